@@ -0,0 +1,70 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _IMAGE_H_
+#define _IMAGE_H_ 1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vector_math.h"
+
+// Row-major CPU image which plays the role of the "RenderTarget" for the CPU path.
+template <typename T, int CHANNEL_COUNT>
+class Image
+{
+public:
+	Image(int width, int height) : m_width(width),
+		m_height(height),
+		m_data(static_cast<size_t>(width) * static_cast<size_t>(height) * CHANNEL_COUNT, T(0))
+	{
+	}
+
+	int getWidth() const { return m_width; }
+	int getHeight() const { return m_height; }
+
+	T* getData() { return m_data.data(); }
+	const T* getData() const { return m_data.data(); }
+
+	T* operator()(int x, int y) { return &m_data[(static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x)) * CHANNEL_COUNT]; }
+	const T* operator()(int x, int y) const { return &m_data[(static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x)) * CHANNEL_COUNT]; }
+
+	// D3D11_FILTER_MIN_MAG_MIP_POINT + D3D11_TEXTURE_ADDRESS_CLAMP
+	const T* sampleLevelPoint(float2 uv) const
+	{
+		return (*this)(texelCoord(uv.x, m_width), texelCoord(uv.y, m_height));
+	}
+
+	// The texel of the "sampleLevelPoint" (also used by the "SwizzledImage")
+	static int texelCoord(float u, int size)
+	{
+		// NOTE: the NaN is mapped to zero
+		float texel = u * float(size);
+		return (texel >= 0.0f) ? ((texel < float(size)) ? int(texel) : (size - 1)) : 0;
+	}
+
+private:
+	int m_width;
+	int m_height;
+	std::vector<T> m_data;
+};
+
+typedef Image<float, 4> ImageRGBA32F;
+typedef Image<float, 1> ImageR32F;
+typedef Image<uint8_t, 1> ImageR8U;
+
+#endif
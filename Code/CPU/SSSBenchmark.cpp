@@ -0,0 +1,170 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+const float3 benchmarkScatteringDistance(0.7568628f, 0.32156864f, 0.20000002f);
+
+double elapsedSeconds(chrono::steady_clock::time_point begin)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+void multiProfileScene(int width, int height, SSSProfileTable& profiles, float4x4& currProj, ImageRGBA32F& irradianceRT, ImageR32F& depthRT, ImageR8U& stencil, ImageRGBA32F& albedoRT, float sphereRadius)
+{
+	profiles.addProfile(float3(0.4f, 0.6f, 0.9f), float3(0.4f, 0.6f, 0.9f), 0.25f);
+	profiles.addProfile(float3(1.0f, 0.5f, 0.5f), float3(1.0f, 0.5f, 0.5f), 0.0625f);
+
+	// Projection (row major, SV_POSITION.z = (proj[2][2] * z + proj[3][2]) / z)
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+	const float yScale = 1.0f / std::tan(0.5f * (20.0f * float(PI) / 180.0f));
+	currProj = {};
+	currProj.m[0][0] = yScale * float(height) / float(width);
+	currProj.m[1][1] = yScale;
+	currProj.m[2][2] = farPlane / (farPlane - nearPlane);
+	currProj.m[2][3] = 1.0f;
+	currProj.m[3][2] = -nearPlane * farPlane / (farPlane - nearPlane);
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const float u = (float(x) + 0.5f) / float(width) * 2.0f - 1.0f;
+			const float v = (float(y) + 0.5f) / float(height) * 2.0f - 1.0f;
+			const float aspect = float(width) / float(height);
+			const float r2 = u * u * aspect * aspect + v * v;
+			if (r2 < (sphereRadius * sphereRadius))
+			{
+				const float viewPositionZ = 3.0f - 0.5f * std::sqrt(sphereRadius * sphereRadius - r2);
+				depthRT(x, y)[0] = (currProj.m[2][2] * viewPositionZ + currProj.m[3][2]) / viewPositionZ;
+
+				const float stripe = (u * aspect / sphereRadius + 1.0f) * 0.5f;
+				const int profileIndex = std::min(std::max(int(stripe * float(MULTI_PROFILE_VERIFICATION_PROFILE_COUNT)), 0), MULTI_PROFILE_VERIFICATION_PROFILE_COUNT - 1);
+				stencil(x, y)[0] = subsurface_scattering_profile_stencil_ref(profileIndex);
+
+				float* albedo = albedoRT(x, y);
+				albedo[0] = 0.8f;
+				albedo[1] = 0.5f + 0.2f * std::sin(float(x) * 0.1f);
+				albedo[2] = 0.4f;
+				albedo[3] = 1.0f;
+
+				// Hard shadow edges, s.t. the blur is NOT trivially flat
+				const float lit = ((std::sin(float(x) * 0.05f) * std::cos(float(y) * 0.07f)) > 0.0f) ? 1.0f : 0.1f;
+				float* irradiance = irradianceRT(x, y);
+				irradiance[0] = lit * 0.9f;
+				irradiance[1] = lit * 0.7f;
+				irradiance[2] = lit * 0.6f;
+			}
+		}
+	}
+}
+
+vector<float3> perChannelReference(const SequenceConvergenceSource& source, const SSSProfile& profile, float worldScale, int pixelsPerSample, const vector<float2>& uvs)
+{
+	vector<float3> reference(uvs.size());
+	for (int channel = 0; channel < 3; ++channel)
+	{
+		const float channelScatteringDistance = (&profile.scatteringDistance.x)[channel];
+		const float channelFilterRadius = profile.filterRadius * (channelScatteringDistance / std::max(std::max(profile.scatteringDistance.x, profile.scatteringDistance.y), profile.scatteringDistance.z));
+		for (size_t i = 0; i < uvs.size(); ++i)
+		{
+			float3 radiance = subsurface_scattering_disney_blur<SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT>(source, float3(channelScatteringDistance, channelScatteringDistance, channelScatteringDistance), channelFilterRadius, worldScale, pixelsPerSample, SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT, SSS_MIS_MODE_NONE, uvs[i]);
+			(&reference[i].x)[channel] = (&radiance.x)[channel];
+		}
+	}
+	return reference;
+}
+
+float3 rmsePerChannel(const vector<float3>& values, const vector<float3>& reference)
+{
+	double sumSquaredError[3] = { 0.0, 0.0, 0.0 };
+	for (size_t i = 0; i < values.size(); ++i)
+	{
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			double error = double((&values[i].x)[channel]) - double((&reference[i].x)[channel]);
+			sumSquaredError[channel] += error * error;
+		}
+	}
+	return float3(float(std::sqrt(sumSquaredError[0] / double(values.size()))), float(std::sqrt(sumSquaredError[1] / double(values.size()))), float(std::sqrt(sumSquaredError[2] / double(values.size()))));
+}
+
+float2 preintegratedSphereTexcoord(float3 normal)
+{
+	const float u = (std::atan2(normal.z, normal.x) + float(PI)) * float(1.0 / (2.0 * PI));
+	const float v = std::acos(std::min(std::max(normal.y, -1.0f), 1.0f)) * float(1.0 / PI);
+	return float2(u, v);
+}
+
+SSSCurvatureMesh preintegratedSphereMesh(float radius, vector<PreintegratedBenchmarkVertex>& vertices, vector<uint32_t>& indices)
+{
+	const int stackCount = 64;
+	const int sliceCount = 128;
+	vertices.clear();
+	indices.clear();
+	for (int stack = 0; stack <= stackCount; ++stack)
+	{
+		for (int slice = 0; slice <= sliceCount; ++slice)
+		{
+			const float theta = float(PI) * float(stack) / float(stackCount);
+			const float phi = float(2.0 * PI) * float(slice) / float(sliceCount) - float(PI);
+			const float3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+			PreintegratedBenchmarkVertex vertex = {};
+			vertex.position[0] = radius * normal.x;
+			vertex.position[1] = radius * normal.y;
+			vertex.position[2] = radius * normal.z;
+			vertex.normal[0] = normal.x;
+			vertex.normal[1] = normal.y;
+			vertex.normal[2] = normal.z;
+			vertex.texcoord[0] = float(slice) / float(sliceCount);
+			vertex.texcoord[1] = float(stack) / float(stackCount);
+			vertices.push_back(vertex);
+		}
+	}
+	for (int stack = 0; stack < stackCount; ++stack)
+	{
+		for (int slice = 0; slice < sliceCount; ++slice)
+		{
+			const uint32_t i00 = uint32_t(stack * (sliceCount + 1) + slice);
+			const uint32_t i01 = i00 + 1U;
+			const uint32_t i10 = i00 + uint32_t(sliceCount + 1);
+			const uint32_t i11 = i10 + 1U;
+			indices.insert(indices.end(), { i00, i10, i01, i01, i10, i11 });
+		}
+	}
+
+	SSSCurvatureMesh mesh;
+	mesh.vertices = vertices.data();
+	mesh.vertexCount = static_cast<int>(vertices.size());
+	mesh.vertexStride = static_cast<int>(sizeof(PreintegratedBenchmarkVertex));
+	mesh.positionOffset = static_cast<int>(offsetof(PreintegratedBenchmarkVertex, position));
+	mesh.normalOffset = static_cast<int>(offsetof(PreintegratedBenchmarkVertex, normal));
+	mesh.texcoordOffset = static_cast<int>(offsetof(PreintegratedBenchmarkVertex, texcoord));
+	mesh.indices = indices.data();
+	mesh.indexCount = static_cast<int>(indices.size());
+	mesh.indices32 = true;
+	return mesh;
+}
@@ -0,0 +1,789 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSBenchmark_H_
+#define _SSSBenchmark_H_ 1
+
+#include <iostream>
+#include "low_discrepancy_sequence.h"
+#include "subsurface_scattering_gbuffer_encoding.h"
+#include "subsurface_scattering_shadow_thickness.h"
+#include "SwizzledImage.h"
+#include "subsurface_scattering_disney_blur_bucket.h"
+#include "SSSLodSelector.h"
+#include "SSSTextureSpaceCache.h"
+
+// Microbenchmarks and accuracy reports of the CPU path.
+// All benchmarks are single threaded, s.t. the throughput is "per core".
+
+struct DiffusionProfileBenchmarkResult
+{
+	int simdWidth;
+
+	// One sample = diffusion_profile_sample_r + diffusion_profile_evaluate_rcp_pdf + diffusion_profile_evaluate_pdf
+	double referenceSamplesPerSecond; // std::exp2 / std::log2 (subsurface_scattering_disney_blur.h)
+	double approxSamplesPerSecond;    // approx_* (scalar reference of the SIMD versions, NOT used by the batch)
+	double batchSamplesPerSecond;     // diffusion_profile_*_batch (widest instruction set supported by the CPU)
+
+	// Maximum error in ULP against the double precision reference: [0] the reference version, [1] the batch version
+	double sampleRMaxULP[2];
+	double cdfMaxULP[2];
+	double rcpPdfMaxULP[2];
+	double pdfMaxULP[2];
+};
+
+DiffusionProfileBenchmarkResult benchmarkDiffusionProfile(int sampleCount = (1 << 20), int repetitionCount = 16);
+
+std::ostream& operator<<(std::ostream& out, const DiffusionProfileBenchmarkResult& result);
+
+#define INVERSE_CDF_LUT_BENCHMARK_SIZE_COUNT 6
+
+struct InverseCdfLUTBenchmarkResult
+{
+	// diffusion_profile_sample_r (analytic)
+	double analyticSamplesPerSecond;
+
+	// 32, 64, 128, 256, 512, 1024
+	int lutSize[INVERSE_CDF_LUT_BENCHMARK_SIZE_COUNT];
+
+	// [0] SSS_INVERSE_CDF_MODE_LUT_LINEAR, [1] SSS_INVERSE_CDF_MODE_LUT_HERMITE
+	double samplesPerSecond[INVERSE_CDF_LUT_BENCHMARK_SIZE_COUNT][2];
+
+	// Maximum error against the double precision reference: cdf in [0, SSS_INVERSE_CDF_LUT_MAX_CDF)
+	double maxRelativeError[INVERSE_CDF_LUT_BENCHMARK_SIZE_COUNT][2];
+	double maxAbsoluteError[INVERSE_CDF_LUT_BENCHMARK_SIZE_COUNT][2]; // in units of "d"
+};
+
+// The cdf values are distributed as the center sample reweighting of the blur, namely, uniform in [0, 1) (the analytic version is used beyond the SSS_INVERSE_CDF_LUT_MAX_CDF).
+InverseCdfLUTBenchmarkResult benchmarkInverseCdfLUT(int sampleCount = (1 << 20), int repetitionCount = 16);
+
+std::ostream& operator<<(std::ostream& out, const InverseCdfLUTBenchmarkResult& result);
+
+#define TRANSMITTANCE_LUT_BENCHMARK_SIZE_COUNT 5
+
+struct TransmittanceLUTBenchmarkResult
+{
+	// transmittanceTint * subsurface_scattering_disney_transmittance (analytic)
+	double analyticSamplesPerSecond;
+
+	// 16, 32, 64, 128, 256
+	int lutSize[TRANSMITTANCE_LUT_BENCHMARK_SIZE_COUNT];
+
+	// [0] SSS_TRANSMITTANCE_LUT_MAX_THICKNESS, [1] SSS_TRANSMITTANCE_LUT_EXTENDED_MAX_THICKNESS
+	double samplesPerSecond[TRANSMITTANCE_LUT_BENCHMARK_SIZE_COUNT][2];
+
+	// Maximum error (of all channels) against the double precision reference
+	double maxAbsoluteError[TRANSMITTANCE_LUT_BENCHMARK_SIZE_COUNT][2];
+};
+
+// The thickness values are uniform in [0, SSS_TRANSMITTANCE_LUT_EXTENDED_MAX_THICKNESS) (the analytic version is used beyond the range of the table).
+TransmittanceLUTBenchmarkResult benchmarkTransmittanceLUT(int sampleCount = (1 << 20), int repetitionCount = 16);
+
+std::ostream& operator<<(std::ostream& out, const TransmittanceLUTBenchmarkResult& result);
+
+#define SEQUENCE_CONVERGENCE_BUDGET_COUNT 20
+#define SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT 4096
+
+struct SequenceConvergenceResult
+{
+	// 4, 8, ..., 80
+	int sampleBudget[SEQUENCE_CONVERGENCE_BUDGET_COUNT];
+
+	// RMSE (of all channels) against the reference (Hammersley with SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT samples), indexed by LOW_DISCREPANCY_SEQUENCE_*
+	double rmse[LOW_DISCREPANCY_SEQUENCE_COUNT][SEQUENCE_CONVERGENCE_BUDGET_COUNT];
+
+	// The smallest budget of which the RMSE is NOT greater than the RMSE of the Hammersley with 32 samples (0 if none)
+	int budgetToMatchHammersley32[LOW_DISCREPANCY_SEQUENCE_COUNT];
+};
+
+// A flat plane of which the irradiance is white noise (4x4 pixels cells) blurred by the default skin profile, of which the filter radius is 96 pixels, s.t. the sample count is always the budget.
+// Only one of every "pixelStride x pixelStride" pixels is evaluated.
+SequenceConvergenceResult benchmarkSequenceConvergence(int width = 256, int height = 256, int pixelStride = 4);
+
+std::ostream& operator<<(std::ostream& out, const SequenceConvergenceResult& result);
+
+#define MIS_VARIANCE_BUDGET_COUNT 4
+#define MIS_VARIANCE_MODE_COUNT 3
+
+struct MisVarianceResult
+{
+	// 8, 16, 32, 64
+	int sampleBudget[MIS_VARIANCE_BUDGET_COUNT];
+
+	// RMSE (per channel) against the reference (each channel importance sampled by its own profile with SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT samples), indexed by SSS_MIS_MODE_*
+	float3 rmse[MIS_VARIANCE_MODE_COUNT][MIS_VARIANCE_BUDGET_COUNT];
+
+	// The mean RMSE (of the three channels) of the MIS is NOT larger than the SSS_MIS_MODE_NONE at any budget (the budgets below SSS_MIS_MIN_SAMPLE_COUNT fall back to the SSS_MIS_MODE_NONE)
+	bool passed;
+};
+
+// The same plane as the "benchmarkSequenceConvergence" (Hammersley), blurred by the current estimator (SSS_MIS_MODE_NONE) and by the per-channel MIS (SSS_MIS_MODE_BALANCE / SSS_MIS_MODE_POWER) at the same budgets.
+MisVarianceResult benchmarkMisVariance(int width = 256, int height = 256, int pixelStride = 4);
+
+std::ostream& operator<<(std::ostream& out, const MisVarianceResult& result);
+
+#define SEPARABLE_BENCHMARK_BUDGET_COUNT 4
+
+struct SeparableBenchmarkResult
+{
+	// RMSE of the radial energy density of the sum of Gaussians (relative to the maximum)
+	float gaussianFitRmse;
+
+	// The separable blur (both passes)
+	int separableSampleCount;
+	float3 separableRmse;
+	double separableNanosecondsPerPixel;
+
+	// The Burley blur (SSS_MIS_MODE_NONE) at 16, 32, 64, 80 samples
+	int burleySampleBudget[SEPARABLE_BENCHMARK_BUDGET_COUNT];
+	float3 burleyRmse[SEPARABLE_BENCHMARK_BUDGET_COUNT];
+	double burleyNanosecondsPerPixel[SEPARABLE_BENCHMARK_BUDGET_COUNT];
+};
+
+// The same plane as the "benchmarkMisVariance" (the filter radius is 96 pixels), of which the reference is the same.
+// The separable blur evaluates all pixels (the vertical pass reads the whole column of the horizontal pass), while the Burley blur only evaluates one of every "pixelStride x pixelStride" pixels. The RMSE of both is measured at the same pixels.
+SeparableBenchmarkResult benchmarkSeparable(int width = 256, int height = 256, int pixelStride = 4);
+
+std::ostream& operator<<(std::ostream& out, const SeparableBenchmarkResult& result);
+
+#define MULTI_PROFILE_VERIFICATION_PROFILE_COUNT 3
+
+struct MultiProfileVerificationResult
+{
+	int pixelCount[MULTI_PROFILE_VERIFICATION_PROFILE_COUNT];
+
+	// The mixed-profile frame (one blur with all the profiles) against the per-profile blurs (one blur with only the pixels of the profile)
+	double maxAbsoluteError[MULTI_PROFILE_VERIFICATION_PROFILE_COUNT];
+
+	bool passed;
+};
+
+// A synthetic sphere of which the vertical stripes use different profiles (with different world scales), blurred by the "SSSBlurCPU".
+// The samples which belong to another profile are rejected, s.t. the mixed-profile frame should match the per-profile blurs exactly.
+MultiProfileVerificationResult verifyMultiProfile(int width = 320, int height = 180);
+
+std::ostream& operator<<(std::ostream& out, const MultiProfileVerificationResult& result);
+
+#define LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT 3
+#define LOW_RESOLUTION_BENCHMARK_EDGE_RADIUS 4
+
+struct LowResolutionBenchmarkResult
+{
+	// SSS_RESOLUTION_FACTOR_FULL, SSS_RESOLUTION_FACTOR_HALF, SSS_RESOLUTION_FACTOR_QUARTER
+	int resolutionFactor[LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT];
+	double millisecondsPerFrame[LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT];
+	// The error map is the maximum (of all channels) absolute error against the reference (SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT samples at one of every "pixelStride x pixelStride" pixels of the subsurface scattering, zero at the other pixels), of which the statistics are over the reference pixels
+	// NOTE: the error of the full resolution is the sampling noise (SSS_MAX_SAMPLE_BUDGET samples)
+	double rmse[LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT];
+	// The pixels within LOW_RESOLUTION_BENCHMARK_EDGE_RADIUS of another stencil (the silhouette and the profile boundaries) are the edge
+	double interiorRmse[LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT];
+	double edgeRmse[LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT];
+	// The error which the low resolution adds to the sampling noise: sqrt(rmse^2 - rmse_full_resolution^2)
+	double interiorResolutionRmse[LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT];
+	double edgeResolutionRmse[LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT];
+	double maxAbsoluteError[LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT];
+	// The ratio of the pixels of which the error is greater than 1/255
+	double aboveThresholdRatio[LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT];
+};
+
+// The same sphere as the "verifyMultiProfile", blurred by the "SSSBlurCPU" at each resolution factor.
+// The error maps (of the half and the quarter resolution) are written as "<errorMapPathPrefix>_x2.pfm" and "<errorMapPathPrefix>_x4.pfm" if the prefix is NOT NULL.
+LowResolutionBenchmarkResult benchmarkLowResolution(int width = 640, int height = 360, int pixelStride = 4, int repetitionCount = 4, const char* errorMapPathPrefix = NULL);
+
+std::ostream& operator<<(std::ostream& out, const LowResolutionBenchmarkResult& result);
+
+struct TemporalReprojectionVerificationResult
+{
+	// The pixels of the subsurface scattering in the current frame (the camera is moved)
+	int pixelCount;
+
+	// The "uv - motion_vector" against the "subsurface_scattering_temporal_reproject" by the camera matrices (in pixels)
+	double maxMotionVectorError;
+	// The predicted view depth of the previous frame against the analytic view depth (relative)
+	double maxViewDepthError;
+
+	// The history is rejected (the disocclusion behind the sphere and the border which was off screen)
+	double rejectedRatio;
+	// The history is accepted while the surface was NOT visible in the previous frame (occluded or off screen), and vice versa
+	double falseAcceptRatio;
+	double falseRejectRatio;
+
+	// The camera is still: all the history should be accepted and reproduced
+	int stillRejectedCount;
+	double stillMaxAbsoluteError;
+
+	// The camera is still but the surface is moved along the view direction by 5% (without the motion vector): all the history should be rejected
+	int depthChangedAcceptedCount;
+	// The subsurface mask of the history is 0.5 (should be rejected) and 0.95 (should be accepted)
+	int maskChangedAcceptedCount;
+	int maskSimilarRejectedCount;
+
+	// The "subsurface_scattering_temporal_accumulate" against the running average (the first "1 / min_blend" frames) and the exponential moving average (afterwards)
+	double accumulateMaxError;
+
+	bool passed;
+};
+
+// A sphere in front of a plane, rendered analytically from the previous and the current camera (the camera is orbited around the sphere).
+// The unit tests of the reprojection (the motion vector and the camera matrices) and the rejection (depth, subsurface mask and off screen) of the "subsurface_scattering_temporal.h".
+TemporalReprojectionVerificationResult verifyTemporalReprojection(int width = 320, int height = 180);
+
+std::ostream& operator<<(std::ostream& out, const TemporalReprojectionVerificationResult& result);
+
+#define TEMPORAL_CONVERGENCE_BUDGET_COUNT 4
+#define TEMPORAL_CONVERGENCE_FRAME_COUNT 7
+
+struct TemporalConvergenceResult
+{
+	// The sample budget of each frame of the temporal accumulation
+	int sampleBudget;
+
+	// RMSE (of all channels) against the reference (the same as the "benchmarkSequenceConvergence") without the temporal accumulation: 8, 16, 32, 64
+	int singleFrameSampleBudget[TEMPORAL_CONVERGENCE_BUDGET_COUNT];
+	double singleFrameRmse[TEMPORAL_CONVERGENCE_BUDGET_COUNT];
+
+	// RMSE after 1, 2, 4, 8, 16, 32, 64 frames of the temporal accumulation (the head is still), with and without the per frame rotation (and radius offset) of the sample pattern
+	int frameCount[TEMPORAL_CONVERGENCE_FRAME_COUNT];
+	double accumulatedRmse[TEMPORAL_CONVERGENCE_FRAME_COUNT];
+	double notRotatedRmse[TEMPORAL_CONVERGENCE_FRAME_COUNT];
+
+	// The RMSE of the rotated accumulation never increases as the frames are added
+	bool passed;
+};
+
+// The procedural flat plane of the "benchmarkSequenceConvergence", accumulated by the "subsurface_scattering_temporal_accumulate" with the default blend.
+TemporalConvergenceResult benchmarkTemporalConvergence(int width = 256, int height = 256, int pixelStride = 4, int sampleBudget = 8);
+
+std::ostream& operator<<(std::ostream& out, const TemporalConvergenceResult& result);
+
+#define ADAPTIVE_SAMPLING_BUDGET_COUNT 4
+#define ADAPTIVE_SAMPLING_FILTER_RADIUS_IN_PIXELS 32
+
+struct AdaptiveSamplingResult
+{
+	// The pixels of which the filter (ADAPTIVE_SAMPLING_FILTER_RADIUS_IN_PIXELS) overlaps a shadow edge, and the flat (evenly lit) pixels
+	int edgePixelCount;
+	int flatPixelCount;
+
+	// The average samples per pixel of the frame: 16, 24, 32, 48
+	int samplesPerPixel[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+
+	// uniform: "setNSamples(samplesPerPixel)"
+	// adaptive: "setSamplesPerFrame(samplesPerPixel * pixelCount)" and "setNSamples(SSS_MAX_SAMPLE_BUDGET)"
+	// The samples actually taken per pixel ("getSampleCount", including the pilot pass) and the RMSE (of all channels) against the reference
+	double uniformSamplesPerPixel[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+	double uniformRmse[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+	double uniformEdgeRmse[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+	double uniformFlatRmse[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+	double adaptiveSamplesPerPixel[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+	double adaptiveRmse[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+	double adaptiveEdgeRmse[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+	double adaptiveFlatRmse[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+
+	// The smallest uniform sample budget (4, 8, ..., SSS_MAX_SAMPLE_BUDGET) of which the RMSE is NOT greater than the adaptive one (0 if none)
+	int uniformBudgetToMatchAdaptive[ADAPTIVE_SAMPLING_BUDGET_COUNT];
+
+	// The adaptive RMSE is NOT greater than the uniform RMSE at every budget, and the adaptive sampling does NOT take more than 1% over the budget
+	bool passed;
+};
+
+// A flat plane (size x size) which is evenly lit except the hard shadows of a disk and a half plane, blurred by the "SSSBlurCPU" (Hammersley, analytic inverse CDF and without the kernel cache, s.t. the reference is the same estimator)
+// The reference is the "subsurface_scattering_disney_blur" with SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT samples at one of every "pixelStride x pixelStride" pixels
+AdaptiveSamplingResult benchmarkAdaptiveSampling(int size = 384, int pixelStride = 2);
+
+std::ostream& operator<<(std::ostream& out, const AdaptiveSamplingResult& result);
+
+
+#define TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT 3
+
+struct TileClassificationBenchmarkResult
+{
+	// The ratio of the pixels of the subsurface scattering: the full screen, the sphere of the "verifyMultiProfile" and a head of 10% of the screen
+	double coverage[TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT];
+	// [0] without the classification, [1] with the classification (the fastest of the interleaved repetitions)
+	double millisecondsPerFrame[TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT][2];
+	// "getTileCount" of the "SSSBlurCPU"
+	int emptyTileCount[TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT];
+	int interiorTileCount[TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT];
+	int edgeTileCount[TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT];
+	// With the classification against without the classification (should be zero)
+	double maxAbsoluteError[TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT];
+
+	// The error is zero, and the classification is NOT slower at the partial coverages
+	bool passed;
+};
+
+// The sphere of the "verifyMultiProfile" (scaled to each coverage), blurred by the "SSSBlurCPU" (one thread) with and without the tile classification.
+TileClassificationBenchmarkResult benchmarkTileClassification(int width = 640, int height = 360, int repetitionCount = 4);
+
+std::ostream& operator<<(std::ostream& out, const TileClassificationBenchmarkResult& result);
+
+
+#define MASK_PYRAMID_BENCHMARK_BUDGET_COUNT 3
+
+struct MaskPyramidBenchmarkResult
+{
+	// The sample budget of the preset: the default of the HUD (16), the middle of the slider (40) and the maximum (SSS_MAX_SAMPLE_BUDGET)
+	int sampleBudget[MASK_PYRAMID_BENCHMARK_BUDGET_COUNT];
+	// [0] without the mask pyramid, [1] with the mask pyramid (the fastest of the interleaved repetitions, including the build of the pyramid)
+	double millisecondsPerFrame[MASK_PYRAMID_BENCHMARK_BUDGET_COUNT][2];
+	// The frame is slower with the mask pyramid (fails the benchmark)
+	bool regression[MASK_PYRAMID_BENCHMARK_BUDGET_COUNT];
+	// "getSampleCount" and "getRejectedSampleCount" of the "SSSBlurCPU" (the same with and without the mask pyramid)
+	uint64_t sampleCount[MASK_PYRAMID_BENCHMARK_BUDGET_COUNT];
+	uint64_t rejectedSampleCount[MASK_PYRAMID_BENCHMARK_BUDGET_COUNT];
+	// "getWastedSampleCount" of the "SSSBlurCPU": [0] without the mask pyramid, [1] with the mask pyramid
+	uint64_t wastedSampleCount[MASK_PYRAMID_BENCHMARK_BUDGET_COUNT][2];
+	// With the mask pyramid against without the mask pyramid (should be zero)
+	double maxAbsoluteError[MASK_PYRAMID_BENCHMARK_BUDGET_COUNT];
+
+	// The error is zero, the sample counts are the same, and there is no regression
+	bool passed;
+};
+
+// The sphere of the "verifyMultiProfile", blurred by the "SSSBlurCPU" (one thread, without the tile classification) with and without the mask pyramid.
+MaskPyramidBenchmarkResult benchmarkMaskPyramid(int width = 640, int height = 360, int repetitionCount = 4);
+
+std::ostream& operator<<(std::ostream& out, const MaskPyramidBenchmarkResult& result);
+
+
+#define IRRADIANCE_PYRAMID_BENCHMARK_WORLD_SCALE_COUNT 4
+#define IRRADIANCE_PYRAMID_BENCHMARK_CACHE_SIZE (32 * 1024)
+#define IRRADIANCE_PYRAMID_BENCHMARK_CACHE_WAY_COUNT 8
+#define IRRADIANCE_PYRAMID_BENCHMARK_CACHE_LINE_SIZE 64
+
+struct IrradiancePyramidBenchmarkResult
+{
+	// The world scale of the profile 0 (the other profiles are scaled by the same factor): 1, 1/2, 1/4 and 1/8 of the "verifyMultiProfile", namely, the camera zooms in
+	float worldScale[IRRADIANCE_PYRAMID_BENCHMARK_WORLD_SCALE_COUNT];
+	// The filter radius (of the profile 0) in pixels at the center of the sphere
+	float filterRadiusInPixels[IRRADIANCE_PYRAMID_BENCHMARK_WORLD_SCALE_COUNT];
+	// [0] without the irradiance pyramid, [1] with the irradiance pyramid
+	// RMSE (of all channels) of the blurred irradiance (SSS_MAX_SAMPLE_BUDGET samples) against the reference (SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT samples without the irradiance pyramid)
+	double rmse[IRRADIANCE_PYRAMID_BENCHMARK_WORLD_SCALE_COUNT][2];
+	// The misses of the simulated cache (IRRADIANCE_PYRAMID_BENCHMARK_CACHE_SIZE, IRRADIANCE_PYRAMID_BENCHMARK_CACHE_WAY_COUNT ways, IRRADIANCE_PYRAMID_BENCHMARK_CACHE_LINE_SIZE bytes per line, LRU) per pixel of the subsurface scattering
+	double cacheMissesPerPixel[IRRADIANCE_PYRAMID_BENCHMARK_WORLD_SCALE_COUNT][2];
+	// The "SSSBlurCPU" (one thread, SSS_MAX_SAMPLE_BUDGET samples)
+	double millisecondsPerFrame[IRRADIANCE_PYRAMID_BENCHMARK_WORLD_SCALE_COUNT][2];
+};
+
+// The sphere of the "verifyMultiProfile" of which the world scales are reduced, blurred by the "subsurface_scattering_disney_blur" (Hammersley, analytic inverse CDF and without the kernel cache, s.t. the reference is the same estimator) with and without the irradiance pyramid.
+// The RMSE is measured at one of every "pixelStride x pixelStride" pixels, while the cache is simulated over all pixels in the raster order. Only the fetches of the irradiance and the view depth (the full resolution or the irradiance pyramid) are simulated, since the subsurface mask and the profile index are fetched the same with and without the irradiance pyramid.
+IrradiancePyramidBenchmarkResult benchmarkIrradiancePyramid(int width = 640, int height = 360, int pixelStride = 4, int repetitionCount = 2);
+
+std::ostream& operator<<(std::ostream& out, const IrradiancePyramidBenchmarkResult& result);
+
+
+#define GBUFFER_ENCODING_VERIFICATION_ROUND_TRIP_COUNT (1 << 20)
+
+struct GBufferEncodingVerificationResult
+{
+	// The round trip of the random irradiance (each channel in [2^-10, 2^10]) through the render target: the max error relative to the max channel
+	// NOTE: the YCoCg round trip uses the partner of the same irradiance (namely, the flat region), since the chroma of the half resolution is NOT exact across the edges
+	double irradianceMaxRelativeError[SSS_IRRADIANCE_ENCODING_COUNT];
+	double irradianceErrorBound[SSS_IRRADIANCE_ENCODING_COUNT];
+	// The round trip of the random view depth (in [near, 10 * near]) through the render target: the max error relative to the view depth
+	double depthMaxRelativeError[SSS_DEPTH_ENCODING_COUNT];
+	double depthErrorBound[SSS_DEPTH_ENCODING_COUNT];
+	// RMSE (of all channels of the pixels of the subsurface scattering) of the blurred irradiance against the blur of the unencoded (32-bit float) irradiance and depth
+	double blurRmse[SSS_IRRADIANCE_ENCODING_COUNT][SSS_DEPTH_ENCODING_COUNT];
+	// The bytes of the irradiance and the depth per frame: written by the main pass (all pixels) and read by the blur (the center and each accepted sample)
+	// NOTE: the albedo, the stencil and the rejected samples are the same for all encodings and are NOT counted
+	double megabytesPerFrame[SSS_IRRADIANCE_ENCODING_COUNT][SSS_DEPTH_ENCODING_COUNT];
+
+	bool passed;
+};
+
+// The codecs of the "subsurface_scattering_gbuffer_encoding.h", and the sphere of the "verifyMultiProfile" blurred by the "SSSBlurCPU" (SSS_MAX_SAMPLE_BUDGET samples) with each combination of the encodings.
+GBufferEncodingVerificationResult verifyGBufferEncoding(int width = 640, int height = 360);
+
+std::ostream& operator<<(std::ostream& out, const GBufferEncodingVerificationResult& result);
+
+
+#define SHADOW_THICKNESS_VERIFICATION_DISTANCE_COUNT 5
+#define SHADOW_THICKNESS_VERIFICATION_SAMPLE_COUNT 4096
+
+struct ShadowThicknessVerificationResult
+{
+	// The distance between the light and the shaded point (the view space position z of the light) in units: 0.5, 1, 2 (the lights of the demo), 4 and 8
+	float distance[SHADOW_THICKNESS_VERIFICATION_DISTANCE_COUNT];
+	// The max error (in mm) of the view space position z of the texel of the shadow map
+	double depthMaxError[SHADOW_THICKNESS_VERIFICATION_DISTANCE_COUNT][SSS_SHADOW_DEPTH_MODE_COUNT];
+	// The max error (in mm) of the thickness of the transmittance
+	double thicknessMaxError[SHADOW_THICKNESS_VERIFICATION_DISTANCE_COUNT][SSS_SHADOW_DEPTH_MODE_COUNT];
+	// The max error (of all channels) of the "subsurface_scattering_disney_transmittance" of the default skin profile
+	double transmittanceMaxError[SHADOW_THICKNESS_VERIFICATION_DISTANCE_COUNT][SSS_SHADOW_DEPTH_MODE_COUNT];
+
+	bool passed;
+};
+
+// The projection of the lights of the demo (45 degrees, near 0.1 and far 10) and the default world scale of the demo (0.125 meters per unit).
+// The thickness values are uniform in [0, SSS_TRANSMITTANCE_LUT_MAX_THICKNESS) mm and the distance is jittered by 5%, s.t. the quantization of the texel is NOT aligned.
+ShadowThicknessVerificationResult verifyShadowThickness();
+
+std::ostream& operator<<(std::ostream& out, const ShadowThicknessVerificationResult& result);
+
+
+#define IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT 2
+#define IMAGE_LAYOUT_BENCHMARK_SAMPLE_BUDGET 16
+#define IMAGE_LAYOUT_BENCHMARK_BAND_HEIGHT 64
+#define IMAGE_LAYOUT_BENCHMARK_L1_CACHE_SIZE (32 * 1024)
+#define IMAGE_LAYOUT_BENCHMARK_L1_CACHE_WAY_COUNT 8
+#define IMAGE_LAYOUT_BENCHMARK_L2_CACHE_SIZE (1024 * 1024)
+#define IMAGE_LAYOUT_BENCHMARK_L2_CACHE_WAY_COUNT 16
+#define IMAGE_LAYOUT_BENCHMARK_CACHE_LINE_SIZE 64
+
+struct ImageLayoutBenchmarkResult
+{
+	// 1920 x 1080 and 3840 x 2160
+	int width[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT];
+	int height[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT];
+	// The pixels of the subsurface scattering
+	int pixelCount[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT];
+	// [IMAGE_LAYOUT_ROW_MAJOR / IMAGE_LAYOUT_MORTON / IMAGE_LAYOUT_BLOCK_LINEAR]
+	// The model (NOT measured): the miss rate (misses / accesses) of the simulated L1 (IMAGE_LAYOUT_BENCHMARK_L1_CACHE_SIZE, IMAGE_LAYOUT_BENCHMARK_L1_CACHE_WAY_COUNT ways) and L2 (IMAGE_LAYOUT_BENCHMARK_L2_CACHE_SIZE, IMAGE_LAYOUT_BENCHMARK_L2_CACHE_WAY_COUNT ways, only accessed by the misses of the L1), LRU and IMAGE_LAYOUT_BENCHMARK_CACHE_LINE_SIZE bytes per line
+	double l1MissRate[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT][IMAGE_LAYOUT_COUNT];
+	double l2MissRate[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT][IMAGE_LAYOUT_COUNT];
+	// The hardware counters (the "perf_event_open" of Linux) of the L1 data cache and the last level cache reads of the whole "SSSBlurCPU::go" (including the swizzle)
+	// The "hardwareCounterError" is the "errno" of the first counter which is NOT available (zero if all counters are measured)
+	int hardwareCounterError;
+	double hardwareL1MissRate[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT][IMAGE_LAYOUT_COUNT];
+	double hardwareLlcMissRate[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT][IMAGE_LAYOUT_COUNT];
+	double hardwareL1MissesPerPixel[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT][IMAGE_LAYOUT_COUNT];
+	double hardwareLlcMissesPerPixel[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT][IMAGE_LAYOUT_COUNT];
+	// The "SSSBlurCPU" (one thread, IMAGE_LAYOUT_BENCHMARK_SAMPLE_BUDGET samples) including the swizzle of the inputs
+	double millisecondsPerFrame[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT][IMAGE_LAYOUT_COUNT];
+	// The "SwizzledImage::swizzle" of the irradiance, the depth, the albedo and the stencil
+	double swizzleMilliseconds[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT][IMAGE_LAYOUT_COUNT];
+	// Against the row-major layout (should be zero)
+	double maxAbsoluteError[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT][IMAGE_LAYOUT_COUNT];
+	// The "SwizzledImage::unswizzle" returns exactly the "SwizzledImage::swizzle"d image
+	bool roundTripExact;
+
+	bool passed;
+};
+
+// The sphere of the "verifyMultiProfile" at 1080p and 4K, stored in each layout of the "SwizzledImage.h" (the block-linear layout of the default block size).
+// The cache is simulated for the "subsurface_scattering_disney_blur" (Hammersley, analytic inverse CDF and without the kernel cache) of the pixels of the band of IMAGE_LAYOUT_BENCHMARK_BAND_HEIGHT rows at the center of the screen, visited in the order of the tiles (SSS_TILE_SIZE x SSS_TILE_SIZE) of the blur.
+// Only the fetches of the samples (the irradiance with the depth, the albedo and the stencil) are simulated (the model), and the hardware counters of the "SSSBlurCPU" are measured by the "perf_event_open" if available (Linux only).
+ImageLayoutBenchmarkResult benchmarkImageLayout(int repetitionCount = 1);
+
+std::ostream& operator<<(std::ostream& out, const ImageLayoutBenchmarkResult& result);
+
+
+#define WORK_STEALING_BENCHMARK_THREAD_COUNT_COUNT 7
+
+struct WorkStealingBenchmarkResult
+{
+	// std::thread::hardware_concurrency (the scaling beyond it only measures the overhead)
+	int hardwareConcurrency;
+	// The coverage of the sphere (the fraction of the pixels of the subsurface scattering)
+	double coverage;
+	// 1, 2, 4, 8, 16, 32 and 64
+	int threadCount[WORK_STEALING_BENCHMARK_THREAD_COUNT_COUNT];
+	// [0] the shared queue in the order of the classification, [1] the work stealing
+	double millisecondsPerFrame[WORK_STEALING_BENCHMARK_THREAD_COUNT_COUNT][2];
+	// The work stealing: the steals and the stolen tiles of all workers
+	uint64_t stealCount[WORK_STEALING_BENCHMARK_THREAD_COUNT_COUNT];
+	uint64_t stolenTileCount[WORK_STEALING_BENCHMARK_THREAD_COUNT_COUNT];
+	// The work stealing: the max busy time of the workers over the mean busy time (1 is perfectly balanced)
+	double busyImbalance[WORK_STEALING_BENCHMARK_THREAD_COUNT_COUNT];
+	// Against one thread of the shared queue (should be zero)
+	double maxAbsoluteError[WORK_STEALING_BENCHMARK_THREAD_COUNT_COUNT][2];
+
+	bool passed;
+};
+
+// The sphere of the "verifyMultiProfile" which covers 10% of the screen (the head of the "benchmarkTileClassification"), blurred by the "SSSBlurCPU" (SSS_MAX_SAMPLE_BUDGET samples, with the tile classification) with the shared queue and with the work stealing (see "SSSTileScheduler.h").
+// NOTE: unlike the other benchmarks, this one is multithreaded.
+WorkStealingBenchmarkResult benchmarkWorkStealing(int width = 960, int height = 540, int repetitionCount = 2);
+
+std::ostream& operator<<(std::ostream& out, const WorkStealingBenchmarkResult& result);
+
+
+#define COHERENT_SAMPLING_BENCHMARK_BLOCK_SIZE_COUNT 4
+#define COHERENT_SAMPLING_BENCHMARK_LOW_SAMPLE_BUDGET 16
+
+struct CoherentSamplingBenchmarkResult
+{
+	// The pixels of the subsurface scattering
+	int pixelCount;
+	// 1 (each pixel takes all its samples before the next pixel), 2, 4 and 8
+	int blockSize[COHERENT_SAMPLING_BENCHMARK_BLOCK_SIZE_COUNT];
+	// The miss rate (misses / accesses) of the simulated L1 and L2 (the same caches as the "benchmarkImageLayout")
+	double l1MissRate[COHERENT_SAMPLING_BENCHMARK_BLOCK_SIZE_COUNT];
+	double l2MissRate[COHERENT_SAMPLING_BENCHMARK_BLOCK_SIZE_COUNT];
+	// The "SSSBlurCPU" (one thread, SSS_MAX_SAMPLE_BUDGET samples): [0] per pixel, [1] the coherent sampling
+	double millisecondsPerFrame[2];
+	// The coherent sampling against per pixel (should be zero)
+	double maxAbsoluteError;
+	// The mean absolute difference of the error (the luminance of the COHERENT_SAMPLING_BENCHMARK_LOW_SAMPLE_BUDGET samples of the coherent sampling against the SSS_MAX_SAMPLE_BUDGET samples) of the neighboring pixels across the boundaries of the blocks over within the blocks (1 means no structure)
+	double seamRatio;
+
+	bool passed;
+};
+
+// The sphere of the "verifyMultiProfile" of which the pixels of each block take the samples of the same index together, and the fetches of each sample index are sorted by the texel address (see "setCoherentSamplingEnabled" of the "SSSBlurCPU.h").
+// The cache is simulated for the "subsurface_scattering_disney_blur" (Hammersley, analytic inverse CDF and without the kernel cache, SSS_MAX_SAMPLE_BUDGET samples) of the pixels of the band of IMAGE_LAYOUT_BENCHMARK_BAND_HEIGHT rows at the center of the screen, visited in the order of the tiles (SSS_TILE_SIZE x SSS_TILE_SIZE) and of the blocks within each tile.
+CoherentSamplingBenchmarkResult benchmarkCoherentSampling(int width = 960, int height = 540, int repetitionCount = 2);
+
+std::ostream& operator<<(std::ostream& out, const CoherentSamplingBenchmarkResult& result);
+
+
+#define SAMPLE_COUNT_BUCKET_BENCHMARK_PIXELS_PER_SAMPLE_COUNT 3
+
+struct SampleCountBucketBenchmarkResult
+{
+	// 16 (AVX-512), 8 (AVX2) or 1 (scalar) of the "diffusion_profile_simd_width" (detected at runtime)
+	int simdWidth;
+	// The "SSSBlurCPU" (one thread) of which the "sampleBudget" is the size of the bucket, s.t. the generic loop takes the same number of the samples
+	// [bucket][0: pre-scatter, 1: post-scatter]
+	int bucketSize[SSS_SAMPLE_COUNT_BUCKET_COUNT];
+	double genericMilliseconds[SSS_SAMPLE_COUNT_BUCKET_COUNT][2];
+	double bucketMilliseconds[SSS_SAMPLE_COUNT_BUCKET_COUNT][2];
+	// Against the generic loop (only the approximations of the "diffusion_profile_simd.h")
+	double bucketMaxAbsoluteError[SSS_SAMPLE_COUNT_BUCKET_COUNT][2];
+	// The "SSSBlurCPU" (one thread, SSS_MAX_SAMPLE_BUDGET samples, pre-scatter) of which the "pixelsPerSample" is raised, s.t. the predicted "sample_count" is rounded to the buckets
+	int pixelsPerSample[SAMPLE_COUNT_BUCKET_BENCHMARK_PIXELS_PER_SAMPLE_COUNT];
+	// [0] the generic loop, [1] the buckets
+	double roundingMilliseconds[SAMPLE_COUNT_BUCKET_BENCHMARK_PIXELS_PER_SAMPLE_COUNT][2];
+	double samplesPerPixel[SAMPLE_COUNT_BUCKET_BENCHMARK_PIXELS_PER_SAMPLE_COUNT][2];
+	// The RMSE (the luminance) against the generic loop of SSS_MIN_PIXELS_PER_SAMPLE
+	double rmse[SAMPLE_COUNT_BUCKET_BENCHMARK_PIXELS_PER_SAMPLE_COUNT][2];
+	// The tiles of each bucket
+	int bucketTileCount[SAMPLE_COUNT_BUCKET_BENCHMARK_PIXELS_PER_SAMPLE_COUNT][SSS_SAMPLE_COUNT_BUCKET_COUNT];
+	// The left half of the sphere with the reduced budget (see "SSS_STENCIL_REDUCED_BUDGET_BIT", SSS_MAX_SAMPLE_BUDGET samples, SSS_MIN_PIXELS_PER_SAMPLE)
+	// The mean of the budgets of the pixels, and the samples of the generic loop / the buckets (the buckets fail if the rounding exceeds the budgets)
+	double reducedBudgetPerPixel;
+	double reducedSamplesPerPixel[2];
+	int reducedBucketTileCount[SSS_SAMPLE_COUNT_BUCKET_COUNT];
+
+	bool passed;
+};
+
+// The sphere of the "verifyMultiProfile" blurred by the generic loop and by the specializations of the sample count buckets (see "subsurface_scattering_disney_blur_bucket.h").
+// NOTE: the profile is only evaluated by the SIMD if the CPU supports the AVX2 or the AVX-512.
+SampleCountBucketBenchmarkResult benchmarkSampleCountBuckets(int width = 960, int height = 540, int repetitionCount = 2);
+
+std::ostream& operator<<(std::ostream& out, const SampleCountBucketBenchmarkResult& result);
+
+
+#define STOCHASTIC_DENOISER_BENCHMARK_SAMPLE_COUNT_COUNT 3
+#define STOCHASTIC_DENOISER_BENCHMARK_BASELINE_SAMPLE_BUDGET 32
+
+struct StochasticDenoiserBenchmarkResult
+{
+	// The pixels of the subsurface scattering
+	int pixelCount;
+	// The "SSSBlurCPU" (one thread, STOCHASTIC_DENOISER_BENCHMARK_BASELINE_SAMPLE_BUDGET samples)
+	double baselineMilliseconds;
+	double baselineSamplesPerPixel;
+	// The RMSE (the luminance) against the reference (SSS_MAX_SAMPLE_BUDGET samples)
+	double baselineRmse;
+	// 1, 2 and SSS_STOCHASTIC_MAX_SAMPLE_COUNT samples of the stochastic mode
+	int sampleCount[STOCHASTIC_DENOISER_BENCHMARK_SAMPLE_COUNT_COUNT];
+	double samplesPerPixel[STOCHASTIC_DENOISER_BENCHMARK_SAMPLE_COUNT_COUNT];
+	// [0] the noise (without the denoiser), [1] SSS_ATROUS_DEFAULT_ITERATION_COUNT iterations of the denoiser
+	double milliseconds[STOCHASTIC_DENOISER_BENCHMARK_SAMPLE_COUNT_COUNT][2];
+	double rmse[STOCHASTIC_DENOISER_BENCHMARK_SAMPLE_COUNT_COUNT][2];
+	// Against the baseline
+	double baselineRelativeRmse[STOCHASTIC_DENOISER_BENCHMARK_SAMPLE_COUNT_COUNT][2];
+
+	bool passed;
+};
+
+// The sphere of the "verifyMultiProfile" (of which the irradiance has the hard shadow edges) blurred by the stochastic mode (see "setStochasticSampleCount" of the "SSSBlurCPU.h") with and without the denoiser, against the baseline of STOCHASTIC_DENOISER_BENCHMARK_BASELINE_SAMPLE_BUDGET samples.
+// The test passes if the denoiser reduces the error of each sample count.
+StochasticDenoiserBenchmarkResult benchmarkStochasticDenoiser(int width = 960, int height = 540, int repetitionCount = 2);
+
+std::ostream& operator<<(std::ostream& out, const StochasticDenoiserBenchmarkResult& result);
+
+
+#define PREINTEGRATED_LUT_BENCHMARK_THREAD_COUNT_COUNT 4
+#define PREINTEGRATED_LUT_BENCHMARK_DISTANCE_COUNT 4
+// In the units of the scene (the world scale of the default profile), namely, 6.25 mm (the scale of the nose or the ears)
+#define PREINTEGRATED_LUT_BENCHMARK_SPHERE_RADIUS 0.05f
+
+struct PreintegratedLUTBenchmarkResult
+{
+	// std::thread::hardware_concurrency (the scaling beyond it only measures the overhead)
+	int hardwareConcurrency;
+	// 1, 2, 4 and 8
+	int threadCount[PREINTEGRATED_LUT_BENCHMARK_THREAD_COUNT_COUNT];
+	// The "SSSPreintegratedLUT" (the default profile) and the "SSSCurvatureMap" (the UV sphere)
+	double lutBakeMilliseconds[PREINTEGRATED_LUT_BENCHMARK_THREAD_COUNT_COUNT];
+	double curvatureMapBakeMilliseconds[PREINTEGRATED_LUT_BENCHMARK_THREAD_COUNT_COUNT];
+	// Both bakers are the same for all thread counts
+	bool deterministic;
+
+	// The relative error of the baked curvature of the UV sphere against "1 / radius": the vertices and the covered texels of the map
+	double maxVertexCurvatureError;
+	double maxMapCurvatureError;
+	int coveredTexelCount;
+
+	// The radius of the sphere on the screen
+	int radiusInPixels[PREINTEGRATED_LUT_BENCHMARK_DISTANCE_COUNT];
+	int pixelCount[PREINTEGRATED_LUT_BENCHMARK_DISTANCE_COUNT];
+	// The "SSSBlurCPU" (one thread, SSS_MAX_SAMPLE_BUDGET samples) against the shading by the LUT (the lookup of the curvature map and the LUT of each pixel)
+	double blurMilliseconds[PREINTEGRATED_LUT_BENCHMARK_DISTANCE_COUNT];
+	double lutMilliseconds[PREINTEGRATED_LUT_BENCHMARK_DISTANCE_COUNT];
+	// The RMSE (the luminance) against the blur: [0] "saturate(N.L)" (without the subsurface scattering), [1] the LUT
+	double rmse[PREINTEGRATED_LUT_BENCHMARK_DISTANCE_COUNT][2];
+
+	bool passed;
+};
+
+// The UV sphere of the radius PREINTEGRATED_LUT_BENCHMARK_SPHERE_RADIUS (lit by one directional light) at the distances of which the radius on the screen is 128, 64, 32 and 16 pixels.
+// The irradiance "saturate(N.L)" is blurred by the "SSSBlurCPU" and compared with the shading by the "SSSPreintegratedLUT" of the curvature baked by the "SSSCurvatureMap" from the mesh of the sphere.
+// The test passes if both bakers are deterministic, the baked curvature is "1 / radius" (within 0.1%) and the LUT is closer to the blur than "saturate(N.L)" at all distances.
+// NOTE: the bakers are multithreaded (the same as the "benchmarkWorkStealing"), and the rest is single threaded.
+PreintegratedLUTBenchmarkResult benchmarkPreintegratedLUT(int width = 640, int height = 360, int repetitionCount = 2);
+
+std::ostream& operator<<(std::ostream& out, const PreintegratedLUTBenchmarkResult& result);
+
+
+#define LOD_BENCHMARK_HEAD_COUNT 16
+// In the units of the scene (the world scale of the default profile), namely, 62.5 mm
+#define LOD_BENCHMARK_HEAD_RADIUS 0.5f
+#define LOD_BENCHMARK_HYSTERESIS_FRAME_COUNT 64
+
+struct LodBenchmarkResult
+{
+	// The tier and the radius of the filter on the screen of each head (from the nearest to the farthest)
+	int tier[LOD_BENCHMARK_HEAD_COUNT];
+	float filterRadiusInPixels[LOD_BENCHMARK_HEAD_COUNT];
+	// The counters of the "SSSLodSelector" (estimated from the projected bounds) against the pixels of the heads of each tier in the ray cast image
+	int headCount[SSS_LOD_TIER_COUNT];
+	uint64_t estimatedPixelCount[SSS_LOD_TIER_COUNT];
+	uint64_t pixelCount[SSS_LOD_TIER_COUNT];
+	double selectMicroseconds;
+
+	// The "SSSBlurCPU" (one thread) of all heads at the full budget against the tiers of the LOD (only the FULL and the REDUCED tiers are blurred)
+	uint64_t fullSampleCount;
+	uint64_t lodSampleCount;
+	double fullMilliseconds;
+	double lodMilliseconds;
+	// The RMSE (the luminance) of the pixels of the REDUCED tier against the full budget
+	double reducedRmse;
+
+	// The transitions of one head of which the distance oscillates by 10% around the threshold between the FULL and the REDUCED tiers: [0] without the hysteresis, [1] SSS_LOD_DEFAULT_HYSTERESIS
+	int transitionCount[2];
+
+	bool passed;
+};
+
+// The crowd of LOD_BENCHMARK_HEAD_COUNT spheres of the radius LOD_BENCHMARK_HEAD_RADIUS (side by side on the screen), of which the distances grow by 25% per head, are selected by the "SSSLodSelector" and blurred by the "SSSBlurCPU" with the stencil of the tiers.
+// The test passes if the tiers never get more detailed with the distance, the estimated pixels are within 25% of the ray cast pixels, the LOD takes fewer samples than the full budget and the hysteresis keeps the oscillating head in one tier.
+LodBenchmarkResult benchmarkLodSelection(int width = 1280, int height = 360, int repetitionCount = 2);
+
+std::ostream& operator<<(std::ostream& out, const LodBenchmarkResult& result);
+
+
+#define TEXTURE_SPACE_BENCHMARK_THREAD_COUNT_COUNT 4
+#define TEXTURE_SPACE_BENCHMARK_DISTANCE_COUNT 3
+// In the units of the scene (the world scale of the default profile), namely, 6.25 mm (the same as the "benchmarkPreintegratedLUT")
+#define TEXTURE_SPACE_BENCHMARK_SPHERE_RADIUS 0.05f
+#define TEXTURE_SPACE_BENCHMARK_HEAD_COUNT 8
+#define TEXTURE_SPACE_BENCHMARK_VISIBLE_HEAD_COUNT 4
+#define TEXTURE_SPACE_BENCHMARK_FRAME_COUNT 64
+#define TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT 4
+
+struct TextureSpaceBenchmarkResult
+{
+	int hardwareConcurrency;
+	int threadCount[TEXTURE_SPACE_BENCHMARK_THREAD_COUNT_COUNT];
+	// The "SSSTextureSpaceGeometry" and the "SSSTextureSpaceDiffusion" (the relighting included, SSS_TEXTURE_SPACE_DEFAULT_SAMPLE_COUNT samples) of one head, namely, the cost of one miss
+	double rasterizeMilliseconds[TEXTURE_SPACE_BENCHMARK_THREAD_COUNT_COUNT];
+	double diffuseMilliseconds[TEXTURE_SPACE_BENCHMARK_THREAD_COUNT_COUNT];
+	bool deterministic;
+	int coveredTexelCount;
+	// The relative error of the stretch along v against "PI * radius / size" (the stretch along u shrinks towards the poles)
+	double maxStretchError;
+
+	// The radius of the sphere on the screen
+	int radiusInPixels[TEXTURE_SPACE_BENCHMARK_DISTANCE_COUNT];
+	int pixelCount[TEXTURE_SPACE_BENCHMARK_DISTANCE_COUNT];
+	// The "SSSBlurCPU" (one thread, SSS_MAX_SAMPLE_BUDGET samples) against the lookup of the atlas (the bilinear fetch of each pixel, namely, the cost of one hit)
+	double blurMilliseconds[TEXTURE_SPACE_BENCHMARK_DISTANCE_COUNT];
+	double lookupMilliseconds[TEXTURE_SPACE_BENCHMARK_DISTANCE_COUNT];
+	// The RMSE (the luminance) against the blur: [0] "saturate(N.L)" (without the subsurface scattering), [1] the atlas
+	double rmse[TEXTURE_SPACE_BENCHMARK_DISTANCE_COUNT][2];
+
+	// The sequence of TEXTURE_SPACE_BENCHMARK_FRAME_COUNT frames (see "benchmarkTextureSpaceCache") replayed by the "SSSTextureSpaceCache" of 1, 2, 4 and 8 slots
+	int slotCount[TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT];
+	size_t memoryBudget[TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT];
+	size_t maxMemoryUsage[TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT];
+	uint64_t hitCount[TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT];
+	uint64_t missCount[TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT];
+	uint64_t evictionCount[TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT];
+	uint64_t fallbackCount[TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT];
+	// The misses expected when all heads fit into the budget: the first frame of each head and the frames of which the key of the head changes
+	uint64_t expectedMissCount;
+
+	bool passed;
+};
+
+// The UV sphere of the radius TEXTURE_SPACE_BENCHMARK_SPHERE_RADIUS (lit by one directional light) is rasterized into the texture space by the "SSSTextureSpaceGeometry", relit ("saturate(N.L)" of each texel) and diffused by the "SSSTextureSpaceDiffusion".
+// The atlas is sampled by the texture coordinates of the pixels of the sphere at the distances of which the radius on the screen is 128, 64 and 32 pixels, and compared with the blur of the "SSSBlurCPU".
+// The cache is replayed with TEXTURE_SPACE_BENCHMARK_HEAD_COUNT heads of which TEXTURE_SPACE_BENCHMARK_VISIBLE_HEAD_COUNT are visible (the window slides by one head every 8 frames), while the camera moves every frame (NOT in the key), the light changes every 16 frames and one head moves for 4 frames.
+// The test passes if the rasterization and the diffusion are deterministic, the stretch along v is within 1%, the atlas is closer to the blur than "saturate(N.L)" at all distances, the memory never exceeds the budget, the budgets of the visible heads never fall back and the misses of the largest budget are the expected misses.
+// NOTE: the rasterization and the diffusion are multithreaded (one band of SSS_TEXTURE_SPACE_ROWS_PER_TASK rows per work item), and the rest is single threaded.
+TextureSpaceBenchmarkResult benchmarkTextureSpaceCache(int width = 640, int height = 360, int repetitionCount = 2);
+
+std::ostream& operator<<(std::ostream& out, const TextureSpaceBenchmarkResult& result);
+
+#define GOLDEN_IMAGE_VERIFICATION_CASE_COUNT 8
+// The max absolute error (of all channels of all pixels) against the golden image, which covers the differences of the "std::exp2" / "std::log2" and of the floating point contraction between the compilers
+#define GOLDEN_IMAGE_VERIFICATION_TOLERANCE 1.0e-3
+
+struct GoldenImageVerificationResult
+{
+	// The golden image is "<goldenPathPrefix><name>.pfm"
+	const char* name[GOLDEN_IMAGE_VERIFICATION_CASE_COUNT];
+	// The golden image is missing or of another size
+	bool missing[GOLDEN_IMAGE_VERIFICATION_CASE_COUNT];
+	double maxAbsoluteError[GOLDEN_IMAGE_VERIFICATION_CASE_COUNT];
+	double rmse[GOLDEN_IMAGE_VERIFICATION_CASE_COUNT];
+
+	bool passed;
+};
+
+// The sphere of the "verifyMultiProfile" blurred by the "SSSBlurCPU" with the default settings and with each mode (the inverse CDF, the MIS, the separable blur, the half resolution, the adaptive sampling and the stochastic mode), against the golden images within GOLDEN_IMAGE_VERIFICATION_TOLERANCE.
+// The golden images are written instead (and the test passes) if "updateGolden" is true, which should only be done when the output of a mode is changed on purpose.
+GoldenImageVerificationResult verifyGoldenImages(const char* goldenPathPrefix, bool updateGolden = false, int width = 160, int height = 90);
+
+std::ostream& operator<<(std::ostream& out, const GoldenImageVerificationResult& result);
+
+#define ENERGY_CONSERVATION_VERIFICATION_CASE_COUNT 10
+#define ENERGY_CONSERVATION_VERIFICATION_TOLERANCE 1e-5
+
+struct EnergyConservationVerificationResult
+{
+	const char* name[ENERGY_CONSERVATION_VERIFICATION_CASE_COUNT];
+	// The maximum (of all pixels and channels) relative error against the "total_diffuse_reflectance_post_scatter" x the irradiance
+	double maxRelativeError[ENERGY_CONSERVATION_VERIFICATION_CASE_COUNT];
+
+	bool passed;
+};
+
+// A flat plane (facing the camera) of which the irradiance and the albedo are constant, blurred by the "SSSBlurCPU" with the default settings and with each mode (the modes of the "verifyGoldenImages", the irradiance pyramid and the sample count buckets).
+// The weights of each mode are normalized, s.t. the blur of the flat field is analytically the "total_diffuse_reflectance_post_scatter" x the irradiance (whatever the sample count), which every pixel should match within ENERGY_CONSERVATION_VERIFICATION_TOLERANCE.
+EnergyConservationVerificationResult verifyEnergyConservation(int width = 160, int height = 90);
+
+std::ostream& operator<<(std::ostream& out, const EnergyConservationVerificationResult& result);
+
+#endif
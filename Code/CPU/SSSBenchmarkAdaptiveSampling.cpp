@@ -0,0 +1,296 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+// The "SequenceConvergenceSource" of which the irradiance is the "irradianceRT" (point sampled)
+struct AdaptiveSamplingSource
+{
+	SequenceConvergenceSource plane;
+	const ImageRGBA32F* irradianceRT;
+
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const
+	{
+		const float* irradiance = irradianceRT->sampleLevelPoint(uv);
+		return float3(irradiance[0], irradiance[1], irradiance[2]);
+	}
+
+	float3 total_diffuse_reflectance_post_scatter(float2 uv) const
+	{
+		return plane.total_diffuse_reflectance_post_scatter(uv);
+	}
+
+	float subsurface_mask(float2 uv) const
+	{
+		return plane.subsurface_mask(uv);
+	}
+
+	int subsurface_profile_index(float2 uv) const
+	{
+		return plane.subsurface_profile_index(uv);
+	}
+
+	float view_space_position_z(float2 uv) const
+	{
+		return plane.view_space_position_z(uv);
+	}
+
+	float projection_x() const
+	{
+		return plane.projection_x();
+	}
+
+	float projection_y() const
+	{
+		return plane.projection_y();
+	}
+
+	float2 pixels_per_uv() const
+	{
+		return plane.pixels_per_uv();
+	}
+
+	float diffusion_profile_sample_r(float d, float cdf) const
+	{
+		return plane.diffusion_profile_sample_r(d, cdf);
+	}
+
+	float center_sample_cdf(float center_sample_cdf) const
+	{
+		return plane.center_sample_cdf(center_sample_cdf);
+	}
+
+	float2 sample_sequence(int sample_count, int sample_index) const
+	{
+		return plane.sample_sequence(sample_count, sample_index);
+	}
+
+	float2 sample_rotation() const
+	{
+		return plane.sample_rotation();
+	}
+
+	int mask_pyramid_level_count() const
+	{
+		return plane.mask_pyramid_level_count();
+	}
+
+	float4 mask_pyramid(int level, int x, int y) const
+	{
+		return plane.mask_pyramid(level, x, y);
+	}
+
+	int irradiance_pyramid_level_count() const
+	{
+		return plane.irradiance_pyramid_level_count();
+	}
+
+	float4 irradiance_pyramid(int level, int x, int y) const
+	{
+		return plane.irradiance_pyramid(level, x, y);
+	}
+
+	float irradiance_pyramid_view_space_position_z(int level, int x, int y) const
+	{
+		return plane.irradiance_pyramid_view_space_position_z(level, x, y);
+	}
+
+	float4 kernel_sample(float d, float center_sample_cdf, int sample_count, int sample_index) const
+	{
+		return subsurface_scattering_disney_kernel_sample(*this, d, center_sample_cdf, sample_count, sample_index);
+	}
+};
+
+AdaptiveSamplingResult benchmarkAdaptiveSampling(int size, int pixelStride)
+{
+	AdaptiveSamplingResult result = {};
+
+	SSSProfileTable profiles;
+	const SSSProfile& profile = profiles.getProfile(0);
+
+	// The same as the "benchmarkSequenceConvergence" except the filter radius
+	// pixels_per_mm = pixels_per_uv * 0.5 * projection / view_space_position_z / (1000 * world_scale)
+	const float pixelsPerMm = float(ADAPTIVE_SAMPLING_FILTER_RADIUS_IN_PIXELS) / profile.filterRadius;
+	const float worldScale = 0.5f * float(size) / (1000.0f * pixelsPerMm);
+	profiles.setWorldScale(0, worldScale);
+	const float2 pixelsPerUV = float2(float(size), float(size));
+	const int pixelsPerSample = SSS_MIN_PIXELS_PER_SAMPLE;
+
+	// The shadows of the disk and the half plane (u + 0.5 * v > 1) in uv
+	const float2 diskCenter(0.3f, 0.35f);
+	const float diskRadius = 0.12f;
+	const float filterRadiusInUV = float(ADAPTIVE_SAMPLING_FILTER_RADIUS_IN_PIXELS) / float(size);
+
+	// Projection (row major, SV_POSITION.z = (proj[2][2] * z + proj[3][2]) / z) of which the "projection_x" and the "projection_y" are 1
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+	float4x4 currProj = {};
+	currProj.m[0][0] = 1.0f;
+	currProj.m[1][1] = 1.0f;
+	currProj.m[2][2] = farPlane / (farPlane - nearPlane);
+	currProj.m[2][3] = 1.0f;
+	currProj.m[3][2] = -nearPlane * farPlane / (farPlane - nearPlane);
+
+	ImageRGBA32F irradianceRT(size, size);
+	ImageR32F depthRT(size, size);
+	ImageRGBA32F albedoRT(size, size);
+	ImageR8U edgeMask(size, size);
+	for (int y = 0; y < size; ++y)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			const float u = (float(x) + 0.5f) / float(size);
+			const float v = (float(y) + 0.5f) / float(size);
+			const float diskDistance = std::sqrt((u - diskCenter.x) * (u - diskCenter.x) + (v - diskCenter.y) * (v - diskCenter.y)) - diskRadius;
+			const float planeDistance = (u + 0.5f * v - 1.0f) * float(1.0 / 1.11803398874989484820);
+
+			const float lit = ((diskDistance < 0.0f) || (planeDistance > 0.0f)) ? 0.1f : 1.0f;
+			float* irradiance = irradianceRT(x, y);
+			irradiance[0] = lit * 0.9f;
+			irradiance[1] = lit * 0.7f;
+			irradiance[2] = lit * 0.6f;
+
+			// The view space position z is 1
+			depthRT(x, y)[0] = currProj.m[2][2] + currProj.m[3][2];
+
+			float* albedo = albedoRT(x, y);
+			albedo[0] = 1.0f;
+			albedo[1] = 1.0f;
+			albedo[2] = 1.0f;
+			albedo[3] = 1.0f;
+
+			edgeMask(x, y)[0] = ((std::abs(diskDistance) < filterRadiusInUV) || (std::abs(planeDistance) < filterRadiusInUV)) ? uint8_t(1U) : uint8_t(0U);
+		}
+	}
+
+	vector<float2> uvs;
+	vector<bool> edges;
+	for (int y = pixelStride / 2; y < size; y += pixelStride)
+	{
+		for (int x = pixelStride / 2; x < size; x += pixelStride)
+		{
+			uvs.push_back(float2((float(x) + 0.5f) / pixelsPerUV.x, (float(y) + 0.5f) / pixelsPerUV.y));
+			edges.push_back(0U != edgeMask(x, y)[0]);
+			((0U != edgeMask(x, y)[0]) ? result.edgePixelCount : result.flatPixelCount) += 1;
+		}
+	}
+
+	const AdaptiveSamplingSource source = { { LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY, pixelsPerUV, 0U }, &irradianceRT };
+	vector<float3> reference(uvs.size());
+	for (size_t uvIndex = 0; uvIndex < uvs.size(); ++uvIndex)
+	{
+		reference[uvIndex] = subsurface_scattering_disney_blur<SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT>(source, profile.scatteringDistance, profile.filterRadius, worldScale, pixelsPerSample, SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT, SSS_MIS_MODE_NONE, uvs[uvIndex]);
+	}
+
+	SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, pixelsPerSample);
+	blur.setKernelCacheEnabled(false);
+	blur.setInverseCdfMode(SSS_INVERSE_CDF_MODE_ANALYTIC);
+
+	// rmse: [0] all, [1] edge, [2] flat
+	// return: the samples per pixel
+	auto render = [&](double rmse[3]) -> double
+	{
+		ImageRGBA32F mainRT(size, size);
+		blur.go(mainRT, irradianceRT, depthRT, NULL, albedoRT, currProj, profiles);
+
+		double sumSquaredError[3] = { 0.0, 0.0, 0.0 };
+		for (size_t uvIndex = 0; uvIndex < uvs.size(); ++uvIndex)
+		{
+			const float* radiance = mainRT.sampleLevelPoint(uvs[uvIndex]);
+			const double squaredError =
+				(double(radiance[0]) - double(reference[uvIndex].x)) * (double(radiance[0]) - double(reference[uvIndex].x)) +
+				(double(radiance[1]) - double(reference[uvIndex].y)) * (double(radiance[1]) - double(reference[uvIndex].y)) +
+				(double(radiance[2]) - double(reference[uvIndex].z)) * (double(radiance[2]) - double(reference[uvIndex].z));
+			sumSquaredError[0] += squaredError;
+			sumSquaredError[edges[uvIndex] ? 1 : 2] += squaredError;
+		}
+		rmse[0] = std::sqrt(sumSquaredError[0] / double(3 * std::max(result.edgePixelCount + result.flatPixelCount, 1)));
+		rmse[1] = std::sqrt(sumSquaredError[1] / double(3 * std::max(result.edgePixelCount, 1)));
+		rmse[2] = std::sqrt(sumSquaredError[2] / double(3 * std::max(result.flatPixelCount, 1)));
+
+		return double(blur.getSampleCount()) / double(size * size);
+	};
+
+	// The uniform sample budgets 4, 8, ..., SSS_MAX_SAMPLE_BUDGET
+	double uniformBudgetRmse[SSS_MAX_SAMPLE_BUDGET / 4];
+	for (int uniformIndex = 0; uniformIndex < (SSS_MAX_SAMPLE_BUDGET / 4); ++uniformIndex)
+	{
+		double rmse[3];
+		blur.setNSamples(4 * (uniformIndex + 1));
+		render(rmse);
+		uniformBudgetRmse[uniformIndex] = rmse[0];
+	}
+
+	static const int samplesPerPixel[ADAPTIVE_SAMPLING_BUDGET_COUNT] = { 16, 24, 32, 48 };
+	result.passed = true;
+	for (int budgetIndex = 0; budgetIndex < ADAPTIVE_SAMPLING_BUDGET_COUNT; ++budgetIndex)
+	{
+		result.samplesPerPixel[budgetIndex] = samplesPerPixel[budgetIndex];
+
+		double rmse[3];
+		blur.setSamplesPerFrame(0);
+		blur.setNSamples(samplesPerPixel[budgetIndex]);
+		result.uniformSamplesPerPixel[budgetIndex] = render(rmse);
+		result.uniformRmse[budgetIndex] = rmse[0];
+		result.uniformEdgeRmse[budgetIndex] = rmse[1];
+		result.uniformFlatRmse[budgetIndex] = rmse[2];
+
+		blur.setSamplesPerFrame(samplesPerPixel[budgetIndex] * size * size);
+		blur.setNSamples(SSS_MAX_SAMPLE_BUDGET);
+		result.adaptiveSamplesPerPixel[budgetIndex] = render(rmse);
+		result.adaptiveRmse[budgetIndex] = rmse[0];
+		result.adaptiveEdgeRmse[budgetIndex] = rmse[1];
+		result.adaptiveFlatRmse[budgetIndex] = rmse[2];
+
+		result.passed = result.passed && (result.adaptiveRmse[budgetIndex] <= result.uniformRmse[budgetIndex]) && (result.adaptiveSamplesPerPixel[budgetIndex] <= 1.01 * double(samplesPerPixel[budgetIndex]));
+
+		for (int uniformIndex = 0; uniformIndex < (SSS_MAX_SAMPLE_BUDGET / 4); ++uniformIndex)
+		{
+			if (uniformBudgetRmse[uniformIndex] <= result.adaptiveRmse[budgetIndex])
+			{
+				result.uniformBudgetToMatchAdaptive[budgetIndex] = 4 * (uniformIndex + 1);
+				break;
+			}
+		}
+	}
+	blur.setSamplesPerFrame(0);
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const AdaptiveSamplingResult& result)
+{
+	out << "Adaptive Sampling (" << (result.passed ? "passed" : "FAILED") << ", RMSE against " << SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT << " samples, " << result.edgePixelCount << " edge / " << result.flatPixelCount << " flat pixels)" << endl;
+	for (int budgetIndex = 0; budgetIndex < ADAPTIVE_SAMPLING_BUDGET_COUNT; ++budgetIndex)
+	{
+		out << "  " << setw(2) << result.samplesPerPixel[budgetIndex] << " samples per pixel" << endl;
+		out << "    uniform:  " << std::fixed << setprecision(1) << setw(5) << result.uniformSamplesPerPixel[budgetIndex] << " spp";
+		out << std::scientific << setprecision(3) << "  rmse " << result.uniformRmse[budgetIndex] << " (edge " << result.uniformEdgeRmse[budgetIndex] << ", flat " << result.uniformFlatRmse[budgetIndex] << ")" << endl;
+		out << "    adaptive: " << std::fixed << setprecision(1) << setw(5) << result.adaptiveSamplesPerPixel[budgetIndex] << " spp";
+		out << std::scientific << setprecision(3) << "  rmse " << result.adaptiveRmse[budgetIndex] << " (edge " << result.adaptiveEdgeRmse[budgetIndex] << ", flat " << result.adaptiveFlatRmse[budgetIndex] << ")";
+		out << "  matches uniform " << result.uniformBudgetToMatchAdaptive[budgetIndex] << endl;
+	}
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,257 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+CoherentSamplingBenchmarkResult benchmarkCoherentSampling(int width, int height, int repetitionCount)
+{
+	CoherentSamplingBenchmarkResult result = {};
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+
+	// The irradiance (RGB) and the depth (A), the same as the "SSSBlurCPU"
+	ImageRGBA32F irradianceDepthRT(width, height);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const float* irradiance = irradianceRT(x, y);
+			float* irradianceDepth = irradianceDepthRT(x, y);
+			irradianceDepth[0] = irradiance[0];
+			irradianceDepth[1] = irradiance[1];
+			irradianceDepth[2] = irradiance[2];
+			irradianceDepth[3] = depthRT(x, y)[0];
+
+			result.pixelCount += (0U != stencil(x, y)[0]) ? 1 : 0;
+		}
+	}
+
+	// Simulated Cache
+	SwizzledImageRGBA32F swizzledIrradianceDepth;
+	SwizzledImageRGBA32F swizzledAlbedo;
+	SwizzledImageR8U swizzledStencil;
+	swizzledIrradianceDepth.swizzle(irradianceDepthRT, IMAGE_LAYOUT_ROW_MAJOR);
+	swizzledAlbedo.swizzle(albedoRT, IMAGE_LAYOUT_ROW_MAJOR);
+	swizzledStencil.swizzle(stencil, IMAGE_LAYOUT_ROW_MAJOR);
+
+	const int bandY0 = std::max(0, (height - IMAGE_LAYOUT_BENCHMARK_BAND_HEIGHT) / 2);
+	const int bandY1 = std::min(height, bandY0 + IMAGE_LAYOUT_BENCHMARK_BAND_HEIGHT);
+	for (int blockSizeIndex = 0; blockSizeIndex < COHERENT_SAMPLING_BENCHMARK_BLOCK_SIZE_COUNT; ++blockSizeIndex)
+	{
+		const int blockSize = 1 << blockSizeIndex;
+		result.blockSize[blockSizeIndex] = blockSize;
+
+		SimulatedCache l1Cache(IMAGE_LAYOUT_BENCHMARK_L1_CACHE_SIZE, IMAGE_LAYOUT_BENCHMARK_L1_CACHE_WAY_COUNT, IMAGE_LAYOUT_BENCHMARK_CACHE_LINE_SIZE);
+		SimulatedCache l2Cache(IMAGE_LAYOUT_BENCHMARK_L2_CACHE_SIZE, IMAGE_LAYOUT_BENCHMARK_L2_CACHE_WAY_COUNT, IMAGE_LAYOUT_BENCHMARK_CACHE_LINE_SIZE);
+		const ImageLayoutBenchmarkSource source = { swizzledIrradianceDepth, swizzledAlbedo, swizzledStencil, currProj, l1Cache, l2Cache };
+
+		std::vector<subsurface_scattering_disney_blur_state> blockStates(static_cast<size_t>(blockSize * blockSize));
+		std::vector<subsurface_scattering_disney_blur_sample> blockSamples(static_cast<size_t>(blockSize * blockSize));
+		std::vector<uint64_t> fetchList(static_cast<size_t>(blockSize * blockSize));
+		for (int tileY0 = bandY0; tileY0 < bandY1; tileY0 += SSS_TILE_SIZE)
+		{
+			for (int tileX0 = 0; tileX0 < width; tileX0 += SSS_TILE_SIZE)
+			{
+				const int tileY1 = std::min(tileY0 + SSS_TILE_SIZE, bandY1);
+				const int tileX1 = std::min(tileX0 + SSS_TILE_SIZE, width);
+				for (int blockY0 = tileY0; blockY0 < tileY1; blockY0 += blockSize)
+				{
+					for (int blockX0 = tileX0; blockX0 < tileX1; blockX0 += blockSize)
+					{
+						int blockPixelCount = 0;
+						int blockSampleCount = 0;
+						for (int y = blockY0; y < std::min(blockY0 + blockSize, tileY1); ++y)
+						{
+							for (int x = blockX0; x < std::min(blockX0 + blockSize, tileX1); ++x)
+							{
+								if (0U == stencil(x, y)[0])
+								{
+									continue;
+								}
+
+								const SSSProfile& profile = profiles.getProfile(subsurface_scattering_profile_index_from_stencil(stencil(x, y)[0]));
+								const float2 center_uv((float(x) + 0.5f) / float(width), (float(y) + 0.5f) / float(height));
+								subsurface_scattering_disney_blur_result blur;
+								if (subsurface_scattering_disney_blur_begin(source, profile.scatteringDistance, profile.filterRadius, profile.worldScale, SSS_MIN_PIXELS_PER_SAMPLE, SSS_MAX_SAMPLE_BUDGET, SSS_MIS_MODE_NONE, 0.0f, center_uv, blockStates[blockPixelCount], blur))
+								{
+									blockSampleCount = std::max(blockSampleCount, blockStates[blockPixelCount].sample_count);
+									++blockPixelCount;
+								}
+							}
+						}
+
+						// The fetch lists of the block (the same as the "SSSBlurCPU")
+						for (int sampleIndex = 0; sampleIndex < blockSampleCount; ++sampleIndex)
+						{
+							int fetchCount = 0;
+							for (int pixelIndex = 0; pixelIndex < blockPixelCount; ++pixelIndex)
+							{
+								if (sampleIndex < blockStates[pixelIndex].sample_count)
+								{
+									blockSamples[pixelIndex] = subsurface_scattering_disney_blur_generate(source, blockStates[pixelIndex], sampleIndex);
+
+									const int sampleX = ImageRGBA32F::texelCoord(blockSamples[pixelIndex].sample_uv.x, width);
+									const int sampleY = ImageRGBA32F::texelCoord(blockSamples[pixelIndex].sample_uv.y, height);
+									fetchList[fetchCount] = ((static_cast<uint64_t>(sampleY) * static_cast<uint64_t>(width) + static_cast<uint64_t>(sampleX)) << 8) | static_cast<uint64_t>(pixelIndex);
+									++fetchCount;
+								}
+							}
+
+							std::sort(fetchList.begin(), fetchList.begin() + fetchCount);
+
+							for (int fetchIndex = 0; fetchIndex < fetchCount; ++fetchIndex)
+							{
+								const int pixelIndex = static_cast<int>(fetchList[fetchIndex] & 0xFFU);
+								subsurface_scattering_disney_blur_accumulate(source, blockStates[pixelIndex], blockSamples[pixelIndex]);
+							}
+						}
+
+						for (int pixelIndex = 0; pixelIndex < blockPixelCount; ++pixelIndex)
+						{
+							subsurface_scattering_disney_blur_end(source, blockStates[pixelIndex]);
+						}
+					}
+				}
+			}
+		}
+
+		result.l1MissRate[blockSizeIndex] = double(l1Cache.getMissCount()) / double(std::max(uint64_t(1U), l1Cache.getAccessCount()));
+		result.l2MissRate[blockSizeIndex] = double(l2Cache.getMissCount()) / double(std::max(uint64_t(1U), l2Cache.getAccessCount()));
+	}
+
+	// Throughput
+	SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+
+	// [0] per pixel, [1] the coherent sampling
+	ImageRGBA32F mainRT[2] = { ImageRGBA32F(width, height), ImageRGBA32F(width, height) };
+
+	// Warm up (NOT timed): the kernel cache and the first pass over the images in each order
+	for (int modeIndex = 0; modeIndex < 2; ++modeIndex)
+	{
+		blur.setCoherentSamplingEnabled(0 != modeIndex);
+		blur.go(mainRT[modeIndex], irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+	}
+
+	for (int modeIndex = 0; modeIndex < 2; ++modeIndex)
+	{
+		blur.setCoherentSamplingEnabled(0 != modeIndex);
+		double seconds = 0.0;
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			std::fill(mainRT[modeIndex].getData(), mainRT[modeIndex].getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			blur.go(mainRT[modeIndex], irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+			seconds += elapsedSeconds(begin);
+		}
+		result.millisecondsPerFrame[modeIndex] = 1000.0 * seconds / double(std::max(1, repetitionCount));
+	}
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				result.maxAbsoluteError = std::max(result.maxAbsoluteError, double(std::abs(mainRT[1](x, y)[channel] - mainRT[0](x, y)[channel])));
+			}
+		}
+	}
+
+	// Image Quality
+	// The error of the coherent sampling of the low budget against the coherent sampling of SSS_MAX_SAMPLE_BUDGET samples
+	SSSBlurCPU lowBlur(false, COHERENT_SAMPLING_BENCHMARK_LOW_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+	lowBlur.setCoherentSamplingEnabled(true);
+	ImageRGBA32F lowRT(width, height);
+	lowBlur.go(lowRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+
+	ImageR32F errorRT(width, height);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const float* low = lowRT(x, y);
+			const float* reference = mainRT[1](x, y);
+			errorRT(x, y)[0] = 0.2126f * (low[0] - reference[0]) + 0.7152f * (low[1] - reference[1]) + 0.0722f * (low[2] - reference[2]);
+		}
+	}
+
+	// The neighbors (both covered) of which the "x" or the "y" is the last of the block are across the boundary
+	// NOTE: the blocks are aligned to the tiles, and the size of the tiles is a multiple of the size of the blocks
+	const int coherentBlockSize = result.blockSize[2];
+	double sumAcross = 0.0;
+	double countAcross = 0.0;
+	double sumWithin = 0.0;
+	double countWithin = 0.0;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			if (0U == stencil(x, y)[0])
+			{
+				continue;
+			}
+
+			const int neighborX[2] = { x + 1, x };
+			const int neighborY[2] = { y, y + 1 };
+			const bool across[2] = { (coherentBlockSize - 1) == (x % coherentBlockSize), (coherentBlockSize - 1) == (y % coherentBlockSize) };
+			for (int neighborIndex = 0; neighborIndex < 2; ++neighborIndex)
+			{
+				if ((neighborX[neighborIndex] >= width) || (neighborY[neighborIndex] >= height) || (0U == stencil(neighborX[neighborIndex], neighborY[neighborIndex])[0]))
+				{
+					continue;
+				}
+
+				const double difference = std::abs(double(errorRT(neighborX[neighborIndex], neighborY[neighborIndex])[0]) - double(errorRT(x, y)[0]));
+				(across[neighborIndex] ? sumAcross : sumWithin) += difference;
+				(across[neighborIndex] ? countAcross : countWithin) += 1.0;
+			}
+		}
+	}
+	result.seamRatio = (sumWithin > 0.0) ? ((sumAcross / std::max(countAcross, 1.0)) / (sumWithin / std::max(countWithin, 1.0))) : 1.0;
+
+	result.passed = (result.maxAbsoluteError == 0.0) && (std::abs(result.seamRatio - 1.0) < 0.1);
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const CoherentSamplingBenchmarkResult& result)
+{
+	out << "Coherent Sampling (" << result.pixelCount << " pixels, simulated " << (IMAGE_LAYOUT_BENCHMARK_L1_CACHE_SIZE / 1024) << " KiB L1 / " << (IMAGE_LAYOUT_BENCHMARK_L2_CACHE_SIZE / 1024) << " KiB L2 miss rate of the blocks)" << endl;
+	for (int blockSizeIndex = 0; blockSizeIndex < COHERENT_SAMPLING_BENCHMARK_BLOCK_SIZE_COUNT; ++blockSizeIndex)
+	{
+		out << "  " << result.blockSize[blockSizeIndex] << "x" << result.blockSize[blockSizeIndex] << ": " << std::fixed << setprecision(2);
+		out << "L1 " << setw(6) << (100.0 * result.l1MissRate[blockSizeIndex]) << "%, L2 " << setw(6) << (100.0 * result.l2MissRate[blockSizeIndex]) << "%" << endl;
+	}
+	out << "  per pixel " << setw(9) << result.millisecondsPerFrame[0] << " ms, coherent " << setw(9) << result.millisecondsPerFrame[1] << " ms (x" << (result.millisecondsPerFrame[0] / result.millisecondsPerFrame[1]) << ")";
+	out << std::scientific << setprecision(2) << ", max error " << result.maxAbsoluteError << std::fixed << endl;
+	out << "  seam ratio (error across / within the blocks) " << setprecision(3) << result.seamRatio << endl;
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	return out;
+}
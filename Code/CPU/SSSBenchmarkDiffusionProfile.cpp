@@ -0,0 +1,295 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+#include "diffusion_profile_simd.h"
+#include "diffusion_profile_inverse_cdf_lut.h"
+
+using namespace std;
+
+static double ulpError(float value, double reference)
+{
+	if (!(std::isfinite(value) && std::isfinite(reference)))
+	{
+		return (value == reference) ? 0.0 : HUGE_VAL;
+	}
+
+	int exponent;
+	std::frexp(std::max(std::abs(reference), double(FLT_MIN)), &exponent);
+	double ulp = std::ldexp(1.0, exponent - 24);
+	return std::abs(double(value) - reference) / ulp;
+}
+
+static double referenceSampleR(double d, double cdf)
+{
+	double u = 1.0 - cdf;
+	double g = 1.0 + (4.0 * u) * (2.0 * u + std::sqrt(1.0 + (4.0 * u) * u));
+	double n = std::pow(g, -1.0 / 3.0);
+	double p = std::pow(g, 1.0 / 3.0);
+	double c = 1.0 + p + n;
+	double x = 3.0 * std::log(c / (4.0 * u));
+	return x * d;
+}
+
+static double referenceCdf(double d, double r)
+{
+	return 1.0 - 0.25 * std::exp(-r / d) - 0.75 * std::exp(-r / (3.0 * d));
+}
+
+static double referenceRcpPdf(double d, double r)
+{
+	return (8.0 * PI) * d / (std::exp(-r / d) + std::exp(-r / (3.0 * d)));
+}
+
+static double referencePdf(double S, double r)
+{
+	return S / (8.0 * PI) * (std::exp(-S * r) + std::exp(-S * r / 3.0));
+}
+
+DiffusionProfileBenchmarkResult benchmarkDiffusionProfile(int sampleCount, int repetitionCount)
+{
+	DiffusionProfileBenchmarkResult result = {};
+	result.simdWidth = diffusion_profile_simd_width();
+
+	const float3 S = float3(1.0f, 1.0f, 1.0f) / benchmarkScatteringDistance;
+	const float d = std::max(std::max(benchmarkScatteringDistance.x, benchmarkScatteringDistance.y), benchmarkScatteringDistance.z);
+
+	vector<float> cdf(sampleCount);
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		// [0, 0.999]
+		cdf[i] = 0.999f * (float(i) + 0.5f) / float(sampleCount);
+	}
+
+	vector<float> r(sampleCount);
+	vector<float> rcp_pdf(sampleCount);
+	vector<float> pdf_r(sampleCount);
+	vector<float> pdf_g(sampleCount);
+	vector<float> pdf_b(sampleCount);
+
+	// NOTE: the checksums prevent the compiler from eliminating the loops
+	volatile float checksum = 0.0f;
+
+	// Reference
+	{
+		auto begin = chrono::steady_clock::now();
+		for (int repetition = 0; repetition < repetitionCount; ++repetition)
+		{
+			for (int i = 0; i < sampleCount; ++i)
+			{
+				r[i] = diffusion_profile_sample_r(d, cdf[i]);
+				rcp_pdf[i] = diffusion_profile_evaluate_rcp_pdf(d, r[i]);
+				float3 pdf = diffusion_profile_evaluate_pdf(S, r[i]);
+				pdf_r[i] = pdf.x;
+				pdf_g[i] = pdf.y;
+				pdf_b[i] = pdf.z;
+			}
+			checksum = checksum + pdf_g[repetition % sampleCount];
+		}
+		result.referenceSamplesPerSecond = double(sampleCount) * double(repetitionCount) / elapsedSeconds(begin);
+	}
+
+	// Scalar Approximation (NOT used by the batch, merely the reference of the SIMD versions)
+	{
+		auto begin = chrono::steady_clock::now();
+		for (int repetition = 0; repetition < repetitionCount; ++repetition)
+		{
+			for (int i = 0; i < sampleCount; ++i)
+			{
+				r[i] = approx_diffusion_profile_sample_r(d, cdf[i]);
+				rcp_pdf[i] = approx_diffusion_profile_evaluate_rcp_pdf(d, r[i]);
+				float3 pdf = approx_diffusion_profile_evaluate_pdf(S, r[i]);
+				pdf_r[i] = pdf.x;
+				pdf_g[i] = pdf.y;
+				pdf_b[i] = pdf.z;
+			}
+			checksum = checksum + pdf_g[repetition % sampleCount];
+		}
+		result.approxSamplesPerSecond = double(sampleCount) * double(repetitionCount) / elapsedSeconds(begin);
+	}
+
+	// Batch
+	{
+		auto begin = chrono::steady_clock::now();
+		for (int repetition = 0; repetition < repetitionCount; ++repetition)
+		{
+			diffusion_profile_sample_r_batch(d, cdf.data(), r.data(), sampleCount);
+			diffusion_profile_evaluate_rcp_pdf_batch(d, r.data(), rcp_pdf.data(), sampleCount);
+			diffusion_profile_evaluate_pdf_batch(S, r.data(), pdf_r.data(), pdf_g.data(), pdf_b.data(), sampleCount);
+			checksum = checksum + pdf_g[repetition % sampleCount];
+		}
+		result.batchSamplesPerSecond = double(sampleCount) * double(repetitionCount) / elapsedSeconds(begin);
+	}
+
+	// Accuracy
+	// NOTE: the domain is restricted to where the formulas are well-conditioned (the cancellation of "1 - 0.25 - 0.75" when r -> 0 is inherent to the formulas)
+	{
+		const int accuracySampleCount = sampleCount;
+		vector<float> x(accuracySampleCount);
+		vector<float> y(accuracySampleCount);
+		vector<float> y_g(accuracySampleCount);
+		vector<float> y_b(accuracySampleCount);
+
+		// cdf in [0.05, 0.999999]
+		for (int i = 0; i < accuracySampleCount; ++i)
+		{
+			x[i] = 0.05f + (0.999999f - 0.05f) * float(i) / float(accuracySampleCount - 1);
+		}
+		diffusion_profile_sample_r_batch(1.0f, x.data(), y.data(), accuracySampleCount);
+		for (int i = 0; i < accuracySampleCount; ++i)
+		{
+			double reference = referenceSampleR(1.0, x[i]);
+			result.sampleRMaxULP[0] = std::max(result.sampleRMaxULP[0], ulpError(diffusion_profile_sample_r(1.0f, x[i]), reference));
+			result.sampleRMaxULP[1] = std::max(result.sampleRMaxULP[1], ulpError(y[i], reference));
+		}
+
+		// r / d in [0.05, 64]
+		for (int i = 0; i < accuracySampleCount; ++i)
+		{
+			x[i] = 0.05f + (64.0f - 0.05f) * float(i) / float(accuracySampleCount - 1);
+		}
+		diffusion_profile_evaluate_cdf_batch(1.0f, x.data(), y.data(), accuracySampleCount);
+		for (int i = 0; i < accuracySampleCount; ++i)
+		{
+			double reference = referenceCdf(1.0, x[i]);
+			result.cdfMaxULP[0] = std::max(result.cdfMaxULP[0], ulpError(diffusion_profile_evaluate_cdf(1.0f, x[i]), reference));
+			result.cdfMaxULP[1] = std::max(result.cdfMaxULP[1], ulpError(y[i], reference));
+		}
+
+		diffusion_profile_evaluate_rcp_pdf_batch(1.0f, x.data(), y.data(), accuracySampleCount);
+		for (int i = 0; i < accuracySampleCount; ++i)
+		{
+			double reference = referenceRcpPdf(1.0, x[i]);
+			result.rcpPdfMaxULP[0] = std::max(result.rcpPdfMaxULP[0], ulpError(diffusion_profile_evaluate_rcp_pdf(1.0f, x[i]), reference));
+			result.rcpPdfMaxULP[1] = std::max(result.rcpPdfMaxULP[1], ulpError(y[i], reference));
+		}
+
+		diffusion_profile_evaluate_pdf_batch(float3(1.0f, 1.0f, 1.0f), x.data(), y.data(), y_g.data(), y_b.data(), accuracySampleCount);
+		for (int i = 0; i < accuracySampleCount; ++i)
+		{
+			double reference = referencePdf(1.0, x[i]);
+			result.pdfMaxULP[0] = std::max(result.pdfMaxULP[0], ulpError(diffusion_profile_evaluate_pdf(float3(1.0f, 1.0f, 1.0f), x[i]).x, reference));
+			result.pdfMaxULP[1] = std::max(result.pdfMaxULP[1], ulpError(y[i], reference));
+		}
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const DiffusionProfileBenchmarkResult& result)
+{
+	out << "Diffusion Profile (SIMD width " << result.simdWidth << ")" << endl;
+	out << setprecision(3) << std::fixed;
+	out << "  reference (std::exp2 / std::log2): " << (result.referenceSamplesPerSecond / 1.0e6) << " M samples/s/core" << endl;
+	out << "  scalar approximation (unused)    : " << (result.approxSamplesPerSecond / 1.0e6) << " M samples/s/core" << endl;
+	out << "  batch                            : " << (result.batchSamplesPerSecond / 1.0e6) << " M samples/s/core (x" << (result.batchSamplesPerSecond / result.referenceSamplesPerSecond) << ")" << endl;
+	out << setprecision(1);
+	out << "  max error (reference / batch): sample_r " << result.sampleRMaxULP[0] << " / " << result.sampleRMaxULP[1] << " ULP";
+	out << ", cdf " << result.cdfMaxULP[0] << " / " << result.cdfMaxULP[1] << " ULP";
+	out << ", rcp_pdf " << result.rcpPdfMaxULP[0] << " / " << result.rcpPdfMaxULP[1] << " ULP";
+	out << ", pdf " << result.pdfMaxULP[0] << " / " << result.pdfMaxULP[1] << " ULP" << endl;
+	return out;
+}
+
+InverseCdfLUTBenchmarkResult benchmarkInverseCdfLUT(int sampleCount, int repetitionCount)
+{
+	InverseCdfLUTBenchmarkResult result = {};
+
+	const float d = std::max(std::max(benchmarkScatteringDistance.x, benchmarkScatteringDistance.y), benchmarkScatteringDistance.z);
+
+	// NOTE: the cdf values are shuffled by the radical inverse, s.t. the branch of the "SSS_INVERSE_CDF_LUT_MAX_CDF" is NOT trivially predictable
+	vector<float> cdf(sampleCount);
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		cdf[i] = hammersley_2d(uint32_t(i), uint32_t(sampleCount)).y;
+	}
+
+	vector<float> r(sampleCount);
+
+	volatile float checksum = 0.0f;
+
+	{
+		auto begin = chrono::steady_clock::now();
+		for (int repetition = 0; repetition < repetitionCount; ++repetition)
+		{
+			for (int i = 0; i < sampleCount; ++i)
+			{
+				r[i] = diffusion_profile_sample_r(d, cdf[i]);
+			}
+			checksum = checksum + r[repetition % sampleCount];
+		}
+		result.analyticSamplesPerSecond = double(sampleCount) * double(repetitionCount) / elapsedSeconds(begin);
+	}
+
+	for (int sizeIndex = 0; sizeIndex < INVERSE_CDF_LUT_BENCHMARK_SIZE_COUNT; ++sizeIndex)
+	{
+		const int lutSize = (32 << sizeIndex);
+		result.lutSize[sizeIndex] = lutSize;
+
+		const DiffusionProfileInverseCdfLUT lut(lutSize);
+
+		for (int modeIndex = 0; modeIndex < 2; ++modeIndex)
+		{
+			const int mode = (0 == modeIndex) ? SSS_INVERSE_CDF_MODE_LUT_LINEAR : SSS_INVERSE_CDF_MODE_LUT_HERMITE;
+
+			auto begin = chrono::steady_clock::now();
+			for (int repetition = 0; repetition < repetitionCount; ++repetition)
+			{
+				for (int i = 0; i < sampleCount; ++i)
+				{
+					r[i] = lut.sampleR(mode, d, cdf[i]);
+				}
+				checksum = checksum + r[repetition % sampleCount];
+			}
+			result.samplesPerSecond[sizeIndex][modeIndex] = double(sampleCount) * double(repetitionCount) / elapsedSeconds(begin);
+
+			for (int i = 0; i < sampleCount; ++i)
+			{
+				float x = SSS_INVERSE_CDF_LUT_MAX_CDF * (float(i) + 0.5f) / float(sampleCount);
+				double reference = referenceSampleR(1.0, x);
+				double error = std::abs(double(lut.sampleR(mode, 1.0f, x)) - reference);
+				result.maxAbsoluteError[sizeIndex][modeIndex] = std::max(result.maxAbsoluteError[sizeIndex][modeIndex], error);
+				result.maxRelativeError[sizeIndex][modeIndex] = std::max(result.maxRelativeError[sizeIndex][modeIndex], error / reference);
+			}
+		}
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const InverseCdfLUTBenchmarkResult& result)
+{
+	out << "Inverse CDF LUT (max cdf " << SSS_INVERSE_CDF_LUT_MAX_CDF << ")" << endl;
+	out << setprecision(3) << std::fixed;
+	out << "  analytic: " << (result.analyticSamplesPerSecond / 1.0e6) << " M samples/s/core" << endl;
+	for (int sizeIndex = 0; sizeIndex < INVERSE_CDF_LUT_BENCHMARK_SIZE_COUNT; ++sizeIndex)
+	{
+		for (int modeIndex = 0; modeIndex < 2; ++modeIndex)
+		{
+			out << "  " << setw(4) << result.lutSize[sizeIndex] << ((0 == modeIndex) ? " linear : " : " hermite: ");
+			out << std::fixed << setprecision(3) << (result.samplesPerSecond[sizeIndex][modeIndex] / 1.0e6) << " M samples/s/core (x" << (result.samplesPerSecond[sizeIndex][modeIndex] / result.analyticSamplesPerSecond) << ")";
+			out << std::scientific << setprecision(2) << ", max error " << result.maxRelativeError[sizeIndex][modeIndex] << " (relative) " << result.maxAbsoluteError[sizeIndex][modeIndex] << " (absolute)" << endl;
+		}
+	}
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,147 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include "SSSBenchmarkInternal.h"
+#include "subsurface_scattering_texturing_mode.h"
+
+using namespace std;
+
+EnergyConservationVerificationResult verifyEnergyConservation(int width, int height)
+{
+	EnergyConservationVerificationResult result = {};
+
+	SSSProfileTable profiles;
+	profiles.addProfile(benchmarkScatteringDistance, benchmarkScatteringDistance, 0.25f);
+
+	// Projection (row major, SV_POSITION.z = (proj[2][2] * z + proj[3][2]) / z), the same as the "multiProfileScene"
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+	const float yScale = 1.0f / std::tan(0.5f * (20.0f * float(PI) / 180.0f));
+	float4x4 currProj = {};
+	currProj.m[0][0] = yScale * float(height) / float(width);
+	currProj.m[1][1] = yScale;
+	currProj.m[2][2] = farPlane / (farPlane - nearPlane);
+	currProj.m[2][3] = 1.0f;
+	currProj.m[3][2] = -nearPlane * farPlane / (farPlane - nearPlane);
+
+	const float viewPositionZ = 3.0f;
+	const float3 irradiance(0.6f, 0.75f, 0.9f);
+	const float3 albedo(0.8f, 0.5f, 0.3f);
+
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			depthRT(x, y)[0] = (currProj.m[2][2] * viewPositionZ + currProj.m[3][2]) / viewPositionZ;
+			stencil(x, y)[0] = subsurface_scattering_profile_stencil_ref(0);
+
+			float* irradianceTexel = irradianceRT(x, y);
+			irradianceTexel[0] = irradiance.x;
+			irradianceTexel[1] = irradiance.y;
+			irradianceTexel[2] = irradiance.z;
+			irradianceTexel[3] = 1.0f;
+
+			float* albedoTexel = albedoRT(x, y);
+			albedoTexel[0] = albedo.x;
+			albedoTexel[1] = albedo.y;
+			albedoTexel[2] = albedo.z;
+			albedoTexel[3] = 1.0f;
+		}
+	}
+
+	const float3 expected = subsurface_scattering_total_diffuse_reflectance_post_scatter_from_albedo(false, albedo) * irradiance;
+
+	static const char* const names[ENERGY_CONSERVATION_VERIFICATION_CASE_COUNT] = { "default", "inverse_cdf_lut_hermite", "mis_balance", "separable", "half_resolution", "adaptive", "stochastic", "kernel_cache", "irradiance_pyramid", "sample_count_buckets" };
+
+	result.passed = true;
+	for (int caseIndex = 0; caseIndex < ENERGY_CONSERVATION_VERIFICATION_CASE_COUNT; ++caseIndex)
+	{
+		result.name[caseIndex] = names[caseIndex];
+
+		SSSBlurCPU blur(false, 32, SSS_MIN_PIXELS_PER_SAMPLE);
+		switch (caseIndex)
+		{
+		case 1:
+			blur.setInverseCdfMode(SSS_INVERSE_CDF_MODE_LUT_HERMITE);
+			break;
+		case 2:
+			blur.setMisMode(SSS_MIS_MODE_BALANCE);
+			break;
+		case 3:
+			blur.setBlurMode(SSS_BLUR_MODE_SEPARABLE);
+			break;
+		case 4:
+			blur.setResolutionFactor(SSS_RESOLUTION_FACTOR_HALF);
+			break;
+		case 5:
+			// 8 samples per pixel of the screen
+			blur.setSamplesPerFrame(8 * width * height);
+			break;
+		case 6:
+			blur.setStochasticSampleCount(2);
+			break;
+		case 7:
+			blur.setKernelCacheEnabled(true);
+			break;
+		case 8:
+			blur.setIrradiancePyramidEnabled(true);
+			break;
+		case 9:
+			blur.setSampleCountBucketsEnabled(true);
+			break;
+		}
+
+		ImageRGBA32F mainRT(width, height);
+		blur.go(mainRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					const double error = std::abs(double(mainRT(x, y)[channel]) - double((&expected.x)[channel])) / double((&expected.x)[channel]);
+					// NOTE: the NaN fails the test
+					result.maxRelativeError[caseIndex] = (error == error) ? std::max(result.maxRelativeError[caseIndex], error) : std::numeric_limits<double>::infinity();
+				}
+			}
+		}
+		result.passed = result.passed && (result.maxRelativeError[caseIndex] <= ENERGY_CONSERVATION_VERIFICATION_TOLERANCE);
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const EnergyConservationVerificationResult& result)
+{
+	out << "Energy Conservation (tolerance " << std::scientific << setprecision(2) << ENERGY_CONSERVATION_VERIFICATION_TOLERANCE << ")" << endl;
+	for (int caseIndex = 0; caseIndex < ENERGY_CONSERVATION_VERIFICATION_CASE_COUNT; ++caseIndex)
+	{
+		out << "  " << left << setw(24) << result.name[caseIndex] << right << "max error " << result.maxRelativeError[caseIndex] << " (relative)" << endl;
+	}
+	out << std::fixed;
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	return out;
+}
@@ -0,0 +1,235 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+// The irradiance after the round trip of the render target (the conversion of the format by the hardware and the decode of the "SSS_Blur.hlsli")
+// The "partnerRGB" is the irradiance of the texel (partnerX, y), which is only used by the YCoCg
+static float3 gbufferEncodingIrradianceRoundTrip(int irradianceEncoding, float3 rgb, float3 partnerRGB, int x, int partnerX, int y)
+{
+	switch (irradianceEncoding)
+	{
+	case SSS_IRRADIANCE_ENCODING_R11G11B10F:
+	{
+		return subsurface_scattering_r11g11b10f_decode(subsurface_scattering_r11g11b10f_encode(rgb));
+	}
+	case SSS_IRRADIANCE_ENCODING_RGB9E5:
+	{
+		const float2 stored = subsurface_scattering_rgb9e5_to_unorm16x2(subsurface_scattering_rgb9e5_encode(rgb));
+		const float2 loaded(subsurface_scattering_unorm16_decode(subsurface_scattering_unorm16_encode(stored.x)), subsurface_scattering_unorm16_decode(subsurface_scattering_unorm16_encode(stored.y)));
+		return subsurface_scattering_rgb9e5_decode(subsurface_scattering_rgb9e5_from_unorm16x2(loaded));
+	}
+	case SSS_IRRADIANCE_ENCODING_YCOCG:
+	{
+		const float2 center = subsurface_scattering_ycocg_encode(rgb, x, y);
+		const float2 partner = subsurface_scattering_ycocg_encode(partnerRGB, partnerX, y);
+		const float2 centerLoaded(subsurface_scattering_half_decode(subsurface_scattering_half_encode(center.x)), subsurface_scattering_half_decode(subsurface_scattering_half_encode(center.y)));
+		const float2 partnerLoaded(subsurface_scattering_half_decode(subsurface_scattering_half_encode(partner.x)), subsurface_scattering_half_decode(subsurface_scattering_half_encode(partner.y)));
+		return subsurface_scattering_ycocg_decode(centerLoaded, partnerLoaded, x, y);
+	}
+	default:
+	{
+		return float3(subsurface_scattering_half_decode(subsurface_scattering_half_encode(rgb.x)), subsurface_scattering_half_decode(subsurface_scattering_half_encode(rgb.y)), subsurface_scattering_half_decode(subsurface_scattering_half_encode(rgb.z)));
+	}
+	}
+}
+
+// The view depth after the round trip of the render target
+static float gbufferEncodingDepthRoundTrip(int depthEncoding, float viewPositionZ, const float4x4& currProj)
+{
+	switch (depthEncoding)
+	{
+	case SSS_DEPTH_ENCODING_LINEAR_R16:
+	{
+		return subsurface_scattering_linear_depth_decode(subsurface_scattering_unorm16_decode(subsurface_scattering_unorm16_encode(subsurface_scattering_linear_depth_encode(viewPositionZ, currProj))), currProj);
+	}
+	case SSS_DEPTH_ENCODING_VIEW_Z_R16F:
+	{
+		return subsurface_scattering_half_decode(subsurface_scattering_half_encode(viewPositionZ));
+	}
+	case SSS_DEPTH_ENCODING_VIEW_Z_R32F:
+	{
+		return viewPositionZ;
+	}
+	default:
+	{
+		const float depth = subsurface_scattering_ndcz_from_view_space_position_z(viewPositionZ, currProj);
+		return currProj.m[3][2] / (depth - currProj.m[2][2]);
+	}
+	}
+}
+
+GBufferEncodingVerificationResult verifyGBufferEncoding(int width, int height)
+{
+	GBufferEncodingVerificationResult result = {};
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+
+	// The round trip of the codecs
+	const float nearPlane = -currProj.m[3][2] / currProj.m[2][2];
+	const float farPlane = currProj.m[3][2] / (1.0f - currProj.m[2][2]);
+	// NOTE: the error relative to the max channel is bounded by the half ULP of the mantissa (10 bits of the half, 5 bits of the blue of the R11G11B10F, 9 bits of the RGB9E5 of which the max channel may be rounded up to the next exponent), and the YCoCg sums the errors of the luma and the two chroma
+	const double irradianceErrorBound[SSS_IRRADIANCE_ENCODING_COUNT] = { std::ldexp(1.0, -11), std::ldexp(1.0, -6), std::ldexp(1.0, -9) * (512.0 / 511.0), std::ldexp(1.0, -9) };
+	for (int sampleIndex = 0; sampleIndex < GBUFFER_ENCODING_VERIFICATION_ROUND_TRIP_COUNT; ++sampleIndex)
+	{
+		const float2 xi = sobol_owen_2d(uint32_t(sampleIndex));
+		const float2 eta = r2_2d(uint32_t(sampleIndex));
+		const float3 rgb(std::exp2(xi.x * 20.0f - 10.0f), std::exp2(xi.y * 20.0f - 10.0f), std::exp2(eta.x * 20.0f - 10.0f));
+		const float maxChannel = std::max(std::max(rgb.x, rgb.y), rgb.z);
+		for (int irradianceEncoding = 0; irradianceEncoding < SSS_IRRADIANCE_ENCODING_COUNT; ++irradianceEncoding)
+		{
+			const float3 decoded = gbufferEncodingIrradianceRoundTrip(irradianceEncoding, rgb, rgb, 0, 1, 0);
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				result.irradianceMaxRelativeError[irradianceEncoding] = std::max(result.irradianceMaxRelativeError[irradianceEncoding], double(std::abs((&decoded.x)[channel] - (&rgb.x)[channel])) / double(maxChannel));
+			}
+		}
+
+		const float viewPositionZ = nearPlane * (1.0f + 9.0f * eta.y);
+		for (int depthEncoding = 0; depthEncoding < SSS_DEPTH_ENCODING_COUNT; ++depthEncoding)
+		{
+			result.depthMaxRelativeError[depthEncoding] = std::max(result.depthMaxRelativeError[depthEncoding], double(std::abs(gbufferEncodingDepthRoundTrip(depthEncoding, viewPositionZ, currProj) - viewPositionZ)) / double(viewPositionZ));
+		}
+	}
+
+	// NOTE: the NDC is bounded by the ULP of the float near 1 (2^-24) divided by the derivative of the NDC (-proj[3][2] / z^2), the linear depth is bounded by the half ULP of the UNORM16 over the range of the depth (namely, the worst at the near plane), and the view space position z is bounded by the half ULP of the mantissa (exact in the R32F)
+	result.depthErrorBound[SSS_DEPTH_ENCODING_NDC_R32F] = 4.0 * std::ldexp(1.0, -24) * 10.0 * double(nearPlane) / double(-currProj.m[3][2]);
+	result.depthErrorBound[SSS_DEPTH_ENCODING_LINEAR_R16] = (0.5 / 65535.0 + std::ldexp(1.0, -23)) * double(farPlane - nearPlane) / double(nearPlane);
+	result.depthErrorBound[SSS_DEPTH_ENCODING_VIEW_Z_R16F] = std::ldexp(1.0, -11);
+	result.depthErrorBound[SSS_DEPTH_ENCODING_VIEW_Z_R32F] = 0.0;
+
+	result.passed = true;
+	for (int irradianceEncoding = 0; irradianceEncoding < SSS_IRRADIANCE_ENCODING_COUNT; ++irradianceEncoding)
+	{
+		result.irradianceErrorBound[irradianceEncoding] = irradianceErrorBound[irradianceEncoding];
+		result.passed = result.passed && (result.irradianceMaxRelativeError[irradianceEncoding] <= irradianceErrorBound[irradianceEncoding]);
+	}
+	for (int depthEncoding = 0; depthEncoding < SSS_DEPTH_ENCODING_COUNT; ++depthEncoding)
+	{
+		result.passed = result.passed && (result.depthMaxRelativeError[depthEncoding] <= result.depthErrorBound[depthEncoding]);
+	}
+
+	// The blur of the unencoded irradiance and depth
+	SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE);
+	ImageRGBA32F referenceRT(width, height);
+	blur.go(referenceRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+	const double acceptedSampleCount = double(blur.getSampleCount() - blur.getRejectedSampleCount());
+
+	size_t pixelCount = 0U;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			pixelCount += (0U != stencil(x, y)[0]) ? 1U : 0U;
+		}
+	}
+
+	for (int irradianceEncoding = 0; irradianceEncoding < SSS_IRRADIANCE_ENCODING_COUNT; ++irradianceEncoding)
+	{
+		for (int depthEncoding = 0; depthEncoding < SSS_DEPTH_ENCODING_COUNT; ++depthEncoding)
+		{
+			// The blur reads the decoded render targets
+			ImageRGBA32F encodedIrradianceRT(width, height);
+			ImageR32F encodedDepthRT(width, height);
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					const int partnerX = subsurface_scattering_ycocg_partner_x(x, width);
+					const float3 rgb(irradianceRT(x, y)[0], irradianceRT(x, y)[1], irradianceRT(x, y)[2]);
+					const float3 partnerRGB(irradianceRT(partnerX, y)[0], irradianceRT(partnerX, y)[1], irradianceRT(partnerX, y)[2]);
+					const float3 decoded = gbufferEncodingIrradianceRoundTrip(irradianceEncoding, rgb, partnerRGB, x, partnerX, y);
+					encodedIrradianceRT(x, y)[0] = decoded.x;
+					encodedIrradianceRT(x, y)[1] = decoded.y;
+					encodedIrradianceRT(x, y)[2] = decoded.z;
+					encodedIrradianceRT(x, y)[3] = irradianceRT(x, y)[3];
+
+					// NOTE: the background (of which the NDC depth is zero) is NOT read by the blur
+					const float depth = depthRT(x, y)[0];
+					encodedDepthRT(x, y)[0] = (0U != stencil(x, y)[0]) ? subsurface_scattering_ndcz_from_view_space_position_z(gbufferEncodingDepthRoundTrip(depthEncoding, currProj.m[3][2] / (depth - currProj.m[2][2]), currProj), currProj) : depth;
+				}
+			}
+
+			ImageRGBA32F mainRT(width, height);
+			blur.go(mainRT, encodedIrradianceRT, encodedDepthRT, &stencil, albedoRT, currProj, profiles);
+
+			double sumSquaredError = 0.0;
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					if (0U != stencil(x, y)[0])
+					{
+						for (int channel = 0; channel < 3; ++channel)
+						{
+							const double error = double(mainRT(x, y)[channel]) - double(referenceRT(x, y)[channel]);
+							sumSquaredError += error * error;
+						}
+					}
+				}
+			}
+			result.blurRmse[irradianceEncoding][depthEncoding] = std::sqrt(sumSquaredError / double(std::max(size_t(1U), 3U * pixelCount)));
+
+			const double texelSize = double(subsurface_scattering_irradiance_encoding_size(irradianceEncoding) + subsurface_scattering_depth_encoding_size(depthEncoding));
+			result.megabytesPerFrame[irradianceEncoding][depthEncoding] = texelSize * (double(width) * double(height) + double(pixelCount) + acceptedSampleCount) / (1024.0 * 1024.0);
+		}
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const GBufferEncodingVerificationResult& result)
+{
+	static const char* const irradianceEncodingNames[SSS_IRRADIANCE_ENCODING_COUNT] = { "RGBA16F   ", "R11G11B10F", "RGB9E5    ", "YCoCg     " };
+	static const char* const depthEncodingNames[SSS_DEPTH_ENCODING_COUNT] = { "NDC R32F   ", "Linear R16 ", "View Z R16F", "View Z R32F" };
+
+	out << "G-Buffer Encoding (round trip max relative error / bound)" << endl;
+	out << std::scientific << setprecision(2);
+	for (int irradianceEncoding = 0; irradianceEncoding < SSS_IRRADIANCE_ENCODING_COUNT; ++irradianceEncoding)
+	{
+		out << "  irradiance " << irradianceEncodingNames[irradianceEncoding] << ": " << result.irradianceMaxRelativeError[irradianceEncoding] << " / " << result.irradianceErrorBound[irradianceEncoding] << endl;
+	}
+	for (int depthEncoding = 0; depthEncoding < SSS_DEPTH_ENCODING_COUNT; ++depthEncoding)
+	{
+		out << "  depth      " << depthEncodingNames[depthEncoding] << ": " << result.depthMaxRelativeError[depthEncoding] << " / " << result.depthErrorBound[depthEncoding] << endl;
+	}
+	out << "  blur (RMSE against the unencoded irradiance and depth, bandwidth of the irradiance and the depth per frame)" << endl;
+	for (int irradianceEncoding = 0; irradianceEncoding < SSS_IRRADIANCE_ENCODING_COUNT; ++irradianceEncoding)
+	{
+		for (int depthEncoding = 0; depthEncoding < SSS_DEPTH_ENCODING_COUNT; ++depthEncoding)
+		{
+			out << "    " << irradianceEncodingNames[irradianceEncoding] << " + " << depthEncodingNames[depthEncoding] << ": ";
+			out << std::scientific << setprecision(2) << "rmse " << result.blurRmse[irradianceEncoding][depthEncoding];
+			out << std::fixed << setprecision(2) << ", " << setw(7) << result.megabytesPerFrame[irradianceEncoding][depthEncoding] << " MiB (x" << (result.megabytesPerFrame[irradianceEncoding][depthEncoding] / result.megabytesPerFrame[SSS_IRRADIANCE_ENCODING_RGBA16F][SSS_DEPTH_ENCODING_NDC_R32F]) << ")" << endl;
+		}
+	}
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,196 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <string>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+#include "diffusion_profile_inverse_cdf_lut.h"
+
+using namespace std;
+
+// Portable Float Map (RGB of the "ImageRGBA32F", little endian, the rows from the bottom to the top)
+static bool writeGoldenPFM(const string& path, const ImageRGBA32F& image)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (NULL == file)
+	{
+		return false;
+	}
+
+	fprintf(file, "PF\n%d %d\n-1.0\n", image.getWidth(), image.getHeight());
+	vector<float> row(static_cast<size_t>(image.getWidth()) * 3U);
+	for (int y = image.getHeight() - 1; y >= 0; --y)
+	{
+		for (int x = 0; x < image.getWidth(); ++x)
+		{
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				row[static_cast<size_t>(x) * 3U + channel] = image(x, y)[channel];
+			}
+		}
+		fwrite(row.data(), sizeof(float), row.size(), file);
+	}
+
+	fclose(file);
+	return true;
+}
+
+// The alpha channel of the "image" is zero
+static bool readGoldenPFM(const string& path, ImageRGBA32F& image)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (NULL == file)
+	{
+		return false;
+	}
+
+	char magic[3] = {};
+	int width = 0;
+	int height = 0;
+	double scale = 0.0;
+	bool succeeded = (4 == fscanf(file, "%2s %d %d %lf", magic, &width, &height, &scale)) && (string("PF") == magic) && (width == image.getWidth()) && (height == image.getHeight()) && (scale < 0.0);
+	// One whitespace between the header and the data
+	succeeded = succeeded && (EOF != fgetc(file));
+
+	vector<float> row(static_cast<size_t>(std::max(width, 0)) * 3U);
+	for (int y = height - 1; succeeded && (y >= 0); --y)
+	{
+		succeeded = (row.size() == fread(row.data(), sizeof(float), row.size(), file));
+		for (int x = 0; succeeded && (x < width); ++x)
+		{
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				image(x, y)[channel] = row[static_cast<size_t>(x) * 3U + channel];
+			}
+			image(x, y)[3] = 0.0f;
+		}
+	}
+
+	fclose(file);
+	return succeeded;
+}
+
+GoldenImageVerificationResult verifyGoldenImages(const char* goldenPathPrefix, bool updateGolden, int width, int height)
+{
+	GoldenImageVerificationResult result = {};
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+
+	static const char* const names[GOLDEN_IMAGE_VERIFICATION_CASE_COUNT] = { "default", "inverse_cdf_lut_hermite", "mis_balance", "separable", "half_resolution", "adaptive", "stochastic", "kernel_cache" };
+
+	result.passed = true;
+	for (int caseIndex = 0; caseIndex < GOLDEN_IMAGE_VERIFICATION_CASE_COUNT; ++caseIndex)
+	{
+		result.name[caseIndex] = names[caseIndex];
+
+		SSSBlurCPU blur(false, 32, SSS_MIN_PIXELS_PER_SAMPLE);
+		switch (caseIndex)
+		{
+		case 1:
+			blur.setInverseCdfMode(SSS_INVERSE_CDF_MODE_LUT_HERMITE);
+			break;
+		case 2:
+			blur.setMisMode(SSS_MIS_MODE_BALANCE);
+			break;
+		case 3:
+			blur.setBlurMode(SSS_BLUR_MODE_SEPARABLE);
+			break;
+		case 4:
+			blur.setResolutionFactor(SSS_RESOLUTION_FACTOR_HALF);
+			break;
+		case 5:
+			// 8 samples per pixel of the screen
+			blur.setSamplesPerFrame(8 * width * height);
+			break;
+		case 6:
+			blur.setStochasticSampleCount(2);
+			break;
+		case 7:
+			blur.setKernelCacheEnabled(true);
+			break;
+		}
+
+		ImageRGBA32F mainRT(width, height);
+		blur.go(mainRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+
+		const string path = string(goldenPathPrefix) + names[caseIndex] + ".pfm";
+		if (updateGolden)
+		{
+			result.passed = writeGoldenPFM(path, mainRT) && result.passed;
+			continue;
+		}
+
+		ImageRGBA32F goldenRT(width, height);
+		result.missing[caseIndex] = !readGoldenPFM(path, goldenRT);
+		if (result.missing[caseIndex])
+		{
+			result.passed = false;
+			continue;
+		}
+
+		double squaredErrorSum = 0.0;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					const double error = std::abs(double(mainRT(x, y)[channel]) - double(goldenRT(x, y)[channel]));
+					// NOTE: the NaN fails the test
+					result.maxAbsoluteError[caseIndex] = (error == error) ? std::max(result.maxAbsoluteError[caseIndex], error) : std::numeric_limits<double>::infinity();
+					squaredErrorSum += error * error;
+				}
+			}
+		}
+		result.rmse[caseIndex] = std::sqrt(squaredErrorSum / (3.0 * double(width) * double(height)));
+		result.passed = result.passed && (result.maxAbsoluteError[caseIndex] <= GOLDEN_IMAGE_VERIFICATION_TOLERANCE);
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const GoldenImageVerificationResult& result)
+{
+	out << "Golden Images (tolerance " << std::scientific << setprecision(2) << GOLDEN_IMAGE_VERIFICATION_TOLERANCE << ")" << endl;
+	for (int caseIndex = 0; caseIndex < GOLDEN_IMAGE_VERIFICATION_CASE_COUNT; ++caseIndex)
+	{
+		out << "  " << left << setw(24) << result.name[caseIndex] << right;
+		if (result.missing[caseIndex])
+		{
+			out << "missing" << endl;
+		}
+		else
+		{
+			out << "max error " << result.maxAbsoluteError[caseIndex] << ", rmse " << result.rmse[caseIndex] << endl;
+		}
+	}
+	out << std::fixed;
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	return out;
+}
@@ -0,0 +1,307 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+#include "SSSBenchmarkInternal.h"
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// The hardware counters (user space only, including the threads which are created after the "begin") of the L1 data cache and the last level cache reads
+// Only the "perf_event_open" of Linux is supported, and the "error" is the "errno" (ENOENT if the PMU is NOT exposed, e.g. by the virtual machine, EACCES if denied by the "perf_event_paranoid") or ENOSYS on the other platforms.
+class HardwareCacheCounters
+{
+public:
+	enum
+	{
+		L1_ACCESS = 0,
+		L1_MISS = 1,
+		LLC_ACCESS = 2,
+		LLC_MISS = 3,
+		COUNTER_COUNT = 4
+	};
+
+	HardwareCacheCounters() : m_error(0)
+	{
+		for (int counter = 0; counter < COUNTER_COUNT; ++counter)
+		{
+			m_fd[counter] = -1;
+			m_value[counter] = 0U;
+		}
+
+#if defined(__linux__)
+		const uint64_t configs[COUNTER_COUNT] = {
+			PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16),
+			PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+			PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16),
+			PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) };
+		for (int counter = 0; (counter < COUNTER_COUNT) && (0 == m_error); ++counter)
+		{
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(perf_event_attr));
+			attr.size = sizeof(perf_event_attr);
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = configs[counter];
+			attr.disabled = 1;
+			attr.inherit = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			m_fd[counter] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+			m_error = (m_fd[counter] < 0) ? errno : 0;
+		}
+#else
+		m_error = ENOSYS;
+#endif
+	}
+
+	~HardwareCacheCounters()
+	{
+#if defined(__linux__)
+		for (int counter = 0; counter < COUNTER_COUNT; ++counter)
+		{
+			if (m_fd[counter] >= 0)
+			{
+				close(m_fd[counter]);
+			}
+		}
+#endif
+	}
+
+	HardwareCacheCounters(const HardwareCacheCounters&) = delete;
+	HardwareCacheCounters& operator=(const HardwareCacheCounters&) = delete;
+
+	int getError() const { return m_error; }
+
+	void begin()
+	{
+#if defined(__linux__)
+		for (int counter = 0; (counter < COUNTER_COUNT) && (0 == m_error); ++counter)
+		{
+			ioctl(m_fd[counter], PERF_EVENT_IOC_RESET, 0);
+			ioctl(m_fd[counter], PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	// The counts are accumulated from the "begin"
+	void end()
+	{
+#if defined(__linux__)
+		for (int counter = 0; (counter < COUNTER_COUNT) && (0 == m_error); ++counter)
+		{
+			ioctl(m_fd[counter], PERF_EVENT_IOC_DISABLE, 0);
+			uint64_t value = 0U;
+			m_error = (sizeof(uint64_t) == read(m_fd[counter], &value, sizeof(uint64_t))) ? 0 : EIO;
+			m_value[counter] += value;
+		}
+#endif
+	}
+
+	uint64_t getValue(int counter) const { return m_value[counter]; }
+
+private:
+	int m_fd[COUNTER_COUNT];
+	uint64_t m_value[COUNTER_COUNT];
+	int m_error;
+};
+
+ImageLayoutBenchmarkResult benchmarkImageLayout(int repetitionCount)
+{
+	ImageLayoutBenchmarkResult result = {};
+
+	const int widths[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT] = { 1920, 3840 };
+	const int heights[IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT] = { 1080, 2160 };
+
+	SSSBlurCPU blur(false, IMAGE_LAYOUT_BENCHMARK_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+
+	result.roundTripExact = true;
+	result.passed = true;
+	for (int resolutionIndex = 0; resolutionIndex < IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT; ++resolutionIndex)
+	{
+		const int width = widths[resolutionIndex];
+		const int height = heights[resolutionIndex];
+		result.width[resolutionIndex] = width;
+		result.height[resolutionIndex] = height;
+
+		SSSProfileTable profiles;
+		float4x4 currProj;
+		ImageRGBA32F irradianceRT(width, height);
+		ImageR32F depthRT(width, height);
+		ImageR8U stencil(width, height);
+		ImageRGBA32F albedoRT(width, height);
+		multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+
+		// The irradiance (RGB) and the depth (A), the same as the "SSSBlurCPU"
+		ImageRGBA32F irradianceDepthRT(width, height);
+		int pixelCount = 0;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const float* irradiance = irradianceRT(x, y);
+				float* irradianceDepth = irradianceDepthRT(x, y);
+				irradianceDepth[0] = irradiance[0];
+				irradianceDepth[1] = irradiance[1];
+				irradianceDepth[2] = irradiance[2];
+				irradianceDepth[3] = depthRT(x, y)[0];
+
+				pixelCount += (0U != stencil(x, y)[0]) ? 1 : 0;
+			}
+		}
+		result.pixelCount[resolutionIndex] = pixelCount;
+
+		// [IMAGE_LAYOUT_ROW_MAJOR] is the reference
+		ImageRGBA32F mainRT[IMAGE_LAYOUT_COUNT] = { ImageRGBA32F(width, height), ImageRGBA32F(width, height), ImageRGBA32F(width, height) };
+		for (int layout = 0; layout < IMAGE_LAYOUT_COUNT; ++layout)
+		{
+			// Conversion
+			SwizzledImageRGBA32F swizzledIrradianceDepth;
+			SwizzledImageR32F swizzledDepth;
+			SwizzledImageRGBA32F swizzledAlbedo;
+			SwizzledImageR8U swizzledStencil;
+			{
+				chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+				swizzledIrradianceDepth.swizzle(irradianceDepthRT, layout);
+				swizzledDepth.swizzle(depthRT, layout);
+				swizzledAlbedo.swizzle(albedoRT, layout);
+				swizzledStencil.swizzle(stencil, layout);
+				result.swizzleMilliseconds[resolutionIndex][layout] = 1000.0 * elapsedSeconds(begin);
+			}
+
+			ImageRGBA32F roundTripRT(width, height);
+			swizzledAlbedo.unswizzle(roundTripRT);
+			result.roundTripExact = result.roundTripExact && std::equal(albedoRT.getData(), albedoRT.getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, roundTripRT.getData());
+
+			// Cache Model
+			{
+				SimulatedCache l1Cache(IMAGE_LAYOUT_BENCHMARK_L1_CACHE_SIZE, IMAGE_LAYOUT_BENCHMARK_L1_CACHE_WAY_COUNT, IMAGE_LAYOUT_BENCHMARK_CACHE_LINE_SIZE);
+				SimulatedCache l2Cache(IMAGE_LAYOUT_BENCHMARK_L2_CACHE_SIZE, IMAGE_LAYOUT_BENCHMARK_L2_CACHE_WAY_COUNT, IMAGE_LAYOUT_BENCHMARK_CACHE_LINE_SIZE);
+				const ImageLayoutBenchmarkSource source = { swizzledIrradianceDepth, swizzledAlbedo, swizzledStencil, currProj, l1Cache, l2Cache };
+
+				const int bandY0 = std::max(0, (height - IMAGE_LAYOUT_BENCHMARK_BAND_HEIGHT) / 2);
+				const int bandY1 = std::min(height, bandY0 + IMAGE_LAYOUT_BENCHMARK_BAND_HEIGHT);
+				for (int tileY0 = bandY0; tileY0 < bandY1; tileY0 += SSS_TILE_SIZE)
+				{
+					for (int tileX0 = 0; tileX0 < width; tileX0 += SSS_TILE_SIZE)
+					{
+						for (int y = tileY0; y < std::min(tileY0 + SSS_TILE_SIZE, bandY1); ++y)
+						{
+							for (int x = tileX0; x < std::min(tileX0 + SSS_TILE_SIZE, width); ++x)
+							{
+								if (0U == stencil(x, y)[0])
+								{
+									continue;
+								}
+
+								const SSSProfile& profile = profiles.getProfile(subsurface_scattering_profile_index_from_stencil(stencil(x, y)[0]));
+								const float2 center_uv((float(x) + 0.5f) / float(width), (float(y) + 0.5f) / float(height));
+								subsurface_scattering_disney_blur<IMAGE_LAYOUT_BENCHMARK_SAMPLE_BUDGET>(source, profile.scatteringDistance, profile.filterRadius, profile.worldScale, SSS_MIN_PIXELS_PER_SAMPLE, IMAGE_LAYOUT_BENCHMARK_SAMPLE_BUDGET, SSS_MIS_MODE_NONE, center_uv);
+							}
+						}
+					}
+				}
+
+				result.l1MissRate[resolutionIndex][layout] = double(l1Cache.getMissCount()) / double(std::max(uint64_t(1U), l1Cache.getAccessCount()));
+				result.l2MissRate[resolutionIndex][layout] = double(l2Cache.getMissCount()) / double(std::max(uint64_t(1U), l2Cache.getAccessCount()));
+			}
+
+			// Throughput (and the hardware counters of the whole "go", including the swizzle)
+			blur.setImageLayout(layout);
+			HardwareCacheCounters counters;
+			double seconds = 0.0;
+			for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+			{
+				std::fill(mainRT[layout].getData(), mainRT[layout].getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+				chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+				counters.begin();
+				blur.go(mainRT[layout], irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+				counters.end();
+				seconds += elapsedSeconds(begin);
+			}
+			result.millisecondsPerFrame[resolutionIndex][layout] = 1000.0 * seconds / double(std::max(1, repetitionCount));
+
+			result.hardwareCounterError = (0 != result.hardwareCounterError) ? result.hardwareCounterError : counters.getError();
+			if (0 == counters.getError())
+			{
+				result.hardwareL1MissRate[resolutionIndex][layout] = double(counters.getValue(HardwareCacheCounters::L1_MISS)) / double(std::max(uint64_t(1U), counters.getValue(HardwareCacheCounters::L1_ACCESS)));
+				result.hardwareLlcMissRate[resolutionIndex][layout] = double(counters.getValue(HardwareCacheCounters::LLC_MISS)) / double(std::max(uint64_t(1U), counters.getValue(HardwareCacheCounters::LLC_ACCESS)));
+				result.hardwareL1MissesPerPixel[resolutionIndex][layout] = double(counters.getValue(HardwareCacheCounters::L1_MISS)) / double(std::max(1, pixelCount * std::max(1, repetitionCount)));
+				result.hardwareLlcMissesPerPixel[resolutionIndex][layout] = double(counters.getValue(HardwareCacheCounters::LLC_MISS)) / double(std::max(1, pixelCount * std::max(1, repetitionCount)));
+			}
+
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					for (int channel = 0; channel < 4; ++channel)
+					{
+						result.maxAbsoluteError[resolutionIndex][layout] = std::max(result.maxAbsoluteError[resolutionIndex][layout], double(std::abs(mainRT[layout](x, y)[channel] - mainRT[IMAGE_LAYOUT_ROW_MAJOR](x, y)[channel])));
+					}
+				}
+			}
+
+			result.passed = result.passed && (result.maxAbsoluteError[resolutionIndex][layout] == 0.0);
+		}
+	}
+	blur.setImageLayout(IMAGE_LAYOUT_ROW_MAJOR);
+
+	result.passed = result.passed && result.roundTripExact;
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const ImageLayoutBenchmarkResult& result)
+{
+	static const char* const layoutNames[IMAGE_LAYOUT_COUNT] = { "row-major   ", "morton      ", "block-linear" };
+
+	out << "Image Layout (MODEL: the miss rate of a simulated " << (IMAGE_LAYOUT_BENCHMARK_L1_CACHE_SIZE / 1024) << " KiB L1 / " << (IMAGE_LAYOUT_BENCHMARK_L2_CACHE_SIZE / 1024) << " KiB L2 of the fetches of a band, NOT measured; cost per frame including the swizzle)" << endl;
+	if (0 != result.hardwareCounterError)
+	{
+		out << "  hardware counters unavailable (perf_event_open: " << std::strerror(result.hardwareCounterError) << "), only the model is reported" << endl;
+	}
+	for (int resolutionIndex = 0; resolutionIndex < IMAGE_LAYOUT_BENCHMARK_RESOLUTION_COUNT; ++resolutionIndex)
+	{
+		out << "  " << result.width[resolutionIndex] << "x" << result.height[resolutionIndex] << " (" << result.pixelCount[resolutionIndex] << " pixels)" << endl;
+		for (int layout = 0; layout < IMAGE_LAYOUT_COUNT; ++layout)
+		{
+			out << "    " << layoutNames[layout] << ": " << std::fixed << setprecision(2);
+			out << "model L1 " << setw(6) << (100.0 * result.l1MissRate[resolutionIndex][layout]) << "%, L2 " << setw(6) << (100.0 * result.l2MissRate[resolutionIndex][layout]) << "%";
+			if (0 == result.hardwareCounterError)
+			{
+				out << ", measured L1D " << setw(6) << (100.0 * result.hardwareL1MissRate[resolutionIndex][layout]) << "% (" << result.hardwareL1MissesPerPixel[resolutionIndex][layout] << " per pixel)";
+				out << ", LLC " << setw(6) << (100.0 * result.hardwareLlcMissRate[resolutionIndex][layout]) << "% (" << result.hardwareLlcMissesPerPixel[resolutionIndex][layout] << " per pixel)";
+			}
+			out << ", " << setw(9) << result.millisecondsPerFrame[resolutionIndex][layout] << " ms (x" << (result.millisecondsPerFrame[resolutionIndex][IMAGE_LAYOUT_ROW_MAJOR] / result.millisecondsPerFrame[resolutionIndex][layout]) << ")";
+			out << ", swizzle " << setw(7) << result.swizzleMilliseconds[resolutionIndex][layout] << " ms";
+			out << std::scientific << setprecision(2) << ", max error " << result.maxAbsoluteError[resolutionIndex][layout] << endl;
+		}
+	}
+	out << "  round trip " << (result.roundTripExact ? "exact" : "NOT exact") << endl;
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	out << std::fixed;
+	return out;
+}
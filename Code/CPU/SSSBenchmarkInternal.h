@@ -0,0 +1,468 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSBenchmarkInternal_H_
+#define _SSSBenchmarkInternal_H_ 1
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SSSBenchmark.h"
+#include "subsurface_scattering_disney_blur.h"
+#include "SSSBlurCPU.h"
+#include "subsurface_scattering_temporal.h"
+#include "SSSIrradiancePyramid.h"
+#include "SSSCurvatureMap.h"
+
+// Shared by the benchmarks of the features (SSSBenchmark*.cpp), NOT part of the interface of the "SSSBenchmark.h"
+
+// The default skin profile of the HUD
+extern const float3 benchmarkScatteringDistance;
+
+double elapsedSeconds(std::chrono::steady_clock::time_point begin);
+
+// A synthetic sphere of which the vertical stripes use different profiles (with different world scales)
+// The images should be zero and of the size (width, height)
+// The "sphereRadius" is in the NDC of the height (namely, the sphere covers "PI * sphereRadius^2 / (4 * aspect)" of the screen)
+void multiProfileScene(int width, int height, SSSProfileTable& profiles, float4x4& currProj, ImageRGBA32F& irradianceRT, ImageR32F& depthRT, ImageR8U& stencil, ImageRGBA32F& albedoRT, float sphereRadius = 0.70710678118654752440f);
+
+// The counterpart of the "Shaders/Support/SSS_Blur.hlsli" for a procedural flat plane
+struct SequenceConvergenceSource
+{
+	int sequence;
+	float2 pixelsPerUV;
+	// 0 means NOT rotated (see "subsurface_scattering_sample_rotation")
+	uint32_t frameIndex;
+
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const
+	{
+		// Point sampled 4x4 pixels cells of white noise, s.t. the neighborhood of each pixel is different (NOT periodic)
+		const uint32_t x = uint32_t(int(std::floor(uv.x * pixelsPerUV.x)) >> 2);
+		const uint32_t y = uint32_t(int(std::floor(uv.y * pixelsPerUV.y)) >> 2);
+		const float value = float(laine_karras_permutation(x * 0x9E3779B9U ^ y, 0x85EBCA6BU) >> 8U) * float(1.0 / 16777216.0);
+		return float3(value, value, value);
+	}
+
+	float3 total_diffuse_reflectance_post_scatter(float2) const
+	{
+		return float3(1.0f, 1.0f, 1.0f);
+	}
+
+	float subsurface_mask(float2) const
+	{
+		return 1.0f;
+	}
+
+	int subsurface_profile_index(float2) const
+	{
+		return 0;
+	}
+
+	float view_space_position_z(float2) const
+	{
+		return 1.0f;
+	}
+
+	float projection_x() const
+	{
+		return 1.0f;
+	}
+
+	float projection_y() const
+	{
+		return 1.0f;
+	}
+
+	float2 pixels_per_uv() const
+	{
+		return pixelsPerUV;
+	}
+
+	float diffusion_profile_sample_r(float d, float cdf) const
+	{
+		return ::diffusion_profile_sample_r(d, cdf);
+	}
+
+	float center_sample_cdf(float center_sample_cdf) const
+	{
+		return center_sample_cdf;
+	}
+
+	float2 sample_sequence(int sample_count, int sample_index) const
+	{
+		return subsurface_scattering_sample_sequence_offset(low_discrepancy_sequence_2d(sequence, uint32_t(sample_index), uint32_t(sample_count)), subsurface_scattering_sample_radius_offset(subsurface_scattering_sample_radius_offset_index(frameIndex)), sample_count);
+	}
+
+	float2 sample_rotation() const
+	{
+		return subsurface_scattering_sample_rotation(frameIndex);
+	}
+
+	// The plane is fully covered, s.t. the mask pyramid is NOT used
+	int mask_pyramid_level_count() const
+	{
+		return 0;
+	}
+
+	float4 mask_pyramid(int, int, int) const
+	{
+		return float4();
+	}
+
+	// The irradiance is procedural, s.t. the irradiance pyramid is NOT used
+	int irradiance_pyramid_level_count() const
+	{
+		return 0;
+	}
+
+	float4 irradiance_pyramid(int, int, int) const
+	{
+		return float4();
+	}
+
+	float irradiance_pyramid_view_space_position_z(int, int, int) const
+	{
+		return 0.0f;
+	}
+
+	float4 kernel_sample(float d, float center_sample_cdf, int sample_count, int sample_index) const
+	{
+		return subsurface_scattering_disney_kernel_sample(*this, d, center_sample_cdf, sample_count, sample_index);
+	}
+};
+
+// Each channel is blurred by the profile of which all channels are the channel, s.t. the samples are drawn from the exact profile of the channel
+// NOTE: the current estimator (SSS_MIS_MODE_NONE) reweights the center sample of all channels by the CDF of the widest channel, which is NOT the reference of the narrower channels
+std::vector<float3> perChannelReference(const SequenceConvergenceSource& source, const SSSProfile& profile, float worldScale, int pixelsPerSample, const std::vector<float2>& uvs);
+
+float3 rmsePerChannel(const std::vector<float3>& values, const std::vector<float3>& reference);
+
+// Set associative cache with the LRU replacement, s.t. the locality of the fetches of the blur is measured without the hardware counters
+class SimulatedCache
+{
+public:
+	SimulatedCache(int size, int wayCount, int lineSize) : m_wayCount(wayCount),
+		m_setCount(size / (wayCount * lineSize)),
+		m_lineSize(lineSize),
+		m_tags(static_cast<size_t>(size / lineSize), UINTPTR_MAX),
+		m_lastAccess(static_cast<size_t>(size / lineSize), 0U),
+		m_accessCount(0U),
+		m_missCount(0U)
+	{
+	}
+
+	// true if hit
+	bool access(const void* address)
+	{
+		const uintptr_t line = reinterpret_cast<uintptr_t>(address) / static_cast<uintptr_t>(m_lineSize);
+		const size_t setBegin = static_cast<size_t>(line % static_cast<uintptr_t>(m_setCount)) * static_cast<size_t>(m_wayCount);
+		++m_accessCount;
+
+		size_t victim = setBegin;
+		for (size_t way = setBegin; way < (setBegin + static_cast<size_t>(m_wayCount)); ++way)
+		{
+			if (m_tags[way] == line)
+			{
+				m_lastAccess[way] = m_accessCount;
+				return true;
+			}
+			victim = (m_lastAccess[way] < m_lastAccess[victim]) ? way : victim;
+		}
+
+		++m_missCount;
+		m_tags[victim] = line;
+		m_lastAccess[victim] = m_accessCount;
+		return false;
+	}
+
+	uint64_t getAccessCount() const { return m_accessCount; }
+	uint64_t getMissCount() const { return m_missCount; }
+
+private:
+	int m_wayCount;
+	int m_setCount;
+	int m_lineSize;
+	std::vector<uintptr_t> m_tags;
+	std::vector<uint64_t> m_lastAccess;
+	uint64_t m_accessCount;
+	uint64_t m_missCount;
+};
+
+// The counterpart of the "SSSBlurCPUSource" (the analytic inverse CDF, Hammersley, NOT rotated and without the kernel cache and the mask pyramid), of which the reference of the low resolution and the irradiance pyramid is blurred
+// The "total_diffuse_reflectance_post_scatter" is white, s.t. the blur outputs the blurred irradiance
+struct IrradiancePyramidBenchmarkSource
+{
+	const ImageRGBA32F& irradianceRT;
+	const ImageR32F& depthRT;
+	const ImageR8U& stencil;
+	const ImageRGBA32F& albedoRT;
+	const float4x4& currProj;
+	// NULL if the irradiance pyramid is disabled
+	const SSSIrradiancePyramid* irradiancePyramid;
+	// NULL if the fetches are NOT simulated
+	SimulatedCache* cache;
+
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const
+	{
+		const float* texel = irradianceRT.sampleLevelPoint(uv);
+		if (NULL != cache)
+		{
+			cache->access(texel);
+		}
+		return float3(texel[0], texel[1], texel[2]);
+	}
+
+	float3 total_diffuse_reflectance_post_scatter(float2) const
+	{
+		return float3(1.0f, 1.0f, 1.0f);
+	}
+
+	float subsurface_mask(float2 uv) const
+	{
+		return albedoRT.sampleLevelPoint(uv)[3];
+	}
+
+	int subsurface_profile_index(float2 uv) const
+	{
+		return subsurface_scattering_profile_index_from_stencil(stencil.sampleLevelPoint(uv)[0]);
+	}
+
+	float view_space_position_z(float2 uv) const
+	{
+		const float* texel = depthRT.sampleLevelPoint(uv);
+		if (NULL != cache)
+		{
+			cache->access(texel);
+		}
+		// ndcz_to_viewpositionz
+		return currProj.m[3][2] / (texel[0] - currProj.m[2][2]);
+	}
+
+	float projection_x() const
+	{
+		return currProj.m[0][0];
+	}
+
+	float projection_y() const
+	{
+		return currProj.m[1][1];
+	}
+
+	float2 pixels_per_uv() const
+	{
+		return float2(float(irradianceRT.getWidth()), float(irradianceRT.getHeight()));
+	}
+
+	float diffusion_profile_sample_r(float d, float cdf) const
+	{
+		return ::diffusion_profile_sample_r(d, cdf);
+	}
+
+	float center_sample_cdf(float center_sample_cdf) const
+	{
+		return center_sample_cdf;
+	}
+
+	float2 sample_sequence(int sample_count, int sample_index) const
+	{
+		return low_discrepancy_sequence_2d(LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY, uint32_t(sample_index), uint32_t(sample_count));
+	}
+
+	float2 sample_rotation() const
+	{
+		return float2(1.0f, 0.0f);
+	}
+
+	int mask_pyramid_level_count() const
+	{
+		return 0;
+	}
+
+	float4 mask_pyramid(int, int, int) const
+	{
+		return float4();
+	}
+
+	int irradiance_pyramid_level_count() const
+	{
+		return (NULL != irradiancePyramid) ? irradiancePyramid->getLevelCount() : 0;
+	}
+
+	float4 irradiance_pyramid(int level, int x, int y) const
+	{
+		const float* texel = irradiancePyramid->getIrradiance(level)(x, y);
+		if (NULL != cache)
+		{
+			cache->access(texel);
+		}
+		return float4(texel[0], texel[1], texel[2], texel[3]);
+	}
+
+	float irradiance_pyramid_view_space_position_z(int level, int x, int y) const
+	{
+		const float* texel = irradiancePyramid->getViewSpacePositionZ(level)(x, y);
+		if (NULL != cache)
+		{
+			cache->access(texel);
+		}
+		return texel[0];
+	}
+
+	float4 kernel_sample(float d, float center_sample_cdf, int sample_count, int sample_index) const
+	{
+		return subsurface_scattering_disney_kernel_sample(*this, d, center_sample_cdf, sample_count, sample_index);
+	}
+};
+
+// The counterpart of the "SSSBlurCPUSource" of which the inputs are swizzled (the analytic inverse CDF, Hammersley, NOT rotated and without the kernel cache and the pyramids)
+struct ImageLayoutBenchmarkSource
+{
+	const SwizzledImageRGBA32F& irradianceDepth;
+	const SwizzledImageRGBA32F& albedo;
+	const SwizzledImageR8U& stencil;
+	const float4x4& currProj;
+	SimulatedCache& l1Cache;
+	SimulatedCache& l2Cache;
+
+	void access(const void* texel) const
+	{
+		if (!l1Cache.access(texel))
+		{
+			l2Cache.access(texel);
+		}
+	}
+
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const
+	{
+		const float* texel = irradianceDepth.sampleLevelPoint(uv);
+		access(texel);
+		return float3(texel[0], texel[1], texel[2]);
+	}
+
+	float3 total_diffuse_reflectance_post_scatter(float2 uv) const
+	{
+		const float* texel = albedo.sampleLevelPoint(uv);
+		access(texel);
+		return float3(texel[0], texel[1], texel[2]);
+	}
+
+	float subsurface_mask(float2 uv) const
+	{
+		const float* texel = albedo.sampleLevelPoint(uv);
+		access(texel);
+		return texel[3];
+	}
+
+	int subsurface_profile_index(float2 uv) const
+	{
+		const uint8_t* texel = stencil.sampleLevelPoint(uv);
+		access(texel);
+		return subsurface_scattering_profile_index_from_stencil(texel[0]);
+	}
+
+	float view_space_position_z(float2 uv) const
+	{
+		const float* texel = irradianceDepth.sampleLevelPoint(uv);
+		access(texel);
+		// ndcz_to_viewpositionz
+		return currProj.m[3][2] / (texel[3] - currProj.m[2][2]);
+	}
+
+	float projection_x() const
+	{
+		return currProj.m[0][0];
+	}
+
+	float projection_y() const
+	{
+		return currProj.m[1][1];
+	}
+
+	float2 pixels_per_uv() const
+	{
+		return float2(float(irradianceDepth.getWidth()), float(irradianceDepth.getHeight()));
+	}
+
+	float diffusion_profile_sample_r(float d, float cdf) const
+	{
+		return ::diffusion_profile_sample_r(d, cdf);
+	}
+
+	float center_sample_cdf(float center_sample_cdf) const
+	{
+		return center_sample_cdf;
+	}
+
+	float2 sample_sequence(int sample_count, int sample_index) const
+	{
+		return low_discrepancy_sequence_2d(LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY, uint32_t(sample_index), uint32_t(sample_count));
+	}
+
+	float2 sample_rotation() const
+	{
+		return float2(1.0f, 0.0f);
+	}
+
+	int mask_pyramid_level_count() const
+	{
+		return 0;
+	}
+
+	float4 mask_pyramid(int, int, int) const
+	{
+		return float4();
+	}
+
+	int irradiance_pyramid_level_count() const
+	{
+		return 0;
+	}
+
+	float4 irradiance_pyramid(int, int, int) const
+	{
+		return float4();
+	}
+
+	float irradiance_pyramid_view_space_position_z(int, int, int) const
+	{
+		return 0.0f;
+	}
+
+	float4 kernel_sample(float d, float center_sample_cdf, int sample_count, int sample_index) const
+	{
+		return subsurface_scattering_disney_kernel_sample(*this, d, center_sample_cdf, sample_count, sample_index);
+	}
+};
+
+// The vertices of the UV sphere (the same layout as the head: POSITION, NORMAL, TEXCOORD and TANGENT)
+struct PreintegratedBenchmarkVertex
+{
+	float position[3];
+	float normal[3];
+	float texcoord[2];
+	float tangent[3];
+};
+
+// The texture coordinates of the normal of the UV sphere: u = (atan2(z, x) + PI) / (2 * PI), v = acos(y) / PI
+float2 preintegratedSphereTexcoord(float3 normal);
+
+// The UV sphere (the seam and the poles are duplicated, the same as the charts of the head)
+// NOTE: the mesh points into the "vertices" and the "indices"
+SSSCurvatureMesh preintegratedSphereMesh(float radius, std::vector<PreintegratedBenchmarkVertex>& vertices, std::vector<uint32_t>& indices);
+
+#endif
@@ -0,0 +1,149 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+IrradiancePyramidBenchmarkResult benchmarkIrradiancePyramid(int width, int height, int pixelStride, int repetitionCount)
+{
+	IrradiancePyramidBenchmarkResult result = {};
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+	const SSSProfileTable sceneProfiles(profiles);
+
+	SSSIrradiancePyramid irradiancePyramid;
+	irradiancePyramid.build(irradianceRT, depthRT, &stencil, albedoRT, currProj);
+
+	// The pixels (y * width + x) of the subsurface scattering in the raster order, of which one of every "pixelStride x pixelStride" pixels is evaluated against the reference
+	vector<int> pixels;
+	vector<size_t> strided;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			if (0U != stencil(x, y)[0])
+			{
+				if (((y % pixelStride) == (pixelStride / 2)) && ((x % pixelStride) == (pixelStride / 2)))
+				{
+					strided.push_back(pixels.size());
+				}
+				pixels.push_back(y * width + x);
+			}
+		}
+	}
+
+	SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+
+	for (int scaleIndex = 0; scaleIndex < IRRADIANCE_PYRAMID_BENCHMARK_WORLD_SCALE_COUNT; ++scaleIndex)
+	{
+		const float worldScaleFactor = 1.0f / float(1 << scaleIndex);
+		for (int profileIndex = 0; profileIndex < profiles.getCount(); ++profileIndex)
+		{
+			profiles.setWorldScale(profileIndex, sceneProfiles.getProfile(profileIndex).worldScale * worldScaleFactor);
+		}
+
+		// pixels_per_mm = pixels_per_uv * 0.5 * projection / view_space_position_z / (1000 * world_scale)
+		const SSSProfile& profile0 = profiles.getProfile(0);
+		const float centerViewSpacePositionZ = currProj.m[3][2] / (depthRT(width / 2, height / 2)[0] - currProj.m[2][2]);
+		result.worldScale[scaleIndex] = profile0.worldScale;
+		result.filterRadiusInPixels[scaleIndex] = profile0.filterRadius * float(height) * 0.5f * currProj.m[1][1] / centerViewSpacePositionZ / (1000.0f * profile0.worldScale);
+
+		auto estimate = [&](const IrradiancePyramidBenchmarkSource& source, int sampleBudget, int pixel) -> float3
+		{
+			const int x = pixel % width;
+			const int y = pixel / width;
+			const SSSProfile& profile = profiles.getProfile(subsurface_scattering_profile_index_from_stencil(stencil(x, y)[0]));
+			const float2 center_uv((float(x) + 0.5f) / float(width), (float(y) + 0.5f) / float(height));
+			return subsurface_scattering_disney_blur<SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT>(source, profile.scatteringDistance, profile.filterRadius, profile.worldScale, SSS_MIN_PIXELS_PER_SAMPLE, sampleBudget, SSS_MIS_MODE_NONE, center_uv);
+		};
+
+		vector<float3> reference(strided.size());
+		{
+			const IrradiancePyramidBenchmarkSource source = { irradianceRT, depthRT, stencil, albedoRT, currProj, NULL, NULL };
+			for (size_t i = 0; i < strided.size(); ++i)
+			{
+				reference[i] = estimate(source, SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT, pixels[strided[i]]);
+			}
+		}
+
+		// [0] without the irradiance pyramid, [1] with the irradiance pyramid
+		for (int pyramidIndex = 0; pyramidIndex < 2; ++pyramidIndex)
+		{
+			SimulatedCache cache(IRRADIANCE_PYRAMID_BENCHMARK_CACHE_SIZE, IRRADIANCE_PYRAMID_BENCHMARK_CACHE_WAY_COUNT, IRRADIANCE_PYRAMID_BENCHMARK_CACHE_LINE_SIZE);
+			const IrradiancePyramidBenchmarkSource source = { irradianceRT, depthRT, stencil, albedoRT, currProj, (0 != pyramidIndex) ? &irradiancePyramid : NULL, &cache };
+
+			vector<float3> radiance(pixels.size());
+			for (size_t i = 0; i < pixels.size(); ++i)
+			{
+				radiance[i] = estimate(source, SSS_MAX_SAMPLE_BUDGET, pixels[i]);
+			}
+			result.cacheMissesPerPixel[scaleIndex][pyramidIndex] = double(cache.getMissCount()) / double(std::max(size_t(1U), pixels.size()));
+
+			double sumSquaredError = 0.0;
+			for (size_t i = 0; i < strided.size(); ++i)
+			{
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					double error = double((&radiance[strided[i]].x)[channel]) - double((&reference[i].x)[channel]);
+					sumSquaredError += error * error;
+				}
+			}
+			result.rmse[scaleIndex][pyramidIndex] = std::sqrt(sumSquaredError / double(std::max(size_t(1U), 3U * strided.size())));
+
+			blur.setIrradiancePyramidEnabled(0 != pyramidIndex);
+			ImageRGBA32F mainRT(width, height);
+			double seconds = 0.0;
+			for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+			{
+				std::fill(mainRT.getData(), mainRT.getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+				chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+				blur.go(mainRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+				seconds += elapsedSeconds(begin);
+			}
+			result.millisecondsPerFrame[scaleIndex][pyramidIndex] = 1000.0 * seconds / double(std::max(1, repetitionCount));
+		}
+	}
+	blur.setIrradiancePyramidEnabled(false);
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const IrradiancePyramidBenchmarkResult& result)
+{
+	out << "Irradiance Pyramid (RMSE against " << SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT << " samples, simulated " << (IRRADIANCE_PYRAMID_BENCHMARK_CACHE_SIZE / 1024) << " KiB cache misses per pixel and cost per frame without / with the irradiance pyramid)" << endl;
+	for (int scaleIndex = 0; scaleIndex < IRRADIANCE_PYRAMID_BENCHMARK_WORLD_SCALE_COUNT; ++scaleIndex)
+	{
+		out << "  world scale " << std::fixed << setprecision(5) << result.worldScale[scaleIndex] << " (filter radius " << setprecision(0) << setw(4) << result.filterRadiusInPixels[scaleIndex] << " pixels): ";
+		out << "rmse " << std::scientific << setprecision(2) << result.rmse[scaleIndex][0] << " / " << result.rmse[scaleIndex][1];
+		out << std::fixed << setprecision(1) << ", misses " << setw(5) << result.cacheMissesPerPixel[scaleIndex][0] << " / " << setw(5) << result.cacheMissesPerPixel[scaleIndex][1];
+		out << setprecision(2) << ", " << setw(8) << result.millisecondsPerFrame[scaleIndex][0] << " ms / " << setw(8) << result.millisecondsPerFrame[scaleIndex][1] << " ms" << endl;
+	}
+	return out;
+}
@@ -0,0 +1,248 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <limits>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+LodBenchmarkResult benchmarkLodSelection(int width, int height, int repetitionCount)
+{
+	LodBenchmarkResult result = {};
+
+	const SSSProfileTable profiles;
+	const SSSProfile& profile = profiles.getProfile(0);
+	const float headRadius = LOD_BENCHMARK_HEAD_RADIUS;
+
+	// Projection (row major), the same as the "benchmarkPreintegratedLUT", and the camera at the origin (the view matrix is the identity)
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+	const float yScale = 1.0f / std::tan(0.5f * (20.0f * float(PI) / 180.0f));
+	float4x4 currProj = {};
+	currProj.m[0][0] = yScale * float(height) / float(width);
+	currProj.m[1][1] = yScale;
+	currProj.m[2][2] = farPlane / (farPlane - nearPlane);
+	currProj.m[2][3] = 1.0f;
+	currProj.m[3][2] = -nearPlane * farPlane / (farPlane - nearPlane);
+	float4x4 view = {};
+	view.m[0][0] = 1.0f;
+	view.m[1][1] = 1.0f;
+	view.m[2][2] = 1.0f;
+	view.m[3][3] = 1.0f;
+
+	// The heads side by side on the screen (from the left to the right), of which the distances are 4, 5, 6.25, ...
+	SSSLodBounds heads[LOD_BENCHMARK_HEAD_COUNT];
+	{
+		float previousRight = 0.0f;
+		for (int headIndex = 0; headIndex < LOD_BENCHMARK_HEAD_COUNT; ++headIndex)
+		{
+			const float centerZ = 4.0f * std::pow(1.25f, float(headIndex));
+			const float radiusInPixels = headRadius * yScale * (0.5f * float(height)) / centerZ;
+			const float centerX = previousRight + radiusInPixels + 2.0f;
+			previousRight = centerX + radiusInPixels;
+
+			heads[headIndex].center = float3((centerX / float(width) * 2.0f - 1.0f) * centerZ / currProj.m[0][0], 0.0f, centerZ);
+			heads[headIndex].radius = headRadius;
+		}
+	}
+
+	SSSLodSelector selector;
+	SSSLodSelection selections[LOD_BENCHMARK_HEAD_COUNT];
+	for (int repetitionIndex = 0; repetitionIndex <= repetitionCount; ++repetitionIndex)
+	{
+		// NOTE: the first frame is NOT timed, and the heads are static, s.t. the hysteresis does NOT change the tiers
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		selector.beginFrame(view, currProj, width, height);
+		for (int headIndex = 0; headIndex < LOD_BENCHMARK_HEAD_COUNT; ++headIndex)
+		{
+			selections[headIndex] = selector.select(headIndex, heads[headIndex], profile);
+		}
+		result.selectMicroseconds += (repetitionIndex > 0) ? (1000000.0 * elapsedSeconds(begin) / double(LOD_BENCHMARK_HEAD_COUNT * std::max(1, repetitionCount))) : 0.0;
+	}
+
+	result.passed = true;
+	for (int headIndex = 0; headIndex < LOD_BENCHMARK_HEAD_COUNT; ++headIndex)
+	{
+		result.tier[headIndex] = selections[headIndex].tier;
+		result.filterRadiusInPixels[headIndex] = selections[headIndex].filterRadiusInPixels;
+		result.passed = result.passed && ((0 == headIndex) || (result.tier[headIndex] >= result.tier[headIndex - 1]));
+	}
+	for (int tier = 0; tier < SSS_LOD_TIER_COUNT; ++tier)
+	{
+		result.headCount[tier] = selector.getHeadCount(tier);
+		result.estimatedPixelCount[tier] = selector.getPixelCount(tier);
+	}
+
+	// The ray cast of the heads: the stencil of the full budget and the stencil of the tiers
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U fullStencil(width, height);
+	ImageR8U lodStencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	vector<int> reducedPixels;
+	const float3 light = float3(1.0f, 0.25f, -0.5f) * (1.0f / std::sqrt(1.0f + 0.0625f + 0.25f));
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const float u = (float(x) + 0.5f) / float(width) * 2.0f - 1.0f;
+			const float v = (float(y) + 0.5f) / float(height) * 2.0f - 1.0f;
+			const float3 direction(u / currProj.m[0][0], v / currProj.m[1][1], 1.0f);
+
+			// The nearest head
+			int hitIndex = -1;
+			float hitT = std::numeric_limits<float>::max();
+			for (int headIndex = 0; headIndex < LOD_BENCHMARK_HEAD_COUNT; ++headIndex)
+			{
+				const float3 offset = heads[headIndex].center * -1.0f;
+				const float a = dot(direction, direction);
+				const float b = 2.0f * dot(direction, offset);
+				const float c = dot(offset, offset) - headRadius * headRadius;
+				const float discriminant = b * b - 4.0f * a * c;
+				if (discriminant < 0.0f)
+				{
+					continue;
+				}
+				const float t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+				if ((t > 0.0f) && (t < hitT))
+				{
+					hitT = t;
+					hitIndex = headIndex;
+				}
+			}
+			if (hitIndex < 0)
+			{
+				continue;
+			}
+
+			const float3 position = direction * hitT;
+			const float3 normal = (position - heads[hitIndex].center) * (1.0f / headRadius);
+			const int tier = selections[hitIndex].tier;
+			++result.pixelCount[tier];
+
+			depthRT(x, y)[0] = (currProj.m[2][2] * position.z + currProj.m[3][2]) / position.z;
+			fullStencil(x, y)[0] = subsurface_scattering_profile_stencil_ref(0);
+			// The same as the "mainPass": the PREINTEGRATED and the NONE tiers are NOT blurred
+			lodStencil(x, y)[0] = ((SSS_LOD_TIER_FULL == tier) || (SSS_LOD_TIER_REDUCED == tier)) ? subsurface_scattering_profile_stencil_ref(0, SSS_LOD_TIER_REDUCED == tier) : uint8_t(0U);
+			if (SSS_LOD_TIER_REDUCED == tier)
+			{
+				reducedPixels.push_back(y * width + x);
+			}
+
+			float* albedo = albedoRT(x, y);
+			albedo[0] = 1.0f;
+			albedo[1] = 1.0f;
+			albedo[2] = 1.0f;
+			albedo[3] = 1.0f;
+
+			const float ndotl = saturate(dot(normal, light));
+			float* irradiance = irradianceRT(x, y);
+			irradiance[0] = ndotl;
+			irradiance[1] = ndotl;
+			irradiance[2] = ndotl;
+		}
+	}
+
+	uint64_t sumEstimatedPixelCount = 0U;
+	uint64_t sumPixelCount = 0U;
+	for (int tier = 0; tier < SSS_LOD_TIER_COUNT; ++tier)
+	{
+		sumEstimatedPixelCount += result.estimatedPixelCount[tier];
+		sumPixelCount += result.pixelCount[tier];
+	}
+	result.passed = result.passed && (sumPixelCount > 0U) && (std::abs(double(sumEstimatedPixelCount) / double(sumPixelCount) - 1.0) <= 0.25);
+
+	// The warm-up (NOT timed) and the mean of the "repetitionCount"
+	ImageRGBA32F fullRT(width, height);
+	ImageRGBA32F lodRT(width, height);
+	auto timedGo = [&](ImageRGBA32F& targetRT, const ImageR8U& stencil, uint64_t& sampleCount) -> double
+	{
+		SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+		blur.go(targetRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+		sampleCount = blur.getSampleCount();
+
+		double seconds = 0.0;
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			std::fill(targetRT.getData(), targetRT.getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			blur.go(targetRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+			seconds += elapsedSeconds(begin);
+		}
+		return 1000.0 * seconds / double(std::max(1, repetitionCount));
+	};
+	result.fullMilliseconds = timedGo(fullRT, fullStencil, result.fullSampleCount);
+	result.lodMilliseconds = timedGo(lodRT, lodStencil, result.lodSampleCount);
+	result.passed = result.passed && (result.lodSampleCount < result.fullSampleCount);
+
+	double sumSquaredError = 0.0;
+	for (const int pixel : reducedPixels)
+	{
+		const float* value = lodRT(pixel % width, pixel / width);
+		const float* target = fullRT(pixel % width, pixel / width);
+		const double error = 0.2126 * double(value[0] - target[0]) + 0.7152 * double(value[1] - target[1]) + 0.0722 * double(value[2] - target[2]);
+		sumSquaredError += error * error;
+	}
+	result.reducedRmse = std::sqrt(sumSquaredError / double(std::max<size_t>(1U, reducedPixels.size())));
+
+	// The distance of the threshold between the FULL and the REDUCED tiers (at the center of the screen)
+	const float thresholdZ = profile.filterRadius * (0.5f * float(height) * yScale / (1000.0f * profile.worldScale)) / SSS_LOD_DEFAULT_FULL_FILTER_RADIUS_IN_PIXELS;
+	for (int hysteresisIndex = 0; hysteresisIndex < 2; ++hysteresisIndex)
+	{
+		SSSLodSelector oscillatingSelector;
+		oscillatingSelector.setHysteresis((0 != hysteresisIndex) ? SSS_LOD_DEFAULT_HYSTERESIS : 0.0f);
+		for (int frameIndex = 0; frameIndex < LOD_BENCHMARK_HYSTERESIS_FRAME_COUNT; ++frameIndex)
+		{
+			SSSLodBounds bounds;
+			bounds.center = float3(0.0f, 0.0f, thresholdZ * (1.0f + 0.1f * std::sin(float(2.0 * PI) * float(frameIndex) / 16.0f + 0.5f)));
+			bounds.radius = headRadius;
+
+			oscillatingSelector.beginFrame(view, currProj, width, height);
+			oscillatingSelector.select(0, bounds, profile);
+			result.transitionCount[hysteresisIndex] += oscillatingSelector.getTransitionCount();
+		}
+	}
+	result.passed = result.passed && (result.transitionCount[1] <= 1) && (result.transitionCount[0] > result.transitionCount[1]);
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const LodBenchmarkResult& result)
+{
+	out << "LOD Selection (" << LOD_BENCHMARK_HEAD_COUNT << " heads, " << std::fixed << setprecision(3) << result.selectMicroseconds << " us per head)" << endl;
+	out << setprecision(1) << "  filter radius (pixels) / tier:";
+	for (int headIndex = 0; headIndex < LOD_BENCHMARK_HEAD_COUNT; ++headIndex)
+	{
+		out << " " << result.filterRadiusInPixels[headIndex] << "/" << subsurface_scattering_lod_tier_name(result.tier[headIndex])[0];
+	}
+	out << endl;
+	for (int tier = 0; tier < SSS_LOD_TIER_COUNT; ++tier)
+	{
+		out << "  " << setw(14) << subsurface_scattering_lod_tier_name(tier) << ": " << setw(2) << result.headCount[tier] << " heads, " << setw(7) << result.estimatedPixelCount[tier] << " estimated pixels, " << setw(7) << result.pixelCount[tier] << " pixels" << endl;
+	}
+	out << setprecision(2) << "  blur: full " << setw(10) << result.fullSampleCount << " samples " << setw(8) << result.fullMilliseconds << " ms, LOD " << setw(10) << result.lodSampleCount << " samples " << setw(8) << result.lodMilliseconds << " ms (x" << (result.fullMilliseconds / result.lodMilliseconds) << "), ";
+	out << std::scientific << "rmse of the reduced tier " << result.reducedRmse << std::fixed << endl;
+	out << "  transitions of the oscillating head (" << LOD_BENCHMARK_HYSTERESIS_FRAME_COUNT << " frames): without the hysteresis " << result.transitionCount[0] << ", with " << result.transitionCount[1] << endl;
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	return out;
+}
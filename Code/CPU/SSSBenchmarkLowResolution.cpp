@@ -0,0 +1,180 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+#include "subsurface_scattering_texturing_mode.h"
+
+using namespace std;
+
+// Portable Float Map (grayscale, little endian, the rows from the bottom to the top)
+static bool writePFM(const string& path, const ImageR32F& image)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (NULL == file)
+	{
+		return false;
+	}
+
+	fprintf(file, "Pf\n%d %d\n-1.0\n", image.getWidth(), image.getHeight());
+	for (int y = image.getHeight() - 1; y >= 0; --y)
+	{
+		fwrite(image(0, y), sizeof(float), static_cast<size_t>(image.getWidth()), file);
+	}
+
+	fclose(file);
+	return true;
+}
+
+LowResolutionBenchmarkResult benchmarkLowResolution(int width, int height, int pixelStride, int repetitionCount, const char* errorMapPathPrefix)
+{
+	LowResolutionBenchmarkResult result = {};
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+
+	// The pixels of which the neighborhood contains another stencil (the silhouette and the profile boundaries)
+	ImageR8U edge(width, height);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			for (int neighborY = std::max(y - LOW_RESOLUTION_BENCHMARK_EDGE_RADIUS, 0); neighborY <= std::min(y + LOW_RESOLUTION_BENCHMARK_EDGE_RADIUS, height - 1); ++neighborY)
+			{
+				for (int neighborX = std::max(x - LOW_RESOLUTION_BENCHMARK_EDGE_RADIUS, 0); neighborX <= std::min(x + LOW_RESOLUTION_BENCHMARK_EDGE_RADIUS, width - 1); ++neighborX)
+				{
+					edge(x, y)[0] |= (stencil(neighborX, neighborY)[0] != stencil(x, y)[0]) ? uint8_t(1U) : uint8_t(0U);
+				}
+			}
+		}
+	}
+
+	// The reference (SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT samples) at one of every "pixelStride x pixelStride" pixels of the subsurface scattering
+	// NOTE: the pre-scatter texturing mode multiplies the blurred irradiance by the "sqrt(albedo)" of the center
+	vector<int> strided;
+	vector<float3> reference;
+	{
+		const IrradiancePyramidBenchmarkSource source = { irradianceRT, depthRT, stencil, albedoRT, currProj, NULL, NULL };
+		for (int y = pixelStride / 2; y < height; y += pixelStride)
+		{
+			for (int x = pixelStride / 2; x < width; x += pixelStride)
+			{
+				if (0U == stencil(x, y)[0])
+				{
+					continue;
+				}
+
+				const SSSProfile& profile = profiles.getProfile(subsurface_scattering_profile_index_from_stencil(stencil(x, y)[0]));
+				const float2 center_uv((float(x) + 0.5f) / float(width), (float(y) + 0.5f) / float(height));
+				const float3 blurred = subsurface_scattering_disney_blur<SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT>(source, profile.scatteringDistance, profile.filterRadius, profile.worldScale, SSS_MIN_PIXELS_PER_SAMPLE, SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT, SSS_MIS_MODE_NONE, center_uv);
+				const float* albedo = albedoRT(x, y);
+				strided.push_back(y * width + x);
+				reference.push_back(blurred * subsurface_scattering_total_diffuse_reflectance_post_scatter_from_albedo(false, float3(albedo[0], albedo[1], albedo[2])));
+			}
+		}
+	}
+
+	SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE);
+
+	for (int factorIndex = 0; factorIndex < LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT; ++factorIndex)
+	{
+		const int resolutionFactor = (1 << factorIndex);
+		result.resolutionFactor[factorIndex] = resolutionFactor;
+		blur.setResolutionFactor(resolutionFactor);
+
+		ImageRGBA32F mainRT(width, height);
+		double seconds = 0.0;
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			std::fill(mainRT.getData(), mainRT.getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			blur.go(mainRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+			seconds += elapsedSeconds(begin);
+		}
+		result.millisecondsPerFrame[factorIndex] = 1000.0 * seconds / double(std::max(1, repetitionCount));
+
+		// The error map: the maximum (of all channels) absolute error
+		ImageR32F errorMap(width, height);
+		double sumSquaredError[2] = { 0.0, 0.0 };
+		int pixelCount[2] = { 0, 0 };
+		int aboveThresholdCount = 0;
+		for (size_t i = 0; i < strided.size(); ++i)
+		{
+			const int x = strided[i] % width;
+			const int y = strided[i] / width;
+
+			float error = 0.0f;
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				error = std::max(error, std::abs(mainRT(x, y)[channel] - (&reference[i].x)[channel]));
+			}
+			errorMap(x, y)[0] = error;
+
+			const int region = (0U != edge(x, y)[0]) ? 1 : 0;
+			sumSquaredError[region] += double(error) * double(error);
+			++pixelCount[region];
+			aboveThresholdCount += (error > (1.0f / 255.0f)) ? 1 : 0;
+			result.maxAbsoluteError[factorIndex] = std::max(result.maxAbsoluteError[factorIndex], double(error));
+		}
+		result.interiorRmse[factorIndex] = std::sqrt(sumSquaredError[0] / double(std::max(1, pixelCount[0])));
+		result.edgeRmse[factorIndex] = std::sqrt(sumSquaredError[1] / double(std::max(1, pixelCount[1])));
+		result.rmse[factorIndex] = std::sqrt((sumSquaredError[0] + sumSquaredError[1]) / double(std::max(1, pixelCount[0] + pixelCount[1])));
+		result.aboveThresholdRatio[factorIndex] = double(aboveThresholdCount) / double(std::max(1, pixelCount[0] + pixelCount[1]));
+
+		// The sampling noise (of the full resolution) and the error of the low resolution are assumed to be uncorrelated
+		result.interiorResolutionRmse[factorIndex] = std::sqrt(std::max(0.0, result.interiorRmse[factorIndex] * result.interiorRmse[factorIndex] - result.interiorRmse[0] * result.interiorRmse[0]));
+		result.edgeResolutionRmse[factorIndex] = std::sqrt(std::max(0.0, result.edgeRmse[factorIndex] * result.edgeRmse[factorIndex] - result.edgeRmse[0] * result.edgeRmse[0]));
+
+		if ((NULL != errorMapPathPrefix) && (SSS_RESOLUTION_FACTOR_FULL != resolutionFactor))
+		{
+			writePFM(string(errorMapPathPrefix) + "_x" + to_string(resolutionFactor) + ".pfm", errorMap);
+		}
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const LowResolutionBenchmarkResult& result)
+{
+	out << "Low Resolution (error against " << SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT << " samples, the sampling noise is the error of the full resolution, cost per frame)" << endl;
+	for (int factorIndex = 0; factorIndex < LOW_RESOLUTION_BENCHMARK_FACTOR_COUNT; ++factorIndex)
+	{
+		out << "  1/" << result.resolutionFactor[factorIndex] << ": " << std::fixed << setprecision(2) << setw(8) << result.millisecondsPerFrame[factorIndex] << " ms";
+		out << " (x" << setprecision(2) << (result.millisecondsPerFrame[0] / result.millisecondsPerFrame[factorIndex]) << ")";
+		out << std::scientific << setprecision(2) << ", rmse " << result.rmse[factorIndex] << " (interior " << result.interiorRmse[factorIndex] << ", edge " << result.edgeRmse[factorIndex] << ")";
+		if (0 != factorIndex)
+		{
+			out << ", beyond the noise: interior " << result.interiorResolutionRmse[factorIndex] << ", edge " << result.edgeResolutionRmse[factorIndex];
+		}
+		out << ", max " << result.maxAbsoluteError[factorIndex];
+		out << std::fixed << setprecision(2) << ", > 1/255: " << (100.0 * result.aboveThresholdRatio[factorIndex]) << "%" << endl;
+	}
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,111 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <limits>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+MaskPyramidBenchmarkResult benchmarkMaskPyramid(int width, int height, int repetitionCount)
+{
+	MaskPyramidBenchmarkResult result = {};
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+
+	// NOTE: the tile classification is disabled, s.t. every sample beyond the center is tested by the mask pyramid or the full resolution
+	SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+	blur.setTileClassificationEnabled(false);
+
+	const int sampleBudget[MASK_PYRAMID_BENCHMARK_BUDGET_COUNT] = { 16, 40, SSS_MAX_SAMPLE_BUDGET };
+
+	result.passed = true;
+	for (int budgetIndex = 0; budgetIndex < MASK_PYRAMID_BENCHMARK_BUDGET_COUNT; ++budgetIndex)
+	{
+		result.sampleBudget[budgetIndex] = sampleBudget[budgetIndex];
+		blur.setNSamples(sampleBudget[budgetIndex]);
+
+		// [0] without the mask pyramid, [1] with the mask pyramid
+		// The repetitions of the two paths are interleaved and the fastest repetition of each path is reported (the same as the "benchmarkTileClassification")
+		ImageRGBA32F mainRT[2] = { ImageRGBA32F(width, height), ImageRGBA32F(width, height) };
+		double minSeconds[2] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+		for (int repetitionIndex = 0; repetitionIndex < std::max(1, repetitionCount); ++repetitionIndex)
+		{
+			for (int pyramidIndex = 0; pyramidIndex < 2; ++pyramidIndex)
+			{
+				blur.setMaskPyramidEnabled(0 != pyramidIndex);
+
+				std::fill(mainRT[pyramidIndex].getData(), mainRT[pyramidIndex].getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+				chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+				blur.go(mainRT[pyramidIndex], irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+				minSeconds[pyramidIndex] = std::min(minSeconds[pyramidIndex], elapsedSeconds(begin));
+				result.wastedSampleCount[budgetIndex][pyramidIndex] = blur.getWastedSampleCount();
+
+				result.passed = result.passed && ((0 == pyramidIndex) || ((result.sampleCount[budgetIndex] == blur.getSampleCount()) && (result.rejectedSampleCount[budgetIndex] == blur.getRejectedSampleCount())));
+				result.sampleCount[budgetIndex] = blur.getSampleCount();
+				result.rejectedSampleCount[budgetIndex] = blur.getRejectedSampleCount();
+			}
+		}
+		result.millisecondsPerFrame[budgetIndex][0] = 1000.0 * minSeconds[0];
+		result.millisecondsPerFrame[budgetIndex][1] = 1000.0 * minSeconds[1];
+		result.regression[budgetIndex] = (result.millisecondsPerFrame[budgetIndex][1] > result.millisecondsPerFrame[budgetIndex][0]);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				for (int channel = 0; channel < 4; ++channel)
+				{
+					result.maxAbsoluteError[budgetIndex] = std::max(result.maxAbsoluteError[budgetIndex], double(std::abs(mainRT[1](x, y)[channel] - mainRT[0](x, y)[channel])));
+				}
+			}
+		}
+
+		result.passed = result.passed && (result.maxAbsoluteError[budgetIndex] == 0.0) && !result.regression[budgetIndex];
+	}
+	blur.setMaskPyramidEnabled(true);
+	blur.setTileClassificationEnabled(true);
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const MaskPyramidBenchmarkResult& result)
+{
+	out << "Mask Pyramid (cost per frame and wasted samples without / with the mask pyramid)" << endl;
+	for (int budgetIndex = 0; budgetIndex < MASK_PYRAMID_BENCHMARK_BUDGET_COUNT; ++budgetIndex)
+	{
+		out << "  " << setw(2) << result.sampleBudget[budgetIndex] << " samples: ";
+		out << std::fixed << setprecision(2) << setw(8) << result.millisecondsPerFrame[budgetIndex][0] << " ms / " << setw(8) << result.millisecondsPerFrame[budgetIndex][1] << " ms";
+		out << ", " << result.rejectedSampleCount[budgetIndex] << " of " << result.sampleCount[budgetIndex] << " samples rejected";
+		out << ", wasted " << result.wastedSampleCount[budgetIndex][0] << " / " << result.wastedSampleCount[budgetIndex][1];
+		out << std::scientific << setprecision(2) << ", max error " << result.maxAbsoluteError[budgetIndex];
+		out << (result.regression[budgetIndex] ? " REGRESSION (slower with the mask pyramid)" : "") << endl;
+	}
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,99 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+MisVarianceResult benchmarkMisVariance(int width, int height, int pixelStride)
+{
+	MisVarianceResult result = {};
+
+	const SSSProfileTable profiles;
+	const SSSProfile& profile = profiles.getProfile(0);
+
+	// The same setup as the "benchmarkSequenceConvergence"
+	const float pixelsPerMm = 96.0f / profile.filterRadius;
+	const float worldScale = 0.5f * float(std::max(width, height)) / (1000.0f * pixelsPerMm);
+	const float2 pixelsPerUV(float(std::max(width, height)), float(std::max(width, height)));
+	const int pixelsPerSample = SSS_MIN_PIXELS_PER_SAMPLE;
+	const SequenceConvergenceSource source = { LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY, pixelsPerUV, 0U };
+
+	vector<float2> uvs;
+	for (int y = pixelStride / 2; y < height; y += pixelStride)
+	{
+		for (int x = pixelStride / 2; x < width; x += pixelStride)
+		{
+			uvs.push_back(float2((float(x) + 0.5f) / pixelsPerUV.x, (float(y) + 0.5f) / pixelsPerUV.y));
+		}
+	}
+
+	const vector<float3> reference = perChannelReference(source, profile, worldScale, pixelsPerSample, uvs);
+
+	for (int misMode = 0; misMode < MIS_VARIANCE_MODE_COUNT; ++misMode)
+	{
+		for (int budgetIndex = 0; budgetIndex < MIS_VARIANCE_BUDGET_COUNT; ++budgetIndex)
+		{
+			const int sampleBudget = 8 << budgetIndex;
+			result.sampleBudget[budgetIndex] = sampleBudget;
+
+			vector<float3> radiance(uvs.size());
+			for (size_t i = 0; i < uvs.size(); ++i)
+			{
+				radiance[i] = subsurface_scattering_disney_blur(source, profile.scatteringDistance, profile.filterRadius, worldScale, pixelsPerSample, sampleBudget, misMode, uvs[i]);
+			}
+			result.rmse[misMode][budgetIndex] = rmsePerChannel(radiance, reference);
+		}
+	}
+
+	result.passed = true;
+	for (int budgetIndex = 0; budgetIndex < MIS_VARIANCE_BUDGET_COUNT; ++budgetIndex)
+	{
+		const float3& noneRmse = result.rmse[SSS_MIS_MODE_NONE][budgetIndex];
+		for (int misMode = 0; misMode < MIS_VARIANCE_MODE_COUNT; ++misMode)
+		{
+			const float3& rmse = result.rmse[misMode][budgetIndex];
+			result.passed = result.passed && ((rmse.x + rmse.y + rmse.z) <= (noneRmse.x + noneRmse.y + noneRmse.z));
+		}
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const MisVarianceResult& result)
+{
+	static const char* const misModeNames[MIS_VARIANCE_MODE_COUNT] = { "none   ", "balance", "power  " };
+
+	out << "MIS Variance (RMSE per channel against " << SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT << " samples)" << endl;
+	out << std::scientific << setprecision(2);
+	for (int budgetIndex = 0; budgetIndex < MIS_VARIANCE_BUDGET_COUNT; ++budgetIndex)
+	{
+		out << "  budget " << setw(2) << result.sampleBudget[budgetIndex] << endl;
+		for (int misMode = 0; misMode < MIS_VARIANCE_MODE_COUNT; ++misMode)
+		{
+			const float3& rmse = result.rmse[misMode][budgetIndex];
+			out << "    " << misModeNames[misMode] << " r " << rmse.x << ", g " << rmse.y << ", b " << rmse.z << endl;
+		}
+	}
+	out << "  " << (result.passed ? "PASSED" : "FAILED (the MIS is noisier than the widest channel)") << endl;
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,102 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+MultiProfileVerificationResult verifyMultiProfile(int width, int height)
+{
+	MultiProfileVerificationResult result = {};
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+
+	SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE);
+
+	ImageRGBA32F mixedRT(width, height);
+	blur.go(mixedRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+
+	result.passed = true;
+	for (int profileIndex = 0; profileIndex < MULTI_PROFILE_VERIFICATION_PROFILE_COUNT; ++profileIndex)
+	{
+		// Only the pixels of this profile, which is the profile 0 of its own table
+		const SSSProfile& profile = profiles.getProfile(profileIndex);
+		SSSProfileTable singleProfile;
+		singleProfile.setScatteringDistance(0, profile.scatteringDistance);
+		singleProfile.setTransmittanceTint(0, profile.transmittanceTint);
+		singleProfile.setWorldScale(0, profile.worldScale);
+
+		// The other materials are NOT rendered: neither the stencil nor the subsurface mask
+		ImageR8U singleStencil(width, height);
+		ImageRGBA32F singleAlbedoRT(albedoRT);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const bool inside = (subsurface_scattering_profile_stencil_ref(profileIndex) == stencil(x, y)[0]);
+				singleStencil(x, y)[0] = inside ? subsurface_scattering_profile_stencil_ref(0) : uint8_t(0U);
+				if (!inside)
+				{
+					singleAlbedoRT(x, y)[3] = 0.0f;
+				}
+			}
+		}
+
+		ImageRGBA32F singleRT(width, height);
+		blur.go(singleRT, irradianceRT, depthRT, &singleStencil, singleAlbedoRT, currProj, singleProfile);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				if (0U != singleStencil(x, y)[0])
+				{
+					++result.pixelCount[profileIndex];
+					for (int channel = 0; channel < 3; ++channel)
+					{
+						result.maxAbsoluteError[profileIndex] = std::max(result.maxAbsoluteError[profileIndex], double(std::abs(mixedRT(x, y)[channel] - singleRT(x, y)[channel])));
+					}
+				}
+			}
+		}
+
+		result.passed = result.passed && (result.pixelCount[profileIndex] > 0) && (result.maxAbsoluteError[profileIndex] == 0.0);
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const MultiProfileVerificationResult& result)
+{
+	out << "Multi-Profile (" << (result.passed ? "passed" : "FAILED") << ")" << endl;
+	for (int profileIndex = 0; profileIndex < MULTI_PROFILE_VERIFICATION_PROFILE_COUNT; ++profileIndex)
+	{
+		out << "  profile " << profileIndex << ": " << result.pixelCount[profileIndex] << " pixels";
+		out << std::scientific << setprecision(2) << ", max error " << result.maxAbsoluteError[profileIndex] << " (absolute)" << endl;
+	}
+	out << std::fixed;
+	return out;
+}
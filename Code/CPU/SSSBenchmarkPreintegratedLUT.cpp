@@ -0,0 +1,231 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+#include "SSSPreintegratedLUT.h"
+#include "SSSCurvatureMap.h"
+
+using namespace std;
+
+PreintegratedLUTBenchmarkResult benchmarkPreintegratedLUT(int width, int height, int repetitionCount)
+{
+	PreintegratedLUTBenchmarkResult result = {};
+	result.hardwareConcurrency = static_cast<int>(std::thread::hardware_concurrency());
+
+	const SSSProfileTable profiles;
+	const SSSProfile& profile = profiles.getProfile(0);
+	const float sphereRadius = PREINTEGRATED_LUT_BENCHMARK_SPHERE_RADIUS;
+
+	vector<PreintegratedBenchmarkVertex> vertices;
+	vector<uint32_t> indices;
+	const SSSCurvatureMesh mesh = preintegratedSphereMesh(sphereRadius, vertices, indices);
+
+	// The bakers: one thread is the reference of the other thread counts
+	SSSPreintegratedLUT lut(SSS_PREINTEGRATED_LUT_DEFAULT_SIZE, 1);
+	lut.update(profiles);
+	SSSCurvatureMap curvatureMap(SSS_CURVATURE_MAP_DEFAULT_SIZE, 1);
+	curvatureMap.bake(&mesh, 1);
+
+	result.deterministic = true;
+	for (int threadCountIndex = 0; threadCountIndex < PREINTEGRATED_LUT_BENCHMARK_THREAD_COUNT_COUNT; ++threadCountIndex)
+	{
+		const int threadCount = 1 << threadCountIndex;
+		result.threadCount[threadCountIndex] = threadCount;
+
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			// NOTE: the table is only rebuilt when the profiles change, s.t. a new table is baked each time
+			SSSPreintegratedLUT timedLUT(SSS_PREINTEGRATED_LUT_DEFAULT_SIZE, threadCount);
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			timedLUT.update(profiles);
+			result.lutBakeMilliseconds[threadCountIndex] += 1000.0 * elapsedSeconds(begin) / double(std::max(1, repetitionCount));
+
+			SSSCurvatureMap timedCurvatureMap(SSS_CURVATURE_MAP_DEFAULT_SIZE, threadCount);
+			begin = chrono::steady_clock::now();
+			timedCurvatureMap.bake(&mesh, 1);
+			result.curvatureMapBakeMilliseconds[threadCountIndex] += 1000.0 * elapsedSeconds(begin) / double(std::max(1, repetitionCount));
+
+			const size_t lutFloatCount = static_cast<size_t>(lut.getProfileCount()) * static_cast<size_t>(lut.getSize()) * static_cast<size_t>(lut.getSize()) * 4U;
+			const size_t mapFloatCount = static_cast<size_t>(curvatureMap.getSize()) * static_cast<size_t>(curvatureMap.getSize());
+			result.deterministic = result.deterministic && std::equal(&lut.getData()->x, &lut.getData()->x + lutFloatCount, &timedLUT.getData()->x);
+			result.deterministic = result.deterministic && std::equal(curvatureMap.getData(), curvatureMap.getData() + mapFloatCount, timedCurvatureMap.getData());
+		}
+	}
+
+	// The exact curvature of the sphere is "1 / radius"
+	const float exactCurvature = 1.0f / sphereRadius;
+	for (float curvature : curvatureMap.getVertexCurvature())
+	{
+		result.maxVertexCurvatureError = std::max(result.maxVertexCurvatureError, std::abs(double(curvature) / double(exactCurvature) - 1.0));
+	}
+	result.coveredTexelCount = curvatureMap.getCoveredTexelCount();
+	for (int y = 0; y < curvatureMap.getSize(); ++y)
+	{
+		for (int x = 0; x < curvatureMap.getSize(); ++x)
+		{
+			const float curvature = curvatureMap.getData()[static_cast<size_t>(y) * static_cast<size_t>(curvatureMap.getSize()) + static_cast<size_t>(x)];
+			result.maxMapCurvatureError = std::max(result.maxMapCurvatureError, std::abs(double(curvature) / double(exactCurvature) - 1.0));
+		}
+	}
+
+	// Projection (row major, SV_POSITION.z = (proj[2][2] * z + proj[3][2]) / z), the same as the "multiProfileScene"
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+	const float yScale = 1.0f / std::tan(0.5f * (20.0f * float(PI) / 180.0f));
+	float4x4 currProj = {};
+	currProj.m[0][0] = yScale * float(height) / float(width);
+	currProj.m[1][1] = yScale;
+	currProj.m[2][2] = farPlane / (farPlane - nearPlane);
+	currProj.m[2][3] = 1.0f;
+	currProj.m[3][2] = -nearPlane * farPlane / (farPlane - nearPlane);
+
+	// The directional light (in the view space) of which the terminator is visible
+	const float3 light = float3(1.0f, 0.25f, -0.5f) * (1.0f / std::sqrt(1.0f + 0.0625f + 0.25f));
+
+	result.passed = result.deterministic && (result.maxVertexCurvatureError < 1.0e-3) && (result.maxMapCurvatureError < 1.0e-3);
+
+	for (int distanceIndex = 0; distanceIndex < PREINTEGRATED_LUT_BENCHMARK_DISTANCE_COUNT; ++distanceIndex)
+	{
+		// 128, 64, 32 and 16
+		const int radiusInPixels = 128 >> distanceIndex;
+		result.radiusInPixels[distanceIndex] = radiusInPixels;
+		const float centerZ = sphereRadius * yScale * (0.5f * float(height)) / float(radiusInPixels);
+
+		ImageRGBA32F irradianceRT(width, height);
+		ImageR32F depthRT(width, height);
+		ImageR8U stencil(width, height);
+		ImageRGBA32F albedoRT(width, height);
+
+		// (N.L, texcoord) of the covered pixels (y * width + x), in the order of the pixels
+		vector<int> pixels;
+		vector<float> ndotls;
+		vector<float2> texcoords;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				// The primary ray through the pixel (the view space, the camera at the origin)
+				const float u = (float(x) + 0.5f) / float(width) * 2.0f - 1.0f;
+				const float v = (float(y) + 0.5f) / float(height) * 2.0f - 1.0f;
+				const float3 direction(u / currProj.m[0][0], v / currProj.m[1][1], 1.0f);
+
+				// |t * direction - center|^2 = radius^2
+				const float a = dot(direction, direction);
+				const float b = -2.0f * direction.z * centerZ;
+				const float c = centerZ * centerZ - sphereRadius * sphereRadius;
+				const float discriminant = b * b - 4.0f * a * c;
+				if (discriminant < 0.0f)
+				{
+					continue;
+				}
+
+				const float t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+				const float3 position = direction * t;
+				const float3 normal = (position - float3(0.0f, 0.0f, centerZ)) * (1.0f / sphereRadius);
+				const float ndotl = dot(normal, light);
+
+				depthRT(x, y)[0] = (currProj.m[2][2] * position.z + currProj.m[3][2]) / position.z;
+				stencil(x, y)[0] = subsurface_scattering_profile_stencil_ref(0);
+
+				// The white albedo, s.t. the blur outputs the blurred irradiance (both the pre-scatter and the post-scatter are 1)
+				float* albedo = albedoRT(x, y);
+				albedo[0] = 1.0f;
+				albedo[1] = 1.0f;
+				albedo[2] = 1.0f;
+				albedo[3] = 1.0f;
+
+				float* irradiance = irradianceRT(x, y);
+				irradiance[0] = saturate(ndotl);
+				irradiance[1] = saturate(ndotl);
+				irradiance[2] = saturate(ndotl);
+
+				pixels.push_back(y * width + x);
+				ndotls.push_back(ndotl);
+				texcoords.push_back(preintegratedSphereTexcoord(normal));
+			}
+		}
+		const int pixelCount = static_cast<int>(pixels.size());
+		result.pixelCount[distanceIndex] = pixelCount;
+
+		SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+		ImageRGBA32F blurredRT(width, height);
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			std::fill(blurredRT.getData(), blurredRT.getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			blur.go(blurredRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+			result.blurMilliseconds[distanceIndex] += 1000.0 * elapsedSeconds(begin) / double(std::max(1, repetitionCount));
+		}
+
+		// The same as the "RenderPS": the curvature map is sampled by the texture coordinates
+		vector<float3> shaded(pixelCount);
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			for (int i = 0; i < pixelCount; ++i)
+			{
+				const float curvatureInMm = subsurface_scattering_curvature_in_mm(curvatureMap.sample(texcoords[i]), profile.worldScale);
+				shaded[i] = lut.evaluate(profiles, 0, ndotls[i], curvatureInMm);
+			}
+			result.lutMilliseconds[distanceIndex] += 1000.0 * elapsedSeconds(begin) / double(std::max(1, repetitionCount));
+		}
+
+		double sumSquaredError[2] = { 0.0, 0.0 };
+		for (int i = 0; i < pixelCount; ++i)
+		{
+			const float* blurred = blurredRT(pixels[i] % width, pixels[i] / width);
+			const double target = 0.2126 * double(blurred[0]) + 0.7152 * double(blurred[1]) + 0.0722 * double(blurred[2]);
+			const double lambertError = double(saturate(ndotls[i])) - target;
+			const double lutError = 0.2126 * double(shaded[i].x) + 0.7152 * double(shaded[i].y) + 0.0722 * double(shaded[i].z) - target;
+			sumSquaredError[0] += lambertError * lambertError;
+			sumSquaredError[1] += lutError * lutError;
+		}
+		result.rmse[distanceIndex][0] = std::sqrt(sumSquaredError[0] / double(std::max(1, pixelCount)));
+		result.rmse[distanceIndex][1] = std::sqrt(sumSquaredError[1] / double(std::max(1, pixelCount)));
+
+		result.passed = result.passed && (pixelCount > 0) && (result.rmse[distanceIndex][1] < result.rmse[distanceIndex][0]);
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const PreintegratedLUTBenchmarkResult& result)
+{
+	out << "Pre-Integrated LUT (" << SSS_PREINTEGRATED_LUT_DEFAULT_SIZE << " x " << SSS_PREINTEGRATED_LUT_DEFAULT_SIZE << ", curvature map " << SSS_CURVATURE_MAP_DEFAULT_SIZE << " x " << SSS_CURVATURE_MAP_DEFAULT_SIZE << ", hardware concurrency " << result.hardwareConcurrency << ")" << endl;
+	out << std::fixed << setprecision(2);
+	for (int threadCountIndex = 0; threadCountIndex < PREINTEGRATED_LUT_BENCHMARK_THREAD_COUNT_COUNT; ++threadCountIndex)
+	{
+		out << "  " << setw(2) << result.threadCount[threadCountIndex] << " threads: LUT " << setw(8) << result.lutBakeMilliseconds[threadCountIndex] << " ms (x" << (result.lutBakeMilliseconds[0] / result.lutBakeMilliseconds[threadCountIndex]) << "), ";
+		out << "curvature map " << setw(8) << result.curvatureMapBakeMilliseconds[threadCountIndex] << " ms (x" << (result.curvatureMapBakeMilliseconds[0] / result.curvatureMapBakeMilliseconds[threadCountIndex]) << ")" << endl;
+	}
+	out << "  deterministic: " << (result.deterministic ? "yes" : "no") << ", " << result.coveredTexelCount << " covered texels" << endl;
+	out << std::scientific << "  curvature error (relative): vertices " << result.maxVertexCurvatureError << ", map " << result.maxMapCurvatureError << std::fixed << endl;
+	for (int distanceIndex = 0; distanceIndex < PREINTEGRATED_LUT_BENCHMARK_DISTANCE_COUNT; ++distanceIndex)
+	{
+		out << "  radius " << setw(3) << result.radiusInPixels[distanceIndex] << " pixels (" << setw(6) << result.pixelCount[distanceIndex] << " pixels): blur " << setw(8) << result.blurMilliseconds[distanceIndex] << " ms, LUT " << setw(6) << result.lutMilliseconds[distanceIndex] << " ms (x" << setprecision(0) << (result.blurMilliseconds[distanceIndex] / result.lutMilliseconds[distanceIndex]) << setprecision(2) << "), ";
+		out << std::scientific << "rmse N.L " << result.rmse[distanceIndex][0] << ", LUT " << result.rmse[distanceIndex][1] << std::fixed << endl;
+	}
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	return out;
+}
@@ -0,0 +1,216 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include "SSSBenchmarkInternal.h"
+#include "diffusion_profile_simd.h"
+
+using namespace std;
+
+SampleCountBucketBenchmarkResult benchmarkSampleCountBuckets(int width, int height, int repetitionCount)
+{
+	SampleCountBucketBenchmarkResult result = {};
+	result.simdWidth = diffusion_profile_simd_width();
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+
+	int pixelCount = 0;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			pixelCount += (0U != stencil(x, y)[0]) ? 1 : 0;
+		}
+	}
+
+	// [0] the generic loop, [1] the buckets
+	ImageRGBA32F mainRT[2] = { ImageRGBA32F(width, height), ImageRGBA32F(width, height) };
+
+	// The warm-up (NOT timed) and the mean of the "repetitionCount"
+	auto timedGo = [&](SSSBlurCPU& blur, ImageRGBA32F& targetRT) -> double
+	{
+		blur.go(targetRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+
+		double seconds = 0.0;
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			std::fill(targetRT.getData(), targetRT.getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			blur.go(targetRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+			seconds += elapsedSeconds(begin);
+		}
+		return 1000.0 * seconds / double(std::max(1, repetitionCount));
+	};
+
+	result.passed = true;
+
+	// Speedup
+	for (int bucket = 0; bucket < SSS_SAMPLE_COUNT_BUCKET_COUNT; ++bucket)
+	{
+		const int bucketSize = subsurface_scattering_sample_count_bucket_size(bucket);
+		result.bucketSize[bucket] = bucketSize;
+
+		for (int texturingMode = 0; texturingMode < 2; ++texturingMode)
+		{
+			SSSBlurCPU blur(0 != texturingMode, bucketSize, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+
+			blur.setSampleCountBucketsEnabled(false);
+			result.genericMilliseconds[bucket][texturingMode] = timedGo(blur, mainRT[0]);
+			const uint64_t genericSampleCount = blur.getSampleCount();
+
+			blur.setSampleCountBucketsEnabled(true);
+			result.bucketMilliseconds[bucket][texturingMode] = timedGo(blur, mainRT[1]);
+
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					for (int channel = 0; channel < 3; ++channel)
+					{
+						result.bucketMaxAbsoluteError[bucket][texturingMode] = std::max(result.bucketMaxAbsoluteError[bucket][texturingMode], double(std::abs(mainRT[1](x, y)[channel] - mainRT[0](x, y)[channel])));
+					}
+				}
+			}
+
+			// NOTE: the same number of the samples is required by the comparison
+			result.passed = result.passed && (genericSampleCount == blur.getSampleCount()) && (result.bucketMaxAbsoluteError[bucket][texturingMode] < 1e-4);
+		}
+	}
+
+	// Quality
+	ImageRGBA32F referenceRT(width, height);
+	{
+		SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+		blur.go(referenceRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+	}
+
+	for (int pixelsPerSampleIndex = 0; pixelsPerSampleIndex < SAMPLE_COUNT_BUCKET_BENCHMARK_PIXELS_PER_SAMPLE_COUNT; ++pixelsPerSampleIndex)
+	{
+		// 64, 256 and 1024
+		const int pixelsPerSample = SSS_MIN_PIXELS_PER_SAMPLE << (2 * (pixelsPerSampleIndex + 2));
+		result.pixelsPerSample[pixelsPerSampleIndex] = pixelsPerSample;
+
+		SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, pixelsPerSample, 1);
+		for (int modeIndex = 0; modeIndex < 2; ++modeIndex)
+		{
+			blur.setSampleCountBucketsEnabled(0 != modeIndex);
+			result.roundingMilliseconds[pixelsPerSampleIndex][modeIndex] = timedGo(blur, mainRT[modeIndex]);
+			result.samplesPerPixel[pixelsPerSampleIndex][modeIndex] = double(blur.getSampleCount()) / double(std::max(1, pixelCount));
+
+			double sumSquaredError = 0.0;
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					if (0U == stencil(x, y)[0])
+					{
+						continue;
+					}
+
+					const float* value = mainRT[modeIndex](x, y);
+					const float* reference = referenceRT(x, y);
+					const double error = 0.2126 * double(value[0] - reference[0]) + 0.7152 * double(value[1] - reference[1]) + 0.0722 * double(value[2] - reference[2]);
+					sumSquaredError += error * error;
+				}
+			}
+			result.rmse[pixelsPerSampleIndex][modeIndex] = std::sqrt(sumSquaredError / double(std::max(1, pixelCount)));
+		}
+
+		for (int bucket = 0; bucket < SSS_SAMPLE_COUNT_BUCKET_COUNT; ++bucket)
+		{
+			result.bucketTileCount[pixelsPerSampleIndex][bucket] = blur.getBucketTileCount(bucket);
+		}
+	}
+
+	// Budget: the tiles across the border of the reduced budget are rounded to the bucket of the reduced pixels
+	{
+		ImageR8U reducedStencil(width, height);
+		uint64_t sumBudget = 0;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const uint8_t value = stencil(x, y)[0];
+				reducedStencil(x, y)[0] = ((0U != value) && (x < (width / 2))) ? uint8_t(value | SSS_STENCIL_REDUCED_BUDGET_BIT) : value;
+				sumBudget += (0U != value) ? uint64_t(subsurface_scattering_sample_budget_from_stencil(reducedStencil(x, y)[0], SSS_MAX_SAMPLE_BUDGET)) : 0U;
+			}
+		}
+		result.reducedBudgetPerPixel = double(sumBudget) / double(std::max(1, pixelCount));
+
+		SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+		for (int modeIndex = 0; modeIndex < 2; ++modeIndex)
+		{
+			blur.setSampleCountBucketsEnabled(0 != modeIndex);
+			blur.go(mainRT[modeIndex], irradianceRT, depthRT, &reducedStencil, albedoRT, currProj, profiles);
+			result.reducedSamplesPerPixel[modeIndex] = double(blur.getSampleCount()) / double(std::max(1, pixelCount));
+			result.passed = result.passed && (blur.getSampleCount() <= sumBudget);
+		}
+
+		for (int bucket = 0; bucket < SSS_SAMPLE_COUNT_BUCKET_COUNT; ++bucket)
+		{
+			result.reducedBucketTileCount[bucket] = blur.getBucketTileCount(bucket);
+		}
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const SampleCountBucketBenchmarkResult& result)
+{
+	out << "Sample Count Buckets (SIMD width " << result.simdWidth << ", cost per frame of the generic loop / the buckets with the pre-scatter | the post-scatter)" << endl;
+	for (int bucket = 0; bucket < SSS_SAMPLE_COUNT_BUCKET_COUNT; ++bucket)
+	{
+		out << "  " << setw(2) << result.bucketSize[bucket] << " samples:" << std::fixed << setprecision(2);
+		for (int texturingMode = 0; texturingMode < 2; ++texturingMode)
+		{
+			out << ((0 == texturingMode) ? " " : " | ") << setw(8) << result.genericMilliseconds[bucket][texturingMode] << " / " << setw(8) << result.bucketMilliseconds[bucket][texturingMode] << " ms (x" << (result.genericMilliseconds[bucket][texturingMode] / result.bucketMilliseconds[bucket][texturingMode]) << ")";
+			out << std::scientific << setprecision(2) << " max error " << result.bucketMaxAbsoluteError[bucket][texturingMode] << std::fixed;
+		}
+		out << endl;
+	}
+	out << "  Rounding (RMSE against " << SSS_MIN_PIXELS_PER_SAMPLE << " pixels per sample, the generic loop / the buckets)" << endl;
+	for (int pixelsPerSampleIndex = 0; pixelsPerSampleIndex < SAMPLE_COUNT_BUCKET_BENCHMARK_PIXELS_PER_SAMPLE_COUNT; ++pixelsPerSampleIndex)
+	{
+		out << "    " << setw(4) << result.pixelsPerSample[pixelsPerSampleIndex] << " pixels per sample: " << setprecision(1);
+		out << setw(5) << result.samplesPerPixel[pixelsPerSampleIndex][0] << " / " << setw(5) << result.samplesPerPixel[pixelsPerSampleIndex][1] << " spp, " << setprecision(2);
+		out << setw(8) << result.roundingMilliseconds[pixelsPerSampleIndex][0] << " / " << setw(8) << result.roundingMilliseconds[pixelsPerSampleIndex][1] << " ms, ";
+		out << std::scientific << "rmse " << result.rmse[pixelsPerSampleIndex][0] << " / " << result.rmse[pixelsPerSampleIndex][1] << std::fixed << ", tiles";
+		for (int bucket = 0; bucket < SSS_SAMPLE_COUNT_BUCKET_COUNT; ++bucket)
+		{
+			out << " " << result.bucketTileCount[pixelsPerSampleIndex][bucket];
+		}
+		out << endl;
+	}
+	out << "  Reduced budget (the left half, " << std::fixed << setprecision(1) << result.reducedBudgetPerPixel << " samples per pixel at most): " << setw(5) << result.reducedSamplesPerPixel[0] << " / " << setw(5) << result.reducedSamplesPerPixel[1] << " spp, tiles";
+	for (int bucket = 0; bucket < SSS_SAMPLE_COUNT_BUCKET_COUNT; ++bucket)
+	{
+		out << " " << result.reducedBucketTileCount[bucket];
+	}
+	out << endl;
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	return out;
+}
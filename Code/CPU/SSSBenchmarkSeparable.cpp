@@ -0,0 +1,182 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+#include "SSSSeparableKernel.h"
+#include "subsurface_scattering_separable_blur.h"
+
+using namespace std;
+
+// The "SequenceConvergenceSource" plane of which the irradiance is the "irradianceRT" (NULL means the white noise of the plane) for the separable blur
+struct SeparableBenchmarkSource
+{
+	SequenceConvergenceSource plane;
+	const ImageRGBA32F* irradianceRT;
+	const float4* separableKernelRow;
+
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const
+	{
+		if (NULL == irradianceRT)
+		{
+			return plane.total_diffuse_reflectance_pre_scatter_multiply_form_factor(uv);
+		}
+		const float* texel = irradianceRT->sampleLevelPoint(uv);
+		return float3(texel[0], texel[1], texel[2]);
+	}
+
+	float subsurface_mask(float2 uv) const
+	{
+		return plane.subsurface_mask(uv);
+	}
+
+	int subsurface_profile_index(float2 uv) const
+	{
+		return plane.subsurface_profile_index(uv);
+	}
+
+	float view_space_position_z(float2 uv) const
+	{
+		return plane.view_space_position_z(uv);
+	}
+
+	float projection_x() const
+	{
+		return plane.projection_x();
+	}
+
+	float projection_y() const
+	{
+		return plane.projection_y();
+	}
+
+	float2 pixels_per_uv() const
+	{
+		return plane.pixels_per_uv();
+	}
+
+	float4 separable_kernel_sample(int, int sample_index) const
+	{
+		return separableKernelRow[sample_index];
+	}
+};
+
+SeparableBenchmarkResult benchmarkSeparable(int width, int height, int pixelStride)
+{
+	SeparableBenchmarkResult result = {};
+
+	const SSSProfileTable profiles;
+	const SSSProfile& profile = profiles.getProfile(0);
+
+	SSSSeparableKernel separableKernel;
+	separableKernel.update(profiles);
+
+	// The same setup as the "benchmarkSequenceConvergence"
+	// NOTE: the "pixelsPerUV" is square, s.t. the images (width x height) are addressed by the same uv as the plane
+	const int size = std::max(width, height);
+	const float pixelsPerMm = 96.0f / profile.filterRadius;
+	const float worldScale = 0.5f * float(size) / (1000.0f * pixelsPerMm);
+	const float2 pixelsPerUV(float(std::max(width, height)), float(std::max(width, height)));
+	const int pixelsPerSample = SSS_MIN_PIXELS_PER_SAMPLE;
+	const SequenceConvergenceSource source = { LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY, pixelsPerUV, 0U };
+
+	vector<float2> uvs;
+	for (int y = pixelStride / 2; y < height; y += pixelStride)
+	{
+		for (int x = pixelStride / 2; x < width; x += pixelStride)
+		{
+			uvs.push_back(float2((float(x) + 0.5f) / pixelsPerUV.x, (float(y) + 0.5f) / pixelsPerUV.y));
+		}
+	}
+
+	const vector<float3> reference = perChannelReference(source, profile, worldScale, pixelsPerSample, uvs);
+
+	result.gaussianFitRmse = subsurface_scattering_separable_gaussian_fit().rmse;
+	result.separableSampleCount = 2 * SSS_SEPARABLE_KERNEL_SAMPLE_COUNT;
+
+	{
+		ImageRGBA32F tmpRT(size, size);
+		ImageRGBA32F outRT(size, size);
+
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			const float2 direction = (0 == pass) ? float2(1.0f, 0.0f) : float2(0.0f, 1.0f);
+			const SeparableBenchmarkSource separableSource = { source, (0 == pass) ? NULL : &tmpRT, separableKernel.getRow(0) };
+			ImageRGBA32F& dstRT = (0 == pass) ? tmpRT : outRT;
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					float3 color = subsurface_scattering_separable_blur(separableSource, profile.filterRadius, worldScale, direction, float2((float(x) + 0.5f) / pixelsPerUV.x, (float(y) + 0.5f) / pixelsPerUV.y));
+					float* dst = dstRT(x, y);
+					dst[0] = color.x;
+					dst[1] = color.y;
+					dst[2] = color.z;
+				}
+			}
+		}
+		result.separableNanosecondsPerPixel = elapsedSeconds(begin) * 1.0e9 / double(width * height);
+
+		// NOTE: the "total_diffuse_reflectance_post_scatter" of the plane is one
+		vector<float3> radiance(uvs.size());
+		for (size_t i = 0; i < uvs.size(); ++i)
+		{
+			const float* texel = outRT.sampleLevelPoint(uvs[i]);
+			radiance[i] = float3(texel[0], texel[1], texel[2]);
+		}
+		result.separableRmse = rmsePerChannel(radiance, reference);
+	}
+
+	for (int budgetIndex = 0; budgetIndex < SEPARABLE_BENCHMARK_BUDGET_COUNT; ++budgetIndex)
+	{
+		const int sampleBudget = (budgetIndex < (SEPARABLE_BENCHMARK_BUDGET_COUNT - 1)) ? (16 << budgetIndex) : SSS_MAX_SAMPLE_BUDGET;
+		result.burleySampleBudget[budgetIndex] = sampleBudget;
+
+		vector<float3> radiance(uvs.size());
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		for (size_t i = 0; i < uvs.size(); ++i)
+		{
+			radiance[i] = subsurface_scattering_disney_blur(source, profile.scatteringDistance, profile.filterRadius, worldScale, pixelsPerSample, sampleBudget, SSS_MIS_MODE_NONE, uvs[i]);
+		}
+		result.burleyNanosecondsPerPixel[budgetIndex] = elapsedSeconds(begin) * 1.0e9 / double(uvs.size());
+		result.burleyRmse[budgetIndex] = rmsePerChannel(radiance, reference);
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const SeparableBenchmarkResult& result)
+{
+	out << "Separable (RMSE per channel against " << SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT << " samples, cost per pixel per core)" << endl;
+	out << std::scientific << setprecision(2);
+	out << "  sum of " << SSS_SEPARABLE_GAUSSIAN_COUNT << " gaussians: fit error " << result.gaussianFitRmse << " (relative)" << endl;
+	out << "  separable  " << setw(2) << result.separableSampleCount << " taps: r " << result.separableRmse.x << ", g " << result.separableRmse.y << ", b " << result.separableRmse.z;
+	out << std::fixed << setprecision(1) << ", " << result.separableNanosecondsPerPixel << " ns" << endl;
+	for (int budgetIndex = 0; budgetIndex < SEPARABLE_BENCHMARK_BUDGET_COUNT; ++budgetIndex)
+	{
+		out << std::scientific << setprecision(2);
+		out << "  burley     " << setw(2) << result.burleySampleBudget[budgetIndex] << " taps: r " << result.burleyRmse[budgetIndex].x << ", g " << result.burleyRmse[budgetIndex].y << ", b " << result.burleyRmse[budgetIndex].z;
+		out << std::fixed << setprecision(1) << ", " << result.burleyNanosecondsPerPixel[budgetIndex] << " ns (x" << setprecision(2) << (result.burleyNanosecondsPerPixel[budgetIndex] / result.separableNanosecondsPerPixel) << ")" << endl;
+	}
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,122 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+SequenceConvergenceResult benchmarkSequenceConvergence(int width, int height, int pixelStride)
+{
+	SequenceConvergenceResult result = {};
+
+	const SSSProfileTable profiles;
+	const SSSProfile& profile = profiles.getProfile(0);
+
+	// The filter radius is 96 pixels, s.t. the "sample_count_unclamped" (PI * 96 * 96 / 4) is greater than the reference sample count
+	// pixels_per_mm = pixels_per_uv * 0.5 * projection / view_space_position_z / (1000 * world_scale)
+	const float pixelsPerMm = 96.0f / profile.filterRadius;
+	const float worldScale = 0.5f * float(std::max(width, height)) / (1000.0f * pixelsPerMm);
+	const float2 pixelsPerUV(float(std::max(width, height)), float(std::max(width, height)));
+	const int pixelsPerSample = SSS_MIN_PIXELS_PER_SAMPLE;
+
+	vector<float2> uvs;
+	for (int y = pixelStride / 2; y < height; y += pixelStride)
+	{
+		for (int x = pixelStride / 2; x < width; x += pixelStride)
+		{
+			uvs.push_back(float2((float(x) + 0.5f) / pixelsPerUV.x, (float(y) + 0.5f) / pixelsPerUV.y));
+		}
+	}
+
+	vector<float3> reference(uvs.size());
+	{
+		const SequenceConvergenceSource source = { LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY, pixelsPerUV, 0U };
+		for (size_t i = 0; i < uvs.size(); ++i)
+		{
+			reference[i] = subsurface_scattering_disney_blur<SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT>(source, profile.scatteringDistance, profile.filterRadius, worldScale, pixelsPerSample, SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT, SSS_MIS_MODE_NONE, uvs[i]);
+		}
+	}
+
+	for (int sequence = 0; sequence < LOW_DISCREPANCY_SEQUENCE_COUNT; ++sequence)
+	{
+		const SequenceConvergenceSource source = { sequence, pixelsPerUV, 0U };
+
+		for (int budgetIndex = 0; budgetIndex < SEQUENCE_CONVERGENCE_BUDGET_COUNT; ++budgetIndex)
+		{
+			const int sampleBudget = 4 * (budgetIndex + 1);
+			result.sampleBudget[budgetIndex] = sampleBudget;
+
+			double sumSquaredError = 0.0;
+			for (size_t i = 0; i < uvs.size(); ++i)
+			{
+				float3 radiance = subsurface_scattering_disney_blur(source, profile.scatteringDistance, profile.filterRadius, worldScale, pixelsPerSample, sampleBudget, SSS_MIS_MODE_NONE, uvs[i]);
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					double error = double((&radiance.x)[channel]) - double((&reference[i].x)[channel]);
+					sumSquaredError += error * error;
+				}
+			}
+			result.rmse[sequence][budgetIndex] = std::sqrt(sumSquaredError / double(3U * uvs.size()));
+		}
+	}
+
+	// 32 = 4 * (7 + 1)
+	const double hammersley32 = result.rmse[LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY][7];
+	for (int sequence = 0; sequence < LOW_DISCREPANCY_SEQUENCE_COUNT; ++sequence)
+	{
+		for (int budgetIndex = 0; budgetIndex < SEQUENCE_CONVERGENCE_BUDGET_COUNT; ++budgetIndex)
+		{
+			if (result.rmse[sequence][budgetIndex] <= hammersley32)
+			{
+				result.budgetToMatchHammersley32[sequence] = result.sampleBudget[budgetIndex];
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const SequenceConvergenceResult& result)
+{
+	static const char* const sequenceNames[LOW_DISCREPANCY_SEQUENCE_COUNT] = { "hammersley", "fibonacci ", "r2        ", "sobol-owen", "blue noise" };
+
+	out << "Sequence Convergence (RMSE against " << SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT << " samples)" << endl;
+	out << "  budget    ";
+	for (int budgetIndex = 0; budgetIndex < SEQUENCE_CONVERGENCE_BUDGET_COUNT; ++budgetIndex)
+	{
+		out << " " << setw(8) << result.sampleBudget[budgetIndex];
+	}
+	out << endl;
+	out << std::scientific << setprecision(2);
+	for (int sequence = 0; sequence < LOW_DISCREPANCY_SEQUENCE_COUNT; ++sequence)
+	{
+		out << "  " << sequenceNames[sequence];
+		for (int budgetIndex = 0; budgetIndex < SEQUENCE_CONVERGENCE_BUDGET_COUNT; ++budgetIndex)
+		{
+			out << " " << result.rmse[sequence][budgetIndex];
+		}
+		out << " (matches hammersley 32 at " << result.budgetToMatchHammersley32[sequence] << ")" << endl;
+	}
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,100 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include "SSSBenchmarkInternal.h"
+#include "SSSTransmittanceLUT.h"
+
+using namespace std;
+
+ShadowThicknessVerificationResult verifyShadowThickness()
+{
+	ShadowThicknessVerificationResult result = {};
+
+	// The same as the "lights[i].camera.setProjection" of the demo (only the depth of the projection matters)
+	const float nearPlane = 0.1f;
+	const float farPlane = 10.0f;
+	const float metersPerUnit = 0.125f;
+	float4x4 lightProjection = {};
+	lightProjection.m[0][0] = 1.0f / std::tan(0.5f * (45.0f * float(PI) / 180.0f));
+	lightProjection.m[1][1] = lightProjection.m[0][0];
+	lightProjection.m[2][2] = farPlane / (farPlane - nearPlane);
+	lightProjection.m[2][3] = 1.0f;
+	lightProjection.m[3][2] = -nearPlane * farPlane / (farPlane - nearPlane);
+
+	const float distance[SHADOW_THICKNESS_VERIFICATION_DISTANCE_COUNT] = { 0.5f, 1.0f, 2.0f, 4.0f, 8.0f };
+
+	result.passed = true;
+	for (int distanceIndex = 0; distanceIndex < SHADOW_THICKNESS_VERIFICATION_DISTANCE_COUNT; ++distanceIndex)
+	{
+		result.distance[distanceIndex] = distance[distanceIndex];
+		for (int sampleIndex = 0; sampleIndex < SHADOW_THICKNESS_VERIFICATION_SAMPLE_COUNT; ++sampleIndex)
+		{
+			const float2 xi = hammersley_2d(uint32_t(sampleIndex), uint32_t(SHADOW_THICKNESS_VERIFICATION_SAMPLE_COUNT));
+			const float thicknessInMillimeters = xi.x * SSS_TRANSMITTANCE_LUT_MAX_THICKNESS;
+			const float3 reference = subsurface_scattering_disney_transmittance(benchmarkScatteringDistance, thicknessInMillimeters);
+
+			// The shaded point and the first surface seen by the light
+			const float shadowPositionW = distance[distanceIndex] * (1.0f + 0.05f * xi.y);
+			const float occluderViewPositionZ = shadowPositionW - thicknessInMillimeters / (1000.0f * metersPerUnit);
+			const float shadowPositionZ = subsurface_scattering_ndcz_from_view_space_position_z(shadowPositionW, lightProjection);
+
+			for (int shadowDepthMode = 0; shadowDepthMode < SSS_SHADOW_DEPTH_MODE_COUNT; ++shadowDepthMode)
+			{
+				const float texel = subsurface_scattering_shadow_map_texel(shadowDepthMode, occluderViewPositionZ, lightProjection);
+				const float texelViewPositionZ = (SSS_SHADOW_DEPTH_MODE_NDC_R32F == shadowDepthMode) ? (lightProjection.m[3][2] / (texel - lightProjection.m[2][2])) : texel;
+				result.depthMaxError[distanceIndex][shadowDepthMode] = std::max(result.depthMaxError[distanceIndex][shadowDepthMode], 1000.0 * double(metersPerUnit) * std::abs(double(texelViewPositionZ) - double(occluderViewPositionZ)));
+
+				const float thickness = 1000.0f * metersPerUnit * subsurface_scattering_shadow_thickness(shadowDepthMode, texel, shadowPositionZ, shadowPositionW, lightProjection);
+				result.thicknessMaxError[distanceIndex][shadowDepthMode] = std::max(result.thicknessMaxError[distanceIndex][shadowDepthMode], std::abs(double(thickness) - double(thicknessInMillimeters)));
+
+				const float3 transmittance = subsurface_scattering_disney_transmittance(benchmarkScatteringDistance, thickness);
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					result.transmittanceMaxError[distanceIndex][shadowDepthMode] = std::max(result.transmittanceMaxError[distanceIndex][shadowDepthMode], double(std::abs((&transmittance.x)[channel] - (&reference.x)[channel])));
+				}
+			}
+		}
+
+		// The linear R32F does NOT reconstruct both ends from the NDC, and the error of the linear R16F is bounded by the half ULP of the texel (2^-11 relative) and the rounding of the occluder (in float)
+		const double halfBound = 1000.0 * double(metersPerUnit) * (std::ldexp(1.0, -11) + std::ldexp(1.0, -22)) * double(distance[distanceIndex]) * 1.05;
+		result.passed = result.passed && (result.thicknessMaxError[distanceIndex][SSS_SHADOW_DEPTH_MODE_LINEAR_R32F] <= result.thicknessMaxError[distanceIndex][SSS_SHADOW_DEPTH_MODE_NDC_R32F]) && (result.thicknessMaxError[distanceIndex][SSS_SHADOW_DEPTH_MODE_LINEAR_R16F] <= halfBound);
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const ShadowThicknessVerificationResult& result)
+{
+	static const char* const shadowDepthModeNames[SSS_SHADOW_DEPTH_MODE_COUNT] = { "NDC R32F   ", "Linear R16F", "Linear R32F" };
+
+	out << "Shadow Thickness (max error of the depth of the shadow map in mm, of the thickness in mm and of the transmittance)" << endl;
+	for (int distanceIndex = 0; distanceIndex < SHADOW_THICKNESS_VERIFICATION_DISTANCE_COUNT; ++distanceIndex)
+	{
+		out << "  distance " << std::fixed << setprecision(1) << result.distance[distanceIndex] << endl;
+		for (int shadowDepthMode = 0; shadowDepthMode < SSS_SHADOW_DEPTH_MODE_COUNT; ++shadowDepthMode)
+		{
+			out << "    " << shadowDepthModeNames[shadowDepthMode] << ": " << std::scientific << setprecision(2);
+			out << "depth " << result.depthMaxError[distanceIndex][shadowDepthMode] << " mm, thickness " << result.thicknessMaxError[distanceIndex][shadowDepthMode] << " mm, transmittance " << result.transmittanceMaxError[distanceIndex][shadowDepthMode] << endl;
+		}
+	}
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	out << std::fixed;
+	return out;
+}
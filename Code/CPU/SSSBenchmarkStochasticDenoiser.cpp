@@ -0,0 +1,143 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+StochasticDenoiserBenchmarkResult benchmarkStochasticDenoiser(int width, int height, int repetitionCount)
+{
+	StochasticDenoiserBenchmarkResult result = {};
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT);
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			result.pixelCount += (0U != stencil(x, y)[0]) ? 1 : 0;
+		}
+	}
+
+	ImageRGBA32F referenceRT(width, height);
+	{
+		SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+		blur.go(referenceRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+	}
+
+	ImageRGBA32F mainRT(width, height);
+	ImageRGBA32F baselineRT(width, height);
+
+	// The warm-up (NOT timed) and the mean of the "repetitionCount"
+	auto timedGo = [&](SSSBlurCPU& blur, ImageRGBA32F& targetRT) -> double
+	{
+		blur.go(targetRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+
+		double seconds = 0.0;
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			std::fill(targetRT.getData(), targetRT.getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			blur.go(targetRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+			seconds += elapsedSeconds(begin);
+		}
+		return 1000.0 * seconds / double(std::max(1, repetitionCount));
+	};
+
+	// The RMSE of the luminance over the pixels of the subsurface scattering
+	auto rmse = [&](const ImageRGBA32F& valueRT, const ImageRGBA32F& targetRT) -> double
+	{
+		double sumSquaredError = 0.0;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				if (0U == stencil(x, y)[0])
+				{
+					continue;
+				}
+
+				const float* value = valueRT(x, y);
+				const float* target = targetRT(x, y);
+				const double error = 0.2126 * double(value[0] - target[0]) + 0.7152 * double(value[1] - target[1]) + 0.0722 * double(value[2] - target[2]);
+				sumSquaredError += error * error;
+			}
+		}
+		return std::sqrt(sumSquaredError / double(std::max(1, result.pixelCount)));
+	};
+
+	{
+		SSSBlurCPU blur(false, STOCHASTIC_DENOISER_BENCHMARK_BASELINE_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+		result.baselineMilliseconds = timedGo(blur, baselineRT);
+		result.baselineSamplesPerPixel = double(blur.getSampleCount()) / double(std::max(1, result.pixelCount));
+		result.baselineRmse = rmse(baselineRT, referenceRT);
+	}
+
+	result.passed = true;
+
+	for (int sampleCountIndex = 0; sampleCountIndex < STOCHASTIC_DENOISER_BENCHMARK_SAMPLE_COUNT_COUNT; ++sampleCountIndex)
+	{
+		// 1, 2 and 4
+		const int sampleCount = std::min(1 << sampleCountIndex, int(SSS_STOCHASTIC_MAX_SAMPLE_COUNT));
+		result.sampleCount[sampleCountIndex] = sampleCount;
+
+		SSSBlurCPU blur(false, STOCHASTIC_DENOISER_BENCHMARK_BASELINE_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+		blur.setStochasticSampleCount(sampleCount);
+		for (int denoiserIndex = 0; denoiserIndex < 2; ++denoiserIndex)
+		{
+			blur.setDenoiserIterationCount((0 != denoiserIndex) ? SSS_ATROUS_DEFAULT_ITERATION_COUNT : 0);
+			result.milliseconds[sampleCountIndex][denoiserIndex] = timedGo(blur, mainRT);
+			result.rmse[sampleCountIndex][denoiserIndex] = rmse(mainRT, referenceRT);
+			result.baselineRelativeRmse[sampleCountIndex][denoiserIndex] = rmse(mainRT, baselineRT);
+		}
+		result.samplesPerPixel[sampleCountIndex] = double(blur.getSampleCount()) / double(std::max(1, result.pixelCount));
+
+		result.passed = result.passed && (result.rmse[sampleCountIndex][1] < result.rmse[sampleCountIndex][0]);
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const StochasticDenoiserBenchmarkResult& result)
+{
+	out << "Stochastic Denoiser (" << result.pixelCount << " pixels, RMSE against " << SSS_MAX_SAMPLE_BUDGET << " samples | against the baseline)" << endl;
+	out << "  baseline: " << std::fixed << setprecision(1) << setw(5) << result.baselineSamplesPerPixel << " spp, " << setprecision(2) << setw(8) << result.baselineMilliseconds << " ms, ";
+	out << std::scientific << "rmse " << result.baselineRmse << std::fixed << endl;
+	for (int sampleCountIndex = 0; sampleCountIndex < STOCHASTIC_DENOISER_BENCHMARK_SAMPLE_COUNT_COUNT; ++sampleCountIndex)
+	{
+		out << "  " << result.sampleCount[sampleCountIndex] << " samples: " << setprecision(1) << setw(5) << result.samplesPerPixel[sampleCountIndex] << " spp, " << setprecision(2);
+		for (int denoiserIndex = 0; denoiserIndex < 2; ++denoiserIndex)
+		{
+			out << ((0 == denoiserIndex) ? "noisy " : ", denoised ") << setw(8) << result.milliseconds[sampleCountIndex][denoiserIndex] << " ms (x" << (result.baselineMilliseconds / result.milliseconds[sampleCountIndex][denoiserIndex]) << ") ";
+			out << std::scientific << "rmse " << result.rmse[sampleCountIndex][denoiserIndex] << " | " << result.baselineRelativeRmse[sampleCountIndex][denoiserIndex] << std::fixed;
+		}
+		out << endl;
+	}
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	return out;
+}
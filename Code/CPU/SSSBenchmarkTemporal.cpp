@@ -0,0 +1,488 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+// The row major matrices (row vector)
+static float4x4 temporalMul(const float4x4& a, const float4x4& b)
+{
+	float4x4 c = {};
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			for (int k = 0; k < 4; ++k)
+			{
+				c.m[row][column] += a.m[row][k] * b.m[k][column];
+			}
+		}
+	}
+	return c;
+}
+
+// Gauss-Jordan elimination with partial pivoting (in double precision)
+static float4x4 temporalInverse(const float4x4& a)
+{
+	double m[4][8];
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			m[row][column] = double(a.m[row][column]);
+			m[row][4 + column] = (row == column) ? 1.0 : 0.0;
+		}
+	}
+
+	for (int column = 0; column < 4; ++column)
+	{
+		int pivot = column;
+		for (int row = column + 1; row < 4; ++row)
+		{
+			pivot = (std::abs(m[row][column]) > std::abs(m[pivot][column])) ? row : pivot;
+		}
+		for (int k = 0; k < 8; ++k)
+		{
+			std::swap(m[column][k], m[pivot][k]);
+		}
+
+		const double rcp = 1.0 / m[column][column];
+		for (int k = 0; k < 8; ++k)
+		{
+			m[column][k] *= rcp;
+		}
+		for (int row = 0; row < 4; ++row)
+		{
+			if (row != column)
+			{
+				const double factor = m[row][column];
+				for (int k = 0; k < 8; ++k)
+				{
+					m[row][k] -= factor * m[column][k];
+				}
+			}
+		}
+	}
+
+	float4x4 b;
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			b.m[row][column] = float(m[row][4 + column]);
+		}
+	}
+	return b;
+}
+
+static float3 temporalCross(float3 a, float3 b)
+{
+	return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static float3 temporalNormalize(float3 a)
+{
+	return a / std::sqrt(dot(a, a));
+}
+
+// The camera looks at the origin (left handed, the same as the "XMMatrixLookAtLH")
+struct TemporalCamera
+{
+	float3 eye;
+	float3 axis[3];
+	float4x4 view;
+	float4x4 viewProj;
+};
+
+static TemporalCamera temporalCamera(float3 eye, const float4x4& proj)
+{
+	TemporalCamera camera;
+	camera.eye = eye;
+	camera.axis[2] = temporalNormalize(float3(0.0f, 0.0f, 0.0f) - eye);
+	camera.axis[0] = temporalNormalize(temporalCross(float3(0.0f, 1.0f, 0.0f), camera.axis[2]));
+	camera.axis[1] = temporalCross(camera.axis[2], camera.axis[0]);
+
+	camera.view = {};
+	for (int i = 0; i < 3; ++i)
+	{
+		camera.view.m[0][i] = camera.axis[i].x;
+		camera.view.m[1][i] = camera.axis[i].y;
+		camera.view.m[2][i] = camera.axis[i].z;
+		camera.view.m[3][i] = -dot(camera.axis[i], eye);
+	}
+	camera.view.m[3][3] = 1.0f;
+
+	camera.viewProj = temporalMul(camera.view, proj);
+	return camera;
+}
+
+// A sphere (radius 0.5) at the origin in front of a plane (z = 1)
+// The "t" is along the "direction" (NOT normalized), or negative if the ray misses
+static float temporalSceneHit(float3 origin, float3 direction)
+{
+	float t = -1.0f;
+
+	// |origin + t * direction|^2 = 0.25
+	const float a = dot(direction, direction);
+	const float b = dot(origin, direction);
+	const float c = dot(origin, origin) - 0.25f;
+	const float discriminant = b * b - a * c;
+	if (discriminant >= 0.0f)
+	{
+		const float sphereT = (-b - std::sqrt(discriminant)) / a;
+		t = (sphereT > 0.0f) ? sphereT : t;
+	}
+
+	if ((t < 0.0f) && (direction.z > 0.0f))
+	{
+		const float planeT = (1.0f - origin.z) / direction.z;
+		const float3 position = origin + direction * planeT;
+		t = ((planeT > 0.0f) && (std::abs(position.x) < 2.0f) && (std::abs(position.y) < 2.0f)) ? planeT : t;
+	}
+
+	return t;
+}
+
+// The ray through the center of the pixel, of which the view space z of the "direction" is one, s.t. the "t" is the view space position z
+static float3 temporalPixelDirection(const TemporalCamera& camera, const float4x4& proj, int x, int y, int width, int height)
+{
+	const float ndcX = (float(x) + 0.5f) / float(width) * 2.0f - 1.0f;
+	const float ndcY = (float(y) + 0.5f) / float(height) * -2.0f + 1.0f;
+	return camera.axis[0] * (ndcX / proj.m[0][0]) + camera.axis[1] * (ndcY / proj.m[1][1]) + camera.axis[2];
+}
+
+// The counterpart of the "Shaders/Support/SSS_Blur.hlsli" for the "subsurface_scattering_temporal_history"
+struct TemporalHistorySource
+{
+	const ImageRGBA32F& historyRT;
+	// (view_space_position_z, subsurface_mask)
+	const ImageRGBA32F& historyGuideRT;
+
+	float4 history(int x, int y) const
+	{
+		const float* texel = historyRT(x, y);
+		return float4(texel[0], texel[1], texel[2], texel[3]);
+	}
+
+	float2 history_guide(int x, int y) const
+	{
+		const float* texel = historyGuideRT(x, y);
+		return float2(texel[0], texel[1]);
+	}
+
+	int history_width() const
+	{
+		return historyRT.getWidth();
+	}
+
+	int history_height() const
+	{
+		return historyRT.getHeight();
+	}
+};
+
+TemporalReprojectionVerificationResult verifyTemporalReprojection(int width, int height)
+{
+	TemporalReprojectionVerificationResult result = {};
+
+	// The same projection as the "multiProfileScene"
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+	const float yScale = 1.0f / std::tan(0.5f * (20.0f * float(PI) / 180.0f));
+	float4x4 proj = {};
+	proj.m[0][0] = yScale * float(height) / float(width);
+	proj.m[1][1] = yScale;
+	proj.m[2][2] = farPlane / (farPlane - nearPlane);
+	proj.m[2][3] = 1.0f;
+	proj.m[3][2] = -nearPlane * farPlane / (farPlane - nearPlane);
+
+	// The camera is orbited by 3 degrees and moved closer, s.t. the plane behind the silhouette of the sphere is disoccluded and the border is off screen
+	const float orbit = 3.0f * float(PI) / 180.0f;
+	const TemporalCamera prevCamera = temporalCamera(float3(0.0f, 0.0f, -4.0f), proj);
+	const TemporalCamera currCamera = temporalCamera(float3(3.9f * std::sin(orbit), 0.1f, -3.9f * std::cos(orbit)), proj);
+
+	// The history of the previous frame: (x, y, 0.5, history_length) and (view_space_position_z, subsurface_mask)
+	ImageRGBA32F historyRT(width, height);
+	ImageRGBA32F historyGuideRT(width, height);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const float t = temporalSceneHit(prevCamera.eye, temporalPixelDirection(prevCamera, proj, x, y, width, height));
+			if (t > 0.0f)
+			{
+				float* history = historyRT(x, y);
+				history[0] = float(x) / float(width);
+				history[1] = float(y) / float(height);
+				history[2] = 0.5f;
+				history[3] = 4.0f;
+				historyGuideRT(x, y)[0] = t;
+				historyGuideRT(x, y)[1] = 1.0f;
+			}
+		}
+	}
+	const TemporalHistorySource source = { historyRT, historyGuideRT };
+
+	// Moving Camera
+	{
+		const float4x4 reprojection = temporalMul(temporalInverse(currCamera.viewProj), prevCamera.viewProj);
+
+		int rejectedCount = 0;
+		int falseAcceptCount = 0;
+		int falseRejectCount = 0;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const float3 direction = temporalPixelDirection(currCamera, proj, x, y, width, height);
+				const float t = temporalSceneHit(currCamera.eye, direction);
+				if (t <= 0.0f)
+				{
+					continue;
+				}
+				++result.pixelCount;
+
+				const float3 position = currCamera.eye + direction * t;
+				const float4 currClip = subsurface_scattering_temporal_mul(float4(position.x, position.y, position.z, 1.0f), currCamera.viewProj);
+				const float4 prevClip = subsurface_scattering_temporal_mul(float4(position.x, position.y, position.z, 1.0f), prevCamera.viewProj);
+
+				// The "RenderPS" and the "SSS_Blur_Temporal_PS"
+				const float2 uv((float(x) + 0.5f) / float(width), (float(y) + 0.5f) / float(height));
+				const float2 prevUV = uv - subsurface_scattering_motion_vector(currClip, prevClip);
+				const float3 reprojected = subsurface_scattering_temporal_reproject(uv, currClip.z / currClip.w, currClip.w, reprojection);
+
+				result.maxMotionVectorError = std::max(result.maxMotionVectorError, double(std::max(std::abs(prevUV.x - reprojected.x) * float(width), std::abs(prevUV.y - reprojected.y) * float(height))));
+				result.maxViewDepthError = std::max(result.maxViewDepthError, double(std::abs(reprojected.z - prevClip.w) / prevClip.w));
+
+				const float4 history = subsurface_scattering_temporal_history(source, prevUV, reprojected.z, 1.0f);
+
+				// Visible in the previous frame: on screen and NOT occluded
+				const bool onScreen = (prevUV.x >= 0.0f) && (prevUV.y >= 0.0f) && (prevUV.x <= 1.0f) && (prevUV.y <= 1.0f);
+				const bool visible = onScreen && (temporalSceneHit(prevCamera.eye, position - prevCamera.eye) > (1.0f - 1.0e-3f));
+
+				rejectedCount += (history.w <= 0.0f) ? 1 : 0;
+				falseAcceptCount += ((history.w > 0.0f) && (!visible)) ? 1 : 0;
+				falseRejectCount += ((history.w <= 0.0f) && visible) ? 1 : 0;
+			}
+		}
+		result.rejectedRatio = double(rejectedCount) / double(std::max(1, result.pixelCount));
+		result.falseAcceptRatio = double(falseAcceptCount) / double(std::max(1, result.pixelCount));
+		result.falseRejectRatio = double(falseRejectCount) / double(std::max(1, result.pixelCount));
+	}
+
+	// Still Camera
+	{
+		ImageRGBA32F depthChangedGuideRT(historyGuideRT);
+		ImageRGBA32F maskChangedGuideRT(historyGuideRT);
+		ImageRGBA32F maskSimilarGuideRT(historyGuideRT);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				depthChangedGuideRT(x, y)[0] *= 1.05f;
+				maskChangedGuideRT(x, y)[1] *= 0.5f;
+				maskSimilarGuideRT(x, y)[1] *= 0.95f;
+			}
+		}
+		const TemporalHistorySource depthChangedSource = { historyRT, depthChangedGuideRT };
+		const TemporalHistorySource maskChangedSource = { historyRT, maskChangedGuideRT };
+		const TemporalHistorySource maskSimilarSource = { historyRT, maskSimilarGuideRT };
+
+		const float4x4 reprojection = temporalMul(temporalInverse(prevCamera.viewProj), prevCamera.viewProj);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const float t = historyGuideRT(x, y)[0];
+				if (t <= 0.0f)
+				{
+					continue;
+				}
+
+				// The motion vector is zero
+				const float2 uv((float(x) + 0.5f) / float(width), (float(y) + 0.5f) / float(height));
+				const float3 reprojected = subsurface_scattering_temporal_reproject(uv, (proj.m[2][2] * t + proj.m[3][2]) / t, t, reprojection);
+
+				const float4 history = subsurface_scattering_temporal_history(source, uv, reprojected.z, 1.0f);
+				const float* expected = historyRT(x, y);
+				result.stillRejectedCount += (history.w <= 0.0f) ? 1 : 0;
+				result.stillMaxAbsoluteError = std::max(result.stillMaxAbsoluteError, double(std::max(std::max(std::abs(history.x - expected[0]), std::abs(history.y - expected[1])), std::max(std::abs(history.z - expected[2]), std::abs(history.w - expected[3])))));
+
+				result.depthChangedAcceptedCount += (subsurface_scattering_temporal_history(depthChangedSource, uv, reprojected.z, 1.0f).w > 0.0f) ? 1 : 0;
+				result.maskChangedAcceptedCount += (subsurface_scattering_temporal_history(maskChangedSource, uv, reprojected.z, 1.0f).w > 0.0f) ? 1 : 0;
+				result.maskSimilarRejectedCount += (subsurface_scattering_temporal_history(maskSimilarSource, uv, reprojected.z, 1.0f).w <= 0.0f) ? 1 : 0;
+			}
+		}
+	}
+
+	// Accumulation
+	{
+		const int frameCount = 4 * int(SSS_TEMPORAL_MAX_HISTORY_LENGTH);
+		float4 history(0.0f, 0.0f, 0.0f, 0.0f);
+		double sum = 0.0;
+		double average = 0.0;
+		for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+		{
+			const float current = 0.5f + 0.5f * std::sin(float(frameIndex) * 1.7f);
+			history = subsurface_scattering_temporal_accumulate(float3(current, current, current), history, SSS_TEMPORAL_DEFAULT_BLEND);
+
+			sum += double(current);
+			const double length = double(frameIndex + 1);
+			average = (length <= (1.0 / double(SSS_TEMPORAL_DEFAULT_BLEND))) ? (sum / length) : (average + double(SSS_TEMPORAL_DEFAULT_BLEND) * (double(current) - average));
+			result.accumulateMaxError = std::max(result.accumulateMaxError, std::abs(double(history.x) - average));
+		}
+		// The history length is clamped
+		result.accumulateMaxError = std::max(result.accumulateMaxError, std::abs(double(history.w) - double(SSS_TEMPORAL_MAX_HISTORY_LENGTH)));
+	}
+
+	// NOTE: the false accept and the false reject are only expected within one pixel of the silhouettes, where the bilinear footprint straddles the occluder
+	result.passed = (result.maxMotionVectorError < 1.0e-2) && (result.maxViewDepthError < 1.0e-4) && (result.falseAcceptRatio < 1.0e-2) && (result.falseRejectRatio < 1.0e-2) && (0 == result.stillRejectedCount) && (result.stillMaxAbsoluteError < 1.0e-3) && (0 == result.depthChangedAcceptedCount) && (0 == result.maskChangedAcceptedCount) && (0 == result.maskSimilarRejectedCount) && (result.accumulateMaxError < 1.0e-5);
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const TemporalReprojectionVerificationResult& result)
+{
+	out << "Temporal Reprojection (" << (result.passed ? "passed" : "FAILED") << ")" << endl;
+	out << std::scientific << setprecision(2);
+	out << "  moving camera: " << result.pixelCount << " pixels, motion vector error " << result.maxMotionVectorError << " pixels, view depth error " << result.maxViewDepthError << " (relative)" << endl;
+	out << std::fixed << setprecision(2);
+	out << "  rejection: rejected " << (100.0 * result.rejectedRatio) << "%, false accept " << (100.0 * result.falseAcceptRatio) << "%, false reject " << (100.0 * result.falseRejectRatio) << "%" << endl;
+	out << std::scientific << setprecision(2);
+	out << "  still camera: " << result.stillRejectedCount << " rejected, max error " << result.stillMaxAbsoluteError << " (absolute)" << endl;
+	out << "  depth changed: " << result.depthChangedAcceptedCount << " accepted, mask changed: " << result.maskChangedAcceptedCount << " accepted, mask similar: " << result.maskSimilarRejectedCount << " rejected" << endl;
+	out << "  accumulate: max error " << result.accumulateMaxError << " (absolute)" << endl;
+	out << std::fixed;
+	return out;
+}
+
+TemporalConvergenceResult benchmarkTemporalConvergence(int width, int height, int pixelStride, int sampleBudget)
+{
+	TemporalConvergenceResult result = {};
+	result.sampleBudget = sampleBudget;
+
+	const SSSProfileTable profiles;
+	const SSSProfile& profile = profiles.getProfile(0);
+
+	// The same setup as the "benchmarkSequenceConvergence"
+	const float pixelsPerMm = 96.0f / profile.filterRadius;
+	const float worldScale = 0.5f * float(std::max(width, height)) / (1000.0f * pixelsPerMm);
+	const float2 pixelsPerUV(float(std::max(width, height)), float(std::max(width, height)));
+	const int pixelsPerSample = SSS_MIN_PIXELS_PER_SAMPLE;
+
+	vector<float2> uvs;
+	for (int y = pixelStride / 2; y < height; y += pixelStride)
+	{
+		for (int x = pixelStride / 2; x < width; x += pixelStride)
+		{
+			uvs.push_back(float2((float(x) + 0.5f) / pixelsPerUV.x, (float(y) + 0.5f) / pixelsPerUV.y));
+		}
+	}
+
+	vector<float3> reference(uvs.size());
+	{
+		const SequenceConvergenceSource source = { LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY, pixelsPerUV, 0U };
+		for (size_t i = 0; i < uvs.size(); ++i)
+		{
+			reference[i] = subsurface_scattering_disney_blur<SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT>(source, profile.scatteringDistance, profile.filterRadius, worldScale, pixelsPerSample, SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT, SSS_MIS_MODE_NONE, uvs[i]);
+		}
+	}
+
+	auto rmse = [&](const vector<float4>& values) -> double
+	{
+		double sumSquaredError = 0.0;
+		for (size_t i = 0; i < uvs.size(); ++i)
+		{
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				double error = double((&values[i].x)[channel]) - double((&reference[i].x)[channel]);
+				sumSquaredError += error * error;
+			}
+		}
+		return std::sqrt(sumSquaredError / double(3U * uvs.size()));
+	};
+
+	for (int budgetIndex = 0; budgetIndex < TEMPORAL_CONVERGENCE_BUDGET_COUNT; ++budgetIndex)
+	{
+		const int singleFrameSampleBudget = std::min(sampleBudget << budgetIndex, int(SSS_MAX_SAMPLE_BUDGET));
+		result.singleFrameSampleBudget[budgetIndex] = singleFrameSampleBudget;
+
+		const SequenceConvergenceSource source = { LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY, pixelsPerUV, 0U };
+		vector<float4> radiance(uvs.size());
+		for (size_t i = 0; i < uvs.size(); ++i)
+		{
+			const float3 value = subsurface_scattering_disney_blur(source, profile.scatteringDistance, profile.filterRadius, worldScale, pixelsPerSample, singleFrameSampleBudget, SSS_MIS_MODE_NONE, uvs[i]);
+			radiance[i] = float4(value.x, value.y, value.z, 1.0f);
+		}
+		result.singleFrameRmse[budgetIndex] = rmse(radiance);
+	}
+
+	for (int rotated = 0; rotated < 2; ++rotated)
+	{
+		// The history of each pixel (the head is still, s.t. the history is always accepted at the same pixel)
+		vector<float4> history(uvs.size());
+		int frameIndex = 0;
+		for (int frameCountIndex = 0; frameCountIndex < TEMPORAL_CONVERGENCE_FRAME_COUNT; ++frameCountIndex)
+		{
+			const int frameCount = (1 << frameCountIndex);
+			result.frameCount[frameCountIndex] = frameCount;
+
+			for (; frameIndex < frameCount; ++frameIndex)
+			{
+				const SequenceConvergenceSource source = { LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY, pixelsPerUV, (0 != rotated) ? uint32_t(frameIndex) : 0U };
+				for (size_t i = 0; i < uvs.size(); ++i)
+				{
+					const float3 current = subsurface_scattering_disney_blur(source, profile.scatteringDistance, profile.filterRadius, worldScale, pixelsPerSample, sampleBudget, SSS_MIS_MODE_NONE, uvs[i]);
+					history[i] = subsurface_scattering_temporal_accumulate(current, history[i], SSS_TEMPORAL_DEFAULT_BLEND);
+				}
+			}
+
+			((0 != rotated) ? result.accumulatedRmse : result.notRotatedRmse)[frameCountIndex] = rmse(history);
+		}
+	}
+
+	result.passed = true;
+	for (int frameCountIndex = 1; frameCountIndex < TEMPORAL_CONVERGENCE_FRAME_COUNT; ++frameCountIndex)
+	{
+		result.passed = result.passed && (result.accumulatedRmse[frameCountIndex] <= result.accumulatedRmse[frameCountIndex - 1]);
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const TemporalConvergenceResult& result)
+{
+	out << "Temporal Convergence (RMSE against " << SEQUENCE_CONVERGENCE_REFERENCE_SAMPLE_COUNT << " samples, " << result.sampleBudget << " samples per frame, blend " << SSS_TEMPORAL_DEFAULT_BLEND << ")" << endl;
+	out << std::scientific << setprecision(2);
+	for (int budgetIndex = 0; budgetIndex < TEMPORAL_CONVERGENCE_BUDGET_COUNT; ++budgetIndex)
+	{
+		out << "  single frame " << setw(2) << result.singleFrameSampleBudget[budgetIndex] << " samples: " << result.singleFrameRmse[budgetIndex] << endl;
+	}
+	for (int frameCountIndex = 0; frameCountIndex < TEMPORAL_CONVERGENCE_FRAME_COUNT; ++frameCountIndex)
+	{
+		out << "  " << setw(2) << result.frameCount[frameCountIndex] << " frames: rotated " << result.accumulatedRmse[frameCountIndex] << ", NOT rotated " << result.notRotatedRmse[frameCountIndex] << endl;
+	}
+	out << "  " << (result.passed ? "PASSED" : "FAILED (the error increases with the frames)") << endl;
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,331 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+#include "SSSCurvatureMap.h"
+
+using namespace std;
+
+// The bilinear fetch of the atlas (the same as the "LinearSampler" with the clamp)
+static float3 textureSpaceSample(const vector<float4>& atlas, int size, float2 texcoord)
+{
+	const float x = std::min(std::max(texcoord.x * float(size) - 0.5f, 0.0f), float(size - 1));
+	const float y = std::min(std::max(texcoord.y * float(size) - 0.5f, 0.0f), float(size - 1));
+	const int x0 = static_cast<int>(x);
+	const int y0 = static_cast<int>(y);
+	const int x1 = std::min(x0 + 1, size - 1);
+	const int y1 = std::min(y0 + 1, size - 1);
+	const float fx = x - float(x0);
+	const float fy = y - float(y0);
+
+	const float4& t00 = atlas[static_cast<size_t>(y0) * static_cast<size_t>(size) + static_cast<size_t>(x0)];
+	const float4& t01 = atlas[static_cast<size_t>(y0) * static_cast<size_t>(size) + static_cast<size_t>(x1)];
+	const float4& t10 = atlas[static_cast<size_t>(y1) * static_cast<size_t>(size) + static_cast<size_t>(x0)];
+	const float4& t11 = atlas[static_cast<size_t>(y1) * static_cast<size_t>(size) + static_cast<size_t>(x1)];
+	const float3 top = lerp(float3(t00.x, t00.y, t00.z), float3(t01.x, t01.y, t01.z), fx);
+	const float3 bottom = lerp(float3(t10.x, t10.y, t10.z), float3(t11.x, t11.y, t11.z), fx);
+	return lerp(top, bottom, fy);
+}
+
+// The relighting of the CPU path: "saturate(N.L)" of each texel with the coverage of the rasterization (the dilated texels are NOT lit)
+static void textureSpaceRelight(const SSSTextureSpaceGeometry& geometry, float3 light, vector<float4>& irradiance)
+{
+	const size_t texelCount = static_cast<size_t>(geometry.getSize()) * static_cast<size_t>(geometry.getSize());
+	irradiance.resize(texelCount);
+	for (size_t texelIndex = 0U; texelIndex < texelCount; ++texelIndex)
+	{
+		const float4& normal = geometry.getNormals()[texelIndex];
+		const float ndotl = (normal.w > 0.0f) ? saturate(dot(float3(normal.x, normal.y, normal.z), light)) : 0.0f;
+		irradiance[texelIndex] = float4(ndotl, ndotl, ndotl, normal.w);
+	}
+}
+
+// The key of the head in the sequence of the "benchmarkTextureSpaceCache": the version of the light and the transform of the head (the camera is NOT in the key)
+static uint64_t textureSpaceBenchmarkKey(int frameIndex, int headIndex)
+{
+	const int lightVersion = frameIndex / 16;
+	// The head 5 moves from the frame 32 to the frame 35 (visible from the frame 32 to the frame 39)
+	const int transformVersion = (5 == headIndex) ? std::min(std::max(frameIndex - 31, 0), 4) : 0;
+	const int state[3] = { lightVersion, headIndex, transformVersion };
+	return subsurface_scattering_texture_space_hash(state, sizeof(state));
+}
+
+TextureSpaceBenchmarkResult benchmarkTextureSpaceCache(int width, int height, int repetitionCount)
+{
+	TextureSpaceBenchmarkResult result = {};
+	result.hardwareConcurrency = static_cast<int>(std::thread::hardware_concurrency());
+
+	const SSSProfileTable profiles;
+	const SSSProfile& profile = profiles.getProfile(0);
+	const float sphereRadius = TEXTURE_SPACE_BENCHMARK_SPHERE_RADIUS;
+	const int size = SSS_TEXTURE_SPACE_DEFAULT_SIZE;
+	const size_t texelCount = static_cast<size_t>(size) * static_cast<size_t>(size);
+
+	vector<PreintegratedBenchmarkVertex> vertices;
+	vector<uint32_t> indices;
+	const SSSCurvatureMesh mesh = preintegratedSphereMesh(sphereRadius, vertices, indices);
+
+	// The directional light (in the view space, the same as the object space of the sphere) of which the terminator is visible
+	const float3 light = float3(1.0f, 0.25f, -0.5f) * (1.0f / std::sqrt(1.0f + 0.0625f + 0.25f));
+
+	// One thread is the reference of the other thread counts
+	SSSTextureSpaceGeometry geometry(size, 1);
+	geometry.rasterize(&mesh, 1);
+	vector<float4> irradiance;
+	textureSpaceRelight(geometry, light, irradiance);
+	vector<float4> diffused(texelCount);
+	SSSTextureSpaceDiffusion(SSS_TEXTURE_SPACE_DEFAULT_SAMPLE_COUNT, 1).go(geometry, irradiance.data(), profile, diffused.data());
+
+	result.deterministic = true;
+	for (int threadCountIndex = 0; threadCountIndex < TEXTURE_SPACE_BENCHMARK_THREAD_COUNT_COUNT; ++threadCountIndex)
+	{
+		const int threadCount = 1 << threadCountIndex;
+		result.threadCount[threadCountIndex] = threadCount;
+
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			SSSTextureSpaceGeometry timedGeometry(size, threadCount);
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			timedGeometry.rasterize(&mesh, 1);
+			result.rasterizeMilliseconds[threadCountIndex] += 1000.0 * elapsedSeconds(begin) / double(std::max(1, repetitionCount));
+
+			vector<float4> timedIrradiance;
+			vector<float4> timedDiffused(texelCount);
+			const SSSTextureSpaceDiffusion diffusion(SSS_TEXTURE_SPACE_DEFAULT_SAMPLE_COUNT, threadCount);
+			begin = chrono::steady_clock::now();
+			textureSpaceRelight(timedGeometry, light, timedIrradiance);
+			diffusion.go(timedGeometry, timedIrradiance.data(), profile, timedDiffused.data());
+			result.diffuseMilliseconds[threadCountIndex] += 1000.0 * elapsedSeconds(begin) / double(std::max(1, repetitionCount));
+
+			result.deterministic = result.deterministic && std::equal(&geometry.getPositions()->x, &geometry.getPositions()->x + texelCount * 4U, &timedGeometry.getPositions()->x);
+			result.deterministic = result.deterministic && std::equal(&geometry.getStretch()->x, &geometry.getStretch()->x + texelCount * 2U, &timedGeometry.getStretch()->x);
+			result.deterministic = result.deterministic && std::equal(&geometry.getNormals()->x, &geometry.getNormals()->x + texelCount * 4U, &timedGeometry.getNormals()->x);
+			result.deterministic = result.deterministic && std::equal(&diffused[0].x, &diffused[0].x + texelCount * 4U, &timedDiffused[0].x);
+		}
+	}
+
+	// The length of the meridian is "PI * radius" (the chords of the stacks are shorter by less than 0.01%)
+	const float exactStretch = float(PI) * sphereRadius / float(size);
+	result.coveredTexelCount = geometry.getCoveredTexelCount();
+	for (size_t texelIndex = 0U; texelIndex < texelCount; ++texelIndex)
+	{
+		if (geometry.getNormals()[texelIndex].w > 0.0f)
+		{
+			result.maxStretchError = std::max(result.maxStretchError, std::abs(double(geometry.getStretch()[texelIndex].y) / double(exactStretch) - 1.0));
+		}
+	}
+
+	// Projection (row major, SV_POSITION.z = (proj[2][2] * z + proj[3][2]) / z), the same as the "multiProfileScene"
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+	const float yScale = 1.0f / std::tan(0.5f * (20.0f * float(PI) / 180.0f));
+	float4x4 currProj = {};
+	currProj.m[0][0] = yScale * float(height) / float(width);
+	currProj.m[1][1] = yScale;
+	currProj.m[2][2] = farPlane / (farPlane - nearPlane);
+	currProj.m[2][3] = 1.0f;
+	currProj.m[3][2] = -nearPlane * farPlane / (farPlane - nearPlane);
+
+	result.passed = result.deterministic && (result.maxStretchError < 1.0e-2);
+
+	for (int distanceIndex = 0; distanceIndex < TEXTURE_SPACE_BENCHMARK_DISTANCE_COUNT; ++distanceIndex)
+	{
+		// 128, 64 and 32
+		const int radiusInPixels = 128 >> distanceIndex;
+		result.radiusInPixels[distanceIndex] = radiusInPixels;
+		const float centerZ = sphereRadius * yScale * (0.5f * float(height)) / float(radiusInPixels);
+
+		ImageRGBA32F irradianceRT(width, height);
+		ImageR32F depthRT(width, height);
+		ImageR8U stencil(width, height);
+		ImageRGBA32F albedoRT(width, height);
+
+		// (N.L, texcoord) of the covered pixels (y * width + x), in the order of the pixels
+		vector<int> pixels;
+		vector<float> ndotls;
+		vector<float2> texcoords;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				// The primary ray through the pixel (the view space, the camera at the origin)
+				const float u = (float(x) + 0.5f) / float(width) * 2.0f - 1.0f;
+				const float v = (float(y) + 0.5f) / float(height) * 2.0f - 1.0f;
+				const float3 direction(u / currProj.m[0][0], v / currProj.m[1][1], 1.0f);
+
+				// |t * direction - center|^2 = radius^2
+				const float a = dot(direction, direction);
+				const float b = -2.0f * direction.z * centerZ;
+				const float c = centerZ * centerZ - sphereRadius * sphereRadius;
+				const float discriminant = b * b - 4.0f * a * c;
+				if (discriminant < 0.0f)
+				{
+					continue;
+				}
+
+				const float t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+				const float3 position = direction * t;
+				const float3 normal = (position - float3(0.0f, 0.0f, centerZ)) * (1.0f / sphereRadius);
+				const float ndotl = dot(normal, light);
+
+				depthRT(x, y)[0] = (currProj.m[2][2] * position.z + currProj.m[3][2]) / position.z;
+				stencil(x, y)[0] = subsurface_scattering_profile_stencil_ref(0);
+
+				// The white albedo, s.t. the blur outputs the blurred irradiance (both the pre-scatter and the post-scatter are 1)
+				float* albedo = albedoRT(x, y);
+				albedo[0] = 1.0f;
+				albedo[1] = 1.0f;
+				albedo[2] = 1.0f;
+				albedo[3] = 1.0f;
+
+				float* pixelIrradiance = irradianceRT(x, y);
+				pixelIrradiance[0] = saturate(ndotl);
+				pixelIrradiance[1] = saturate(ndotl);
+				pixelIrradiance[2] = saturate(ndotl);
+
+				pixels.push_back(y * width + x);
+				ndotls.push_back(ndotl);
+				texcoords.push_back(preintegratedSphereTexcoord(normal));
+			}
+		}
+		const int pixelCount = static_cast<int>(pixels.size());
+		result.pixelCount[distanceIndex] = pixelCount;
+
+		SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+		ImageRGBA32F blurredRT(width, height);
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			std::fill(blurredRT.getData(), blurredRT.getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			blur.go(blurredRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+			result.blurMilliseconds[distanceIndex] += 1000.0 * elapsedSeconds(begin) / double(std::max(1, repetitionCount));
+		}
+
+		// The same as the "RenderPS": the atlas is sampled by the texture coordinates
+		vector<float3> shaded(pixelCount);
+		for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+		{
+			chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+			for (int i = 0; i < pixelCount; ++i)
+			{
+				shaded[i] = textureSpaceSample(diffused, size, texcoords[i]);
+			}
+			result.lookupMilliseconds[distanceIndex] += 1000.0 * elapsedSeconds(begin) / double(std::max(1, repetitionCount));
+		}
+
+		double sumSquaredError[2] = { 0.0, 0.0 };
+		for (int i = 0; i < pixelCount; ++i)
+		{
+			const float* blurred = blurredRT(pixels[i] % width, pixels[i] / width);
+			const double target = 0.2126 * double(blurred[0]) + 0.7152 * double(blurred[1]) + 0.0722 * double(blurred[2]);
+			const double lambertError = double(saturate(ndotls[i])) - target;
+			const double atlasError = 0.2126 * double(shaded[i].x) + 0.7152 * double(shaded[i].y) + 0.0722 * double(shaded[i].z) - target;
+			sumSquaredError[0] += lambertError * lambertError;
+			sumSquaredError[1] += atlasError * atlasError;
+		}
+		result.rmse[distanceIndex][0] = std::sqrt(sumSquaredError[0] / double(std::max(1, pixelCount)));
+		result.rmse[distanceIndex][1] = std::sqrt(sumSquaredError[1] / double(std::max(1, pixelCount)));
+
+		result.passed = result.passed && (pixelCount > 0) && (result.rmse[distanceIndex][1] < result.rmse[distanceIndex][0]);
+	}
+
+	// The expected misses: the first frame of each head and the frames of which the key of the head changes since its last visible frame
+	{
+		uint64_t lastKey[TEXTURE_SPACE_BENCHMARK_HEAD_COUNT] = {};
+		bool seen[TEXTURE_SPACE_BENCHMARK_HEAD_COUNT] = {};
+		for (int frameIndex = 0; frameIndex < TEXTURE_SPACE_BENCHMARK_FRAME_COUNT; ++frameIndex)
+		{
+			for (int visibleIndex = 0; visibleIndex < TEXTURE_SPACE_BENCHMARK_VISIBLE_HEAD_COUNT; ++visibleIndex)
+			{
+				const int headIndex = (frameIndex / 8 + visibleIndex) % TEXTURE_SPACE_BENCHMARK_HEAD_COUNT;
+				const uint64_t key = textureSpaceBenchmarkKey(frameIndex, headIndex);
+				result.expectedMissCount += (!seen[headIndex] || (lastKey[headIndex] != key)) ? 1U : 0U;
+				seen[headIndex] = true;
+				lastKey[headIndex] = key;
+			}
+		}
+	}
+
+	for (int budgetIndex = 0; budgetIndex < TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT; ++budgetIndex)
+	{
+		// 1, 2, 4 and 8 slots
+		const int budgetSlotCount = 1 << budgetIndex;
+		const size_t memoryBudget = static_cast<size_t>(budgetSlotCount) * texelCount * SSS_TEXTURE_SPACE_BYTES_PER_TEXEL;
+		SSSTextureSpaceCache cache(size, memoryBudget, TEXTURE_SPACE_BENCHMARK_HEAD_COUNT);
+		result.slotCount[budgetIndex] = cache.getSlotCount();
+		result.memoryBudget[budgetIndex] = cache.getMemoryBudget();
+
+		for (int frameIndex = 0; frameIndex < TEXTURE_SPACE_BENCHMARK_FRAME_COUNT; ++frameIndex)
+		{
+			cache.beginFrame();
+			for (int visibleIndex = 0; visibleIndex < TEXTURE_SPACE_BENCHMARK_VISIBLE_HEAD_COUNT; ++visibleIndex)
+			{
+				const int headIndex = (frameIndex / 8 + visibleIndex) % TEXTURE_SPACE_BENCHMARK_HEAD_COUNT;
+				bool dirty = false;
+				cache.acquire(headIndex, textureSpaceBenchmarkKey(frameIndex, headIndex), dirty);
+			}
+			result.maxMemoryUsage[budgetIndex] = std::max(result.maxMemoryUsage[budgetIndex], cache.getMemoryUsage());
+		}
+
+		result.hitCount[budgetIndex] = cache.getHitCount();
+		result.missCount[budgetIndex] = cache.getMissCount();
+		result.evictionCount[budgetIndex] = cache.getEvictionCount();
+		result.fallbackCount[budgetIndex] = cache.getFallbackCount();
+
+		const uint64_t acquireCount = uint64_t(TEXTURE_SPACE_BENCHMARK_FRAME_COUNT) * uint64_t(TEXTURE_SPACE_BENCHMARK_VISIBLE_HEAD_COUNT);
+		result.passed = result.passed && (result.slotCount[budgetIndex] == budgetSlotCount) && (result.maxMemoryUsage[budgetIndex] <= memoryBudget);
+		result.passed = result.passed && ((result.hitCount[budgetIndex] + result.missCount[budgetIndex] + result.fallbackCount[budgetIndex]) == acquireCount);
+		result.passed = result.passed && ((budgetSlotCount < TEXTURE_SPACE_BENCHMARK_VISIBLE_HEAD_COUNT) || (0U == result.fallbackCount[budgetIndex]));
+		result.passed = result.passed && ((budgetSlotCount < TEXTURE_SPACE_BENCHMARK_HEAD_COUNT) || ((result.missCount[budgetIndex] == result.expectedMissCount) && (0U == result.evictionCount[budgetIndex])));
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const TextureSpaceBenchmarkResult& result)
+{
+	out << "Texture Space Diffusion (" << SSS_TEXTURE_SPACE_DEFAULT_SIZE << " x " << SSS_TEXTURE_SPACE_DEFAULT_SIZE << ", " << SSS_TEXTURE_SPACE_DEFAULT_SAMPLE_COUNT << " samples, hardware concurrency " << result.hardwareConcurrency << ")" << endl;
+	out << std::fixed << setprecision(2);
+	for (int threadCountIndex = 0; threadCountIndex < TEXTURE_SPACE_BENCHMARK_THREAD_COUNT_COUNT; ++threadCountIndex)
+	{
+		out << "  " << setw(2) << result.threadCount[threadCountIndex] << " threads: rasterize " << setw(8) << result.rasterizeMilliseconds[threadCountIndex] << " ms (x" << (result.rasterizeMilliseconds[0] / result.rasterizeMilliseconds[threadCountIndex]) << "), ";
+		out << "relight + diffuse " << setw(8) << result.diffuseMilliseconds[threadCountIndex] << " ms (x" << (result.diffuseMilliseconds[0] / result.diffuseMilliseconds[threadCountIndex]) << ")" << endl;
+	}
+	out << "  deterministic: " << (result.deterministic ? "yes" : "no") << ", " << result.coveredTexelCount << " covered texels" << endl;
+	out << std::scientific << "  stretch error (relative): " << result.maxStretchError << std::fixed << endl;
+	for (int distanceIndex = 0; distanceIndex < TEXTURE_SPACE_BENCHMARK_DISTANCE_COUNT; ++distanceIndex)
+	{
+		out << "  radius " << setw(3) << result.radiusInPixels[distanceIndex] << " pixels (" << setw(6) << result.pixelCount[distanceIndex] << " pixels): blur " << setw(8) << result.blurMilliseconds[distanceIndex] << " ms, atlas " << setw(6) << result.lookupMilliseconds[distanceIndex] << " ms (x" << setprecision(0) << (result.blurMilliseconds[distanceIndex] / result.lookupMilliseconds[distanceIndex]) << setprecision(2) << "), ";
+		out << std::scientific << "rmse N.L " << result.rmse[distanceIndex][0] << ", atlas " << result.rmse[distanceIndex][1] << std::fixed << endl;
+	}
+	for (int budgetIndex = 0; budgetIndex < TEXTURE_SPACE_BENCHMARK_BUDGET_COUNT; ++budgetIndex)
+	{
+		const uint64_t acquireCount = result.hitCount[budgetIndex] + result.missCount[budgetIndex] + result.fallbackCount[budgetIndex];
+		out << "  " << result.slotCount[budgetIndex] << " slots (" << setw(5) << (result.memoryBudget[budgetIndex] / 1024U) << " KB, max usage " << setw(5) << (result.maxMemoryUsage[budgetIndex] / 1024U) << " KB): ";
+		out << "hits " << setw(3) << result.hitCount[budgetIndex] << " (" << setw(6) << (100.0 * double(result.hitCount[budgetIndex]) / double(std::max(acquireCount, uint64_t(1U)))) << "%), misses " << setw(3) << result.missCount[budgetIndex] << ", evictions " << setw(3) << result.evictionCount[budgetIndex] << ", fallbacks " << setw(3) << result.fallbackCount[budgetIndex] << endl;
+	}
+	out << "  expected misses: " << result.expectedMissCount << endl;
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	return out;
+}
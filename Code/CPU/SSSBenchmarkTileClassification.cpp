@@ -0,0 +1,119 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <limits>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+TileClassificationBenchmarkResult benchmarkTileClassification(int width, int height, int repetitionCount)
+{
+	TileClassificationBenchmarkResult result = {};
+
+	// The full screen (the sphere covers the corners), the default sphere of the "verifyMultiProfile" and a head of 10% of the screen
+	const float aspect = float(width) / float(height);
+	const float sphereRadius[TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT] = {
+		std::sqrt(aspect * aspect + 1.0f) + 0.01f,
+		0.70710678118654752440f,
+		std::sqrt(0.4f * aspect / float(PI)) };
+
+	SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE, 1);
+
+	result.passed = true;
+	for (int coverageIndex = 0; coverageIndex < TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT; ++coverageIndex)
+	{
+		SSSProfileTable profiles;
+		float4x4 currProj;
+		ImageRGBA32F irradianceRT(width, height);
+		ImageR32F depthRT(width, height);
+		ImageR8U stencil(width, height);
+		ImageRGBA32F albedoRT(width, height);
+		multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT, sphereRadius[coverageIndex]);
+
+		int pixelCount = 0;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				pixelCount += (0U != stencil(x, y)[0]) ? 1 : 0;
+			}
+		}
+		result.coverage[coverageIndex] = double(pixelCount) / double(width * height);
+
+		// [0] without the classification, [1] with the classification
+		// The repetitions of the two paths are interleaved and the fastest repetition of each path is reported, s.t. the drift of the clock of the CPU affects both paths the same
+		ImageRGBA32F mainRT[2] = { ImageRGBA32F(width, height), ImageRGBA32F(width, height) };
+		double minSeconds[2] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+		for (int repetitionIndex = 0; repetitionIndex < std::max(1, repetitionCount); ++repetitionIndex)
+		{
+			for (int classificationIndex = 0; classificationIndex < 2; ++classificationIndex)
+			{
+				blur.setTileClassificationEnabled(0 != classificationIndex);
+
+				std::fill(mainRT[classificationIndex].getData(), mainRT[classificationIndex].getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+				chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+				blur.go(mainRT[classificationIndex], irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+				minSeconds[classificationIndex] = std::min(minSeconds[classificationIndex], elapsedSeconds(begin));
+			}
+		}
+		result.millisecondsPerFrame[coverageIndex][0] = 1000.0 * minSeconds[0];
+		result.millisecondsPerFrame[coverageIndex][1] = 1000.0 * minSeconds[1];
+
+		result.emptyTileCount[coverageIndex] = blur.getTileCount(SSS_TILE_CLASS_EMPTY);
+		result.interiorTileCount[coverageIndex] = blur.getTileCount(SSS_TILE_CLASS_INTERIOR);
+		result.edgeTileCount[coverageIndex] = blur.getTileCount(SSS_TILE_CLASS_EDGE);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				for (int channel = 0; channel < 4; ++channel)
+				{
+					result.maxAbsoluteError[coverageIndex] = std::max(result.maxAbsoluteError[coverageIndex], double(std::abs(mainRT[1](x, y)[channel] - mainRT[0](x, y)[channel])));
+				}
+			}
+		}
+
+		// The classification should NOT be slower unless the whole screen is covered
+		const bool fullScreen = (pixelCount == width * height);
+		result.passed = result.passed && (result.maxAbsoluteError[coverageIndex] == 0.0) && (fullScreen || (result.millisecondsPerFrame[coverageIndex][1] <= result.millisecondsPerFrame[coverageIndex][0]));
+	}
+	blur.setTileClassificationEnabled(true);
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const TileClassificationBenchmarkResult& result)
+{
+	out << "Tile Classification (" << SSS_TILE_SIZE << "x" << SSS_TILE_SIZE << " tiles, cost per frame without / with the classification)" << endl;
+	for (int coverageIndex = 0; coverageIndex < TILE_CLASSIFICATION_BENCHMARK_COVERAGE_COUNT; ++coverageIndex)
+	{
+		out << "  " << std::fixed << setprecision(1) << setw(5) << (100.0 * result.coverage[coverageIndex]) << "% coverage: ";
+		out << setprecision(2) << setw(8) << result.millisecondsPerFrame[coverageIndex][0] << " ms / " << setw(8) << result.millisecondsPerFrame[coverageIndex][1] << " ms";
+		out << " (" << setprecision(1) << setw(5) << (100.0 * result.millisecondsPerFrame[coverageIndex][1] / result.millisecondsPerFrame[0][1]) << "% of the full screen)";
+		out << ", tiles " << result.emptyTileCount[coverageIndex] << " empty / " << result.interiorTileCount[coverageIndex] << " interior / " << result.edgeTileCount[coverageIndex] << " edge";
+		out << std::scientific << setprecision(2) << ", max error " << result.maxAbsoluteError[coverageIndex] << endl;
+	}
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	out << std::fixed;
+	return out;
+}
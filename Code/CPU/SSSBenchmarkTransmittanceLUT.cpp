@@ -0,0 +1,120 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+#include "SSSBenchmarkInternal.h"
+#include "SSSTransmittanceLUT.h"
+
+using namespace std;
+
+static double referenceTransmittance(double S, double thickness)
+{
+	double exp_13 = std::exp(-S * thickness / 3.0);
+	return 0.25 * (exp_13 * exp_13 * exp_13 + 3.0 * exp_13);
+}
+
+TransmittanceLUTBenchmarkResult benchmarkTransmittanceLUT(int sampleCount, int repetitionCount)
+{
+	TransmittanceLUTBenchmarkResult result = {};
+
+	// The default profile of the HUD (the tint is the same as the scattering distance)
+	const SSSProfileTable profiles;
+	const SSSProfile& profile = profiles.getProfile(0);
+
+	// NOTE: the thickness values are shuffled by the radical inverse, s.t. the branch of the "maxThickness" is NOT trivially predictable
+	vector<float> thickness(sampleCount);
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		thickness[i] = SSS_TRANSMITTANCE_LUT_EXTENDED_MAX_THICKNESS * hammersley_2d(uint32_t(i), uint32_t(sampleCount)).y;
+	}
+
+	vector<float3> transmittance(sampleCount);
+
+	volatile float checksum = 0.0f;
+
+	{
+		auto begin = chrono::steady_clock::now();
+		for (int repetition = 0; repetition < repetitionCount; ++repetition)
+		{
+			for (int i = 0; i < sampleCount; ++i)
+			{
+				transmittance[i] = profile.transmittanceTint * subsurface_scattering_disney_transmittance(profile.scatteringDistance, thickness[i]);
+			}
+			checksum = checksum + transmittance[repetition % sampleCount].x;
+		}
+		result.analyticSamplesPerSecond = double(sampleCount) * double(repetitionCount) / elapsedSeconds(begin);
+	}
+
+	for (int sizeIndex = 0; sizeIndex < TRANSMITTANCE_LUT_BENCHMARK_SIZE_COUNT; ++sizeIndex)
+	{
+		const int lutSize = (16 << sizeIndex);
+		result.lutSize[sizeIndex] = lutSize;
+
+		for (int rangeIndex = 0; rangeIndex < 2; ++rangeIndex)
+		{
+			SSSTransmittanceLUT lut(lutSize, (0 == rangeIndex) ? SSS_TRANSMITTANCE_LUT_MAX_THICKNESS : SSS_TRANSMITTANCE_LUT_EXTENDED_MAX_THICKNESS);
+			lut.update(profiles);
+
+			auto begin = chrono::steady_clock::now();
+			for (int repetition = 0; repetition < repetitionCount; ++repetition)
+			{
+				for (int i = 0; i < sampleCount; ++i)
+				{
+					transmittance[i] = lut.evaluate(profiles, 0, thickness[i]);
+				}
+				checksum = checksum + transmittance[repetition % sampleCount].x;
+			}
+			result.samplesPerSecond[sizeIndex][rangeIndex] = double(sampleCount) * double(repetitionCount) / elapsedSeconds(begin);
+
+			for (int i = 0; i < sampleCount; ++i)
+			{
+				float t = SSS_TRANSMITTANCE_LUT_EXTENDED_MAX_THICKNESS * (float(i) + 0.5f) / float(sampleCount);
+				float3 value = lut.evaluate(profiles, 0, t);
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					double reference = double((&profile.transmittanceTint.x)[channel]) * referenceTransmittance((&profile.scatteringDistance.x)[channel], t);
+					double error = std::abs(double((&value.x)[channel]) - reference);
+					result.maxAbsoluteError[sizeIndex][rangeIndex] = std::max(result.maxAbsoluteError[sizeIndex][rangeIndex], error);
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const TransmittanceLUTBenchmarkResult& result)
+{
+	out << "Transmittance LUT (max thickness " << SSS_TRANSMITTANCE_LUT_MAX_THICKNESS << " / " << SSS_TRANSMITTANCE_LUT_EXTENDED_MAX_THICKNESS << " mm)" << endl;
+	out << setprecision(3) << std::fixed;
+	out << "  analytic: " << (result.analyticSamplesPerSecond / 1.0e6) << " M samples/s/core" << endl;
+	for (int sizeIndex = 0; sizeIndex < TRANSMITTANCE_LUT_BENCHMARK_SIZE_COUNT; ++sizeIndex)
+	{
+		for (int rangeIndex = 0; rangeIndex < 2; ++rangeIndex)
+		{
+			out << "  " << setw(4) << result.lutSize[sizeIndex] << ((0 == rangeIndex) ? " default : " : " extended: ");
+			out << std::fixed << setprecision(3) << (result.samplesPerSecond[sizeIndex][rangeIndex] / 1.0e6) << " M samples/s/core (x" << (result.samplesPerSecond[sizeIndex][rangeIndex] / result.analyticSamplesPerSecond) << ")";
+			out << std::scientific << setprecision(2) << ", max error " << result.maxAbsoluteError[sizeIndex][rangeIndex] << " (absolute)" << endl;
+		}
+	}
+	out << std::fixed;
+	return out;
+}
@@ -0,0 +1,135 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <thread>
+#include "SSSBenchmarkInternal.h"
+
+using namespace std;
+
+WorkStealingBenchmarkResult benchmarkWorkStealing(int width, int height, int repetitionCount)
+{
+	WorkStealingBenchmarkResult result = {};
+	result.hardwareConcurrency = static_cast<int>(std::thread::hardware_concurrency());
+
+	SSSProfileTable profiles;
+	float4x4 currProj;
+	ImageRGBA32F irradianceRT(width, height);
+	ImageR32F depthRT(width, height);
+	ImageR8U stencil(width, height);
+	ImageRGBA32F albedoRT(width, height);
+	multiProfileScene(width, height, profiles, currProj, irradianceRT, depthRT, stencil, albedoRT, std::sqrt(0.4f * (float(width) / float(height)) / float(PI)));
+
+	int pixelCount = 0;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			pixelCount += (0U != stencil(x, y)[0]) ? 1 : 0;
+		}
+	}
+	result.coverage = double(pixelCount) / double(width * height);
+
+	SSSBlurCPU blur(false, SSS_MAX_SAMPLE_BUDGET, SSS_MIN_PIXELS_PER_SAMPLE);
+
+	ImageRGBA32F referenceRT(width, height);
+	ImageRGBA32F mainRT(width, height);
+
+	// Warm up (NOT timed): the kernel cache and the first pass over the images in the order of each scheduler
+	for (int schedulerIndex = 0; schedulerIndex < 2; ++schedulerIndex)
+	{
+		blur.setWorkStealingEnabled(0 != schedulerIndex);
+		blur.go(mainRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+	}
+
+	result.passed = true;
+	for (int threadCountIndex = 0; threadCountIndex < WORK_STEALING_BENCHMARK_THREAD_COUNT_COUNT; ++threadCountIndex)
+	{
+		const int threadCount = 1 << threadCountIndex;
+		result.threadCount[threadCountIndex] = threadCount;
+		blur.setThreadCount(threadCount);
+
+		// [0] the shared queue, [1] the work stealing
+		for (int schedulerIndex = 0; schedulerIndex < 2; ++schedulerIndex)
+		{
+			blur.setWorkStealingEnabled(0 != schedulerIndex);
+
+			ImageRGBA32F& targetRT = ((0 == threadCountIndex) && (0 == schedulerIndex)) ? referenceRT : mainRT;
+			double seconds = 0.0;
+			for (int repetitionIndex = 0; repetitionIndex < repetitionCount; ++repetitionIndex)
+			{
+				std::fill(targetRT.getData(), targetRT.getData() + static_cast<size_t>(width) * static_cast<size_t>(height) * 4U, 0.0f);
+				chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+				blur.go(targetRT, irradianceRT, depthRT, &stencil, albedoRT, currProj, profiles);
+				seconds += elapsedSeconds(begin);
+			}
+			result.millisecondsPerFrame[threadCountIndex][schedulerIndex] = 1000.0 * seconds / double(std::max(1, repetitionCount));
+
+			if (0 != schedulerIndex)
+			{
+				// The stats of the last repetition
+				double sumBusySeconds = 0.0;
+				double maxBusySeconds = 0.0;
+				for (int workerIndex = 0; workerIndex < blur.getWorkerCount(); ++workerIndex)
+				{
+					const SSSTileSchedulerWorkerStats& stats = blur.getWorkerStats(workerIndex);
+					result.stealCount[threadCountIndex] += stats.stealCount;
+					result.stolenTileCount[threadCountIndex] += stats.stolenTileCount;
+					sumBusySeconds += stats.busySeconds;
+					maxBusySeconds = std::max(maxBusySeconds, stats.busySeconds);
+				}
+				result.busyImbalance[threadCountIndex] = (sumBusySeconds > 0.0) ? (maxBusySeconds * double(blur.getWorkerCount()) / sumBusySeconds) : 1.0;
+			}
+
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					for (int channel = 0; channel < 4; ++channel)
+					{
+						result.maxAbsoluteError[threadCountIndex][schedulerIndex] = std::max(result.maxAbsoluteError[threadCountIndex][schedulerIndex], double(std::abs(targetRT(x, y)[channel] - referenceRT(x, y)[channel])));
+					}
+				}
+			}
+
+			result.passed = result.passed && (result.maxAbsoluteError[threadCountIndex][schedulerIndex] == 0.0);
+		}
+	}
+	blur.setWorkStealingEnabled(true);
+
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const WorkStealingBenchmarkResult& result)
+{
+	out << "Work Stealing (" << std::fixed << setprecision(1) << (100.0 * result.coverage) << "% coverage, " << result.hardwareConcurrency << " hardware threads, cost per frame and speedup with the shared queue / the work stealing)" << endl;
+	for (int threadCountIndex = 0; threadCountIndex < WORK_STEALING_BENCHMARK_THREAD_COUNT_COUNT; ++threadCountIndex)
+	{
+		out << "  " << setw(2) << result.threadCount[threadCountIndex] << " threads: ";
+		out << setprecision(2) << setw(8) << result.millisecondsPerFrame[threadCountIndex][0] << " ms (x" << setw(5) << (result.millisecondsPerFrame[0][0] / result.millisecondsPerFrame[threadCountIndex][0]) << ")";
+		out << " / " << setw(8) << result.millisecondsPerFrame[threadCountIndex][1] << " ms (x" << setw(5) << (result.millisecondsPerFrame[0][1] / result.millisecondsPerFrame[threadCountIndex][1]) << ")";
+		out << ", " << result.stealCount[threadCountIndex] << " steals of " << result.stolenTileCount[threadCountIndex] << " tiles";
+		out << ", busy imbalance " << setprecision(2) << result.busyImbalance[threadCountIndex];
+		out << std::scientific << setprecision(2) << ", max error " << result.maxAbsoluteError[threadCountIndex][0] << " / " << result.maxAbsoluteError[threadCountIndex][1] << std::fixed << endl;
+	}
+	out << "  " << (result.passed ? "PASSED" : "FAILED") << endl;
+	return out;
+}
@@ -0,0 +1,1605 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "SSSBlurCPU.h"
+#include "subsurface_scattering_texturing_mode.h"
+#include "subsurface_scattering_disney_blur.h"
+#include "subsurface_scattering_separable_blur.h"
+#include "subsurface_scattering_tile_classification.h"
+#include "SSSIrradiancePyramid.h"
+
+// The work item of the Burley blur is 2x2 tiles of the classification (see "subsurface_scattering_tile_classification.h")
+#define SSS_CPU_TILE_SIZE 32
+static_assert(0 == (SSS_CPU_TILE_SIZE % SSS_TILE_SIZE), "SSS_CPU_TILE_SIZE should be a multiple of SSS_TILE_SIZE");
+
+// The block of the coherent sampling (at most 256 pixels, since the pixel index is packed into the low 8 bits of the fetch list)
+#define SSS_CPU_COHERENT_BLOCK_SIZE 4
+
+#define SSS_CPU_BURLEY_PASS_BLUR 0
+#define SSS_CPU_BURLEY_PASS_PILOT 1
+#define SSS_CPU_BURLEY_PASS_REFINEMENT 2
+#define SSS_CPU_BURLEY_PASS_STOCHASTIC 3
+
+// The work item of the Burley blur
+struct SSSBlurCPUTile
+{
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+	// The predicted cost (see "Work Stealing") and the sample count bucket (-1 if none)
+	float cost;
+	int bucket;
+};
+
+// The analysis of each tile of the classification, s.t. the pixels of the tile are read by the classification and by the prediction of the cost while they are in the cache
+struct SSSBlurCPUTileAnalysis
+{
+	float cost;
+	float sumPredictedSampleCount;
+	int coveredPixelCount;
+	// The minimum budget of the covered pixels (see "subsurface_scattering_sample_budget_from_stencil")
+	int minSampleBudget;
+};
+
+// The counterpart of the "Shaders/Support/SSS_Blur.hlsli"
+struct SSSBlurCPUSource
+{
+	const ImageRGBA32F& irradianceRT;
+	const ImageR32F& depthRT;
+	const ImageRGBA32F& albedoRT;
+	const float4x4& currProj;
+	bool postscatterEnabled;
+	const DiffusionProfileInverseCdfLUT& inverseCdfLUT;
+	int inverseCdfMode;
+	const float3 scatteringDistance;
+	int sequence;
+	SSSKernelCache* kernelCache;
+	// NULL if the kernel cache is disabled
+	// Per worker thread, s.t. the (shared) kernel cache is only locked on the first use of each kernel
+	// [channel][center cdf bucket][sample count - 1], since the MIS draws the samples from the profile of each channel
+	std::shared_ptr<const SSSKernel>* localKernels;
+	const ImageR8U* stencil;
+	float2 sampleRotation;
+	// The Cranley-Patterson offset of the radius of the frame (see "subsurface_scattering_sample_radius_offset")
+	int sampleRadiusOffsetIndex;
+	// NULL if the mask pyramid is disabled
+	const std::vector<ImageRGBA32F>* maskPyramid;
+	// NULL if the irradiance pyramid is disabled
+	const SSSIrradiancePyramid* irradiancePyramid;
+	// NULL if the layout is IMAGE_LAYOUT_ROW_MAJOR
+	// (total_diffuse_reflectance_pre_scatter_multiply_form_factor, NDC depth), the albedo and the stencil (NULL if the "stencil" is NULL)
+	const SwizzledImageRGBA32F* swizzledIrradianceDepth;
+	const SwizzledImageRGBA32F* swizzledAlbedo;
+	const SwizzledImageR8U* swizzledStencil;
+
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const
+	{
+		const float* texel = (NULL != swizzledIrradianceDepth) ? swizzledIrradianceDepth->sampleLevelPoint(uv) : irradianceRT.sampleLevelPoint(uv);
+		return float3(texel[0], texel[1], texel[2]);
+	}
+
+	float3 total_diffuse_reflectance_post_scatter(float2 uv) const
+	{
+		const float* texel = (NULL != swizzledAlbedo) ? swizzledAlbedo->sampleLevelPoint(uv) : albedoRT.sampleLevelPoint(uv);
+		return subsurface_scattering_total_diffuse_reflectance_post_scatter_from_albedo(postscatterEnabled, float3(texel[0], texel[1], texel[2]));
+	}
+
+	float subsurface_mask(float2 uv) const
+	{
+		return ((NULL != swizzledAlbedo) ? swizzledAlbedo->sampleLevelPoint(uv) : albedoRT.sampleLevelPoint(uv))[3];
+	}
+
+	int subsurface_profile_index(float2 uv) const
+	{
+		if (NULL == stencil)
+		{
+			return 0;
+		}
+		return subsurface_scattering_profile_index_from_stencil(((NULL != swizzledStencil) ? swizzledStencil->sampleLevelPoint(uv) : stencil->sampleLevelPoint(uv))[0]);
+	}
+
+	float view_space_position_z(float2 uv) const
+	{
+		// ndcz_to_viewpositionz
+		float depth = (NULL != swizzledIrradianceDepth) ? swizzledIrradianceDepth->sampleLevelPoint(uv)[3] : depthRT.sampleLevelPoint(uv)[0];
+		return currProj.m[3][2] / (depth - currProj.m[2][2]);
+	}
+
+	float projection_x() const
+	{
+		return currProj.m[0][0];
+	}
+
+	float projection_y() const
+	{
+		return currProj.m[1][1];
+	}
+
+	float2 pixels_per_uv() const
+	{
+		return float2(float(irradianceRT.getWidth()), float(irradianceRT.getHeight()));
+	}
+
+	float diffusion_profile_sample_r(float d, float cdf) const
+	{
+		return inverseCdfLUT.sampleR(inverseCdfMode, d, cdf);
+	}
+
+	float center_sample_cdf(float center_sample_cdf) const
+	{
+		return (NULL != kernelCache) ? subsurface_scattering_kernel_cache_center_sample_cdf(center_sample_cdf) : center_sample_cdf;
+	}
+
+	float2 sample_sequence(int sample_count, int sample_index) const
+	{
+		return subsurface_scattering_sample_sequence_offset(low_discrepancy_sequence_2d(sequence, uint32_t(sample_index), uint32_t(sample_count)), subsurface_scattering_sample_radius_offset(sampleRadiusOffsetIndex), sample_count);
+	}
+
+	float2 sample_rotation() const
+	{
+		return sampleRotation;
+	}
+
+	int mask_pyramid_level_count() const
+	{
+		return (NULL != maskPyramid) ? static_cast<int>(maskPyramid->size()) : 0;
+	}
+
+	float4 mask_pyramid(int level, int x, int y) const
+	{
+		const float* texel = (*maskPyramid)[level](x, y);
+		return float4(texel[0], texel[1], texel[2], texel[3]);
+	}
+
+	int irradiance_pyramid_level_count() const
+	{
+		return (NULL != irradiancePyramid) ? irradiancePyramid->getLevelCount() : 0;
+	}
+
+	float4 irradiance_pyramid(int level, int x, int y) const
+	{
+		const float* texel = irradiancePyramid->getIrradiance(level)(x, y);
+		return float4(texel[0], texel[1], texel[2], texel[3]);
+	}
+
+	float irradiance_pyramid_view_space_position_z(int level, int x, int y) const
+	{
+		return irradiancePyramid->getViewSpacePositionZ(level)(x, y)[0];
+	}
+
+	float4 kernel_sample(float d, float center_sample_cdf, int sample_count, int sample_index) const
+	{
+		if (NULL == kernelCache)
+		{
+			return subsurface_scattering_disney_kernel_sample(*this, d, center_sample_cdf, sample_count, sample_index);
+		}
+
+		// NOTE: the "d" is exactly one of the channels of the "scatteringDistance" (see "subsurface_scattering_disney_blur")
+		const int channel = (d == scatteringDistance.x) ? 0 : ((d == scatteringDistance.y) ? 1 : 2);
+		const int center_cdf_bucket = subsurface_scattering_kernel_cache_center_cdf_bucket(center_sample_cdf);
+		std::shared_ptr<const SSSKernel>& kernel = localKernels[(channel * SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT + center_cdf_bucket) * SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT + (sample_count - 1)];
+		if (!kernel)
+		{
+			// NOTE: the kernel only depends on the "d" (the maximum of the scattering distance)
+			kernel = kernelCache->get(float3(d, d, d), sequence, sample_count, center_cdf_bucket, sampleRadiusOffsetIndex);
+		}
+		return kernel->samples[sample_index];
+	}
+};
+
+// The texturing mode of the "subsurface_scattering_disney_blur_estimate_bucket" is the template parameter
+template <bool POSTSCATTER_ENABLED>
+struct SSSBlurCPUBucketSource : public SSSBlurCPUSource
+{
+	explicit SSSBlurCPUBucketSource(const SSSBlurCPUSource& source) : SSSBlurCPUSource(source)
+	{
+	}
+
+	float3 total_diffuse_reflectance_post_scatter(float2 uv) const
+	{
+		const float* texel = (NULL != swizzledAlbedo) ? swizzledAlbedo->sampleLevelPoint(uv) : albedoRT.sampleLevelPoint(uv);
+		return subsurface_scattering_total_diffuse_reflectance_post_scatter_from_albedo(POSTSCATTER_ENABLED, float3(texel[0], texel[1], texel[2]));
+	}
+};
+
+template <bool POSTSCATTER_ENABLED>
+static subsurface_scattering_disney_blur_result burleyBucketEstimate(int bucket, const SSSBlurCPUSource& source, const SSSProfile& profile, float edgeFreeRadius, float2 center_uv)
+{
+	const SSSBlurCPUBucketSource<POSTSCATTER_ENABLED> bucketSource(source);
+	switch (bucket)
+	{
+	case 0:
+		return subsurface_scattering_disney_blur_estimate_bucket<SSS_SAMPLE_COUNT_BUCKET_SIZE_0>(bucketSource, profile.scatteringDistance, profile.filterRadius, profile.worldScale, edgeFreeRadius, center_uv);
+	case 1:
+		return subsurface_scattering_disney_blur_estimate_bucket<SSS_SAMPLE_COUNT_BUCKET_SIZE_1>(bucketSource, profile.scatteringDistance, profile.filterRadius, profile.worldScale, edgeFreeRadius, center_uv);
+	case 2:
+		return subsurface_scattering_disney_blur_estimate_bucket<SSS_SAMPLE_COUNT_BUCKET_SIZE_2>(bucketSource, profile.scatteringDistance, profile.filterRadius, profile.worldScale, edgeFreeRadius, center_uv);
+	case 3:
+		return subsurface_scattering_disney_blur_estimate_bucket<SSS_SAMPLE_COUNT_BUCKET_SIZE_3>(bucketSource, profile.scatteringDistance, profile.filterRadius, profile.worldScale, edgeFreeRadius, center_uv);
+	default:
+		return subsurface_scattering_disney_blur_estimate_bucket<SSS_SAMPLE_COUNT_BUCKET_SIZE_4>(bucketSource, profile.scatteringDistance, profile.filterRadius, profile.worldScale, edgeFreeRadius, center_uv);
+	}
+}
+
+// The sequence of the stochastic mode is offset per pixel (see "subsurface_scattering_stochastic.h")
+// NOTE: the kernel cache is NOT used, since the kernel is NOT shared by the pixels
+struct SSSBlurCPUStochasticSource : public SSSBlurCPUSource
+{
+	SSSBlurCPUStochasticSource(const SSSBlurCPUSource& source, float2 offset) : SSSBlurCPUSource(source), sequenceOffset(offset)
+	{
+	}
+
+	float2 sequenceOffset;
+
+	float2 sample_sequence(int sample_count, int sample_index) const
+	{
+		return subsurface_scattering_stochastic_sequence(SSSBlurCPUSource::sample_sequence(sample_count, sample_index), sequenceOffset);
+	}
+
+	float4 kernel_sample(float d, float center_sample_cdf, int sample_count, int sample_index) const
+	{
+		return subsurface_scattering_disney_kernel_sample(*this, d, center_sample_cdf, sample_count, sample_index);
+	}
+};
+
+// The counterpart of the "Shaders/Support/SSS_Blur.hlsli" for the "subsurface_scattering_separable_blur"
+// The "irradianceRT" is the intermediate image for the vertical pass
+struct SSSSeparableBlurCPUSource
+{
+	const ImageRGBA32F& irradianceRT;
+	const ImageR32F& depthRT;
+	const ImageRGBA32F& albedoRT;
+	const float4x4& currProj;
+	const SSSSeparableKernel& separableKernel;
+	const ImageR8U* stencil;
+
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const
+	{
+		const float* texel = irradianceRT.sampleLevelPoint(uv);
+		return float3(texel[0], texel[1], texel[2]);
+	}
+
+	float subsurface_mask(float2 uv) const
+	{
+		return albedoRT.sampleLevelPoint(uv)[3];
+	}
+
+	int subsurface_profile_index(float2 uv) const
+	{
+		return (NULL != stencil) ? subsurface_scattering_profile_index_from_stencil(stencil->sampleLevelPoint(uv)[0]) : 0;
+	}
+
+	float view_space_position_z(float2 uv) const
+	{
+		// ndcz_to_viewpositionz
+		float depth = depthRT.sampleLevelPoint(uv)[0];
+		return currProj.m[3][2] / (depth - currProj.m[2][2]);
+	}
+
+	float projection_x() const
+	{
+		return currProj.m[0][0];
+	}
+
+	float projection_y() const
+	{
+		return currProj.m[1][1];
+	}
+
+	float2 pixels_per_uv() const
+	{
+		return float2(float(irradianceRT.getWidth()), float(irradianceRT.getHeight()));
+	}
+
+	float4 separable_kernel_sample(int profile_index, int sample_index) const
+	{
+		return separableKernel.getRow(profile_index)[sample_index];
+	}
+};
+
+// The counterpart of the "Shaders/Support/SSS_Blur.hlsli" for the "subsurface_scattering_downsample" and the "subsurface_scattering_upsample"
+// The "lowBlurredRT" is only read by the upsample
+struct SSSLowResolutionCPUSource
+{
+	const ImageRGBA32F& irradianceRT;
+	const ImageR32F& depthRT;
+	const ImageR8U* stencil;
+	const ImageRGBA32F& albedoRT;
+	const ImageRGBA32F& lowBlurredRT;
+	const ImageR32F& lowDepthRT;
+	const ImageR8U& lowStencil;
+	const ImageRGBA32F& lowAlbedoRT;
+	const float4x4& currProj;
+
+	float3 full_resolution_irradiance(int x, int y) const
+	{
+		const float* texel = irradianceRT(x, y);
+		return float3(texel[0], texel[1], texel[2]);
+	}
+
+	float full_resolution_subsurface_mask(int x, int y) const
+	{
+		return albedoRT(x, y)[3];
+	}
+
+	int full_resolution_profile_index(int x, int y) const
+	{
+		return (NULL != stencil) ? subsurface_scattering_profile_index_from_stencil((*stencil)(x, y)[0]) : 0;
+	}
+
+	float full_resolution_view_space_position_z(int x, int y) const
+	{
+		// ndcz_to_viewpositionz
+		return currProj.m[3][2] / (depthRT(x, y)[0] - currProj.m[2][2]);
+	}
+
+	int full_resolution_width() const
+	{
+		return irradianceRT.getWidth();
+	}
+
+	int full_resolution_height() const
+	{
+		return irradianceRT.getHeight();
+	}
+
+	float3 low_resolution_blurred(int x, int y) const
+	{
+		const float* texel = lowBlurredRT(x, y);
+		return float3(texel[0], texel[1], texel[2]);
+	}
+
+	float low_resolution_subsurface_mask(int x, int y) const
+	{
+		return lowAlbedoRT(x, y)[3];
+	}
+
+	int low_resolution_profile_index(int x, int y) const
+	{
+		return subsurface_scattering_profile_index_from_stencil(lowStencil(x, y)[0]);
+	}
+
+	float low_resolution_view_space_position_z(int x, int y) const
+	{
+		return currProj.m[3][2] / (lowDepthRT(x, y)[0] - currProj.m[2][2]);
+	}
+
+	int low_resolution_width() const
+	{
+		return lowBlurredRT.getWidth();
+	}
+
+	int low_resolution_height() const
+	{
+		return lowBlurredRT.getHeight();
+	}
+};
+
+// The counterpart of the "Shaders/Support/SSS_Blur.hlsli" for the "subsurface_scattering_tile_state" and the "subsurface_scattering_tile_classify"
+// The "tileStates" is only read by the classify
+struct SSSTileClassificationCPUSource
+{
+	const ImageRGBA32F& albedoRT;
+	const ImageR8U* stencil;
+	const std::vector<uint32_t>& tileStates;
+
+	float tile_subsurface_mask(int x, int y) const
+	{
+		return albedoRT(x, y)[3];
+	}
+
+	int tile_profile_index(int x, int y) const
+	{
+		return (NULL != stencil) ? subsurface_scattering_profile_index_from_stencil((*stencil)(x, y)[0]) : 0;
+	}
+
+	int tile_screen_width() const
+	{
+		return albedoRT.getWidth();
+	}
+
+	int tile_screen_height() const
+	{
+		return albedoRT.getHeight();
+	}
+
+	uint32_t tile_state(int tile_x, int tile_y) const
+	{
+		return tileStates[static_cast<size_t>(tile_y) * static_cast<size_t>(subsurface_scattering_tile_count(albedoRT.getWidth())) + static_cast<size_t>(tile_x)];
+	}
+};
+
+// The counterpart of the "SSS_SOURCE" of the "subsurface_scattering_atrous_filter"
+struct SSSAtrousCPUSource
+{
+	const ImageRGBA32F& numeratorRT;
+	const ImageRGBA32F& denominatorRT;
+	const ImageRGBA32F& guideRT;
+
+	float4 atrous_guide(int x, int y) const
+	{
+		const float* texel = guideRT(x, y);
+		return float4(texel[0], texel[1], texel[2], texel[3]);
+	}
+
+	float4 atrous_numerator(int x, int y) const
+	{
+		const float* texel = numeratorRT(x, y);
+		return float4(texel[0], texel[1], texel[2], texel[3]);
+	}
+
+	float4 atrous_denominator(int x, int y) const
+	{
+		const float* texel = denominatorRT(x, y);
+		return float4(texel[0], texel[1], texel[2], texel[3]);
+	}
+
+	int atrous_width() const
+	{
+		return guideRT.getWidth();
+	}
+
+	int atrous_height() const
+	{
+		return guideRT.getHeight();
+	}
+};
+
+// The calling thread is also used as a worker
+template <typename WORKER>
+static void runWorkers(int threadCount, const WORKER& worker)
+{
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for (int threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+// The counterpart of the mip SSS_ADAPTIVE_DEVIATION_MIP_LEVEL of the "pilotErrorRT" (by the "GenerateMips") on the GPU
+// The deviation of each covered pixel is replaced by the mean deviation of its block (including the pixels which are NOT covered)
+static void blockMeanDeviation(ImageRGBA32F& pilotErrorRT)
+{
+	const int blockSize = 1 << SSS_ADAPTIVE_DEVIATION_MIP_LEVEL;
+	for (int blockY = 0; blockY < pilotErrorRT.getHeight(); blockY += blockSize)
+	{
+		for (int blockX = 0; blockX < pilotErrorRT.getWidth(); blockX += blockSize)
+		{
+			const int endX = std::min(blockX + blockSize, pilotErrorRT.getWidth());
+			const int endY = std::min(blockY + blockSize, pilotErrorRT.getHeight());
+
+			double sumDeviation = 0.0;
+			for (int y = blockY; y < endY; ++y)
+			{
+				for (int x = blockX; x < endX; ++x)
+				{
+					sumDeviation += double(pilotErrorRT(x, y)[0]);
+				}
+			}
+
+			const float meanDeviation = float(sumDeviation / double((endX - blockX) * (endY - blockY)));
+			for (int y = blockY; y < endY; ++y)
+			{
+				for (int x = blockX; x < endX; ++x)
+				{
+					float* pilotErrorTexel = pilotErrorRT(x, y);
+					if (pilotErrorTexel[2] > 0.0f)
+					{
+						pilotErrorTexel[0] = meanDeviation;
+					}
+				}
+			}
+		}
+	}
+}
+
+// Water Filling
+// The (uniformSampleCount, deviationScale) of which the sum of the refinement sample counts (before the rounding) over the covered pixels is NOT greater than the "refinementBudget"
+// The pixels which reach the "sampleBudget" are excluded by the larger "deviationScale", s.t. the rest of the budget is redistributed to the other pixels
+// If every pixel with error reaches the "sampleBudget", the rest of the budget is given back to all pixels by the larger "uniformSampleCount" (rather than left unspent)
+static float2 solveRefinementAllocation(const ImageRGBA32F& pilotErrorRT, int sampleBudget, float uniformSampleCount, double refinementBudget)
+{
+	// (deviation, pilot_sample_count) of the covered pixels
+	std::vector<float2> pixels;
+	bool error = false;
+	for (int y = 0; y < pilotErrorRT.getHeight(); ++y)
+	{
+		for (int x = 0; x < pilotErrorRT.getWidth(); ++x)
+		{
+			const float* pilotErrorTexel = pilotErrorRT(x, y);
+			if (pilotErrorTexel[2] > 0.0f)
+			{
+				pixels.push_back(float2(pilotErrorTexel[0], pilotErrorTexel[1]));
+				error = error || (pilotErrorTexel[0] > 0.0f);
+			}
+		}
+	}
+
+	// NOTE: the same as the "subsurface_scattering_adaptive_refinement_sample_count" (the pixels which are NOT refined take no samples)
+	auto allocated = [&](float uniform, float deviationScale) -> double
+	{
+		double sum = 0.0;
+		for (const float2& pixel : pixels)
+		{
+			const float sampleCount = std::min(uniform + deviationScale * pixel.x, float(sampleBudget));
+			sum += (sampleCount > pixel.y) ? double(sampleCount) : 0.0;
+		}
+		return sum;
+	};
+
+	// NOTE: the "allocated" is monotonic (but NOT continuous) and the "upper" is doubled until the budget is reached (or every pixel reaches the "sampleBudget")
+	// NOTE: the "lower" is returned, s.t. the budget is NOT exceeded when many pixels are refined at once
+	float deviationScale = 0.0f;
+	if (error)
+	{
+		float lower = 0.0f;
+		float upper = 1.0f;
+		for (int iteration = 0; (iteration < 64) && (allocated(uniformSampleCount, upper) < refinementBudget); ++iteration)
+		{
+			lower = upper;
+			upper *= 2.0f;
+		}
+
+		for (int iteration = 0; iteration < 32; ++iteration)
+		{
+			const float middle = 0.5f * (lower + upper);
+			((allocated(uniformSampleCount, middle) <= refinementBudget) ? lower : upper) = middle;
+		}
+
+		deviationScale = lower;
+	}
+
+	if (allocated(uniformSampleCount, deviationScale) < refinementBudget)
+	{
+		float lower = uniformSampleCount;
+		float upper = float(sampleBudget);
+		for (int iteration = 0; iteration < 32; ++iteration)
+		{
+			const float middle = 0.5f * (lower + upper);
+			((allocated(middle, deviationScale) <= refinementBudget) ? lower : upper) = middle;
+		}
+
+		uniformSampleCount = lower;
+	}
+
+	return float2(uniformSampleCount, deviationScale);
+}
+
+// Tile Analysis
+// One pass over the tiles of the classification (one row of the tiles per work item): the state of the classification and the analysis (the predicted cost of the work stealing and the predicted "sample_count" of the sample count buckets)
+// The predicted cost of each tile: the sum of the "sample_count" (the "subsurface_scattering_disney_blur_estimate_interior" without the MIS) of the covered pixels, namely, the mask coverage x the predicted sample count, and one for each pixel of the tile for the stencil test
+// The "tileClasses" is empty if the classification is disabled, and the "tileAnalyses" is empty if the cost is disabled
+static void analyzeTiles(const ImageR32F& depthRT, const ImageR8U* stencil, const ImageRGBA32F& albedoRT, const float4x4& currProj, const std::vector<SSSProfile>& profileTable, int width, int height, int sampleBudget, int pixelsPerSample, bool tileClassificationEnabled, bool tileCostEnabled, int threadCount, std::vector<subsurface_scattering_tile_classify_result>& tileClasses, std::vector<SSSBlurCPUTileAnalysis>& tileAnalyses, int tileCounts[SSS_TILE_CLASS_COUNT])
+{
+	const int classificationTileCountX = subsurface_scattering_tile_count(width);
+	const int classificationTileCountY = subsurface_scattering_tile_count(height);
+	std::vector<uint32_t> tileStates(tileClassificationEnabled ? (static_cast<size_t>(classificationTileCountX) * static_cast<size_t>(classificationTileCountY)) : 0U);
+	tileClasses.assign(tileStates.size(), subsurface_scattering_tile_classify_result());
+	tileAnalyses.assign(tileCostEnabled ? (static_cast<size_t>(classificationTileCountX) * static_cast<size_t>(classificationTileCountY)) : 0U, SSSBlurCPUTileAnalysis());
+	if (!(tileClassificationEnabled || tileCostEnabled))
+	{
+		return;
+	}
+
+	const SSSTileClassificationCPUSource classificationSource = { albedoRT, stencil, tileStates };
+	std::atomic<int> nextRow(0);
+
+	auto worker = [&]()
+	{
+		for (int tileY = nextRow.fetch_add(1); tileY < classificationTileCountY; tileY = nextRow.fetch_add(1))
+		{
+			for (int tileX = 0; tileX < classificationTileCountX; ++tileX)
+			{
+				const size_t tileIndex = static_cast<size_t>(tileY) * static_cast<size_t>(classificationTileCountX) + static_cast<size_t>(tileX);
+				if (tileClassificationEnabled)
+				{
+					tileStates[tileIndex] = subsurface_scattering_tile_state(classificationSource, tileX, tileY);
+				}
+
+				if (!tileCostEnabled)
+				{
+					continue;
+				}
+
+				SSSBlurCPUTileAnalysis analysis = { 0.0f, 0.0f, 0, sampleBudget };
+				for (int y = tileY * SSS_TILE_SIZE; y < std::min((tileY + 1) * SSS_TILE_SIZE, height); ++y)
+				{
+					for (int x = tileX * SSS_TILE_SIZE; x < std::min((tileX + 1) * SSS_TILE_SIZE, width); ++x)
+					{
+						analysis.cost += 1.0f;
+
+						const int profileIndex = (NULL != stencil) ? subsurface_scattering_profile_index_from_stencil((*stencil)(x, y)[0]) : 0;
+						const float subsurfaceMask = albedoRT(x, y)[3];
+						if ((profileIndex < 0) || (profileIndex >= static_cast<int>(profileTable.size())) || (subsurfaceMask < (1.0f / 255.0f)))
+						{
+							continue;
+						}
+						const SSSProfile& profile = profileTable[profileIndex];
+
+						// The same "pixels_per_mm" as the "subsurface_scattering_disney_blur_estimate_interior"
+						const float viewSpacePositionZ = currProj.m[3][2] / (depthRT(x, y)[0] - currProj.m[2][2]);
+						const float mmsPerUnit = 1000.0f * profile.worldScale * (1.0f / subsurfaceMask);
+						const float pixelsPerMmX = float(width) * 0.5f * currProj.m[0][0] * (1.0f / viewSpacePositionZ) * (1.0f / mmsPerUnit);
+						const float pixelsPerMmY = float(height) * 0.5f * currProj.m[1][1] * (1.0f / viewSpacePositionZ) * (1.0f / mmsPerUnit);
+						const float predictedSampleCount = float(PI) * (profile.filterRadius * pixelsPerMmX) * (profile.filterRadius * pixelsPerMmY) * (1.0f / float(pixelsPerSample));
+						const int pixelSampleBudget = (NULL != stencil) ? subsurface_scattering_sample_budget_from_stencil((*stencil)(x, y)[0], sampleBudget) : sampleBudget;
+						// NOTE: the NaN is mapped to zero
+						const float clampedSampleCount = (predictedSampleCount >= 0.0f) ? std::min(predictedSampleCount, float(pixelSampleBudget)) : 0.0f;
+						analysis.cost += clampedSampleCount;
+						analysis.sumPredictedSampleCount += clampedSampleCount;
+						++analysis.coveredPixelCount;
+						analysis.minSampleBudget = std::min(analysis.minSampleBudget, pixelSampleBudget);
+					}
+				}
+				tileAnalyses[tileIndex] = analysis;
+			}
+		}
+	};
+
+	runWorkers(std::min(threadCount, classificationTileCountY), worker);
+
+	// Tile Classification
+	// The classify pass only reads the states of the neighbouring tiles, and the work items of SSS_CPU_TILE_SIZE of which all tiles are EMPTY are skipped
+	if (tileClassificationEnabled)
+	{
+		for (int tileY = 0; tileY < classificationTileCountY; ++tileY)
+		{
+			for (int tileX = 0; tileX < classificationTileCountX; ++tileX)
+			{
+				subsurface_scattering_tile_classify_result& tileClass = tileClasses[static_cast<size_t>(tileY) * static_cast<size_t>(classificationTileCountX) + static_cast<size_t>(tileX)];
+				tileClass = subsurface_scattering_tile_classify(classificationSource, tileX, tileY);
+				++tileCounts[tileClass.tile_class];
+			}
+		}
+	}
+}
+
+// The work items of SSS_CPU_TILE_SIZE, of which the analyses of the tiles of the classification are summed
+// Sample Count Buckets: the bucket of each work item is the nearest to the mean of the predicted "sample_count" of the covered pixels (-1 if none of the pixels is covered)
+// NOTE: the bucket is NOT larger than the budget of any covered pixel (the LOD of the head may reduce the budget, see "SSSLodSelector"), s.t. the rounding never exceeds the "sampleBudget"
+static void buildBurleyTiles(int width, int height, int sampleBudget, bool tileClassificationEnabled, bool tileCostEnabled, bool sampleCountBucketsEnabled, const std::vector<subsurface_scattering_tile_classify_result>& tileClasses, const std::vector<SSSBlurCPUTileAnalysis>& tileAnalyses, std::vector<SSSBlurCPUTile>& burleyTiles, int bucketTileCounts[SSS_SAMPLE_COUNT_BUCKET_COUNT])
+{
+	const int tileCountX = (width + SSS_CPU_TILE_SIZE - 1) / SSS_CPU_TILE_SIZE;
+	const int tileCountY = (height + SSS_CPU_TILE_SIZE - 1) / SSS_CPU_TILE_SIZE;
+	const int tileCount = tileCountX * tileCountY;
+	const int classificationTileCountX = subsurface_scattering_tile_count(width);
+
+	burleyTiles.clear();
+	burleyTiles.reserve(tileCount);
+	for (int tileIndex = 0; tileIndex < tileCount; ++tileIndex)
+	{
+		const int x0 = (tileIndex % tileCountX) * SSS_CPU_TILE_SIZE;
+		const int y0 = (tileIndex / tileCountX) * SSS_CPU_TILE_SIZE;
+		SSSBlurCPUTile tile = { x0, y0, std::min(x0 + SSS_CPU_TILE_SIZE, width), std::min(y0 + SSS_CPU_TILE_SIZE, height), 0.0f, -1 };
+
+		bool empty = tileClassificationEnabled;
+		SSSBlurCPUTileAnalysis analysis = { 0.0f, 0.0f, 0, sampleBudget };
+		for (int tileY = y0 / SSS_TILE_SIZE; tileY < subsurface_scattering_tile_count(tile.y1); ++tileY)
+		{
+			for (int tileX = x0 / SSS_TILE_SIZE; tileX < subsurface_scattering_tile_count(tile.x1); ++tileX)
+			{
+				const size_t classificationTileIndex = static_cast<size_t>(tileY) * static_cast<size_t>(classificationTileCountX) + static_cast<size_t>(tileX);
+				if (tileClassificationEnabled)
+				{
+					empty = empty && (SSS_TILE_CLASS_EMPTY == tileClasses[classificationTileIndex].tile_class);
+				}
+				if (tileCostEnabled)
+				{
+					analysis.cost += tileAnalyses[classificationTileIndex].cost;
+					analysis.sumPredictedSampleCount += tileAnalyses[classificationTileIndex].sumPredictedSampleCount;
+					analysis.coveredPixelCount += tileAnalyses[classificationTileIndex].coveredPixelCount;
+					analysis.minSampleBudget = std::min(analysis.minSampleBudget, tileAnalyses[classificationTileIndex].minSampleBudget);
+				}
+			}
+		}
+
+		if (empty)
+		{
+			continue;
+		}
+
+		tile.cost = analysis.cost;
+		tile.bucket = (sampleCountBucketsEnabled && (analysis.coveredPixelCount > 0)) ? subsurface_scattering_sample_count_bucket(analysis.sumPredictedSampleCount / float(analysis.coveredPixelCount), analysis.minSampleBudget) : -1;
+		bucketTileCounts[std::max(tile.bucket, 0)] += (tile.bucket >= 0) ? 1 : 0;
+		burleyTiles.push_back(tile);
+	}
+}
+
+// Mask Pyramid
+// The level 0 (the "SSS_Blur_MaskPyramidBase_PS") is padded by clamping the address, and each following level is the reduce of the 2x2 texels of the previous level (the "SSS_Blur_MaskPyramidReduce_PS")
+static void buildMaskPyramid(const ImageR8U* stencil, const ImageRGBA32F& albedoRT, int width, int height, int threadCount, std::vector<ImageRGBA32F>& maskPyramid)
+{
+	const int levelCount = subsurface_scattering_mask_pyramid_level_count(width, height);
+	const int paddedWidth = subsurface_scattering_mask_pyramid_padded_size(width, levelCount);
+	const int paddedHeight = subsurface_scattering_mask_pyramid_padded_size(height, levelCount);
+	// NOTE: every texel is written below, s.t. the images are only reallocated if the size is changed
+	if ((static_cast<int>(maskPyramid.size()) != levelCount) || (maskPyramid[0].getWidth() != paddedWidth) || (maskPyramid[0].getHeight() != paddedHeight))
+	{
+		maskPyramid.clear();
+		maskPyramid.reserve(levelCount);
+		for (int level = 0; level < levelCount; ++level)
+		{
+			maskPyramid.emplace_back(paddedWidth >> level, paddedHeight >> level);
+		}
+	}
+
+	// One row per work item of each level, of which the texels only read the previous level
+	for (int level = 0; level < levelCount; ++level)
+	{
+		ImageRGBA32F& levelRT = maskPyramid[level];
+		std::atomic<int> nextRow(0);
+
+		auto worker = [&]()
+		{
+			for (int y = nextRow.fetch_add(1); y < levelRT.getHeight(); y = nextRow.fetch_add(1))
+			{
+				for (int x = 0; x < levelRT.getWidth(); ++x)
+				{
+					float4 texel;
+					if (0 == level)
+					{
+						const int texelX = std::min(x, width - 1);
+						const int texelY = std::min(y, height - 1);
+						const int profileIndex = (NULL != stencil) ? subsurface_scattering_profile_index_from_stencil((*stencil)(texelX, texelY)[0]) : 0;
+						texel = subsurface_scattering_mask_pyramid_base(albedoRT(texelX, texelY)[3], profileIndex);
+					}
+					else
+					{
+						const ImageRGBA32F& previousLevelRT = maskPyramid[level - 1];
+						const float* texel00 = previousLevelRT(2 * x, 2 * y);
+						const float* texel10 = previousLevelRT(2 * x + 1, 2 * y);
+						const float* texel01 = previousLevelRT(2 * x, 2 * y + 1);
+						const float* texel11 = previousLevelRT(2 * x + 1, 2 * y + 1);
+						texel = subsurface_scattering_mask_pyramid_reduce(
+							float4(texel00[0], texel00[1], texel00[2], texel00[3]),
+							float4(texel10[0], texel10[1], texel10[2], texel10[3]),
+							float4(texel01[0], texel01[1], texel01[2], texel01[3]),
+							float4(texel11[0], texel11[1], texel11[2], texel11[3]));
+					}
+
+					float* dst = levelRT(x, y);
+					dst[0] = texel.x;
+					dst[1] = texel.y;
+					dst[2] = texel.z;
+					dst[3] = texel.w;
+				}
+			}
+		};
+
+		runWorkers(std::min(threadCount, levelRT.getHeight()), worker);
+	}
+}
+
+// Swizzled Images
+// The irradiance and the depth are packed into one texel, s.t. the "total_diffuse_reflectance_pre_scatter_multiply_form_factor" and the "view_space_position_z" of the same sample share the cache line
+// NOTE: the swizzled copies should be of the size of the inputs (the stencil is NOT copied if NULL)
+static void swizzleImages(const ImageRGBA32F& irradianceRT, const ImageR32F& depthRT, const ImageR8U* stencil, const ImageRGBA32F& albedoRT, int width, int height, int threadCount, SwizzledImageRGBA32F& swizzledIrradianceDepth, SwizzledImageRGBA32F& swizzledAlbedo, SwizzledImageR8U& swizzledStencil)
+{
+	// One row per work item
+	std::atomic<int> nextRow(0);
+
+	auto worker = [&]()
+	{
+		for (int y = nextRow.fetch_add(1); y < height; y = nextRow.fetch_add(1))
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const float* irradiance = irradianceRT(x, y);
+				float* irradianceDepth = swizzledIrradianceDepth(x, y);
+				irradianceDepth[0] = irradiance[0];
+				irradianceDepth[1] = irradiance[1];
+				irradianceDepth[2] = irradiance[2];
+				irradianceDepth[3] = depthRT(x, y)[0];
+
+				const float* albedo = albedoRT(x, y);
+				float* swizzledAlbedoTexel = swizzledAlbedo(x, y);
+				swizzledAlbedoTexel[0] = albedo[0];
+				swizzledAlbedoTexel[1] = albedo[1];
+				swizzledAlbedoTexel[2] = albedo[2];
+				swizzledAlbedoTexel[3] = albedo[3];
+
+				if (NULL != stencil)
+				{
+					swizzledStencil(x, y)[0] = (*stencil)(x, y)[0];
+				}
+			}
+		}
+	};
+
+	runWorkers(std::min(threadCount, height), worker);
+}
+
+SSSBlurCPU::SSSBlurCPU(bool postscatterEnabled,
+	int sampleBudget,
+	int pixelsPerSample,
+	int threadCount) : m_postscatterEnabled(postscatterEnabled),
+	m_sampleBudget(std::max(1, sampleBudget)),
+	m_pixelsPerSample(std::max(4, pixelsPerSample)),
+	m_threadCount(std::max(0, threadCount)),
+	m_inverseCdfMode(SSS_INVERSE_CDF_MODE_ANALYTIC),
+	m_inverseCdfLUT(new DiffusionProfileInverseCdfLUT(SSS_INVERSE_CDF_LUT_DEFAULT_SIZE)),
+	m_kernelCacheEnabled(false),
+	m_sequence(LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY),
+	m_misMode(SSS_MIS_MODE_NONE),
+	m_blurMode(SSS_BLUR_MODE_BURLEY),
+	m_resolutionFactor(SSS_RESOLUTION_FACTOR_FULL),
+	m_frameIndex(0U),
+	m_samplesPerFrame(0),
+	m_sampleCount(0U),
+	m_tileClassificationEnabled(true),
+	m_maskPyramidEnabled(true),
+	m_rejectedSampleCount(0U),
+	m_wastedSampleCount(0U),
+	m_irradiancePyramidEnabled(false),
+	m_imageLayout(IMAGE_LAYOUT_ROW_MAJOR),
+	m_blockWidthLog2(IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_WIDTH_LOG2),
+	m_blockHeightLog2(IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_HEIGHT_LOG2),
+	m_workStealingEnabled(true),
+	m_coherentSamplingEnabled(false),
+	m_sampleCountBucketsEnabled(false),
+	m_stochasticSampleCount(0),
+	m_denoiserIterationCount(SSS_ATROUS_DEFAULT_ITERATION_COUNT)
+{
+	std::fill(m_tileCounts, m_tileCounts + SSS_TILE_CLASS_COUNT, 0);
+	std::fill(m_bucketTileCounts, m_bucketTileCounts + SSS_SAMPLE_COUNT_BUCKET_COUNT, 0);
+}
+
+SSSBlurCPU::~SSSBlurCPU()
+{
+}
+
+void SSSBlurCPU::go(ImageRGBA32F& mainRT,
+	const ImageRGBA32F& irradianceRT,
+	const ImageR32F& depthRT,
+	const ImageR8U* stencil,
+	const ImageRGBA32F& albedoRT,
+	const float4x4& currProj,
+	const SSSProfileTable& profiles)
+{
+	const int resolutionFactor = m_resolutionFactor;
+	if (SSS_RESOLUTION_FACTOR_FULL == resolutionFactor)
+	{
+		blur(mainRT, irradianceRT, depthRT, stencil, albedoRT, currProj, profiles);
+		return;
+	}
+
+	const int width = mainRT.getWidth();
+	const int height = mainRT.getHeight();
+	const int lowWidth = subsurface_scattering_low_resolution_size(width, resolutionFactor);
+	const int lowHeight = subsurface_scattering_low_resolution_size(height, resolutionFactor);
+	const int profileCount = profiles.getCount();
+	const bool postscatterEnabled = m_postscatterEnabled;
+
+	int threadCount = (m_threadCount > 0) ? m_threadCount : static_cast<int>(std::thread::hardware_concurrency());
+	threadCount = std::max(1, std::min(threadCount, lowHeight));
+
+	// The low resolution render targets ("SSSUpsampler::createRTs")
+	// NOTE: the albedo of the low resolution is white, s.t. the blur outputs the blurred irradiance and the "total_diffuse_reflectance_post_scatter" is multiplied by the upsample
+	ImageRGBA32F lowIrradianceRT(lowWidth, lowHeight);
+	ImageR32F lowDepthRT(lowWidth, lowHeight);
+	ImageR8U lowStencil(lowWidth, lowHeight);
+	ImageRGBA32F lowAlbedoRT(lowWidth, lowHeight);
+	ImageRGBA32F lowBlurredRT(lowWidth, lowHeight);
+	const SSSLowResolutionCPUSource source = { irradianceRT, depthRT, stencil, albedoRT, lowBlurredRT, lowDepthRT, lowStencil, lowAlbedoRT, currProj };
+
+	// Downsample: one low resolution row per work item
+	{
+		std::atomic<int> nextRow(0);
+
+		auto worker = [&]()
+		{
+			for (int y = nextRow.fetch_add(1); y < lowHeight; y = nextRow.fetch_add(1))
+			{
+				for (int x = 0; x < lowWidth; ++x)
+				{
+					const subsurface_scattering_downsample_result result = subsurface_scattering_downsample(source, resolutionFactor, x, y);
+
+					float* irradiance = lowIrradianceRT(x, y);
+					irradiance[0] = result.total_diffuse_reflectance_pre_scatter_multiply_form_factor.x;
+					irradiance[1] = result.total_diffuse_reflectance_pre_scatter_multiply_form_factor.y;
+					irradiance[2] = result.total_diffuse_reflectance_pre_scatter_multiply_form_factor.z;
+					irradiance[3] = 1.0f;
+
+					float* albedo = lowAlbedoRT(x, y);
+					albedo[0] = 1.0f;
+					albedo[1] = 1.0f;
+					albedo[2] = 1.0f;
+					albedo[3] = result.subsurface_mask;
+
+					lowDepthRT(x, y)[0] = depthRT(result.representative_texel_x, result.representative_texel_y)[0];
+					lowStencil(x, y)[0] = (result.profile_index >= 0) ? subsurface_scattering_profile_stencil_ref(result.profile_index) : uint8_t(0U);
+				}
+			}
+		};
+
+		runWorkers(threadCount, worker);
+	}
+
+	blur(lowBlurredRT, lowIrradianceRT, lowDepthRT, &lowStencil, lowAlbedoRT, currProj, profiles);
+
+	// Upsample: one full resolution row per work item
+	{
+		std::atomic<int> nextRow(0);
+
+		auto worker = [&]()
+		{
+			for (int y = nextRow.fetch_add(1); y < height; y = nextRow.fetch_add(1))
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					// Stencil Test: D3D11_COMPARISON_NOT_EQUAL with StencilRef = 0
+					if ((NULL != stencil) && (0U == (*stencil)(x, y)[0]))
+					{
+						continue;
+					}
+
+					if (source.full_resolution_profile_index(x, y) >= profileCount)
+					{
+						continue;
+					}
+
+					const float* albedo = albedoRT(x, y);
+					float3 radiance = subsurface_scattering_total_diffuse_reflectance_post_scatter_from_albedo(postscatterEnabled, float3(albedo[0], albedo[1], albedo[2])) * subsurface_scattering_upsample(source, resolutionFactor, x, y);
+
+					// Additive Blending: D3D11_BLEND_ONE + D3D11_BLEND_ONE (RGB only)
+					float* dst = mainRT(x, y);
+					dst[0] += radiance.x;
+					dst[1] += radiance.y;
+					dst[2] += radiance.z;
+				}
+			}
+		};
+
+		runWorkers(threadCount, worker);
+	}
+}
+
+void SSSBlurCPU::blur(ImageRGBA32F& mainRT,
+	const ImageRGBA32F& irradianceRT,
+	const ImageR32F& depthRT,
+	const ImageR8U* stencil,
+	const ImageRGBA32F& albedoRT,
+	const float4x4& currProj,
+	const SSSProfileTable& profiles)
+{
+	// Keep the LUT alive during the blur, s.t. the "setInverseCdfLUTSize" is allowed to be called by other threads
+	const std::shared_ptr<const DiffusionProfileInverseCdfLUT> inverseCdfLUT = std::atomic_load(&m_inverseCdfLUT);
+
+	const int width = mainRT.getWidth();
+	const int height = mainRT.getHeight();
+	const int tileCountX = (width + SSS_CPU_TILE_SIZE - 1) / SSS_CPU_TILE_SIZE;
+	const int tileCountY = (height + SSS_CPU_TILE_SIZE - 1) / SSS_CPU_TILE_SIZE;
+	const int tileCount = tileCountX * tileCountY;
+
+	// Copy the parameters, s.t. the setters are allowed to be called by other threads during the blur
+	const std::vector<SSSProfile> profileTable(profiles.getData(), profiles.getData() + profiles.getCount());
+	const int pixelsPerSample = m_pixelsPerSample;
+	const int sampleBudget = m_sampleBudget;
+	const int sequence = m_sequence;
+	const int misMode = m_misMode;
+	const int stochasticSampleCount = m_stochasticSampleCount;
+	// NOTE: the stochastic mode does NOT use the kernel cache
+	SSSKernelCache* const kernelCache = (m_kernelCacheEnabled && (stochasticSampleCount <= 0)) ? &m_kernelCache : NULL;
+
+	int threadCount = (m_threadCount > 0) ? m_threadCount : static_cast<int>(std::thread::hardware_concurrency());
+	threadCount = std::max(1, std::min(threadCount, tileCount));
+
+	m_sampleCount = 0U;
+	m_rejectedSampleCount = 0U;
+	m_wastedSampleCount = 0U;
+	std::fill(m_tileCounts, m_tileCounts + SSS_TILE_CLASS_COUNT, 0);
+	std::fill(m_bucketTileCounts, m_bucketTileCounts + SSS_SAMPLE_COUNT_BUCKET_COUNT, 0);
+
+	if (SSS_BLUR_MODE_SEPARABLE == m_blurMode)
+	{
+		m_separableKernel.update(profiles);
+
+		// The intermediate render target ("tmpRT" of the "SSSBlur")
+		ImageRGBA32F tmpRT(width, height);
+
+		// direction: (1, 0) reads the "irradianceRT" and writes the "tmpRT"; (0, 1) reads the "tmpRT" and adds the radiance into the "mainRT"
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			const float2 direction = (0 == pass) ? float2(1.0f, 0.0f) : float2(0.0f, 1.0f);
+			const SSSSeparableBlurCPUSource source = { (0 == pass) ? irradianceRT : tmpRT, depthRT, albedoRT, currProj, m_separableKernel, stencil };
+
+			std::atomic<int> nextTile(0);
+
+			auto worker = [&]()
+			{
+				for (int tileIndex = nextTile.fetch_add(1); tileIndex < tileCount; tileIndex = nextTile.fetch_add(1))
+				{
+					const int x0 = (tileIndex % tileCountX) * SSS_CPU_TILE_SIZE;
+					const int y0 = (tileIndex / tileCountX) * SSS_CPU_TILE_SIZE;
+					const int x1 = std::min(x0 + SSS_CPU_TILE_SIZE, width);
+					const int y1 = std::min(y0 + SSS_CPU_TILE_SIZE, height);
+
+					for (int y = y0; y < y1; ++y)
+					{
+						for (int x = x0; x < x1; ++x)
+						{
+							// Stencil Test: D3D11_COMPARISON_NOT_EQUAL with StencilRef = 0
+							if ((NULL != stencil) && (0U == (*stencil)(x, y)[0]))
+							{
+								continue;
+							}
+
+							const int profileIndex = (NULL != stencil) ? subsurface_scattering_profile_index_from_stencil((*stencil)(x, y)[0]) : 0;
+							if (profileIndex >= static_cast<int>(profileTable.size()))
+							{
+								continue;
+							}
+							const SSSProfile& profile = profileTable[profileIndex];
+
+							const float2 center_uv((float(x) + 0.5f) / float(width), (float(y) + 0.5f) / float(height));
+
+							float3 color = subsurface_scattering_separable_blur(source, profile.filterRadius, profile.worldScale, direction, center_uv);
+
+							if (0 == pass)
+							{
+								float* dst = tmpRT(x, y);
+								dst[0] = color.x;
+								dst[1] = color.y;
+								dst[2] = color.z;
+								dst[3] = 1.0f;
+							}
+							else
+							{
+								const float* albedo = albedoRT(x, y);
+								float3 radiance = subsurface_scattering_total_diffuse_reflectance_post_scatter_from_albedo(m_postscatterEnabled, float3(albedo[0], albedo[1], albedo[2])) * color;
+
+								// Additive Blending: D3D11_BLEND_ONE + D3D11_BLEND_ONE (RGB only)
+								float* dst = mainRT(x, y);
+								dst[0] += radiance.x;
+								dst[1] += radiance.y;
+								dst[2] += radiance.z;
+							}
+						}
+					}
+				}
+			};
+
+			runWorkers(threadCount, worker);
+		}
+
+		return;
+	}
+
+	const float2 sampleRotation = subsurface_scattering_sample_rotation(m_frameIndex);
+	const int sampleRadiusOffsetIndex = subsurface_scattering_sample_radius_offset_index(m_frameIndex);
+
+	// Adaptive Sampling
+	// NOTE: the stochastic mode takes precedence over the adaptive sampling
+	const int samplesPerFrame = (stochasticSampleCount > 0) ? 0 : m_samplesPerFrame;
+	const int pilotSampleCount = std::min(int(SSS_ADAPTIVE_PILOT_SAMPLE_COUNT), sampleBudget);
+
+	// The "pilotRT" and the "pilotErrorRT" of the "SSSBlur": (radiance.rgb, pilot_sample_count) and (deviation, pilot_sample_count, covered, 0)
+	ImageRGBA32F pilotRT((samplesPerFrame > 0) ? width : 0, (samplesPerFrame > 0) ? height : 0);
+	ImageRGBA32F pilotErrorRT((samplesPerFrame > 0) ? width : 0, (samplesPerFrame > 0) ? height : 0);
+	float deviationScale = 0.0f;
+	float uniformSampleCount = 0.0f;
+
+	// Stochastic Mode
+	// The "stochasticNumeratorRT" and the "stochasticDenominatorRT" (ping-pong of the a-trous filter): (sum_numerator / sample_count, center_sample_cdf) and (sum_denominator / sample_count, 0)
+	// The "stochasticGuideRT": (view_space_position_z, subsurface_mask, diffusion_radius_in_pixels, profile_index), of which the profile_index is -1 if the pixel is NOT estimated by the stochastic pass
+	const uint32_t frameIndex = m_frameIndex;
+	const int denoiserIterationCount = m_denoiserIterationCount;
+	const int stochasticWidth = (stochasticSampleCount > 0) ? width : 0;
+	const int stochasticHeight = (stochasticSampleCount > 0) ? height : 0;
+	ImageRGBA32F stochasticNumeratorRT[2] = { ImageRGBA32F(stochasticWidth, stochasticHeight), ImageRGBA32F((denoiserIterationCount > 0) ? stochasticWidth : 0, (denoiserIterationCount > 0) ? stochasticHeight : 0) };
+	ImageRGBA32F stochasticDenominatorRT[2] = { ImageRGBA32F(stochasticWidth, stochasticHeight), ImageRGBA32F((denoiserIterationCount > 0) ? stochasticWidth : 0, (denoiserIterationCount > 0) ? stochasticHeight : 0) };
+	ImageRGBA32F stochasticGuideRT(stochasticWidth, stochasticHeight);
+	for (int y = 0; y < stochasticHeight; ++y)
+	{
+		for (int x = 0; x < stochasticWidth; ++x)
+		{
+			stochasticGuideRT(x, y)[3] = -1.0f;
+		}
+	}
+
+	// Tile Analysis and Tile Classification
+	// NOTE: the adaptive sampling ignores the classification, the same as the "SSSBlur"
+	const bool tileClassificationEnabled = m_tileClassificationEnabled && (samplesPerFrame <= 0);
+	const bool workStealingEnabled = m_workStealingEnabled;
+	const bool coherentSamplingEnabled = m_coherentSamplingEnabled;
+	const bool sampleCountBucketsEnabled = m_sampleCountBucketsEnabled && (SSS_MIS_MODE_NONE == misMode);
+	const bool tileCostEnabled = workStealingEnabled || sampleCountBucketsEnabled;
+	const int classificationTileCountX = subsurface_scattering_tile_count(width);
+	std::vector<subsurface_scattering_tile_classify_result> tileClasses;
+	std::vector<SSSBlurCPUTileAnalysis> tileAnalyses;
+	analyzeTiles(depthRT, stencil, albedoRT, currProj, profileTable, width, height, sampleBudget, pixelsPerSample, tileClassificationEnabled, tileCostEnabled, threadCount, tileClasses, tileAnalyses, m_tileCounts);
+
+	// The "SSS_Blur_Interior_PS" skips the test of the samples within the tiles which are known to be INTERIOR
+	auto tileEdgeFreeRadius = [&](int x, int y) -> float
+	{
+		if (!tileClassificationEnabled)
+		{
+			return 0.0f;
+		}
+		const subsurface_scattering_tile_classify_result& tileClass = tileClasses[static_cast<size_t>(y / SSS_TILE_SIZE) * static_cast<size_t>(classificationTileCountX) + static_cast<size_t>(x / SSS_TILE_SIZE)];
+		return (SSS_TILE_CLASS_INTERIOR == tileClass.tile_class) ? subsurface_scattering_tile_edge_free_radius(x, y, tileClass.margin) : 0.0f;
+	};
+
+	// The work items of the Burley blur and the sample count buckets
+	std::vector<SSSBlurCPUTile> burleyTiles;
+	buildBurleyTiles(width, height, sampleBudget, tileClassificationEnabled, tileCostEnabled, sampleCountBucketsEnabled, tileClasses, tileAnalyses, burleyTiles, m_bucketTileCounts);
+	const int burleyTileCount = static_cast<int>(burleyTiles.size());
+
+	// Mask Pyramid
+	std::vector<ImageRGBA32F>& maskPyramid = m_maskPyramid;
+	if (m_maskPyramidEnabled)
+	{
+		buildMaskPyramid(stencil, albedoRT, width, height, threadCount, maskPyramid);
+	}
+	const std::vector<ImageRGBA32F>* const maskPyramidSource = m_maskPyramidEnabled ? &maskPyramid : NULL;
+
+	// Irradiance Pyramid
+	// The "SSS_Blur_IrradiancePyramidBase_PS" and the "SSS_Blur_IrradiancePyramidReduce_PS"
+	if (m_irradiancePyramidEnabled)
+	{
+		m_irradiancePyramid.build(irradianceRT, depthRT, stencil, albedoRT, currProj);
+	}
+	const SSSIrradiancePyramid* const irradiancePyramidSource = m_irradiancePyramidEnabled ? &m_irradiancePyramid : NULL;
+
+	// Swizzled Images
+	const int imageLayout = m_imageLayout;
+	const bool swizzled = (IMAGE_LAYOUT_MORTON == imageLayout) || (IMAGE_LAYOUT_BLOCK_LINEAR == imageLayout);
+	if (swizzled)
+	{
+		m_swizzledIrradianceDepth.resize(width, height, imageLayout, m_blockWidthLog2, m_blockHeightLog2);
+		m_swizzledAlbedo.resize(width, height, imageLayout, m_blockWidthLog2, m_blockHeightLog2);
+		m_swizzledStencil.resize((NULL != stencil) ? width : 0, (NULL != stencil) ? height : 0, imageLayout, m_blockWidthLog2, m_blockHeightLog2);
+		swizzleImages(irradianceRT, depthRT, stencil, albedoRT, width, height, threadCount, m_swizzledIrradianceDepth, m_swizzledAlbedo, m_swizzledStencil);
+	}
+	const SwizzledImageRGBA32F* const swizzledIrradianceDepthSource = swizzled ? &m_swizzledIrradianceDepth : NULL;
+	const SwizzledImageRGBA32F* const swizzledAlbedoSource = swizzled ? &m_swizzledAlbedo : NULL;
+	const SwizzledImageR8U* const swizzledStencilSource = (swizzled && (NULL != stencil)) ? &m_swizzledStencil : NULL;
+
+	// Work Stealing
+	// The tiles are sorted in the Z-order, s.t. each contiguous range of the seed of the scheduler is a compact region of the screen
+	// NOTE: the pilot pass and the refinement pass use the same prediction, since the refinement is proportional to the error which is NOT known before the pilot pass
+	std::vector<float> burleyTileCosts;
+	if (workStealingEnabled)
+	{
+		std::sort(burleyTiles.begin(), burleyTiles.end(), [](const SSSBlurCPUTile& a, const SSSBlurCPUTile& b)
+		{
+			return (image_layout_morton_spread(uint32_t(a.x0 / SSS_CPU_TILE_SIZE)) | (image_layout_morton_spread(uint32_t(a.y0 / SSS_CPU_TILE_SIZE)) << 1)) < (image_layout_morton_spread(uint32_t(b.x0 / SSS_CPU_TILE_SIZE)) | (image_layout_morton_spread(uint32_t(b.y0 / SSS_CPU_TILE_SIZE)) << 1));
+		});
+
+		burleyTileCosts.reserve(burleyTiles.size());
+		for (const SSSBlurCPUTile& tile : burleyTiles)
+		{
+			burleyTileCosts.push_back(tile.cost);
+		}
+	}
+	m_tileScheduler.begin(workStealingEnabled ? threadCount : 0);
+
+	std::atomic<uint64_t> sampleCount(0U);
+	std::atomic<uint64_t> rejectedSampleCount(0U);
+	std::atomic<uint64_t> wastedSampleCount(0U);
+
+	// SSS_CPU_BURLEY_PASS_BLUR: the blur with the "sampleBudget" is added into the "mainRT"
+	// SSS_CPU_BURLEY_PASS_PILOT: the blur with the "pilotSampleCount" is written into the "pilotRT" and the "pilotErrorRT"
+	// SSS_CPU_BURLEY_PASS_REFINEMENT: the blur with the allocated samples is combined with the "pilotRT" and added into the "mainRT"
+	auto burleyPass = [&](int pass)
+	{
+		std::atomic<int> nextTile(0);
+		std::atomic<int> nextWorkerIndex(0);
+
+		if (workStealingEnabled)
+		{
+			m_tileScheduler.seed(burleyTileCosts);
+		}
+
+		// Coherent Sampling
+		// The pixels of each block are begun together, and the samples of the same index of all pixels of the block are fetched in the order of the texel address (in the layout of the swizzled copy if any)
+		const bool coherentSampling = coherentSamplingEnabled && (SSS_CPU_BURLEY_PASS_BLUR == pass);
+
+		auto worker = [&]()
+		{
+			const int workerIndex = nextWorkerIndex.fetch_add(1);
+
+			std::vector<SSSBlurCPUSource> blockSources;
+			blockSources.reserve(SSS_CPU_COHERENT_BLOCK_SIZE * SSS_CPU_COHERENT_BLOCK_SIZE);
+			subsurface_scattering_disney_blur_state blockStates[SSS_CPU_COHERENT_BLOCK_SIZE * SSS_CPU_COHERENT_BLOCK_SIZE];
+			subsurface_scattering_disney_blur_sample blockSamples[SSS_CPU_COHERENT_BLOCK_SIZE * SSS_CPU_COHERENT_BLOCK_SIZE];
+			int blockX[SSS_CPU_COHERENT_BLOCK_SIZE * SSS_CPU_COHERENT_BLOCK_SIZE];
+			int blockY[SSS_CPU_COHERENT_BLOCK_SIZE * SSS_CPU_COHERENT_BLOCK_SIZE];
+			// (texel address << 8) | pixel index
+			uint64_t fetchList[SSS_CPU_COHERENT_BLOCK_SIZE * SSS_CPU_COHERENT_BLOCK_SIZE];
+
+			// Allocated on the first use of each profile
+			std::vector<std::vector<std::shared_ptr<const SSSKernel>>> localKernels(profileTable.size());
+
+			uint64_t localSampleCount = 0U;
+			uint64_t localRejectedSampleCount = 0U;
+			uint64_t localWastedSampleCount = 0U;
+
+			// The tiles in the order of the classification (shared by all workers) or from the deque of the worker
+			auto nextBurleyTile = [&](int& tileIndex) -> bool
+			{
+				if (workStealingEnabled)
+				{
+					return m_tileScheduler.next(workerIndex, tileIndex);
+				}
+				tileIndex = nextTile.fetch_add(1);
+				return tileIndex < burleyTileCount;
+			};
+
+			for (int tileIndex = -1; nextBurleyTile(tileIndex);)
+			{
+				const SSSBlurCPUTile& tile = burleyTiles[tileIndex];
+
+				// The pilot pass and the refinement pass ignore the sample count buckets
+				const int tileBucket = (SSS_CPU_BURLEY_PASS_BLUR == pass) ? tile.bucket : -1;
+
+				// Without the coherent sampling, the whole tile is one block
+				const bool coherentTile = coherentSampling && (tileBucket < 0);
+				const int blockWidth = coherentTile ? SSS_CPU_COHERENT_BLOCK_SIZE : (tile.x1 - tile.x0);
+				const int blockHeight = coherentTile ? SSS_CPU_COHERENT_BLOCK_SIZE : (tile.y1 - tile.y0);
+
+				for (int blockY0 = tile.y0; blockY0 < tile.y1; blockY0 += blockHeight)
+				{
+					for (int blockX0 = tile.x0; blockX0 < tile.x1; blockX0 += blockWidth)
+					{
+						blockSources.clear();
+						int blockPixelCount = 0;
+						int blockSampleCount = 0;
+
+						for (int y = blockY0; y < std::min(blockY0 + blockHeight, tile.y1); ++y)
+						{
+							for (int x = blockX0; x < std::min(blockX0 + blockWidth, tile.x1); ++x)
+							{
+								// Stencil Test: D3D11_COMPARISON_NOT_EQUAL with StencilRef = 0
+								if ((NULL != stencil) && (0U == (*stencil)(x, y)[0]))
+								{
+									continue;
+								}
+
+								const int profileIndex = (NULL != stencil) ? subsurface_scattering_profile_index_from_stencil((*stencil)(x, y)[0]) : 0;
+								if (profileIndex >= static_cast<int>(profileTable.size()))
+								{
+									continue;
+								}
+								const SSSProfile& profile = profileTable[profileIndex];
+								// The budget of the LOD of the head (see "SSSLodSelector")
+								const int pixelSampleBudget = (NULL != stencil) ? subsurface_scattering_sample_budget_from_stencil((*stencil)(x, y)[0], sampleBudget) : sampleBudget;
+
+								std::vector<std::shared_ptr<const SSSKernel>>& profileKernels = localKernels[profileIndex];
+								if ((NULL != kernelCache) && profileKernels.empty())
+								{
+									profileKernels.resize(3 * SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT * SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT);
+								}
+
+								const SSSBlurCPUSource source = { irradianceRT, depthRT, albedoRT, currProj, m_postscatterEnabled, *inverseCdfLUT, m_inverseCdfMode, profile.scatteringDistance, sequence, kernelCache, profileKernels.data(), stencil, sampleRotation, sampleRadiusOffsetIndex, maskPyramidSource, irradiancePyramidSource, swizzledIrradianceDepthSource, swizzledAlbedoSource, swizzledStencilSource };
+
+								const float2 center_uv((float(x) + 0.5f) / float(width), (float(y) + 0.5f) / float(height));
+
+								if (SSS_CPU_BURLEY_PASS_STOCHASTIC == pass)
+								{
+									const SSSBlurCPUStochasticSource stochasticSource(source, subsurface_scattering_stochastic_sequence_offset(x, y, frameIndex));
+									const float edgeFreeRadius = tileEdgeFreeRadius(x, y);
+
+									subsurface_scattering_disney_blur_state state;
+									subsurface_scattering_disney_blur_result blur;
+									if (!subsurface_scattering_disney_blur_begin<SSS_STOCHASTIC_MAX_SAMPLE_COUNT>(stochasticSource, profile.scatteringDistance, profile.filterRadius, profile.worldScale, pixelsPerSample, stochasticSampleCount, SSS_MIS_MODE_NONE, edgeFreeRadius, center_uv, state, blur))
+									{
+										// Additive Blending: D3D11_BLEND_ONE + D3D11_BLEND_ONE (RGB only)
+										float* dst = mainRT(x, y);
+										dst[0] += blur.radiance.x;
+										dst[1] += blur.radiance.y;
+										dst[2] += blur.radiance.z;
+										continue;
+									}
+
+									for (int sampleIndex = 0; sampleIndex < state.sample_count; ++sampleIndex)
+									{
+										subsurface_scattering_disney_blur_accumulate(stochasticSource, state, subsurface_scattering_disney_blur_generate(stochasticSource, state, sampleIndex));
+									}
+									localSampleCount += static_cast<uint64_t>(state.sample_count);
+									localRejectedSampleCount += static_cast<uint64_t>(state.rejected_sample_count);
+									localWastedSampleCount += static_cast<uint64_t>(state.wasted_sample_count);
+
+									// NOTE: the pixel of which the "sample_count" is zero has no weight
+									const float rcpSampleCount = 1.0f / float(std::max(state.sample_count, 1));
+
+									float* numeratorTexel = stochasticNumeratorRT[0](x, y);
+									numeratorTexel[0] = state.sum_numerator.x * rcpSampleCount;
+									numeratorTexel[1] = state.sum_numerator.y * rcpSampleCount;
+									numeratorTexel[2] = state.sum_numerator.z * rcpSampleCount;
+									numeratorTexel[3] = state.strategy_center_sample_cdf[0];
+
+									float* denominatorTexel = stochasticDenominatorRT[0](x, y);
+									denominatorTexel[0] = state.sum_denominator.x * rcpSampleCount;
+									denominatorTexel[1] = state.sum_denominator.y * rcpSampleCount;
+									denominatorTexel[2] = state.sum_denominator.z * rcpSampleCount;
+									denominatorTexel[3] = 0.0f;
+
+									float* guideTexel = stochasticGuideRT(x, y);
+									guideTexel[0] = state.center_view_space_position_z;
+									guideTexel[1] = albedoRT(x, y)[3];
+									guideTexel[2] = std::max(std::max(profile.scatteringDistance.x, profile.scatteringDistance.y), profile.scatteringDistance.z) * std::max(state.pixels_per_mm.x, state.pixels_per_mm.y);
+									guideTexel[3] = float(state.profile_index);
+									continue;
+								}
+
+								if (SSS_CPU_BURLEY_PASS_PILOT == pass)
+								{
+									const subsurface_scattering_disney_blur_result pilot = subsurface_scattering_disney_blur_estimate(source, profile.scatteringDistance, profile.filterRadius, profile.worldScale, pixelsPerSample, pilotSampleCount, misMode, center_uv);
+									localSampleCount += static_cast<uint64_t>(pilot.sample_count);
+									localRejectedSampleCount += static_cast<uint64_t>(pilot.rejected_sample_count);
+									localWastedSampleCount += static_cast<uint64_t>(pilot.wasted_sample_count);
+
+									float* pilotTexel = pilotRT(x, y);
+									pilotTexel[0] = pilot.radiance.x;
+									pilotTexel[1] = pilot.radiance.y;
+									pilotTexel[2] = pilot.radiance.z;
+									pilotTexel[3] = float(pilot.sample_count);
+
+									float* pilotErrorTexel = pilotErrorRT(x, y);
+									pilotErrorTexel[0] = subsurface_scattering_adaptive_deviation(pilot.standard_error, pilot.sample_count);
+									pilotErrorTexel[1] = float(pilot.sample_count);
+									pilotErrorTexel[2] = (pilot.sample_count > 0) ? 1.0f : 0.0f;
+									continue;
+								}
+
+								float3 radiance;
+								if (SSS_CPU_BURLEY_PASS_REFINEMENT == pass)
+								{
+									const float* pilotTexel = pilotRT(x, y);
+									const int refinementSampleCount = (pilotTexel[3] > 0.0f) ? subsurface_scattering_adaptive_refinement_sample_count(pilotErrorRT(x, y)[0], deviationScale, uniformSampleCount, int(pilotTexel[3]), pixelSampleBudget) : 0;
+
+									radiance = float3(pilotTexel[0], pilotTexel[1], pilotTexel[2]);
+									if (refinementSampleCount > 0)
+									{
+										const subsurface_scattering_disney_blur_result refinement = subsurface_scattering_disney_blur_estimate(source, profile.scatteringDistance, profile.filterRadius, profile.worldScale, pixelsPerSample, refinementSampleCount, misMode, center_uv);
+										localSampleCount += static_cast<uint64_t>(refinement.sample_count);
+										localRejectedSampleCount += static_cast<uint64_t>(refinement.rejected_sample_count);
+										localWastedSampleCount += static_cast<uint64_t>(refinement.wasted_sample_count);
+
+										radiance = refinement.radiance;
+									}
+								}
+								else
+								{
+									// The "SSS_Blur_Interior_PS" or the "SSS_Blur_PS"
+									const float edgeFreeRadius = tileEdgeFreeRadius(x, y);
+									subsurface_scattering_disney_blur_result blur;
+									if (tileBucket >= 0)
+									{
+										// The specialization of the bucket and the texturing mode
+										blur = m_postscatterEnabled ? burleyBucketEstimate<true>(tileBucket, source, profile, edgeFreeRadius, center_uv) : burleyBucketEstimate<false>(tileBucket, source, profile, edgeFreeRadius, center_uv);
+									}
+									else if (coherentTile)
+									{
+										// Deferred to the fetch lists of the block (unless the center is NOT covered)
+										subsurface_scattering_disney_blur_state& state = blockStates[blockPixelCount];
+										if (subsurface_scattering_disney_blur_begin(source, profile.scatteringDistance, profile.filterRadius, profile.worldScale, pixelsPerSample, pixelSampleBudget, misMode, edgeFreeRadius, center_uv, state, blur))
+										{
+											blockSources.push_back(source);
+											blockX[blockPixelCount] = x;
+											blockY[blockPixelCount] = y;
+											blockSampleCount = std::max(blockSampleCount, std::min(state.sample_count, int(SSS_MAX_SAMPLE_BUDGET)));
+											++blockPixelCount;
+											continue;
+										}
+									}
+									else
+									{
+										blur = subsurface_scattering_disney_blur_estimate_interior(source, profile.scatteringDistance, profile.filterRadius, profile.worldScale, pixelsPerSample, pixelSampleBudget, misMode, edgeFreeRadius, center_uv);
+									}
+									localSampleCount += static_cast<uint64_t>(blur.sample_count);
+									localRejectedSampleCount += static_cast<uint64_t>(blur.rejected_sample_count);
+									localWastedSampleCount += static_cast<uint64_t>(blur.wasted_sample_count);
+
+									radiance = blur.radiance;
+								}
+
+								// Additive Blending: D3D11_BLEND_ONE + D3D11_BLEND_ONE (RGB only)
+								float* dst = mainRT(x, y);
+								dst[0] += radiance.x;
+								dst[1] += radiance.y;
+								dst[2] += radiance.z;
+							}
+						}
+
+						// The fetch lists of the block
+						// NOTE: the samples of each pixel are accumulated in the order of the "sample_index", s.t. the result is the same as the "subsurface_scattering_disney_blur_estimate_interior"
+						for (int sampleIndex = 0; sampleIndex < blockSampleCount; ++sampleIndex)
+						{
+							int fetchCount = 0;
+							for (int pixelIndex = 0; pixelIndex < blockPixelCount; ++pixelIndex)
+							{
+								if (sampleIndex < blockStates[pixelIndex].sample_count)
+								{
+									blockSamples[pixelIndex] = subsurface_scattering_disney_blur_generate(blockSources[pixelIndex], blockStates[pixelIndex], sampleIndex);
+
+									const int sampleX = ImageRGBA32F::texelCoord(blockSamples[pixelIndex].sample_uv.x, width);
+									const int sampleY = ImageRGBA32F::texelCoord(blockSamples[pixelIndex].sample_uv.y, height);
+									const uint64_t texelAddress = (NULL != swizzledIrradianceDepthSource) ? static_cast<uint64_t>(swizzledIrradianceDepthSource->texelIndex(sampleX, sampleY)) : (static_cast<uint64_t>(sampleY) * static_cast<uint64_t>(width) + static_cast<uint64_t>(sampleX));
+									fetchList[fetchCount] = (texelAddress << 8) | static_cast<uint64_t>(pixelIndex);
+									++fetchCount;
+								}
+							}
+
+							std::sort(fetchList, fetchList + fetchCount);
+
+							for (int fetchIndex = 0; fetchIndex < fetchCount; ++fetchIndex)
+							{
+								const int pixelIndex = static_cast<int>(fetchList[fetchIndex] & 0xFFU);
+								subsurface_scattering_disney_blur_accumulate(blockSources[pixelIndex], blockStates[pixelIndex], blockSamples[pixelIndex]);
+							}
+						}
+
+						for (int pixelIndex = 0; pixelIndex < blockPixelCount; ++pixelIndex)
+						{
+							const subsurface_scattering_disney_blur_result blur = subsurface_scattering_disney_blur_end(blockSources[pixelIndex], blockStates[pixelIndex]);
+							localSampleCount += static_cast<uint64_t>(blur.sample_count);
+							localRejectedSampleCount += static_cast<uint64_t>(blur.rejected_sample_count);
+							localWastedSampleCount += static_cast<uint64_t>(blur.wasted_sample_count);
+
+							// Additive Blending: D3D11_BLEND_ONE + D3D11_BLEND_ONE (RGB only)
+							float* dst = mainRT(blockX[pixelIndex], blockY[pixelIndex]);
+							dst[0] += blur.radiance.x;
+							dst[1] += blur.radiance.y;
+							dst[2] += blur.radiance.z;
+						}
+					}
+				}
+			}
+
+			sampleCount.fetch_add(localSampleCount);
+			rejectedSampleCount.fetch_add(localRejectedSampleCount);
+			wastedSampleCount.fetch_add(localWastedSampleCount);
+		};
+
+		runWorkers(threadCount, worker);
+	};
+
+	if (samplesPerFrame > 0)
+	{
+		burleyPass(SSS_CPU_BURLEY_PASS_PILOT);
+
+		blockMeanDeviation(pilotErrorRT);
+
+		// The "GenerateMips" of the "pilotErrorRT" on the GPU
+		double sumDeviation = 0.0;
+		double sumPilotSampleCount = 0.0;
+		double coveredPixelCount = 0.0;
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const float* pilotErrorTexel = pilotErrorRT(x, y);
+				sumDeviation += double(pilotErrorTexel[0]);
+				sumPilotSampleCount += double(pilotErrorTexel[1]);
+				coveredPixelCount += double(pilotErrorTexel[2]);
+			}
+		}
+		const float refinementSamplesPerPixel = subsurface_scattering_adaptive_refinement_samples_per_pixel(float(samplesPerFrame), float(coveredPixelCount), float(sumPilotSampleCount));
+		// NOTE: the budget is spread evenly if no error is found by the pilot pass
+		const float2 allocation = solveRefinementAllocation(pilotErrorRT, sampleBudget, (sumDeviation > 0.0) ? (float(SSS_ADAPTIVE_UNIFORM_FRACTION) * refinementSamplesPerPixel) : refinementSamplesPerPixel, double(refinementSamplesPerPixel) * coveredPixelCount);
+		uniformSampleCount = allocation.x;
+		deviationScale = allocation.y;
+
+		burleyPass(SSS_CPU_BURLEY_PASS_REFINEMENT);
+	}
+	else if (stochasticSampleCount > 0)
+	{
+		burleyPass(SSS_CPU_BURLEY_PASS_STOCHASTIC);
+
+		// Denoiser: one row per work item of each iteration, of which the taps are 2^iteration pixels apart
+		int current = 0;
+		for (int iteration = 0; iteration < denoiserIterationCount; ++iteration)
+		{
+			const SSSAtrousCPUSource source = { stochasticNumeratorRT[current], stochasticDenominatorRT[current], stochasticGuideRT };
+			ImageRGBA32F& numeratorRT = stochasticNumeratorRT[1 - current];
+			ImageRGBA32F& denominatorRT = stochasticDenominatorRT[1 - current];
+			const int step = 1 << iteration;
+
+			std::atomic<int> nextRow(0);
+
+			auto worker = [&]()
+			{
+				for (int y = nextRow.fetch_add(1); y < height; y = nextRow.fetch_add(1))
+				{
+					for (int x = 0; x < width; ++x)
+					{
+						// NOTE: the pixel which is NOT estimated by the stochastic pass is never read
+						if (stochasticGuideRT(x, y)[3] < 0.0f)
+						{
+							continue;
+						}
+
+						const subsurface_scattering_atrous_result result = subsurface_scattering_atrous_filter(source, x, y, step);
+
+						float* numeratorTexel = numeratorRT(x, y);
+						numeratorTexel[0] = result.numerator.x;
+						numeratorTexel[1] = result.numerator.y;
+						numeratorTexel[2] = result.numerator.z;
+						numeratorTexel[3] = result.numerator.w;
+
+						float* denominatorTexel = denominatorRT(x, y);
+						denominatorTexel[0] = result.denominator.x;
+						denominatorTexel[1] = result.denominator.y;
+						denominatorTexel[2] = result.denominator.z;
+						denominatorTexel[3] = result.denominator.w;
+					}
+				}
+			};
+
+			runWorkers(std::min(threadCount, height), worker);
+
+			current = 1 - current;
+		}
+
+		// Composite: the "subsurface_scattering_stochastic_resolve" multiplied by the "total_diffuse_reflectance_post_scatter"
+		{
+			std::atomic<int> nextRow(0);
+
+			auto worker = [&]()
+			{
+				for (int y = nextRow.fetch_add(1); y < height; y = nextRow.fetch_add(1))
+				{
+					for (int x = 0; x < width; ++x)
+					{
+						if (stochasticGuideRT(x, y)[3] < 0.0f)
+						{
+							continue;
+						}
+
+						const float* numeratorTexel = stochasticNumeratorRT[current](x, y);
+						const float* denominatorTexel = stochasticDenominatorRT[current](x, y);
+						const float* irradiance = irradianceRT(x, y);
+						const float* albedo = albedoRT(x, y);
+						const float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor = subsurface_scattering_stochastic_resolve(float4(numeratorTexel[0], numeratorTexel[1], numeratorTexel[2], numeratorTexel[3]), float4(denominatorTexel[0], denominatorTexel[1], denominatorTexel[2], denominatorTexel[3]), float3(irradiance[0], irradiance[1], irradiance[2]));
+						float3 radiance = subsurface_scattering_total_diffuse_reflectance_post_scatter_from_albedo(m_postscatterEnabled, float3(albedo[0], albedo[1], albedo[2])) * total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+
+						// Additive Blending: D3D11_BLEND_ONE + D3D11_BLEND_ONE (RGB only)
+						float* dst = mainRT(x, y);
+						dst[0] += radiance.x;
+						dst[1] += radiance.y;
+						dst[2] += radiance.z;
+					}
+				}
+			};
+
+			runWorkers(std::min(threadCount, height), worker);
+		}
+	}
+	else
+	{
+		burleyPass(SSS_CPU_BURLEY_PASS_BLUR);
+	}
+
+	m_sampleCount = sampleCount.load();
+	m_rejectedSampleCount = rejectedSampleCount.load();
+	m_wastedSampleCount = wastedSampleCount.load();
+}
@@ -0,0 +1,317 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSBlurCPU_H_
+#define _SSSBlurCPU_H_ 1
+
+#include <algorithm>
+#include <memory>
+#include "vector_math.h"
+#include "Image.h"
+#include "diffusion_profile_inverse_cdf_lut.h"
+#include "SSSKernelCache.h"
+#include "SSSProfileTable.h"
+#include "SSSSeparableKernel.h"
+#include "subsurface_scattering_low_resolution.h"
+#include "subsurface_scattering_temporal.h"
+#include "subsurface_scattering_adaptive.h"
+#include "subsurface_scattering_tile_classification.h"
+#include "subsurface_scattering_mask_pyramid.h"
+#include "SSSIrradiancePyramid.h"
+#include "SwizzledImage.h"
+#include "SSSTileScheduler.h"
+#include "subsurface_scattering_disney_blur_bucket.h"
+#include "subsurface_scattering_stochastic.h"
+
+// The CPU counterpart of the "SSSBlur" which does NOT depend on the D3D11.
+// The screen is split into tiles which are processed by the worker threads in parallel.
+class SSSBlurCPU
+{
+public:
+	SSSBlurCPU(bool postscatterEnabled,
+		int sampleBudget,
+		int pixelsPerSample,
+		int threadCount = 0);
+	~SSSBlurCPU();
+
+	// mainRT: the radiance is added into the RGB channels (the alpha channel is NOT modified)
+	// irradianceRT: total_diffuse_reflectance_pre_scatter * form_factor
+	// depthRT: the NDC depth (SV_POSITION.z)
+	// stencil: the profile index + 1, and only the pixels of which the stencil is NOT 0 are processed (NULL means profile 0 for all pixels)
+	// albedoRT: the linear albedo (RGB) and the subsurface mask (A)
+	// currProj: the projection matrix of the camera
+	// profiles: copied at the beginning of the blur
+	void go(ImageRGBA32F& mainRT,
+		const ImageRGBA32F& irradianceRT,
+		const ImageR32F& depthRT,
+		const ImageR8U* stencil,
+		const ImageRGBA32F& albedoRT,
+		const float4x4& currProj,
+		const SSSProfileTable& profiles);
+
+	void setPostScatterEnabled(bool postscatterEnabled)
+	{
+		this->m_postscatterEnabled = postscatterEnabled;
+	}
+
+	void setNSamples(int sampleBudget)
+	{
+		this->m_sampleBudget = std::max(1, sampleBudget);
+	}
+
+	// 0 disables the adaptive sampling
+	// The pilot pass estimates the error of each pixel, and the rest of the "samplesPerFrame" is spread across the pixels in proportion to the mean error of their blocks by the refinement pass, which replaces the pilot (see "subsurface_scattering_adaptive.h")
+	// NOTE: the "sampleBudget" is still the maximum sample count of one pixel, and the "samplesPerFrame" is the budget of the pixels of the blur (namely, the low resolution if the resolution is NOT full)
+	void setSamplesPerFrame(int samplesPerFrame)
+	{
+		this->m_samplesPerFrame = std::max(0, samplesPerFrame);
+	}
+
+	void setPixelsPerSample(int pixelsPerSample)
+	{
+		this->m_pixelsPerSample = std::max(4, pixelsPerSample);
+	}
+
+	// 0 means "std::thread::hardware_concurrency"
+	void setThreadCount(int threadCount)
+	{
+		this->m_threadCount = std::max(0, threadCount);
+	}
+
+	// SSS_INVERSE_CDF_MODE_ANALYTIC / SSS_INVERSE_CDF_MODE_LUT_LINEAR / SSS_INVERSE_CDF_MODE_LUT_HERMITE
+	// Analytic by default, since the LUT approximates the inverse CDF (the result is NOT the same as the default)
+	void setInverseCdfMode(int inverseCdfMode)
+	{
+		this->m_inverseCdfMode = inverseCdfMode;
+	}
+
+	// NOTE: the blur which is in progress keeps using the previous LUT
+	void setInverseCdfLUTSize(int inverseCdfLUTSize)
+	{
+		std::atomic_store(&this->m_inverseCdfLUT, std::shared_ptr<const DiffusionProfileInverseCdfLUT>(new DiffusionProfileInverseCdfLUT(inverseCdfLUTSize)));
+	}
+
+	// Off by default, since the center sample cdf is quantized into SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT buckets (the result is NOT the same as the default)
+	// NOTE: the kernel cache is used instead of the "SSS_INVERSE_CDF_MODE"
+	// NOTE: the kernels are keyed by the (scatteringDistance, sequence, sample_count, center cdf bucket), s.t. the profiles, the "setSequence" and the "setNSamples" do NOT need to clear the cache
+	void setKernelCacheEnabled(bool kernelCacheEnabled)
+	{
+		this->m_kernelCacheEnabled = kernelCacheEnabled;
+	}
+
+	// LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY / FIBONACCI / R2 / SOBOL_OWEN / BLUE_NOISE
+	void setSequence(int sequence)
+	{
+		this->m_sequence = sequence;
+	}
+
+	// SSS_MIS_MODE_NONE / SSS_MIS_MODE_BALANCE / SSS_MIS_MODE_POWER
+	// NOTE: the pixels which take fewer than SSS_MIS_MIN_SAMPLE_COUNT samples ignore the MIS
+	void setMisMode(int misMode)
+	{
+		this->m_misMode = misMode;
+	}
+
+	// SSS_BLUR_MODE_BURLEY / SSS_BLUR_MODE_SEPARABLE
+	// NOTE: the separable mode ignores the "sampleBudget", the "pixelsPerSample", the "inverseCdfMode", the "sequence" and the "misMode"
+	void setBlurMode(int blurMode)
+	{
+		this->m_blurMode = blurMode;
+	}
+
+	// SSS_RESOLUTION_FACTOR_FULL / SSS_RESOLUTION_FACTOR_HALF / SSS_RESOLUTION_FACTOR_QUARTER
+	// The irradiance, the depth, the subsurface mask and the stencil are downsampled (depth-aware), blurred at the low resolution and upsampled by the joint bilateral filter guided by the full resolution depth and subsurface mask
+	void setResolutionFactor(int resolutionFactor)
+	{
+		this->m_resolutionFactor = (resolutionFactor >= SSS_RESOLUTION_FACTOR_QUARTER) ? SSS_RESOLUTION_FACTOR_QUARTER : ((resolutionFactor >= SSS_RESOLUTION_FACTOR_HALF) ? SSS_RESOLUTION_FACTOR_HALF : SSS_RESOLUTION_FACTOR_FULL);
+	}
+
+	// The Burley blur only processes the tiles which are NOT empty, and the interior tiles skip the subsurface mask and the profile index of the samples near the center (see "subsurface_scattering_tile_classification.h")
+	// NOTE: the result is exactly the same, and the adaptive sampling and the separable mode ignore the classification
+	void setTileClassificationEnabled(bool tileClassificationEnabled)
+	{
+		this->m_tileClassificationEnabled = tileClassificationEnabled;
+	}
+
+	// The min/max pyramid of the subsurface mask is built once per "go", s.t. the samples of which the footprint is known to be empty (or another profile) skip the fetch of the full resolution, and the pixels of which the whole filter is known to be covered skip the test of all samples (see "subsurface_scattering_mask_pyramid.h")
+	// NOTE: the result is exactly the same, and the separable mode ignores the mask pyramid
+	void setMaskPyramidEnabled(bool maskPyramidEnabled)
+	{
+		this->m_maskPyramidEnabled = maskPyramidEnabled;
+	}
+
+	// The depth-aware mip chain of the irradiance and the view depth is built once per "go", s.t. each sample of the Burley blur fetches the level which matches its share of the disk (see "subsurface_scattering_irradiance_pyramid.h")
+	// NOTE: the result is NOT the same (the irradiance is prefiltered), and the separable mode ignores the irradiance pyramid
+	void setIrradiancePyramidEnabled(bool irradiancePyramidEnabled)
+	{
+		this->m_irradiancePyramidEnabled = irradiancePyramidEnabled;
+	}
+
+	// IMAGE_LAYOUT_ROW_MAJOR / IMAGE_LAYOUT_MORTON / IMAGE_LAYOUT_BLOCK_LINEAR
+	// The irradiance (RGB) and the depth (A), the albedo and the stencil are swizzled once per "go", s.t. the samples of the Burley blur are fetched from the swizzled copies (see "SwizzledImage.h")
+	// NOTE: the result is exactly the same, and the separable mode ignores the layout
+	void setImageLayout(int imageLayout, int blockWidthLog2 = IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_WIDTH_LOG2, int blockHeightLog2 = IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_HEIGHT_LOG2)
+	{
+		this->m_imageLayout = imageLayout;
+		this->m_blockWidthLog2 = std::max(0, std::min(blockWidthLog2, 8));
+		this->m_blockHeightLog2 = std::max(0, std::min(blockHeightLog2, 8));
+	}
+
+	// The tiles of the Burley blur are seeded into the deques of the workers in the order of the predicted cost (the mask coverage x the predicted sample count) and the idle workers steal half of the deque of the busiest worker (see "SSSTileScheduler.h"), instead of one shared queue in the order of the classification
+	// NOTE: the result is exactly the same, and the separable mode ignores the scheduler
+	void setWorkStealingEnabled(bool workStealingEnabled)
+	{
+		this->m_workStealingEnabled = workStealingEnabled;
+	}
+
+	// The pixels of each 4x4 block of the Burley blur (the BLUR pass only) take the samples of the same index together, and the fetches of each sample index are sorted by the texel address (the fetch list), s.t. the neighboring pixels which traverse the disk in the same radial/angular order (and with the same rotation) hit the same cache lines
+	// NOTE: the samples of each pixel are still accumulated in the same order, s.t. the result is exactly the same, and the separable mode ignores the coherent sampling
+	void setCoherentSamplingEnabled(bool coherentSamplingEnabled)
+	{
+		this->m_coherentSamplingEnabled = coherentSamplingEnabled;
+	}
+
+	// The predicted "sample_count" of each tile of the Burley blur (the BLUR pass without the MIS only) is rounded to the nearest bucket (8, 16, 32, 64 or SSS_MAX_SAMPLE_BUDGET samples) which is NOT larger than the budget of any pixel of the tile, and all pixels of the tile are blurred by the specialization of the bucket and the texturing mode (see "subsurface_scattering_disney_blur_bucket.h")
+	// NOTE: the result is NOT the same, and the bucketed tiles ignore the coherent sampling
+	void setSampleCountBucketsEnabled(bool sampleCountBucketsEnabled)
+	{
+		this->m_sampleCountBucketsEnabled = sampleCountBucketsEnabled;
+	}
+
+	// 0 disables the stochastic mode
+	// Each pixel of the Burley blur takes at most "stochasticSampleCount" (1 to SSS_STOCHASTIC_MAX_SAMPLE_COUNT, instead of the "sampleBudget") samples of which the sequence is offset per pixel, and the noise is reconstructed by the iterations of the edge-aware a-trous filter guided by the linear depth, the subsurface mask and the diffusion radius in pixels (see "subsurface_scattering_stochastic.h")
+	// NOTE: the result is NOT the same, the stochastic mode ignores the MIS, the kernel cache, the sample count buckets, the coherent sampling and the adaptive sampling, and the separable mode ignores the stochastic mode
+	void setStochasticSampleCount(int stochasticSampleCount)
+	{
+		this->m_stochasticSampleCount = std::max(0, std::min(stochasticSampleCount, int(SSS_STOCHASTIC_MAX_SAMPLE_COUNT)));
+	}
+
+	// The iterations of the a-trous filter of the stochastic mode (0 keeps the noise)
+	void setDenoiserIterationCount(int denoiserIterationCount)
+	{
+		this->m_denoiserIterationCount = std::max(0, std::min(denoiserIterationCount, int(SSS_ATROUS_MAX_ITERATION_COUNT)));
+	}
+
+	// The sample pattern is rotated by the "subsurface_scattering_sample_rotation" and the radii are offset by the "subsurface_scattering_sample_radius_offset" (the frame 0 is NEITHER rotated NOR offset), s.t. the successive frames can be accumulated (see "subsurface_scattering_temporal.h")
+	void setFrameIndex(uint32_t frameIndex)
+	{
+		this->m_frameIndex = frameIndex;
+	}
+
+	SSSKernelCache& getKernelCache()
+	{
+		return this->m_kernelCache;
+	}
+
+	// The number of the samples of the Burley blur (including the pilot pass) taken by the last "go"
+	uint64_t getSampleCount() const
+	{
+		return this->m_sampleCount;
+	}
+
+	// The number of the samples (of the "getSampleCount") rejected by the subsurface mask or the profile index
+	uint64_t getRejectedSampleCount() const
+	{
+		return this->m_rejectedSampleCount;
+	}
+
+	// The number of the rejected samples which were rejected only after the fetch of the full resolution (namely, NOT decided by the mask pyramid)
+	uint64_t getWastedSampleCount() const
+	{
+		return this->m_wastedSampleCount;
+	}
+
+	// SSS_TILE_CLASS_EMPTY / SSS_TILE_CLASS_INTERIOR / SSS_TILE_CLASS_EDGE
+	// The number of the tiles (SSS_TILE_SIZE x SSS_TILE_SIZE) of the class classified by the last "go" (zero if the classification is NOT used)
+	int getTileCount(int tileClass) const
+	{
+		return this->m_tileCounts[tileClass];
+	}
+
+	// The number of the work items (SSS_CPU_TILE_SIZE x SSS_CPU_TILE_SIZE) of the Burley blur rounded to the bucket by the last "go" (zero if the sample count buckets are NOT used)
+	int getBucketTileCount(int bucket) const
+	{
+		return this->m_bucketTileCounts[bucket];
+	}
+
+	// The workers of the Burley blur of the last "go" (zero if the work stealing is disabled)
+	// NOTE: the low resolution blur is the last "go" of the scheduler if the resolution is NOT full
+	int getWorkerCount() const
+	{
+		return this->m_tileScheduler.getWorkerCount();
+	}
+
+	// Accumulated over the passes (the pilot pass and the refinement pass) of the last "go"
+	const SSSTileSchedulerWorkerStats& getWorkerStats(int workerIndex) const
+	{
+		return this->m_tileScheduler.getWorkerStats(workerIndex);
+	}
+
+private:
+	// The "go" at the resolution of the "mainRT"
+	void blur(ImageRGBA32F& mainRT,
+		const ImageRGBA32F& irradianceRT,
+		const ImageR32F& depthRT,
+		const ImageR8U* stencil,
+		const ImageRGBA32F& albedoRT,
+		const float4x4& currProj,
+		const SSSProfileTable& profiles);
+
+	bool m_postscatterEnabled;
+	int m_sampleBudget;
+	int m_pixelsPerSample;
+	int m_threadCount;
+	int m_inverseCdfMode;
+	std::shared_ptr<const DiffusionProfileInverseCdfLUT> m_inverseCdfLUT;
+	bool m_kernelCacheEnabled;
+	int m_sequence;
+	int m_misMode;
+	SSSKernelCache m_kernelCache;
+	int m_blurMode;
+	// Rebuilt by the "go" when the profiles change
+	SSSSeparableKernel m_separableKernel;
+	int m_resolutionFactor;
+	uint32_t m_frameIndex;
+	int m_samplesPerFrame;
+	uint64_t m_sampleCount;
+	bool m_tileClassificationEnabled;
+	int m_tileCounts[SSS_TILE_CLASS_COUNT];
+	bool m_maskPyramidEnabled;
+	// Rebuilt by each "go" if the mask pyramid is enabled (the images are reused)
+	std::vector<ImageRGBA32F> m_maskPyramid;
+	uint64_t m_rejectedSampleCount;
+	uint64_t m_wastedSampleCount;
+	bool m_irradiancePyramidEnabled;
+	// Rebuilt by each "go" (the images are reused)
+	SSSIrradiancePyramid m_irradiancePyramid;
+	int m_imageLayout;
+	int m_blockWidthLog2;
+	int m_blockHeightLog2;
+	// Rebuilt by each "go" if the layout is NOT IMAGE_LAYOUT_ROW_MAJOR (the images are reused)
+	SwizzledImageRGBA32F m_swizzledIrradianceDepth;
+	SwizzledImageRGBA32F m_swizzledAlbedo;
+	SwizzledImageR8U m_swizzledStencil;
+	bool m_workStealingEnabled;
+	SSSTileScheduler m_tileScheduler;
+	bool m_coherentSamplingEnabled;
+	bool m_sampleCountBucketsEnabled;
+	int m_bucketTileCounts[SSS_SAMPLE_COUNT_BUCKET_COUNT];
+	int m_stochasticSampleCount;
+	int m_denoiserIterationCount;
+};
+
+#endif
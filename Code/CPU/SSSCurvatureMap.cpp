@@ -0,0 +1,284 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include "SSSCurvatureMap.h"
+
+template <typename WORKER>
+static void runWorkers(int threadCount, const WORKER& worker)
+{
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for (int threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+static float3 loadFloat3(const SSSCurvatureMesh& mesh, int vertexIndex, int offset)
+{
+	float value[3];
+	std::memcpy(value, static_cast<const uint8_t*>(mesh.vertices) + static_cast<size_t>(vertexIndex) * static_cast<size_t>(mesh.vertexStride) + offset, sizeof(value));
+	return float3(value[0], value[1], value[2]);
+}
+
+static float2 loadFloat2(const SSSCurvatureMesh& mesh, int vertexIndex, int offset)
+{
+	float value[2];
+	std::memcpy(value, static_cast<const uint8_t*>(mesh.vertices) + static_cast<size_t>(vertexIndex) * static_cast<size_t>(mesh.vertexStride) + offset, sizeof(value));
+	return float2(value[0], value[1]);
+}
+
+static int loadIndex(const SSSCurvatureMesh& mesh, int index)
+{
+	return mesh.indices32 ? static_cast<int>(static_cast<const uint32_t*>(mesh.indices)[index]) : static_cast<int>(static_cast<const uint16_t*>(mesh.indices)[index]);
+}
+
+static float3 normalize3(float3 a)
+{
+	const float length = std::sqrt(dot(a, a));
+	return (length > 0.0f) ? (a * (1.0f / length)) : a;
+}
+
+SSSCurvatureMap::SSSCurvatureMap(int size, int threadCount) : m_size(std::max(1, size)),
+	m_threadCount(std::max(0, threadCount)),
+	m_coveredTexelCount(0)
+{
+}
+
+void SSSCurvatureMap::bake(const SSSCurvatureMesh* meshes, int meshCount)
+{
+	const int threadCount = (m_threadCount > 0) ? m_threadCount : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	const int size = m_size;
+
+	m_map.assign(static_cast<size_t>(size) * static_cast<size_t>(size), 0.0f);
+	std::vector<uint8_t> covered(static_cast<size_t>(size) * static_cast<size_t>(size), uint8_t(0U));
+
+	for (int meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+	{
+		const SSSCurvatureMesh& mesh = meshes[meshIndex];
+		const int triangleCount = mesh.indexCount / 3;
+
+		// The corners of each vertex (in the order of the triangles), s.t. the vertices are processed in parallel without the atomics and the result does NOT depend on the thread count
+		std::vector<int> cornerOffsets(static_cast<size_t>(mesh.vertexCount) + 1U, 0);
+		for (int cornerIndex = 0; cornerIndex < triangleCount * 3; ++cornerIndex)
+		{
+			++cornerOffsets[static_cast<size_t>(loadIndex(mesh, cornerIndex)) + 1U];
+		}
+		for (int vertexIndex = 0; vertexIndex < mesh.vertexCount; ++vertexIndex)
+		{
+			cornerOffsets[vertexIndex + 1] += cornerOffsets[vertexIndex];
+		}
+		std::vector<int> corners(static_cast<size_t>(triangleCount) * 3U);
+		{
+			std::vector<int> cursors(cornerOffsets.begin(), cornerOffsets.end() - 1);
+			for (int cornerIndex = 0; cornerIndex < triangleCount * 3; ++cornerIndex)
+			{
+				corners[cursors[loadIndex(mesh, cornerIndex)]++] = cornerIndex;
+			}
+		}
+
+		// The vertices: one range per work item
+		m_vertexCurvature.assign(mesh.vertexCount, 0.0f);
+		{
+			const int verticesPerTask = 1024;
+			std::atomic<int> nextVertex(0);
+
+			auto worker = [&]()
+			{
+				for (int begin = nextVertex.fetch_add(verticesPerTask); begin < mesh.vertexCount; begin = nextVertex.fetch_add(verticesPerTask))
+				{
+					const int end = std::min(begin + verticesPerTask, mesh.vertexCount);
+					for (int vertexIndex = begin; vertexIndex < end; ++vertexIndex)
+					{
+						const float3 p = loadFloat3(mesh, vertexIndex, mesh.positionOffset);
+						const float3 n = normalize3(loadFloat3(mesh, vertexIndex, mesh.normalOffset));
+
+						// The two edges of each corner (the shared edges are counted once per triangle)
+						float sum = 0.0f;
+						int count = 0;
+						for (int i = cornerOffsets[vertexIndex]; i < cornerOffsets[vertexIndex + 1]; ++i)
+						{
+							const int triangleIndex = corners[i] / 3;
+							const int corner = corners[i] - triangleIndex * 3;
+							for (int edge = 1; edge < 3; ++edge)
+							{
+								const int otherIndex = loadIndex(mesh, triangleIndex * 3 + (corner + edge) % 3);
+								const float3 dp = loadFloat3(mesh, otherIndex, mesh.positionOffset) - p;
+								const float3 dn = normalize3(loadFloat3(mesh, otherIndex, mesh.normalOffset)) - n;
+								const float lengthSquared = dot(dp, dp);
+								if (lengthSquared > 1.0e-20f)
+								{
+									sum += dot(dn, dp) / lengthSquared;
+									++count;
+								}
+							}
+						}
+
+						m_vertexCurvature[vertexIndex] = (count > 0) ? (sum / float(count)) : 0.0f;
+					}
+				}
+			};
+
+			runWorkers(std::min(threadCount, std::max(1, mesh.vertexCount / verticesPerTask)), worker);
+		}
+
+		// The rasterization: one band of SSS_CURVATURE_MAP_ROWS_PER_TASK rows per work item (the triangles are visited in order, s.t. the overlapping texels are deterministic)
+		{
+			const int bandCount = (size + SSS_CURVATURE_MAP_ROWS_PER_TASK - 1) / SSS_CURVATURE_MAP_ROWS_PER_TASK;
+			std::atomic<int> nextBand(0);
+
+			auto worker = [&]()
+			{
+				for (int band = nextBand.fetch_add(1); band < bandCount; band = nextBand.fetch_add(1))
+				{
+					const int bandBegin = band * SSS_CURVATURE_MAP_ROWS_PER_TASK;
+					const int bandEnd = std::min(bandBegin + SSS_CURVATURE_MAP_ROWS_PER_TASK, size);
+
+					for (int triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+					{
+						int vertexIndices[3];
+						float2 texel[3];
+						for (int corner = 0; corner < 3; ++corner)
+						{
+							vertexIndices[corner] = loadIndex(mesh, triangleIndex * 3 + corner);
+							// The texel centers are at the integers
+							const float2 texcoord = loadFloat2(mesh, vertexIndices[corner], mesh.texcoordOffset);
+							texel[corner] = float2(texcoord.x * float(size) - 0.5f, texcoord.y * float(size) - 0.5f);
+						}
+
+						const int yMin = std::max(int(std::ceil(std::min(std::min(texel[0].y, texel[1].y), texel[2].y))), bandBegin);
+						const int yMax = std::min(int(std::floor(std::max(std::max(texel[0].y, texel[1].y), texel[2].y))), bandEnd - 1);
+						if (yMin > yMax)
+						{
+							continue;
+						}
+						const int xMin = std::max(int(std::ceil(std::min(std::min(texel[0].x, texel[1].x), texel[2].x))), 0);
+						const int xMax = std::min(int(std::floor(std::max(std::max(texel[0].x, texel[1].x), texel[2].x))), size - 1);
+
+						const float2 e1 = texel[1] - texel[0];
+						const float2 e2 = texel[2] - texel[0];
+						const float area = e1.x * e2.y - e1.y * e2.x;
+						if (std::abs(area) < 1.0e-12f)
+						{
+							continue;
+						}
+						const float rcpArea = 1.0f / area;
+
+						for (int y = yMin; y <= yMax; ++y)
+						{
+							for (int x = xMin; x <= xMax; ++x)
+							{
+								const float2 p = float2(float(x), float(y)) - texel[0];
+								const float b1 = (p.x * e2.y - p.y * e2.x) * rcpArea;
+								const float b2 = (e1.x * p.y - e1.y * p.x) * rcpArea;
+								const float b0 = 1.0f - b1 - b2;
+								if ((b0 >= -1.0e-5f) && (b1 >= -1.0e-5f) && (b2 >= -1.0e-5f))
+								{
+									const size_t texelIndex = static_cast<size_t>(y) * static_cast<size_t>(size) + static_cast<size_t>(x);
+									m_map[texelIndex] = b0 * m_vertexCurvature[vertexIndices[0]] + b1 * m_vertexCurvature[vertexIndices[1]] + b2 * m_vertexCurvature[vertexIndices[2]];
+									covered[texelIndex] = uint8_t(1U);
+								}
+							}
+						}
+					}
+				}
+			};
+
+			runWorkers(std::min(threadCount, bandCount), worker);
+		}
+	}
+
+	m_coveredTexelCount = 0;
+	for (uint8_t value : covered)
+	{
+		m_coveredTexelCount += (0U != value) ? 1 : 0;
+	}
+
+	// The dilation: each empty texel takes the mean of the neighbors which are filled by the previous passes
+	for (int pass = 0; pass < SSS_CURVATURE_MAP_DILATION_COUNT; ++pass)
+	{
+		std::vector<uint8_t> filled(covered);
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				const size_t texelIndex = static_cast<size_t>(y) * static_cast<size_t>(size) + static_cast<size_t>(x);
+				if (0U != covered[texelIndex])
+				{
+					continue;
+				}
+
+				const int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+				float sum = 0.0f;
+				int count = 0;
+				for (int i = 0; i < 4; ++i)
+				{
+					const int neighborX = x + offsets[i][0];
+					const int neighborY = y + offsets[i][1];
+					if ((neighborX >= 0) && (neighborX < size) && (neighborY >= 0) && (neighborY < size))
+					{
+						const size_t neighborIndex = static_cast<size_t>(neighborY) * static_cast<size_t>(size) + static_cast<size_t>(neighborX);
+						if (0U != covered[neighborIndex])
+						{
+							sum += m_map[neighborIndex];
+							++count;
+						}
+					}
+				}
+
+				if (count > 0)
+				{
+					m_map[texelIndex] = sum / float(count);
+					filled[texelIndex] = uint8_t(1U);
+				}
+			}
+		}
+		covered.swap(filled);
+	}
+}
+
+float SSSCurvatureMap::sample(float2 texcoord) const
+{
+	const int size = m_size;
+	const float x = texcoord.x * float(size) - 0.5f;
+	const float y = texcoord.y * float(size) - 0.5f;
+	const float x0 = std::floor(x);
+	const float y0 = std::floor(y);
+	const float fx = x - x0;
+	const float fy = y - y0;
+
+	auto texel = [&](int tx, int ty) -> float
+	{
+		tx = std::min(std::max(tx, 0), size - 1);
+		ty = std::min(std::max(ty, 0), size - 1);
+		return m_map[static_cast<size_t>(ty) * static_cast<size_t>(size) + static_cast<size_t>(tx)];
+	};
+
+	const int ix = int(x0);
+	const int iy = int(y0);
+	return lerp(lerp(texel(ix, iy), texel(ix + 1, iy), fx), lerp(texel(ix, iy + 1), texel(ix + 1, iy + 1), fx), fy);
+}
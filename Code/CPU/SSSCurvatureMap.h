@@ -0,0 +1,90 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSCurvatureMap_H_
+#define _SSSCurvatureMap_H_ 1
+
+#include <cstdint>
+#include <vector>
+#include "vector_math.h"
+
+// The curvature of the mesh (the input of the "SSSPreintegratedLUT") baked into the texture space.
+//
+// The curvature of each edge is "dot(N_j - N_i, P_j - P_i) / |P_j - P_i|^2" (exactly "1 / radius" for the sphere), and the curvature of each vertex is the mean of its edges.
+// The curvature of the vertices is then rasterized into the texture coordinates (interpolated by the barycentric coordinates), and the empty texels next to the charts are dilated, s.t. the bilinear filter does NOT bleed the empty texels into the seams.
+// The curvature is in 1 / (the units of the mesh), and the concave surfaces are negative (clamped by the lookup of the "SSSPreintegratedLUT").
+#define SSS_CURVATURE_MAP_DEFAULT_SIZE 512
+#define SSS_CURVATURE_MAP_DILATION_COUNT 4
+// The rows of the map per work item of the rasterization
+#define SSS_CURVATURE_MAP_ROWS_PER_TASK 16
+
+// The triangle list of the interleaved vertices (namely, the vertex buffer and the index buffer of the "CDXUTSDKMesh")
+struct SSSCurvatureMesh
+{
+	const void* vertices;
+	int vertexCount;
+	// In bytes
+	int vertexStride;
+	int positionOffset;
+	int normalOffset;
+	int texcoordOffset;
+	const void* indices;
+	int indexCount;
+	bool indices32;
+};
+
+// "curvature_in_mm = curvature_in_units / (1000 * world_scale)" (see "subsurface_scattering_curvature_in_mm" of "Shaders/subsurface_scattering_preintegrated_lut.hlsli")
+inline float subsurface_scattering_curvature_in_mm(float curvature_in_units, float world_scale)
+{
+	const float meters_per_unit = world_scale;
+	return curvature_in_units * (1.0f / (1000.0f * meters_per_unit));
+}
+
+class SSSCurvatureMap
+{
+public:
+	explicit SSSCurvatureMap(int size = SSS_CURVATURE_MAP_DEFAULT_SIZE, int threadCount = 0);
+
+	// All meshes are rasterized into the same map (the later meshes overwrite the overlapping texels)
+	void bake(const SSSCurvatureMesh* meshes, int meshCount);
+
+	// 0 means "std::thread::hardware_concurrency"
+	void setThreadCount(int threadCount) { m_threadCount = std::max(0, threadCount); }
+
+	int getSize() const { return m_size; }
+
+	// Row major: [v][u] (DXGI_FORMAT_R32_FLOAT)
+	const float* getData() const { return m_map.data(); }
+
+	// The texels which are covered by the triangles (NOT the dilated texels)
+	int getCoveredTexelCount() const { return m_coveredTexelCount; }
+
+	// The curvature of the vertices of the last mesh of the "bake"
+	const std::vector<float>& getVertexCurvature() const { return m_vertexCurvature; }
+
+	// The bilinear filter of the "LinearSampler" (D3D11_TEXTURE_ADDRESS_CLAMP) of the GPU path
+	float sample(float2 texcoord) const;
+
+private:
+	int m_size;
+	int m_threadCount;
+	int m_coveredTexelCount;
+	std::vector<float> m_vertexCurvature;
+	std::vector<float> m_map;
+};
+
+#endif
@@ -0,0 +1,95 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "SSSIrradiancePyramid.h"
+#include "SSSProfileTable.h"
+
+SSSIrradiancePyramid::SSSIrradiancePyramid()
+{
+}
+
+void SSSIrradiancePyramid::build(const ImageRGBA32F& irradianceRT,
+	const ImageR32F& depthRT,
+	const ImageR8U* stencil,
+	const ImageRGBA32F& albedoRT,
+	const float4x4& currProj)
+{
+	const int width = irradianceRT.getWidth();
+	const int height = irradianceRT.getHeight();
+	const int levelCount = std::min(subsurface_scattering_mask_pyramid_level_count(width, height), int(SSS_IRRADIANCE_PYRAMID_MAX_LEVEL_COUNT));
+	const int paddedWidth = subsurface_scattering_mask_pyramid_padded_size(width, levelCount);
+	const int paddedHeight = subsurface_scattering_mask_pyramid_padded_size(height, levelCount);
+
+	if ((static_cast<int>(m_irradiance.size()) != levelCount) || (m_irradiance[0].getWidth() != paddedWidth) || (m_irradiance[0].getHeight() != paddedHeight))
+	{
+		m_irradiance.clear();
+		m_viewSpacePositionZ.clear();
+		m_irradiance.reserve(levelCount);
+		m_viewSpacePositionZ.reserve(levelCount);
+		for (int level = 0; level < levelCount; ++level)
+		{
+			m_irradiance.emplace_back(paddedWidth >> level, paddedHeight >> level);
+			m_viewSpacePositionZ.emplace_back(paddedWidth >> level, paddedHeight >> level);
+		}
+	}
+
+	for (int level = 0; level < levelCount; ++level)
+	{
+		ImageRGBA32F& irradianceLevel = m_irradiance[level];
+		ImageR32F& viewSpacePositionZLevel = m_viewSpacePositionZ[level];
+		for (int y = 0; y < irradianceLevel.getHeight(); ++y)
+		{
+			for (int x = 0; x < irradianceLevel.getWidth(); ++x)
+			{
+				subsurface_scattering_irradiance_pyramid_texel texel;
+				if (0 == level)
+				{
+					// The padding replicates the border
+					const int texelX = std::min(x, width - 1);
+					const int texelY = std::min(y, height - 1);
+					const float* irradiance = irradianceRT(texelX, texelY);
+					const int profileIndex = (NULL != stencil) ? subsurface_scattering_profile_index_from_stencil((*stencil)(texelX, texelY)[0]) : 0;
+					// ndcz_to_viewpositionz
+					const float viewSpacePositionZ = currProj.m[3][2] / (depthRT(texelX, texelY)[0] - currProj.m[2][2]);
+					texel = subsurface_scattering_irradiance_pyramid_base(float3(irradiance[0], irradiance[1], irradiance[2]), albedoRT(texelX, texelY)[3], profileIndex, viewSpacePositionZ);
+				}
+				else
+				{
+					const ImageRGBA32F& previousIrradianceLevel = m_irradiance[level - 1];
+					const ImageR32F& previousViewSpacePositionZLevel = m_viewSpacePositionZ[level - 1];
+					subsurface_scattering_irradiance_pyramid_texel children[4];
+					for (int childIndex = 0; childIndex < 4; ++childIndex)
+					{
+						const int childX = 2 * x + (childIndex & 1);
+						const int childY = 2 * y + (childIndex >> 1);
+						const float* irradiance = previousIrradianceLevel(childX, childY);
+						children[childIndex].irradiance = float4(irradiance[0], irradiance[1], irradiance[2], irradiance[3]);
+						children[childIndex].view_space_position_z = previousViewSpacePositionZLevel(childX, childY)[0];
+					}
+					texel = subsurface_scattering_irradiance_pyramid_reduce(children, level);
+				}
+
+				float* dst = irradianceLevel(x, y);
+				dst[0] = texel.irradiance.x;
+				dst[1] = texel.irradiance.y;
+				dst[2] = texel.irradiance.z;
+				dst[3] = texel.irradiance.w;
+				viewSpacePositionZLevel(x, y)[0] = texel.view_space_position_z;
+			}
+		}
+	}
+}
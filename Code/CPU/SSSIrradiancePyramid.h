@@ -0,0 +1,56 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSIrradiancePyramid_H_
+#define _SSSIrradiancePyramid_H_ 1
+
+#include <vector>
+#include "vector_math.h"
+#include "Image.h"
+#include "subsurface_scattering_irradiance_pyramid.h"
+
+// The CPU builder of the "Shaders/subsurface_scattering_irradiance_pyramid.hlsli" (the "SSS_Blur_IrradiancePyramidBase_PS" and the "SSS_Blur_IrradiancePyramidReduce_PS" of the "SSSIrradiancePyramidBuilder")
+//
+// Each level is stored as two images: (total_diffuse_reflectance_pre_scatter_multiply_form_factor, profile_index) and the view depth.
+// The layout is the same as the mask pyramid (see "subsurface_scattering_mask_pyramid.h"), s.t. the texel of the pixel (x, y) at the level is (x >> level, y >> level).
+class SSSIrradiancePyramid
+{
+public:
+	SSSIrradiancePyramid();
+
+	// The render targets of the blur (the same as the "SSSBlurCPU::go")
+	// NOTE: the images are reused if the size does NOT change
+	void build(const ImageRGBA32F& irradianceRT,
+		const ImageR32F& depthRT,
+		const ImageR8U* stencil,
+		const ImageRGBA32F& albedoRT,
+		const float4x4& currProj);
+
+	int getLevelCount() const { return static_cast<int>(m_irradiance.size()); }
+
+	// The "SSS_IRRADIANCE_PYRAMID_SOURCE"
+	const ImageRGBA32F& getIrradiance(int level) const { return m_irradiance[level]; }
+
+	// The "SSS_IRRADIANCE_PYRAMID_VIEW_SPACE_POSITION_Z_SOURCE"
+	const ImageR32F& getViewSpacePositionZ(int level) const { return m_viewSpacePositionZ[level]; }
+
+private:
+	std::vector<ImageRGBA32F> m_irradiance;
+	std::vector<ImageR32F> m_viewSpacePositionZ;
+};
+
+#endif
@@ -0,0 +1,200 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <cstring>
+#include "SSSKernelCache.h"
+#include "subsurface_scattering_disney_blur.h"
+#include "subsurface_scattering_temporal.h"
+
+// The kernels are baked with the analytic inverse CDF
+struct SSSKernelCacheAnalyticSource
+{
+	int sequence;
+	int radiusOffsetIndex;
+
+	float2 sample_sequence(int sample_count, int sample_index) const
+	{
+		return subsurface_scattering_sample_sequence_offset(low_discrepancy_sequence_2d(sequence, uint32_t(sample_index), uint32_t(sample_count)), subsurface_scattering_sample_radius_offset(radiusOffsetIndex), sample_count);
+	}
+
+	float diffusion_profile_sample_r(float d, float cdf) const
+	{
+		return ::diffusion_profile_sample_r(d, cdf);
+	}
+};
+
+bool SSSKernelCache::Key::operator==(const Key& other) const
+{
+	return (0 == std::memcmp(this->scatteringDistance, other.scatteringDistance, sizeof(this->scatteringDistance))) && (this->sequence == other.sequence) && (this->sampleCount == other.sampleCount) && (this->centerCdfBucket == other.centerCdfBucket) && (this->radiusOffsetIndex == other.radiusOffsetIndex);
+}
+
+size_t SSSKernelCache::KeyHash::operator()(const Key& key) const
+{
+	// FNV-1a
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&key);
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < sizeof(Key); ++i)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	}
+	return static_cast<size_t>(hash);
+}
+
+SSSKernelCache::SSSKernelCache(size_t memoryCap) : m_memoryCap(memoryCap),
+	m_memoryUsage(0U),
+	m_hitCount(0U),
+	m_missCount(0U),
+	m_evictionCount(0U)
+{
+}
+
+SSSKernelCache::~SSSKernelCache()
+{
+}
+
+void SSSKernelCache::bake(SSSKernel& kernel)
+{
+	const SSSKernelCacheAnalyticSource source = { kernel.sequence, kernel.radiusOffsetIndex };
+
+	const float3 scatteringDistance = kernel.scatteringDistance;
+	const float d = std::max(std::max(scatteringDistance.x, scatteringDistance.y), scatteringDistance.z);
+	const float center_sample_cdf = float(kernel.centerCdfBucket) * (1.0f / float(SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT - 1));
+
+	kernel.samples.resize(kernel.sampleCount);
+	for (int sample_index = 0; sample_index < kernel.sampleCount; ++sample_index)
+	{
+		kernel.samples[sample_index] = subsurface_scattering_disney_kernel_sample(source, d, center_sample_cdf, kernel.sampleCount, sample_index);
+	}
+}
+
+size_t SSSKernelCache::memoryUsage(const SSSKernel& kernel)
+{
+	return sizeof(SSSKernel) + sizeof(float4) * kernel.samples.size();
+}
+
+std::shared_ptr<const SSSKernel> SSSKernelCache::get(float3 scatteringDistance, int sequence, int sampleCount, int centerCdfBucket, int radiusOffsetIndex)
+{
+	Key key;
+	// NOTE: the padding is zeroed, s.t. the "memcmp" and the hash are well-defined
+	std::memset(&key, 0, sizeof(Key));
+	key.scatteringDistance[0] = scatteringDistance.x;
+	key.scatteringDistance[1] = scatteringDistance.y;
+	key.scatteringDistance[2] = scatteringDistance.z;
+	key.sequence = sequence;
+	key.sampleCount = std::min(std::max(sampleCount, 1), int(SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT));
+	key.centerCdfBucket = std::min(std::max(centerCdfBucket, 0), int(SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT - 1));
+	key.radiusOffsetIndex = std::min(std::max(radiusOffsetIndex, 0), int(SSS_TEMPORAL_SAMPLE_RADIUS_OFFSET_COUNT - 1));
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto found = m_entries.find(key);
+		if (m_entries.end() != found)
+		{
+			++m_hitCount;
+			m_lru.splice(m_lru.begin(), m_lru, found->second);
+			return found->second->second;
+		}
+
+		++m_missCount;
+	}
+
+	// Bake outside of the lock, s.t. the other threads are NOT blocked
+	std::shared_ptr<SSSKernel> kernel(new SSSKernel());
+	kernel->scatteringDistance = scatteringDistance;
+	kernel->sequence = key.sequence;
+	kernel->sampleCount = key.sampleCount;
+	kernel->centerCdfBucket = key.centerCdfBucket;
+	kernel->radiusOffsetIndex = key.radiusOffsetIndex;
+	bake(*kernel);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Another thread may have baked the same kernel in the meantime
+		auto found = m_entries.find(key);
+		if (m_entries.end() != found)
+		{
+			m_lru.splice(m_lru.begin(), m_lru, found->second);
+			return found->second->second;
+		}
+
+		m_lru.emplace_front(key, kernel);
+		m_entries.emplace(key, m_lru.begin());
+		m_memoryUsage += memoryUsage(*kernel);
+		evict();
+	}
+
+	return kernel;
+}
+
+void SSSKernelCache::evict()
+{
+	// NOTE: the most recently inserted entry is never evicted, s.t. the cache is still usable when the cap is smaller than one kernel
+	while ((m_memoryUsage > m_memoryCap) && (m_lru.size() > 1U))
+	{
+		m_memoryUsage -= memoryUsage(*m_lru.back().second);
+		m_entries.erase(m_lru.back().first);
+		m_lru.pop_back();
+		++m_evictionCount;
+	}
+}
+
+void SSSKernelCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.clear();
+	m_lru.clear();
+	m_memoryUsage = 0U;
+}
+
+void SSSKernelCache::setMemoryCap(size_t memoryCap)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_memoryCap = memoryCap;
+	evict();
+}
+
+size_t SSSKernelCache::getMemoryCap() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_memoryCap;
+}
+
+size_t SSSKernelCache::getMemoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_memoryUsage;
+}
+
+uint64_t SSSKernelCache::getHitCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_hitCount;
+}
+
+uint64_t SSSKernelCache::getMissCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_missCount;
+}
+
+uint64_t SSSKernelCache::getEvictionCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_evictionCount;
+}
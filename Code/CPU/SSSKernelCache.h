@@ -0,0 +1,130 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSKernelCache_H_
+#define _SSSKernelCache_H_ 1
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "vector_math.h"
+#include "low_discrepancy_sequence.h"
+
+// The counterpart of "Shaders/subsurface_scattering_kernel_cache.hlsli"
+//
+// The points of the sequence, "r", "theta" and "rcp_pdf" of the blur only depend on the (scatteringDistance, sequence, sample_count, center_sample_cdf, radius offset of the frame).
+// The "center_sample_cdf" is quantized (rounded down) into buckets, s.t. the kernels can be baked once and reused by all pixels.
+// NOTE: rounding down is safe since the samples between the quantized and the exact center sample radius fall inside the center pixel anyway.
+//
+// Each sample of the kernel is (offset_in_mm.x, offset_in_mm.y, r, rcp_pdf) where offset_in_mm = (cos(theta), sin(theta)) * r.
+#define SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT 64
+#define SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT 80
+#define SSS_KERNEL_CACHE_DEFAULT_MEMORY_CAP (8U * 1024U * 1024U)
+
+inline float subsurface_scattering_kernel_cache_center_sample_cdf(float center_sample_cdf)
+{
+	return std::floor(saturate(center_sample_cdf) * float(SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT - 1)) * (1.0f / float(SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT - 1));
+}
+
+inline int subsurface_scattering_kernel_cache_center_cdf_bucket(float quantized_center_sample_cdf)
+{
+	// NOTE: "+ 0.5" to be robust to the rounding of the quantized value
+	return int(quantized_center_sample_cdf * float(SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT - 1) + 0.5f);
+}
+
+// The layout of the "Buffer<float4>" of the GPU path: the kernels of all sample counts are packed without gaps
+// NOTE: the GPU path bakes the kernels for "d = 1" and scales them by "d", s.t. one buffer is shared by all profiles
+inline int subsurface_scattering_kernel_cache_offset(int center_cdf_bucket, int sample_count)
+{
+	return center_cdf_bucket * ((SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT * (SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT + 1)) / 2) + (sample_count * (sample_count - 1)) / 2;
+}
+
+#define SSS_KERNEL_CACHE_GPU_SAMPLE_COUNT (SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT * ((SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT * (SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT + 1)) / 2))
+
+struct SSSKernel
+{
+	float3 scatteringDistance;
+	// LOW_DISCREPANCY_SEQUENCE_*
+	int sequence;
+	int sampleCount;
+	int centerCdfBucket;
+	// [0, SSS_TEMPORAL_SAMPLE_RADIUS_OFFSET_COUNT) of the "subsurface_scattering_sample_radius_offset_index"
+	int radiusOffsetIndex;
+	std::vector<float4> samples;
+};
+
+// Thread safe. The entries are shared, s.t. an entry which is evicted (or cleared) remains valid for the users which still hold it.
+class SSSKernelCache
+{
+public:
+	explicit SSSKernelCache(size_t memoryCap = SSS_KERNEL_CACHE_DEFAULT_MEMORY_CAP);
+	~SSSKernelCache();
+
+	// Bake the kernel on miss (with the analytic inverse CDF)
+	std::shared_ptr<const SSSKernel> get(float3 scatteringDistance, int sequence, int sampleCount, int centerCdfBucket, int radiusOffsetIndex);
+
+	void clear();
+
+	void setMemoryCap(size_t memoryCap);
+
+	size_t getMemoryCap() const;
+	size_t getMemoryUsage() const;
+	uint64_t getHitCount() const;
+	uint64_t getMissCount() const;
+	uint64_t getEvictionCount() const;
+
+	static void bake(SSSKernel& kernel);
+
+private:
+	struct Key
+	{
+		float scatteringDistance[3];
+		int sequence;
+		int sampleCount;
+		int centerCdfBucket;
+		int radiusOffsetIndex;
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	typedef std::list<std::pair<Key, std::shared_ptr<const SSSKernel>>> LRUList;
+
+	static size_t memoryUsage(const SSSKernel& kernel);
+
+	void evict();
+
+	mutable std::mutex m_mutex;
+	// The most recently used entry is at the front
+	LRUList m_lru;
+	std::unordered_map<Key, LRUList::iterator, KeyHash> m_entries;
+	size_t m_memoryCap;
+	size_t m_memoryUsage;
+	uint64_t m_hitCount;
+	uint64_t m_missCount;
+	uint64_t m_evictionCount;
+};
+
+#endif
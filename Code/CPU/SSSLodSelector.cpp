@@ -0,0 +1,187 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "math_consts.h"
+#include "SSSLodSelector.h"
+
+SSSLodBounds subsurface_scattering_lod_bounds(const SSSCurvatureMesh* meshes, int meshCount)
+{
+	float3 minPosition(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+	float3 maxPosition(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+	std::vector<float3> positions;
+	for (int meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+	{
+		const SSSCurvatureMesh& mesh = meshes[meshIndex];
+		for (int vertexIndex = 0; vertexIndex < mesh.vertexCount; ++vertexIndex)
+		{
+			float value[3];
+			std::memcpy(value, static_cast<const uint8_t*>(mesh.vertices) + static_cast<size_t>(vertexIndex) * static_cast<size_t>(mesh.vertexStride) + mesh.positionOffset, sizeof(value));
+			const float3 position(value[0], value[1], value[2]);
+			minPosition = float3(std::min(minPosition.x, position.x), std::min(minPosition.y, position.y), std::min(minPosition.z, position.z));
+			maxPosition = max(maxPosition, position);
+			positions.push_back(position);
+		}
+	}
+
+	SSSLodBounds bounds;
+	bounds.center = (positions.empty()) ? float3(0.0f, 0.0f, 0.0f) : ((minPosition + maxPosition) * 0.5f);
+	bounds.radius = 0.0f;
+	for (const float3& position : positions)
+	{
+		const float3 offset = position - bounds.center;
+		bounds.radius = std::max(bounds.radius, std::sqrt(dot(offset, offset)));
+	}
+	return bounds;
+}
+
+const char* subsurface_scattering_lod_tier_name(int tier)
+{
+	switch (tier)
+	{
+	case SSS_LOD_TIER_FULL:
+		return "Full";
+	case SSS_LOD_TIER_REDUCED:
+		return "Reduced";
+	case SSS_LOD_TIER_PREINTEGRATED:
+		return "Pre-Integrated";
+	case SSS_LOD_TIER_NONE:
+		return "None";
+	default:
+		return "Unknown";
+	}
+}
+
+SSSLodSelector::SSSLodSelector() : m_fullFilterRadiusInPixels(SSS_LOD_DEFAULT_FULL_FILTER_RADIUS_IN_PIXELS),
+	m_reducedFilterRadiusInPixels(SSS_LOD_DEFAULT_REDUCED_FILTER_RADIUS_IN_PIXELS),
+	m_minPixelCount(SSS_LOD_DEFAULT_MIN_PIXEL_COUNT),
+	m_hysteresis(SSS_LOD_DEFAULT_HYSTERESIS),
+	m_view(),
+	m_proj(),
+	m_width(0),
+	m_height(0),
+	m_transitionCount(0)
+{
+	std::fill(m_headCounts, m_headCounts + SSS_LOD_TIER_COUNT, 0);
+	std::fill(m_pixelCounts, m_pixelCounts + SSS_LOD_TIER_COUNT, uint64_t(0U));
+}
+
+void SSSLodSelector::beginFrame(const float4x4& view, const float4x4& proj, int width, int height)
+{
+	m_view = view;
+	m_proj = proj;
+	m_width = width;
+	m_height = height;
+
+	std::fill(m_headCounts, m_headCounts + SSS_LOD_TIER_COUNT, 0);
+	std::fill(m_pixelCounts, m_pixelCounts + SSS_LOD_TIER_COUNT, uint64_t(0U));
+	m_transitionCount = 0;
+}
+
+SSSLodSelection SSSLodSelector::select(int headIndex, const SSSLodBounds& bounds, const SSSProfile& profile)
+{
+	// The view space position of the center (row vector)
+	const float3 center(
+		bounds.center.x * m_view.m[0][0] + bounds.center.y * m_view.m[1][0] + bounds.center.z * m_view.m[2][0] + m_view.m[3][0],
+		bounds.center.x * m_view.m[0][1] + bounds.center.y * m_view.m[1][1] + bounds.center.z * m_view.m[2][1] + m_view.m[3][1],
+		bounds.center.x * m_view.m[0][2] + bounds.center.y * m_view.m[1][2] + bounds.center.z * m_view.m[2][2] + m_view.m[3][2]);
+
+	SSSLodSelection selection;
+	selection.x0 = 0;
+	selection.y0 = 0;
+	selection.x1 = 0;
+	selection.y1 = 0;
+	selection.pixelCount = 0.0f;
+	selection.pixelsPerMm = 0.0f;
+	selection.filterRadiusInPixels = 0.0f;
+
+	if (center.z > -bounds.radius)
+	{
+		// NOTE: the camera within the sphere sees the whole viewport
+		const float viewSpacePositionZ = std::max(center.z, 0.5f * bounds.radius);
+		float x0 = 0.0f;
+		float y0 = 0.0f;
+		float x1 = float(m_width);
+		float y1 = float(m_height);
+		if (center.z > bounds.radius)
+		{
+			// The tangent of the half angle of the cone which encloses the sphere
+			const float rcpDistance = 1.0f / std::sqrt(center.z * center.z - bounds.radius * bounds.radius);
+			const float halfWidth = 0.5f * float(m_width) * m_proj.m[0][0] * bounds.radius * rcpDistance;
+			const float halfHeight = 0.5f * float(m_height) * m_proj.m[1][1] * bounds.radius * rcpDistance;
+			const float centerX = (0.5f + 0.5f * center.x * m_proj.m[0][0] / center.z) * float(m_width);
+			const float centerY = (0.5f - 0.5f * center.y * m_proj.m[1][1] / center.z) * float(m_height);
+			x0 = std::max(centerX - halfWidth, 0.0f);
+			y0 = std::max(centerY - halfHeight, 0.0f);
+			x1 = std::min(centerX + halfWidth, float(m_width));
+			y1 = std::min(centerY + halfHeight, float(m_height));
+		}
+
+		if ((x1 > x0) && (y1 > y0))
+		{
+			selection.x0 = int(std::floor(x0));
+			selection.y0 = int(std::floor(y0));
+			selection.x1 = int(std::ceil(x1));
+			selection.y1 = int(std::ceil(y1));
+			selection.pixelCount = float(PI / 4.0) * (x1 - x0) * (y1 - y0);
+		}
+
+		// The same "pixels_per_mm" as the "subsurface_scattering_disney_blur" (without the subsurface mask)
+		const float mmsPerUnit = 1000.0f * profile.worldScale;
+		selection.pixelsPerMm = float(m_height) * 0.5f * m_proj.m[1][1] * (1.0f / viewSpacePositionZ) * (1.0f / mmsPerUnit);
+		selection.filterRadiusInPixels = profile.filterRadius * selection.pixelsPerMm;
+	}
+
+	if (headIndex >= static_cast<int>(m_previousTiers.size()))
+	{
+		m_previousTiers.resize(static_cast<size_t>(headIndex) + 1U, -1);
+	}
+	const int previousTier = m_previousTiers[headIndex];
+
+	// The boundary between the tier "boundary" and the tier "boundary + 1": the head of the more detailed side keeps its tier until the metric falls below "(1 - hysteresis) * threshold", while the other head needs "(1 + hysteresis) * threshold"
+	auto detailed = [&](int boundary, float metric, float threshold) -> bool
+	{
+		const float scale = (previousTier < 0) ? 1.0f : ((previousTier <= boundary) ? (1.0f - m_hysteresis) : (1.0f + m_hysteresis));
+		return metric >= (threshold * scale);
+	};
+
+	if ((selection.pixelCount <= 0.0f) || (!detailed(SSS_LOD_TIER_PREINTEGRATED, selection.pixelCount, m_minPixelCount)))
+	{
+		selection.tier = SSS_LOD_TIER_NONE;
+	}
+	else if (detailed(SSS_LOD_TIER_FULL, selection.filterRadiusInPixels, m_fullFilterRadiusInPixels))
+	{
+		selection.tier = SSS_LOD_TIER_FULL;
+	}
+	else if (detailed(SSS_LOD_TIER_REDUCED, selection.filterRadiusInPixels, m_reducedFilterRadiusInPixels))
+	{
+		selection.tier = SSS_LOD_TIER_REDUCED;
+	}
+	else
+	{
+		selection.tier = SSS_LOD_TIER_PREINTEGRATED;
+	}
+
+	m_transitionCount += ((previousTier >= 0) && (previousTier != selection.tier)) ? 1 : 0;
+	m_previousTiers[headIndex] = selection.tier;
+
+	++m_headCounts[selection.tier];
+	m_pixelCounts[selection.tier] += static_cast<uint64_t>(selection.pixelCount + 0.5f);
+	return selection;
+}
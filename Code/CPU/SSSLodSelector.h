@@ -0,0 +1,116 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSLodSelector_H_
+#define _SSSLodSelector_H_ 1
+
+#include <cstdint>
+#include <vector>
+#include "vector_math.h"
+#include "SSSProfileTable.h"
+#include "SSSCurvatureMap.h"
+
+// The level of detail of the subsurface scattering of each head, selected by the coverage of the head on the screen:
+//    SSS_LOD_TIER_FULL: the blur with the full sample budget
+//    SSS_LOD_TIER_REDUCED: the blur of which the budget is divided by the SSS_REDUCED_SAMPLE_BUDGET_DIVISOR (the "reduced budget" bit of the stencil, see "SSSProfileTable.h")
+//    SSS_LOD_TIER_PREINTEGRATED: NOT blurred, but shaded by the "SSSPreintegratedLUT"
+//    SSS_LOD_TIER_NONE: NOT blurred, and shaded without the subsurface scattering
+// The FULL, REDUCED and PREINTEGRATED tiers are split by the filter radius of the profile in pixels (namely, the width of the blur on the screen), while the NONE tier is split by the number of the pixels of the head.
+// Each threshold is widened by the hysteresis against the tier of the previous frame, s.t. the head near the threshold does NOT flicker between the tiers.
+#define SSS_LOD_TIER_FULL 0
+#define SSS_LOD_TIER_REDUCED 1
+#define SSS_LOD_TIER_PREINTEGRATED 2
+#define SSS_LOD_TIER_NONE 3
+#define SSS_LOD_TIER_COUNT 4
+#define SSS_LOD_DEFAULT_FULL_FILTER_RADIUS_IN_PIXELS 16.0f
+#define SSS_LOD_DEFAULT_REDUCED_FILTER_RADIUS_IN_PIXELS 4.0f
+#define SSS_LOD_DEFAULT_MIN_PIXEL_COUNT 400.0f
+// The relative width of the band around each threshold
+#define SSS_LOD_DEFAULT_HYSTERESIS 0.2f
+
+// The bounding sphere of the head (in the units of the mesh)
+struct SSSLodBounds
+{
+	float3 center;
+	float radius;
+};
+
+struct SSSLodSelection
+{
+	int tier;
+	// At the center of the head (the same "pixels_per_mm" as the blur)
+	float pixelsPerMm;
+	float filterRadiusInPixels;
+	// The projected bounds (clamped to the viewport) and the estimated number of the pixels of the head (the ellipse inscribed in the bounds)
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+	float pixelCount;
+};
+
+// The bounding sphere of the vertices of the meshes (the center of the axis aligned bounding box)
+SSSLodBounds subsurface_scattering_lod_bounds(const SSSCurvatureMesh* meshes, int meshCount);
+
+const char* subsurface_scattering_lod_tier_name(int tier);
+
+// One selector per renderer: the state of the hysteresis is indexed by the head, and the counters are reset by the "beginFrame".
+class SSSLodSelector
+{
+public:
+	SSSLodSelector();
+
+	void setFullFilterRadiusInPixels(float fullFilterRadiusInPixels) { m_fullFilterRadiusInPixels = fullFilterRadiusInPixels; }
+	void setReducedFilterRadiusInPixels(float reducedFilterRadiusInPixels) { m_reducedFilterRadiusInPixels = reducedFilterRadiusInPixels; }
+	void setMinPixelCount(float minPixelCount) { m_minPixelCount = minPixelCount; }
+	void setHysteresis(float hysteresis) { m_hysteresis = saturate(hysteresis); }
+
+	// Forget the tiers of the previous frames (namely, the next selection of each head has no hysteresis)
+	void reset() { m_previousTiers.clear(); }
+
+	// view, proj: row_major, the same as the "currProj" of the blur
+	void beginFrame(const float4x4& view, const float4x4& proj, int width, int height);
+
+	// bounds: in the world space
+	SSSLodSelection select(int headIndex, const SSSLodBounds& bounds, const SSSProfile& profile);
+
+	// The counters of the current frame
+	int getHeadCount(int tier) const { return m_headCounts[tier]; }
+	uint64_t getPixelCount(int tier) const { return m_pixelCounts[tier]; }
+	// The heads of which the tier is different from the previous frame
+	int getTransitionCount() const { return m_transitionCount; }
+
+private:
+	float m_fullFilterRadiusInPixels;
+	float m_reducedFilterRadiusInPixels;
+	float m_minPixelCount;
+	float m_hysteresis;
+
+	float4x4 m_view;
+	float4x4 m_proj;
+	int m_width;
+	int m_height;
+
+	// -1 means no previous frame
+	std::vector<int> m_previousTiers;
+
+	int m_headCounts[SSS_LOD_TIER_COUNT];
+	uint64_t m_pixelCounts[SSS_LOD_TIER_COUNT];
+	int m_transitionCount;
+};
+
+#endif
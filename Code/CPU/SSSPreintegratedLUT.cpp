@@ -0,0 +1,133 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <atomic>
+#include <thread>
+#include "SSSPreintegratedLUT.h"
+#include "subsurface_scattering_disney_blur.h"
+
+// The row "curvature_index" of the slice of the profile
+// The weights of the geodesic angles only depend on the curvature, s.t. they are shared by all "N.L" of the row.
+static void bakeRow(float3 scatteringDistance, int size, int curvatureIndex, float4* row)
+{
+	const float h = 1.0f / float(size - 1);
+	const float d = std::max(std::max(scatteringDistance.x, scatteringDistance.y), scatteringDistance.z);
+
+	// The same mapping as the "subsurface_scattering_preintegrated_lut"
+	const float t = h * float(curvatureIndex);
+	const float curvature = (t * t) * (SSS_PREINTEGRATED_LUT_MAX_CURVATURE / d);
+
+	if (!(curvature > 0.0f))
+	{
+		for (int i = 0; i < size; ++i)
+		{
+			const float ndotl = saturate(-1.0f + 2.0f * h * float(i));
+			row[i] = float4(ndotl, ndotl, ndotl, 0.0f);
+		}
+		return;
+	}
+
+	// The sphere of which the radius is "1 / curvature" (in mm)
+	// NOTE: the geodesic angle beyond the radius of SSS_PREINTEGRATED_LUT_INTEGRATION_CDF of the widest channel is negligible
+	const float radius = 1.0f / curvature;
+	const float maxAlpha = std::min(diffusion_profile_sample_r(d, SSS_PREINTEGRATED_LUT_INTEGRATION_CDF) * curvature, float(PI));
+	const float stepAlpha = maxAlpha * (1.0f / float(SSS_PREINTEGRATED_LUT_INTEGRATION_STEP_COUNT));
+	const float3 S = float3(1.0f, 1.0f, 1.0f) / scatteringDistance;
+
+	std::vector<float> cosAlpha(SSS_PREINTEGRATED_LUT_INTEGRATION_STEP_COUNT);
+	std::vector<float> sinAlpha(SSS_PREINTEGRATED_LUT_INTEGRATION_STEP_COUNT);
+	std::vector<float3> weights(SSS_PREINTEGRATED_LUT_INTEGRATION_STEP_COUNT);
+	float3 weightSum(0.0f, 0.0f, 0.0f);
+	for (int k = 0; k < SSS_PREINTEGRATED_LUT_INTEGRATION_STEP_COUNT; ++k)
+	{
+		// The midpoint rule, s.t. the center (alpha = 0) is never evaluated
+		const float alpha = stepAlpha * (float(k) + 0.5f);
+		cosAlpha[k] = std::cos(alpha);
+		sinAlpha[k] = std::sin(alpha);
+
+		// The 2D profile is "pdf(r) / (2 * PI * r)" of which the chord "r" is the distance through the sphere, and the area of the ring is "2 * PI * radius^2 * sin(alpha) * dalpha"
+		// NOTE: the constants are cancelled by the normalization
+		const float r = 2.0f * radius * std::sin(0.5f * alpha);
+		weights[k] = diffusion_profile_evaluate_pdf(S, r) * (sinAlpha[k] / r);
+		weightSum += weights[k];
+	}
+
+	const float3 rcpNormalization = float3(1.0f, 1.0f, 1.0f) / (weightSum * float(2.0 * PI));
+	for (int i = 0; i < size; ++i)
+	{
+		const float cosTheta = std::min(std::max(-1.0f + 2.0f * h * float(i), -1.0f), 1.0f);
+		const float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+
+		float3 irradiance(0.0f, 0.0f, 0.0f);
+		for (int k = 0; k < SSS_PREINTEGRATED_LUT_INTEGRATION_STEP_COUNT; ++k)
+		{
+			irradiance += weights[k] * subsurface_scattering_preintegrated_ring(cosTheta, sinTheta, cosAlpha[k], sinAlpha[k]);
+		}
+		irradiance = irradiance * rcpNormalization;
+		row[i] = float4(irradiance.x, irradiance.y, irradiance.z, 0.0f);
+	}
+}
+
+SSSPreintegratedLUT::SSSPreintegratedLUT(int size, int threadCount) : m_size(std::max(size, int(SSS_PREINTEGRATED_LUT_MIN_SIZE))),
+	m_threadCount(std::max(0, threadCount)),
+	m_profilesVersion(0U)
+{
+}
+
+bool SSSPreintegratedLUT::update(const SSSProfileTable& profiles)
+{
+	if (m_profilesVersion == profiles.getVersion())
+	{
+		return false;
+	}
+
+	const int profileCount = profiles.getCount();
+	const size_t sliceSize = static_cast<size_t>(m_size) * static_cast<size_t>(m_size);
+	m_table.resize(static_cast<size_t>(profileCount) * sliceSize);
+
+	// One row (of one profile) per work item, s.t. the result does NOT depend on the thread count
+	const int rowCount = profileCount * m_size;
+	std::atomic<int> nextRow(0);
+
+	auto worker = [&]()
+	{
+		for (int rowIndex = nextRow.fetch_add(1); rowIndex < rowCount; rowIndex = nextRow.fetch_add(1))
+		{
+			const int profileIndex = rowIndex / m_size;
+			const int curvatureIndex = rowIndex - profileIndex * m_size;
+			bakeRow(profiles.getProfile(profileIndex).scatteringDistance, m_size, curvatureIndex, &m_table[static_cast<size_t>(profileIndex) * sliceSize + static_cast<size_t>(curvatureIndex) * static_cast<size_t>(m_size)]);
+		}
+	};
+
+	const int threadCount = std::min((m_threadCount > 0) ? m_threadCount : std::max(1, static_cast<int>(std::thread::hardware_concurrency())), rowCount);
+	std::vector<std::thread> threads;
+	threads.reserve(std::max(threadCount - 1, 0));
+	for (int threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	m_profilesVersion = profiles.getVersion();
+	return true;
+}
@@ -0,0 +1,139 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSPreintegratedLUT_H_
+#define _SSSPreintegratedLUT_H_ 1
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include "math_consts.h"
+#include "vector_math.h"
+#include "SSSProfileTable.h"
+
+// The counterpart of "Shaders/subsurface_scattering_preintegrated_lut.hlsli"
+//
+// Pre-Integrated Skin Shading: the cheap LOD of the blur for the distant (or small) heads, of which the irradiance is NOT written for the blur.
+// Each entry is the irradiance of the surface of the sphere of the radius "1 / curvature" blurred by the Burley profile, which replaces the "saturate(N.L)" of the light loop:
+//    D(theta, r) = Integral[R(|P - Q|) * saturate(dot(N_Q, L)) dA_Q] / Integral[R(|P - Q|) dA_Q], where dot(N_P, L) = cos(theta) and Q runs over the sphere
+// The azimuth of Q is integrated analytically (see "subsurface_scattering_preintegrated_ring"), s.t. only the geodesic angle is integrated numerically.
+//
+// One slice per profile, and each slice is [curvature][N.L]:
+//    N.L: uniform in [-1, 1] (the negative side is the light wrapped around the terminator)
+//    curvature: uniform in "sqrt(curvature * max(scatteringDistance) / SSS_PREINTEGRATED_LUT_MAX_CURVATURE)", s.t. the flat surfaces (most of the head) get more entries, the same as the "SSSTransmittanceLUT"
+// The first row (curvature = 0) is exactly "saturate(N.L)", and the curvature beyond the range is clamped.
+#define SSS_PREINTEGRATED_LUT_MIN_SIZE 2
+#define SSS_PREINTEGRATED_LUT_DEFAULT_SIZE 64
+// The curvature (in 1 / mm) times the widest scattering distance (in mm), namely, the radius of the sphere is NOT smaller than the scattering distance
+#define SSS_PREINTEGRATED_LUT_MAX_CURVATURE 1.0f
+// The steps of the geodesic angle, which cover the sphere up to the radius of SSS_PREINTEGRATED_LUT_INTEGRATION_CDF of the profile
+#define SSS_PREINTEGRATED_LUT_INTEGRATION_STEP_COUNT 512
+#define SSS_PREINTEGRATED_LUT_INTEGRATION_CDF 0.999f
+
+inline float3 subsurface_scattering_preintegrated_lut(const float4* lut_slice, int lut_size, float3 scattering_distance, float ndotl, float curvature_in_mm);
+
+// Integral[saturate(cos(theta) * cos(alpha) + sin(theta) * sin(alpha) * cos(phi)) dphi] over [0, 2 * PI], namely, the irradiance of the ring of the geodesic angle "alpha" around the point of which "N.L = cos(theta)"
+inline float subsurface_scattering_preintegrated_ring(float cos_theta, float sin_theta, float cos_alpha, float sin_alpha);
+
+// Rebuilt on the CPU (by the worker threads) when the profiles change. The same data is uploaded as the "Texture2DArray<float4>" (DXGI_FORMAT_R32G32B32A32_FLOAT, one slice per profile) of the GPU path.
+class SSSPreintegratedLUT
+{
+public:
+	explicit SSSPreintegratedLUT(int size = SSS_PREINTEGRATED_LUT_DEFAULT_SIZE, int threadCount = 0);
+
+	// Return true if the table is rebuilt (namely, the GPU copy should be uploaded)
+	bool update(const SSSProfileTable& profiles);
+
+	// 0 means "std::thread::hardware_concurrency"
+	void setThreadCount(int threadCount) { m_threadCount = std::max(0, threadCount); }
+
+	int getSize() const { return m_size; }
+	int getProfileCount() const { return static_cast<int>(m_table.size() / (static_cast<size_t>(m_size) * static_cast<size_t>(m_size))); }
+
+	// Row major: [profile index][curvature][N.L]
+	const float4* getData() const { return m_table.data(); }
+
+	// ndotl: the signed "N.L" (NOT saturated)
+	// curvatureInMm: "1 / radius" in 1 / mm (see "SSSCurvatureMap")
+	float3 evaluate(const SSSProfileTable& profiles, int profileIndex, float ndotl, float curvatureInMm) const
+	{
+		return subsurface_scattering_preintegrated_lut(&m_table[static_cast<size_t>(profileIndex) * static_cast<size_t>(m_size) * static_cast<size_t>(m_size)], m_size, profiles.getProfile(profileIndex).scatteringDistance, ndotl, curvatureInMm);
+	}
+
+private:
+	int m_size;
+	int m_threadCount;
+	// The version of the profiles which the table is built from (0 means dirty)
+	uint64_t m_profilesVersion;
+	std::vector<float4> m_table;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+//    IMPLEMENTATION
+//
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+inline float3 subsurface_scattering_preintegrated_lut(const float4* lut_slice, int lut_size, float3 scattering_distance, float ndotl, float curvature_in_mm)
+{
+	const float d = std::max(std::max(scattering_distance.x, scattering_distance.y), scattering_distance.z);
+
+	// NOTE: the bilinear filter is done manually, the same as the GPU path
+	const float s = saturate(ndotl * 0.5f + 0.5f) * float(lut_size - 1);
+	const float t = std::sqrt(saturate(std::max(curvature_in_mm, 0.0f) * d * (1.0f / SSS_PREINTEGRATED_LUT_MAX_CURVATURE))) * float(lut_size - 1);
+	const int s_index = std::min(int(s), lut_size - 2);
+	const int t_index = std::min(int(t), lut_size - 2);
+	const float s_fraction = s - float(s_index);
+	const float t_fraction = t - float(t_index);
+
+	const float4* row0 = lut_slice + static_cast<size_t>(t_index) * static_cast<size_t>(lut_size);
+	const float4* row1 = row0 + lut_size;
+	const float3 p00(row0[s_index].x, row0[s_index].y, row0[s_index].z);
+	const float3 p01(row0[s_index + 1].x, row0[s_index + 1].y, row0[s_index + 1].z);
+	const float3 p10(row1[s_index].x, row1[s_index].y, row1[s_index].z);
+	const float3 p11(row1[s_index + 1].x, row1[s_index + 1].y, row1[s_index + 1].z);
+	return lerp(lerp(p00, p01, s_fraction), lerp(p10, p11, s_fraction), t_fraction);
+}
+
+inline float subsurface_scattering_preintegrated_ring(float cos_theta, float sin_theta, float cos_alpha, float sin_alpha)
+{
+	// a + b * cos(phi), where b >= 0 since both theta and alpha are in [0, PI]
+	const float a = cos_theta * cos_alpha;
+	const float b = sin_theta * sin_alpha;
+
+	if (a >= b)
+	{
+		// The whole ring is lit
+		return float(2.0 * PI) * a;
+	}
+	else if (a <= -b)
+	{
+		return 0.0f;
+	}
+	else
+	{
+		// lit in [-phi0, phi0] where cos(phi0) = -a / b
+		const float cos_phi0 = -a / b;
+		const float phi0 = std::acos(cos_phi0);
+		const float sin_phi0 = std::sqrt(std::max(1.0f - cos_phi0 * cos_phi0, 0.0f));
+		return 2.0f * (a * phi0 + b * sin_phi0);
+	}
+}
+
+#endif
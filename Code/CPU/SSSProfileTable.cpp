@@ -0,0 +1,79 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <atomic>
+#include "SSSProfileTable.h"
+#include "subsurface_scattering_disney_blur.h"
+
+static std::atomic<uint64_t> nextVersion(1U);
+
+static float filterRadius(const float3& scatteringDistance)
+{
+	// See "subsurface_scattering_disney_blur" for details.
+	const float d = std::max(std::max(scatteringDistance.x, scatteringDistance.y), scatteringDistance.z);
+	return diffusion_profile_sample_r(d, 0.997f);
+}
+
+SSSProfileTable::SSSProfileTable() : m_version(0U)
+{
+	// Runtime/RenderPipelineResources/Skin Diffusion Profile.asset
+	const float3 skin(0.7568628f, 0.32156864f, 0.20000002f);
+	m_profiles.reserve(SSS_PROFILE_MAX_COUNT);
+	addProfile(skin, skin, 0.125f);
+}
+
+int SSSProfileTable::addProfile(const float3& scatteringDistance, const float3& transmittanceTint, float worldScale)
+{
+	if (m_profiles.size() >= SSS_PROFILE_MAX_COUNT)
+	{
+		return -1;
+	}
+
+	SSSProfile profile;
+	profile.scatteringDistance = scatteringDistance;
+	profile.worldScale = std::max(0.001f, worldScale);
+	profile.transmittanceTint = transmittanceTint;
+	profile.filterRadius = filterRadius(scatteringDistance);
+	m_profiles.push_back(profile);
+
+	updateVersion();
+	return static_cast<int>(m_profiles.size()) - 1;
+}
+
+void SSSProfileTable::setScatteringDistance(int index, const float3& scatteringDistance)
+{
+	m_profiles[index].scatteringDistance = scatteringDistance;
+	m_profiles[index].filterRadius = filterRadius(scatteringDistance);
+	updateVersion();
+}
+
+void SSSProfileTable::setTransmittanceTint(int index, const float3& transmittanceTint)
+{
+	m_profiles[index].transmittanceTint = transmittanceTint;
+	updateVersion();
+}
+
+void SSSProfileTable::setWorldScale(int index, float worldScale)
+{
+	m_profiles[index].worldScale = std::max(0.001f, worldScale);
+	updateVersion();
+}
+
+void SSSProfileTable::updateVersion()
+{
+	m_version = nextVersion.fetch_add(1U);
+}
@@ -0,0 +1,92 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSProfileTable_H_
+#define _SSSProfileTable_H_ 1
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "vector_math.h"
+
+// The counterpart of "Shaders/subsurface_scattering_profile.hlsli"
+//
+// The profile index of each pixel is stored in the stencil buffer: stencil = profile_index + 1, and zero means no subsurface scattering.
+// Thus one blur pass handles all the materials and the samples which belong to another profile are rejected.
+// The highest bit of the stencil is the "reduced budget" tier of the LOD (see "SSSLodSelector"), s.t. the profile index only takes the lower 7 bits.
+#define SSS_PROFILE_MAX_COUNT 127
+#define SSS_STENCIL_PROFILE_MASK 0x7F
+#define SSS_STENCIL_REDUCED_BUDGET_BIT 0x80
+// The sample budget of the pixels of the "reduced budget" tier is "max(1, sample_budget / SSS_REDUCED_SAMPLE_BUDGET_DIVISOR)"
+#define SSS_REDUCED_SAMPLE_BUDGET_DIVISOR 4
+
+// Each profile is uploaded as two "float4" of the "Buffer<float4>": (scatteringDistance, worldScale) and (transmittanceTint, filterRadius)
+struct SSSProfile
+{
+	float3 scatteringDistance;
+	float worldScale;
+	float3 transmittanceTint;
+	// The radius (in mm) of the kernel which corresponds to 99.7% of the energy of the filter
+	float filterRadius;
+};
+
+inline int subsurface_scattering_profile_index_from_stencil(uint8_t stencil)
+{
+	return int(stencil & SSS_STENCIL_PROFILE_MASK) - 1;
+}
+
+inline uint8_t subsurface_scattering_profile_stencil_ref(int profile_index, bool reduced_budget = false)
+{
+	return uint8_t((profile_index + 1) | (reduced_budget ? SSS_STENCIL_REDUCED_BUDGET_BIT : 0));
+}
+
+inline int subsurface_scattering_sample_budget_from_stencil(uint8_t stencil, int sample_budget)
+{
+	return (0 != (stencil & SSS_STENCIL_REDUCED_BUDGET_BIT)) ? std::max(1, sample_budget / SSS_REDUCED_SAMPLE_BUDGET_DIVISOR) : sample_budget;
+}
+
+// The table starts with one profile (the default skin of the HUD).
+// Each modification bumps the version, s.t. the GPU copy is only uploaded when the table changes.
+class SSSProfileTable
+{
+public:
+	SSSProfileTable();
+
+	// Return the index of the new profile (or -1 if the table is full)
+	int addProfile(const float3& scatteringDistance, const float3& transmittanceTint, float worldScale);
+
+	void setScatteringDistance(int index, const float3& scatteringDistance);
+	void setTransmittanceTint(int index, const float3& transmittanceTint);
+	void setWorldScale(int index, float worldScale);
+
+	int getCount() const { return static_cast<int>(m_profiles.size()); }
+
+	const SSSProfile& getProfile(int index) const { return m_profiles[index]; }
+
+	const SSSProfile* getData() const { return m_profiles.data(); }
+
+	// Unique among all tables, s.t. the version is never reused by another table
+	uint64_t getVersion() const { return m_version; }
+
+private:
+	void updateVersion();
+
+	std::vector<SSSProfile> m_profiles;
+	uint64_t m_version;
+};
+
+#endif
@@ -0,0 +1,260 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <cmath>
+#include <utility>
+#include "SSSSeparableKernel.h"
+#include "math_consts.h"
+
+// Solve the normal equations by the Gaussian elimination with partial pivoting
+static void solveLinearSystem(std::vector<double>& A, std::vector<double>& b, int n, double* x)
+{
+	for (int i = 0; i < n; ++i)
+	{
+		int pivot = i;
+		for (int k = i + 1; k < n; ++k)
+		{
+			if (std::abs(A[k * n + i]) > std::abs(A[pivot * n + i]))
+			{
+				pivot = k;
+			}
+		}
+		for (int k = 0; k < n; ++k)
+		{
+			std::swap(A[i * n + k], A[pivot * n + k]);
+		}
+		std::swap(b[i], b[pivot]);
+
+		for (int k = i + 1; k < n; ++k)
+		{
+			const double f = A[k * n + i] / A[i * n + i];
+			for (int j = i; j < n; ++j)
+			{
+				A[k * n + j] -= f * A[i * n + j];
+			}
+			b[k] -= f * b[i];
+		}
+	}
+
+	for (int i = n - 1; i >= 0; --i)
+	{
+		double sum = b[i];
+		for (int j = i + 1; j < n; ++j)
+		{
+			sum -= A[i * n + j] * x[j];
+		}
+		x[i] = sum / A[i * n + i];
+	}
+}
+
+static SSSGaussianFit fitGaussians()
+{
+	// The radial energy density of the Burley profile (d = 1): 2 * PI * r * R(r) = (exp(-r) + exp(-r / 3)) / 4
+	// The radial energy density of the 2D Gaussian: 2 * PI * r * G(v, r) = (r / v) * exp(-r * r / (2 * v))
+	const int sampleCount = 4096;
+	const double maxRadius = 30.0;
+
+	double variance[SSS_SEPARABLE_GAUSSIAN_COUNT];
+	for (int j = 0; j < SSS_SEPARABLE_GAUSSIAN_COUNT; ++j)
+	{
+		const double standardDeviation = double(SSS_SEPARABLE_GAUSSIAN_MIN_STANDARD_DEVIATION) * std::pow(double(SSS_SEPARABLE_GAUSSIAN_MAX_STANDARD_DEVIATION) / double(SSS_SEPARABLE_GAUSSIAN_MIN_STANDARD_DEVIATION), double(j) / double(SSS_SEPARABLE_GAUSSIAN_COUNT - 1));
+		variance[j] = standardDeviation * standardDeviation;
+	}
+
+	// Active Set: the most negative weight is removed and the least squares is solved again, until all weights are NOT negative
+	bool active[SSS_SEPARABLE_GAUSSIAN_COUNT];
+	double weight[SSS_SEPARABLE_GAUSSIAN_COUNT];
+	for (int j = 0; j < SSS_SEPARABLE_GAUSSIAN_COUNT; ++j)
+	{
+		active[j] = true;
+	}
+	for (int iteration = 0; iteration < SSS_SEPARABLE_GAUSSIAN_COUNT; ++iteration)
+	{
+		int activeIndices[SSS_SEPARABLE_GAUSSIAN_COUNT];
+		int n = 0;
+		for (int j = 0; j < SSS_SEPARABLE_GAUSSIAN_COUNT; ++j)
+		{
+			if (active[j])
+			{
+				activeIndices[n++] = j;
+			}
+		}
+
+		std::vector<double> AtA(n * n, 0.0);
+		std::vector<double> Atb(n, 0.0);
+		for (int i = 0; i < sampleCount; ++i)
+		{
+			const double r = (double(i) + 0.5) * (maxRadius / double(sampleCount));
+			const double p = 0.25 * (std::exp(-r) + std::exp(-r / 3.0));
+			double g[SSS_SEPARABLE_GAUSSIAN_COUNT];
+			for (int k = 0; k < n; ++k)
+			{
+				const double v = variance[activeIndices[k]];
+				g[k] = (r / v) * std::exp(-r * r / (2.0 * v));
+			}
+			for (int k = 0; k < n; ++k)
+			{
+				Atb[k] += g[k] * p;
+				for (int l = 0; l < n; ++l)
+				{
+					AtA[k * n + l] += g[k] * g[l];
+				}
+			}
+		}
+
+		double x[SSS_SEPARABLE_GAUSSIAN_COUNT];
+		solveLinearSystem(AtA, Atb, n, x);
+
+		int mostNegative = -1;
+		double mostNegativeWeight = 0.0;
+		for (int j = 0; j < SSS_SEPARABLE_GAUSSIAN_COUNT; ++j)
+		{
+			weight[j] = 0.0;
+		}
+		for (int k = 0; k < n; ++k)
+		{
+			weight[activeIndices[k]] = x[k];
+			if (x[k] < mostNegativeWeight)
+			{
+				mostNegativeWeight = x[k];
+				mostNegative = activeIndices[k];
+			}
+		}
+
+		if (mostNegative < 0)
+		{
+			break;
+		}
+		active[mostNegative] = false;
+	}
+
+	SSSGaussianFit fit;
+	double sumWeight = 0.0;
+	for (int j = 0; j < SSS_SEPARABLE_GAUSSIAN_COUNT; ++j)
+	{
+		sumWeight += weight[j];
+	}
+
+	double sumSquaredError = 0.0;
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		const double r = (double(i) + 0.5) * (maxRadius / double(sampleCount));
+		const double p = 0.25 * (std::exp(-r) + std::exp(-r / 3.0));
+		double q = 0.0;
+		for (int j = 0; j < SSS_SEPARABLE_GAUSSIAN_COUNT; ++j)
+		{
+			q += (weight[j] / sumWeight) * (r / variance[j]) * std::exp(-r * r / (2.0 * variance[j]));
+		}
+		sumSquaredError += (q - p) * (q - p);
+	}
+
+	// The weights are normalized, s.t. the energy is conserved
+	for (int j = 0; j < SSS_SEPARABLE_GAUSSIAN_COUNT; ++j)
+	{
+		fit.standardDeviation[j] = float(std::sqrt(variance[j]));
+		fit.weight[j] = float(weight[j] / sumWeight);
+	}
+	fit.rmse = float(std::sqrt(sumSquaredError / double(sampleCount)) / 0.5);
+	return fit;
+}
+
+const SSSGaussianFit& subsurface_scattering_separable_gaussian_fit()
+{
+	// NOTE: the initialization of the local static is thread safe since C++11
+	static const SSSGaussianFit fit = fitGaussians();
+	return fit;
+}
+
+float3 subsurface_scattering_separable_gaussian_fit_evaluate(const SSSGaussianFit& fit, float3 scattering_distance, float r)
+{
+	float3 value(0.0f, 0.0f, 0.0f);
+	for (int j = 0; j < SSS_SEPARABLE_GAUSSIAN_COUNT; ++j)
+	{
+		const float3 standard_deviation = scattering_distance * fit.standardDeviation[j];
+		const float3 variance = standard_deviation * standard_deviation;
+		value += float3(
+			std::exp(-r * r / (2.0f * variance.x)) / (float(2.0 * PI) * variance.x),
+			std::exp(-r * r / (2.0f * variance.y)) / (float(2.0 * PI) * variance.y),
+			std::exp(-r * r / (2.0f * variance.z)) / (float(2.0 * PI) * variance.z)) * fit.weight[j];
+	}
+	return value;
+}
+
+// The integral of the 1D sum of Gaussians over [x0, x1]
+static double integrateGaussians(const SSSGaussianFit& fit, double scatteringDistance, double x0, double x1)
+{
+	double sum = 0.0;
+	for (int j = 0; j < SSS_SEPARABLE_GAUSSIAN_COUNT; ++j)
+	{
+		const double rcpScale = 1.0 / (std::sqrt(2.0) * scatteringDistance * double(fit.standardDeviation[j]));
+		sum += double(fit.weight[j]) * 0.5 * (std::erf(x1 * rcpScale) - std::erf(x0 * rcpScale));
+	}
+	return sum;
+}
+
+SSSSeparableKernel::SSSSeparableKernel() : m_profilesVersion(0U)
+{
+}
+
+bool SSSSeparableKernel::update(const SSSProfileTable& profiles)
+{
+	if (m_profilesVersion == profiles.getVersion())
+	{
+		return false;
+	}
+
+	const SSSGaussianFit& fit = subsurface_scattering_separable_gaussian_fit();
+
+	const int profileCount = profiles.getCount();
+	m_table.resize(static_cast<size_t>(profileCount) * SSS_SEPARABLE_KERNEL_SAMPLE_COUNT);
+
+	for (int profileIndex = 0; profileIndex < profileCount; ++profileIndex)
+	{
+		const SSSProfile& profile = profiles.getProfile(profileIndex);
+		float4* row = &m_table[static_cast<size_t>(profileIndex) * SSS_SEPARABLE_KERNEL_SAMPLE_COUNT];
+
+		double offsets[SSS_SEPARABLE_KERNEL_SAMPLE_COUNT];
+		for (int i = 0; i < SSS_SEPARABLE_KERNEL_SAMPLE_COUNT; ++i)
+		{
+			const double t = 2.0 * double(i) / double(SSS_SEPARABLE_KERNEL_SAMPLE_COUNT - 1) - 1.0;
+			offsets[i] = double(profile.filterRadius) * t * std::abs(t);
+		}
+
+		double weights[SSS_SEPARABLE_KERNEL_SAMPLE_COUNT][3];
+		double sumWeights[3] = { 0.0, 0.0, 0.0 };
+		for (int i = 0; i < SSS_SEPARABLE_KERNEL_SAMPLE_COUNT; ++i)
+		{
+			// The interval of each tap is bounded by the midpoints between the neighbouring taps (and the filter radius at both ends)
+			const double x0 = (i > 0) ? (0.5 * (offsets[i - 1] + offsets[i])) : offsets[0];
+			const double x1 = (i < (SSS_SEPARABLE_KERNEL_SAMPLE_COUNT - 1)) ? (0.5 * (offsets[i] + offsets[i + 1])) : offsets[SSS_SEPARABLE_KERNEL_SAMPLE_COUNT - 1];
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				weights[i][channel] = integrateGaussians(fit, double((&profile.scatteringDistance.x)[channel]), x0, x1);
+				sumWeights[channel] += weights[i][channel];
+			}
+		}
+
+		// The energy beyond the filter radius is redistributed, s.t. each pass preserves the energy
+		for (int i = 0; i < SSS_SEPARABLE_KERNEL_SAMPLE_COUNT; ++i)
+		{
+			row[i] = float4(float(weights[i][0] / sumWeights[0]), float(weights[i][1] / sumWeights[1]), float(weights[i][2] / sumWeights[2]), float(offsets[i]));
+		}
+	}
+
+	m_profilesVersion = profiles.getVersion();
+	return true;
+}
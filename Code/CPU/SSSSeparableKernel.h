@@ -0,0 +1,76 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSSeparableKernel_H_
+#define _SSSSeparableKernel_H_ 1
+
+#include <cstdint>
+#include <vector>
+#include "vector_math.h"
+#include "SSSProfileTable.h"
+#include "subsurface_scattering_separable_blur.h"
+
+// The Burley profile of which the scattering distance is 1 mm is fitted by a small sum of Gaussians.
+// The standard deviations are fixed (geometric from SSS_SEPARABLE_GAUSSIAN_MIN_STANDARD_DEVIATION to SSS_SEPARABLE_GAUSSIAN_MAX_STANDARD_DEVIATION) and the weights are solved by the non-negative least squares of the radial energy density (2 * PI * r * R(r)).
+// Since "R(d, r) = R(1, r / d) / (d * d)", the fit is shared by all profiles and all channels: the standard deviations are scaled by the scattering distance of each channel.
+#define SSS_SEPARABLE_GAUSSIAN_COUNT 6
+#define SSS_SEPARABLE_GAUSSIAN_MIN_STANDARD_DEVIATION 0.02f
+#define SSS_SEPARABLE_GAUSSIAN_MAX_STANDARD_DEVIATION 5.0f
+
+struct SSSGaussianFit
+{
+	float standardDeviation[SSS_SEPARABLE_GAUSSIAN_COUNT];
+	float weight[SSS_SEPARABLE_GAUSSIAN_COUNT];
+	// RMSE of the radial energy density (relative to the maximum, namely, "2 * PI * r * R(r)" at r = 0)
+	float rmse;
+};
+
+// Fitted on the first call
+const SSSGaussianFit& subsurface_scattering_separable_gaussian_fit();
+
+// The 2D radial profile of the fit (the counterpart of "diffusion_profile_evaluate_pdf / (2 * PI * r)")
+float3 subsurface_scattering_separable_gaussian_fit_evaluate(const SSSGaussianFit& fit, float3 scattering_distance, float r);
+
+// The counterpart of the "Buffer<float4>" of "Shaders/subsurface_scattering_separable_blur.hlsli"
+//
+// One row of SSS_SEPARABLE_KERNEL_SAMPLE_COUNT taps per profile: (weight.rgb, offset in mm).
+// The offsets are shared by the three channels and distributed as "filterRadius * t * |t|" (t is uniform in [-1, 1]), s.t. the center gets more taps.
+// The weight of each tap is the integral of the 1D sum of Gaussians over the interval of the tap (rather than the value at the offset), s.t. the Gaussians which are narrower than the spacing are NOT lost.
+// Rebuilt on the CPU when the profiles change.
+class SSSSeparableKernel
+{
+public:
+	SSSSeparableKernel();
+
+	// Return true if the table is rebuilt (namely, the GPU copy should be uploaded)
+	bool update(const SSSProfileTable& profiles);
+
+	int getSampleCount() const { return SSS_SEPARABLE_KERNEL_SAMPLE_COUNT; }
+	int getProfileCount() const { return static_cast<int>(m_table.size()) / SSS_SEPARABLE_KERNEL_SAMPLE_COUNT; }
+
+	// Row major: [profile index][sample index]
+	const float4* getData() const { return m_table.data(); }
+
+	const float4* getRow(int profileIndex) const { return &m_table[static_cast<size_t>(profileIndex) * SSS_SEPARABLE_KERNEL_SAMPLE_COUNT]; }
+
+private:
+	// The version of the profiles which the table is built from (0 means dirty)
+	uint64_t m_profilesVersion;
+	std::vector<float4> m_table;
+};
+
+#endif
@@ -0,0 +1,283 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include "SSSTextureSpace.h"
+
+template <typename WORKER>
+static void runWorkers(int threadCount, const WORKER& worker)
+{
+	std::vector<std::thread> threads;
+	threads.reserve(std::max(threadCount - 1, 0));
+	for (int threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+static float3 loadFloat3(const SSSCurvatureMesh& mesh, int vertexIndex, int offset)
+{
+	float value[3];
+	std::memcpy(value, static_cast<const uint8_t*>(mesh.vertices) + static_cast<size_t>(vertexIndex) * static_cast<size_t>(mesh.vertexStride) + offset, sizeof(value));
+	return float3(value[0], value[1], value[2]);
+}
+
+static float2 loadFloat2(const SSSCurvatureMesh& mesh, int vertexIndex, int offset)
+{
+	float value[2];
+	std::memcpy(value, static_cast<const uint8_t*>(mesh.vertices) + static_cast<size_t>(vertexIndex) * static_cast<size_t>(mesh.vertexStride) + offset, sizeof(value));
+	return float2(value[0], value[1]);
+}
+
+static int loadIndex(const SSSCurvatureMesh& mesh, int index)
+{
+	return mesh.indices32 ? static_cast<int>(static_cast<const uint32_t*>(mesh.indices)[index]) : static_cast<int>(static_cast<const uint16_t*>(mesh.indices)[index]);
+}
+
+static float3 normalize3(float3 a)
+{
+	const float length = std::sqrt(dot(a, a));
+	return (length > 0.0f) ? (a * (1.0f / length)) : a;
+}
+
+static int resolveThreadCount(int threadCount)
+{
+	return (threadCount > 0) ? threadCount : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+SSSTextureSpaceGeometry::SSSTextureSpaceGeometry(int size, int threadCount) : m_size(std::max(1, size)),
+	m_threadCount(std::max(0, threadCount)),
+	m_coveredTexelCount(0)
+{
+}
+
+void SSSTextureSpaceGeometry::rasterize(const SSSCurvatureMesh* meshes, int meshCount)
+{
+	const int threadCount = resolveThreadCount(m_threadCount);
+	const int size = m_size;
+	const size_t texelCount = static_cast<size_t>(size) * static_cast<size_t>(size);
+
+	m_positions.assign(texelCount, float4(0.0f, 0.0f, 0.0f, 0.0f));
+	m_stretch.assign(texelCount, float2(0.0f, 0.0f));
+	m_normals.assign(texelCount, float4(0.0f, 0.0f, 0.0f, 0.0f));
+
+	for (int meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+	{
+		const SSSCurvatureMesh& mesh = meshes[meshIndex];
+		const int triangleCount = mesh.indexCount / 3;
+
+		// One band of SSS_TEXTURE_SPACE_ROWS_PER_TASK rows per work item (the triangles are visited in order, s.t. the overlapping texels are deterministic)
+		const int bandCount = (size + SSS_TEXTURE_SPACE_ROWS_PER_TASK - 1) / SSS_TEXTURE_SPACE_ROWS_PER_TASK;
+		std::atomic<int> nextBand(0);
+
+		auto worker = [&]()
+		{
+			for (int band = nextBand.fetch_add(1); band < bandCount; band = nextBand.fetch_add(1))
+			{
+				const int bandBegin = band * SSS_TEXTURE_SPACE_ROWS_PER_TASK;
+				const int bandEnd = std::min(bandBegin + SSS_TEXTURE_SPACE_ROWS_PER_TASK, size);
+
+				for (int triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+				{
+					float3 positions[3];
+					float3 normals[3];
+					float2 texel[3];
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const int vertexIndex = loadIndex(mesh, triangleIndex * 3 + corner);
+						positions[corner] = loadFloat3(mesh, vertexIndex, mesh.positionOffset);
+						normals[corner] = normalize3(loadFloat3(mesh, vertexIndex, mesh.normalOffset));
+						// The texel centers are at the integers
+						const float2 texcoord = loadFloat2(mesh, vertexIndex, mesh.texcoordOffset);
+						texel[corner] = float2(texcoord.x * float(size) - 0.5f, texcoord.y * float(size) - 0.5f);
+					}
+
+					const int yMin = std::max(int(std::ceil(std::min(std::min(texel[0].y, texel[1].y), texel[2].y))), bandBegin);
+					const int yMax = std::min(int(std::floor(std::max(std::max(texel[0].y, texel[1].y), texel[2].y))), bandEnd - 1);
+					if (yMin > yMax)
+					{
+						continue;
+					}
+					const int xMin = std::max(int(std::ceil(std::min(std::min(texel[0].x, texel[1].x), texel[2].x))), 0);
+					const int xMax = std::min(int(std::floor(std::max(std::max(texel[0].x, texel[1].x), texel[2].x))), size - 1);
+
+					const float2 e1 = texel[1] - texel[0];
+					const float2 e2 = texel[2] - texel[0];
+					const float area = e1.x * e2.y - e1.y * e2.x;
+					if (std::abs(area) < 1.0e-12f)
+					{
+						continue;
+					}
+					const float rcpArea = 1.0f / area;
+
+					// dP/dx and dP/dy of the texel: "P - P0 = b1 * (P1 - P0) + b2 * (P2 - P0)" where b1 and b2 are linear in the texel
+					const float3 p1 = positions[1] - positions[0];
+					const float3 p2 = positions[2] - positions[0];
+					const float3 dPdx = (p1 * e2.y - p2 * e1.y) * rcpArea;
+					const float3 dPdy = (p2 * e1.x - p1 * e2.x) * rcpArea;
+					const float2 stretch(std::sqrt(dot(dPdx, dPdx)), std::sqrt(dot(dPdy, dPdy)));
+
+					for (int y = yMin; y <= yMax; ++y)
+					{
+						for (int x = xMin; x <= xMax; ++x)
+						{
+							const float2 p = float2(float(x), float(y)) - texel[0];
+							const float b1 = (p.x * e2.y - p.y * e2.x) * rcpArea;
+							const float b2 = (e1.x * p.y - e1.y * p.x) * rcpArea;
+							const float b0 = 1.0f - b1 - b2;
+							if ((b0 >= -1.0e-5f) && (b1 >= -1.0e-5f) && (b2 >= -1.0e-5f))
+							{
+								const size_t texelIndex = static_cast<size_t>(y) * static_cast<size_t>(size) + static_cast<size_t>(x);
+								const float3 position = positions[0] * b0 + positions[1] * b1 + positions[2] * b2;
+								const float3 normal = normalize3(normals[0] * b0 + normals[1] * b1 + normals[2] * b2);
+								m_positions[texelIndex] = float4(position.x, position.y, position.z, 1.0f);
+								m_stretch[texelIndex] = stretch;
+								m_normals[texelIndex] = float4(normal.x, normal.y, normal.z, 1.0f);
+							}
+						}
+					}
+				}
+			}
+		};
+
+		runWorkers(std::min(threadCount, bandCount), worker);
+	}
+
+	m_coveredTexelCount = 0;
+	for (const float4& normal : m_normals)
+	{
+		m_coveredTexelCount += (normal.w > 0.0f) ? 1 : 0;
+	}
+
+	// The dilation: each empty texel takes the mean of the neighbors which are filled by the previous passes
+	std::vector<uint8_t> filled(texelCount);
+	for (size_t texelIndex = 0U; texelIndex < texelCount; ++texelIndex)
+	{
+		filled[texelIndex] = (m_positions[texelIndex].w > 0.0f) ? uint8_t(1U) : uint8_t(0U);
+	}
+	for (int pass = 0; pass < SSS_TEXTURE_SPACE_DILATION_COUNT; ++pass)
+	{
+		std::vector<uint8_t> nextFilled(filled);
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				const size_t texelIndex = static_cast<size_t>(y) * static_cast<size_t>(size) + static_cast<size_t>(x);
+				if (0U != filled[texelIndex])
+				{
+					continue;
+				}
+
+				const int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+				float3 position(0.0f, 0.0f, 0.0f);
+				float2 stretch(0.0f, 0.0f);
+				float3 normal(0.0f, 0.0f, 0.0f);
+				int count = 0;
+				for (int i = 0; i < 4; ++i)
+				{
+					const int neighborX = x + offsets[i][0];
+					const int neighborY = y + offsets[i][1];
+					if ((neighborX >= 0) && (neighborX < size) && (neighborY >= 0) && (neighborY < size))
+					{
+						const size_t neighborIndex = static_cast<size_t>(neighborY) * static_cast<size_t>(size) + static_cast<size_t>(neighborX);
+						if (0U != filled[neighborIndex])
+						{
+							position += float3(m_positions[neighborIndex].x, m_positions[neighborIndex].y, m_positions[neighborIndex].z);
+							stretch = stretch + m_stretch[neighborIndex];
+							normal += float3(m_normals[neighborIndex].x, m_normals[neighborIndex].y, m_normals[neighborIndex].z);
+							++count;
+						}
+					}
+				}
+
+				if (count > 0)
+				{
+					const float rcpCount = 1.0f / float(count);
+					position = position * rcpCount;
+					normal = normalize3(normal);
+					m_positions[texelIndex] = float4(position.x, position.y, position.z, 1.0f);
+					m_stretch[texelIndex] = stretch * rcpCount;
+					m_normals[texelIndex] = float4(normal.x, normal.y, normal.z, 0.0f);
+					nextFilled[texelIndex] = uint8_t(1U);
+				}
+			}
+		}
+		filled.swap(nextFilled);
+	}
+}
+
+// The "SSS_SOURCE" of the "subsurface_scattering_texture_space_diffuse"
+struct TextureSpaceDiffusionSource
+{
+	const SSSTextureSpaceGeometry& geometry;
+	const float4* irradiance;
+
+	float4 texture_space_irradiance(int x, int y) const { return irradiance[static_cast<size_t>(y) * static_cast<size_t>(geometry.getSize()) + static_cast<size_t>(x)]; }
+	float4 texture_space_position(int x, int y) const { return geometry.texture_space_position(x, y); }
+	float2 texture_space_stretch(int x, int y) const { return geometry.texture_space_stretch(x, y); }
+	int texture_space_size() const { return geometry.getSize(); }
+};
+
+SSSTextureSpaceDiffusion::SSSTextureSpaceDiffusion(int sampleCount, int threadCount) : m_sampleCount(std::min(std::max(1, sampleCount), int(SSS_TEXTURE_SPACE_MAX_SAMPLE_COUNT))),
+	m_threadCount(std::max(0, threadCount))
+{
+}
+
+void SSSTextureSpaceDiffusion::go(const SSSTextureSpaceGeometry& geometry, const float4* irradiance, const SSSProfile& profile, float4* diffused) const
+{
+	const TextureSpaceDiffusionSource source = { geometry, irradiance };
+	const int size = geometry.getSize();
+
+	// The kernel of the widest channel (the same for all texels)
+	const float d = std::max(std::max(profile.scatteringDistance.x, profile.scatteringDistance.y), profile.scatteringDistance.z);
+	std::vector<subsurface_scattering_texture_space_kernel_sample> kernel(m_sampleCount);
+	for (int sampleIndex = 0; sampleIndex < m_sampleCount; ++sampleIndex)
+	{
+		kernel[sampleIndex] = subsurface_scattering_texture_space_kernel(d, m_sampleCount, sampleIndex);
+	}
+
+	const int bandCount = (size + SSS_TEXTURE_SPACE_ROWS_PER_TASK - 1) / SSS_TEXTURE_SPACE_ROWS_PER_TASK;
+	std::atomic<int> nextBand(0);
+
+	auto worker = [&]()
+	{
+		for (int band = nextBand.fetch_add(1); band < bandCount; band = nextBand.fetch_add(1))
+		{
+			const int bandEnd = std::min((band + 1) * SSS_TEXTURE_SPACE_ROWS_PER_TASK, size);
+			for (int y = band * SSS_TEXTURE_SPACE_ROWS_PER_TASK; y < bandEnd; ++y)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					const float3 radiance = subsurface_scattering_texture_space_diffuse(source, kernel.data(), profile.scatteringDistance, profile.worldScale, m_sampleCount, x, y);
+					const float coverage = (geometry.texture_space_position(x, y).w > 0.0f) ? 1.0f : 0.0f;
+					diffused[static_cast<size_t>(y) * static_cast<size_t>(size) + static_cast<size_t>(x)] = float4(radiance.x, radiance.y, radiance.z, coverage);
+				}
+			}
+		}
+	};
+
+	runWorkers(std::min(resolveThreadCount(m_threadCount), bandCount), worker);
+}
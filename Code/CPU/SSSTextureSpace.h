@@ -0,0 +1,101 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSTextureSpace_H_
+#define _SSSTextureSpace_H_ 1
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include "vector_math.h"
+#include "SSSProfileTable.h"
+#include "SSSCurvatureMap.h"
+#include "subsurface_scattering_texture_space.h"
+
+// The geometry of the mesh in the texture space (the input of the texture space diffusion, see "subsurface_scattering_texture_space.h").
+//
+// Each triangle is rasterized into the texture coordinates (the same rasterization as the "SSSCurvatureMap"), and each texel gets:
+//    the position: the object space position interpolated by the barycentric coordinates
+//    the stretch: the length of the derivatives of the position by the texel along u and v (constant per triangle), namely, the units of the mesh per texel
+//    the normal: the object space normal interpolated by the barycentric coordinates (only used by the relighting of the CPU path, since the GPU path rasterizes the mesh itself)
+// The empty texels next to the charts are dilated (the same as the "SSSCurvatureMap"), s.t. the bilinear filter of the atlas does NOT bleed the empty texels into the seams, while the "coverage" of the normal stays zero.
+#define SSS_TEXTURE_SPACE_DEFAULT_SIZE 512
+#define SSS_TEXTURE_SPACE_DILATION_COUNT 4
+// The rows of the map per work item of the rasterization and of the diffusion
+#define SSS_TEXTURE_SPACE_ROWS_PER_TASK 16
+
+class SSSTextureSpaceGeometry
+{
+public:
+	explicit SSSTextureSpaceGeometry(int size = SSS_TEXTURE_SPACE_DEFAULT_SIZE, int threadCount = 0);
+
+	// All meshes are rasterized into the same map (the later meshes overwrite the overlapping texels)
+	void rasterize(const SSSCurvatureMesh* meshes, int meshCount);
+
+	// 0 means "std::thread::hardware_concurrency"
+	void setThreadCount(int threadCount) { m_threadCount = std::max(0, threadCount); }
+
+	int getSize() const { return m_size; }
+
+	// Row major: [v][u]
+	// (position, 1) or zero if empty (DXGI_FORMAT_R32G32B32A32_FLOAT)
+	const float4* getPositions() const { return m_positions.data(); }
+	// (units per texel along u, along v) or zero if empty (DXGI_FORMAT_R32G32_FLOAT)
+	const float2* getStretch() const { return m_stretch.data(); }
+	// (normal, coverage)
+	const float4* getNormals() const { return m_normals.data(); }
+
+	// The texels which are covered by the triangles (NOT the dilated texels)
+	int getCoveredTexelCount() const { return m_coveredTexelCount; }
+
+	// The "SSS_SOURCE" of the "subsurface_scattering_texture_space_diffuse" (with the irradiance of the caller)
+	float4 texture_space_position(int x, int y) const { return m_positions[static_cast<size_t>(y) * static_cast<size_t>(m_size) + static_cast<size_t>(x)]; }
+	float2 texture_space_stretch(int x, int y) const { return m_stretch[static_cast<size_t>(y) * static_cast<size_t>(m_size) + static_cast<size_t>(x)]; }
+	int texture_space_size() const { return m_size; }
+
+private:
+	int m_size;
+	int m_threadCount;
+	int m_coveredTexelCount;
+	std::vector<float4> m_positions;
+	std::vector<float2> m_stretch;
+	std::vector<float4> m_normals;
+};
+
+// The CPU counterpart of the "SSS_Blur_TextureSpace_PS": one band of SSS_TEXTURE_SPACE_ROWS_PER_TASK rows per work item, s.t. the result does NOT depend on the thread count.
+class SSSTextureSpaceDiffusion
+{
+public:
+	explicit SSSTextureSpaceDiffusion(int sampleCount = SSS_TEXTURE_SPACE_DEFAULT_SAMPLE_COUNT, int threadCount = 0);
+
+	void setSampleCount(int sampleCount) { m_sampleCount = std::min(std::max(1, sampleCount), int(SSS_TEXTURE_SPACE_MAX_SAMPLE_COUNT)); }
+
+	// 0 means "std::thread::hardware_concurrency"
+	void setThreadCount(int threadCount) { m_threadCount = std::max(0, threadCount); }
+
+	int getSampleCount() const { return m_sampleCount; }
+
+	// irradiance: (total_diffuse_reflectance_pre_scatter_multiply_form_factor, coverage) of each texel of the "geometry" (row major)
+	// diffused: (the diffused irradiance, 1) of each texel of the "geometry", or zero if the texel is empty (the same as the atlas of the GPU path)
+	void go(const SSSTextureSpaceGeometry& geometry, const float4* irradiance, const SSSProfile& profile, float4* diffused) const;
+
+private:
+	int m_sampleCount;
+	int m_threadCount;
+};
+
+#endif
@@ -0,0 +1,135 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include "SSSTextureSpaceCache.h"
+
+SSSTextureSpaceCache::SSSTextureSpaceCache(int size, size_t memoryBudget, int maxSlotCount) : m_size(std::max(1, size)),
+	m_memoryBudget(memoryBudget),
+	m_frameIndex(0U)
+{
+	const size_t slotCount = std::min(m_memoryBudget / getSlotMemory(), static_cast<size_t>(std::max(0, maxSlotCount)));
+	const Slot freeSlot = { -1, 0U, 0U };
+	m_slots.assign(slotCount, freeSlot);
+	clear();
+}
+
+void SSSTextureSpaceCache::beginFrame()
+{
+	++m_frameIndex;
+	m_frameHitCount = 0;
+	m_frameMissCount = 0;
+	m_frameFallbackCount = 0;
+}
+
+int SSSTextureSpaceCache::acquire(int headIndex, uint64_t key, bool& dirty)
+{
+	// The slot of the head, or else a free slot, or else the least recently used slot which is NOT used by the current frame
+	int headSlot = -1;
+	int victimSlot = -1;
+	for (int slotIndex = 0; slotIndex < getSlotCount(); ++slotIndex)
+	{
+		const Slot& slot = m_slots[slotIndex];
+		if (headIndex == slot.headIndex)
+		{
+			headSlot = slotIndex;
+			break;
+		}
+		else if (slot.headIndex < 0)
+		{
+			if ((victimSlot < 0) || (m_slots[victimSlot].headIndex >= 0))
+			{
+				victimSlot = slotIndex;
+			}
+		}
+		else if (slot.lastUsedFrame < m_frameIndex)
+		{
+			if ((victimSlot < 0) || ((m_slots[victimSlot].headIndex >= 0) && (slot.lastUsedFrame < m_slots[victimSlot].lastUsedFrame)))
+			{
+				victimSlot = slotIndex;
+			}
+		}
+	}
+
+	if (headSlot >= 0)
+	{
+		Slot& slot = m_slots[headSlot];
+		slot.lastUsedFrame = m_frameIndex;
+		dirty = (slot.key != key);
+		if (dirty)
+		{
+			slot.key = key;
+			++m_missCount;
+			++m_frameMissCount;
+		}
+		else
+		{
+			++m_hitCount;
+			++m_frameHitCount;
+		}
+		return headSlot;
+	}
+
+	if (victimSlot < 0)
+	{
+		dirty = false;
+		++m_fallbackCount;
+		++m_frameFallbackCount;
+		return -1;
+	}
+
+	Slot& slot = m_slots[victimSlot];
+	if (slot.headIndex >= 0)
+	{
+		++m_evictionCount;
+	}
+	slot.headIndex = headIndex;
+	slot.key = key;
+	slot.lastUsedFrame = m_frameIndex;
+	dirty = true;
+	++m_missCount;
+	++m_frameMissCount;
+	return victimSlot;
+}
+
+void SSSTextureSpaceCache::clear()
+{
+	for (Slot& slot : m_slots)
+	{
+		slot.headIndex = -1;
+		slot.key = 0U;
+		slot.lastUsedFrame = 0U;
+	}
+
+	m_hitCount = 0U;
+	m_missCount = 0U;
+	m_evictionCount = 0U;
+	m_fallbackCount = 0U;
+	m_frameHitCount = 0;
+	m_frameMissCount = 0;
+	m_frameFallbackCount = 0;
+}
+
+size_t SSSTextureSpaceCache::getMemoryUsage() const
+{
+	size_t usedSlotCount = 0U;
+	for (const Slot& slot : m_slots)
+	{
+		usedSlotCount += (slot.headIndex >= 0) ? 1U : 0U;
+	}
+	return usedSlotCount * getSlotMemory();
+}
@@ -0,0 +1,105 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSTextureSpaceCache_H_
+#define _SSSTextureSpaceCache_H_ 1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SSSTextureSpace.h"
+
+// The atlas of the diffused irradiance in the texture space: one slot (one slice of the "Texture2DArray" of the GPU path) per head.
+//
+// Each slot remembers the key of the state which its irradiance was relit and diffused from (see "subsurface_scattering_texture_space_hash"), namely, the lights, the parameters of the material and the transform of the head, but NOT the camera.
+// The slot of the head is reused as long as the key is the same (the hit), and relit and diffused again when the key changes (the miss).
+// The slots are limited by the memory budget (SSS_TEXTURE_SPACE_BYTES_PER_TEXEL per texel), and the head without the slot takes the least recently used slot of the other heads (the eviction).
+// The slots used by the current frame are NOT evicted, s.t. the heads beyond the budget fall back to the blur of the screen space (the fallback).
+// NOTE: NOT thread safe (owned by the renderer)
+#define SSS_TEXTURE_SPACE_BYTES_PER_TEXEL 8U
+#define SSS_TEXTURE_SPACE_DEFAULT_MEMORY_BUDGET (16U * 1024U * 1024U)
+
+// FNV-1a (64 bits), chained by the "hash"
+inline uint64_t subsurface_scattering_texture_space_hash(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0U; i < size; ++i)
+	{
+		hash ^= uint64_t(bytes[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+class SSSTextureSpaceCache
+{
+public:
+	// maxSlotCount: the slots beyond the number of the heads are useless
+	explicit SSSTextureSpaceCache(int size = SSS_TEXTURE_SPACE_DEFAULT_SIZE, size_t memoryBudget = SSS_TEXTURE_SPACE_DEFAULT_MEMORY_BUDGET, int maxSlotCount = 64);
+
+	// The counters of the frame are reset, and the slots acquired after this call are NOT evicted until the next "beginFrame"
+	void beginFrame();
+
+	// Return the slot of the head, or -1 if all slots are used by the other heads of the current frame (the fallback).
+	// dirty: the slot should be relit and diffused (the miss), namely, the slot is newly assigned to the head or the key of the head has changed
+	int acquire(int headIndex, uint64_t key, bool& dirty);
+
+	// All slots are freed (without the evictions), e.g. when the atlas is recreated
+	void clear();
+
+	int getSize() const { return m_size; }
+	int getSlotCount() const { return static_cast<int>(m_slots.size()); }
+	size_t getSlotMemory() const { return static_cast<size_t>(m_size) * static_cast<size_t>(m_size) * SSS_TEXTURE_SPACE_BYTES_PER_TEXEL; }
+	size_t getMemoryBudget() const { return m_memoryBudget; }
+	// The slots which are assigned to the heads (the atlas of the GPU path always allocates all slots)
+	size_t getMemoryUsage() const;
+
+	// The counters since the construction (or the "clear")
+	uint64_t getHitCount() const { return m_hitCount; }
+	uint64_t getMissCount() const { return m_missCount; }
+	uint64_t getEvictionCount() const { return m_evictionCount; }
+	uint64_t getFallbackCount() const { return m_fallbackCount; }
+
+	// The counters of the current frame
+	int getFrameHitCount() const { return m_frameHitCount; }
+	int getFrameMissCount() const { return m_frameMissCount; }
+	int getFrameFallbackCount() const { return m_frameFallbackCount; }
+
+private:
+	struct Slot
+	{
+		// -1 means free
+		int headIndex;
+		uint64_t key;
+		uint64_t lastUsedFrame;
+	};
+
+	int m_size;
+	size_t m_memoryBudget;
+	std::vector<Slot> m_slots;
+	uint64_t m_frameIndex;
+
+	uint64_t m_hitCount;
+	uint64_t m_missCount;
+	uint64_t m_evictionCount;
+	uint64_t m_fallbackCount;
+	int m_frameHitCount;
+	int m_frameMissCount;
+	int m_frameFallbackCount;
+};
+
+#endif
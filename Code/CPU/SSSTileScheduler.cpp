@@ -0,0 +1,153 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include "SSSTileScheduler.h"
+
+SSSTileScheduler::SSSTileScheduler()
+{
+}
+
+SSSTileScheduler::~SSSTileScheduler()
+{
+}
+
+void SSSTileScheduler::begin(int workerCount)
+{
+	m_workers.clear();
+	m_workers.reserve(std::max(0, workerCount));
+	for (int workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+	{
+		std::unique_ptr<Worker> worker(new Worker());
+		worker->tileCount.store(0);
+		worker->stats = SSSTileSchedulerWorkerStats();
+		worker->busy = false;
+		m_workers.push_back(std::move(worker));
+	}
+}
+
+void SSSTileScheduler::seed(const std::vector<float>& tileCosts)
+{
+	const int workerCount = static_cast<int>(m_workers.size());
+
+	double totalCost = 0.0;
+	for (const float tileCost : tileCosts)
+	{
+		totalCost += double(tileCost);
+	}
+
+	// The worker "w" is seeded with the tiles of which the prefix sum of the cost (at the center of the tile) is in [w, w + 1) * totalCost / workerCount
+	double prefixCost = 0.0;
+	for (size_t tileIndex = 0U; tileIndex < tileCosts.size(); ++tileIndex)
+	{
+		const double centerCost = prefixCost + 0.5 * double(tileCosts[tileIndex]);
+		prefixCost += double(tileCosts[tileIndex]);
+
+		const int workerIndex = (totalCost > 0.0) ? std::min(static_cast<int>(centerCost * double(workerCount) / totalCost), workerCount - 1) : static_cast<int>((tileIndex * static_cast<size_t>(workerCount)) / tileCosts.size());
+		m_workers[workerIndex]->tiles.push_back(static_cast<int>(tileIndex));
+	}
+
+	for (std::unique_ptr<Worker>& worker : m_workers)
+	{
+		worker->tileCount.store(static_cast<int>(worker->tiles.size()));
+	}
+}
+
+bool SSSTileScheduler::next(int workerIndex, int& tileIndex)
+{
+	Worker& worker = *m_workers[workerIndex];
+
+	if (worker.busy)
+	{
+		worker.stats.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - worker.busyBegin).count();
+		worker.busy = false;
+	}
+
+	do
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (!worker.tiles.empty())
+		{
+			tileIndex = worker.tiles.front();
+			worker.tiles.pop_front();
+			worker.tileCount.store(static_cast<int>(worker.tiles.size()));
+
+			++worker.stats.tileCount;
+			worker.busy = true;
+			worker.busyBegin = std::chrono::steady_clock::now();
+			return true;
+		}
+	} while (steal(workerIndex));
+
+	return false;
+}
+
+bool SSSTileScheduler::steal(int workerIndex)
+{
+	Worker& thief = *m_workers[workerIndex];
+	const int workerCount = static_cast<int>(m_workers.size());
+
+	std::vector<int> stolenTiles;
+	for (;;)
+	{
+		// The victim of which the most tiles are left (starting from the next worker, s.t. the thieves spread over the victims)
+		int victimIndex = -1;
+		int victimTileCount = 0;
+		for (int offset = 1; offset < workerCount; ++offset)
+		{
+			const int candidateIndex = (workerIndex + offset) % workerCount;
+			const int candidateTileCount = m_workers[candidateIndex]->tileCount.load();
+			if (candidateTileCount > victimTileCount)
+			{
+				victimIndex = candidateIndex;
+				victimTileCount = candidateTileCount;
+			}
+		}
+
+		// NOTE: the tiles which are moved by other thieves are executed by them, s.t. nothing is lost if this worker stops
+		if (victimIndex < 0)
+		{
+			return false;
+		}
+
+		Worker& victim = *m_workers[victimIndex];
+		{
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			// Half of the tiles (rounded up) from the back
+			const size_t stealCount = (victim.tiles.size() + 1U) / 2U;
+			stolenTiles.assign(victim.tiles.end() - static_cast<std::ptrdiff_t>(stealCount), victim.tiles.end());
+			victim.tiles.erase(victim.tiles.end() - static_cast<std::ptrdiff_t>(stealCount), victim.tiles.end());
+			victim.tileCount.store(static_cast<int>(victim.tiles.size()));
+		}
+
+		// The victim may be emptied by the owner or another thief after the choice
+		if (!stolenTiles.empty())
+		{
+			break;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(thief.mutex);
+		thief.tiles.insert(thief.tiles.end(), stolenTiles.begin(), stolenTiles.end());
+		thief.tileCount.store(static_cast<int>(thief.tiles.size()));
+	}
+
+	++thief.stats.stealCount;
+	thief.stats.stolenTileCount += static_cast<uint64_t>(stolenTiles.size());
+	return true;
+}
@@ -0,0 +1,86 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSTileScheduler_H_
+#define _SSSTileScheduler_H_ 1
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct SSSTileSchedulerWorkerStats
+{
+	// The tiles executed by the worker (including the stolen tiles)
+	uint64_t tileCount;
+	// The steals of which the victim still had tiles, and the tiles moved by them
+	uint64_t stealCount;
+	uint64_t stolenTileCount;
+	// The time between the "next" which returned a tile and the following "next" (namely, excluding the scheduler and the idle time)
+	double busySeconds;
+};
+
+// The work-stealing scheduler of the tiles of the "SSSBlurCPU".
+//
+// Each worker owns one deque. The "seed" splits the tiles (in the order of the index) into the contiguous ranges of the same predicted cost, s.t. the deques are balanced before any steal and the tiles of each worker are neighbors (which share the samples in the cache).
+// The owner pops from the front and the thief takes half of the deque of the victim of which the most tiles are left from the back, s.t. few steals are needed and the stolen tiles are still neighbors.
+// NOTE: the deques are locked by the mutex (NOT lock free), since one tile takes far longer than the lock.
+class SSSTileScheduler
+{
+public:
+	SSSTileScheduler();
+	~SSSTileScheduler();
+
+	// Clear the deques and the stats of all workers (zero workers until the next "begin" if the "workerCount" is zero)
+	// NOTE: NOT thread safe (called before the workers start)
+	void begin(int workerCount);
+
+	// tileCosts: the predicted cost of each tile (the index of the tile is the index of the cost), and the neighbors are expected to be adjacent in the order of the index
+	// NOTE: NOT thread safe (called before the workers start), and the stats are accumulated until the next "begin"
+	void seed(const std::vector<float>& tileCosts);
+
+	// Called by the worker "workerIndex" only (each worker is one thread)
+	// Returns false if no tile is left in any deque
+	bool next(int workerIndex, int& tileIndex);
+
+	int getWorkerCount() const { return static_cast<int>(m_workers.size()); }
+
+	const SSSTileSchedulerWorkerStats& getWorkerStats(int workerIndex) const { return m_workers[workerIndex]->stats; }
+
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<int> tiles;
+		// The size of the "tiles", s.t. the thieves choose the victim without the lock
+		std::atomic<int> tileCount;
+		// Only accessed by the owner
+		SSSTileSchedulerWorkerStats stats;
+		bool busy;
+		std::chrono::steady_clock::time_point busyBegin;
+	};
+
+	bool steal(int workerIndex);
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+#endif
@@ -0,0 +1,57 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "SSSTransmittanceLUT.h"
+
+SSSTransmittanceLUT::SSSTransmittanceLUT(int size, float maxThickness) : m_size(std::max(size, int(SSS_TRANSMITTANCE_LUT_MIN_SIZE))),
+	m_maxThickness(std::max(maxThickness, 0.001f)),
+	m_profilesVersion(0U)
+{
+}
+
+void SSSTransmittanceLUT::setMaxThickness(float maxThickness)
+{
+	m_maxThickness = std::max(maxThickness, 0.001f);
+	m_profilesVersion = 0U;
+}
+
+bool SSSTransmittanceLUT::update(const SSSProfileTable& profiles)
+{
+	if (m_profilesVersion == profiles.getVersion())
+	{
+		return false;
+	}
+
+	const int profileCount = profiles.getCount();
+	m_table.resize(static_cast<size_t>(profileCount) * m_size);
+
+	const float h = 1.0f / float(m_size - 1);
+	for (int profileIndex = 0; profileIndex < profileCount; ++profileIndex)
+	{
+		const SSSProfile& profile = profiles.getProfile(profileIndex);
+		float4* row = &m_table[static_cast<size_t>(profileIndex) * m_size];
+		for (int i = 0; i < m_size; ++i)
+		{
+			// NOTE: the same arguments as the analytic version of the "RenderPS"
+			const float3 transmittance = profile.transmittanceTint * subsurface_scattering_disney_transmittance(profile.scatteringDistance, m_maxThickness * ((h * float(i)) * (h * float(i))));
+			row[i] = float4(transmittance.x, transmittance.y, transmittance.z, 0.0f);
+		}
+	}
+
+	m_profilesVersion = profiles.getVersion();
+	return true;
+}
@@ -0,0 +1,98 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SSSTransmittanceLUT_H_
+#define _SSSTransmittanceLUT_H_ 1
+
+#include <cstdint>
+#include <vector>
+#include "vector_math.h"
+#include "SSSProfileTable.h"
+#include "subsurface_scattering_disney_transmittance.h"
+
+// The counterpart of "Shaders/subsurface_scattering_transmittance_lut.hlsli"
+//
+// One row per profile: "transmittanceTint * EvaluateTransmittance(scatteringDistance, thickness)" tabulated in [0, maxThickness] (in mm).
+// The entries are uniform in "sqrt(thickness / maxThickness)", s.t. the steep part near zero thickness gets more entries.
+// The analytic version is used beyond the "maxThickness", s.t. the range only trades the resolution against the coverage.
+// The extended range covers the thin profiles (small S) of which the transmittance is still NOT negligible beyond the default range.
+#define SSS_TRANSMITTANCE_LUT_MIN_SIZE 2
+#define SSS_TRANSMITTANCE_LUT_DEFAULT_SIZE 64
+#define SSS_TRANSMITTANCE_LUT_MAX_THICKNESS 32.0f
+#define SSS_TRANSMITTANCE_LUT_EXTENDED_MAX_THICKNESS 128.0f
+
+inline float3 subsurface_scattering_transmittance_lut(const float4* lut_row, int lut_size, float max_thickness, float3 scattering_distance, float3 transmittance_tint, float thickness);
+
+// Rebuilt on the CPU when the profiles change. The same data is uploaded as the "Texture2D<float4>" (DXGI_FORMAT_R32G32B32A32_FLOAT, one row per profile) of the GPU path.
+class SSSTransmittanceLUT
+{
+public:
+	explicit SSSTransmittanceLUT(int size = SSS_TRANSMITTANCE_LUT_DEFAULT_SIZE, float maxThickness = SSS_TRANSMITTANCE_LUT_MAX_THICKNESS);
+
+	// Return true if the table is rebuilt (namely, the GPU copy should be uploaded)
+	bool update(const SSSProfileTable& profiles);
+
+	// The table is rebuilt by the next "update"
+	void setMaxThickness(float maxThickness);
+
+	int getSize() const { return m_size; }
+	int getProfileCount() const { return static_cast<int>(m_table.size()) / m_size; }
+	float getMaxThickness() const { return m_maxThickness; }
+
+	// Row major: [profile index][thickness]
+	const float4* getData() const { return m_table.data(); }
+
+	float3 evaluate(const SSSProfileTable& profiles, int profileIndex, float thickness) const
+	{
+		const SSSProfile& profile = profiles.getProfile(profileIndex);
+		return subsurface_scattering_transmittance_lut(&m_table[static_cast<size_t>(profileIndex) * m_size], m_size, m_maxThickness, profile.scatteringDistance, profile.transmittanceTint, thickness);
+	}
+
+private:
+	int m_size;
+	float m_maxThickness;
+	// The version of the profiles which the table is built from (0 means dirty)
+	uint64_t m_profilesVersion;
+	std::vector<float4> m_table;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+//    IMPLEMENTATION
+//
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+inline float3 subsurface_scattering_transmittance_lut(const float4* lut_row, int lut_size, float max_thickness, float3 scattering_distance, float3 transmittance_tint, float thickness)
+{
+	// NOTE: "!(thickness < max_thickness)" also catches the NaN
+	if (!(thickness < max_thickness))
+	{
+		return transmittance_tint * subsurface_scattering_disney_transmittance(scattering_distance, thickness);
+	}
+
+	const float t = std::sqrt(std::max(thickness, 0.0f) * (1.0f / max_thickness)) * float(lut_size - 1);
+	const int index = std::min(int(t), lut_size - 2);
+	const float f = t - float(index);
+
+	const float4 p0 = lut_row[index];
+	const float4 p1 = lut_row[index + 1];
+	return lerp(float3(p0.x, p0.y, p0.z), float3(p1.x, p1.y, p1.z), f);
+}
+
+#endif
@@ -0,0 +1,194 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SWIZZLED_IMAGE_H_
+#define _SWIZZLED_IMAGE_H_ 1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vector_math.h"
+#include "Image.h"
+
+// IMAGE_LAYOUT_ROW_MAJOR: the same as the "Image"
+// IMAGE_LAYOUT_MORTON: the tiles of IMAGE_LAYOUT_MORTON_TILE_SIZE x IMAGE_LAYOUT_MORTON_TILE_SIZE in the row-major order, and the texels of each tile in the Z-order
+// IMAGE_LAYOUT_BLOCK_LINEAR: the blocks of (1 << blockWidthLog2) x (1 << blockHeightLog2) in the row-major order, and the texels of each block in the row-major order
+#define IMAGE_LAYOUT_ROW_MAJOR 0
+#define IMAGE_LAYOUT_MORTON 1
+#define IMAGE_LAYOUT_BLOCK_LINEAR 2
+#define IMAGE_LAYOUT_COUNT 3
+
+#define IMAGE_LAYOUT_MORTON_TILE_SIZE_LOG2 6
+#define IMAGE_LAYOUT_MORTON_TILE_SIZE (1 << IMAGE_LAYOUT_MORTON_TILE_SIZE_LOG2)
+
+// 4 x 4 texels of the RGBA32F (256 bytes) namely 4 cache lines of 64 bytes
+#define IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_WIDTH_LOG2 2
+#define IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_HEIGHT_LOG2 2
+
+// The bits of the "v" (at most 16 bits) interleaved with zeros: the bit i is moved to the bit 2i
+inline uint32_t image_layout_morton_spread(uint32_t v)
+{
+	v &= 0x0000FFFFU;
+	v = (v | (v << 8)) & 0x00FF00FFU;
+	v = (v | (v << 4)) & 0x0F0F0F0FU;
+	v = (v | (v << 2)) & 0x33333333U;
+	v = (v | (v << 1)) & 0x55555555U;
+	return v;
+}
+
+// The CPU image of which the texels are swizzled, s.t. the neighbors in both directions share the cache lines (the counterpart of the tiled layout of the GPU textures).
+// The size is padded to the multiple of the tile (or the block), and the padding texels are NOT accessed by the "sampleLevelPoint".
+template <typename T, int CHANNEL_COUNT>
+class SwizzledImage
+{
+public:
+	SwizzledImage() : m_width(0),
+		m_height(0),
+		m_layout(IMAGE_LAYOUT_ROW_MAJOR),
+		m_blockWidthLog2(0),
+		m_blockHeightLog2(0),
+		m_blockCountX(0)
+	{
+	}
+
+	// NOTE: the texels are reused (NOT cleared) if the size and the layout do NOT change
+	void resize(int width, int height, int layout, int blockWidthLog2 = IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_WIDTH_LOG2, int blockHeightLog2 = IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_HEIGHT_LOG2)
+	{
+		m_width = width;
+		m_height = height;
+		m_layout = layout;
+
+		switch (layout)
+		{
+		case IMAGE_LAYOUT_MORTON:
+		{
+			m_blockWidthLog2 = IMAGE_LAYOUT_MORTON_TILE_SIZE_LOG2;
+			m_blockHeightLog2 = IMAGE_LAYOUT_MORTON_TILE_SIZE_LOG2;
+		}
+		break;
+		case IMAGE_LAYOUT_BLOCK_LINEAR:
+		{
+			m_blockWidthLog2 = blockWidthLog2;
+			m_blockHeightLog2 = blockHeightLog2;
+		}
+		break;
+		default:
+		{
+			m_layout = IMAGE_LAYOUT_ROW_MAJOR;
+			m_blockWidthLog2 = 0;
+			m_blockHeightLog2 = 0;
+		}
+		}
+
+		m_blockCountX = (width + (1 << m_blockWidthLog2) - 1) >> m_blockWidthLog2;
+		const int blockCountY = (height + (1 << m_blockHeightLog2) - 1) >> m_blockHeightLog2;
+		m_data.resize((static_cast<size_t>(m_blockCountX) * static_cast<size_t>(blockCountY) << (m_blockWidthLog2 + m_blockHeightLog2)) * CHANNEL_COUNT, T(0));
+	}
+
+	int getWidth() const { return m_width; }
+	int getHeight() const { return m_height; }
+	int getLayout() const { return m_layout; }
+
+	// The texels including the padding (in the order of the layout)
+	T* getData() { return m_data.data(); }
+	const T* getData() const { return m_data.data(); }
+	size_t getTexelCount() const { return m_data.size() / CHANNEL_COUNT; }
+
+	// The index of the texel (x, y) in the order of the layout
+	size_t texelIndex(int x, int y) const
+	{
+		switch (m_layout)
+		{
+		case IMAGE_LAYOUT_MORTON:
+		{
+			const size_t tileIndex = static_cast<size_t>(y >> IMAGE_LAYOUT_MORTON_TILE_SIZE_LOG2) * static_cast<size_t>(m_blockCountX) + static_cast<size_t>(x >> IMAGE_LAYOUT_MORTON_TILE_SIZE_LOG2);
+			const uint32_t mask = IMAGE_LAYOUT_MORTON_TILE_SIZE - 1;
+			return (tileIndex << (2 * IMAGE_LAYOUT_MORTON_TILE_SIZE_LOG2)) | static_cast<size_t>(image_layout_morton_spread(uint32_t(x) & mask) | (image_layout_morton_spread(uint32_t(y) & mask) << 1));
+		}
+		case IMAGE_LAYOUT_BLOCK_LINEAR:
+		{
+			const size_t blockIndex = static_cast<size_t>(y >> m_blockHeightLog2) * static_cast<size_t>(m_blockCountX) + static_cast<size_t>(x >> m_blockWidthLog2);
+			const int blockWidthMask = (1 << m_blockWidthLog2) - 1;
+			const int blockHeightMask = (1 << m_blockHeightLog2) - 1;
+			return (blockIndex << (m_blockWidthLog2 + m_blockHeightLog2)) | static_cast<size_t>(((y & blockHeightMask) << m_blockWidthLog2) | (x & blockWidthMask));
+		}
+		default:
+		{
+			return static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x);
+		}
+		}
+	}
+
+	T* operator()(int x, int y) { return &m_data[texelIndex(x, y) * CHANNEL_COUNT]; }
+	const T* operator()(int x, int y) const { return &m_data[texelIndex(x, y) * CHANNEL_COUNT]; }
+
+	// D3D11_FILTER_MIN_MAG_MIP_POINT + D3D11_TEXTURE_ADDRESS_CLAMP (the same texel as the "Image::sampleLevelPoint")
+	const T* sampleLevelPoint(float2 uv) const
+	{
+		return (*this)(Image<T, CHANNEL_COUNT>::texelCoord(uv.x, m_width), Image<T, CHANNEL_COUNT>::texelCoord(uv.y, m_height));
+	}
+
+	// The conversion from the row-major image (the size is taken from the "image")
+	void swizzle(const Image<T, CHANNEL_COUNT>& image, int layout, int blockWidthLog2 = IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_WIDTH_LOG2, int blockHeightLog2 = IMAGE_LAYOUT_BLOCK_LINEAR_DEFAULT_HEIGHT_LOG2)
+	{
+		resize(image.getWidth(), image.getHeight(), layout, blockWidthLog2, blockHeightLog2);
+		for (int y = 0; y < m_height; ++y)
+		{
+			for (int x = 0; x < m_width; ++x)
+			{
+				const T* src = image(x, y);
+				T* dst = (*this)(x, y);
+				for (int channel = 0; channel < CHANNEL_COUNT; ++channel)
+				{
+					dst[channel] = src[channel];
+				}
+			}
+		}
+	}
+
+	// The conversion to the row-major image of the same size
+	void unswizzle(Image<T, CHANNEL_COUNT>& image) const
+	{
+		for (int y = 0; y < m_height; ++y)
+		{
+			for (int x = 0; x < m_width; ++x)
+			{
+				const T* src = (*this)(x, y);
+				T* dst = image(x, y);
+				for (int channel = 0; channel < CHANNEL_COUNT; ++channel)
+				{
+					dst[channel] = src[channel];
+				}
+			}
+		}
+	}
+
+private:
+	int m_width;
+	int m_height;
+	int m_layout;
+	int m_blockWidthLog2;
+	int m_blockHeightLog2;
+	int m_blockCountX;
+	std::vector<T> m_data;
+};
+
+typedef SwizzledImage<float, 4> SwizzledImageRGBA32F;
+typedef SwizzledImage<float, 1> SwizzledImageR32F;
+typedef SwizzledImage<uint8_t, 1> SwizzledImageR8U;
+
+#endif
@@ -0,0 +1,93 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include <cstring>
+#include <iostream>
+#include "SSSBenchmark.h"
+
+// The console runner of the "benchmark*" of the "SSSBenchmark.h" with the default arguments (NOT run by the "SSSTest", since the benchmarks take minutes).
+// Usage: SSSBenchmarkRunner [name]... (all benchmarks if no name is given, e.g. "SSSBenchmarkRunner AdaptiveSampling Separable")
+// The exit code is zero if all benchmarks which report the "passed" pass.
+struct BenchmarkEntry
+{
+	const char* name;
+	bool (*run)();
+};
+
+// The results without the "passed" are only reports
+template <typename RESULT>
+static auto resultPassed(const RESULT& result, int) -> decltype(bool(result.passed))
+{
+	return result.passed;
+}
+
+template <typename RESULT>
+static bool resultPassed(const RESULT&, long)
+{
+	return true;
+}
+
+template <typename RESULT>
+static bool printResult(const RESULT& result)
+{
+	std::cout << result << std::endl;
+	return resultPassed(result, 0);
+}
+
+static const BenchmarkEntry benchmarkEntries[] = {
+	{ "DiffusionProfile", [] { return printResult(benchmarkDiffusionProfile()); } },
+	{ "InverseCdfLUT", [] { return printResult(benchmarkInverseCdfLUT()); } },
+	{ "TransmittanceLUT", [] { return printResult(benchmarkTransmittanceLUT()); } },
+	{ "SequenceConvergence", [] { return printResult(benchmarkSequenceConvergence()); } },
+	{ "MisVariance", [] { return printResult(benchmarkMisVariance()); } },
+	{ "Separable", [] { return printResult(benchmarkSeparable()); } },
+	{ "LowResolution", [] { return printResult(benchmarkLowResolution()); } },
+	{ "TemporalConvergence", [] { return printResult(benchmarkTemporalConvergence()); } },
+	{ "AdaptiveSampling", [] { return printResult(benchmarkAdaptiveSampling()); } },
+	{ "TileClassification", [] { return printResult(benchmarkTileClassification()); } },
+	{ "MaskPyramid", [] { return printResult(benchmarkMaskPyramid()); } },
+	{ "IrradiancePyramid", [] { return printResult(benchmarkIrradiancePyramid()); } },
+	{ "ImageLayout", [] { return printResult(benchmarkImageLayout()); } },
+	{ "WorkStealing", [] { return printResult(benchmarkWorkStealing()); } },
+	{ "CoherentSampling", [] { return printResult(benchmarkCoherentSampling()); } },
+	{ "SampleCountBuckets", [] { return printResult(benchmarkSampleCountBuckets()); } },
+	{ "StochasticDenoiser", [] { return printResult(benchmarkStochasticDenoiser()); } },
+	{ "PreintegratedLUT", [] { return printResult(benchmarkPreintegratedLUT()); } },
+	{ "LodSelection", [] { return printResult(benchmarkLodSelection()); } },
+	{ "TextureSpaceCache", [] { return printResult(benchmarkTextureSpaceCache()); } },
+};
+
+int main(int argc, char* argv[])
+{
+	bool passed = true;
+	for (const BenchmarkEntry& entry : benchmarkEntries)
+	{
+		bool selected = (argc < 2);
+		for (int argIndex = 1; argIndex < argc; ++argIndex)
+		{
+			selected = selected || (0 == std::strcmp(argv[argIndex], entry.name));
+		}
+
+		if (selected)
+		{
+			passed = entry.run() && passed;
+		}
+	}
+
+	return passed ? 0 : 1;
+}
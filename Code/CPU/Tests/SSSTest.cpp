@@ -0,0 +1,64 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include <cstring>
+#include <iostream>
+#include "SSSBenchmark.h"
+
+// The console test of the CPU path (no GPU required): the golden images of the "SSSBlurCPU" and the "verify*" of the "SSSBenchmark.h".
+// Usage: SSSTest <golden path prefix> [--update-golden]
+// The exit code is zero if all tests pass.
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <golden path prefix> [--update-golden]" << std::endl;
+		return 2;
+	}
+
+	const bool updateGolden = (argc > 2) && (0 == std::strcmp(argv[2], "--update-golden"));
+
+	bool passed = true;
+
+	const GoldenImageVerificationResult goldenImages = verifyGoldenImages(argv[1], updateGolden);
+	std::cout << goldenImages << std::endl;
+	passed = passed && goldenImages.passed;
+
+	const EnergyConservationVerificationResult energyConservation = verifyEnergyConservation();
+	std::cout << energyConservation << std::endl;
+	passed = passed && energyConservation.passed;
+
+	const MultiProfileVerificationResult multiProfile = verifyMultiProfile();
+	std::cout << multiProfile << std::endl;
+	passed = passed && multiProfile.passed;
+
+	const TemporalReprojectionVerificationResult temporalReprojection = verifyTemporalReprojection();
+	std::cout << temporalReprojection << std::endl;
+	passed = passed && temporalReprojection.passed;
+
+	const GBufferEncodingVerificationResult gbufferEncoding = verifyGBufferEncoding();
+	std::cout << gbufferEncoding << std::endl;
+	passed = passed && gbufferEncoding.passed;
+
+	const ShadowThicknessVerificationResult shadowThickness = verifyShadowThickness();
+	std::cout << shadowThickness << std::endl;
+	passed = passed && shadowThickness.passed;
+
+	std::cout << (passed ? "ALL PASSED" : "FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
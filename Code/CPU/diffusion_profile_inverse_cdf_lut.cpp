@@ -0,0 +1,46 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <cmath>
+#include "diffusion_profile_inverse_cdf_lut.h"
+
+// The table is built in double precision, s.t. the error of the LUT is NOT polluted by the cancellation of the float version when "cdf -> 0".
+static double inverseCdfDouble(double cdf)
+{
+	double u = 1.0 - cdf;
+	if (u >= 1.0)
+	{
+		return 0.0;
+	}
+	double g = 1.0 + (4.0 * u) * (2.0 * u + std::sqrt(1.0 + (4.0 * u) * u));
+	double c = 1.0 + std::cbrt(g) + 1.0 / std::cbrt(g);
+	return 3.0 * std::log(c / (4.0 * u));
+}
+
+DiffusionProfileInverseCdfLUT::DiffusionProfileInverseCdfLUT(int size) : m_table(std::max(size, int(SSS_INVERSE_CDF_LUT_MIN_SIZE)))
+{
+	const int tableSize = static_cast<int>(m_table.size());
+	const double h = double(SSS_INVERSE_CDF_LUT_MAX_CDF) / double(tableSize - 1);
+
+	for (int i = 0; i < tableSize; ++i)
+	{
+		double x = inverseCdfDouble(h * double(i));
+		// dx/dcdf = 4 / (Exp[-x] + Exp[-x/3])
+		double dx_dcdf = 4.0 / (std::exp(-x) + std::exp(-x / 3.0));
+		m_table[i] = float2(float(x), float(h * dx_dcdf));
+	}
+}
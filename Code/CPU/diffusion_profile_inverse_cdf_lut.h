@@ -0,0 +1,109 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/diffusion_profile_inverse_cdf_lut.hlsli"
+//
+// The "diffusion_profile_sample_r" is proportional to "d", s.t. the normalized inverse CDF "x = diffusion_profile_sample_r(1, cdf)" is shared by all profiles and "r = x * d".
+// The table samples the normalized inverse CDF uniformly in [0, SSS_INVERSE_CDF_LUT_MAX_CDF].
+// Since "dx/dcdf" diverges when "cdf -> 1", the analytic version is used beyond the "SSS_INVERSE_CDF_LUT_MAX_CDF".
+//
+// Each entry stores (x, h * dx/dcdf) where h is the spacing of the table, s.t. the cubic Hermite interpolation only depends on the two neighbouring entries.
+// dx/dcdf = 1 / (dcdf/dx) = 4 / (Exp[-x] + Exp[-x/3])
+//
+
+#ifndef _DIFFUSION_PROFILE_INVERSE_CDF_LUT_H_
+#define _DIFFUSION_PROFILE_INVERSE_CDF_LUT_H_ 1
+
+#include <vector>
+#include "vector_math.h"
+#include "subsurface_scattering_disney_blur.h"
+
+#define SSS_INVERSE_CDF_MODE_ANALYTIC 0
+#define SSS_INVERSE_CDF_MODE_LUT_LINEAR 1
+#define SSS_INVERSE_CDF_MODE_LUT_HERMITE 2
+
+#define SSS_INVERSE_CDF_LUT_MAX_CDF 0.99f
+#define SSS_INVERSE_CDF_LUT_MIN_SIZE 2
+#define SSS_INVERSE_CDF_LUT_DEFAULT_SIZE 256
+
+inline float diffusion_profile_sample_r_lut(const float2* lut, int lut_size, int mode, float d, float cdf);
+
+// Built once on the CPU. The same data is uploaded as the "Texture1D<float2>" (DXGI_FORMAT_R32G32_FLOAT) of the GPU path.
+class DiffusionProfileInverseCdfLUT
+{
+public:
+	explicit DiffusionProfileInverseCdfLUT(int size = SSS_INVERSE_CDF_LUT_DEFAULT_SIZE);
+
+	int getSize() const { return static_cast<int>(m_table.size()); }
+
+	const float2* getData() const { return m_table.data(); }
+
+	float sampleR(int mode, float d, float cdf) const
+	{
+		return diffusion_profile_sample_r_lut(m_table.data(), static_cast<int>(m_table.size()), mode, d, cdf);
+	}
+
+private:
+	std::vector<float2> m_table;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+//    IMPLEMENTATION
+//
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+inline float diffusion_profile_sample_r_lut(const float2* lut, int lut_size, int mode, float d, float cdf)
+{
+	// NOTE: "!(cdf < MAX_CDF)" also catches the NaN
+	if ((SSS_INVERSE_CDF_MODE_ANALYTIC == mode) || !(cdf < SSS_INVERSE_CDF_LUT_MAX_CDF))
+	{
+		return diffusion_profile_sample_r(d, cdf);
+	}
+
+	const float t = std::max(cdf, 0.0f) * (float(lut_size - 1) / SSS_INVERSE_CDF_LUT_MAX_CDF);
+	const int index = std::min(int(t), lut_size - 2);
+	const float f = t - float(index);
+
+	const float2 p0 = lut[index];
+	const float2 p1 = lut[index + 1];
+
+	float x;
+	if (SSS_INVERSE_CDF_MODE_LUT_HERMITE == mode)
+	{
+		// Cubic Hermite spline
+		const float f2 = f * f;
+		const float f3 = f2 * f;
+		const float h00 = 2.0f * f3 - 3.0f * f2 + 1.0f;
+		const float h10 = f3 - 2.0f * f2 + f;
+		const float h01 = 3.0f * f2 - 2.0f * f3;
+		const float h11 = f3 - f2;
+		x = h00 * p0.x + h10 * p0.y + h01 * p1.x + h11 * p1.y;
+	}
+	else
+	{
+		x = lerp(p0.x, p1.x, f);
+	}
+
+	// r = x * rcpS = x * d
+	float r = x * d;
+	return r;
+}
+
+#endif
@@ -0,0 +1,114 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include "diffusion_profile_simd.h"
+#include "subsurface_scattering_disney_blur.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+static int diffusion_profile_detect_simd_width()
+{
+	bool avx2 = false;
+	bool avx512f = false;
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	int info[4];
+	__cpuid(info, 0);
+	int max_leaf = info[0];
+	__cpuid(info, 1);
+	bool osxsave = (0 != (info[2] & (1 << 27)));
+	bool avx = (0 != (info[2] & (1 << 28)));
+	bool fma = (0 != (info[2] & (1 << 12)));
+	if (osxsave && avx && (max_leaf >= 7))
+	{
+		// XCR0: the OS saves the XMM and YMM (bits 1 and 2) and the opmask and ZMM (bits 5, 6 and 7) registers
+		unsigned long long xcr0 = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+		avx2 = fma && (0x6 == (xcr0 & 0x6)) && (0 != (info[1] & (1 << 5)));
+		avx512f = (0xE6 == (xcr0 & 0xE6)) && (0 != (info[1] & (1 << 16)));
+	}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+	// NOTE: the "__builtin_cpu_supports" also checks the XCR0 (whether the OS saves the registers)
+	__builtin_cpu_init();
+	avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	avx512f = __builtin_cpu_supports("avx512f");
+#endif
+	if (avx512f && diffusion_profile_batch_x16_compiled())
+	{
+		return 16;
+	}
+	else if (avx2 && diffusion_profile_batch_x8_compiled())
+	{
+		return 8;
+	}
+	else
+	{
+		return 1;
+	}
+}
+
+int diffusion_profile_simd_width()
+{
+	static const int simd_width = diffusion_profile_detect_simd_width();
+	return simd_width;
+}
+
+void diffusion_profile_sample_r_batch(float d, const float* cdf, float* r, int count)
+{
+	int simd_width = diffusion_profile_simd_width();
+	int i = (16 == simd_width) ? diffusion_profile_sample_r_batch_x16(d, cdf, r, count) : (8 == simd_width) ? diffusion_profile_sample_r_batch_x8(d, cdf, r, count) : 0;
+	for (; i < count; ++i)
+	{
+		r[i] = diffusion_profile_sample_r(d, cdf[i]);
+	}
+}
+
+void diffusion_profile_evaluate_cdf_batch(float d, const float* r, float* cdf, int count)
+{
+	int simd_width = diffusion_profile_simd_width();
+	int i = (16 == simd_width) ? diffusion_profile_evaluate_cdf_batch_x16(d, r, cdf, count) : (8 == simd_width) ? diffusion_profile_evaluate_cdf_batch_x8(d, r, cdf, count) : 0;
+	for (; i < count; ++i)
+	{
+		cdf[i] = diffusion_profile_evaluate_cdf(d, r[i]);
+	}
+}
+
+void diffusion_profile_evaluate_rcp_pdf_batch(float d, const float* r, float* rcp_pdf, int count)
+{
+	int simd_width = diffusion_profile_simd_width();
+	int i = (16 == simd_width) ? diffusion_profile_evaluate_rcp_pdf_batch_x16(d, r, rcp_pdf, count) : (8 == simd_width) ? diffusion_profile_evaluate_rcp_pdf_batch_x8(d, r, rcp_pdf, count) : 0;
+	for (; i < count; ++i)
+	{
+		rcp_pdf[i] = diffusion_profile_evaluate_rcp_pdf(d, r[i]);
+	}
+}
+
+void diffusion_profile_evaluate_pdf_batch(float3 S, const float* r, float* pdf_r, float* pdf_g, float* pdf_b, int count)
+{
+	int simd_width = diffusion_profile_simd_width();
+	int i = (16 == simd_width) ? diffusion_profile_evaluate_pdf_batch_x16(S, r, pdf_r, pdf_g, pdf_b, count) : (8 == simd_width) ? diffusion_profile_evaluate_pdf_batch_x8(S, r, pdf_r, pdf_g, pdf_b, count) : 0;
+	for (; i < count; ++i)
+	{
+		float3 pdf = diffusion_profile_evaluate_pdf(S, r[i]);
+		pdf_r[i] = pdf.x;
+		pdf_g[i] = pdf.y;
+		pdf_b[i] = pdf.z;
+	}
+}
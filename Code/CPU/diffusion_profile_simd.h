@@ -0,0 +1,442 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The batch (SIMD) counterparts of the "diffusion_profile_*" of the "subsurface_scattering_disney_blur.h".
+//
+// The 8-wide version (AVX2 + FMA) and the 16-wide version (AVX-512F) are compiled by the "diffusion_profile_simd_avx2.cpp" and the "diffusion_profile_simd_avx512.cpp" with the per-file instruction set,
+// and the widest version supported by the CPU is selected at runtime, s.t. the rest of the CPU path (SSE2) is NOT required to be compiled with "/arch:AVX2".
+// The scalar fallback (and the remainder) uses the std::exp2 / std::log2 version of the "subsurface_scattering_disney_blur.h", since the scalar "approx_*" is NOT faster than the std.
+// The scalar "approx_*" is merely the reference of the SIMD versions.
+//
+// Maximum error of the approximations (measured against the double precision reference, see also "benchmarkDiffusionProfile"):
+// approx_exp2: x in [-126, 126]         : 2 ULP
+// approx_log2: x in [FLT_MIN, FLT_MAX]  : 2 ULP (3.0e-11 absolute error when |log2(x)| < 0.001)
+// approx_cbrt: x in [1, 2^24]           : 2 ULP
+//
+// The error of the whole functions is dominated by the conditioning of the formulas (the rounding of the arguments) rather than by the approximations,
+// and is the same as the error of the std::exp2 / std::log2 version (in brackets):
+// diffusion_profile_sample_r:         cdf in [0.05, 0.999999] : 96 ULP (146 ULP)
+// diffusion_profile_evaluate_cdf:     r / d in [0.05, 64]     : 50 ULP (50 ULP)
+// diffusion_profile_evaluate_rcp_pdf: r / d in [0.05, 64]     : 16 ULP (15 ULP)
+// diffusion_profile_evaluate_pdf:     r * S in [0.05, 64]     : 16 ULP (15 ULP)
+//
+// NOTE: the result of the "approx_exp2" is clamped to [2^-126, 2^126] (NO denormal, NO infinity).
+
+#ifndef _DIFFUSION_PROFILE_SIMD_H_
+#define _DIFFUSION_PROFILE_SIMD_H_ 1
+
+#include <cstdint>
+#include <cstring>
+#include "math_consts.h"
+#include "vector_math.h"
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Polynomial coefficients (Taylor series)
+// 2^f = Exp[f * Ln[2]], f in [-0.5, 0.5]
+#define APPROX_EXP2_C1 0.693147180559945309417f
+#define APPROX_EXP2_C2 0.240226506959100712333f
+#define APPROX_EXP2_C3 0.0555041086648215799532f
+#define APPROX_EXP2_C4 0.00961812910762847716197f
+#define APPROX_EXP2_C5 0.00133335581464284434234f
+#define APPROX_EXP2_C6 0.000154035303933816099545f
+#define APPROX_EXP2_C7 0.0000152527338040598402800f
+
+// Log2[m] = (2 / Ln[2]) * ArcTanh[s], s = (m - 1) / (m + 1), m in [Sqrt[0.5], Sqrt[2])
+#define APPROX_LOG2_C1 2.88539008177792681472f
+#define APPROX_LOG2_C3 0.961796693925975604906f
+#define APPROX_LOG2_C5 0.577078016355585362944f
+#define APPROX_LOG2_C7 0.412198583111132402103f
+#define APPROX_LOG2_C9 0.320598897975325201636f
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    SCALAR
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline float approx_as_float(int32_t i)
+{
+	float f;
+	std::memcpy(&f, &i, sizeof(float));
+	return f;
+}
+
+inline int32_t approx_as_int(float f)
+{
+	int32_t i;
+	std::memcpy(&i, &f, sizeof(float));
+	return i;
+}
+
+inline float approx_exp2(float x)
+{
+	x = std::min(std::max(x, -126.0f), 126.0f);
+
+	float n = std::floor(x + 0.5f);
+	float f = x - n;
+
+	float p = APPROX_EXP2_C7;
+	p = p * f + APPROX_EXP2_C6;
+	p = p * f + APPROX_EXP2_C5;
+	p = p * f + APPROX_EXP2_C4;
+	p = p * f + APPROX_EXP2_C3;
+	p = p * f + APPROX_EXP2_C2;
+	p = p * f + APPROX_EXP2_C1;
+	p = p * f + 1.0f;
+
+	// 2^n
+	float scale = approx_as_float((int32_t(n) + 127) << 23);
+	return p * scale;
+}
+
+inline float approx_log2(float x)
+{
+	int32_t i = approx_as_int(x);
+
+	// x = m * 2^e, m in [1, 2)
+	float e = float(((i >> 23) & 0xFF) - 127);
+	float m = approx_as_float((i & 0x007FFFFF) | 0x3F800000);
+
+	// m in [Sqrt[0.5], Sqrt[2])
+	if (m > 1.41421356237309504880f)
+	{
+		m *= 0.5f;
+		e += 1.0f;
+	}
+
+	float s = (m - 1.0f) / (m + 1.0f);
+	float s2 = s * s;
+
+	float p = APPROX_LOG2_C9;
+	p = p * s2 + APPROX_LOG2_C7;
+	p = p * s2 + APPROX_LOG2_C5;
+	p = p * s2 + APPROX_LOG2_C3;
+	p = p * s2 + APPROX_LOG2_C1;
+
+	return e + s * p;
+}
+
+inline float approx_cbrt(float x)
+{
+	// Initial guess by the exponent division: i / 3 + (127 - 127 / 3) * 2^23
+	int32_t i = approx_as_int(x);
+	float y = approx_as_float(int32_t(float(i) * (1.0f / 3.0f)) + 709921077);
+
+	// Newton-Raphson: y = y - (y^3 - x) / (3 * y^2)
+	y = (2.0f * y + x / (y * y)) * (1.0f / 3.0f);
+	y = (2.0f * y + x / (y * y)) * (1.0f / 3.0f);
+	y = (2.0f * y + x / (y * y)) * (1.0f / 3.0f);
+	return y;
+}
+
+inline float approx_diffusion_profile_sample_r(float d, float cdf)
+{
+	float u = 1.0f - cdf; // Convert CDF to CCDF
+
+	float g = 1.0f + (4.0f * u) * (2.0f * u + std::sqrt(1.0f + (4.0f * u) * u));
+
+	// g^(+1/3)
+	float p = approx_cbrt(g);
+	// g^(-1/3)
+	float n = 1.0f / p;
+	// 1 + g^(+1/3) + g^(-1/3)
+	float c = 1.0f + p + n;
+	// 3 * Log[4 * u]
+	float b = float(3.0 / LOG2_E * 2.0) + float(3.0 / LOG2_E) * approx_log2(u);
+	// 3 * Log[c / (4 * u)]
+	float x = float(3.0 / LOG2_E) * approx_log2(c) - b;
+
+	float r = x * d;
+	return r;
+}
+
+inline float approx_diffusion_profile_evaluate_cdf(float d, float r)
+{
+	float exp_13 = approx_exp2((float(LOG2_E * (-1.0 / 3.0)) * r) * (1.0f / d));
+	float exp_sum = exp_13 * (-0.75f - 0.25f * exp_13 * exp_13);
+	float cdf = 1.0f + exp_sum;
+	return cdf;
+}
+
+inline float approx_diffusion_profile_evaluate_rcp_pdf(float d, float r)
+{
+	float exp_13 = approx_exp2((float(LOG2_E * (-1.0 / 3.0)) * r) * (1.0f / d));
+	float exp_sum = exp_13 * (1.0f + exp_13 * exp_13);
+	float rcpExp = (1.0f / exp_sum);
+	float rcp_pdf = float(8.0 * PI) * d * rcpExp;
+	return rcp_pdf;
+}
+
+inline float3 approx_diffusion_profile_evaluate_pdf(float3 S, float r)
+{
+	float3 exp_13(approx_exp2((float(LOG2_E * (-1.0 / 3.0)) * r) * S.x), approx_exp2((float(LOG2_E * (-1.0 / 3.0)) * r) * S.y), approx_exp2((float(LOG2_E * (-1.0 / 3.0)) * r) * S.z));
+	float3 exp_sum = exp_13 * (float3(1.0f) + exp_13 * exp_13);
+	float3 pdf = S / float(8.0 * PI) * exp_sum;
+	return pdf;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    AVX2 (8-WIDE)
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__AVX2__)
+
+#if defined(__FMA__) || defined(_MSC_VER)
+#define APPROX_FMADD_X8(a, b, c) _mm256_fmadd_ps((a), (b), (c))
+#else
+#define APPROX_FMADD_X8(a, b, c) _mm256_add_ps(_mm256_mul_ps((a), (b)), (c))
+#endif
+
+inline __m256 approx_exp2_x8(__m256 x)
+{
+	x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-126.0f)), _mm256_set1_ps(126.0f));
+
+	__m256 n = _mm256_floor_ps(_mm256_add_ps(x, _mm256_set1_ps(0.5f)));
+	__m256 f = _mm256_sub_ps(x, n);
+
+	__m256 p = _mm256_set1_ps(APPROX_EXP2_C7);
+	p = APPROX_FMADD_X8(p, f, _mm256_set1_ps(APPROX_EXP2_C6));
+	p = APPROX_FMADD_X8(p, f, _mm256_set1_ps(APPROX_EXP2_C5));
+	p = APPROX_FMADD_X8(p, f, _mm256_set1_ps(APPROX_EXP2_C4));
+	p = APPROX_FMADD_X8(p, f, _mm256_set1_ps(APPROX_EXP2_C3));
+	p = APPROX_FMADD_X8(p, f, _mm256_set1_ps(APPROX_EXP2_C2));
+	p = APPROX_FMADD_X8(p, f, _mm256_set1_ps(APPROX_EXP2_C1));
+	p = APPROX_FMADD_X8(p, f, _mm256_set1_ps(1.0f));
+
+	__m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23));
+	return _mm256_mul_ps(p, scale);
+}
+
+inline __m256 approx_log2_x8(__m256 x)
+{
+	__m256i i = _mm256_castps_si256(x);
+
+	__m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(i, 23), _mm256_set1_epi32(0xFF)), _mm256_set1_epi32(127)));
+	__m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(i, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000)));
+
+	__m256 is_greater = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356237309504880f), _CMP_GT_OQ);
+	m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), is_greater);
+	e = _mm256_add_ps(e, _mm256_and_ps(is_greater, _mm256_set1_ps(1.0f)));
+
+	__m256 s = _mm256_div_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)), _mm256_add_ps(m, _mm256_set1_ps(1.0f)));
+	__m256 s2 = _mm256_mul_ps(s, s);
+
+	__m256 p = _mm256_set1_ps(APPROX_LOG2_C9);
+	p = APPROX_FMADD_X8(p, s2, _mm256_set1_ps(APPROX_LOG2_C7));
+	p = APPROX_FMADD_X8(p, s2, _mm256_set1_ps(APPROX_LOG2_C5));
+	p = APPROX_FMADD_X8(p, s2, _mm256_set1_ps(APPROX_LOG2_C3));
+	p = APPROX_FMADD_X8(p, s2, _mm256_set1_ps(APPROX_LOG2_C1));
+
+	return APPROX_FMADD_X8(s, p, e);
+}
+
+inline __m256 approx_cbrt_x8(__m256 x)
+{
+	__m256i i = _mm256_castps_si256(x);
+	__m256 y = _mm256_castsi256_ps(_mm256_add_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(i), _mm256_set1_ps(1.0f / 3.0f))), _mm256_set1_epi32(709921077)));
+
+	__m256 two = _mm256_set1_ps(2.0f);
+	__m256 one_third = _mm256_set1_ps(1.0f / 3.0f);
+	y = _mm256_mul_ps(APPROX_FMADD_X8(two, y, _mm256_div_ps(x, _mm256_mul_ps(y, y))), one_third);
+	y = _mm256_mul_ps(APPROX_FMADD_X8(two, y, _mm256_div_ps(x, _mm256_mul_ps(y, y))), one_third);
+	y = _mm256_mul_ps(APPROX_FMADD_X8(two, y, _mm256_div_ps(x, _mm256_mul_ps(y, y))), one_third);
+	return y;
+}
+
+inline __m256 diffusion_profile_sample_r_x8(__m256 d, __m256 cdf)
+{
+	__m256 one = _mm256_set1_ps(1.0f);
+	__m256 u = _mm256_sub_ps(one, cdf);
+	__m256 u4 = _mm256_mul_ps(_mm256_set1_ps(4.0f), u);
+
+	__m256 g = APPROX_FMADD_X8(u4, _mm256_add_ps(_mm256_add_ps(u, u), _mm256_sqrt_ps(APPROX_FMADD_X8(u4, u, one))), one);
+
+	__m256 p = approx_cbrt_x8(g);
+	__m256 n = _mm256_div_ps(one, p);
+	__m256 c = _mm256_add_ps(_mm256_add_ps(one, p), n);
+	__m256 b = APPROX_FMADD_X8(_mm256_set1_ps(float(3.0 / LOG2_E)), approx_log2_x8(u), _mm256_set1_ps(float(3.0 / LOG2_E * 2.0)));
+	__m256 x = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(float(3.0 / LOG2_E)), approx_log2_x8(c)), b);
+
+	return _mm256_mul_ps(x, d);
+}
+
+inline __m256 diffusion_profile_evaluate_cdf_x8(__m256 d, __m256 r)
+{
+	__m256 exp_13 = approx_exp2_x8(_mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(float(LOG2_E * (-1.0 / 3.0))), r), d));
+	__m256 exp_sum = _mm256_mul_ps(exp_13, APPROX_FMADD_X8(_mm256_set1_ps(-0.25f), _mm256_mul_ps(exp_13, exp_13), _mm256_set1_ps(-0.75f)));
+	return _mm256_add_ps(_mm256_set1_ps(1.0f), exp_sum);
+}
+
+inline __m256 diffusion_profile_evaluate_rcp_pdf_x8(__m256 d, __m256 r)
+{
+	__m256 exp_13 = approx_exp2_x8(_mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(float(LOG2_E * (-1.0 / 3.0))), r), d));
+	__m256 exp_sum = _mm256_mul_ps(exp_13, APPROX_FMADD_X8(exp_13, exp_13, _mm256_set1_ps(1.0f)));
+	return _mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(float(8.0 * PI)), d), exp_sum);
+}
+
+inline __m256 diffusion_profile_evaluate_pdf_channel_x8(__m256 S, __m256 r)
+{
+	__m256 exp_13 = approx_exp2_x8(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(float(LOG2_E * (-1.0 / 3.0))), r), S));
+	__m256 exp_sum = _mm256_mul_ps(exp_13, APPROX_FMADD_X8(exp_13, exp_13, _mm256_set1_ps(1.0f)));
+	return _mm256_mul_ps(_mm256_mul_ps(S, _mm256_set1_ps(float(1.0 / (8.0 * PI)))), exp_sum);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    AVX-512 (16-WIDE)
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__AVX512F__)
+
+// The "maskz" forms of all lanes, since the unmasked intrinsics of the GCC pass an uninitialized vector as the inactive lanes (-Wmaybe-uninitialized), while the result is the same
+#define APPROX_ALL_LANES_X16 ((__mmask16)0xFFFF)
+
+inline __m512 approx_exp2_x16(__m512 x)
+{
+	x = _mm512_maskz_min_ps(APPROX_ALL_LANES_X16, _mm512_maskz_max_ps(APPROX_ALL_LANES_X16, x, _mm512_set1_ps(-126.0f)), _mm512_set1_ps(126.0f));
+
+	__m512 n = _mm512_maskz_roundscale_ps(APPROX_ALL_LANES_X16, _mm512_add_ps(x, _mm512_set1_ps(0.5f)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+	__m512 f = _mm512_sub_ps(x, n);
+
+	__m512 p = _mm512_set1_ps(APPROX_EXP2_C7);
+	p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(APPROX_EXP2_C6));
+	p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(APPROX_EXP2_C5));
+	p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(APPROX_EXP2_C4));
+	p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(APPROX_EXP2_C3));
+	p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(APPROX_EXP2_C2));
+	p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(APPROX_EXP2_C1));
+	p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(1.0f));
+
+	__m512 scale = _mm512_castsi512_ps(_mm512_maskz_slli_epi32(APPROX_ALL_LANES_X16, _mm512_add_epi32(_mm512_maskz_cvtps_epi32(APPROX_ALL_LANES_X16, n), _mm512_set1_epi32(127)), 23));
+	return _mm512_mul_ps(p, scale);
+}
+
+inline __m512 approx_log2_x16(__m512 x)
+{
+	__m512i i = _mm512_castps_si512(x);
+
+	__m512 e = _mm512_maskz_cvtepi32_ps(APPROX_ALL_LANES_X16, _mm512_sub_epi32(_mm512_and_si512(_mm512_maskz_srli_epi32(APPROX_ALL_LANES_X16, i, 23), _mm512_set1_epi32(0xFF)), _mm512_set1_epi32(127)));
+	__m512 m = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(i, _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3F800000)));
+
+	__mmask16 is_greater = _mm512_cmp_ps_mask(m, _mm512_set1_ps(1.41421356237309504880f), _CMP_GT_OQ);
+	m = _mm512_mask_mul_ps(m, is_greater, m, _mm512_set1_ps(0.5f));
+	e = _mm512_mask_add_ps(e, is_greater, e, _mm512_set1_ps(1.0f));
+
+	__m512 s = _mm512_div_ps(_mm512_sub_ps(m, _mm512_set1_ps(1.0f)), _mm512_add_ps(m, _mm512_set1_ps(1.0f)));
+	__m512 s2 = _mm512_mul_ps(s, s);
+
+	__m512 p = _mm512_set1_ps(APPROX_LOG2_C9);
+	p = _mm512_fmadd_ps(p, s2, _mm512_set1_ps(APPROX_LOG2_C7));
+	p = _mm512_fmadd_ps(p, s2, _mm512_set1_ps(APPROX_LOG2_C5));
+	p = _mm512_fmadd_ps(p, s2, _mm512_set1_ps(APPROX_LOG2_C3));
+	p = _mm512_fmadd_ps(p, s2, _mm512_set1_ps(APPROX_LOG2_C1));
+
+	return _mm512_fmadd_ps(s, p, e);
+}
+
+inline __m512 approx_cbrt_x16(__m512 x)
+{
+	__m512i i = _mm512_castps_si512(x);
+	__m512 y = _mm512_castsi512_ps(_mm512_add_epi32(_mm512_maskz_cvttps_epi32(APPROX_ALL_LANES_X16, _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(APPROX_ALL_LANES_X16, i), _mm512_set1_ps(1.0f / 3.0f))), _mm512_set1_epi32(709921077)));
+
+	__m512 two = _mm512_set1_ps(2.0f);
+	__m512 one_third = _mm512_set1_ps(1.0f / 3.0f);
+	y = _mm512_mul_ps(_mm512_fmadd_ps(two, y, _mm512_div_ps(x, _mm512_mul_ps(y, y))), one_third);
+	y = _mm512_mul_ps(_mm512_fmadd_ps(two, y, _mm512_div_ps(x, _mm512_mul_ps(y, y))), one_third);
+	y = _mm512_mul_ps(_mm512_fmadd_ps(two, y, _mm512_div_ps(x, _mm512_mul_ps(y, y))), one_third);
+	return y;
+}
+
+inline __m512 diffusion_profile_sample_r_x16(__m512 d, __m512 cdf)
+{
+	__m512 one = _mm512_set1_ps(1.0f);
+	__m512 u = _mm512_sub_ps(one, cdf);
+	__m512 u4 = _mm512_mul_ps(_mm512_set1_ps(4.0f), u);
+
+	__m512 g = _mm512_fmadd_ps(u4, _mm512_add_ps(_mm512_add_ps(u, u), _mm512_maskz_sqrt_ps(APPROX_ALL_LANES_X16, _mm512_fmadd_ps(u4, u, one))), one);
+
+	__m512 p = approx_cbrt_x16(g);
+	__m512 n = _mm512_div_ps(one, p);
+	__m512 c = _mm512_add_ps(_mm512_add_ps(one, p), n);
+	__m512 b = _mm512_fmadd_ps(_mm512_set1_ps(float(3.0 / LOG2_E)), approx_log2_x16(u), _mm512_set1_ps(float(3.0 / LOG2_E * 2.0)));
+	__m512 x = _mm512_sub_ps(_mm512_mul_ps(_mm512_set1_ps(float(3.0 / LOG2_E)), approx_log2_x16(c)), b);
+
+	return _mm512_mul_ps(x, d);
+}
+
+inline __m512 diffusion_profile_evaluate_cdf_x16(__m512 d, __m512 r)
+{
+	__m512 exp_13 = approx_exp2_x16(_mm512_div_ps(_mm512_mul_ps(_mm512_set1_ps(float(LOG2_E * (-1.0 / 3.0))), r), d));
+	__m512 exp_sum = _mm512_mul_ps(exp_13, _mm512_fmadd_ps(_mm512_set1_ps(-0.25f), _mm512_mul_ps(exp_13, exp_13), _mm512_set1_ps(-0.75f)));
+	return _mm512_add_ps(_mm512_set1_ps(1.0f), exp_sum);
+}
+
+inline __m512 diffusion_profile_evaluate_rcp_pdf_x16(__m512 d, __m512 r)
+{
+	__m512 exp_13 = approx_exp2_x16(_mm512_div_ps(_mm512_mul_ps(_mm512_set1_ps(float(LOG2_E * (-1.0 / 3.0))), r), d));
+	__m512 exp_sum = _mm512_mul_ps(exp_13, _mm512_fmadd_ps(exp_13, exp_13, _mm512_set1_ps(1.0f)));
+	return _mm512_div_ps(_mm512_mul_ps(_mm512_set1_ps(float(8.0 * PI)), d), exp_sum);
+}
+
+inline __m512 diffusion_profile_evaluate_pdf_channel_x16(__m512 S, __m512 r)
+{
+	__m512 exp_13 = approx_exp2_x16(_mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(float(LOG2_E * (-1.0 / 3.0))), r), S));
+	__m512 exp_sum = _mm512_mul_ps(exp_13, _mm512_fmadd_ps(exp_13, exp_13, _mm512_set1_ps(1.0f)));
+	return _mm512_mul_ps(_mm512_mul_ps(S, _mm512_set1_ps(float(1.0 / (8.0 * PI)))), exp_sum);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    BATCH
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// The arrays are NOT required to be aligned.
+// The widest instruction set supported by the CPU is used for the bulk and the scalar fallback is used for the remainder.
+void diffusion_profile_sample_r_batch(float d, const float* cdf, float* r, int count);
+void diffusion_profile_evaluate_cdf_batch(float d, const float* r, float* cdf, int count);
+void diffusion_profile_evaluate_rcp_pdf_batch(float d, const float* r, float* rcp_pdf, int count);
+void diffusion_profile_evaluate_pdf_batch(float3 S, const float* r, float* pdf_r, float* pdf_g, float* pdf_b, int count);
+
+// 16 (AVX-512), 8 (AVX2) or 1 (scalar), detected at runtime (once)
+int diffusion_profile_simd_width();
+
+// The bulk of the batch, which returns the number of the elements processed (0 when the instruction set is NOT compiled in).
+// NOTE: the CPU is NOT checked (only called by the "diffusion_profile_*_batch" above).
+int diffusion_profile_sample_r_batch_x8(float d, const float* cdf, float* r, int count);
+int diffusion_profile_evaluate_cdf_batch_x8(float d, const float* r, float* cdf, int count);
+int diffusion_profile_evaluate_rcp_pdf_batch_x8(float d, const float* r, float* rcp_pdf, int count);
+int diffusion_profile_evaluate_pdf_batch_x8(float3 S, const float* r, float* pdf_r, float* pdf_g, float* pdf_b, int count);
+bool diffusion_profile_batch_x8_compiled();
+
+int diffusion_profile_sample_r_batch_x16(float d, const float* cdf, float* r, int count);
+int diffusion_profile_evaluate_cdf_batch_x16(float d, const float* r, float* cdf, int count);
+int diffusion_profile_evaluate_rcp_pdf_batch_x16(float d, const float* r, float* rcp_pdf, int count);
+int diffusion_profile_evaluate_pdf_batch_x16(float3 S, const float* r, float* pdf_r, float* pdf_g, float* pdf_b, int count);
+bool diffusion_profile_batch_x16_compiled();
+
+#endif
@@ -0,0 +1,87 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+// The 16-wide bulk of the "diffusion_profile_*_batch" (see "diffusion_profile_simd.h").
+//
+// NOTE: this file is compiled with -mavx512f or /arch:AVX512 while the rest of the CPU path is NOT, and is only called when the CPU supports the instruction set.
+// Only the "_x16" functions may be called here, since the inline functions of the other instruction sets (or of the scalar version) emitted by this file might be picked by the linker for the other files.
+
+#include "diffusion_profile_simd.h"
+
+int diffusion_profile_sample_r_batch_x16(float d, const float* cdf, float* r, int count)
+{
+	int i = 0;
+#if defined(__AVX512F__)
+	for (__m512 d_x16 = _mm512_set1_ps(d); (i + 16) <= count; i += 16)
+	{
+		_mm512_storeu_ps(r + i, diffusion_profile_sample_r_x16(d_x16, _mm512_loadu_ps(cdf + i)));
+	}
+#endif
+	return i;
+}
+
+int diffusion_profile_evaluate_cdf_batch_x16(float d, const float* r, float* cdf, int count)
+{
+	int i = 0;
+#if defined(__AVX512F__)
+	for (__m512 d_x16 = _mm512_set1_ps(d); (i + 16) <= count; i += 16)
+	{
+		_mm512_storeu_ps(cdf + i, diffusion_profile_evaluate_cdf_x16(d_x16, _mm512_loadu_ps(r + i)));
+	}
+#endif
+	return i;
+}
+
+int diffusion_profile_evaluate_rcp_pdf_batch_x16(float d, const float* r, float* rcp_pdf, int count)
+{
+	int i = 0;
+#if defined(__AVX512F__)
+	for (__m512 d_x16 = _mm512_set1_ps(d); (i + 16) <= count; i += 16)
+	{
+		_mm512_storeu_ps(rcp_pdf + i, diffusion_profile_evaluate_rcp_pdf_x16(d_x16, _mm512_loadu_ps(r + i)));
+	}
+#endif
+	return i;
+}
+
+int diffusion_profile_evaluate_pdf_batch_x16(float3 S, const float* r, float* pdf_r, float* pdf_g, float* pdf_b, int count)
+{
+	int i = 0;
+#if defined(__AVX512F__)
+	__m512 S_r = _mm512_set1_ps(S.x);
+	__m512 S_g = _mm512_set1_ps(S.y);
+	__m512 S_b = _mm512_set1_ps(S.z);
+	for (; (i + 16) <= count; i += 16)
+	{
+		__m512 r_x16 = _mm512_loadu_ps(r + i);
+		_mm512_storeu_ps(pdf_r + i, diffusion_profile_evaluate_pdf_channel_x16(S_r, r_x16));
+		_mm512_storeu_ps(pdf_g + i, diffusion_profile_evaluate_pdf_channel_x16(S_g, r_x16));
+		_mm512_storeu_ps(pdf_b + i, diffusion_profile_evaluate_pdf_channel_x16(S_b, r_x16));
+	}
+#endif
+	return i;
+}
+
+bool diffusion_profile_batch_x16_compiled()
+{
+#if defined(__AVX512F__)
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,172 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _LOW_DISCREPANCY_H_
+#define _LOW_DISCREPANCY_H_ 1
+
+// C++ counterpart of "Shaders/low_discrepancy_sequence.hlsli"
+
+#include <cstdint>
+#include "vector_math.h"
+
+// The sequence ID of the "low_discrepancy_sequence_2d"
+#define LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY 0
+#define LOW_DISCREPANCY_SEQUENCE_FIBONACCI 1
+#define LOW_DISCREPANCY_SEQUENCE_R2 2
+#define LOW_DISCREPANCY_SEQUENCE_SOBOL_OWEN 3
+#define LOW_DISCREPANCY_SEQUENCE_BLUE_NOISE 4
+#define LOW_DISCREPANCY_SEQUENCE_COUNT 5
+
+#define LOW_DISCREPANCY_BLUE_NOISE_POINT_COUNT 80
+
+inline uint32_t reversebits(uint32_t value)
+{
+	value = (value << 16U) | (value >> 16U);
+	value = ((value & 0x00FF00FFU) << 8U) | ((value & 0xFF00FF00U) >> 8U);
+	value = ((value & 0x0F0F0F0FU) << 4U) | ((value & 0xF0F0F0F0U) >> 4U);
+	value = ((value & 0x33333333U) << 2U) | ((value & 0xCCCCCCCCU) >> 2U);
+	value = ((value & 0x55555555U) << 1U) | ((value & 0xAAAAAAAAU) >> 1U);
+	return value;
+}
+
+inline float2 hammersley_2d(uint32_t sample_index, uint32_t sample_count)
+{
+	// "7.4.1 Hammersley and Halton Sequences" of PBR Book
+	// UE: [Hammersley](https://github.com/EpicGames/UnrealEngine/blob/4.27/Engine/Shaders/Private/MonteCarlo.ush#L34)
+	// U3D: [Hammersley2d](https://github.com/Unity-Technologies/Graphics/blob/v10.8.0/com.unity.render-pipelines.core/ShaderLibrary/Sampling/Hammersley.hlsl#L415)
+
+	float xi_1 = float(sample_index) / float(sample_count);
+	float xi_2 = float(reversebits(sample_index)) * float(1.0 / 4294967296.0);
+
+	return float2(xi_1, xi_2);
+}
+
+inline float2 fibonacci_2d(uint32_t sample_index, uint32_t sample_count)
+{
+	// https://en.wikipedia.org/wiki/Golden_ratio#Relationship_to_Fibonacci_sequence
+	// U3D: [Fibonacci2d](https://github.com/Unity-Technologies/Graphics/blob/v10.8.0/com.unity.render-pipelines.core/ShaderLibrary/Sampling/Fibonacci.hlsl#L16)
+	// NOTE: the fraction is evaluated in 32-bit fixed point, s.t. the precision does NOT decrease with the index (and only 24 bits are kept, s.t. the value is NOT rounded up to 1.0)
+	// 2654435769 = round(2^32 / golden_ratio)
+
+	float xi_1 = (float(sample_index) + 0.5f) / float(sample_count);
+	float xi_2 = float((sample_index * 2654435769U) >> 8U) * float(1.0 / 16777216.0);
+
+	return float2(xi_1, xi_2);
+}
+
+inline float2 r2_2d(uint32_t sample_index)
+{
+	// [Martin Roberts. "The Unreasonable Effectiveness of Quasirandom Sequences." 2018.](http://extremelearning.com.au/unreasonable-effectiveness-of-quasirandom-sequences/)
+	// The Kronecker sequence of the plastic number: frac(0.5 + n * (1 / g, 1 / g^2)) where g^3 = g + 1
+	// NOTE: the fraction is evaluated in 32-bit fixed point, s.t. the precision does NOT decrease with the index (and only 24 bits are kept, s.t. the value is NOT rounded up to 1.0)
+	// 3242174889 = round(2^32 / g), 2447445414 = round(2^32 / g^2)
+
+	float xi_1 = float((2147483648U + sample_index * 3242174889U) >> 8U) * float(1.0 / 16777216.0);
+	float xi_2 = float((2147483648U + sample_index * 2447445414U) >> 8U) * float(1.0 / 16777216.0);
+
+	return float2(xi_1, xi_2);
+}
+
+inline uint32_t laine_karras_permutation(uint32_t value, uint32_t seed)
+{
+	value += seed;
+	value ^= value * 0x6c50b47cU;
+	value ^= value * 0xb82f1e52U;
+	value ^= value * 0xc7afe638U;
+	value ^= value * 0x8d22f6e6U;
+	return value;
+}
+
+inline uint32_t nested_uniform_scramble(uint32_t value, uint32_t seed)
+{
+	value = reversebits(value);
+	value = laine_karras_permutation(value, seed);
+	value = reversebits(value);
+	return value;
+}
+
+inline float2 sobol_owen_2d(uint32_t sample_index)
+{
+	// [Brent Burley. "Practical Hash-based Owen Scrambling." JCGT 2020.](https://jcgt.org/published/0009/04/01/)
+	// The first dimension of the Sobol sequence is the van der Corput sequence, and the second dimension is generated by the direction numbers "v ^= v >> 1".
+	// NOTE: the seeds are constant, s.t. all pixels share the same kernel (as the other sequences)
+
+	uint32_t sobol_1 = reversebits(sample_index);
+
+	uint32_t sobol_2 = 0U;
+	for (uint32_t index = sample_index, v = (1U << 31U); 0U != index; index >>= 1U, v ^= (v >> 1U))
+	{
+		if (0U != (index & 1U))
+		{
+			sobol_2 ^= v;
+		}
+	}
+
+	float xi_1 = float(nested_uniform_scramble(sobol_1, 0x8a3c1f5dU) >> 8U) * float(1.0 / 16777216.0);
+	float xi_2 = float(nested_uniform_scramble(sobol_2, 0x2d7b94e1U) >> 8U) * float(1.0 / 16777216.0);
+
+	return float2(xi_1, xi_2);
+}
+
+inline float2 blue_noise_2d(uint32_t sample_index)
+{
+	// Progressive: each prefix of the point set is well distributed, s.t. the same table is used by all sample counts.
+	// Generated by the best-candidate algorithm ([Don P. Mitchell. "Spectrally Optimal Sampling for Distribution Ray Tracing." SIGGRAPH 1991.](https://doi.org/10.1145/127719.122736)) with the toroidal distance and "64 * n" candidates for the n-th point.
+	static const float blue_noise_points[LOW_DISCREPANCY_BLUE_NOISE_POINT_COUNT * 2] = {
+		0.316593528f, 0.875706971f, 0.817218959f, 0.3137182f, 0.822947919f, 0.802365541f, 0.342273951f, 0.371989548f,
+		0.595685005f, 0.0506322384f, 0.0961852074f, 0.603780866f, 0.0498498678f, 0.0750439167f, 0.539352596f, 0.646940053f,
+		0.306465864f, 0.126363099f, 0.0918661356f, 0.361384511f, 0.787325621f, 0.556313872f, 0.567756593f, 0.283088028f,
+		0.0734766126f, 0.840498626f, 0.826614439f, 0.0160238147f, 0.302418232f, 0.670116961f, 0.56125021f, 0.847314358f,
+		0.504846096f, 0.464828014f, 0.946943641f, 0.470285773f, 0.929069698f, 0.659519851f, 0.721409976f, 0.164765298f,
+		0.2259022f, 0.495536029f, 0.976373792f, 0.232816517f, 0.431023896f, 0.00321787596f, 0.161880732f, 0.204300046f,
+		0.668345273f, 0.418143094f, 0.170081794f, 0.974454939f, 0.676164865f, 0.723665655f, 0.699617267f, 0.921276629f,
+		0.452175558f, 0.173803926f, 0.425682068f, 0.754073501f, 0.952157795f, 0.935139775f, 0.391880631f, 0.552791238f,
+		0.202516675f, 0.775443137f, 0.653716624f, 0.580811262f, 0.86144489f, 0.146281838f, 0.21612525f, 0.32406944f,
+		0.95033437f, 0.805364907f, 0.803607702f, 0.677660525f, 0.328872442f, 0.248517156f, 0.690906644f, 0.285241425f,
+		0.788718045f, 0.432384729f, 0.463349283f, 0.347987056f, 0.0398060679f, 0.714587033f, 0.304088831f, 0.99651438f,
+		0.973040164f, 0.352427304f, 0.0656459928f, 0.483788192f, 0.592908323f, 0.170165956f, 0.189796329f, 0.092457056f,
+		0.442565024f, 0.884504497f, 0.937532961f, 0.0674037933f, 0.715333343f, 0.04488796f, 0.532927692f, 0.956406713f,
+		0.059963882f, 0.947440028f, 0.194077671f, 0.667699814f, 0.852311492f, 0.906021833f, 0.996446311f, 0.572817981f,
+		0.528380096f, 0.748998344f, 0.204159319f, 0.877558947f, 0.432951629f, 0.644975245f, 0.719850063f, 0.814739585f,
+		0.0748169422f, 0.260206878f, 0.50215596f, 0.0859385729f, 0.330029368f, 0.47127378f, 0.895237029f, 0.560952902f,
+		0.308143675f, 0.776929915f, 0.600159883f, 0.498013318f, 0.87864399f, 0.393426776f, 0.57007134f, 0.385055184f,
+		0.492569208f, 0.559461057f, 0.881554961f, 0.240994632f, 0.285381794f, 0.572780252f, 0.0696194172f, 0.164699078f,
+		0.160309374f, 0.425316989f, 0.418369949f, 0.427490175f, 0.255158424f, 0.407330394f, 0.39786762f, 0.0928955674f,
+		0.708789766f, 0.504694998f, 0.420944929f, 0.258045912f, 0.88877058f, 0.739498973f, 0.721273899f, 0.640360713f };
+
+	// NOTE: the indices beyond the table fall back to the R2 sequence
+	return (sample_index < LOW_DISCREPANCY_BLUE_NOISE_POINT_COUNT) ? float2(blue_noise_points[2U * sample_index], blue_noise_points[2U * sample_index + 1U]) : r2_2d(sample_index);
+}
+
+inline float2 low_discrepancy_sequence_2d(int sequence, uint32_t sample_index, uint32_t sample_count)
+{
+	switch (sequence)
+	{
+	case LOW_DISCREPANCY_SEQUENCE_FIBONACCI:
+		return fibonacci_2d(sample_index, sample_count);
+	case LOW_DISCREPANCY_SEQUENCE_R2:
+		return r2_2d(sample_index);
+	case LOW_DISCREPANCY_SEQUENCE_SOBOL_OWEN:
+		return sobol_owen_2d(sample_index);
+	case LOW_DISCREPANCY_SEQUENCE_BLUE_NOISE:
+		return blue_noise_2d(sample_index);
+	default:
+		return hammersley_2d(sample_index, sample_count);
+	}
+}
+
+#endif
@@ -0,0 +1,33 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _MATH_CONSTS_H_
+#define _MATH_CONSTS_H_ 1
+
+// C++ counterpart of "Shaders/math_consts.hlsli"
+
+#include <cfloat>
+
+#ifndef PI
+#define PI 3.141592653589793238462643
+#endif
+
+#ifndef LOG2_E
+#define LOG2_E 1.44269504088896340736
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/subsurface_scattering_adaptive.hlsli"
+//
+// The pilot pass and the refinement pass are the two "subsurface_scattering_disney_blur_estimate" (see "subsurface_scattering_disney_blur.h") of the "SSSBlurCPU".
+// The sums over the pixels are exact on the CPU, while the GPU reads the mean from the last mip of the "GenerateMips" (see "SSSBlur").
+// The CPU also solves the "uniform_sample_count" and the "deviation_scale" s.t. the budget which exceeds the "sample_budget" of the edge pixels is redistributed (water filling), while the GPU uses the proportional "deviation_scale" and may spend less than the budget.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_ADAPTIVE_H_
+#define _SUBSURFACE_SCATTERING_ADAPTIVE_H_ 1
+
+#include <algorithm>
+#include <cmath>
+#include "math_consts.h"
+#include "vector_math.h"
+
+#define SSS_ADAPTIVE_PILOT_SAMPLE_COUNT 8
+#define SSS_ADAPTIVE_UNIFORM_FRACTION 0.25
+#define SSS_ADAPTIVE_DEVIATION_MIP_LEVEL 4
+
+inline float subsurface_scattering_adaptive_deviation(float standard_error, int sample_count)
+{
+	return standard_error * std::sqrt(float(sample_count));
+}
+
+inline float subsurface_scattering_adaptive_refinement_samples_per_pixel(float samples_per_frame, float covered_pixel_count, float sum_pilot_sample_count)
+{
+	return std::max(samples_per_frame - sum_pilot_sample_count, 0.0f) / std::max(covered_pixel_count, 1.0f);
+}
+
+inline int subsurface_scattering_adaptive_refinement_sample_count(float deviation, float deviation_scale, float uniform_sample_count, int pilot_sample_count, int sample_budget)
+{
+	// NOTE: clamp before the conversion to "int" since the behavior of the out-of-range conversion is undefined in C++
+	const int sample_count = int(std::min(std::max(uniform_sample_count + deviation_scale * deviation + 0.5f, 0.0f), float(std::max(sample_budget, 0))));
+	return (sample_count > pilot_sample_count) ? sample_count : 0;
+}
+
+#endif
@@ -0,0 +1,501 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/subsurface_scattering_disney_blur.hlsli"
+//
+// Note: Provided by the User!
+//
+// The "SSS_SOURCE" template parameter replaces the macros of the HLSL version:
+// float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const <=> SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE
+// float3 total_diffuse_reflectance_post_scatter(float2 uv) const                     <=> SSS_TOTAL_DIFFUSE_REFLECTANCE_POST_SCATTER_SOURCE
+// float subsurface_mask(float2 uv) const                                             <=> SSS_SUBSURFACE_MASK_SOURCE
+// int subsurface_profile_index(float2 uv) const                                      <=> SSS_SUBSURFACE_PROFILE_INDEX_SOURCE
+// float view_space_position_z(float2 uv) const                                       <=> SSS_VIEW_SPACE_POSITION_Z_SOURCE
+// float projection_x() const                                                         <=> SSS_PROJECTION_X_SOURCE
+// float projection_y() const                                                         <=> SSS_PROJECTION_Y_SOURCE
+// float2 pixels_per_uv() const                                                       <=> SSS_PIXELS_PER_UV
+// float diffusion_profile_sample_r(float d, float cdf) const                        <=> SSS_DIFFUSION_PROFILE_SAMPLE_R_SOURCE
+// float center_sample_cdf(float center_sample_cdf) const                            <=> SSS_CENTER_SAMPLE_CDF_SOURCE
+// float2 sample_sequence(int sample_count, int sample_index) const                   <=> SSS_SAMPLE_SEQUENCE_SOURCE
+// float4 kernel_sample(float d, float center_sample_cdf, int sample_count, int sample_index) const <=> SSS_KERNEL_SAMPLE_SOURCE
+// float2 sample_rotation() const                                                     <=> SSS_SAMPLE_ROTATION_SOURCE
+// int mask_pyramid_level_count() const / float4 mask_pyramid(int level, int x, int y) const <=> SSS_MASK_PYRAMID_LEVEL_COUNT / SSS_MASK_PYRAMID_SOURCE (see "subsurface_scattering_mask_pyramid.h")
+// int irradiance_pyramid_level_count() const / float4 irradiance_pyramid(int level, int x, int y) const / float irradiance_pyramid_view_space_position_z(int level, int x, int y) const <=> SSS_IRRADIANCE_PYRAMID_* (see "subsurface_scattering_irradiance_pyramid.h")
+//
+// The "sample_sequence" returns the point of the "low_discrepancy_sequence_2d" (see "low_discrepancy_sequence.h"), of which x is mapped to the radius and y to the angle.
+// The "kernel_sample" returns (offset_in_mm.x, offset_in_mm.y, r, rcp_pdf), either evaluated by the "subsurface_scattering_disney_kernel_sample" or fetched from the kernel cache (see "SSSKernelCache.h").
+//
+
+#ifndef _SUBSURFACE_SCATTERING_DISNEY_BLUR_H_
+#define _SUBSURFACE_SCATTERING_DISNEY_BLUR_H_ 1
+
+#include "math_consts.h"
+#include "vector_math.h"
+#include "low_discrepancy_sequence.h"
+#include "subsurface_scattering_mask_pyramid.h"
+#include "subsurface_scattering_irradiance_pyramid.h"
+
+#define SSS_MIN_PIXELS_PER_SAMPLE 4
+#define SSS_MAX_SAMPLE_BUDGET 80
+
+// SSS_MIS_MODE_NONE: all samples are drawn from the profile of the widest channel
+// SSS_MIS_MODE_BALANCE / SSS_MIS_MODE_POWER: the budget is split across the profiles of the three channels (in proportion to the area of the filter of each channel), and the samples are combined by the balance / power (beta = 2) heuristic
+#define SSS_MIS_MODE_NONE 0
+#define SSS_MIS_MODE_BALANCE 1
+#define SSS_MIS_MODE_POWER 2
+
+// The pixels which take fewer samples fall back to SSS_MIS_MODE_NONE, since the budget split across the three strategies leaves too few samples to each of them to be stratified (the MIS is noisier than the widest channel below 32 samples, see "benchmarkMisVariance")
+#define SSS_MIS_MIN_SAMPLE_COUNT 32
+
+// https://zero-radiance.github.io/post/sampling-diffusion/
+// S = ShapeParam = 1 / ScatteringDistance = 1 / d
+// d = ScatteringDistance = 1 / ShapeParam = 1 / S
+// CDF is the random number (the value of the CDF): [0, 1).
+// r is the sampled radial distance, s.t. (CDF = 0 -> r = 0) and (CDF = 1 -> r = Inf).
+// PDF is the derivative of the (marginal) CDF. Actually, '2 * PI' should be multiplied to convert the normalized diffusion profile to 1D, namely, PDF = (DiffusionProfile * r / A) * (2 * PI).
+inline float diffusion_profile_sample_r(float d, float cdf);
+inline float diffusion_profile_evaluate_cdf(float d, float r);
+inline float diffusion_profile_evaluate_rcp_pdf(float d, float r);
+inline float3 diffusion_profile_evaluate_pdf(float3 S, float r);
+
+template <typename SSS_SOURCE>
+inline float4 subsurface_scattering_disney_kernel_sample(const SSS_SOURCE& source, float d, float center_sample_cdf, int sample_count, int sample_index)
+{
+	// NOTE: Hammersley by default, or the other sequence selected by the user
+	float2 xi = source.sample_sequence(sample_count, sample_index);
+
+	// Center Sample Reweighting
+	xi.x = lerp(center_sample_cdf, 1.0f, xi.x);
+
+	// Sampling Diffusion Profile
+	// NOTE: the analytic version or the inverse CDF LUT (see "diffusion_profile_inverse_cdf_lut.h")
+	float r = source.diffusion_profile_sample_r(d, xi.x);
+	float theta = 2.0f * float(PI) * xi.y;
+
+	float rcp_pdf = diffusion_profile_evaluate_rcp_pdf(d, r);
+
+	return float4(std::cos(theta) * r, std::sin(theta) * r, r, rcp_pdf);
+}
+
+struct subsurface_scattering_disney_blur_result
+{
+	float3 radiance;
+	// The standard error of the luminance of the "radiance", estimated from the samples themselves (see "Shaders/subsurface_scattering_disney_blur.hlsli" for details)
+	float standard_error;
+	int sample_count;
+	// The samples rejected by the subsurface mask or the profile index, and those of them which were rejected only after the fetch of the full resolution (namely, NOT decided by the mask pyramid)
+	int rejected_sample_count;
+	int wasted_sample_count;
+};
+
+// The estimator is split into the "subsurface_scattering_disney_blur_begin", the "subsurface_scattering_disney_blur_generate" and the "subsurface_scattering_disney_blur_accumulate" of each sample and the "subsurface_scattering_disney_blur_end", s.t. the samples of a block of pixels can be interleaved (see the coherent sampling of the "SSSBlurCPU").
+// NOTE: the samples of each pixel must be accumulated in the order of the "sample_index", s.t. the result is the same as the "subsurface_scattering_disney_blur_estimate_interior"
+struct subsurface_scattering_disney_blur_state
+{
+	float2 center_uv;
+	int mis_mode;
+	float mms_per_unit;
+	float center_view_space_position_z;
+	float2 uv_per_mm;
+	float2 pixels_per_mm;
+	float3 S;
+	int profile_index;
+	float sample_edge_free_radius_in_pixels;
+	float strategy_d[3];
+	float strategy_center_sample_cdf[3];
+	int strategy_sample_count[3];
+	int sample_count;
+	float3 strategy_pdf_scale;
+	float2 sample_rotation;
+
+	float3 sum_numerator;
+	float3 sum_denominator;
+
+	// The second moments of the ratio estimator (only used by the "standard_error")
+	float3 sum_numerator_squared;
+	float3 sum_numerator_denominator;
+	float3 sum_denominator_squared;
+
+	int rejected_sample_count;
+	int wasted_sample_count;
+};
+
+struct subsurface_scattering_disney_blur_sample
+{
+	int strategy;
+	// (offset_in_mm.x, offset_in_mm.y, r, rcp_pdf)
+	float4 kernel_sample;
+	float2 sample_offset_in_mm;
+	float2 sample_uv;
+};
+
+// NOTE: the "MAX_SAMPLE_BUDGET" is only raised by the reference of the convergence benchmark (see "SSSBenchmark.h")
+// The "edge_free_radius_in_pixels" is the radius (around the center) within which all pixels are known to belong to the profile of the center (see "subsurface_scattering_tile_classification.h"), s.t. the samples within it skip the subsurface mask and the profile index.
+// Returns false if the center is NOT covered by the subsurface scattering, in which case the "result" is final and the "state" is NOT used.
+template <int MAX_SAMPLE_BUDGET = SSS_MAX_SAMPLE_BUDGET, typename SSS_SOURCE>
+inline bool subsurface_scattering_disney_blur_begin(const SSS_SOURCE& source, const float3 scattering_distance, const float filter_radius, const float world_scale, const int pixels_per_sample, const int sample_budget, const int mis_mode, const float edge_free_radius_in_pixels, const float2 center_uv, subsurface_scattering_disney_blur_state& state, subsurface_scattering_disney_blur_result& result)
+{
+	const float dist_scale = source.subsurface_mask(center_uv);
+	// Early Out
+	if (dist_scale < (1.0f / 255.0f))
+	{
+		float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor = source.total_diffuse_reflectance_pre_scatter_multiply_form_factor(center_uv);
+
+		float3 total_diffuse_reflectance_post_scatter = source.total_diffuse_reflectance_post_scatter(center_uv);
+
+		result.radiance = total_diffuse_reflectance_post_scatter * total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+		result.standard_error = 0.0f;
+		result.sample_count = 0;
+		result.rejected_sample_count = 0;
+		result.wasted_sample_count = 0;
+		return false;
+	}
+
+	state.center_uv = center_uv;
+
+	// UE4
+	const float meters_per_unit = world_scale;
+	state.center_view_space_position_z = source.view_space_position_z(center_uv);
+	state.mms_per_unit = 1000.0f * meters_per_unit * (1.0f / dist_scale);
+	state.uv_per_mm = 0.5f * float2(source.projection_x(), source.projection_y()) * (1.0f / state.center_view_space_position_z) * (1.0f / state.mms_per_unit);
+	state.pixels_per_mm = source.pixels_per_uv() * state.uv_per_mm;
+	const float2 pixels_per_mm = state.pixels_per_mm;
+
+	// Unity3D <=> UE4
+	// ScatteringDistance = MeanFreePathColor * MeanFreePathDistance / GetScalingFactor(SurfaceAlbedo)
+	state.S = float3(1.0f, 1.0f, 1.0f) / scattering_distance;
+	const float d = std::max(std::max(scattering_distance.x, scattering_distance.y), scattering_distance.z);
+
+	// Center Sample Reweighting
+	// See "Shaders/subsurface_scattering_disney_blur.hlsli" for details.
+	const float center_sample_radius_in_mm = 0.5f * (1.0f / pixels_per_mm.x + 1.0f / pixels_per_mm.y);
+	// NOTE: the kernel cache quantizes the "center_sample_cdf"
+	const float center_sample_cdf = source.center_sample_cdf(diffusion_profile_evaluate_cdf(d, center_sample_radius_in_mm));
+
+	state.profile_index = source.subsurface_profile_index(center_uv);
+
+	// The mask pyramid may prove that the whole filter belongs to the profile of the center (see "subsurface_scattering_mask_pyramid.h")
+	state.sample_edge_free_radius_in_pixels = std::max(edge_free_radius_in_pixels, subsurface_scattering_mask_pyramid_edge_free_radius(source, center_uv, state.profile_index, filter_radius * std::max(pixels_per_mm.x, pixels_per_mm.y)));
+
+	// The radius of the kernel is defined by the value of the CDF which corresponds to 99.7% of the energy of the filter.
+	// NOTE: the "filter_radius" (of the widest channel) is precomputed per profile (see "SSSProfileTable.h"), and the radius of each channel is proportional to the scattering distance
+	const float rcp_pixels_per_sample = 1.0f / float(std::max(pixels_per_sample, int(SSS_MIN_PIXELS_PER_SAMPLE)));
+	const int max_sample_count = std::min(sample_budget, MAX_SAMPLE_BUDGET);
+
+	// Multiple Importance Sampling
+	// The samples [0, N0) are drawn from the profile of which the scattering distance is "strategy_d[0]", the samples [N0, N0 + N1) from "strategy_d[1]" and the rest from "strategy_d[2]".
+	// Without MIS, all samples are drawn from the widest channel.
+	float* const strategy_d = state.strategy_d;
+	float* const strategy_center_sample_cdf = state.strategy_center_sample_cdf;
+	int* const strategy_sample_count = state.strategy_sample_count;
+	// NOTE: clamp before the conversion to "int" since the behavior of the out-of-range conversion is undefined in C++
+	const float sample_count_unclamped = float(PI) * (filter_radius * pixels_per_mm.x) * (filter_radius * pixels_per_mm.y) * rcp_pixels_per_sample;
+	state.mis_mode = (int(std::min(sample_count_unclamped, float(max_sample_count))) >= SSS_MIS_MIN_SAMPLE_COUNT) ? mis_mode : SSS_MIS_MODE_NONE;
+	if (SSS_MIS_MODE_NONE == state.mis_mode)
+	{
+		strategy_d[0] = strategy_d[1] = strategy_d[2] = d;
+		strategy_center_sample_cdf[0] = strategy_center_sample_cdf[1] = strategy_center_sample_cdf[2] = center_sample_cdf;
+		strategy_sample_count[0] = int(std::min(sample_count_unclamped, float(max_sample_count)));
+		strategy_sample_count[1] = strategy_sample_count[2] = 0;
+	}
+	else
+	{
+		const float channel_scattering_distance[3] = { scattering_distance.x, scattering_distance.y, scattering_distance.z };
+
+		float strategy_sample_count_unclamped[3];
+		float sum_sample_count_unclamped = 0.0f;
+		for (int strategy = 0; strategy < 3; ++strategy)
+		{
+			strategy_d[strategy] = channel_scattering_distance[strategy];
+			strategy_center_sample_cdf[strategy] = source.center_sample_cdf(diffusion_profile_evaluate_cdf(strategy_d[strategy], center_sample_radius_in_mm));
+
+			const float channel_filter_radius = filter_radius * (strategy_d[strategy] / d);
+			strategy_sample_count_unclamped[strategy] = float(PI) * (channel_filter_radius * pixels_per_mm.x) * (channel_filter_radius * pixels_per_mm.y) * rcp_pixels_per_sample;
+			sum_sample_count_unclamped += strategy_sample_count_unclamped[strategy];
+		}
+
+		// The budget is split in proportion to the area of the filter of each channel
+		const float budget_scale = std::min(1.0f, float(max_sample_count) / std::max(sum_sample_count_unclamped, FLT_MIN));
+		for (int strategy = 0; strategy < 3; ++strategy)
+		{
+			strategy_sample_count[strategy] = int(std::min(strategy_sample_count_unclamped[strategy] * budget_scale, float(max_sample_count)));
+		}
+	}
+
+	state.sample_count = strategy_sample_count[0] + strategy_sample_count[1] + strategy_sample_count[2];
+
+	// The density of each strategy is truncated by the center sample (the samples are only drawn beyond the center sample radius): N_k * pdf_k(r) / (1 - center_sample_cdf_k)
+	state.strategy_pdf_scale = float3(
+		float(strategy_sample_count[0]) / std::max(1.0f - strategy_center_sample_cdf[0], FLT_MIN),
+		float(strategy_sample_count[1]) / std::max(1.0f - strategy_center_sample_cdf[1], FLT_MIN),
+		float(strategy_sample_count[2]) / std::max(1.0f - strategy_center_sample_cdf[2], FLT_MIN));
+
+	state.sample_rotation = source.sample_rotation();
+
+	state.sum_numerator = float3(0.0f, 0.0f, 0.0f);
+	state.sum_denominator = float3(0.0f, 0.0f, 0.0f);
+	state.sum_numerator_squared = float3(0.0f, 0.0f, 0.0f);
+	state.sum_numerator_denominator = float3(0.0f, 0.0f, 0.0f);
+	state.sum_denominator_squared = float3(0.0f, 0.0f, 0.0f);
+
+	state.rejected_sample_count = 0;
+	state.wasted_sample_count = 0;
+	return true;
+}
+
+// The position of the sample, s.t. the fetches of a block of pixels can be sorted before the "subsurface_scattering_disney_blur_accumulate"
+template <typename SSS_SOURCE>
+inline subsurface_scattering_disney_blur_sample subsurface_scattering_disney_blur_generate(const SSS_SOURCE& source, const subsurface_scattering_disney_blur_state& state, const int sample_index)
+{
+	subsurface_scattering_disney_blur_sample sample;
+
+	const int* const strategy_sample_count = state.strategy_sample_count;
+	const int strategy = (sample_index < strategy_sample_count[0]) ? 0 : ((sample_index < (strategy_sample_count[0] + strategy_sample_count[1])) ? 1 : 2);
+	const int strategy_sample_offset = (0 == strategy) ? 0 : ((1 == strategy) ? strategy_sample_count[0] : (strategy_sample_count[0] + strategy_sample_count[1]));
+	sample.strategy = strategy;
+
+	// (offset_in_mm.x, offset_in_mm.y, r, rcp_pdf)
+	const float4 kernel_sample = source.kernel_sample(state.strategy_d[strategy], state.strategy_center_sample_cdf[strategy], strategy_sample_count[strategy], sample_index - strategy_sample_offset);
+	sample.kernel_sample = kernel_sample;
+
+	// Bilateral Filter
+	const float2 sample_rotation = state.sample_rotation;
+	sample.sample_offset_in_mm = float2(kernel_sample.x * sample_rotation.x - kernel_sample.y * sample_rotation.y, kernel_sample.x * sample_rotation.y + kernel_sample.y * sample_rotation.x);
+	sample.sample_uv = state.center_uv + state.uv_per_mm * sample.sample_offset_in_mm;
+	return sample;
+}
+
+template <typename SSS_SOURCE>
+inline void subsurface_scattering_disney_blur_accumulate(const SSS_SOURCE& source, subsurface_scattering_disney_blur_state& state, const subsurface_scattering_disney_blur_sample& sample)
+{
+	const int strategy = sample.strategy;
+	const float r = sample.kernel_sample.z;
+	const float rcp_pdf = sample.kernel_sample.w;
+	const float2 sample_uv = sample.sample_uv;
+	const float2 pixels_per_mm = state.pixels_per_mm;
+	const float3 strategy_pdf_scale = state.strategy_pdf_scale;
+	const int mis_mode = state.mis_mode;
+
+	// The samples which belong to another profile are rejected
+	// NOTE: the samples within the "sample_edge_free_radius_in_pixels" are known to belong to the profile of the center
+	bool sample_accepted = true;
+	if (length(sample.sample_offset_in_mm * pixels_per_mm) >= state.sample_edge_free_radius_in_pixels)
+	{
+		// Only the samples which are NOT decided by the mask pyramid fetch the full resolution
+		const int mask_pyramid_sample_test = subsurface_scattering_mask_pyramid_sample_test(source, sample_uv, state.profile_index);
+		if (SSS_MASK_PYRAMID_SAMPLE_UNKNOWN == mask_pyramid_sample_test)
+		{
+			// The "sample_form_factor" may be zero even if the "sample_dist_scale" is NOT zero
+			float sample_dist_scale = source.subsurface_mask(sample_uv);
+			sample_accepted = (sample_dist_scale >= (1.0f / 255.0f)) && (source.subsurface_profile_index(sample_uv) == state.profile_index);
+			state.wasted_sample_count += sample_accepted ? 0 : 1;
+		}
+		else
+		{
+			sample_accepted = (SSS_MASK_PYRAMID_SAMPLE_ACCEPTED == mask_pyramid_sample_test);
+		}
+		state.rejected_sample_count += sample_accepted ? 0 : 1;
+	}
+
+	if (sample_accepted)
+	{
+		// Without MIS, the weight is the "rcp_pdf". Otherwise, the weight is the MIS weight divided by the density of the strategy:
+		// balance: 1 / Sum{N_k * pdf_k}
+		// power: (N_j * pdf_j) / Sum{(N_k * pdf_k)^2}
+		// The footprint (in mm^2) is the share of the disk covered by the sample, namely, the reciprocal of the density of all samples (per mm^2): r / Sum{N_k * pdf_k}
+		float sample_weight = rcp_pdf;
+		float sample_footprint_in_mm2 = r * rcp_pdf / std::max(strategy_pdf_scale.x, FLT_MIN);
+		if (SSS_MIS_MODE_NONE != mis_mode)
+		{
+			// NOTE: the densities of the three strategies are evaluated at once, since the scattering distance of each strategy is the scattering distance of the channel
+			float3 strategy_pdf = diffusion_profile_evaluate_pdf(state.S, r) * strategy_pdf_scale;
+			float current_strategy_pdf = (0 == strategy) ? strategy_pdf.x : ((1 == strategy) ? strategy_pdf.y : strategy_pdf.z);
+			sample_weight = (SSS_MIS_MODE_BALANCE == mis_mode) ? (1.0f / std::max(strategy_pdf.x + strategy_pdf.y + strategy_pdf.z, FLT_MIN)) : (current_strategy_pdf / std::max(dot(strategy_pdf, strategy_pdf), FLT_MIN));
+			sample_footprint_in_mm2 = r / std::max(strategy_pdf.x + strategy_pdf.y + strategy_pdf.z, FLT_MIN);
+		}
+
+		// Mipmapped Irradiance
+		// The level of the irradiance pyramid matches the footprint of the sample (the full resolution if the pyramid is disabled)
+		const subsurface_scattering_irradiance_pyramid_sample_result sample_irradiance = subsurface_scattering_irradiance_pyramid_sample(source, sample_uv, state.profile_index, sample_footprint_in_mm2 * pixels_per_mm.x * pixels_per_mm.y);
+		float3 sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor = sample_irradiance.total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+
+		// Bilateral Filter
+		float sample_view_space_position_z = sample_irradiance.view_space_position_z;
+		float relative_position_z_mm = state.mms_per_unit * (sample_view_space_position_z - state.center_view_space_position_z);
+		float r_bilateral_weight = std::sqrt(r * r + relative_position_z_mm * relative_position_z_mm);
+
+		float3 pdf = diffusion_profile_evaluate_pdf(state.S, r_bilateral_weight);
+
+		// (1.0 / float(N)) * total_diffuse_reflectance_post_scatter * pdf * (total_diffuse_reflectance_pre_scatter * form_factor) * rcp_pdf
+		float3 sample_numerator = pdf * sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor * sample_weight;
+
+		// (1.0 / float(N)) * pdf * rcp_pdf
+		float3 sample_denominator = pdf * sample_weight;
+
+		state.sum_numerator += sample_numerator;
+
+		state.sum_denominator += sample_denominator;
+
+		state.sum_numerator_squared += sample_numerator * sample_numerator;
+		state.sum_numerator_denominator += sample_numerator * sample_denominator;
+		state.sum_denominator_squared += sample_denominator * sample_denominator;
+	}
+}
+
+template <typename SSS_SOURCE>
+inline subsurface_scattering_disney_blur_result subsurface_scattering_disney_blur_end(const SSS_SOURCE& source, const subsurface_scattering_disney_blur_state& state)
+{
+	subsurface_scattering_disney_blur_result result;
+
+	const float2 center_uv = state.center_uv;
+	const float* const strategy_center_sample_cdf = state.strategy_center_sample_cdf;
+	const int sample_count = state.sample_count;
+
+	// Center Sample Reweighting
+	// NOTE: with MIS, the center sample weight of each channel is the CDF of the profile of the channel
+	float3 sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor = state.sum_numerator / max(state.sum_denominator, float3(FLT_MIN, FLT_MIN, FLT_MIN));
+	float3 center_total_diffuse_reflectance_pre_scatter_multiply_form_factor = source.total_diffuse_reflectance_pre_scatter_multiply_form_factor(center_uv);
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor = lerp(sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor, center_total_diffuse_reflectance_pre_scatter_multiply_form_factor, float3(strategy_center_sample_cdf[0], strategy_center_sample_cdf[1], strategy_center_sample_cdf[2]));
+
+	float3 total_diffuse_reflectance_post_scatter = source.total_diffuse_reflectance_post_scatter(center_uv);
+
+	result.radiance = total_diffuse_reflectance_post_scatter * total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+
+	// Var[N / D] = (n / (n - 1)) * Sum{(N_i - (N / D) * D_i)^2} / D^2
+	if (sample_count > 1)
+	{
+		const float3 ratio = sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+		const float3 sum_squared_residual = max(state.sum_numerator_squared - 2.0f * ratio * state.sum_numerator_denominator + ratio * ratio * state.sum_denominator_squared, float3(0.0f, 0.0f, 0.0f));
+		const float3 ratio_variance = (float(sample_count) / float(sample_count - 1)) * sum_squared_residual / max(state.sum_denominator * state.sum_denominator, float3(FLT_MIN, FLT_MIN, FLT_MIN));
+		const float3 one_minus_center_sample_cdf(1.0f - strategy_center_sample_cdf[0], 1.0f - strategy_center_sample_cdf[1], 1.0f - strategy_center_sample_cdf[2]);
+		const float3 radiance_standard_error = total_diffuse_reflectance_post_scatter * one_minus_center_sample_cdf * sqrt(ratio_variance);
+		result.standard_error = dot(radiance_standard_error, float3(0.2126f, 0.7152f, 0.0722f));
+	}
+	else
+	{
+		result.standard_error = 0.0f;
+	}
+	result.sample_count = sample_count;
+	result.rejected_sample_count = state.rejected_sample_count;
+	result.wasted_sample_count = state.wasted_sample_count;
+	return result;
+}
+
+template <int MAX_SAMPLE_BUDGET = SSS_MAX_SAMPLE_BUDGET, typename SSS_SOURCE>
+inline subsurface_scattering_disney_blur_result subsurface_scattering_disney_blur_estimate_interior(const SSS_SOURCE& source, const float3 scattering_distance, const float filter_radius, const float world_scale, const int pixels_per_sample, const int sample_budget, const int mis_mode, const float edge_free_radius_in_pixels, const float2 center_uv)
+{
+	subsurface_scattering_disney_blur_result result;
+
+	subsurface_scattering_disney_blur_state state;
+	if (!subsurface_scattering_disney_blur_begin<MAX_SAMPLE_BUDGET>(source, scattering_distance, filter_radius, world_scale, pixels_per_sample, sample_budget, mis_mode, edge_free_radius_in_pixels, center_uv, state, result))
+	{
+		return result;
+	}
+
+	for (int sample_index = 0; sample_index < MAX_SAMPLE_BUDGET && sample_index < state.sample_count; ++sample_index)
+	{
+		subsurface_scattering_disney_blur_accumulate(source, state, subsurface_scattering_disney_blur_generate(source, state, sample_index));
+	}
+
+	return subsurface_scattering_disney_blur_end(source, state);
+}
+
+template <int MAX_SAMPLE_BUDGET = SSS_MAX_SAMPLE_BUDGET, typename SSS_SOURCE>
+inline subsurface_scattering_disney_blur_result subsurface_scattering_disney_blur_estimate(const SSS_SOURCE& source, const float3 scattering_distance, const float filter_radius, const float world_scale, const int pixels_per_sample, const int sample_budget, const int mis_mode, const float2 center_uv)
+{
+	return subsurface_scattering_disney_blur_estimate_interior<MAX_SAMPLE_BUDGET>(source, scattering_distance, filter_radius, world_scale, pixels_per_sample, sample_budget, mis_mode, 0.0f, center_uv);
+}
+
+template <int MAX_SAMPLE_BUDGET = SSS_MAX_SAMPLE_BUDGET, typename SSS_SOURCE>
+inline float3 subsurface_scattering_disney_blur(const SSS_SOURCE& source, const float3 scattering_distance, const float filter_radius, const float world_scale, const int pixels_per_sample, const int sample_budget, const int mis_mode, const float2 center_uv)
+{
+	return subsurface_scattering_disney_blur_estimate<MAX_SAMPLE_BUDGET>(source, scattering_distance, filter_radius, world_scale, pixels_per_sample, sample_budget, mis_mode, center_uv).radiance;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+//    IMPLEMENTATION
+//
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+inline float diffusion_profile_sample_r(float d, float cdf)
+{
+	float u = 1.0f - cdf; // Convert CDF to CCDF
+
+	float g = 1.0f + (4.0f * u) * (2.0f * u + std::sqrt(1.0f + (4.0f * u) * u));
+
+	// g^(-1/3)
+	float n = std::exp2(std::log2(g) * float(-1.0 / 3.0));
+	// g^(+1/3)
+	float p = (g * n) * n;
+	// 1 + g^(+1/3) + g^(-1/3)
+	float c = 1.0f + p + n;
+	// 3 * Log[4 * u]
+	float b = float(3.0 / LOG2_E * 2.0) + float(3.0 / LOG2_E) * std::log2(u);
+	// 3 * Log[c / (4 * u)]
+	float x = float(3.0 / LOG2_E) * std::log2(c) - b;
+
+	// x = S * r
+	// r = x * rcpS = x * d
+	float r = x * d;
+	return r;
+}
+
+inline float diffusion_profile_evaluate_cdf(float d, float r)
+{
+	// x = S * r = (1.0 / d) * r
+	// exp_13 = Exp[-x/3]
+	float exp_13 = std::exp2((float(LOG2_E * (-1.0 / 3.0)) * r) * (1.0f / d));
+	// exp_1  = Exp[-x] = exp_13 * exp_13 * exp_13
+	// exp_sum = -0.25 * exp_1 - 0.75 * exp_13 =  exp_13 * (-0.75 - 0.25 * exp_13 * exp_13)
+	float exp_sum = exp_13 * (-0.75f - 0.25f * exp_13 * exp_13);
+	// 1 - 0.75 * Exp[-S * r / 3]  - 0.25 * Exp[-S * r])
+	float cdf = 1.0f + exp_sum;
+	return cdf;
+}
+
+inline float diffusion_profile_evaluate_rcp_pdf(float d, float r)
+{
+	// x = S * r = (1.0 / d) * r
+	// exp_13 = Exp[-x/3]
+	float exp_13 = std::exp2((float(LOG2_E * (-1.0 / 3.0)) * r) * (1.0f / d));
+	// exp_1  = Exp[-x] = exp_13 * exp_13 * exp_13
+	// exp_sum = exp_1 + exp_13 =  exp_13 * (1 + exp_13 * exp_13)
+	float exp_sum = exp_13 * (1.0f + exp_13 * exp_13);
+	// rcpExp = (1.0 / exp_sum)
+	float rcpExp = (1.0f / exp_sum);
+
+	// rcpS = d
+	// (8 * PI) / S / (Exp[-S * r / 3] + Exp[-S * r])
+	float rcp_pdf = float(8.0 * PI) * d * rcpExp;
+	return rcp_pdf;
+}
+
+inline float3 diffusion_profile_evaluate_pdf(float3 S, float r)
+{
+	// Exp[-s * r / 3]
+	float3 exp_13 = exp2((float(LOG2_E * (-1.0 / 3.0)) * r) * S);
+	// Exp[-s * r / 3] + Exp[-S * r]
+	float3 exp_sum = exp_13 * (float3(1.0f) + exp_13 * exp_13);
+	// S / (8 * PI) * (Exp[-S * r / 3] + Exp[-S * r])
+	float3 pdf = S / float(8.0 * PI) * exp_sum;
+	return pdf;
+}
+
+#endif
@@ -0,0 +1,206 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_DISNEY_BLUR_BUCKET_H_
+#define _SUBSURFACE_SCATTERING_DISNEY_BLUR_BUCKET_H_ 1
+
+#include "subsurface_scattering_disney_blur.h"
+#include "diffusion_profile_simd.h"
+
+// The specializations of the "subsurface_scattering_disney_blur_estimate_interior" (without the MIS) of which the sample count is a compile-time constant (no HLSL counterpart).
+// The "sample_count" of each tile is rounded to the nearest bucket which is NOT larger than the budget of any pixel of the tile (see "SSSBlurCPU.h"), and the loops of the bucket are split into:
+// 1. the fetches of all samples (the subsurface mask, the profile index and the irradiance of the rejected samples are NOT accumulated, namely, the weight is zero)
+// 2. the profile of all samples at once (see the "diffusion_profile_evaluate_pdf_batch" of the "diffusion_profile_simd.h")
+// 3. the sums of all samples (no branch)
+// NOTE: the result is NOT the same as the "subsurface_scattering_disney_blur_estimate_interior", since the sample count is rounded and the profile is evaluated by the approximations of the "diffusion_profile_simd.h".
+
+#define SSS_SAMPLE_COUNT_BUCKET_COUNT 5
+#define SSS_SAMPLE_COUNT_BUCKET_SIZE_0 8
+#define SSS_SAMPLE_COUNT_BUCKET_SIZE_1 16
+#define SSS_SAMPLE_COUNT_BUCKET_SIZE_2 32
+#define SSS_SAMPLE_COUNT_BUCKET_SIZE_3 64
+#define SSS_SAMPLE_COUNT_BUCKET_SIZE_4 SSS_MAX_SAMPLE_BUDGET
+
+inline int subsurface_scattering_sample_count_bucket_size(int bucket)
+{
+	static const int bucket_sizes[SSS_SAMPLE_COUNT_BUCKET_COUNT] = { SSS_SAMPLE_COUNT_BUCKET_SIZE_0, SSS_SAMPLE_COUNT_BUCKET_SIZE_1, SSS_SAMPLE_COUNT_BUCKET_SIZE_2, SSS_SAMPLE_COUNT_BUCKET_SIZE_3, SSS_SAMPLE_COUNT_BUCKET_SIZE_4 };
+	return bucket_sizes[bucket];
+}
+
+// The bucket of which the size is the nearest to the "sample_count" (the smaller bucket if tied) among the buckets which are NOT larger than the "max_sample_count" (the minimum budget of the pixels), or -1 if the "sample_count" is NOT positive or no bucket fits the "max_sample_count"
+inline int subsurface_scattering_sample_count_bucket(float sample_count, int max_sample_count)
+{
+	// NOTE: the NaN is mapped to -1
+	if (!(sample_count > 0.0f) || (subsurface_scattering_sample_count_bucket_size(0) > max_sample_count))
+	{
+		return -1;
+	}
+
+	int bucket = 0;
+	for (int candidate = 1; (candidate < SSS_SAMPLE_COUNT_BUCKET_COUNT) && (subsurface_scattering_sample_count_bucket_size(candidate) <= max_sample_count); ++candidate)
+	{
+		if (std::abs(float(subsurface_scattering_sample_count_bucket_size(candidate)) - sample_count) < std::abs(float(subsurface_scattering_sample_count_bucket_size(bucket)) - sample_count))
+		{
+			bucket = candidate;
+		}
+	}
+	return bucket;
+}
+
+template <int SAMPLE_COUNT, typename SSS_SOURCE>
+inline subsurface_scattering_disney_blur_result subsurface_scattering_disney_blur_estimate_bucket(const SSS_SOURCE& source, const float3 scattering_distance, const float filter_radius, const float world_scale, const float edge_free_radius_in_pixels, const float2 center_uv)
+{
+	subsurface_scattering_disney_blur_result result;
+
+	const float dist_scale = source.subsurface_mask(center_uv);
+	// Early Out
+	if (dist_scale < (1.0f / 255.0f))
+	{
+		result.radiance = source.total_diffuse_reflectance_post_scatter(center_uv) * source.total_diffuse_reflectance_pre_scatter_multiply_form_factor(center_uv);
+		result.standard_error = 0.0f;
+		result.sample_count = 0;
+		result.rejected_sample_count = 0;
+		result.wasted_sample_count = 0;
+		return result;
+	}
+
+	// The same as the "subsurface_scattering_disney_blur_begin" without the MIS
+	const float meters_per_unit = world_scale;
+	const float center_view_space_position_z = source.view_space_position_z(center_uv);
+	const float mms_per_unit = 1000.0f * meters_per_unit * (1.0f / dist_scale);
+	const float2 uv_per_mm = 0.5f * float2(source.projection_x(), source.projection_y()) * (1.0f / center_view_space_position_z) * (1.0f / mms_per_unit);
+	const float2 pixels_per_mm = source.pixels_per_uv() * uv_per_mm;
+
+	const float3 S = float3(1.0f, 1.0f, 1.0f) / scattering_distance;
+	const float d = std::max(std::max(scattering_distance.x, scattering_distance.y), scattering_distance.z);
+
+	const float center_sample_radius_in_mm = 0.5f * (1.0f / pixels_per_mm.x + 1.0f / pixels_per_mm.y);
+	const float center_sample_cdf = source.center_sample_cdf(diffusion_profile_evaluate_cdf(d, center_sample_radius_in_mm));
+
+	const int profile_index = source.subsurface_profile_index(center_uv);
+
+	const float sample_edge_free_radius_in_pixels = std::max(edge_free_radius_in_pixels, subsurface_scattering_mask_pyramid_edge_free_radius(source, center_uv, profile_index, filter_radius * std::max(pixels_per_mm.x, pixels_per_mm.y)));
+
+	const float strategy_pdf_scale = float(SAMPLE_COUNT) / std::max(1.0f - center_sample_cdf, FLT_MIN);
+
+	const float2 sample_rotation = source.sample_rotation();
+
+	// 1. Fetches
+	float sample_r_bilateral_weight[SAMPLE_COUNT];
+	float sample_weight[SAMPLE_COUNT];
+	float sample_irradiance_r[SAMPLE_COUNT];
+	float sample_irradiance_g[SAMPLE_COUNT];
+	float sample_irradiance_b[SAMPLE_COUNT];
+
+	int rejected_sample_count = 0;
+	int wasted_sample_count = 0;
+
+	for (int sample_index = 0; sample_index < SAMPLE_COUNT; ++sample_index)
+	{
+		// (offset_in_mm.x, offset_in_mm.y, r, rcp_pdf)
+		const float4 kernel_sample = source.kernel_sample(d, center_sample_cdf, SAMPLE_COUNT, sample_index);
+		const float r = kernel_sample.z;
+		const float rcp_pdf = kernel_sample.w;
+
+		const float2 sample_offset_in_mm(kernel_sample.x * sample_rotation.x - kernel_sample.y * sample_rotation.y, kernel_sample.x * sample_rotation.y + kernel_sample.y * sample_rotation.x);
+		const float2 sample_uv = center_uv + uv_per_mm * sample_offset_in_mm;
+
+		bool sample_accepted = true;
+		if (length(sample_offset_in_mm * pixels_per_mm) >= sample_edge_free_radius_in_pixels)
+		{
+			const int mask_pyramid_sample_test = subsurface_scattering_mask_pyramid_sample_test(source, sample_uv, profile_index);
+			if (SSS_MASK_PYRAMID_SAMPLE_UNKNOWN == mask_pyramid_sample_test)
+			{
+				const float sample_dist_scale = source.subsurface_mask(sample_uv);
+				sample_accepted = (sample_dist_scale >= (1.0f / 255.0f)) && (source.subsurface_profile_index(sample_uv) == profile_index);
+				wasted_sample_count += sample_accepted ? 0 : 1;
+			}
+			else
+			{
+				sample_accepted = (SSS_MASK_PYRAMID_SAMPLE_ACCEPTED == mask_pyramid_sample_test);
+			}
+			rejected_sample_count += sample_accepted ? 0 : 1;
+		}
+
+		if (sample_accepted)
+		{
+			const float sample_footprint_in_mm2 = r * rcp_pdf / std::max(strategy_pdf_scale, FLT_MIN);
+			const subsurface_scattering_irradiance_pyramid_sample_result sample_irradiance = subsurface_scattering_irradiance_pyramid_sample(source, sample_uv, profile_index, sample_footprint_in_mm2 * pixels_per_mm.x * pixels_per_mm.y);
+
+			const float relative_position_z_mm = mms_per_unit * (sample_irradiance.view_space_position_z - center_view_space_position_z);
+			sample_r_bilateral_weight[sample_index] = std::sqrt(r * r + relative_position_z_mm * relative_position_z_mm);
+			sample_weight[sample_index] = rcp_pdf;
+			sample_irradiance_r[sample_index] = sample_irradiance.total_diffuse_reflectance_pre_scatter_multiply_form_factor.x;
+			sample_irradiance_g[sample_index] = sample_irradiance.total_diffuse_reflectance_pre_scatter_multiply_form_factor.y;
+			sample_irradiance_b[sample_index] = sample_irradiance.total_diffuse_reflectance_pre_scatter_multiply_form_factor.z;
+		}
+		else
+		{
+			sample_r_bilateral_weight[sample_index] = 0.0f;
+			sample_weight[sample_index] = 0.0f;
+			sample_irradiance_r[sample_index] = 0.0f;
+			sample_irradiance_g[sample_index] = 0.0f;
+			sample_irradiance_b[sample_index] = 0.0f;
+		}
+	}
+
+	// 2. Profile
+	float sample_pdf_r[SAMPLE_COUNT];
+	float sample_pdf_g[SAMPLE_COUNT];
+	float sample_pdf_b[SAMPLE_COUNT];
+	diffusion_profile_evaluate_pdf_batch(S, sample_r_bilateral_weight, sample_pdf_r, sample_pdf_g, sample_pdf_b, SAMPLE_COUNT);
+
+	// 3. Sums
+	float3 sum_numerator(0.0f, 0.0f, 0.0f);
+	float3 sum_denominator(0.0f, 0.0f, 0.0f);
+	float3 sum_numerator_squared(0.0f, 0.0f, 0.0f);
+	float3 sum_numerator_denominator(0.0f, 0.0f, 0.0f);
+	float3 sum_denominator_squared(0.0f, 0.0f, 0.0f);
+	for (int sample_index = 0; sample_index < SAMPLE_COUNT; ++sample_index)
+	{
+		const float3 pdf(sample_pdf_r[sample_index], sample_pdf_g[sample_index], sample_pdf_b[sample_index]);
+		const float3 sample_numerator = pdf * float3(sample_irradiance_r[sample_index], sample_irradiance_g[sample_index], sample_irradiance_b[sample_index]) * sample_weight[sample_index];
+		const float3 sample_denominator = pdf * sample_weight[sample_index];
+
+		sum_numerator += sample_numerator;
+		sum_denominator += sample_denominator;
+		sum_numerator_squared += sample_numerator * sample_numerator;
+		sum_numerator_denominator += sample_numerator * sample_denominator;
+		sum_denominator_squared += sample_denominator * sample_denominator;
+	}
+
+	// The same as the "subsurface_scattering_disney_blur_end"
+	const float3 sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor = sum_numerator / max(sum_denominator, float3(FLT_MIN, FLT_MIN, FLT_MIN));
+	const float3 center_total_diffuse_reflectance_pre_scatter_multiply_form_factor = source.total_diffuse_reflectance_pre_scatter_multiply_form_factor(center_uv);
+	const float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor = lerp(sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor, center_total_diffuse_reflectance_pre_scatter_multiply_form_factor, float3(center_sample_cdf, center_sample_cdf, center_sample_cdf));
+
+	const float3 total_diffuse_reflectance_post_scatter = source.total_diffuse_reflectance_post_scatter(center_uv);
+
+	result.radiance = total_diffuse_reflectance_post_scatter * total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+
+	const float3 ratio = sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	const float3 sum_squared_residual = max(sum_numerator_squared - 2.0f * ratio * sum_numerator_denominator + ratio * ratio * sum_denominator_squared, float3(0.0f, 0.0f, 0.0f));
+	const float3 ratio_variance = (float(SAMPLE_COUNT) / float(SAMPLE_COUNT - 1)) * sum_squared_residual / max(sum_denominator * sum_denominator, float3(FLT_MIN, FLT_MIN, FLT_MIN));
+	const float3 radiance_standard_error = total_diffuse_reflectance_post_scatter * (1.0f - center_sample_cdf) * sqrt(ratio_variance);
+	result.standard_error = dot(radiance_standard_error, float3(0.2126f, 0.7152f, 0.0722f));
+	result.sample_count = SAMPLE_COUNT;
+	result.rejected_sample_count = rejected_sample_count;
+	result.wasted_sample_count = wasted_sample_count;
+	return result;
+}
+
+#endif
@@ -0,0 +1,40 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/subsurface_scattering_disney_transmittance.hlsli"
+//
+
+#ifndef _SUBSURFACE_SCATTERING_DISNEY_TRANSMITTANCE_H_
+#define _SUBSURFACE_SCATTERING_DISNEY_TRANSMITTANCE_H_ 1
+
+#include "math_consts.h"
+#include "vector_math.h"
+
+// Computes the fraction of light passing through the object.
+// Evaluate Int{0, inf}{2 * Pi * r * R(sqrt(r^2 + d^2))}, where R is the diffusion profile.
+// Ref: Approximate Reflectance Profiles for Efficient Subsurface Scattering by Pixar (BSSRDF only).
+inline float3 subsurface_scattering_disney_transmittance(float3 S, float thickness)
+{
+	// Exp[-S * t / 3]
+	float3 exp_13 = exp2((float(LOG2_E * (-1.0 / 3.0)) * thickness) * S);
+
+	// T = (1/4 * A) * (e^(-S * t) + 3 * e^(-S * t / 3))
+	// the 'A' is multiplied in the 'full screen sss blur pass'
+	return 0.25f * (exp_13 * (exp_13 * exp_13 + float3(3.0f)));
+}
+
+#endif
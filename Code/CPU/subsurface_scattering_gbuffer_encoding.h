@@ -0,0 +1,243 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/subsurface_scattering_gbuffer_encoding.hlsli"
+//
+// The HLSL version only needs the encodings which the hardware does NOT support (namely, the RGB9E5, the YCoCg and the linear depth), while the conversions of the render target formats (the R16G16B16A16_FLOAT, the R11G11B10_FLOAT, the R16G16_FLOAT and the R16_UNORM) are done by the hardware.
+// The C++ version additionally provides these conversions, s.t. the round trip of each encoding can be verified on the CPU (see "verifyGBufferEncoding" of the "SSSBenchmark.h").
+//
+
+#ifndef _SUBSURFACE_SCATTERING_GBUFFER_ENCODING_H_
+#define _SUBSURFACE_SCATTERING_GBUFFER_ENCODING_H_ 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "vector_math.h"
+
+// The encoding of the "total_diffuse_reflectance_pre_scatter_multiply_form_factor" written by the main pass and read by the blur
+// RGBA16F: DXGI_FORMAT_R16G16B16A16_FLOAT (8 bytes, the RGBA8 sRGB if the HDR is disabled)
+// R11G11B10F: DXGI_FORMAT_R11G11B10_FLOAT (4 bytes, decoded by the hardware)
+// RGB9E5: the shared exponent packed into the DXGI_FORMAT_R16G16_UNORM (4 bytes, since the DXGI_FORMAT_R9G9B9E5_SHAREDEXP can NOT be rendered)
+// YCOCG: (Y, Co) or (Y, Cg) in the checkerboard in the DXGI_FORMAT_R16G16_FLOAT (4 bytes), namely, the chroma is at the half horizontal resolution
+#define SSS_IRRADIANCE_ENCODING_RGBA16F 0
+#define SSS_IRRADIANCE_ENCODING_R11G11B10F 1
+#define SSS_IRRADIANCE_ENCODING_RGB9E5 2
+#define SSS_IRRADIANCE_ENCODING_YCOCG 3
+#define SSS_IRRADIANCE_ENCODING_COUNT 4
+
+// The encoding of the depth written by the main pass and read by the blur
+// NDC_R32F: the NDC depth (SV_POSITION.z) in the DXGI_FORMAT_R32_FLOAT (4 bytes)
+// LINEAR_R16: (view_space_position_z - near) / (far - near) in the DXGI_FORMAT_R16_UNORM (2 bytes)
+// VIEW_Z_R16F / VIEW_Z_R32F: the view space position z (SV_POSITION.w) in the DXGI_FORMAT_R16_FLOAT (2 bytes) or the DXGI_FORMAT_R32_FLOAT (4 bytes), which is consumed by the blur without any decode
+#define SSS_DEPTH_ENCODING_NDC_R32F 0
+#define SSS_DEPTH_ENCODING_LINEAR_R16 1
+#define SSS_DEPTH_ENCODING_VIEW_Z_R16F 2
+#define SSS_DEPTH_ENCODING_VIEW_Z_R32F 3
+#define SSS_DEPTH_ENCODING_COUNT 4
+
+// The bytes of one texel of the render target
+inline int subsurface_scattering_irradiance_encoding_size(int irradiance_encoding)
+{
+	return (SSS_IRRADIANCE_ENCODING_RGBA16F == irradiance_encoding) ? 8 : 4;
+}
+
+inline int subsurface_scattering_depth_encoding_size(int depth_encoding)
+{
+	return ((SSS_DEPTH_ENCODING_LINEAR_R16 == depth_encoding) || (SSS_DEPTH_ENCODING_VIEW_Z_R16F == depth_encoding)) ? 2 : 4;
+}
+
+// The unsigned float of which the exponent is 5 bits (bias 15) and the mantissa is "mantissa_bit_count" bits (the R11G11B10_FLOAT and the magnitude of the half float)
+// NOTE: rounded to the nearest even, the negative (and the NaN) is clamped to zero and the overflow is clamped to the max finite value (instead of the INF)
+inline uint32_t subsurface_scattering_small_float_encode(float value, int mantissa_bit_count)
+{
+	const uint32_t max_finite = (30U << mantissa_bit_count) | ((1U << mantissa_bit_count) - 1U);
+	if (!(value > 0.0f))
+	{
+		return 0U;
+	}
+
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(float));
+	const int exponent = int((bits >> 23) & 0xFFU) - 127;
+
+	uint32_t encoded;
+	if (exponent < -14)
+	{
+		// Denormal (the carry into the smallest normal is the same bit pattern)
+		encoded = uint32_t(std::nearbyint(std::ldexp(value, 14 + mantissa_bit_count)));
+	}
+	else if (exponent > 15)
+	{
+		encoded = max_finite;
+	}
+	else
+	{
+		const uint32_t biased = (uint32_t(exponent + 15) << 23) | (bits & 0x7FFFFFU);
+		const int shift = 23 - mantissa_bit_count;
+		const uint32_t half = 1U << (shift - 1);
+		const uint32_t remainder = biased & ((1U << shift) - 1U);
+		encoded = biased >> shift;
+		if ((remainder > half) || ((remainder == half) && (0U != (encoded & 1U))))
+		{
+			++encoded;
+		}
+	}
+	return std::min(encoded, max_finite);
+}
+
+inline float subsurface_scattering_small_float_decode(uint32_t encoded, int mantissa_bit_count)
+{
+	const int exponent = int(encoded >> mantissa_bit_count);
+	const float mantissa = float(encoded & ((1U << mantissa_bit_count) - 1U));
+	return (0 == exponent) ? std::ldexp(mantissa, -14 - mantissa_bit_count) : std::ldexp(1.0f + std::ldexp(mantissa, -mantissa_bit_count), exponent - 15);
+}
+
+inline uint16_t subsurface_scattering_half_encode(float value)
+{
+	const uint32_t sign = std::signbit(value) ? 0x8000U : 0U;
+	return uint16_t(sign | subsurface_scattering_small_float_encode(std::abs(value), 10));
+}
+
+inline float subsurface_scattering_half_decode(uint16_t encoded)
+{
+	const float magnitude = subsurface_scattering_small_float_decode(encoded & 0x7FFFU, 10);
+	return (0U != (encoded & 0x8000U)) ? -magnitude : magnitude;
+}
+
+inline uint32_t subsurface_scattering_r11g11b10f_encode(float3 rgb)
+{
+	return subsurface_scattering_small_float_encode(rgb.x, 6) | (subsurface_scattering_small_float_encode(rgb.y, 6) << 11) | (subsurface_scattering_small_float_encode(rgb.z, 5) << 22);
+}
+
+inline float3 subsurface_scattering_r11g11b10f_decode(uint32_t encoded)
+{
+	return float3(subsurface_scattering_small_float_decode(encoded & 0x7FFU, 6), subsurface_scattering_small_float_decode((encoded >> 11) & 0x7FFU, 6), subsurface_scattering_small_float_decode(encoded >> 22, 5));
+}
+
+inline uint16_t subsurface_scattering_unorm16_encode(float value)
+{
+	return uint16_t(std::floor(saturate(value) * 65535.0f + 0.5f));
+}
+
+inline float subsurface_scattering_unorm16_decode(uint16_t encoded)
+{
+	return float(encoded) * (1.0f / 65535.0f);
+}
+
+// The shared exponent (the same as the DXGI_FORMAT_R9G9B9E5_SHAREDEXP): 9 bits of each channel and 5 bits of the exponent (bias 15)
+inline uint32_t subsurface_scattering_rgb9e5_encode(float3 rgb)
+{
+	// (2^9 - 1) / 2^9 * 2^(31 - 15)
+	const float max_value = 65408.0f;
+	const float r = std::min(std::max(rgb.x, 0.0f), max_value);
+	const float g = std::min(std::max(rgb.y, 0.0f), max_value);
+	const float b = std::min(std::max(rgb.z, 0.0f), max_value);
+	const float max_channel = std::max(std::max(r, g), b);
+
+	// NOTE: the "frexp" is exact while the "log2" may NOT be
+	int max_channel_exponent = -16;
+	if (max_channel > 0.0f)
+	{
+		std::frexp(max_channel, &max_channel_exponent);
+		max_channel_exponent = std::max(max_channel_exponent - 1, -16);
+	}
+	int shared_exponent = max_channel_exponent + 16;
+	if (std::floor(std::ldexp(max_channel, 24 - shared_exponent) + 0.5f) >= 512.0f)
+	{
+		++shared_exponent;
+	}
+
+	const uint32_t r_encoded = uint32_t(std::floor(std::ldexp(r, 24 - shared_exponent) + 0.5f));
+	const uint32_t g_encoded = uint32_t(std::floor(std::ldexp(g, 24 - shared_exponent) + 0.5f));
+	const uint32_t b_encoded = uint32_t(std::floor(std::ldexp(b, 24 - shared_exponent) + 0.5f));
+	return r_encoded | (g_encoded << 9) | (b_encoded << 18) | (uint32_t(shared_exponent) << 27);
+}
+
+inline float3 subsurface_scattering_rgb9e5_decode(uint32_t encoded)
+{
+	const int shared_exponent = int(encoded >> 27);
+	return float3(std::ldexp(float(encoded & 0x1FFU), shared_exponent - 24), std::ldexp(float((encoded >> 9) & 0x1FFU), shared_exponent - 24), std::ldexp(float((encoded >> 18) & 0x1FFU), shared_exponent - 24));
+}
+
+// The 32 bits are split into the two channels of the R16G16_UNORM, which are exact since "k / 65535" is rounded back to "k" by the conversion of the UNORM
+inline float2 subsurface_scattering_rgb9e5_to_unorm16x2(uint32_t encoded)
+{
+	return float2(float(encoded & 0xFFFFU) * (1.0f / 65535.0f), float(encoded >> 16) * (1.0f / 65535.0f));
+}
+
+inline uint32_t subsurface_scattering_rgb9e5_from_unorm16x2(float2 unorm16x2)
+{
+	return uint32_t(std::floor(unorm16x2.x * 65535.0f + 0.5f)) | (uint32_t(std::floor(unorm16x2.y * 65535.0f + 0.5f)) << 16);
+}
+
+// YCoCg (NOT the YCoCg-R), of which the Co and the Cg are signed
+inline float3 subsurface_scattering_rgb_to_ycocg(float3 rgb)
+{
+	return float3(0.25f * rgb.x + 0.5f * rgb.y + 0.25f * rgb.z, 0.5f * rgb.x - 0.5f * rgb.z, -0.25f * rgb.x + 0.5f * rgb.y - 0.25f * rgb.z);
+}
+
+inline float3 subsurface_scattering_ycocg_to_rgb(float3 ycocg)
+{
+	const float t = ycocg.x - ycocg.z;
+	return float3(t + ycocg.y, ycocg.x + ycocg.z, t - ycocg.y);
+}
+
+// The Co is stored at the texels of which the "x + y" is even, and the Cg is stored at the others, s.t. the horizontal partner (x ^ 1) always stores the other one
+inline float2 subsurface_scattering_ycocg_encode(float3 rgb, int x, int y)
+{
+	const float3 ycocg = subsurface_scattering_rgb_to_ycocg(rgb);
+	return float2(ycocg.x, (0 == ((x + y) & 1)) ? ycocg.y : ycocg.z);
+}
+
+// NOTE: the last column of the odd width is paired with the previous column, which still stores the other chroma
+inline int subsurface_scattering_ycocg_partner_x(int x, int width)
+{
+	return ((x ^ 1) < width) ? (x ^ 1) : std::max(x - 1, 0);
+}
+
+// The chroma of the partner is scaled by the ratio of the luma, s.t. the hue of the partner is kept while the partner of which the irradiance is different (e.g. across the shadow edge) does NOT bleed
+inline float3 subsurface_scattering_ycocg_decode(float2 center, float2 partner, int x, int y)
+{
+	const float partner_chroma = (partner.x > 0.0f) ? (partner.y * (center.x / partner.x)) : 0.0f;
+	const bool co_at_center = (0 == ((x + y) & 1));
+	const float3 rgb = subsurface_scattering_ycocg_to_rgb(float3(center.x, co_at_center ? center.y : partner_chroma, co_at_center ? partner_chroma : center.y));
+	return max(rgb, float3(0.0f, 0.0f, 0.0f));
+}
+
+// The near plane and the far plane of the projection (row major, SV_POSITION.z = (proj[2][2] * z + proj[3][2]) / z)
+inline float subsurface_scattering_linear_depth_encode(float view_space_position_z, const float4x4& proj)
+{
+	const float near_plane = -proj.m[3][2] / proj.m[2][2];
+	const float far_plane = proj.m[3][2] / (1.0f - proj.m[2][2]);
+	return saturate((view_space_position_z - near_plane) / (far_plane - near_plane));
+}
+
+inline float subsurface_scattering_linear_depth_decode(float linear_depth, const float4x4& proj)
+{
+	const float near_plane = -proj.m[3][2] / proj.m[2][2];
+	const float far_plane = proj.m[3][2] / (1.0f - proj.m[2][2]);
+	return near_plane + linear_depth * (far_plane - near_plane);
+}
+
+inline float subsurface_scattering_ndcz_from_view_space_position_z(float view_space_position_z, const float4x4& proj)
+{
+	return proj.m[2][2] + proj.m[3][2] / view_space_position_z;
+}
+
+#endif
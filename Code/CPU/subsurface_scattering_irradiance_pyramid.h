@@ -0,0 +1,149 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/subsurface_scattering_irradiance_pyramid.hlsli"
+//
+// Note: Provided by the User!
+//
+// The "SSS_SOURCE" template parameter replaces the macros of the HLSL version (the "int2" is replaced by the "int x, int y"):
+// int irradiance_pyramid_level_count() const                                            <=> SSS_IRRADIANCE_PYRAMID_LEVEL_COUNT
+// float4 irradiance_pyramid(int level, int x, int y) const                              <=> SSS_IRRADIANCE_PYRAMID_SOURCE
+// float irradiance_pyramid_view_space_position_z(int level, int x, int y) const         <=> SSS_IRRADIANCE_PYRAMID_VIEW_SPACE_POSITION_Z_SOURCE
+// float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const    <=> SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE
+// float view_space_position_z(float2 uv) const                                          <=> SSS_VIEW_SPACE_POSITION_Z_SOURCE
+// float2 pixels_per_uv() const                                                          <=> SSS_PIXELS_PER_UV
+//
+// The pyramid is built by the host (see "SSSIrradiancePyramid.h").
+//
+
+#ifndef _SUBSURFACE_SCATTERING_IRRADIANCE_PYRAMID_H_
+#define _SUBSURFACE_SCATTERING_IRRADIANCE_PYRAMID_H_ 1
+
+#include <algorithm>
+#include <cmath>
+#include "vector_math.h"
+#include "subsurface_scattering_mask_pyramid.h"
+
+#define SSS_IRRADIANCE_PYRAMID_MAX_LEVEL_COUNT 8
+
+#define SSS_IRRADIANCE_PYRAMID_RELATIVE_DEPTH_THRESHOLD 0.01f
+
+struct subsurface_scattering_irradiance_pyramid_texel
+{
+	// (total_diffuse_reflectance_pre_scatter_multiply_form_factor, profile_index)
+	float4 irradiance;
+	float view_space_position_z;
+};
+
+inline subsurface_scattering_irradiance_pyramid_texel subsurface_scattering_irradiance_pyramid_base(float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor, float subsurface_mask, int profile_index, float view_space_position_z)
+{
+	const bool covered = (subsurface_mask >= (1.0f / 255.0f)) && (profile_index >= 0);
+
+	subsurface_scattering_irradiance_pyramid_texel texel;
+	texel.irradiance = float4(total_diffuse_reflectance_pre_scatter_multiply_form_factor.x, total_diffuse_reflectance_pre_scatter_multiply_form_factor.y, total_diffuse_reflectance_pre_scatter_multiply_form_factor.z, covered ? float(profile_index) : -1.0f);
+	texel.view_space_position_z = view_space_position_z;
+	return texel;
+}
+
+inline subsurface_scattering_irradiance_pyramid_texel subsurface_scattering_irradiance_pyramid_reduce(const subsurface_scattering_irradiance_pyramid_texel children[4], int level)
+{
+	// The nearest child of the subsurface scattering is the representative (the same as the "subsurface_scattering_downsample")
+	int representative_profile_index = -1;
+	float representative_view_space_position_z = 0.0f;
+	for (int child_index = 0; child_index < 4; ++child_index)
+	{
+		const int profile_index = int(children[child_index].irradiance.w);
+		if ((profile_index >= 0) && ((representative_profile_index < 0) || (children[child_index].view_space_position_z < representative_view_space_position_z)))
+		{
+			representative_profile_index = profile_index;
+			representative_view_space_position_z = children[child_index].view_space_position_z;
+		}
+	}
+
+	// Only the children which are on the same surface as the representative are averaged (all of them if none is covered)
+	// NOTE: the threshold is the relative depth gradient per pixel, s.t. the sloped surface is NOT split at the coarse levels
+	const float depth_threshold = SSS_IRRADIANCE_PYRAMID_RELATIVE_DEPTH_THRESHOLD * float(1 << (level - 1)) * representative_view_space_position_z;
+	float3 sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor(0.0f, 0.0f, 0.0f);
+	float sum_view_space_position_z = 0.0f;
+	float count = 0.0f;
+	for (int child_index = 0; child_index < 4; ++child_index)
+	{
+		const subsurface_scattering_irradiance_pyramid_texel& child = children[child_index];
+		if ((representative_profile_index < 0) || ((int(child.irradiance.w) == representative_profile_index) && (std::abs(child.view_space_position_z - representative_view_space_position_z) <= depth_threshold)))
+		{
+			sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor += float3(child.irradiance.x, child.irradiance.y, child.irradiance.z);
+			sum_view_space_position_z += child.view_space_position_z;
+			count += 1.0f;
+		}
+	}
+
+	// NOTE: the representative itself is always counted
+	const float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor = sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor * (1.0f / count);
+
+	subsurface_scattering_irradiance_pyramid_texel texel;
+	texel.irradiance = float4(total_diffuse_reflectance_pre_scatter_multiply_form_factor.x, total_diffuse_reflectance_pre_scatter_multiply_form_factor.y, total_diffuse_reflectance_pre_scatter_multiply_form_factor.z, float(representative_profile_index));
+	texel.view_space_position_z = sum_view_space_position_z * (1.0f / count);
+	return texel;
+}
+
+// The level of which the texel (2^level x 2^level pixels) is NOT larger than the footprint
+inline int subsurface_scattering_irradiance_pyramid_level(float footprint_in_pixels, int level_count)
+{
+	// NOTE: check before the conversion to "int" since the behavior of the out-of-range conversion is undefined in C++
+	if ((level_count <= 1) || !(footprint_in_pixels >= 4.0f))
+	{
+		return 0;
+	}
+
+	const float lod = 0.5f * std::log2(footprint_in_pixels);
+	return (lod < float(level_count - 1)) ? int(lod) : (level_count - 1);
+}
+
+struct subsurface_scattering_irradiance_pyramid_sample_result
+{
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	float view_space_position_z;
+};
+
+template <typename SSS_SOURCE>
+inline subsurface_scattering_irradiance_pyramid_sample_result subsurface_scattering_irradiance_pyramid_sample(const SSS_SOURCE& source, const float2 sample_uv, const int profile_index, const float footprint_in_pixels)
+{
+	subsurface_scattering_irradiance_pyramid_sample_result result;
+
+	const float2 pixels_per_uv = source.pixels_per_uv();
+	const int sample_x = subsurface_scattering_mask_pyramid_texel(sample_uv.x, int(pixels_per_uv.x));
+	const int sample_y = subsurface_scattering_mask_pyramid_texel(sample_uv.y, int(pixels_per_uv.y));
+
+	// The finer level is used if the representative of the texel belongs to another profile
+	for (int level = subsurface_scattering_irradiance_pyramid_level(footprint_in_pixels, source.irradiance_pyramid_level_count()); level > 0; --level)
+	{
+		const float4 irradiance = source.irradiance_pyramid(level, sample_x >> level, sample_y >> level);
+		if (int(irradiance.w) == profile_index)
+		{
+			result.total_diffuse_reflectance_pre_scatter_multiply_form_factor = float3(irradiance.x, irradiance.y, irradiance.z);
+			result.view_space_position_z = source.irradiance_pyramid_view_space_position_z(level, sample_x >> level, sample_y >> level);
+			return result;
+		}
+	}
+
+	// The level 0 is the full resolution
+	result.total_diffuse_reflectance_pre_scatter_multiply_form_factor = source.total_diffuse_reflectance_pre_scatter_multiply_form_factor(sample_uv);
+	result.view_space_position_z = source.view_space_position_z(sample_uv);
+	return result;
+}
+
+#endif
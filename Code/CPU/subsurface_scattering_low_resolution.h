@@ -0,0 +1,191 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+// C++ counterpart of "Shaders/subsurface_scattering_low_resolution.hlsli"
+//
+// Note: Provided by the User!
+//
+// The "SSS_SOURCE" template parameter replaces the macros of the HLSL version (the "int2 texel" is replaced by the "int x, int y"):
+// float3 full_resolution_irradiance(int x, int y) const                  <=> SSS_FULL_RESOLUTION_IRRADIANCE_SOURCE
+// float full_resolution_subsurface_mask(int x, int y) const              <=> SSS_FULL_RESOLUTION_SUBSURFACE_MASK_SOURCE
+// int full_resolution_profile_index(int x, int y) const                  <=> SSS_FULL_RESOLUTION_PROFILE_INDEX_SOURCE
+// float full_resolution_view_space_position_z(int x, int y) const        <=> SSS_FULL_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE
+// int full_resolution_width() const / int full_resolution_height() const <=> SSS_FULL_RESOLUTION_SIZE
+// float3 low_resolution_blurred(int x, int y) const                      <=> SSS_LOW_RESOLUTION_BLURRED_SOURCE
+// float low_resolution_subsurface_mask(int x, int y) const               <=> SSS_LOW_RESOLUTION_SUBSURFACE_MASK_SOURCE
+// int low_resolution_profile_index(int x, int y) const                   <=> SSS_LOW_RESOLUTION_PROFILE_INDEX_SOURCE
+// float low_resolution_view_space_position_z(int x, int y) const         <=> SSS_LOW_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE
+// int low_resolution_width() const / int low_resolution_height() const   <=> SSS_LOW_RESOLUTION_SIZE
+//
+// The "subsurface_scattering_downsample" only uses the "full_resolution_*".
+//
+
+#ifndef _SUBSURFACE_SCATTERING_LOW_RESOLUTION_H_
+#define _SUBSURFACE_SCATTERING_LOW_RESOLUTION_H_ 1
+
+#include <algorithm>
+#include <cmath>
+#include "vector_math.h"
+
+#define SSS_LOW_RESOLUTION_RELATIVE_DEPTH_THRESHOLD 0.01f
+
+#define SSS_LOW_RESOLUTION_MIN_UPSAMPLE_WEIGHT 1e-4f
+
+// The factor of each dimension: the blur is performed at the full resolution / the factor
+#define SSS_RESOLUTION_FACTOR_FULL 1
+#define SSS_RESOLUTION_FACTOR_HALF 2
+#define SSS_RESOLUTION_FACTOR_QUARTER 4
+
+inline int subsurface_scattering_low_resolution_size(int full_resolution_size, int resolution_factor)
+{
+	return (full_resolution_size + resolution_factor - 1) / resolution_factor;
+}
+
+struct subsurface_scattering_downsample_result
+{
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	float subsurface_mask;
+	int profile_index;
+	int representative_texel_x;
+	int representative_texel_y;
+};
+
+template <typename SSS_SOURCE>
+inline subsurface_scattering_downsample_result subsurface_scattering_downsample(const SSS_SOURCE& source, const int resolution_factor, const int low_resolution_texel_x, const int low_resolution_texel_y)
+{
+	const int block_begin_x = std::min(low_resolution_texel_x * resolution_factor, source.full_resolution_width() - 1);
+	const int block_begin_y = std::min(low_resolution_texel_y * resolution_factor, source.full_resolution_height() - 1);
+	const int block_end_x = std::min(block_begin_x + resolution_factor, source.full_resolution_width());
+	const int block_end_y = std::min(block_begin_y + resolution_factor, source.full_resolution_height());
+
+	// The nearest texel of the subsurface scattering is the representative, s.t. the silhouette is NOT pushed into the background
+	subsurface_scattering_downsample_result result;
+	result.total_diffuse_reflectance_pre_scatter_multiply_form_factor = float3(0.0f, 0.0f, 0.0f);
+	result.subsurface_mask = 0.0f;
+	result.profile_index = -1;
+	result.representative_texel_x = block_begin_x;
+	result.representative_texel_y = block_begin_y;
+	float representative_view_space_position_z = 0.0f;
+	for (int block_y = block_begin_y; block_y < block_end_y; ++block_y)
+	{
+		for (int block_x = block_begin_x; block_x < block_end_x; ++block_x)
+		{
+			const int profile_index = source.full_resolution_profile_index(block_x, block_y);
+			const float view_space_position_z = source.full_resolution_view_space_position_z(block_x, block_y);
+			if ((profile_index >= 0) && ((result.profile_index < 0) || (view_space_position_z < representative_view_space_position_z)))
+			{
+				result.profile_index = profile_index;
+				result.representative_texel_x = block_x;
+				result.representative_texel_y = block_y;
+				representative_view_space_position_z = view_space_position_z;
+			}
+		}
+	}
+
+	if (result.profile_index < 0)
+	{
+		return result;
+	}
+
+	// Only the texels which are on the same surface as the representative are averaged, s.t. the irradiance is NOT leaked across the depth discontinuity or the profile boundary
+	float3 sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor = float3(0.0f, 0.0f, 0.0f);
+	float sum_subsurface_mask = 0.0f;
+	float count = 0.0f;
+	for (int y = block_begin_y; y < block_end_y; ++y)
+	{
+		for (int x = block_begin_x; x < block_end_x; ++x)
+		{
+			const int profile_index = source.full_resolution_profile_index(x, y);
+			const float view_space_position_z = source.full_resolution_view_space_position_z(x, y);
+			if ((profile_index == result.profile_index) && (std::abs(view_space_position_z - representative_view_space_position_z) <= (SSS_LOW_RESOLUTION_RELATIVE_DEPTH_THRESHOLD * representative_view_space_position_z)))
+			{
+				sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor += source.full_resolution_irradiance(x, y);
+				sum_subsurface_mask += source.full_resolution_subsurface_mask(x, y);
+				count += 1.0f;
+			}
+		}
+	}
+
+	// NOTE: the representative itself is always counted
+	result.total_diffuse_reflectance_pre_scatter_multiply_form_factor = sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor * (1.0f / count);
+	result.subsurface_mask = sum_subsurface_mask * (1.0f / count);
+	return result;
+}
+
+template <typename SSS_SOURCE>
+inline float3 subsurface_scattering_upsample(const SSS_SOURCE& source, const int resolution_factor, const int full_resolution_texel_x, const int full_resolution_texel_y)
+{
+	const float center_subsurface_mask = source.full_resolution_subsurface_mask(full_resolution_texel_x, full_resolution_texel_y);
+	// Early Out (the same as the full resolution blur)
+	if (center_subsurface_mask < (1.0f / 255.0f))
+	{
+		return source.full_resolution_irradiance(full_resolution_texel_x, full_resolution_texel_y);
+	}
+
+	const int center_profile_index = source.full_resolution_profile_index(full_resolution_texel_x, full_resolution_texel_y);
+	const float center_view_space_position_z = source.full_resolution_view_space_position_z(full_resolution_texel_x, full_resolution_texel_y);
+	const float rcp_depth_sigma = 1.0f / (SSS_LOW_RESOLUTION_RELATIVE_DEPTH_THRESHOLD * center_view_space_position_z);
+
+	// The center of the full resolution texel in the texel space of the low resolution
+	const float low_resolution_position_x = (float(full_resolution_texel_x) + 0.5f) * (1.0f / float(resolution_factor)) - 0.5f;
+	const float low_resolution_position_y = (float(full_resolution_texel_y) + 0.5f) * (1.0f / float(resolution_factor)) - 0.5f;
+	const int low_resolution_base_x = int(std::floor(low_resolution_position_x));
+	const int low_resolution_base_y = int(std::floor(low_resolution_position_y));
+	const float bilinear_x = low_resolution_position_x - float(low_resolution_base_x);
+	const float bilinear_y = low_resolution_position_y - float(low_resolution_base_y);
+
+	float3 sum_blurred = float3(0.0f, 0.0f, 0.0f);
+	float sum_weight = 0.0f;
+
+	// The fallback is the unblurred center if none of the four texels is on the same profile
+	float3 nearest_blurred = source.full_resolution_irradiance(full_resolution_texel_x, full_resolution_texel_y);
+	float nearest_relative_position_z = -1.0f;
+
+	for (int tap_index = 0; tap_index < 4; ++tap_index)
+	{
+		const int tap_offset_x = tap_index & 1;
+		const int tap_offset_y = tap_index >> 1;
+		const int low_resolution_texel_x = std::min(std::max(low_resolution_base_x + tap_offset_x, 0), source.low_resolution_width() - 1);
+		const int low_resolution_texel_y = std::min(std::max(low_resolution_base_y + tap_offset_y, 0), source.low_resolution_height() - 1);
+
+		const float tap_subsurface_mask = source.low_resolution_subsurface_mask(low_resolution_texel_x, low_resolution_texel_y);
+		if ((source.low_resolution_profile_index(low_resolution_texel_x, low_resolution_texel_y) == center_profile_index) && (tap_subsurface_mask >= (1.0f / 255.0f)))
+		{
+			const float3 tap_blurred = source.low_resolution_blurred(low_resolution_texel_x, low_resolution_texel_y);
+			const float relative_position_z = std::abs(source.low_resolution_view_space_position_z(low_resolution_texel_x, low_resolution_texel_y) - center_view_space_position_z) * rcp_depth_sigma;
+
+			const float bilinear_weight = ((0 != tap_offset_x) ? bilinear_x : (1.0f - bilinear_x)) * ((0 != tap_offset_y) ? bilinear_y : (1.0f - bilinear_y));
+			const float depth_weight = std::exp(-0.5f * relative_position_z * relative_position_z);
+			const float subsurface_mask_weight = saturate(1.0f - std::abs(tap_subsurface_mask - center_subsurface_mask));
+			const float weight = bilinear_weight * depth_weight * subsurface_mask_weight;
+
+			sum_blurred += tap_blurred * weight;
+			sum_weight += weight;
+
+			if ((nearest_relative_position_z < 0.0f) || (relative_position_z < nearest_relative_position_z))
+			{
+				nearest_blurred = tap_blurred;
+				nearest_relative_position_z = relative_position_z;
+			}
+		}
+	}
+
+	return (sum_weight >= SSS_LOW_RESOLUTION_MIN_UPSAMPLE_WEIGHT) ? (sum_blurred * (1.0f / sum_weight)) : nearest_blurred;
+}
+
+#endif
@@ -0,0 +1,176 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/subsurface_scattering_mask_pyramid.hlsli"
+//
+// Note: Provided by the User!
+//
+// The "SSS_SOURCE" template parameter replaces the macros of the HLSL version (the "int2" is replaced by the "int x, int y"):
+// int mask_pyramid_level_count() const                 <=> SSS_MASK_PYRAMID_LEVEL_COUNT
+// float4 mask_pyramid(int level, int x, int y) const   <=> SSS_MASK_PYRAMID_SOURCE
+// float2 pixels_per_uv() const                         <=> SSS_PIXELS_PER_UV
+//
+// The "subsurface_scattering_mask_pyramid_level_count" and the "subsurface_scattering_mask_pyramid_padded_size" are only used by the host (the "SSSBlurCPU" and the "SSSBlur") to allocate the pyramid.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_MASK_PYRAMID_H_
+#define _SUBSURFACE_SCATTERING_MASK_PYRAMID_H_ 1
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include "vector_math.h"
+
+#define SSS_MASK_PYRAMID_MAX_LEVEL_COUNT 8
+
+#define SSS_MASK_PYRAMID_SAMPLE_LEVEL 2
+
+#define SSS_MASK_PYRAMID_PROFILE_MIXED -2
+
+#define SSS_MASK_PYRAMID_SAMPLE_REJECTED 0
+#define SSS_MASK_PYRAMID_SAMPLE_ACCEPTED 1
+#define SSS_MASK_PYRAMID_SAMPLE_UNKNOWN 2
+
+#define SSS_MASK_PYRAMID_EDGE_FREE_RADIUS_EPSILON (1.0f / 16.0f)
+
+// The last level is NOT smaller than one texel, and the texel of the last level is NOT larger than 2^(SSS_MASK_PYRAMID_MAX_LEVEL_COUNT - 1) pixels
+inline int subsurface_scattering_mask_pyramid_level_count(int screen_width, int screen_height)
+{
+	int level_count = 1;
+	while ((level_count < SSS_MASK_PYRAMID_MAX_LEVEL_COUNT) && ((1 << level_count) <= std::max(screen_width, screen_height)))
+	{
+		++level_count;
+	}
+	return level_count;
+}
+
+// The size of the level 0, which is the multiple of 2^(level_count - 1)
+inline int subsurface_scattering_mask_pyramid_padded_size(int screen_size, int level_count)
+{
+	const int texel_size = 1 << (level_count - 1);
+	return ((screen_size + texel_size - 1) / texel_size) * texel_size;
+}
+
+inline float4 subsurface_scattering_mask_pyramid_base(float subsurface_mask, int profile_index)
+{
+	const bool covered = (subsurface_mask >= (1.0f / 255.0f)) && (profile_index >= 0);
+	return float4(subsurface_mask, subsurface_mask, covered ? 1.0f : 0.0f, float(profile_index));
+}
+
+inline float4 subsurface_scattering_mask_pyramid_reduce(float4 texel_00, float4 texel_10, float4 texel_01, float4 texel_11)
+{
+	const float min_mask = std::min(std::min(texel_00.x, texel_10.x), std::min(texel_01.x, texel_11.x));
+	const float max_mask = std::max(std::max(texel_00.y, texel_10.y), std::max(texel_01.y, texel_11.y));
+	const float coverage = 0.25f * (texel_00.z + texel_10.z + texel_01.z + texel_11.z);
+	const bool uniform = (texel_00.w == texel_10.w) && (texel_00.w == texel_01.w) && (texel_00.w == texel_11.w);
+	return float4(min_mask, max_mask, coverage, uniform ? texel_00.w : float(SSS_MASK_PYRAMID_PROFILE_MIXED));
+}
+
+// NOTE: the address is clamped the same as the "Image::sampleLevelPoint" (the NaN is mapped to zero)
+inline int subsurface_scattering_mask_pyramid_texel(float u, int screen_size)
+{
+	const float texel = u * float(screen_size);
+	return (texel >= 0.0f) ? ((texel < float(screen_size)) ? int(texel) : (screen_size - 1)) : 0;
+}
+
+template <typename SSS_SOURCE>
+inline int subsurface_scattering_mask_pyramid_sample_test(const SSS_SOURCE& source, const float2 sample_uv, const int profile_index)
+{
+	if (source.mask_pyramid_level_count() <= SSS_MASK_PYRAMID_SAMPLE_LEVEL)
+	{
+		return SSS_MASK_PYRAMID_SAMPLE_UNKNOWN;
+	}
+
+	const float2 pixels_per_uv = source.pixels_per_uv();
+	const int sample_x = subsurface_scattering_mask_pyramid_texel(sample_uv.x, int(pixels_per_uv.x));
+	const int sample_y = subsurface_scattering_mask_pyramid_texel(sample_uv.y, int(pixels_per_uv.y));
+	const float4 footprint = source.mask_pyramid(SSS_MASK_PYRAMID_SAMPLE_LEVEL, sample_x >> SSS_MASK_PYRAMID_SAMPLE_LEVEL, sample_y >> SSS_MASK_PYRAMID_SAMPLE_LEVEL);
+	const int footprint_profile_index = int(footprint.w);
+
+	if ((footprint.y < (1.0f / 255.0f)) || (footprint.z <= 0.0f) || ((SSS_MASK_PYRAMID_PROFILE_MIXED != footprint_profile_index) && (footprint_profile_index != profile_index)))
+	{
+		return SSS_MASK_PYRAMID_SAMPLE_REJECTED;
+	}
+	else if ((footprint.x >= (1.0f / 255.0f)) && (footprint_profile_index == profile_index))
+	{
+		return SSS_MASK_PYRAMID_SAMPLE_ACCEPTED;
+	}
+	else
+	{
+		return SSS_MASK_PYRAMID_SAMPLE_UNKNOWN;
+	}
+}
+
+// The "floor" of the texel of the level (of which the texel size is 2^level) without the call of the libm (the "x" is within the range of "int")
+inline int subsurface_scattering_mask_pyramid_floor_texel(float x, int level)
+{
+	const float texel = x * (1.0f / float(1 << level));
+	const int truncated = int(texel);
+	return (float(truncated) > texel) ? (truncated - 1) : truncated;
+}
+
+template <typename SSS_SOURCE>
+inline float subsurface_scattering_mask_pyramid_edge_free_radius(const SSS_SOURCE& source, const float2 center_uv, const int profile_index, const float radius_in_pixels)
+{
+	const int level_count = source.mask_pyramid_level_count();
+	// NOTE: check before the conversion to "int" since the behavior of the out-of-range conversion is undefined in C++
+	if ((level_count <= 0) || !((2.0f * radius_in_pixels) <= float(1 << (level_count - 1))))
+	{
+		return 0.0f;
+	}
+
+	// The smallest level of which the texel is NOT smaller than the diameter, namely, "ceil(log2(max(2 * radius, 1)))" of the HLSL version
+	// NOTE: the loop replaces the "log2" and the "ceil", since this is evaluated for every pixel
+	int level = 0;
+	while (float(1 << level) < (2.0f * radius_in_pixels))
+	{
+		++level;
+	}
+	const float texel_size = float(1 << level);
+
+	const float2 pixels_per_uv = source.pixels_per_uv();
+	const int screen_width = int(pixels_per_uv.x);
+	const int screen_height = int(pixels_per_uv.y);
+	const int last_texel_x = (screen_width - 1) >> level;
+	const int last_texel_y = (screen_height - 1) >> level;
+	const float center_x = float(subsurface_scattering_mask_pyramid_texel(center_uv.x, screen_width)) + 0.5f;
+	const float center_y = float(subsurface_scattering_mask_pyramid_texel(center_uv.y, screen_height)) + 0.5f;
+	const int texel_begin_x = std::min(std::max(subsurface_scattering_mask_pyramid_floor_texel(center_x - radius_in_pixels, level), 0), last_texel_x);
+	const int texel_begin_y = std::min(std::max(subsurface_scattering_mask_pyramid_floor_texel(center_y - radius_in_pixels, level), 0), last_texel_y);
+	const int texel_end_x = std::min(std::max(subsurface_scattering_mask_pyramid_floor_texel(center_x + radius_in_pixels, level), 0), last_texel_x);
+	const int texel_end_y = std::min(std::max(subsurface_scattering_mask_pyramid_floor_texel(center_y + radius_in_pixels, level), 0), last_texel_y);
+
+	for (int texel_y = texel_begin_y; texel_y <= texel_end_y; ++texel_y)
+	{
+		for (int texel_x = texel_begin_x; texel_x <= texel_end_x; ++texel_x)
+		{
+			const float4 footprint = source.mask_pyramid(level, texel_x, texel_y);
+			if (!((footprint.x >= (1.0f / 255.0f)) && (int(footprint.w) == profile_index)))
+			{
+				return 0.0f;
+			}
+		}
+	}
+
+	const float distance_begin_x = (0 == texel_begin_x) ? FLT_MAX : (center_x - float(texel_begin_x) * texel_size);
+	const float distance_begin_y = (0 == texel_begin_y) ? FLT_MAX : (center_y - float(texel_begin_y) * texel_size);
+	const float distance_end_x = (last_texel_x == texel_end_x) ? FLT_MAX : (float(texel_end_x + 1) * texel_size - center_x);
+	const float distance_end_y = (last_texel_y == texel_end_y) ? FLT_MAX : (float(texel_end_y + 1) * texel_size - center_y);
+	return std::min(std::min(distance_begin_x, distance_begin_y), std::min(distance_end_x, distance_end_y)) - SSS_MASK_PYRAMID_EDGE_FREE_RADIUS_EPSILON;
+}
+
+#endif
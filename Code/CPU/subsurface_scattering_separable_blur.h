@@ -0,0 +1,97 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/subsurface_scattering_separable_blur.hlsli"
+//
+// Note: Provided by the User!
+//
+// The "SSS_SOURCE" template parameter replaces the macros of the HLSL version:
+// float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor(float2 uv) const <=> SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE
+// float subsurface_mask(float2 uv) const                                             <=> SSS_SUBSURFACE_MASK_SOURCE
+// int subsurface_profile_index(float2 uv) const                                      <=> SSS_SUBSURFACE_PROFILE_INDEX_SOURCE
+// float view_space_position_z(float2 uv) const                                       <=> SSS_VIEW_SPACE_POSITION_Z_SOURCE
+// float projection_x() const                                                         <=> SSS_PROJECTION_X_SOURCE
+// float projection_y() const                                                         <=> SSS_PROJECTION_Y_SOURCE
+// float2 pixels_per_uv() const                                                       <=> SSS_PIXELS_PER_UV
+// float4 separable_kernel_sample(int profile_index, int sample_index) const          <=> SSS_SEPARABLE_KERNEL_SAMPLE_SOURCE
+//
+// The "separable_kernel_sample" returns (weight.rgb, offset_in_mm) of the row of the profile (see "SSSSeparableKernel.h").
+// The horizontal pass reads the irradiance and the vertical pass reads the output of the horizontal pass, namely, the "total_diffuse_reflectance_pre_scatter_multiply_form_factor" of the vertical pass is the intermediate render target.
+// The "total_diffuse_reflectance_post_scatter" is multiplied by the caller of the vertical pass.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_SEPARABLE_BLUR_H_
+#define _SUBSURFACE_SCATTERING_SEPARABLE_BLUR_H_ 1
+
+#include <cmath>
+#include "vector_math.h"
+
+#define SSS_SEPARABLE_KERNEL_SAMPLE_COUNT 25
+
+// SSS_BLUR_MODE_BURLEY: the "subsurface_scattering_disney_blur" (one pass)
+// SSS_BLUR_MODE_SEPARABLE: the "subsurface_scattering_separable_blur" (the horizontal pass into the intermediate render target and then the vertical pass)
+#define SSS_BLUR_MODE_BURLEY 0
+#define SSS_BLUR_MODE_SEPARABLE 1
+
+// direction: (1, 0) for the horizontal pass and (0, 1) for the vertical pass
+template <typename SSS_SOURCE>
+inline float3 subsurface_scattering_separable_blur(const SSS_SOURCE& source, const float filter_radius, const float world_scale, const float2 direction, const float2 center_uv)
+{
+	const float3 center_total_diffuse_reflectance_pre_scatter_multiply_form_factor = source.total_diffuse_reflectance_pre_scatter_multiply_form_factor(center_uv);
+
+	const float dist_scale = source.subsurface_mask(center_uv);
+	// Early Out
+	if (dist_scale < (1.0f / 255.0f))
+	{
+		return center_total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	}
+
+	// UE4
+	// See "subsurface_scattering_disney_blur" for details.
+	const float meters_per_unit = world_scale;
+	const float center_view_space_position_z = source.view_space_position_z(center_uv);
+	const float mms_per_unit = 1000.0f * meters_per_unit * (1.0f / dist_scale);
+	const float2 uv_per_mm = 0.5f * float2(source.projection_x(), source.projection_y()) * (1.0f / center_view_space_position_z) * (1.0f / mms_per_unit);
+
+	const int profile_index = source.subsurface_profile_index(center_uv);
+
+	float3 sum = float3(0.0f, 0.0f, 0.0f);
+	for (int sample_index = 0; sample_index < SSS_SEPARABLE_KERNEL_SAMPLE_COUNT; ++sample_index)
+	{
+		// (weight.rgb, offset_in_mm)
+		const float4 kernel_sample = source.separable_kernel_sample(profile_index, sample_index);
+		const float2 sample_uv = center_uv + uv_per_mm * direction * kernel_sample.w;
+
+		// The samples which belong to another profile (or which are NOT skin) are replaced by the center, s.t. the energy is NOT leaked across the boundary
+		float3 sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor = center_total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+		if ((source.subsurface_mask(sample_uv) >= (1.0f / 255.0f)) && (source.subsurface_profile_index(sample_uv) == profile_index))
+		{
+			// Follow Surface
+			// The 1D kernel can NOT be evaluated at the 3D distance (since the cross terms of the sum of Gaussians are dropped), and thus the sample is faded to the center by the depth difference relative to the filter radius.
+			const float sample_view_space_position_z = source.view_space_position_z(sample_uv);
+			const float relative_position_z_mm = mms_per_unit * (sample_view_space_position_z - center_view_space_position_z);
+			const float follow_surface = saturate(std::abs(relative_position_z_mm) * (1.0f / filter_radius));
+			sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor = lerp(source.total_diffuse_reflectance_pre_scatter_multiply_form_factor(sample_uv), center_total_diffuse_reflectance_pre_scatter_multiply_form_factor, follow_surface);
+		}
+
+		sum += float3(kernel_sample.x, kernel_sample.y, kernel_sample.z) * sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	}
+
+	return sum;
+}
+
+#endif
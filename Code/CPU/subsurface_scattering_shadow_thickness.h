@@ -0,0 +1,79 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/subsurface_scattering_shadow_thickness.hlsli"
+//
+// The C++ version additionally provides the texel of the shadow map (after the conversion of the format by the hardware), s.t. the error of the thickness can be analyzed on the CPU (see "verifyShadowThickness" of the "SSSBenchmark.h").
+//
+
+#ifndef _SUBSURFACE_SCATTERING_SHADOW_THICKNESS_H_
+#define _SUBSURFACE_SCATTERING_SHADOW_THICKNESS_H_ 1
+
+#include <cmath>
+#include "vector_math.h"
+#include "subsurface_scattering_gbuffer_encoding.h"
+
+// NDC_R32F: the NDC depth (SV_POSITION.z) of the hardware depth (DXGI_FORMAT_D32_FLOAT)
+// LINEAR_R16F / LINEAR_R32F: the view space position z of the light (SV_POSITION.w) in the DXGI_FORMAT_R16_FLOAT or the DXGI_FORMAT_R32_FLOAT
+#define SSS_SHADOW_DEPTH_MODE_NDC_R32F 0
+#define SSS_SHADOW_DEPTH_MODE_LINEAR_R16F 1
+#define SSS_SHADOW_DEPTH_MODE_LINEAR_R32F 2
+#define SSS_SHADOW_DEPTH_MODE_COUNT 3
+
+inline float subsurface_scattering_shadow_thickness_from_ndc(float shadow_map_depth, float shadow_position_z, const float4x4& light_projection)
+{
+	const float d1 = light_projection.m[3][2] / (shadow_map_depth - light_projection.m[2][2]);
+	const float d2 = light_projection.m[3][2] / (shadow_position_z - light_projection.m[2][2]);
+	return std::abs(d2 - d1);
+}
+
+inline float subsurface_scattering_shadow_thickness_from_linear(float shadow_map_view_space_position_z, float shadow_position_w)
+{
+	return std::abs(shadow_position_w - shadow_map_view_space_position_z);
+}
+
+// The texel of the shadow map of which the view space position z (of the light) is "view_space_position_z"
+inline float subsurface_scattering_shadow_map_texel(int shadow_depth_mode, float view_space_position_z, const float4x4& light_projection)
+{
+	float texel;
+	switch (shadow_depth_mode)
+	{
+	case SSS_SHADOW_DEPTH_MODE_LINEAR_R16F:
+	{
+		texel = subsurface_scattering_half_decode(subsurface_scattering_half_encode(view_space_position_z));
+		break;
+	}
+	case SSS_SHADOW_DEPTH_MODE_LINEAR_R32F:
+	{
+		texel = view_space_position_z;
+		break;
+	}
+	default:
+	{
+		texel = subsurface_scattering_ndcz_from_view_space_position_z(view_space_position_z, light_projection);
+	}
+	}
+	return texel;
+}
+
+// The same as the transmittance of the "RenderPS" (the "shadow_position_z" is after the perspective division, and the "shadow_position_w" is before)
+inline float subsurface_scattering_shadow_thickness(int shadow_depth_mode, float shadow_map_texel, float shadow_position_z, float shadow_position_w, const float4x4& light_projection)
+{
+	return (SSS_SHADOW_DEPTH_MODE_NDC_R32F == shadow_depth_mode) ? subsurface_scattering_shadow_thickness_from_ndc(shadow_map_texel, shadow_position_z, light_projection) : subsurface_scattering_shadow_thickness_from_linear(shadow_map_texel, shadow_position_w);
+}
+
+#endif
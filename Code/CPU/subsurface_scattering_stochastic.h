@@ -0,0 +1,183 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_STOCHASTIC_H_
+#define _SUBSURFACE_SCATTERING_STOCHASTIC_H_ 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "math_consts.h"
+#include "vector_math.h"
+
+// The stochastic mode of the Burley blur (no HLSL counterpart): each pixel takes at most SSS_STOCHASTIC_MAX_SAMPLE_COUNT samples of the "subsurface_scattering_disney_blur", and the noise is reconstructed by the iterations of the edge-aware a-trous wavelet filter (see "SSSBlurCPU.h").
+//
+// The sequence of each pixel is offset by the "subsurface_scattering_stochastic_sequence_offset" (the Cranley-Patterson rotation), s.t. the neighboring pixels take the different samples and the error is spread at the high frequencies (the blue noise, approximately).
+// The stochastic pass writes the sums of the ratio estimator (the "sum_numerator" and the "sum_denominator" divided by the "sample_count", namely, demodulated by the "total_diffuse_reflectance_post_scatter") instead of the ratio, s.t. the filter pools the samples of the neighboring pixels (and the rejected samples have no weight) rather than averaging the ratios.
+// The "subsurface_scattering_stochastic_resolve" divides the filtered sums and applies the center sample reweighting.
+//
+// Note: Provided by the User!
+//
+// The "SSS_SOURCE" template parameter of the "subsurface_scattering_atrous_filter":
+// float4 atrous_guide(int x, int y) const        : (view_space_position_z, subsurface_mask, diffusion_radius_in_pixels, profile_index), of which the profile_index is -1 if the pixel is NOT estimated by the stochastic pass
+// float4 atrous_numerator(int x, int y) const    : (sum_numerator / sample_count, center_sample_cdf)
+// float4 atrous_denominator(int x, int y) const  : (sum_denominator / sample_count, 0)
+// int atrous_width() const / int atrous_height() const
+//
+// The "diffusion_radius_in_pixels" is the scattering distance of the widest channel (NOT the "filter_radius", which is about 16 times wider) at the center.
+//
+
+#define SSS_STOCHASTIC_MAX_SAMPLE_COUNT 4
+
+#define SSS_ATROUS_DEFAULT_ITERATION_COUNT 2
+#define SSS_ATROUS_MAX_ITERATION_COUNT 5
+
+// The B3 spline (1/16, 1/4, 3/8, 1/4, 1/16) of which the taps of the iteration "i" are 2^i pixels apart
+#define SSS_ATROUS_KERNEL_RADIUS 2
+
+// The relative depth per pixel of the distance (the same as the "SSS_IRRADIANCE_PYRAMID_RELATIVE_DEPTH_THRESHOLD")
+#define SSS_ATROUS_RELATIVE_DEPTH_SIGMA 0.01f
+
+// The same as the "SSS_TEMPORAL_SUBSURFACE_MASK_THRESHOLD"
+#define SSS_ATROUS_SUBSURFACE_MASK_SIGMA 0.1f
+
+// The standard deviation of the distance in the units of the diffusion radius, s.t. the pooled samples stay within the peak of the profile of the center
+// NOTE: the pooling widens the profile (the bias), which is why the default iteration count is low
+#define SSS_ATROUS_RADIUS_SCALE 1.0f
+
+// (interleaved gradient noise, R2 dither) of the pixel
+// The interleaved gradient noise is offset by the frame, s.t. the successive frames take the different samples (the same as the "subsurface_scattering_sample_rotation")
+inline float2 subsurface_scattering_stochastic_sequence_offset(int x, int y, uint32_t frame_index)
+{
+	// http://www.iryoku.com/next-generation-post-processing-in-call-of-duty-advanced-warfare
+	const float ign_x = float(x) + 5.588238f * float(frame_index & 63U);
+	const float ign_y = float(y) + 5.588238f * float(frame_index & 63U);
+	const float ign_fraction = 0.06711056f * ign_x + 0.00583715f * ign_y;
+	const float ign_scaled = 52.9829189f * (ign_fraction - std::floor(ign_fraction));
+	const float ign = ign_scaled - std::floor(ign_scaled);
+
+	// http://extremelearning.com.au/unreasonable-effectiveness-of-quasirandom-sequences/
+	const double r2 = 0.75487766624669276005 * double(x) + 0.56984029099805326591 * double(y);
+	const float dither = float(r2 - std::floor(r2));
+
+	return float2(ign, dither);
+}
+
+// Cranley-Patterson Rotation
+inline float2 subsurface_scattering_stochastic_sequence(float2 xi, float2 sequence_offset)
+{
+	const float x = xi.x + sequence_offset.x;
+	const float y = xi.y + sequence_offset.y;
+	// NOTE: the result is clamped below 1, since the "x" is the CDF of the radius
+	return float2(std::min(x - std::floor(x), 0.99999994f), std::min(y - std::floor(y), 0.99999994f));
+}
+
+inline float subsurface_scattering_atrous_kernel_weight(int tap)
+{
+	static const float kernel_weights[2 * SSS_ATROUS_KERNEL_RADIUS + 1] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+	return kernel_weights[tap + SSS_ATROUS_KERNEL_RADIUS];
+}
+
+// The edge-stopping weight of the tap
+// The taps of another profile (or NOT estimated by the stochastic pass) are rejected, and the weight falls off with the difference of the linear depth (relative to the distance), the difference of the subsurface mask and the distance in the units of the diffusion radius of the center
+inline float subsurface_scattering_atrous_edge_stopping_weight(const float4 center_guide, const float4 tap_guide, const float distance_in_pixels)
+{
+	if ((tap_guide.w < 0.0f) || (tap_guide.w != center_guide.w))
+	{
+		return 0.0f;
+	}
+
+	// NOTE: the product of the three weights is evaluated by one "exp"
+	const float depth_term = std::abs(tap_guide.x - center_guide.x) / std::max(SSS_ATROUS_RELATIVE_DEPTH_SIGMA * center_guide.x * distance_in_pixels, FLT_MIN);
+	const float mask_term = std::abs(tap_guide.y - center_guide.y) * (1.0f / SSS_ATROUS_SUBSURFACE_MASK_SIGMA);
+	const float radius_sigma = std::max(SSS_ATROUS_RADIUS_SCALE * center_guide.z, FLT_MIN);
+	const float radius_term = 0.5f * (distance_in_pixels * distance_in_pixels) / (radius_sigma * radius_sigma);
+	return std::exp(-(depth_term + mask_term + radius_term));
+}
+
+struct subsurface_scattering_atrous_result
+{
+	float4 numerator;
+	float4 denominator;
+};
+
+// One iteration of the a-trous filter of which the taps are "step" pixels apart
+// NOTE: the pixel which is NOT estimated by the stochastic pass is copied
+template <typename SSS_SOURCE>
+inline subsurface_scattering_atrous_result subsurface_scattering_atrous_filter(const SSS_SOURCE& source, const int x, const int y, const int step)
+{
+	subsurface_scattering_atrous_result result;
+	result.numerator = source.atrous_numerator(x, y);
+	result.denominator = source.atrous_denominator(x, y);
+
+	const float4 center_guide = source.atrous_guide(x, y);
+	if (center_guide.w < 0.0f)
+	{
+		return result;
+	}
+
+	const int width = source.atrous_width();
+	const int height = source.atrous_height();
+
+	float3 sum_numerator(0.0f, 0.0f, 0.0f);
+	float3 sum_denominator(0.0f, 0.0f, 0.0f);
+	float sum_weight = 0.0f;
+	for (int tap_y = -SSS_ATROUS_KERNEL_RADIUS; tap_y <= SSS_ATROUS_KERNEL_RADIUS; ++tap_y)
+	{
+		const int texel_y = y + tap_y * step;
+		if ((texel_y < 0) || (texel_y >= height))
+		{
+			continue;
+		}
+
+		for (int tap_x = -SSS_ATROUS_KERNEL_RADIUS; tap_x <= SSS_ATROUS_KERNEL_RADIUS; ++tap_x)
+		{
+			const int texel_x = x + tap_x * step;
+			if ((texel_x < 0) || (texel_x >= width))
+			{
+				continue;
+			}
+
+			// NOTE: the center tap is always accepted
+			const float distance_in_pixels = float(step) * std::sqrt(float(tap_x * tap_x + tap_y * tap_y));
+			const float edge_stopping_weight = ((0 == tap_x) && (0 == tap_y)) ? 1.0f : subsurface_scattering_atrous_edge_stopping_weight(center_guide, source.atrous_guide(texel_x, texel_y), distance_in_pixels);
+			const float weight = subsurface_scattering_atrous_kernel_weight(tap_x) * subsurface_scattering_atrous_kernel_weight(tap_y) * edge_stopping_weight;
+			if (weight > 0.0f)
+			{
+				const float4 tap_numerator = source.atrous_numerator(texel_x, texel_y);
+				const float4 tap_denominator = source.atrous_denominator(texel_x, texel_y);
+				sum_numerator += float3(tap_numerator.x, tap_numerator.y, tap_numerator.z) * weight;
+				sum_denominator += float3(tap_denominator.x, tap_denominator.y, tap_denominator.z) * weight;
+				sum_weight += weight;
+			}
+		}
+	}
+
+	const float rcp_sum_weight = 1.0f / sum_weight;
+	result.numerator = float4(sum_numerator.x * rcp_sum_weight, sum_numerator.y * rcp_sum_weight, sum_numerator.z * rcp_sum_weight, result.numerator.w);
+	result.denominator = float4(sum_denominator.x * rcp_sum_weight, sum_denominator.y * rcp_sum_weight, sum_denominator.z * rcp_sum_weight, result.denominator.w);
+	return result;
+}
+
+// The "total_diffuse_reflectance_pre_scatter_multiply_form_factor" of the "subsurface_scattering_disney_blur_end" from the (filtered) sums
+inline float3 subsurface_scattering_stochastic_resolve(const float4 numerator, const float4 denominator, const float3 center_total_diffuse_reflectance_pre_scatter_multiply_form_factor)
+{
+	const float3 sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor = float3(numerator.x, numerator.y, numerator.z) / max(float3(denominator.x, denominator.y, denominator.z), float3(FLT_MIN, FLT_MIN, FLT_MIN));
+	return lerp(sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor, center_total_diffuse_reflectance_pre_scatter_multiply_form_factor, numerator.w);
+}
+
+#endif
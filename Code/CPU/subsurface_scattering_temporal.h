@@ -0,0 +1,162 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+// C++ counterpart of "Shaders/subsurface_scattering_temporal.hlsli"
+//
+// Note: Provided by the User!
+//
+// The "SSS_SOURCE" template parameter replaces the macros of the HLSL version (the "int2 texel" is replaced by the "int x, int y"):
+// float4 history(int x, int y) const                                  <=> SSS_TEMPORAL_HISTORY_SOURCE
+// float2 history_guide(int x, int y) const                            <=> SSS_TEMPORAL_HISTORY_GUIDE_SOURCE
+// int history_width() const / int history_height() const             <=> SSS_TEMPORAL_HISTORY_SIZE
+//
+// The "subsurface_scattering_motion_vector" is the same as the "RenderPS" of the "Shaders/Support/Main.hlsli".
+// The "subsurface_scattering_sample_rotation" is uploaded as the "sampleRotation" of the "Shaders/Support/SSS_Blur.hlsli".
+//
+
+#ifndef _SUBSURFACE_SCATTERING_TEMPORAL_H_
+#define _SUBSURFACE_SCATTERING_TEMPORAL_H_ 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "math_consts.h"
+#include "vector_math.h"
+#include "low_discrepancy_sequence.h"
+
+#define SSS_TEMPORAL_RELATIVE_DEPTH_THRESHOLD 0.01f
+
+#define SSS_TEMPORAL_SUBSURFACE_MASK_THRESHOLD 0.1f
+
+#define SSS_TEMPORAL_MAX_HISTORY_LENGTH 64.0f
+
+// The "min_blend" of the "subsurface_scattering_temporal_accumulate"
+// NOTE: the history of the still head is the average of all SSS_TEMPORAL_MAX_HISTORY_LENGTH frames (the rejection of the "subsurface_scattering_temporal_history" restarts the history of the moving head), s.t. the error does NOT plateau (and fluctuate) after "1 / min_blend" frames
+#define SSS_TEMPORAL_DEFAULT_BLEND (1.0f / SSS_TEMPORAL_MAX_HISTORY_LENGTH)
+
+// The period of the "subsurface_scattering_sample_radius_offset" (a power of two), s.t. the kernel cache only bakes a few offsets of each kernel (see "SSSKernelCache.h")
+#define SSS_TEMPORAL_SAMPLE_RADIUS_OFFSET_COUNT 16
+
+// (cos(theta), sin(theta)) of the golden angle sequence: theta = 2 * PI * frac(frame_index * (sqrt(5) - 1) / 2)
+// The frame 0 is NOT rotated, s.t. the blur without the temporal accumulation is the same as before.
+inline float2 subsurface_scattering_sample_rotation(uint32_t frame_index)
+{
+	// 0.61803398874989484820 * 2^32
+	const uint32_t fraction = frame_index * 2654435769U;
+	const double theta = (2.0 * PI) * (double(fraction) * (1.0 / 4294967296.0));
+	return float2(float(std::cos(theta)), float(std::sin(theta)));
+}
+
+// The rotation only decorrelates the angles of the successive frames, and the radii are the same in every frame.
+// The x (mapped to the radius) of the "sample_sequence" is shifted by the Cranley-Patterson offset of the frame: frac(frame_index * alpha) quantized to SSS_TEMPORAL_SAMPLE_RADIUS_OFFSET_COUNT offsets.
+// NOTE: the alpha = 1 / 1.32471795724474602596 (the plastic number, of which the additive recurrence is independent of the golden angle of the rotation), s.t. any window of successive frames (rather than only the power of two prefixes) is stratified, since the exponential moving average mostly weights the latest frames
+// The frame 0 is NOT offset.
+inline int subsurface_scattering_sample_radius_offset_index(uint32_t frame_index)
+{
+	return int(reversebits(frame_index & uint32_t(SSS_TEMPORAL_SAMPLE_RADIUS_OFFSET_COUNT - 1)) / (4294967296ULL / uint64_t(SSS_TEMPORAL_SAMPLE_RADIUS_OFFSET_COUNT)));
+}
+
+inline float subsurface_scattering_sample_radius_offset(int radius_offset_index)
+{
+	return float(radius_offset_index) * (1.0f / float(SSS_TEMPORAL_SAMPLE_RADIUS_OFFSET_COUNT));
+}
+
+// The Cranley-Patterson rotation of the x of the "sample_sequence"
+// NOTE: the offset is scaled by "1 / sample_count" (the stratum of the Hammersley), since the offset of "1 / sample_count" only permutes the points of the Hammersley
+inline float2 subsurface_scattering_sample_sequence_offset(const float2 xi, const float radius_offset, const int sample_count)
+{
+	const float x = xi.x + radius_offset / float(sample_count);
+	return float2((x >= 1.0f) ? (x - 1.0f) : x, xi.y);
+}
+
+// (row vector) * (row major matrix)
+inline float4 subsurface_scattering_temporal_mul(const float4 v, const float4x4& m)
+{
+	return float4(
+		v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + v.w * m.m[3][0],
+		v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + v.w * m.m[3][1],
+		v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + v.w * m.m[3][2],
+		v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + v.w * m.m[3][3]);
+}
+
+// uv_curr - uv_prev
+inline float2 subsurface_scattering_motion_vector(const float4 curr_clip, const float4 prev_clip)
+{
+	return float2((curr_clip.x / curr_clip.w - prev_clip.x / prev_clip.w) * 0.5f, (curr_clip.y / curr_clip.w - prev_clip.y / prev_clip.w) * -0.5f);
+}
+
+// (uv_prev.x, uv_prev.y, view_space_position_z_prev)
+inline float3 subsurface_scattering_temporal_reproject(const float2 uv, const float ndc_depth, const float view_space_position_z, const float4x4& reprojection)
+{
+	const float4 prev_clip = subsurface_scattering_temporal_mul(float4(uv.x * 2.0f - 1.0f, uv.y * -2.0f + 1.0f, ndc_depth, 1.0f), reprojection);
+	return float3((prev_clip.x / prev_clip.w) * 0.5f + 0.5f, (prev_clip.y / prev_clip.w) * -0.5f + 0.5f, prev_clip.w * view_space_position_z);
+}
+
+template <typename SSS_SOURCE>
+inline float4 subsurface_scattering_temporal_history(const SSS_SOURCE& source, const float2 prev_uv, const float predicted_prev_view_space_position_z, const float subsurface_mask)
+{
+	// Off Screen
+	if ((prev_uv.x < 0.0f) || (prev_uv.y < 0.0f) || (prev_uv.x > 1.0f) || (prev_uv.y > 1.0f) || (predicted_prev_view_space_position_z <= 0.0f))
+	{
+		return float4(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	const int history_width = source.history_width();
+	const int history_height = source.history_height();
+	const float history_position_x = prev_uv.x * float(history_width) - 0.5f;
+	const float history_position_y = prev_uv.y * float(history_height) - 0.5f;
+	const int history_base_x = int(std::floor(history_position_x));
+	const int history_base_y = int(std::floor(history_position_y));
+	const float bilinear_x = history_position_x - float(history_base_x);
+	const float bilinear_y = history_position_y - float(history_base_y);
+
+	float4 sum_history = float4(0.0f, 0.0f, 0.0f, 0.0f);
+	float sum_weight = 0.0f;
+
+	for (int tap_index = 0; tap_index < 4; ++tap_index)
+	{
+		const int tap_offset_x = tap_index & 1;
+		const int tap_offset_y = tap_index >> 1;
+		const int history_texel_x = std::min(std::max(history_base_x + tap_offset_x, 0), history_width - 1);
+		const int history_texel_y = std::min(std::max(history_base_y + tap_offset_y, 0), history_height - 1);
+
+		const float2 history_guide = source.history_guide(history_texel_x, history_texel_y);
+		const bool same_surface = (history_guide.x > 0.0f) && (history_guide.y >= (1.0f / 255.0f)) && (std::abs(history_guide.x - predicted_prev_view_space_position_z) <= (SSS_TEMPORAL_RELATIVE_DEPTH_THRESHOLD * predicted_prev_view_space_position_z)) && (std::abs(history_guide.y - subsurface_mask) <= SSS_TEMPORAL_SUBSURFACE_MASK_THRESHOLD);
+
+		if (same_surface)
+		{
+			const float weight = ((0 != tap_offset_x) ? bilinear_x : (1.0f - bilinear_x)) * ((0 != tap_offset_y) ? bilinear_y : (1.0f - bilinear_y));
+			const float4 history = source.history(history_texel_x, history_texel_y);
+			sum_history = float4(sum_history.x + history.x * weight, sum_history.y + history.y * weight, sum_history.z + history.z * weight, sum_history.w + history.w * weight);
+			sum_weight += weight;
+		}
+	}
+
+	return (sum_weight > 0.0f) ? float4(sum_history.x * (1.0f / sum_weight), sum_history.y * (1.0f / sum_weight), sum_history.z * (1.0f / sum_weight), sum_history.w) : float4(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+// NOTE: the history length is clamped to "1 / min_blend", s.t. the history length is the number of the frames which the exponential moving average is equivalent to, and the weight of the current frame is always "1 / history_length"
+inline float4 subsurface_scattering_temporal_accumulate(const float3 current, const float4 history, const float min_blend)
+{
+	const float history_length = std::min(history.w + 1.0f, std::min(SSS_TEMPORAL_MAX_HISTORY_LENGTH, 1.0f / min_blend));
+	const float blend = 1.0f / history_length;
+	const float3 radiance = lerp(float3(history.x, history.y, history.z), current, blend);
+	return float4(radiance.x, radiance.y, radiance.z, history_length);
+}
+
+#endif
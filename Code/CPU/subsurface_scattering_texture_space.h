@@ -0,0 +1,143 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_TEXTURE_SPACE_H_
+#define _SUBSURFACE_SCATTERING_TEXTURE_SPACE_H_ 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "math_consts.h"
+#include "vector_math.h"
+#include "low_discrepancy_sequence.h"
+#include "subsurface_scattering_disney_blur.h"
+
+// The counterpart of "Shaders/subsurface_scattering_texture_space.hlsli"
+//
+// The texture space diffusion: the irradiance is rendered into the texture space of the head (the "relighting") and blurred by the Burley profile there, s.t. the result does NOT depend on the camera and is reused until the lights, the parameters or the transform change (see "SSSTextureSpaceCache.h").
+// Each texel takes the samples of the profile of the widest channel (the same estimator as the "subsurface_scattering_disney_blur"), of which the offset in mm is converted to the texels by the stretch of the center (the units of the mesh per texel along u and v, see "SSSTextureSpaceGeometry").
+// The radius passed to the profile is the distance between the object space positions of the center and the sample if it is longer than the sampled radius, s.t. the samples of the neighboring charts (adjacent in the texture space but NOT on the surface) are attenuated by their real distance,
+// while the shorter distances (the stretch changes within the filter, e.g. towards the poles of the charts) do NOT amplify the weights.
+// The texels outside the charts (the coverage of the irradiance is zero) and outside the texture are rejected, the same as the subsurface mask of the blur.
+// NOTE: the samples across the seams (adjacent on the surface but NOT in the texture space) are missed, and the ratio estimator renormalizes the rest of the samples.
+//
+// Note: Provided by the User!
+//
+// The "SSS_SOURCE" template parameter of the "subsurface_scattering_texture_space_diffuse":
+// float4 texture_space_irradiance(int x, int y) const <=> SSS_TEXTURE_SPACE_IRRADIANCE_SOURCE : (total_diffuse_reflectance_pre_scatter_multiply_form_factor, coverage)
+// float4 texture_space_position(int x, int y) const   <=> SSS_TEXTURE_SPACE_POSITION_SOURCE : (object space position, 1), or zero if the texel is empty
+// float2 texture_space_stretch(int x, int y) const    <=> SSS_TEXTURE_SPACE_STRETCH_SOURCE : the units of the mesh per texel along u and v
+// int texture_space_size() const                      <=> SSS_TEXTURE_SPACE_SIZE
+//
+
+#define SSS_TEXTURE_SPACE_DEFAULT_SAMPLE_COUNT 64
+#define SSS_TEXTURE_SPACE_MAX_SAMPLE_COUNT 256
+
+// The sample of the kernel which does NOT depend on the texel (baked once per profile by the CPU path, while the GPU path evaluates it per texel)
+struct subsurface_scattering_texture_space_kernel_sample
+{
+	float r;
+	float rcp_pdf;
+	// (cos, sin) of the angle before the rotation of the texel
+	float2 direction;
+};
+
+inline subsurface_scattering_texture_space_kernel_sample subsurface_scattering_texture_space_kernel(const float d, const int sample_count, const int sample_index)
+{
+	const float2 xi = fibonacci_2d(uint32_t(sample_index), uint32_t(sample_count));
+
+	subsurface_scattering_texture_space_kernel_sample kernel_sample;
+	kernel_sample.r = diffusion_profile_sample_r(d, xi.x);
+	kernel_sample.rcp_pdf = diffusion_profile_evaluate_rcp_pdf(d, kernel_sample.r);
+	kernel_sample.direction = float2(std::cos(2.0f * float(PI) * xi.y), std::sin(2.0f * float(PI) * xi.y));
+	return kernel_sample;
+}
+
+// The rotation of the samples of each texel (the interleaved gradient noise without the frame), s.t. the neighboring texels take the different samples and the pattern of the Fibonacci spiral is NOT baked into the atlas
+inline float subsurface_scattering_texture_space_rotation(int x, int y)
+{
+	// http://www.iryoku.com/next-generation-post-processing-in-call-of-duty-advanced-warfare
+	const float ign_fraction = 0.06711056f * float(x) + 0.00583715f * float(y);
+	const float ign_scaled = 52.9829189f * (ign_fraction - std::floor(ign_fraction));
+	return ign_scaled - std::floor(ign_scaled);
+}
+
+template <typename SSS_SOURCE>
+inline float3 subsurface_scattering_texture_space_diffuse(const SSS_SOURCE& source, const subsurface_scattering_texture_space_kernel_sample* kernel, const float3 scattering_distance, const float world_scale, const int sample_count, const int x, const int y)
+{
+	const float4 center_position = source.texture_space_position(x, y);
+	if (!(center_position.w > 0.0f))
+	{
+		return float3(0.0f, 0.0f, 0.0f);
+	}
+
+	const float2 center_stretch = source.texture_space_stretch(x, y);
+	const int size = source.texture_space_size();
+
+	const float meters_per_unit = world_scale;
+	const float mms_per_unit = 1000.0f * meters_per_unit;
+	const float2 texels_per_mm = float2(1.0f / std::max(center_stretch.x * mms_per_unit, 1.0e-7f), 1.0f / std::max(center_stretch.y * mms_per_unit, 1.0e-7f));
+
+	const float3 S = float3(1.0f, 1.0f, 1.0f) / scattering_distance;
+	const float rotation = 2.0f * float(PI) * subsurface_scattering_texture_space_rotation(x, y);
+	const float cos_rotation = std::cos(rotation);
+	const float sin_rotation = std::sin(rotation);
+
+	float3 sum_numerator(0.0f, 0.0f, 0.0f);
+	float3 sum_denominator(0.0f, 0.0f, 0.0f);
+	for (int sample_index = 0; sample_index < sample_count; ++sample_index)
+	{
+		const float r = kernel[sample_index].r;
+		const float rcp_pdf = kernel[sample_index].rcp_pdf;
+		const float2 direction = kernel[sample_index].direction;
+		const float cos_theta = direction.x * cos_rotation - direction.y * sin_rotation;
+		const float sin_theta = direction.y * cos_rotation + direction.x * sin_rotation;
+
+		// NOTE: the nearest texel, s.t. the position and the irradiance of the sample are those of the same texel
+		const int sample_x = int(std::floor(float(x) + 0.5f + cos_theta * r * texels_per_mm.x));
+		const int sample_y = int(std::floor(float(y) + 0.5f + sin_theta * r * texels_per_mm.y));
+		if ((sample_x < 0) || (sample_x >= size) || (sample_y < 0) || (sample_y >= size))
+		{
+			continue;
+		}
+
+		const float4 sample_irradiance = source.texture_space_irradiance(sample_x, sample_y);
+		if (!(sample_irradiance.w > 0.0f))
+		{
+			continue;
+		}
+
+		// The samples within the center texel keep the sampled radius (the distance between the positions is zero)
+		float r_weight = r;
+		if ((sample_x != x) || (sample_y != y))
+		{
+			const float4 sample_position = source.texture_space_position(sample_x, sample_y);
+			const float3 offset = float3(sample_position.x - center_position.x, sample_position.y - center_position.y, sample_position.z - center_position.z);
+			r_weight = std::max(std::sqrt(dot(offset, offset)) * mms_per_unit, r);
+		}
+
+		const float3 weight = diffusion_profile_evaluate_pdf(S, r_weight) * rcp_pdf;
+		sum_numerator += weight * float3(sample_irradiance.x, sample_irradiance.y, sample_irradiance.z);
+		sum_denominator += weight;
+	}
+
+	// NOTE: the dilated texels (NOT lit) of which all samples are rejected are zero
+	const float4 center_irradiance = source.texture_space_irradiance(x, y);
+	return float3((sum_denominator.x > 0.0f) ? (sum_numerator.x / sum_denominator.x) : center_irradiance.x, (sum_denominator.y > 0.0f) ? (sum_numerator.y / sum_denominator.y) : center_irradiance.y, (sum_denominator.z > 0.0f) ? (sum_numerator.z / sum_denominator.z) : center_irradiance.z);
+}
+
+#endif
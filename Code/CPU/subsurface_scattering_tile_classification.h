@@ -0,0 +1,134 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// C++ counterpart of "Shaders/subsurface_scattering_tile_classification.hlsli"
+//
+// Note: Provided by the User!
+//
+// The "SSS_SOURCE" template parameter replaces the macros of the HLSL version (the "int2" is replaced by the "int x, int y"):
+// float tile_subsurface_mask(int x, int y) const                   <=> SSS_TILE_SUBSURFACE_MASK_SOURCE
+// int tile_profile_index(int x, int y) const                       <=> SSS_TILE_PROFILE_INDEX_SOURCE
+// int tile_screen_width() const / int tile_screen_height() const   <=> SSS_TILE_SCREEN_SIZE
+// uint32_t tile_state(int tile_x, int tile_y) const                <=> SSS_TILE_STATE_SOURCE
+//
+// The "subsurface_scattering_tile_state" only uses the "tile_subsurface_mask", the "tile_profile_index" and the "tile_screen_*".
+//
+
+#ifndef _SUBSURFACE_SCATTERING_TILE_CLASSIFICATION_H_
+#define _SUBSURFACE_SCATTERING_TILE_CLASSIFICATION_H_ 1
+
+#include <algorithm>
+#include <cstdint>
+
+#define SSS_TILE_SIZE 16
+
+#define SSS_TILE_STATE_EMPTY 0
+#define SSS_TILE_STATE_MIXED 1
+#define SSS_TILE_STATE_UNIFORM 2
+
+#define SSS_TILE_CLASS_EMPTY 0
+#define SSS_TILE_CLASS_INTERIOR 1
+#define SSS_TILE_CLASS_EDGE 2
+#define SSS_TILE_CLASS_COUNT 3
+
+#define SSS_TILE_EDGE_FREE_RADIUS_EPSILON (1.0f / 16.0f)
+
+inline int subsurface_scattering_tile_count(int screen_size)
+{
+	return (screen_size + SSS_TILE_SIZE - 1) / SSS_TILE_SIZE;
+}
+
+template <typename SSS_SOURCE>
+inline uint32_t subsurface_scattering_tile_state(const SSS_SOURCE& source, const int tile_x, const int tile_y)
+{
+	const int texel_begin_x = tile_x * SSS_TILE_SIZE;
+	const int texel_begin_y = tile_y * SSS_TILE_SIZE;
+	const int texel_end_x = std::min(texel_begin_x + SSS_TILE_SIZE, source.tile_screen_width());
+	const int texel_end_y = std::min(texel_begin_y + SSS_TILE_SIZE, source.tile_screen_height());
+
+	const int uniform_profile_index = source.tile_profile_index(texel_begin_x, texel_begin_y);
+	bool any_profile = false;
+	bool all_uniform = true;
+	for (int y = texel_begin_y; y < texel_end_y; ++y)
+	{
+		for (int x = texel_begin_x; x < texel_end_x; ++x)
+		{
+			const int profile_index = source.tile_profile_index(x, y);
+			const float subsurface_mask = source.tile_subsurface_mask(x, y);
+			any_profile = any_profile || (profile_index >= 0);
+			all_uniform = all_uniform && (profile_index == uniform_profile_index) && (subsurface_mask >= (1.0f / 255.0f));
+		}
+	}
+
+	return (all_uniform && (uniform_profile_index >= 0)) ? (uint32_t(SSS_TILE_STATE_UNIFORM) + uint32_t(uniform_profile_index)) : (any_profile ? uint32_t(SSS_TILE_STATE_MIXED) : uint32_t(SSS_TILE_STATE_EMPTY));
+}
+
+struct subsurface_scattering_tile_classify_result
+{
+	int tile_class;
+	// Only valid for the SSS_TILE_CLASS_INTERIOR
+	int profile_index;
+	int margin;
+};
+
+template <typename SSS_SOURCE>
+inline subsurface_scattering_tile_classify_result subsurface_scattering_tile_classify(const SSS_SOURCE& source, const int tile_x, const int tile_y)
+{
+	subsurface_scattering_tile_classify_result result = { SSS_TILE_CLASS_EMPTY, 0, 0 };
+
+	const uint32_t state = source.tile_state(tile_x, tile_y);
+	if (uint32_t(SSS_TILE_STATE_EMPTY) == state)
+	{
+		return result;
+	}
+	else if (uint32_t(SSS_TILE_STATE_MIXED) == state)
+	{
+		result.tile_class = SSS_TILE_CLASS_EDGE;
+		return result;
+	}
+
+	const int tile_count_x = subsurface_scattering_tile_count(source.tile_screen_width());
+	const int tile_count_y = subsurface_scattering_tile_count(source.tile_screen_height());
+	result.tile_class = SSS_TILE_CLASS_INTERIOR;
+	result.profile_index = int(state - uint32_t(SSS_TILE_STATE_UNIFORM));
+	result.margin = 1;
+	for (int neighbour_y = std::max(tile_y - 1, 0); neighbour_y <= std::min(tile_y + 1, tile_count_y - 1); ++neighbour_y)
+	{
+		for (int neighbour_x = std::max(tile_x - 1, 0); neighbour_x <= std::min(tile_x + 1, tile_count_x - 1); ++neighbour_x)
+		{
+			if (source.tile_state(neighbour_x, neighbour_y) != state)
+			{
+				result.margin = 0;
+			}
+		}
+	}
+
+	return result;
+}
+
+inline float subsurface_scattering_tile_edge_free_radius(const int texel_x, const int texel_y, const int margin)
+{
+	const int tile_x = texel_x / SSS_TILE_SIZE;
+	const int tile_y = texel_y / SSS_TILE_SIZE;
+	const float center_x = float(texel_x) + 0.5f;
+	const float center_y = float(texel_y) + 0.5f;
+	const float distance_x = std::min(center_x - float((tile_x - margin) * SSS_TILE_SIZE), float((tile_x + 1 + margin) * SSS_TILE_SIZE) - center_x);
+	const float distance_y = std::min(center_y - float((tile_y - margin) * SSS_TILE_SIZE), float((tile_y + 1 + margin) * SSS_TILE_SIZE) - center_y);
+	return std::min(distance_x, distance_y) - SSS_TILE_EDGE_FREE_RADIUS_EPSILON;
+}
+
+#endif
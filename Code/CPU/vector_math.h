@@ -0,0 +1,94 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef _VECTOR_MATH_H_
+#define _VECTOR_MATH_H_ 1
+
+// The minimal subset of the HLSL vector types and intrinsics which is used by the shader code,
+// s.t. the "*.hlsli" can be ported to C++ almost line by line.
+
+#include <cmath>
+#include <algorithm>
+
+struct float2
+{
+	float x;
+	float y;
+
+	inline float2() : x(0.0f), y(0.0f) {}
+	inline float2(float var_x, float var_y) : x(var_x), y(var_y) {}
+};
+
+struct float3
+{
+	float x;
+	float y;
+	float z;
+
+	inline float3() : x(0.0f), y(0.0f), z(0.0f) {}
+	inline explicit float3(float s) : x(s), y(s), z(s) {}
+	inline float3(float var_x, float var_y, float var_z) : x(var_x), y(var_y), z(var_z) {}
+};
+
+struct float4
+{
+	float x;
+	float y;
+	float z;
+	float w;
+
+	inline float4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+	inline float4(float var_x, float var_y, float var_z, float var_w) : x(var_x), y(var_y), z(var_z), w(var_w) {}
+};
+
+// row_major float4x4 (the same memory layout as DirectX::XMFLOAT4X4)
+struct float4x4
+{
+	float m[4][4];
+};
+
+inline float2 operator+(float2 a, float2 b) { return float2(a.x + b.x, a.y + b.y); }
+inline float2 operator-(float2 a, float2 b) { return float2(a.x - b.x, a.y - b.y); }
+inline float2 operator*(float2 a, float2 b) { return float2(a.x * b.x, a.y * b.y); }
+inline float2 operator*(float2 a, float s) { return float2(a.x * s, a.y * s); }
+inline float2 operator*(float s, float2 a) { return float2(s * a.x, s * a.y); }
+inline float2 operator/(float2 a, float2 b) { return float2(a.x / b.x, a.y / b.y); }
+
+inline float3 operator+(float3 a, float3 b) { return float3(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline float3 operator-(float3 a, float3 b) { return float3(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline float3 operator*(float3 a, float3 b) { return float3(a.x * b.x, a.y * b.y, a.z * b.z); }
+inline float3 operator*(float3 a, float s) { return float3(a.x * s, a.y * s, a.z * s); }
+inline float3 operator*(float s, float3 a) { return float3(s * a.x, s * a.y, s * a.z); }
+inline float3 operator/(float3 a, float3 b) { return float3(a.x / b.x, a.y / b.y, a.z / b.z); }
+inline float3 operator/(float3 a, float s) { return float3(a.x / s, a.y / s, a.z / s); }
+inline float3& operator+=(float3& a, float3 b) { a.x += b.x; a.y += b.y; a.z += b.z; return a; }
+
+inline float lerp(float a, float b, float t) { return a + t * (b - a); }
+inline float3 lerp(float3 a, float3 b, float t) { return float3(lerp(a.x, b.x, t), lerp(a.y, b.y, t), lerp(a.z, b.z, t)); }
+inline float3 lerp(float3 a, float3 b, float3 t) { return float3(lerp(a.x, b.x, t.x), lerp(a.y, b.y, t.y), lerp(a.z, b.z, t.z)); }
+
+inline float length(float2 a) { return std::sqrt(a.x * a.x + a.y * a.y); }
+
+inline float dot(float3 a, float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+inline float3 max(float3 a, float3 b) { return float3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)); }
+inline float3 sqrt(float3 a) { return float3(std::sqrt(a.x), std::sqrt(a.y), std::sqrt(a.z)); }
+inline float3 exp2(float3 a) { return float3(std::exp2(a.x), std::exp2(a.y), std::exp2(a.z)); }
+
+inline float saturate(float a) { return std::min(std::max(a, 0.0f), 1.0f); }
+
+#endif
@@ -44,12 +44,14 @@
 #include "FilmGrain.h"
 #include "SkyDome.h"
 #include "Main.h"
+#include "CPU/subsurface_scattering_shadow_thickness.h"
 
 using namespace std;
 
 CDXUTDialogResourceManager dialogResourceManager;
 CDXUTDialog mainHud;
 CDXUTDialog secondaryHud;
+CDXUTDialog featureHud;
 
 Timer* timer;
 CDXUTTextHelper* txtHelper;
@@ -77,9 +79,12 @@ RenderTarget* mainRT;
 RenderTarget* irradianceRT;
 RenderTarget* depthRT;
 RenderTarget* albedoRT;
+RenderTarget* velocityRT;
 DepthStencil* depthStencil;
 
 SSSBlur* sssBlur;
+// Profile 0 is edited by the HUD
+SSSProfileTable sssProfiles;
 FilmGrain* filmGrain;
 
 bool showHud = true;
@@ -148,6 +153,27 @@ Object object = OBJECT_CAMERA;
 #define IDC_LIGHT1_BUTTON 52
 #define IDC_LIGHT1_LABEL (53 + 5)
 #define IDC_LIGHT1 (54 + 5 * 2)
+#define IDC_INVERSE_CDF 70
+#define IDC_KERNEL_CACHE 71
+#define IDC_TRANSMITTANCE_LUT 72
+#define IDC_SEQUENCE 73
+#define IDC_MIS 74
+#define IDC_BLUR_MODE 75
+#define IDC_RESOLUTION 76
+#define IDC_TEMPORAL 77
+#define IDC_SAMPLES_PER_FRAME_LABEL 78
+#define IDC_SAMPLES_PER_FRAME 79
+#define IDC_TILE_CLASSIFICATION 80
+#define IDC_MASK_PYRAMID 81
+#define IDC_IRRADIANCE_PYRAMID 82
+#define IDC_IRRADIANCE_ENCODING 83
+#define IDC_DEPTH_ENCODING 84
+#define IDC_SHADOW_DEPTH 85
+#define IDC_PREINTEGRATED 86
+#define IDC_SSS_LOD 87
+#define IDC_SSS_TEXTURE_SPACE 88
+// In millions
+#define IDC_SAMPLES_PER_FRAME_SLIDER_SCALE 32.0f
 
 void renderText()
 {
@@ -179,6 +205,34 @@ void renderText()
 		s.str(L"");
 		s << *timer;
 		txtHelper->DrawTextLine(s.str().c_str());
+
+		const SSSKernelCache& kernelCache = sssBlur->getKernelCache();
+		s.str(L"");
+		s << "Kernel Cache (bake): " << kernelCache.getHitCount() << " hits, " << kernelCache.getMissCount() << " misses, " << (kernelCache.getMemoryUsage() / 1024U) << " KB, GPU table " << ((sizeof(float4) * SSS_KERNEL_CACHE_GPU_SAMPLE_COUNT) / 1024U) << " KB" << endl;
+		txtHelper->DrawTextLine(s.str().c_str());
+	}
+
+	if (mainHud.GetCheckBox(IDC_SSS_LOD)->GetChecked())
+	{
+		const SSSLodSelector& lodSelector = mainEffect_getLodSelector();
+		for (int tier = 0; tier < SSS_LOD_TIER_COUNT; ++tier)
+		{
+			s.str(L"");
+			s << "SSS LOD " << subsurface_scattering_lod_tier_name(tier) << ": " << lodSelector.getHeadCount(tier) << " heads, " << lodSelector.getPixelCount(tier) << " pixels" << endl;
+			txtHelper->DrawTextLine(s.str().c_str());
+		}
+	}
+
+	if (mainHud.GetCheckBox(IDC_SSS_TEXTURE_SPACE)->GetChecked())
+	{
+		const SSSTextureSpaceCache& textureSpaceCache = mainEffect_getTextureSpaceCache();
+		const uint64_t lookupCount = textureSpaceCache.getHitCount() + textureSpaceCache.getMissCount();
+		s.str(L"");
+		s << "SSS Texture Space: " << textureSpaceCache.getFrameHitCount() << " hits, " << textureSpaceCache.getFrameMissCount() << " misses, " << textureSpaceCache.getFrameFallbackCount() << " fallbacks" << endl;
+		txtHelper->DrawTextLine(s.str().c_str());
+		s.str(L"");
+		s << "SSS Texture Space: " << setprecision(1) << std::fixed << ((lookupCount > 0U) ? (100.0 * double(textureSpaceCache.getHitCount()) / double(lookupCount)) : 0.0) << "% hit rate, " << textureSpaceCache.getEvictionCount() << " evictions, " << (textureSpaceCache.getMemoryUsage() / 1024U) << " / " << (textureSpaceCache.getMemoryBudget() / 1024U) << " KB" << endl;
+		txtHelper->DrawTextLine(s.str().c_str());
 	}
 
 	txtHelper->End();
@@ -196,7 +250,7 @@ void renderScene(ID3D11DeviceContext* context, double, float)
 	// Main Pass
 	d3dPerf->BeginEvent(L"Main Pass");
 
-	mainPass(context, *mainRT, *depthRT, *albedoRT, *irradianceRT, *depthStencil);
+	mainPass(context, *mainRT, *depthRT, *albedoRT, *irradianceRT, *velocityRT, *depthStencil, sssProfiles, sssBlur);
 
 	// Sky dome rendering:
 	{
@@ -215,7 +269,7 @@ void renderScene(ID3D11DeviceContext* context, double, float)
 	d3dPerf->BeginEvent(L"SSS Blur Pass");
 	if (mainHud.GetCheckBox(IDC_SSS)->GetChecked())
 	{
-		sssBlur->go(context, *mainRT, *irradianceRT, *depthRT, *depthStencil, *albedoRT);
+		sssBlur->go(context, *mainRT, *irradianceRT, *depthRT, depthStencil->getReadOnlyDepthStencilView(), depthStencil->getStencilShaderResourceView(), *albedoRT, *velocityRT, sssProfiles);
 	}
 	d3dPerf->EndEvent();
 	timer->clock(context, L"SSS Blur Pass");
@@ -324,30 +378,51 @@ void CALLBACK onFrameRender(ID3D11Device*, ID3D11DeviceContext* context, double
 	if (showHud)
 	{
 		mainHud.OnRender(elapsedTime);
+		featureHud.OnRender(elapsedTime);
 		secondaryHud.OnRender(elapsedTime);
 		renderText();
 	}
 	d3dPerf->EndEvent();
 }
 
+// The index is the SSS_SHADOW_DEPTH_MODE
+void createShadowMaps(ID3D11Device* device)
+{
+	const DXGI_FORMAT linearDepthFormats[SSS_SHADOW_DEPTH_MODE_COUNT] = { DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R16_FLOAT, DXGI_FORMAT_R32_FLOAT };
+	int shadowDepthMode = featureHud.GetComboBox(IDC_SHADOW_DEPTH)->GetSelectedIndex();
+	for (int i = 0; i < N_LIGHTS; i++)
+	{
+		SAFE_DELETE(lights[i].shadowMap);
+		lights[i].shadowMap = new ShadowMap(device, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, linearDepthFormats[shadowDepthMode]);
+	}
+	mainEffect_setShadowDepthMode(shadowDepthMode);
+}
+
 void setupSSS(ID3D11Device* device)
 {
 	int min, max;
-	mainHud.GetSlider(IDC_WORLDSCALE)->GetRange(min, max);
-	float worldScale = IDC_WORLDSCALE_SLIDER_SCALE * float(mainHud.GetSlider(IDC_WORLDSCALE)->GetValue()) / (max - min);
+	mainHud.GetSlider(IDC_NSAMPLES)->GetRange(min, max);
 	bool postscatterEnabled = mainHud.GetCheckBox(IDC_POSTSCATTER)->GetChecked();
 	int nSamples = int(IDC_NSAMPLES_SLIDER_SCALE * float(mainHud.GetSlider(IDC_NSAMPLES)->GetValue()) / (max - min));
-	int nPixelsPerSample = int(IDC_PIXELS_PER_SAMPLE_SLIDER_SCALE * float(mainHud.GetSlider(IDC_PIXELS_PER_SAMPLE)->GetValue()) / (max - min));
+	int nPixelsPerSample = int(IDC_PIXELS_PER_SAMPLE_SLIDER_SCALE * float(featureHud.GetSlider(IDC_PIXELS_PER_SAMPLE)->GetValue()) / (max - min));
+	int nSamplesPerFrame = int(1000000.0f * IDC_SAMPLES_PER_FRAME_SLIDER_SCALE * float(mainHud.GetSlider(IDC_SAMPLES_PER_FRAME)->GetValue()) / (max - min));
 
 	SAFE_DELETE(sssBlur);
-	sssBlur = new SSSBlur(device, worldScale, postscatterEnabled, nSamples, nPixelsPerSample);
-
-	DirectX::XMFLOAT3 strength;
-	mainHud.GetSlider(IDC_SCATTERINGDISTANCE_R)->GetRange(min, max);
-	strength.x = float(mainHud.GetSlider(IDC_SCATTERINGDISTANCE_R)->GetValue()) / (max - min);
-	strength.y = float(mainHud.GetSlider(IDC_SCATTERINGDISTANCE_G)->GetValue()) / (max - min);
-	strength.z = float(mainHud.GetSlider(IDC_SCATTERINGDISTANCE_B)->GetValue()) / (max - min);
-	sssBlur->setStrength(strength);
+	sssBlur = new SSSBlur(device, postscatterEnabled, nSamples, nPixelsPerSample);
+
+	sssBlur->setSamplesPerFrame(nSamplesPerFrame);
+
+	sssBlur->setInverseCdfMode(featureHud.GetComboBox(IDC_INVERSE_CDF)->GetSelectedIndex());
+	sssBlur->setKernelCacheEnabled(featureHud.GetCheckBox(IDC_KERNEL_CACHE)->GetChecked());
+	sssBlur->setSequence(featureHud.GetComboBox(IDC_SEQUENCE)->GetSelectedIndex());
+	sssBlur->setMisMode(featureHud.GetComboBox(IDC_MIS)->GetSelectedIndex());
+	sssBlur->setBlurMode(featureHud.GetComboBox(IDC_BLUR_MODE)->GetSelectedIndex());
+	sssBlur->getUpsampler().setResolutionFactor(1 << featureHud.GetComboBox(IDC_RESOLUTION)->GetSelectedIndex());
+	sssBlur->getTemporalResolve().setEnabled(featureHud.GetCheckBox(IDC_TEMPORAL)->GetChecked());
+	sssBlur->getTileClassifier().setEnabled(featureHud.GetCheckBox(IDC_TILE_CLASSIFICATION)->GetChecked());
+	sssBlur->getMaskPyramidBuilder().setEnabled(featureHud.GetCheckBox(IDC_MASK_PYRAMID)->GetChecked());
+	sssBlur->getIrradiancePyramidBuilder().setEnabled(featureHud.GetCheckBox(IDC_IRRADIANCE_PYRAMID)->GetChecked());
+	sssBlur->setGBufferEncoding(featureHud.GetComboBox(IDC_IRRADIANCE_ENCODING)->GetSelectedIndex(), featureHud.GetComboBox(IDC_DEPTH_ENCODING)->GetSelectedIndex());
 }
 
 Camera* currentObject()
@@ -434,6 +509,11 @@ LRESULT CALLBACK msgProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam, bool
 		{
 			return 0;
 		}
+
+		if ((*pbNoFurtherProcessing) = featureHud.MsgProc(hwnd, msg, wparam, lparam))
+		{
+			return 0;
+		}
 	}
 
 	return currentObject()->handleMessages(hwnd, msg, wparam, lparam);
@@ -450,10 +530,20 @@ HRESULT CALLBACK onResizedSwapChain(ID3D11Device* device, IDXGISwapChain* swapCh
 	backbufferRT = new BackbufferRenderTarget(device, swapChain);
 	mainRT = new RenderTarget(device, desc->Width, desc->Height, format);
 
-	depthRT = new RenderTarget(device, desc->Width, desc->Height, DXGI_FORMAT_R32_FLOAT);
-	irradianceRT = new RenderTarget(device, desc->Width, desc->Height, format);
+	// The index is the SSS_IRRADIANCE_ENCODING / SSS_DEPTH_ENCODING
+	// NOTE: the RGB9E5 can NOT be rendered, and is packed into the R16G16_UNORM (see "subsurface_scattering_gbuffer_encoding.hlsli")
+	const DXGI_FORMAT irradianceFormats[SSS_IRRADIANCE_ENCODING_COUNT] = { format, DXGI_FORMAT_R11G11B10_FLOAT, DXGI_FORMAT_R16G16_UNORM, DXGI_FORMAT_R16G16_FLOAT };
+	const DXGI_FORMAT depthFormats[SSS_DEPTH_ENCODING_COUNT] = { DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R16_UNORM, DXGI_FORMAT_R16_FLOAT, DXGI_FORMAT_R32_FLOAT };
+	int irradianceEncoding = featureHud.GetComboBox(IDC_IRRADIANCE_ENCODING)->GetSelectedIndex();
+	int depthEncoding = featureHud.GetComboBox(IDC_DEPTH_ENCODING)->GetSelectedIndex();
+	mainEffect_setGBufferEncoding(irradianceEncoding, depthEncoding);
+
+	depthRT = new RenderTarget(device, desc->Width, desc->Height, depthFormats[depthEncoding]);
+	irradianceRT = new RenderTarget(device, desc->Width, desc->Height, irradianceFormats[irradianceEncoding]);
 	albedoRT = new RenderTarget(device, desc->Width, desc->Height, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB);
-	depthStencil = new DepthStencil(device, desc->Width, desc->Height, DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_D24_UNORM_S8_UINT, DXGI_FORMAT_R24_UNORM_X8_TYPELESS);
+	// uv_curr - uv_prev
+	velocityRT = new RenderTarget(device, desc->Width, desc->Height, DXGI_FORMAT_R16G16_FLOAT);
+	depthStencil = new DepthStencil(device, desc->Width, desc->Height, DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_D24_UNORM_S8_UINT, DXGI_FORMAT_R24_UNORM_X8_TYPELESS, NoMSAA(), DXGI_FORMAT_X24_TYPELESS_G8_UINT);
 
 	float aspect = (float)desc->Width / desc->Height;
 	camera.setProjection(CAMERA_FOV * DirectX::XM_PI / 180.f, aspect, 0.1f, 100.0f);
@@ -467,6 +557,7 @@ HRESULT CALLBACK onResizedSwapChain(ID3D11Device* device, IDXGISwapChain* swapCh
 		lights[i].camera.setViewportSize(DirectX::XMFLOAT2((float)desc->Width, (float)desc->Height));
 
 	mainHud.SetLocation(desc->Width - (45 + HUD_WIDTH), 0);
+	featureHud.SetLocation(desc->Width - 2 * (45 + HUD_WIDTH), 0);
 	secondaryHud.SetLocation(0, desc->Height - 520);
 
 	if (!loaded)
@@ -488,6 +579,7 @@ void CALLBACK onReleasingSwapChain(void*)
 	SAFE_DELETE(depthRT);
 	SAFE_DELETE(irradianceRT);
 	SAFE_DELETE(albedoRT);
+	SAFE_DELETE(velocityRT);
 	SAFE_DELETE(depthStencil);
 
 	SAFE_DELETE(sssBlur);
@@ -517,6 +609,24 @@ void CALLBACK onGUIEvent(UINT event, int id, CDXUTControl*, void*)
 		mainEffect_setPostScatterEnabled(postscatterEnabled);
 		break;
 	}
+	case IDC_PREINTEGRATED:
+	{
+		bool preintegratedEnabled = mainHud.GetCheckBox(IDC_PREINTEGRATED)->GetChecked();
+		mainEffect_setPreintegratedEnabled(preintegratedEnabled);
+		break;
+	}
+	case IDC_SSS_LOD:
+	{
+		bool lodEnabled = mainHud.GetCheckBox(IDC_SSS_LOD)->GetChecked();
+		mainEffect_setLodEnabled(lodEnabled);
+		break;
+	}
+	case IDC_SSS_TEXTURE_SPACE:
+	{
+		bool textureSpaceEnabled = mainHud.GetCheckBox(IDC_SSS_TEXTURE_SPACE)->GetChecked();
+		mainEffect_setTextureSpaceEnabled(textureSpaceEnabled);
+		break;
+	}
 	case IDC_HDR:
 	{
 		if (event == EVENT_CHECKBOX_CHANGED)
@@ -554,50 +664,164 @@ void CALLBACK onGUIEvent(UINT event, int id, CDXUTControl*, void*)
 		sssBlur->setNSamples(nSamples);
 		break;
 	}
+	case IDC_SAMPLES_PER_FRAME:
+	{
+		int min, max;
+		mainHud.GetSlider(IDC_SAMPLES_PER_FRAME)->GetRange(min, max);
+		float value = IDC_SAMPLES_PER_FRAME_SLIDER_SCALE * float(mainHud.GetSlider(IDC_SAMPLES_PER_FRAME)->GetValue()) / (max - min);
+		int nSamplesPerFrame = int(1000000.0f * value);
+
+		// 0 disables the adaptive sampling
+		wstringstream s;
+		if (nSamplesPerFrame > 0)
+		{
+			s << L"Samples Per Frame: " << value << L"M";
+		}
+		else
+		{
+			s << L"Samples Per Frame: Off";
+		}
+		mainHud.GetStatic(IDC_SAMPLES_PER_FRAME_LABEL)->SetText(s.str().c_str());
+
+		sssBlur->setSamplesPerFrame(nSamplesPerFrame);
+		break;
+	}
 	case IDC_WORLDSCALE:
 	{
 		float value = updateSlider(mainHud, IDC_WORLDSCALE, IDC_WORLDSCALE_LABEL, IDC_WORLDSCALE_SLIDER_SCALE, L"World Scale: ");
-		sssBlur->setWorldScale(value);
-		mainEffect_setWorldScale(value);
+		sssProfiles.setWorldScale(0, value);
 		break;
 	}
 	case IDC_SCATTERINGDISTANCE_R:
 	case IDC_SCATTERINGDISTANCE_G:
 	case IDC_SCATTERINGDISTANCE_B:
 	{
-		DirectX::XMFLOAT3 scatteringDistance;
+		float3 scatteringDistance;
 		scatteringDistance.x = updateSlider(mainHud, IDC_SCATTERINGDISTANCE_R, IDC_SCATTERINGDISTANC_R_LABEL, 1.0f, L"R: ");
 		scatteringDistance.y = updateSlider(mainHud, IDC_SCATTERINGDISTANCE_G, IDC_SCATTERINGDISTANC_G_LABEL, 1.0f, L"G: ");
 		scatteringDistance.z = updateSlider(mainHud, IDC_SCATTERINGDISTANCE_B, IDC_SCATTERINGDISTANC_B_LABEL, 1.0f, L"B: ");
-		sssBlur->setStrength(scatteringDistance);
-		mainEffect_setScatteringDistance(scatteringDistance);
+		sssProfiles.setScatteringDistance(0, scatteringDistance);
 		break;
 	}
 	case IDC_TRANSMITTANCETINT_R:
 	case IDC_TRANSMITTANCETINT_G:
 	case IDC_TRANSMITTANCETINT_B:
 	{
-		DirectX::XMFLOAT3 transmittanceTint;
-		transmittanceTint.x = updateSlider(mainHud, IDC_TRANSMITTANCETINT_R, IDC_TRANSMITTANCETINT_R_LABEL, 1.0f, L"R: ");
-		transmittanceTint.y = updateSlider(mainHud, IDC_TRANSMITTANCETINT_G, IDC_TRANSMITTANCETINT_G_LABEL, 1.0f, L"G: ");
-		transmittanceTint.z = updateSlider(mainHud, IDC_TRANSMITTANCETINT_B, IDC_TRANSMITTANCETINT_B_LABEL, 1.0f, L"B: ");
-		mainEffect_setTransmittanceTint(transmittanceTint);
+		float3 transmittanceTint;
+		transmittanceTint.x = updateSlider(featureHud, IDC_TRANSMITTANCETINT_R, IDC_TRANSMITTANCETINT_R_LABEL, 1.0f, L"R: ");
+		transmittanceTint.y = updateSlider(featureHud, IDC_TRANSMITTANCETINT_G, IDC_TRANSMITTANCETINT_G_LABEL, 1.0f, L"G: ");
+		transmittanceTint.z = updateSlider(featureHud, IDC_TRANSMITTANCETINT_B, IDC_TRANSMITTANCETINT_B_LABEL, 1.0f, L"B: ");
+		sssProfiles.setTransmittanceTint(0, transmittanceTint);
 		break;
 	}
 	case IDC_PIXELS_PER_SAMPLE:
 	{
 		int min, max;
-		mainHud.GetSlider(IDC_PIXELS_PER_SAMPLE)->GetRange(min, max);
-		float value = IDC_PIXELS_PER_SAMPLE_SLIDER_SCALE * float(mainHud.GetSlider(IDC_PIXELS_PER_SAMPLE)->GetValue()) / (max - min);
+		featureHud.GetSlider(IDC_PIXELS_PER_SAMPLE)->GetRange(min, max);
+		float value = IDC_PIXELS_PER_SAMPLE_SLIDER_SCALE * float(featureHud.GetSlider(IDC_PIXELS_PER_SAMPLE)->GetValue()) / (max - min);
 		int PixelsPerSample = int(value);
 
 		wstringstream s;
 		s << L"Pixels Per Sample: " << PixelsPerSample;
-		mainHud.GetStatic(IDC_PIXELS_PER_SAMPLE_LABEL)->SetText(s.str().c_str());
+		featureHud.GetStatic(IDC_PIXELS_PER_SAMPLE_LABEL)->SetText(s.str().c_str());
 
 		sssBlur->setPixelsPerSample(PixelsPerSample);
 		break;
 	}
+	case IDC_INVERSE_CDF:
+	{
+		if (event == EVENT_COMBOBOX_SELECTION_CHANGED)
+		{
+			sssBlur->setInverseCdfMode(featureHud.GetComboBox(IDC_INVERSE_CDF)->GetSelectedIndex());
+		}
+		break;
+	}
+	case IDC_KERNEL_CACHE:
+	{
+		sssBlur->setKernelCacheEnabled(featureHud.GetCheckBox(IDC_KERNEL_CACHE)->GetChecked());
+		break;
+	}
+	case IDC_SEQUENCE:
+	{
+		if (event == EVENT_COMBOBOX_SELECTION_CHANGED)
+		{
+			sssBlur->setSequence(featureHud.GetComboBox(IDC_SEQUENCE)->GetSelectedIndex());
+		}
+		break;
+	}
+	case IDC_MIS:
+	{
+		if (event == EVENT_COMBOBOX_SELECTION_CHANGED)
+		{
+			sssBlur->setMisMode(featureHud.GetComboBox(IDC_MIS)->GetSelectedIndex());
+		}
+		break;
+	}
+	case IDC_BLUR_MODE:
+	{
+		if (event == EVENT_COMBOBOX_SELECTION_CHANGED)
+		{
+			sssBlur->setBlurMode(featureHud.GetComboBox(IDC_BLUR_MODE)->GetSelectedIndex());
+		}
+		break;
+	}
+	case IDC_RESOLUTION:
+	{
+		if (event == EVENT_COMBOBOX_SELECTION_CHANGED)
+		{
+			sssBlur->getUpsampler().setResolutionFactor(1 << featureHud.GetComboBox(IDC_RESOLUTION)->GetSelectedIndex());
+		}
+		break;
+	}
+	case IDC_TEMPORAL:
+	{
+		sssBlur->getTemporalResolve().setEnabled(featureHud.GetCheckBox(IDC_TEMPORAL)->GetChecked());
+		break;
+	}
+	case IDC_TILE_CLASSIFICATION:
+	{
+		sssBlur->getTileClassifier().setEnabled(featureHud.GetCheckBox(IDC_TILE_CLASSIFICATION)->GetChecked());
+		break;
+	}
+	case IDC_MASK_PYRAMID:
+	{
+		sssBlur->getMaskPyramidBuilder().setEnabled(featureHud.GetCheckBox(IDC_MASK_PYRAMID)->GetChecked());
+		break;
+	}
+	case IDC_IRRADIANCE_PYRAMID:
+	{
+		sssBlur->getIrradiancePyramidBuilder().setEnabled(featureHud.GetCheckBox(IDC_IRRADIANCE_PYRAMID)->GetChecked());
+		break;
+	}
+	case IDC_SHADOW_DEPTH:
+	{
+		if (event == EVENT_COMBOBOX_SELECTION_CHANGED)
+		{
+			createShadowMaps(DXUTGetD3D11Device());
+		}
+		break;
+	}
+	case IDC_IRRADIANCE_ENCODING:
+	case IDC_DEPTH_ENCODING:
+	{
+		// The render targets are recreated with the format of the encoding
+		if (event == EVENT_COMBOBOX_SELECTION_CHANGED)
+		{
+			onReleasingSwapChain(NULL);
+			onResizedSwapChain(DXUTGetD3D11Device(), DXUTGetDXGISwapChain(), DXUTGetDXGIBackBufferSurfaceDesc(), NULL);
+		}
+		break;
+	}
+	case IDC_TRANSMITTANCE_LUT:
+	{
+		if (event == EVENT_COMBOBOX_SELECTION_CHANGED)
+		{
+			int transmittanceMode = featureHud.GetComboBox(IDC_TRANSMITTANCE_LUT)->GetSelectedIndex();
+			mainEffect_setTransmittanceLUTEnabled(0 != transmittanceMode);
+			mainEffect_setTransmittanceLUTExtended(2 == transmittanceMode);
+		}
+		break;
+	}
 	case IDC_SPEC_INTENSITY:
 	{
 		float value = updateSlider(secondaryHud, IDC_SPEC_INTENSITY, IDC_SPEC_INTENSITY_LABEL, 4.0f, L"Spec. Intensity: ");
@@ -710,29 +934,42 @@ HRESULT CALLBACK onCreateDevice(ID3D11Device* device, const DXGI_SURFACE_DESC*,
 	bool sssEnabled = mainHud.GetCheckBox(IDC_SSS)->GetChecked();
 	mainEffect_setSSSEnabled(sssEnabled);
 
+	bool preintegratedEnabled = mainHud.GetCheckBox(IDC_PREINTEGRATED)->GetChecked();
+	mainEffect_setPreintegratedEnabled(preintegratedEnabled);
+
+	bool lodEnabled = mainHud.GetCheckBox(IDC_SSS_LOD)->GetChecked();
+	mainEffect_setLodEnabled(lodEnabled);
+
+	bool textureSpaceEnabled = mainHud.GetCheckBox(IDC_SSS_TEXTURE_SPACE)->GetChecked();
+	mainEffect_setTextureSpaceEnabled(textureSpaceEnabled);
+
 	int min;
 	int max;
 	mainHud.GetSlider(IDC_WORLDSCALE)->GetRange(min, max);
 	float worldScale = IDC_WORLDSCALE_SLIDER_SCALE * float(mainHud.GetSlider(IDC_WORLDSCALE)->GetValue()) / (max - min);
-	mainEffect_setWorldScale(worldScale);
+	sssProfiles.setWorldScale(0, worldScale);
 
-	DirectX::XMFLOAT3 scatteringDistance;
+	float3 scatteringDistance;
 	mainHud.GetSlider(IDC_SCATTERINGDISTANCE_R)->GetRange(min, max);
 	scatteringDistance.x = float(mainHud.GetSlider(IDC_SCATTERINGDISTANCE_R)->GetValue()) / (max - min);
 	mainHud.GetSlider(IDC_SCATTERINGDISTANCE_G)->GetRange(min, max);
 	scatteringDistance.y = float(mainHud.GetSlider(IDC_SCATTERINGDISTANCE_G)->GetValue()) / (max - min);
 	mainHud.GetSlider(IDC_SCATTERINGDISTANCE_B)->GetRange(min, max);
 	scatteringDistance.z = float(mainHud.GetSlider(IDC_SCATTERINGDISTANCE_B)->GetValue()) / (max - min);
-	mainEffect_setScatteringDistance(scatteringDistance);
+	sssProfiles.setScatteringDistance(0, scatteringDistance);
 
-	DirectX::XMFLOAT3 transmittanceTint;
-	mainHud.GetSlider(IDC_TRANSMITTANCETINT_R)->GetRange(min, max);
-	transmittanceTint.x = float(mainHud.GetSlider(IDC_TRANSMITTANCETINT_R)->GetValue()) / (max - min);
-	mainHud.GetSlider(IDC_TRANSMITTANCETINT_G)->GetRange(min, max);
-	transmittanceTint.y = float(mainHud.GetSlider(IDC_TRANSMITTANCETINT_G)->GetValue()) / (max - min);
-	mainHud.GetSlider(IDC_TRANSMITTANCETINT_B)->GetRange(min, max);
-	transmittanceTint.z = float(mainHud.GetSlider(IDC_TRANSMITTANCETINT_B)->GetValue()) / (max - min);
-	mainEffect_setTransmittanceTint(transmittanceTint);
+	float3 transmittanceTint;
+	featureHud.GetSlider(IDC_TRANSMITTANCETINT_R)->GetRange(min, max);
+	transmittanceTint.x = float(featureHud.GetSlider(IDC_TRANSMITTANCETINT_R)->GetValue()) / (max - min);
+	featureHud.GetSlider(IDC_TRANSMITTANCETINT_G)->GetRange(min, max);
+	transmittanceTint.y = float(featureHud.GetSlider(IDC_TRANSMITTANCETINT_G)->GetValue()) / (max - min);
+	featureHud.GetSlider(IDC_TRANSMITTANCETINT_B)->GetRange(min, max);
+	transmittanceTint.z = float(featureHud.GetSlider(IDC_TRANSMITTANCETINT_B)->GetValue()) / (max - min);
+	sssProfiles.setTransmittanceTint(0, transmittanceTint);
+
+	int transmittanceMode = featureHud.GetComboBox(IDC_TRANSMITTANCE_LUT)->GetSelectedIndex();
+	mainEffect_setTransmittanceLUTEnabled(0 != transmittanceMode);
+	mainEffect_setTransmittanceLUTExtended(2 == transmittanceMode);
 
 	secondaryHud.GetSlider(IDC_SPEC_INTENSITY)->GetRange(min, max);
 	float specularIntensity = float(secondaryHud.GetSlider(IDC_SPEC_INTENSITY)->GetValue()) / (max - min);
@@ -765,8 +1002,8 @@ HRESULT CALLBACK onCreateDevice(ID3D11Device* device, const DXGI_SURFACE_DESC*,
 		lights[i].camera.setDistance(2.0);
 		lights[i].camera.setProjection(lights[i].fov, 1.0f, 0.1f, lights[i].farPlane);
 		lights[i].color = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
-		lights[i].shadowMap = new ShadowMap(device, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
 	}
+	createShadowMaps(device);
 
 	skyDome[0] = new SkyDome(device, L"Enviroment\\StPeters", 0.0f);
 	skyDome[1] = new SkyDome(device, L"Enviroment\\Grace", 0.0f);
@@ -811,6 +1048,9 @@ void initApp()
 	secondaryHud.Init(&dialogResourceManager);
 	secondaryHud.SetCallback(onGUIEvent);
 
+	featureHud.Init(&dialogResourceManager);
+	featureHud.SetCallback(onGUIEvent);
+
 	/**
 	 * Create main hud (the one on the right)
 	 */
@@ -825,10 +1065,15 @@ void initApp()
 	iY += 15;
 	mainHud.AddCheckBox(IDC_SSS, L"SSS Rendering", 35, iY += 24, HUD_WIDTH, 22, true);
 	mainHud.AddCheckBox(IDC_POSTSCATTER, L"Post-Scatter", 35, iY += 24, HUD_WIDTH, 22, false);
+	mainHud.AddCheckBox(IDC_PREINTEGRATED, L"Pre-Integrated LUT", 35, iY += 24, HUD_WIDTH, 22, false);
+	mainHud.AddCheckBox(IDC_SSS_LOD, L"SSS LOD", 35, iY += 24, HUD_WIDTH, 22, false);
+	mainHud.AddCheckBox(IDC_SSS_TEXTURE_SPACE, L"SSS Texture Space", 35, iY += 24, HUD_WIDTH, 22, false);
 
 	iY += 15;
 	mainHud.AddStatic(IDC_NSAMPLES_LABEL, L"Samples: 16", 35, iY += 24, HUD_WIDTH, 22);
 	mainHud.AddSlider(IDC_NSAMPLES, 35, iY += 24, HUD_WIDTH, 22, 0, 100, int((16.0f / IDC_NSAMPLES_SLIDER_SCALE) * 100.0f));
+	mainHud.AddStatic(IDC_SAMPLES_PER_FRAME_LABEL, L"Samples Per Frame: Off", 35, iY += 24, HUD_WIDTH, 22);
+	mainHud.AddSlider(IDC_SAMPLES_PER_FRAME, 35, iY += 24, HUD_WIDTH, 22, 0, 100, 0);
 	mainHud.AddStatic(IDC_WORLDSCALE_LABEL, L"World Scale: 0.125", 35, iY += 24, HUD_WIDTH, 22);
 	mainHud.AddSlider(IDC_WORLDSCALE, 35, iY += 24, HUD_WIDTH, 22, 0, 100, int((0.125f / IDC_WORLDSCALE_SLIDER_SCALE) * 100.0f));
 
@@ -842,19 +1087,94 @@ void initApp()
 	mainHud.AddStatic(IDC_SCATTERINGDISTANC_B_LABEL, L"B: 0.20", 35, iY += 24, 50, 22);
 	mainHud.AddSlider(IDC_SCATTERINGDISTANCE_B, 80, iY, HUD_WIDTH - 45, 22, 0, 100, int(0.20000002f * 100.0f));
 
+	/**
+	 * Create the transmittance and features hud (the one left of the main hud,
+	 * so that every control fits in 1280x720)
+	 */
+	iY = 10;
+
 	iY += 15;
 	// Runtime/RenderPipelineResources/Skin Diffusion Profile.asset
-	mainHud.AddStatic(IDC_TRANSMITTANCETINT_LABEL, L"Transmittance Tint", 35, iY += 24, HUD_WIDTH, 22);
-	mainHud.AddStatic(IDC_TRANSMITTANCETINT_R_LABEL, L"R: 0.76", 35, iY += 24, 50, 22);
-	mainHud.AddSlider(IDC_TRANSMITTANCETINT_R, 80, iY, HUD_WIDTH - 45, 22, 0, 100, int(0.7568628f * 100.0f));
-	mainHud.AddStatic(IDC_TRANSMITTANCETINT_G_LABEL, L"G: 0.32", 35, iY += 24, 50, 22);
-	mainHud.AddSlider(IDC_TRANSMITTANCETINT_G, 80, iY, HUD_WIDTH - 45, 22, 0, 100, int(0.32156864f * 100.0f));
-	mainHud.AddStatic(IDC_TRANSMITTANCETINT_B_LABEL, L"B: 0.20", 35, iY += 24, 50, 22);
-	mainHud.AddSlider(IDC_TRANSMITTANCETINT_B, 80, iY, HUD_WIDTH - 45, 22, 0, 100, int(0.20000002f * 100.0f));
+	featureHud.AddStatic(IDC_TRANSMITTANCETINT_LABEL, L"Transmittance Tint", 35, iY += 24, HUD_WIDTH, 22);
+	featureHud.AddStatic(IDC_TRANSMITTANCETINT_R_LABEL, L"R: 0.76", 35, iY += 24, 50, 22);
+	featureHud.AddSlider(IDC_TRANSMITTANCETINT_R, 80, iY, HUD_WIDTH - 45, 22, 0, 100, int(0.7568628f * 100.0f));
+	featureHud.AddStatic(IDC_TRANSMITTANCETINT_G_LABEL, L"G: 0.32", 35, iY += 24, 50, 22);
+	featureHud.AddSlider(IDC_TRANSMITTANCETINT_G, 80, iY, HUD_WIDTH - 45, 22, 0, 100, int(0.32156864f * 100.0f));
+	featureHud.AddStatic(IDC_TRANSMITTANCETINT_B_LABEL, L"B: 0.20", 35, iY += 24, 50, 22);
+	featureHud.AddSlider(IDC_TRANSMITTANCETINT_B, 80, iY, HUD_WIDTH - 45, 22, 0, 100, int(0.20000002f * 100.0f));
+
+	iY += 15;
+	featureHud.AddStatic(IDC_PIXELS_PER_SAMPLE_LABEL, L"Pixels Per Sample: 4", 25, iY += 24, HUD_WIDTH, 22);
+	featureHud.AddSlider(IDC_PIXELS_PER_SAMPLE, 35, iY += 24, HUD_WIDTH, 22, 0, 100, int((4.0f / IDC_NSAMPLES_SLIDER_SCALE) * 100.0f));
 
 	iY += 15;
-	mainHud.AddStatic(IDC_PIXELS_PER_SAMPLE_LABEL, L"Pixels Per Sample: 4", 25, iY += 24, HUD_WIDTH, 22);
-	mainHud.AddSlider(IDC_PIXELS_PER_SAMPLE, 35, iY += 24, HUD_WIDTH, 22, 0, 100, int((4.0f / IDC_NSAMPLES_SLIDER_SCALE) * 100.0f));
+	CDXUTComboBox* inverseCdfComboBox = NULL;
+	featureHud.AddComboBox(IDC_INVERSE_CDF, 35, iY += 24, HUD_WIDTH, 22, 0, false, &inverseCdfComboBox);
+	// The index is the SSS_INVERSE_CDF_MODE
+	inverseCdfComboBox->AddItem(L"Inverse CDF: Analytic", NULL);
+	inverseCdfComboBox->AddItem(L"Inverse CDF: LUT Linear", NULL);
+	inverseCdfComboBox->AddItem(L"Inverse CDF: LUT Hermite", NULL);
+	inverseCdfComboBox->SetSelectedByIndex(0);
+	featureHud.AddCheckBox(IDC_KERNEL_CACHE, L"Kernel Cache", 35, iY += 24, HUD_WIDTH, 22, false);
+	CDXUTComboBox* sequenceComboBox = NULL;
+	featureHud.AddComboBox(IDC_SEQUENCE, 35, iY += 24, HUD_WIDTH, 22, 0, false, &sequenceComboBox);
+	// The index is the LOW_DISCREPANCY_SEQUENCE
+	sequenceComboBox->AddItem(L"Sequence: Hammersley", NULL);
+	sequenceComboBox->AddItem(L"Sequence: Fibonacci", NULL);
+	sequenceComboBox->AddItem(L"Sequence: R2", NULL);
+	sequenceComboBox->AddItem(L"Sequence: Sobol (Owen)", NULL);
+	sequenceComboBox->AddItem(L"Sequence: Blue Noise", NULL);
+	sequenceComboBox->SetSelectedByIndex(0);
+	CDXUTComboBox* misComboBox = NULL;
+	featureHud.AddComboBox(IDC_MIS, 35, iY += 24, HUD_WIDTH, 22, 0, false, &misComboBox);
+	// The index is the SSS_MIS_MODE
+	misComboBox->AddItem(L"MIS: None", NULL);
+	misComboBox->AddItem(L"MIS: Balance", NULL);
+	misComboBox->AddItem(L"MIS: Power", NULL);
+	misComboBox->SetSelectedByIndex(0);
+	CDXUTComboBox* blurModeComboBox = NULL;
+	featureHud.AddComboBox(IDC_BLUR_MODE, 35, iY += 24, HUD_WIDTH, 22, 0, false, &blurModeComboBox);
+	// The index is the SSS_BLUR_MODE
+	blurModeComboBox->AddItem(L"Blur: Burley", NULL);
+	blurModeComboBox->AddItem(L"Blur: Separable", NULL);
+	blurModeComboBox->SetSelectedByIndex(0);
+	CDXUTComboBox* resolutionComboBox = NULL;
+	featureHud.AddComboBox(IDC_RESOLUTION, 35, iY += 24, HUD_WIDTH, 22, 0, false, &resolutionComboBox);
+	// The factor is "1 << index" (SSS_RESOLUTION_FACTOR)
+	resolutionComboBox->AddItem(L"Resolution: Full", NULL);
+	resolutionComboBox->AddItem(L"Resolution: Half", NULL);
+	resolutionComboBox->AddItem(L"Resolution: Quarter", NULL);
+	resolutionComboBox->SetSelectedByIndex(0);
+	featureHud.AddCheckBox(IDC_TEMPORAL, L"Temporal Accumulation", 35, iY += 24, HUD_WIDTH, 22, false);
+	featureHud.AddCheckBox(IDC_TILE_CLASSIFICATION, L"Tile Classification", 35, iY += 24, HUD_WIDTH, 22, true);
+	featureHud.AddCheckBox(IDC_MASK_PYRAMID, L"Mask Pyramid", 35, iY += 24, HUD_WIDTH, 22, true);
+	featureHud.AddCheckBox(IDC_IRRADIANCE_PYRAMID, L"Irradiance Pyramid", 35, iY += 24, HUD_WIDTH, 22, false);
+	CDXUTComboBox* irradianceEncodingComboBox = NULL;
+	featureHud.AddComboBox(IDC_IRRADIANCE_ENCODING, 35, iY += 24, HUD_WIDTH, 22, 0, false, &irradianceEncodingComboBox);
+	irradianceEncodingComboBox->AddItem(L"Irradiance: RGBA16F", NULL);
+	irradianceEncodingComboBox->AddItem(L"Irradiance: R11G11B10F", NULL);
+	irradianceEncodingComboBox->AddItem(L"Irradiance: RGB9E5", NULL);
+	irradianceEncodingComboBox->AddItem(L"Irradiance: YCoCg", NULL);
+	irradianceEncodingComboBox->SetSelectedByIndex(0);
+	CDXUTComboBox* depthEncodingComboBox = NULL;
+	featureHud.AddComboBox(IDC_DEPTH_ENCODING, 35, iY += 24, HUD_WIDTH, 22, 0, false, &depthEncodingComboBox);
+	depthEncodingComboBox->AddItem(L"Depth: NDC R32F", NULL);
+	depthEncodingComboBox->AddItem(L"Depth: Linear R16", NULL);
+	depthEncodingComboBox->AddItem(L"Depth: View Z R16F", NULL);
+	depthEncodingComboBox->AddItem(L"Depth: View Z R32F", NULL);
+	depthEncodingComboBox->SetSelectedByIndex(0);
+	CDXUTComboBox* shadowDepthComboBox = NULL;
+	featureHud.AddComboBox(IDC_SHADOW_DEPTH, 35, iY += 24, HUD_WIDTH, 22, 0, false, &shadowDepthComboBox);
+	shadowDepthComboBox->AddItem(L"Shadow Depth: NDC R32F", NULL);
+	shadowDepthComboBox->AddItem(L"Shadow Depth: Linear R16F", NULL);
+	shadowDepthComboBox->AddItem(L"Shadow Depth: Linear R32F", NULL);
+	shadowDepthComboBox->SetSelectedByIndex(0);
+	CDXUTComboBox* transmittanceComboBox = NULL;
+	featureHud.AddComboBox(IDC_TRANSMITTANCE_LUT, 35, iY += 24, HUD_WIDTH, 22, 0, false, &transmittanceComboBox);
+	transmittanceComboBox->AddItem(L"Transmittance: Analytic", NULL);
+	transmittanceComboBox->AddItem(L"Transmittance: LUT", NULL);
+	transmittanceComboBox->AddItem(L"Transmittance: LUT Extended", NULL);
+	transmittanceComboBox->SetSelectedByIndex(1);
 
 	/**
 	 * Create the speculars and light step hud (the one on the left)
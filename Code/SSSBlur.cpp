@@ -16,40 +16,116 @@
 //
 
 #include <sstream>
+#include <vector>
 #include "SSSBlur.h"
 #include "Demo.h"
+#include "CPU/diffusion_profile_inverse_cdf_lut.h"
+#include "CPU/subsurface_scattering_disney_blur.h"
+#include "CPU/subsurface_scattering_texture_space.h"
 
 #include "../../dxbc/SSS_Blur_VS_bytecode.inl"
 #include "../../dxbc/SSS_Blur_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_SeparableHorizontal_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_SeparableVertical_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_Pilot_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_Refinement_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_TextureSpace_PS_bytecode.inl"
 
 struct UpdatedPerFrame
 {
 	__declspec(align(16)) DirectX::XMFLOAT4X4 currProj;
-	__declspec(align(16)) DirectX::XMFLOAT3 scatteringDistance;
-	float padding_scatteringDistance;
-	float worldScale;
 	float postscatterEnabled;
 	int sampleBudget;
 	int pixelsPerSample;
+	int inverseCdfMode;
+	int kernelCacheEnabled;
+	int sequence;
+	int misMode;
+	int resolutionFactor;
+	DirectX::XMFLOAT2 sampleRotation;
+	float temporalBlend;
+	float sampleRadiusOffset;
+	__declspec(align(16)) DirectX::XMFLOAT4X4 reprojection;
+	float samplesPerFrame;
+	int pilotSampleCount;
+	int padding_pilotSampleCount[2];
+	int maskPyramidLevelCount;
+	int padding_maskPyramidLevelCount[3];
+	int irradiancePyramidLevelCount;
+	int padding_irradiancePyramidLevelCount[3];
+	int irradianceEncoding;
+	int depthEncoding;
+	int blurIrradianceEncoding;
+	int blurDepthEncoding;
+	int textureSpaceProfileIndex;
+	int textureSpaceSampleCount;
+	int padding_textureSpaceSampleCount[2];
 };
 
 #define CB_UPDATEDPERFRAME 0
 #define TEX_ALBEDO 0
 #define TEX_IRRADIANCE 1
 #define TEX_DEPTH 2
+#define TEX_INVERSE_CDF_LUT 3
+#define TEX_KERNEL_CACHE 4
+#define TEX_STENCIL 5
+#define TEX_PROFILES 6
+#define TEX_SEPARABLE_KERNEL 7
+#define TEX_LOW_RESOLUTION_BLURRED 8
+#define TEX_LOW_RESOLUTION_ALBEDO 9
+#define TEX_LOW_RESOLUTION_DEPTH 10
+#define TEX_LOW_RESOLUTION_STENCIL 11
+#define TEX_TEMPORAL_CURRENT 12
+#define TEX_TEMPORAL_HISTORY 13
+#define TEX_TEMPORAL_HISTORY_GUIDE 14
+#define TEX_MOTION_VECTOR 15
+#define TEX_ADAPTIVE_PILOT 16
+#define TEX_ADAPTIVE_PILOT_ERROR 17
+#define TEX_TILE_STATE 18
+#define TEX_TILE_CLASS 19
+#define TEX_MASK_PYRAMID 20
+#define TEX_MASK_PYRAMID_PREVIOUS_LEVEL 21
+#define TEX_IRRADIANCE_PYRAMID 22
+#define TEX_IRRADIANCE_PYRAMID_VIEW_SPACE_POSITION_Z 23
+#define TEX_IRRADIANCE_PYRAMID_PREVIOUS_LEVEL 24
+#define TEX_IRRADIANCE_PYRAMID_PREVIOUS_LEVEL_VIEW_SPACE_POSITION_Z 25
+#define TEX_TEXTURE_SPACE_IRRADIANCE 26
+#define TEX_TEXTURE_SPACE_POSITION 27
+#define TEX_TEXTURE_SPACE_STRETCH 28
 #define SAMP_POINT 0
 #define SAMP_LINEAR 1
 
 using namespace std;
 
 SSSBlur::SSSBlur(ID3D11Device* device,
-	float worldScale,
 	bool postscatterEnabled,
 	int sampleBudget,
-	int pixelsPerSample) : m_worldScale(std::max(0.001f, worldScale)),
-	m_postscatterEnabled(postscatterEnabled),
+	int pixelsPerSample) : m_postscatterEnabled(postscatterEnabled),
 	m_sampleBudget(std::max(1, sampleBudget)),
-	m_pixelsPerSample(std::max(4, pixelsPerSample))
+	m_samplesPerFrame(0),
+	m_pixelsPerSample(std::max(4, pixelsPerSample)),
+	m_inverseCdfMode(SSS_INVERSE_CDF_MODE_ANALYTIC),
+	m_inverseCdfLUTSize(SSS_INVERSE_CDF_LUT_DEFAULT_SIZE),
+	InverseCdfLUT(NULL),
+	InverseCdfLUTSRV(NULL),
+	m_kernelCacheEnabled(false),
+	m_kernelCacheDirty(true),
+	m_sequence(LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY),
+	m_misMode(SSS_MIS_MODE_NONE),
+	m_blurMode(SSS_BLUR_MODE_BURLEY),
+	m_irradianceEncoding(SSS_IRRADIANCE_ENCODING_RGBA16F),
+	m_depthEncoding(SSS_DEPTH_ENCODING_NDC_R32F),
+	InverseCdfLUTSize(0),
+	KernelCache(NULL),
+	KernelCacheSRV(NULL),
+	Profiles(NULL),
+	ProfilesSRV(NULL),
+	ProfilesVersion(0U),
+	SeparableKernel(NULL),
+	SeparableKernelSRV(NULL),
+	tmpRT(NULL),
+	pilotRT(NULL),
+	pilotErrorRT(NULL)
 {
 	HRESULT hr;
 
@@ -64,6 +140,11 @@ SSSBlur::SSSBlur(ID3D11Device* device,
 
 	V(device->CreateVertexShader(SSS_Blur_VS_bytecode, sizeof(SSS_Blur_VS_bytecode), NULL, &SSS_VS));
 	V(device->CreatePixelShader(SSS_Blur_PS_bytecode, sizeof(SSS_Blur_PS_bytecode), NULL, &SSS_Blur_PS));
+	V(device->CreatePixelShader(SSS_Blur_SeparableHorizontal_PS_bytecode, sizeof(SSS_Blur_SeparableHorizontal_PS_bytecode), NULL, &SSS_Blur_SeparableHorizontal_PS));
+	V(device->CreatePixelShader(SSS_Blur_SeparableVertical_PS_bytecode, sizeof(SSS_Blur_SeparableVertical_PS_bytecode), NULL, &SSS_Blur_SeparableVertical_PS));
+	V(device->CreatePixelShader(SSS_Blur_Pilot_PS_bytecode, sizeof(SSS_Blur_Pilot_PS_bytecode), NULL, &SSS_Blur_Pilot_PS));
+	V(device->CreatePixelShader(SSS_Blur_Refinement_PS_bytecode, sizeof(SSS_Blur_Refinement_PS_bytecode), NULL, &SSS_Blur_Refinement_PS));
+	V(device->CreatePixelShader(SSS_Blur_TextureSpace_PS_bytecode, sizeof(SSS_Blur_TextureSpace_PS_bytecode), NULL, &SSS_Blur_TextureSpace_PS));
 
 	D3D11_DEPTH_STENCIL_DESC BlurStencilDesc = {};
 	BlurStencilDesc.DepthEnable = TRUE;
@@ -82,7 +163,8 @@ SSSBlur::SSSBlur(ID3D11Device* device,
 	BlurStencilDesc.BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
 	BlurStencilDesc.DepthEnable = FALSE;
 	BlurStencilDesc.StencilEnable = TRUE;
-	BlurStencilDesc.FrontFace.StencilFunc = D3D11_COMPARISON_EQUAL;
+	// Any profile: stencil != 0
+	BlurStencilDesc.FrontFace.StencilFunc = D3D11_COMPARISON_NOT_EQUAL;
 	V(device->CreateDepthStencilState(&BlurStencilDesc, &BlurStencil));
 
 	D3D11_BLEND_DESC AddBlendingDesc = {};
@@ -133,17 +215,198 @@ SSSBlur::SSSBlur(ID3D11Device* device,
 	LinearSamplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
 	V(device->CreateSamplerState(&LinearSamplerDesc, &LinearSampler));
 
+	createInverseCdfLUT(device);
+
+	// All the kernels of all the buckets, s.t. the "sampleBudget" can be changed without recreating the buffer
+	D3D11_BUFFER_DESC KernelCacheDesc = {};
+	KernelCacheDesc.ByteWidth = sizeof(float4) * SSS_KERNEL_CACHE_GPU_SAMPLE_COUNT;
+	KernelCacheDesc.Usage = D3D11_USAGE_DEFAULT;
+	KernelCacheDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	V(device->CreateBuffer(&KernelCacheDesc, NULL, &KernelCache));
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC KernelCacheSRVDesc = {};
+	KernelCacheSRVDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	KernelCacheSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	KernelCacheSRVDesc.Buffer.FirstElement = 0;
+	KernelCacheSRVDesc.Buffer.NumElements = SSS_KERNEL_CACHE_GPU_SAMPLE_COUNT;
+	V(device->CreateShaderResourceView(KernelCache, &KernelCacheSRVDesc, &KernelCacheSRV));
+
+	// Two "float4" per profile, s.t. the table can grow without recreating the buffer
+	D3D11_BUFFER_DESC ProfilesDesc = {};
+	ProfilesDesc.ByteWidth = sizeof(SSSProfile) * SSS_PROFILE_MAX_COUNT;
+	ProfilesDesc.Usage = D3D11_USAGE_DEFAULT;
+	ProfilesDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	V(device->CreateBuffer(&ProfilesDesc, NULL, &Profiles));
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC ProfilesSRVDesc = {};
+	ProfilesSRVDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	ProfilesSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	ProfilesSRVDesc.Buffer.FirstElement = 0;
+	ProfilesSRVDesc.Buffer.NumElements = 2 * SSS_PROFILE_MAX_COUNT;
+	V(device->CreateShaderResourceView(Profiles, &ProfilesSRVDesc, &ProfilesSRV));
+
+	// One row of SSS_SEPARABLE_KERNEL_SAMPLE_COUNT "float4" per profile, s.t. the table can grow without recreating the buffer
+	D3D11_BUFFER_DESC SeparableKernelDesc = {};
+	SeparableKernelDesc.ByteWidth = sizeof(float4) * SSS_SEPARABLE_KERNEL_SAMPLE_COUNT * SSS_PROFILE_MAX_COUNT;
+	SeparableKernelDesc.Usage = D3D11_USAGE_DEFAULT;
+	SeparableKernelDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	V(device->CreateBuffer(&SeparableKernelDesc, NULL, &SeparableKernel));
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC SeparableKernelSRVDesc = {};
+	SeparableKernelSRVDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	SeparableKernelSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	SeparableKernelSRVDesc.Buffer.FirstElement = 0;
+	SeparableKernelSRVDesc.Buffer.NumElements = SSS_SEPARABLE_KERNEL_SAMPLE_COUNT * SSS_PROFILE_MAX_COUNT;
+	V(device->CreateShaderResourceView(SeparableKernel, &SeparableKernelSRVDesc, &SeparableKernelSRV));
+
 	quad = new Quad(device, SSS_Blur_VS_bytecode, sizeof(SSS_Blur_VS_bytecode));
+
+	upsampler = new SSSUpsampler(device);
+	temporalResolve = new SSSTemporalResolve(device);
+	tileClassifier = new SSSTileClassifier(device);
+	maskPyramidBuilder = new SSSMaskPyramidBuilder(device);
+	irradiancePyramidBuilder = new SSSIrradiancePyramidBuilder(device);
+}
+
+void SSSBlur::createInverseCdfLUT(ID3D11Device* device)
+{
+	HRESULT hr;
+
+	SAFE_RELEASE(InverseCdfLUTSRV);
+	SAFE_RELEASE(InverseCdfLUT);
+
+	// Built once on the CPU
+	DiffusionProfileInverseCdfLUT lut(m_inverseCdfLUTSize);
+
+	D3D11_TEXTURE1D_DESC InverseCdfLUTDesc = {};
+	InverseCdfLUTDesc.Width = lut.getSize();
+	InverseCdfLUTDesc.MipLevels = 1;
+	InverseCdfLUTDesc.ArraySize = 1;
+	InverseCdfLUTDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
+	InverseCdfLUTDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	InverseCdfLUTDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	D3D11_SUBRESOURCE_DATA InverseCdfLUTData = {};
+	InverseCdfLUTData.pSysMem = lut.getData();
+	InverseCdfLUTData.SysMemPitch = sizeof(float2) * lut.getSize();
+	V(device->CreateTexture1D(&InverseCdfLUTDesc, &InverseCdfLUTData, &InverseCdfLUT));
+	V(device->CreateShaderResourceView(InverseCdfLUT, NULL, &InverseCdfLUTSRV));
+
+	InverseCdfLUTSize = m_inverseCdfLUTSize;
+}
+
+void SSSBlur::uploadKernelCache(ID3D11DeviceContext* context)
+{
+	// Only the kernels which may be used by the current "sampleBudget" are baked
+	// NOTE: baked for "d = 1" and scaled by the shader, s.t. the kernels are shared by all profiles
+	// NOTE: baked without the radius offset of the frame (see "sampleRadiusOffset" of the "SSS_Blur.hlsli")
+	const float3 scatteringDistance(1.0f, 1.0f, 1.0f);
+	const int maxSampleCount = std::min(m_sampleBudget, int(SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT));
+
+	std::vector<float4> samples(subsurface_scattering_kernel_cache_offset(SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT - 1, maxSampleCount + 1));
+	for (int centerCdfBucket = 0; centerCdfBucket < SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT; ++centerCdfBucket)
+	{
+		for (int sampleCount = 1; sampleCount <= maxSampleCount; ++sampleCount)
+		{
+			std::shared_ptr<const SSSKernel> kernel = m_kernelCache.get(scatteringDistance, m_sequence, sampleCount, centerCdfBucket, 0);
+			std::copy(kernel->samples.begin(), kernel->samples.end(), samples.begin() + subsurface_scattering_kernel_cache_offset(centerCdfBucket, sampleCount));
+		}
+	}
+
+	// NOTE: unlike the CPU path, the buffer is a fixed table of SSS_KERNEL_CACHE_GPU_SAMPLE_COUNT (64 buckets * 3240) samples (3.2 MB), which has no hit/miss and no memory cap of its own
+	// (the counters and the memory cap of the "m_kernelCache" only apply to the baking on the CPU)
+	// NOTE: the gaps between the buckets (the sample counts which are greater than the "sampleBudget") are uploaded as zero but never used
+	D3D11_BOX box = { 0U, 0U, 0U, static_cast<UINT>(sizeof(float4) * samples.size()), 1U, 1U };
+	context->UpdateSubresource(KernelCache, 0U, &box, samples.data(), 0U, 0U);
+
+	m_kernelCacheDirty = false;
+}
+
+void SSSBlur::uploadProfiles(ID3D11DeviceContext* context, const SSSProfileTable& profiles)
+{
+	static_assert(sizeof(SSSProfile) == (2U * sizeof(float4)), "The layout of the SSSProfile should match the Buffer<float4>");
+
+	D3D11_BOX box = { 0U, 0U, 0U, static_cast<UINT>(sizeof(SSSProfile) * profiles.getCount()), 1U, 1U };
+	context->UpdateSubresource(Profiles, 0U, &box, profiles.getData(), 0U, 0U);
+
+	ProfilesVersion = profiles.getVersion();
+}
+
+void SSSBlur::createTmpRT(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV)
+{
+	ID3D11Resource* irradianceResource = NULL;
+	irradianceSRV->GetResource(&irradianceResource);
+	D3D11_TEXTURE2D_DESC irradianceDesc;
+	static_cast<ID3D11Texture2D*>(irradianceResource)->GetDesc(&irradianceDesc);
+	SAFE_RELEASE(irradianceResource);
+
+	if ((NULL != tmpRT) && (tmpRT->getWidth() == static_cast<int>(irradianceDesc.Width)) && (tmpRT->getHeight() == static_cast<int>(irradianceDesc.Height)))
+	{
+		return;
+	}
+
+	SAFE_DELETE(tmpRT);
+
+	ID3D11Device* device = NULL;
+	context->GetDevice(&device);
+	// NOTE: the (blurred) irradiance is NOT clamped by the format
+	tmpRT = new RenderTarget(device, static_cast<int>(irradianceDesc.Width), static_cast<int>(irradianceDesc.Height), DXGI_FORMAT_R16G16B16A16_FLOAT);
+	SAFE_RELEASE(device);
+}
+
+void SSSBlur::createAdaptiveRTs(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV)
+{
+	ID3D11Resource* irradianceResource = NULL;
+	irradianceSRV->GetResource(&irradianceResource);
+	D3D11_TEXTURE2D_DESC irradianceDesc;
+	static_cast<ID3D11Texture2D*>(irradianceResource)->GetDesc(&irradianceDesc);
+	SAFE_RELEASE(irradianceResource);
+
+	if ((NULL != pilotRT) && (pilotRT->getWidth() == static_cast<int>(irradianceDesc.Width)) && (pilotRT->getHeight() == static_cast<int>(irradianceDesc.Height)))
+	{
+		return;
+	}
+
+	SAFE_DELETE(pilotErrorRT);
+	SAFE_DELETE(pilotRT);
+
+	ID3D11Device* device = NULL;
+	context->GetDevice(&device);
+	pilotRT = new RenderTarget(device, static_cast<int>(irradianceDesc.Width), static_cast<int>(irradianceDesc.Height), DXGI_FORMAT_R16G16B16A16_FLOAT);
+	// NOTE: the sums over all pixels are NOT precise enough in the half float
+	pilotErrorRT = new RenderTarget(device, static_cast<int>(irradianceDesc.Width), static_cast<int>(irradianceDesc.Height), DXGI_FORMAT_R32G32B32A32_FLOAT, NoMSAA(), true, true);
+	SAFE_RELEASE(device);
 }
 
 SSSBlur::~SSSBlur()
 {
+	SAFE_DELETE(irradiancePyramidBuilder);
+	SAFE_DELETE(maskPyramidBuilder);
+	SAFE_DELETE(tileClassifier);
+	SAFE_DELETE(temporalResolve);
+	SAFE_DELETE(upsampler);
+	SAFE_DELETE(pilotErrorRT);
+	SAFE_DELETE(pilotRT);
+	SAFE_DELETE(tmpRT);
 	SAFE_DELETE(quad);
+	SAFE_RELEASE(SeparableKernelSRV);
+	SAFE_RELEASE(SeparableKernel);
+	SAFE_RELEASE(ProfilesSRV);
+	SAFE_RELEASE(Profiles);
+	SAFE_RELEASE(KernelCacheSRV);
+	SAFE_RELEASE(KernelCache);
+	SAFE_RELEASE(InverseCdfLUTSRV);
+	SAFE_RELEASE(InverseCdfLUT);
 	SAFE_RELEASE(LinearSampler);
 	SAFE_RELEASE(PointSampler);
 	SAFE_RELEASE(AddBlending);
 	SAFE_RELEASE(BlurStencil);
 	SAFE_RELEASE(CbufUpdatedPerFrame);
+	SAFE_RELEASE(SSS_Blur_TextureSpace_PS);
+	SAFE_RELEASE(SSS_Blur_Refinement_PS);
+	SAFE_RELEASE(SSS_Blur_Pilot_PS);
+	SAFE_RELEASE(SSS_Blur_SeparableVertical_PS);
+	SAFE_RELEASE(SSS_Blur_SeparableHorizontal_PS);
 	SAFE_RELEASE(SSS_Blur_PS);
 	SAFE_RELEASE(SSS_VS);
 }
@@ -153,43 +416,296 @@ void SSSBlur::go(ID3D11DeviceContext* context,
 	ID3D11ShaderResourceView* irradianceSRV,
 	ID3D11ShaderResourceView* depthSRV,
 	ID3D11DepthStencilView* depthDSV,
-	ID3D11ShaderResourceView* albedoSRV)
+	ID3D11ShaderResourceView* stencilSRV,
+	ID3D11ShaderResourceView* albedoSRV,
+	ID3D11ShaderResourceView* velocitySRV,
+	const SSSProfileTable& profiles)
 {
+	if (InverseCdfLUTSize != m_inverseCdfLUTSize)
+	{
+		ID3D11Device* device = NULL;
+		context->GetDevice(&device);
+		createInverseCdfLUT(device);
+		SAFE_RELEASE(device);
+	}
+
+	if (m_kernelCacheEnabled && m_kernelCacheDirty)
+	{
+		uploadKernelCache(context);
+	}
+
+	if (ProfilesVersion != profiles.getVersion())
+	{
+		uploadProfiles(context, profiles);
+	}
+
+	const bool lowResolutionEnabled = upsampler->isEnabled();
+	if (lowResolutionEnabled)
+	{
+		upsampler->createRTs(context, irradianceSRV);
+	}
+
+	// The blurred radiance is written into the "currentRT" (instead of the "mainRTV") and resolved with the history at the end if the temporal accumulation is enabled
+	temporalResolve->prepare(context, irradianceSRV);
+	ID3D11RenderTargetView* outputRTV = temporalResolve->isEnabled() ? temporalResolve->getCurrentRTV() : mainRTV;
+
+	// The blur reads the low resolution render targets and writes the "lowBlurredRT" (no stencil buffer and no blending) if the resolution is NOT full
+	ID3D11ShaderResourceView* blurIrradianceSRV = lowResolutionEnabled ? upsampler->getIrradianceSRV() : irradianceSRV;
+	ID3D11RenderTargetView* blurRTV = lowResolutionEnabled ? upsampler->getBlurredRTV() : outputRTV;
+	ID3D11DepthStencilView* blurDSV = lowResolutionEnabled ? NULL : depthDSV;
+	ID3D11BlendState* blurBlending = lowResolutionEnabled ? NULL : AddBlending;
+
+	const bool adaptiveEnabled = (SSS_BLUR_MODE_SEPARABLE != m_blurMode) && (m_samplesPerFrame > 0);
+	const bool tileClassificationEnabled = (SSS_BLUR_MODE_SEPARABLE != m_blurMode) && (!adaptiveEnabled) && tileClassifier->isEnabled();
+	const bool maskPyramidEnabled = (SSS_BLUR_MODE_SEPARABLE != m_blurMode) && maskPyramidBuilder->isEnabled();
+	const bool irradiancePyramidEnabled = (SSS_BLUR_MODE_SEPARABLE != m_blurMode) && irradiancePyramidBuilder->isEnabled();
+
+	if (SSS_BLUR_MODE_SEPARABLE == m_blurMode)
+	{
+		if (m_separableKernel.update(profiles))
+		{
+			D3D11_BOX box = { 0U, 0U, 0U, static_cast<UINT>(sizeof(float4) * SSS_SEPARABLE_KERNEL_SAMPLE_COUNT * m_separableKernel.getProfileCount()), 1U, 1U };
+			context->UpdateSubresource(SeparableKernel, 0U, &box, m_separableKernel.getData(), 0U, 0U);
+		}
+
+		createTmpRT(context, blurIrradianceSRV);
+	}
+	else if (adaptiveEnabled)
+	{
+		createAdaptiveRTs(context, blurIrradianceSRV);
+	}
+	else if (tileClassificationEnabled)
+	{
+		tileClassifier->createRTs(context, blurIrradianceSRV);
+	}
+
+	if (maskPyramidEnabled)
+	{
+		maskPyramidBuilder->createRT(context, blurIrradianceSRV);
+	}
+
+	if (irradiancePyramidEnabled)
+	{
+		irradiancePyramidBuilder->createRTs(context, blurIrradianceSRV);
+	}
+
+	DirectX::XMFLOAT4X4 currViewProj;
+	DirectX::XMStoreFloat4x4(&currViewProj, DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&camera.getViewMatrix()), DirectX::XMLoadFloat4x4(&camera.getProjectionMatrix())));
+
+	const float2 sampleRotation = temporalResolve->getSampleRotation();
+	const float sampleRadiusOffset = temporalResolve->getSampleRadiusOffset();
+	const int pilotSampleCount = std::min(int(SSS_ADAPTIVE_PILOT_SAMPLE_COUNT), m_sampleBudget);
+
 	// Set variables:
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 	context->Map(CbufUpdatedPerFrame, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 	((struct UpdatedPerFrame*)mappedResource.pData)->currProj = camera.getProjectionMatrix();
-	((struct UpdatedPerFrame*)mappedResource.pData)->scatteringDistance = m_scatteringDistance;
-	((struct UpdatedPerFrame*)mappedResource.pData)->worldScale = m_worldScale;
 	((struct UpdatedPerFrame*)mappedResource.pData)->postscatterEnabled = m_postscatterEnabled ? 1.0f : -1.0f;
 	((struct UpdatedPerFrame*)mappedResource.pData)->sampleBudget = m_sampleBudget;
 	((struct UpdatedPerFrame*)mappedResource.pData)->pixelsPerSample = m_pixelsPerSample;
+	((struct UpdatedPerFrame*)mappedResource.pData)->inverseCdfMode = m_inverseCdfMode;
+	((struct UpdatedPerFrame*)mappedResource.pData)->kernelCacheEnabled = m_kernelCacheEnabled ? 1 : 0;
+	((struct UpdatedPerFrame*)mappedResource.pData)->sequence = m_sequence;
+	((struct UpdatedPerFrame*)mappedResource.pData)->misMode = m_misMode;
+	((struct UpdatedPerFrame*)mappedResource.pData)->resolutionFactor = upsampler->getResolutionFactor();
+	((struct UpdatedPerFrame*)mappedResource.pData)->sampleRotation = DirectX::XMFLOAT2(sampleRotation.x, sampleRotation.y);
+	((struct UpdatedPerFrame*)mappedResource.pData)->temporalBlend = temporalResolve->getBlend();
+	((struct UpdatedPerFrame*)mappedResource.pData)->sampleRadiusOffset = sampleRadiusOffset;
+	((struct UpdatedPerFrame*)mappedResource.pData)->reprojection = temporalResolve->getReprojection(currViewProj);
+	((struct UpdatedPerFrame*)mappedResource.pData)->samplesPerFrame = float(m_samplesPerFrame);
+	((struct UpdatedPerFrame*)mappedResource.pData)->pilotSampleCount = pilotSampleCount;
+	((struct UpdatedPerFrame*)mappedResource.pData)->maskPyramidLevelCount = maskPyramidEnabled ? maskPyramidBuilder->getLevelCount() : 0;
+	((struct UpdatedPerFrame*)mappedResource.pData)->irradiancePyramidLevelCount = irradiancePyramidEnabled ? irradiancePyramidBuilder->getLevelCount() : 0;
+	((struct UpdatedPerFrame*)mappedResource.pData)->irradianceEncoding = m_irradianceEncoding;
+	((struct UpdatedPerFrame*)mappedResource.pData)->depthEncoding = m_depthEncoding;
+	((struct UpdatedPerFrame*)mappedResource.pData)->blurIrradianceEncoding = lowResolutionEnabled ? SSS_IRRADIANCE_ENCODING_RGBA16F : m_irradianceEncoding;
+	((struct UpdatedPerFrame*)mappedResource.pData)->blurDepthEncoding = lowResolutionEnabled ? SSS_DEPTH_ENCODING_NDC_R32F : m_depthEncoding;
 	context->Unmap(CbufUpdatedPerFrame, 0);
 
 	// Set input layout and viewport:
 	quad->setInputLayout(context);
 
-	UINT StencilRef = 1;
+	UINT StencilRef = 0;
 
 	context->PSSetShaderResources(TEX_IRRADIANCE, 1U, &irradianceSRV);
 	context->PSSetShaderResources(TEX_ALBEDO, 1U, &albedoSRV);
 	context->PSSetShaderResources(TEX_DEPTH, 1U, &depthSRV);
+	context->PSSetShaderResources(TEX_INVERSE_CDF_LUT, 1U, &InverseCdfLUTSRV);
+	context->PSSetShaderResources(TEX_KERNEL_CACHE, 1U, &KernelCacheSRV);
+	context->PSSetShaderResources(TEX_STENCIL, 1U, &stencilSRV);
+	context->PSSetShaderResources(TEX_PROFILES, 1U, &ProfilesSRV);
+	context->PSSetShaderResources(TEX_SEPARABLE_KERNEL, 1U, &SeparableKernelSRV);
 	context->VSSetConstantBuffers(CB_UPDATEDPERFRAME, 1U, &CbufUpdatedPerFrame);
 	context->PSSetConstantBuffers(CB_UPDATEDPERFRAME, 1U, &CbufUpdatedPerFrame);
 	context->PSSetSamplers(SAMP_POINT, 1, &PointSampler);
 	context->PSSetSamplers(SAMP_LINEAR, 1, &LinearSampler);
 	context->VSSetShader(SSS_VS, NULL, 0);
 	context->GSSetShader(NULL, NULL, 0);
-	context->PSSetShader(SSS_Blur_PS, NULL, 0);
 	context->OMSetDepthStencilState(BlurStencil, StencilRef);
 	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-	context->OMSetBlendState(AddBlending, BlendFactor, 0xFFFFFFFF);
+	ID3D11RenderTargetView* pRenderTargetViews[4] = { NULL, NULL, NULL, NULL };
+
+	// The viewport of the full resolution is restored before the upsample
+	UINT NumViewports = 1U;
+	D3D11_VIEWPORT Viewport;
+	context->RSGetViewports(&NumViewports, &Viewport);
+
+	if (lowResolutionEnabled)
+	{
+		upsampler->downsample(context, quad);
+	}
 
-	context->OMSetRenderTargets(1, &mainRTV, depthDSV);
+	if (maskPyramidEnabled)
+	{
+		maskPyramidBuilder->build(context, quad);
+	}
+
+	if (irradiancePyramidEnabled)
+	{
+		irradiancePyramidBuilder->build(context, quad);
+	}
+
+	if (SSS_BLUR_MODE_SEPARABLE == m_blurMode)
+	{
+		// Horizontal: irradiance -> tmpRT (no blending)
+		// NOTE: the pixels which are NOT written (stencil == 0) are rejected by the vertical pass (the subsurface mask is zero)
+		FLOAT ClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		context->ClearRenderTargetView(*tmpRT, ClearColor);
+		context->PSSetShader(SSS_Blur_SeparableHorizontal_PS, NULL, 0);
+		context->OMSetBlendState(NULL, BlendFactor, 0xFFFFFFFF);
+		context->OMSetRenderTargets(1, *tmpRT, blurDSV);
+		quad->draw(context);
+		context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+
+		// Vertical: tmpRT -> mainRT (additive blending)
+		ID3D11ShaderResourceView* tmpSRV = *tmpRT;
+		context->PSSetShaderResources(TEX_IRRADIANCE, 1U, &tmpSRV);
+		context->PSSetShader(SSS_Blur_SeparableVertical_PS, NULL, 0);
+		context->OMSetBlendState(blurBlending, BlendFactor, 0xFFFFFFFF);
+		context->OMSetRenderTargets(1, &blurRTV, blurDSV);
+		quad->draw(context);
+		context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+	}
+	else if (adaptiveEnabled)
+	{
+		// Pilot: irradiance -> pilotRT + pilotErrorRT (no blending)
+		// NOTE: the pixels which are NOT written (stencil == 0) are NOT covered, and are NOT read by the refinement (stencil test)
+		FLOAT ClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		context->ClearRenderTargetView(*pilotRT, ClearColor);
+		context->ClearRenderTargetView(*pilotErrorRT, ClearColor);
+		ID3D11RenderTargetView* pilotRTVs[2] = { *pilotRT, *pilotErrorRT };
+		context->PSSetShader(SSS_Blur_Pilot_PS, NULL, 0);
+		context->OMSetBlendState(NULL, BlendFactor, 0xFFFFFFFF);
+		context->OMSetRenderTargets(2, pilotRTVs, blurDSV);
+		quad->draw(context);
+		context->OMSetRenderTargets(2, pRenderTargetViews, NULL);
+
+		// The last mip is the mean over all pixels
+		context->GenerateMips(*pilotErrorRT);
+
+		// Refinement: irradiance + pilotRT -> mainRT (additive blending)
+		ID3D11ShaderResourceView* adaptiveSRVs[2] = { *pilotRT, *pilotErrorRT };
+		context->PSSetShaderResources(TEX_ADAPTIVE_PILOT, 2U, adaptiveSRVs);
+		context->PSSetShader(SSS_Blur_Refinement_PS, NULL, 0);
+		context->OMSetBlendState(blurBlending, BlendFactor, 0xFFFFFFFF);
+		context->OMSetRenderTargets(1, &blurRTV, blurDSV);
+		quad->draw(context);
+		context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+	}
+	else if (tileClassificationEnabled)
+	{
+		// The edge tiles are drawn with the full Burley blur
+		tileClassifier->go(context, quad, blurRTV, blurIrradianceSRV, blurDSV, blurBlending, SSS_Blur_PS);
+		context->VSSetShader(SSS_VS, NULL, 0);
+		quad->setInputLayout(context);
+	}
+	else
+	{
+		context->PSSetShader(SSS_Blur_PS, NULL, 0);
+		context->OMSetBlendState(blurBlending, BlendFactor, 0xFFFFFFFF);
+		context->OMSetRenderTargets(1, &blurRTV, blurDSV);
+		quad->draw(context);
+		context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+	}
+
+	if (lowResolutionEnabled)
+	{
+		// Upsample: low resolution -> mainRT or currentRT (additive blending)
+		context->RSSetViewports(NumViewports, &Viewport);
+		upsampler->upsample(context, quad, outputRTV, irradianceSRV, depthSRV, depthDSV, stencilSRV, albedoSRV, AddBlending);
+	}
+
+	if (temporalResolve->isEnabled())
+	{
+		temporalResolve->resolve(context, quad, mainRTV, depthDSV, velocitySRV, currViewProj);
+	}
+
+	ID3D11ShaderResourceView* pShaderResourceViews[26] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+	context->PSSetShaderResources(0, 26, pShaderResourceViews);
+	context->VSSetShaderResources(0, 26, pShaderResourceViews);
+}
+
+void SSSBlur::goTextureSpace(ID3D11DeviceContext* context,
+	ID3D11RenderTargetView* atlasRTV,
+	ID3D11ShaderResourceView* irradianceSRV,
+	ID3D11ShaderResourceView* positionSRV,
+	ID3D11ShaderResourceView* stretchSRV,
+	int size,
+	int profileIndex,
+	int sampleCount,
+	const SSSProfileTable& profiles)
+{
+	if (ProfilesVersion != profiles.getVersion())
+	{
+		uploadProfiles(context, profiles);
+	}
+
+	// Set variables:
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	context->Map(CbufUpdatedPerFrame, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	((struct UpdatedPerFrame*)mappedResource.pData)->textureSpaceProfileIndex = profileIndex;
+	((struct UpdatedPerFrame*)mappedResource.pData)->textureSpaceSampleCount = std::min(std::max(1, sampleCount), int(SSS_TEXTURE_SPACE_MAX_SAMPLE_COUNT));
+	context->Unmap(CbufUpdatedPerFrame, 0);
+
+	// The viewport and the render targets of the caller are restored at the end
+	UINT NumViewports = 1U;
+	D3D11_VIEWPORT Viewport;
+	context->RSGetViewports(&NumViewports, &Viewport);
+	ID3D11RenderTargetView* prevRTVs[4] = { NULL, NULL, NULL, NULL };
+	ID3D11DepthStencilView* prevDSV = NULL;
+	context->OMGetRenderTargets(4, prevRTVs, &prevDSV);
+
+	// Set input layout and viewport:
+	quad->setInputLayout(context);
+	D3D11_VIEWPORT AtlasViewport = { 0.0f, 0.0f, float(size), float(size), 0.0f, 1.0f };
+	context->RSSetViewports(1U, &AtlasViewport);
+
+	ID3D11ShaderResourceView* textureSpaceSRVs[3] = { irradianceSRV, positionSRV, stretchSRV };
+	context->PSSetShaderResources(TEX_PROFILES, 1U, &ProfilesSRV);
+	context->PSSetShaderResources(TEX_TEXTURE_SPACE_IRRADIANCE, 3U, textureSpaceSRVs);
+	context->VSSetConstantBuffers(CB_UPDATEDPERFRAME, 1U, &CbufUpdatedPerFrame);
+	context->PSSetConstantBuffers(CB_UPDATEDPERFRAME, 1U, &CbufUpdatedPerFrame);
+	context->VSSetShader(SSS_VS, NULL, 0);
+	context->GSSetShader(NULL, NULL, 0);
+	context->PSSetShader(SSS_Blur_TextureSpace_PS, NULL, 0);
+	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	context->OMSetBlendState(NULL, BlendFactor, 0xFFFFFFFF);
+	context->OMSetDepthStencilState(BlurStencil, 0);
+
+	// Diffuse: irradiance -> atlas (no depth stencil buffer and no blending)
+	// NOTE: all texels are written (the empty texels are zero), s.t. the atlas does NOT need to be cleared
+	context->OMSetRenderTargets(1, &atlasRTV, NULL);
 	quad->draw(context);
-	ID3D11RenderTargetView* pRenderTargetViews[1] = { NULL };
-	context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
 
-	ID3D11ShaderResourceView* pShaderResourceViews[4] = { NULL, NULL, NULL, NULL };
-	context->PSSetShaderResources(0, 4, pShaderResourceViews);
+	ID3D11ShaderResourceView* pShaderResourceViews[3] = { NULL, NULL, NULL };
+	context->PSSetShaderResources(TEX_TEXTURE_SPACE_IRRADIANCE, 3U, pShaderResourceViews);
+	context->PSSetShaderResources(TEX_PROFILES, 1U, pShaderResourceViews);
+
+	context->OMSetRenderTargets(4, prevRTVs, prevDSV);
+	context->RSSetViewports(NumViewports, &Viewport);
+	for (int i = 0; i < 4; ++i)
+	{
+		SAFE_RELEASE(prevRTVs[i]);
+	}
+	SAFE_RELEASE(prevDSV);
 }
@@ -24,43 +24,71 @@
 #include <DXUT.h>
 #include <DirectXMath.h>
 #include "RenderTarget.h"
+#include "CPU/SSSKernelCache.h"
+#include "CPU/SSSProfileTable.h"
+#include "CPU/SSSSeparableKernel.h"
+#include "CPU/subsurface_scattering_adaptive.h"
+#include "CPU/subsurface_scattering_gbuffer_encoding.h"
+#include "SSSUpsampler.h"
+#include "SSSTemporalResolve.h"
+#include "SSSTileClassifier.h"
+#include "SSSPyramidBuilder.h"
 #include <string>
 
 class SSSBlur
 {
 public:
 	SSSBlur(ID3D11Device* device,
-		float worldScale,
 		bool postscatterEnabled,
 		int sampleBudget,
 		int pixelsPerSample);
 	~SSSBlur();
 
+	// depthDSV: read-only, since the stencil (profile index + 1) is also read by the shader
+	// velocitySRV: the motion vectors (uv_curr - uv_prev) written by the "mainPass", only read by the temporal accumulation
+	// profiles: uploaded when the version of the table changes
 	void go(ID3D11DeviceContext* context,
 		ID3D11RenderTargetView* mainRTV,
 		ID3D11ShaderResourceView* irradianceSRV,
 		ID3D11ShaderResourceView* depthSRV,
 		ID3D11DepthStencilView* depthDSV,
-		ID3D11ShaderResourceView* albedoSRV);
+		ID3D11ShaderResourceView* stencilSRV,
+		ID3D11ShaderResourceView* albedoSRV,
+		ID3D11ShaderResourceView* velocitySRV,
+		const SSSProfileTable& profiles);
 
-	void setWorldScale(float worldScale)
-	{
-		this->m_worldScale = std::max(0.001f, worldScale);
-	}
+	// The texture space diffusion of one head (see "subsurface_scattering_texture_space.hlsli"): the relit irradiance of the head is diffused into the "atlasRTV" (no blending, the viewport of the "size"), which is sampled by the "mainPass" instead of the lighting
+	// irradianceSRV: (total_diffuse_reflectance_pre_scatter_multiply_form_factor, coverage) rendered by the "mainPass" into the texture space of the head
+	// positionSRV and stretchSRV: baked by the "SSSTextureSpaceGeometry" from the mesh of the head
+	// NOTE: the viewport and the render targets of the caller are restored
+	void goTextureSpace(ID3D11DeviceContext* context,
+		ID3D11RenderTargetView* atlasRTV,
+		ID3D11ShaderResourceView* irradianceSRV,
+		ID3D11ShaderResourceView* positionSRV,
+		ID3D11ShaderResourceView* stretchSRV,
+		int size,
+		int profileIndex,
+		int sampleCount,
+		const SSSProfileTable& profiles);
 
 	void setPostScatterEnabled(bool postscatterEnabled)
 	{
 		this->m_postscatterEnabled = postscatterEnabled;
 	}
 
-	void setStrength(DirectX::XMFLOAT3 scatteringDistance)
+	void setNSamples(int sampleBudget)
 	{
-		this->m_scatteringDistance = scatteringDistance;
+		this->m_sampleBudget = std::max(1, sampleBudget);
+		this->m_kernelCacheDirty = true;
 	}
 
-	void setNSamples(int sampleBudget)
+	// 0 disables the adaptive sampling
+	// The pilot pass estimates the error of each pixel, the "GenerateMips" sums the errors, and the rest of the "samplesPerFrame" is spread across the pixels in proportion to the mean error of their blocks (a mip of the "GenerateMips") by the refinement pass, which replaces the pilot (see "subsurface_scattering_adaptive.hlsli")
+	// NOTE: the "sampleBudget" is still the maximum sample count of one pixel, and the "samplesPerFrame" is the budget of the pixels of the blur (namely, the low resolution if the resolution is NOT full)
+	// NOTE: the separable mode ignores the "samplesPerFrame"
+	void setSamplesPerFrame(int samplesPerFrame)
 	{
-		this->m_sampleBudget = std::max(1, sampleBudget);
+		this->m_samplesPerFrame = std::max(0, samplesPerFrame);
 	}
 
 	void setPixelsPerSample(int pixelsPerSample)
@@ -68,22 +96,145 @@ public:
 		this->m_pixelsPerSample = std::max(4, pixelsPerSample);
 	}
 
+	// SSS_INVERSE_CDF_MODE_ANALYTIC / SSS_INVERSE_CDF_MODE_LUT_LINEAR / SSS_INVERSE_CDF_MODE_LUT_HERMITE
+	// Analytic by default, since the LUT approximates the inverse CDF (the result is NOT the same as the default)
+	void setInverseCdfMode(int inverseCdfMode)
+	{
+		this->m_inverseCdfMode = inverseCdfMode;
+	}
+
+	// The LUT is rebuilt by the next "go"
+	void setInverseCdfLUTSize(int inverseCdfLUTSize)
+	{
+		this->m_inverseCdfLUTSize = std::max(2, inverseCdfLUTSize);
+	}
+
+	// Off by default, since the center sample cdf is quantized into SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT buckets (the result is NOT the same as the default)
+	// NOTE: the kernel cache is used instead of the "SSS_INVERSE_CDF_MODE"
+	void setKernelCacheEnabled(bool kernelCacheEnabled)
+	{
+		this->m_kernelCacheEnabled = kernelCacheEnabled;
+	}
+
+	// LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY / FIBONACCI / R2 / SOBOL_OWEN / BLUE_NOISE
+	void setSequence(int sequence)
+	{
+		this->m_sequence = sequence;
+		this->m_kernelCacheDirty = true;
+	}
+
+	// SSS_MIS_MODE_NONE / BALANCE / POWER
+	// NOTE: the pixels which take fewer than SSS_MIS_MIN_SAMPLE_COUNT samples ignore the MIS
+	// NOTE: the kernels of the three channels are looked up from the same kernel cache
+	void setMisMode(int misMode)
+	{
+		this->m_misMode = misMode;
+	}
+
+	// SSS_BLUR_MODE_BURLEY / SSS_BLUR_MODE_SEPARABLE
+	// NOTE: the separable mode ignores the "sampleBudget", the "pixelsPerSample", the "inverseCdfMode", the "kernelCacheEnabled", the "sequence" and the "misMode"
+	void setBlurMode(int blurMode)
+	{
+		this->m_blurMode = blurMode;
+	}
+
+	// SSS_IRRADIANCE_ENCODING_* / SSS_DEPTH_ENCODING_* of the "irradianceSRV" and the "depthSRV" passed to the "go" (see "subsurface_scattering_gbuffer_encoding.hlsli")
+	// NOTE: the low resolution render targets are NOT encoded
+	void setGBufferEncoding(int irradianceEncoding, int depthEncoding)
+	{
+		this->m_irradianceEncoding = irradianceEncoding;
+		this->m_depthEncoding = depthEncoding;
+	}
+
+	const SSSKernelCache& getKernelCache() const
+	{
+		return this->m_kernelCache;
+	}
+
+	// The optional passes, each of which owns its shaders and render targets, and reads the inputs bound by the "go"
+	// NOTE: the adaptive sampling and the separable mode ignore the tile classification, and the separable mode ignores the mask pyramid and the irradiance pyramid
+	SSSUpsampler& getUpsampler()
+	{
+		return *this->upsampler;
+	}
+
+	SSSTemporalResolve& getTemporalResolve()
+	{
+		return *this->temporalResolve;
+	}
+
+	SSSTileClassifier& getTileClassifier()
+	{
+		return *this->tileClassifier;
+	}
+
+	SSSMaskPyramidBuilder& getMaskPyramidBuilder()
+	{
+		return *this->maskPyramidBuilder;
+	}
+
+	SSSIrradiancePyramidBuilder& getIrradiancePyramidBuilder()
+	{
+		return *this->irradiancePyramidBuilder;
+	}
+
 private:
-	DirectX::XMFLOAT3 m_scatteringDistance;
-	float m_worldScale;
+	void createInverseCdfLUT(ID3D11Device* device);
+	void uploadKernelCache(ID3D11DeviceContext* context);
+	void uploadProfiles(ID3D11DeviceContext* context, const SSSProfileTable& profiles);
+	void createTmpRT(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV);
+	void createAdaptiveRTs(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV);
+
 	bool m_postscatterEnabled;
 	int m_sampleBudget;
+	int m_samplesPerFrame;
 	int m_pixelsPerSample;
+	int m_inverseCdfMode;
+	int m_inverseCdfLUTSize;
+	bool m_kernelCacheEnabled;
+	bool m_kernelCacheDirty;
+	int m_sequence;
+	int m_misMode;
+	SSSKernelCache m_kernelCache;
+	int m_blurMode;
+	SSSSeparableKernel m_separableKernel;
+	int m_irradianceEncoding;
+	int m_depthEncoding;
 
 	ID3D11VertexShader* SSS_VS;
 	ID3D11PixelShader* SSS_Blur_PS;
+	ID3D11PixelShader* SSS_Blur_SeparableHorizontal_PS;
+	ID3D11PixelShader* SSS_Blur_SeparableVertical_PS;
+	ID3D11PixelShader* SSS_Blur_Pilot_PS;
+	ID3D11PixelShader* SSS_Blur_Refinement_PS;
+	ID3D11PixelShader* SSS_Blur_TextureSpace_PS;
 	ID3D11Buffer* CbufUpdatedPerFrame;
 	ID3D11DepthStencilState* BlurStencil;
 	ID3D11BlendState* AddBlending;
 	ID3D11SamplerState* PointSampler;
 	ID3D11SamplerState* LinearSampler;
+	ID3D11Texture1D* InverseCdfLUT;
+	ID3D11ShaderResourceView* InverseCdfLUTSRV;
+	int InverseCdfLUTSize;
+	ID3D11Buffer* KernelCache;
+	ID3D11ShaderResourceView* KernelCacheSRV;
+	ID3D11Buffer* Profiles;
+	ID3D11ShaderResourceView* ProfilesSRV;
+	uint64_t ProfilesVersion;
+	ID3D11Buffer* SeparableKernel;
+	ID3D11ShaderResourceView* SeparableKernelSRV;
+	// The intermediate render target of the separable mode (created by the first separable "go", with the size of the irradiance)
 	RenderTarget* tmpRT;
+	// The adaptive sampling render targets (created by the first adaptive "go", with the size of the blur)
+	// (radiance.rgb, pilot_sample_count) and (deviation, pilot_sample_count, covered, 0) with the mips
+	RenderTarget* pilotRT;
+	RenderTarget* pilotErrorRT;
 	Quad* quad;
+	SSSUpsampler* upsampler;
+	SSSTemporalResolve* temporalResolve;
+	SSSTileClassifier* tileClassifier;
+	SSSMaskPyramidBuilder* maskPyramidBuilder;
+	SSSIrradiancePyramidBuilder* irradiancePyramidBuilder;
 };
 
 #endif
@@ -0,0 +1,278 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include "SSSPyramidBuilder.h"
+
+#include "../../dxbc/SSS_Blur_MaskPyramidBase_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_MaskPyramidReduce_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_IrradiancePyramidBase_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_IrradiancePyramidReduce_PS_bytecode.inl"
+
+#define TEX_MASK_PYRAMID 20
+#define TEX_MASK_PYRAMID_PREVIOUS_LEVEL 21
+#define TEX_IRRADIANCE_PYRAMID 22
+#define TEX_IRRADIANCE_PYRAMID_PREVIOUS_LEVEL 24
+
+SSSMaskPyramidBuilder::SSSMaskPyramidBuilder(ID3D11Device* device) : m_enabled(true),
+	maskPyramidRT(NULL),
+	levelCount(0)
+{
+	HRESULT hr;
+
+	for (int level = 0; level < SSS_MASK_PYRAMID_MAX_LEVEL_COUNT; ++level)
+	{
+		levelRTVs[level] = NULL;
+		levelSRVs[level] = NULL;
+	}
+
+	V(device->CreatePixelShader(SSS_Blur_MaskPyramidBase_PS_bytecode, sizeof(SSS_Blur_MaskPyramidBase_PS_bytecode), NULL, &SSS_Blur_MaskPyramidBase_PS));
+	V(device->CreatePixelShader(SSS_Blur_MaskPyramidReduce_PS_bytecode, sizeof(SSS_Blur_MaskPyramidReduce_PS_bytecode), NULL, &SSS_Blur_MaskPyramidReduce_PS));
+}
+
+SSSMaskPyramidBuilder::~SSSMaskPyramidBuilder()
+{
+	releaseRT();
+	SAFE_RELEASE(SSS_Blur_MaskPyramidReduce_PS);
+	SAFE_RELEASE(SSS_Blur_MaskPyramidBase_PS);
+}
+
+void SSSMaskPyramidBuilder::createRT(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV)
+{
+	HRESULT hr;
+
+	ID3D11Resource* irradianceResource = NULL;
+	irradianceSRV->GetResource(&irradianceResource);
+	D3D11_TEXTURE2D_DESC irradianceDesc;
+	static_cast<ID3D11Texture2D*>(irradianceResource)->GetDesc(&irradianceDesc);
+	SAFE_RELEASE(irradianceResource);
+
+	const int newLevelCount = subsurface_scattering_mask_pyramid_level_count(static_cast<int>(irradianceDesc.Width), static_cast<int>(irradianceDesc.Height));
+	const int width = subsurface_scattering_mask_pyramid_padded_size(static_cast<int>(irradianceDesc.Width), newLevelCount);
+	const int height = subsurface_scattering_mask_pyramid_padded_size(static_cast<int>(irradianceDesc.Height), newLevelCount);
+	if ((NULL != maskPyramidRT) && (levelCount == newLevelCount) && (maskPyramidRT->getWidth() == width) && (maskPyramidRT->getHeight() == height))
+	{
+		return;
+	}
+
+	releaseRT();
+
+	ID3D11Device* device = NULL;
+	context->GetDevice(&device);
+	// NOTE: the subsurface mask is compared with "1 / 255", which is NOT exact in the half float
+	maskPyramidRT = new RenderTarget(device, width, height, DXGI_FORMAT_R32G32B32A32_FLOAT, NoMSAA(), true, true);
+	levelCount = newLevelCount;
+
+	// The reduce writes the level and reads the previous level, s.t. each level has its own views
+	for (int level = 0; level < levelCount; ++level)
+	{
+		D3D11_RENDER_TARGET_VIEW_DESC rtdesc = {};
+		rtdesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		rtdesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+		rtdesc.Texture2D.MipSlice = level;
+		V(device->CreateRenderTargetView(*maskPyramidRT, &rtdesc, &levelRTVs[level]));
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srdesc = {};
+		srdesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		srdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srdesc.Texture2D.MostDetailedMip = level;
+		srdesc.Texture2D.MipLevels = 1;
+		V(device->CreateShaderResourceView(*maskPyramidRT, &srdesc, &levelSRVs[level]));
+	}
+	SAFE_RELEASE(device);
+}
+
+void SSSMaskPyramidBuilder::releaseRT()
+{
+	for (int level = 0; level < SSS_MASK_PYRAMID_MAX_LEVEL_COUNT; ++level)
+	{
+		SAFE_RELEASE(levelSRVs[level]);
+		SAFE_RELEASE(levelRTVs[level]);
+	}
+	SAFE_DELETE(maskPyramidRT);
+	levelCount = 0;
+}
+
+void SSSMaskPyramidBuilder::build(ID3D11DeviceContext* context, Quad* quad)
+{
+	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	ID3D11RenderTargetView* pRenderTargetViews[1] = { NULL };
+
+	// The viewport of the blur is restored after the reduce
+	UINT BlurNumViewports = 1U;
+	D3D11_VIEWPORT BlurViewport;
+	context->RSGetViewports(&BlurNumViewports, &BlurViewport);
+
+	// Base: albedo + stencil -> level 0
+	// NOTE: the padding is written as well, s.t. the pyramid does NOT need to be cleared
+	D3D11_VIEWPORT LevelViewport = { 0.0f, 0.0f, float(maskPyramidRT->getWidth()), float(maskPyramidRT->getHeight()), 0.0f, 1.0f };
+	context->RSSetViewports(1U, &LevelViewport);
+	context->PSSetShader(SSS_Blur_MaskPyramidBase_PS, NULL, 0);
+	context->OMSetBlendState(NULL, BlendFactor, 0xFFFFFFFF);
+	context->OMSetRenderTargets(1, &levelRTVs[0], NULL);
+	quad->draw(context);
+	context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+
+	// Reduce: level - 1 -> level
+	context->PSSetShader(SSS_Blur_MaskPyramidReduce_PS, NULL, 0);
+	for (int level = 1; level < levelCount; ++level)
+	{
+		LevelViewport.Width = float(maskPyramidRT->getWidth() >> level);
+		LevelViewport.Height = float(maskPyramidRT->getHeight() >> level);
+		context->RSSetViewports(1U, &LevelViewport);
+		context->PSSetShaderResources(TEX_MASK_PYRAMID_PREVIOUS_LEVEL, 1U, &levelSRVs[level - 1]);
+		context->OMSetRenderTargets(1, &levelRTVs[level], NULL);
+		quad->draw(context);
+		context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+	}
+
+	ID3D11ShaderResourceView* maskPyramidSRVs[2] = { *maskPyramidRT, NULL };
+	context->PSSetShaderResources(TEX_MASK_PYRAMID, 2U, maskPyramidSRVs);
+	context->RSSetViewports(BlurNumViewports, &BlurViewport);
+}
+
+SSSIrradiancePyramidBuilder::SSSIrradiancePyramidBuilder(ID3D11Device* device) : m_enabled(false),
+	irradiancePyramidRT(NULL),
+	irradiancePyramidDepthRT(NULL),
+	levelCount(0)
+{
+	HRESULT hr;
+
+	for (int level = 0; level < SSS_IRRADIANCE_PYRAMID_MAX_LEVEL_COUNT; ++level)
+	{
+		for (int target = 0; target < 2; ++target)
+		{
+			levelRTVs[level][target] = NULL;
+			levelSRVs[level][target] = NULL;
+		}
+	}
+
+	V(device->CreatePixelShader(SSS_Blur_IrradiancePyramidBase_PS_bytecode, sizeof(SSS_Blur_IrradiancePyramidBase_PS_bytecode), NULL, &SSS_Blur_IrradiancePyramidBase_PS));
+	V(device->CreatePixelShader(SSS_Blur_IrradiancePyramidReduce_PS_bytecode, sizeof(SSS_Blur_IrradiancePyramidReduce_PS_bytecode), NULL, &SSS_Blur_IrradiancePyramidReduce_PS));
+}
+
+SSSIrradiancePyramidBuilder::~SSSIrradiancePyramidBuilder()
+{
+	releaseRTs();
+	SAFE_RELEASE(SSS_Blur_IrradiancePyramidReduce_PS);
+	SAFE_RELEASE(SSS_Blur_IrradiancePyramidBase_PS);
+}
+
+void SSSIrradiancePyramidBuilder::createRTs(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV)
+{
+	HRESULT hr;
+
+	ID3D11Resource* irradianceResource = NULL;
+	irradianceSRV->GetResource(&irradianceResource);
+	D3D11_TEXTURE2D_DESC irradianceDesc;
+	static_cast<ID3D11Texture2D*>(irradianceResource)->GetDesc(&irradianceDesc);
+	SAFE_RELEASE(irradianceResource);
+
+	const int newLevelCount = subsurface_scattering_mask_pyramid_level_count(static_cast<int>(irradianceDesc.Width), static_cast<int>(irradianceDesc.Height));
+	const int width = subsurface_scattering_mask_pyramid_padded_size(static_cast<int>(irradianceDesc.Width), newLevelCount);
+	const int height = subsurface_scattering_mask_pyramid_padded_size(static_cast<int>(irradianceDesc.Height), newLevelCount);
+	if ((NULL != irradiancePyramidRT) && (levelCount == newLevelCount) && (irradiancePyramidRT->getWidth() == width) && (irradiancePyramidRT->getHeight() == height))
+	{
+		return;
+	}
+
+	releaseRTs();
+
+	ID3D11Device* device = NULL;
+	context->GetDevice(&device);
+	// NOTE: the profile index is a small integer, which is exact in the half float
+	const DXGI_FORMAT formats[2] = { DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R32_FLOAT };
+	irradiancePyramidRT = new RenderTarget(device, width, height, formats[0], NoMSAA(), true, true);
+	irradiancePyramidDepthRT = new RenderTarget(device, width, height, formats[1], NoMSAA(), true, true);
+	levelCount = newLevelCount;
+
+	// The reduce writes the level and reads the previous level, s.t. each level has its own views
+	RenderTarget* const targets[2] = { irradiancePyramidRT, irradiancePyramidDepthRT };
+	for (int level = 0; level < levelCount; ++level)
+	{
+		for (int target = 0; target < 2; ++target)
+		{
+			D3D11_RENDER_TARGET_VIEW_DESC rtdesc = {};
+			rtdesc.Format = formats[target];
+			rtdesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+			rtdesc.Texture2D.MipSlice = level;
+			V(device->CreateRenderTargetView(*targets[target], &rtdesc, &levelRTVs[level][target]));
+
+			D3D11_SHADER_RESOURCE_VIEW_DESC srdesc = {};
+			srdesc.Format = formats[target];
+			srdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+			srdesc.Texture2D.MostDetailedMip = level;
+			srdesc.Texture2D.MipLevels = 1;
+			V(device->CreateShaderResourceView(*targets[target], &srdesc, &levelSRVs[level][target]));
+		}
+	}
+	SAFE_RELEASE(device);
+}
+
+void SSSIrradiancePyramidBuilder::releaseRTs()
+{
+	for (int level = 0; level < SSS_IRRADIANCE_PYRAMID_MAX_LEVEL_COUNT; ++level)
+	{
+		for (int target = 0; target < 2; ++target)
+		{
+			SAFE_RELEASE(levelSRVs[level][target]);
+			SAFE_RELEASE(levelRTVs[level][target]);
+		}
+	}
+	SAFE_DELETE(irradiancePyramidDepthRT);
+	SAFE_DELETE(irradiancePyramidRT);
+	levelCount = 0;
+}
+
+void SSSIrradiancePyramidBuilder::build(ID3D11DeviceContext* context, Quad* quad)
+{
+	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	ID3D11RenderTargetView* pRenderTargetViews[2] = { NULL, NULL };
+
+	// The viewport of the blur is restored after the reduce
+	UINT BlurNumViewports = 1U;
+	D3D11_VIEWPORT BlurViewport;
+	context->RSGetViewports(&BlurNumViewports, &BlurViewport);
+
+	// Base: irradiance + albedo + depth + stencil -> level 0
+	// NOTE: the padding is written as well, s.t. the pyramid does NOT need to be cleared
+	D3D11_VIEWPORT LevelViewport = { 0.0f, 0.0f, float(irradiancePyramidRT->getWidth()), float(irradiancePyramidRT->getHeight()), 0.0f, 1.0f };
+	context->RSSetViewports(1U, &LevelViewport);
+	context->PSSetShader(SSS_Blur_IrradiancePyramidBase_PS, NULL, 0);
+	context->OMSetBlendState(NULL, BlendFactor, 0xFFFFFFFF);
+	context->OMSetRenderTargets(2, levelRTVs[0], NULL);
+	quad->draw(context);
+	context->OMSetRenderTargets(2, pRenderTargetViews, NULL);
+
+	// Reduce: level - 1 -> level
+	// NOTE: the level is derived from the size of the previous level by the shader
+	context->PSSetShader(SSS_Blur_IrradiancePyramidReduce_PS, NULL, 0);
+	for (int level = 1; level < levelCount; ++level)
+	{
+		LevelViewport.Width = float(irradiancePyramidRT->getWidth() >> level);
+		LevelViewport.Height = float(irradiancePyramidRT->getHeight() >> level);
+		context->RSSetViewports(1U, &LevelViewport);
+		context->PSSetShaderResources(TEX_IRRADIANCE_PYRAMID_PREVIOUS_LEVEL, 2U, levelSRVs[level - 1]);
+		context->OMSetRenderTargets(2, levelRTVs[level], NULL);
+		quad->draw(context);
+		context->OMSetRenderTargets(2, pRenderTargetViews, NULL);
+	}
+
+	ID3D11ShaderResourceView* irradiancePyramidSRVs[4] = { *irradiancePyramidRT, *irradiancePyramidDepthRT, NULL, NULL };
+	context->PSSetShaderResources(TEX_IRRADIANCE_PYRAMID, 4U, irradiancePyramidSRVs);
+	context->RSSetViewports(BlurNumViewports, &BlurViewport);
+}
@@ -0,0 +1,118 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _SSSPyramidBuilder_H_
+#define _SSSPyramidBuilder_H_ 1
+
+#include <sdkddkver.h>
+#define NOMINMAX 1
+#define WIN32_LEAN_AND_MEAN 1
+#include <DXUT.h>
+#include "RenderTarget.h"
+#include "CPU/subsurface_scattering_mask_pyramid.h"
+#include "CPU/subsurface_scattering_irradiance_pyramid.h"
+
+// The min/max pyramid of the subsurface mask, built once per frame, s.t. the samples of which the footprint is known to be empty (or another profile) skip the fetch of the full resolution, and the pixels of which the whole filter is known to be covered skip the test of all samples (see "subsurface_scattering_mask_pyramid.hlsli")
+class SSSMaskPyramidBuilder
+{
+public:
+	SSSMaskPyramidBuilder(ID3D11Device* device);
+	~SSSMaskPyramidBuilder();
+
+	void setEnabled(bool enabled)
+	{
+		this->m_enabled = enabled;
+	}
+
+	bool isEnabled() const
+	{
+		return this->m_enabled;
+	}
+
+	// The pyramid is created by the first "go", with the size of the blur padded to the multiple of 2^(levelCount - 1)
+	void createRT(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV);
+
+	// Base: the albedo + the stencil bound by the caller -> level 0, and reduce: level - 1 -> level (no stencil buffer and no blending)
+	// The pyramid is bound for the blur, and the viewport of the caller is restored
+	void build(ID3D11DeviceContext* context, Quad* quad);
+
+	int getLevelCount() const
+	{
+		return this->levelCount;
+	}
+
+private:
+	void releaseRT();
+
+	bool m_enabled;
+
+	ID3D11PixelShader* SSS_Blur_MaskPyramidBase_PS;
+	ID3D11PixelShader* SSS_Blur_MaskPyramidReduce_PS;
+	// (min_mask, max_mask, coverage, profile) with the mips, and the views of each level (written by the reduce of the next level)
+	RenderTarget* maskPyramidRT;
+	int levelCount;
+	ID3D11RenderTargetView* levelRTVs[SSS_MASK_PYRAMID_MAX_LEVEL_COUNT];
+	ID3D11ShaderResourceView* levelSRVs[SSS_MASK_PYRAMID_MAX_LEVEL_COUNT];
+};
+
+// The depth-aware mip chain of the irradiance and the view depth, built once per frame, s.t. each sample of the Burley blur fetches the level which matches its share of the disk (see "subsurface_scattering_irradiance_pyramid.hlsli")
+class SSSIrradiancePyramidBuilder
+{
+public:
+	SSSIrradiancePyramidBuilder(ID3D11Device* device);
+	~SSSIrradiancePyramidBuilder();
+
+	// NOTE: the result is NOT the same (the irradiance is prefiltered)
+	void setEnabled(bool enabled)
+	{
+		this->m_enabled = enabled;
+	}
+
+	bool isEnabled() const
+	{
+		return this->m_enabled;
+	}
+
+	// The pyramid is created by the first "go", with the same layout as the mask pyramid
+	void createRTs(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV);
+
+	// Base: the irradiance + the albedo + the depth + the stencil bound by the caller -> level 0, and reduce: level - 1 -> level (no stencil buffer and no blending)
+	// The pyramid is bound for the blur, and the viewport of the caller is restored
+	void build(ID3D11DeviceContext* context, Quad* quad);
+
+	int getLevelCount() const
+	{
+		return this->levelCount;
+	}
+
+private:
+	void releaseRTs();
+
+	bool m_enabled;
+
+	ID3D11PixelShader* SSS_Blur_IrradiancePyramidBase_PS;
+	ID3D11PixelShader* SSS_Blur_IrradiancePyramidReduce_PS;
+	// (total_diffuse_reflectance_pre_scatter_multiply_form_factor, profile) and the view depth with the mips, and the views of each level (written by the reduce of the next level)
+	RenderTarget* irradiancePyramidRT;
+	RenderTarget* irradiancePyramidDepthRT;
+	int levelCount;
+	ID3D11RenderTargetView* levelRTVs[SSS_IRRADIANCE_PYRAMID_MAX_LEVEL_COUNT][2];
+	ID3D11ShaderResourceView* levelSRVs[SSS_IRRADIANCE_PYRAMID_MAX_LEVEL_COUNT][2];
+};
+
+#endif
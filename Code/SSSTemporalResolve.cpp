@@ -0,0 +1,155 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include "SSSTemporalResolve.h"
+
+#include "../../dxbc/SSS_Blur_Temporal_PS_bytecode.inl"
+
+#define TEX_TEMPORAL_CURRENT 12
+
+SSSTemporalResolve::SSSTemporalResolve(ID3D11Device* device) : m_enabled(false),
+	m_blend(SSS_TEMPORAL_DEFAULT_BLEND),
+	m_frameIndex(0U),
+	m_historyValid(false),
+	m_historyIndex(0),
+	currentRT(NULL)
+{
+	HRESULT hr;
+
+	historyRT[0] = NULL;
+	historyRT[1] = NULL;
+	historyGuideRT[0] = NULL;
+	historyGuideRT[1] = NULL;
+	DirectX::XMStoreFloat4x4(&m_prevViewProj, DirectX::XMMatrixIdentity());
+
+	V(device->CreatePixelShader(SSS_Blur_Temporal_PS_bytecode, sizeof(SSS_Blur_Temporal_PS_bytecode), NULL, &SSS_Blur_Temporal_PS));
+
+	// RT0: the radiance is added to the main render target, RT1 and RT2: the history is overwritten
+	D3D11_BLEND_DESC TemporalBlendingDesc = {};
+	TemporalBlendingDesc.AlphaToCoverageEnable = FALSE;
+	TemporalBlendingDesc.IndependentBlendEnable = TRUE;
+	TemporalBlendingDesc.RenderTarget[0].BlendEnable = TRUE;
+	TemporalBlendingDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+	TemporalBlendingDesc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+	TemporalBlendingDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+	TemporalBlendingDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+	TemporalBlendingDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+	TemporalBlendingDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	TemporalBlendingDesc.RenderTarget[0].RenderTargetWriteMask = ((D3D11_COLOR_WRITE_ENABLE_RED | D3D11_COLOR_WRITE_ENABLE_GREEN) | D3D11_COLOR_WRITE_ENABLE_BLUE);
+	TemporalBlendingDesc.RenderTarget[1].BlendEnable = FALSE;
+	TemporalBlendingDesc.RenderTarget[1].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	TemporalBlendingDesc.RenderTarget[2].BlendEnable = FALSE;
+	TemporalBlendingDesc.RenderTarget[2].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	V(device->CreateBlendState(&TemporalBlendingDesc, &TemporalBlending));
+}
+
+SSSTemporalResolve::~SSSTemporalResolve()
+{
+	SAFE_DELETE(historyGuideRT[1]);
+	SAFE_DELETE(historyGuideRT[0]);
+	SAFE_DELETE(historyRT[1]);
+	SAFE_DELETE(historyRT[0]);
+	SAFE_DELETE(currentRT);
+	SAFE_RELEASE(TemporalBlending);
+	SAFE_RELEASE(SSS_Blur_Temporal_PS);
+}
+
+void SSSTemporalResolve::prepare(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV)
+{
+	if (!m_enabled)
+	{
+		m_historyValid = false;
+		return;
+	}
+
+	ID3D11Resource* irradianceResource = NULL;
+	irradianceSRV->GetResource(&irradianceResource);
+	D3D11_TEXTURE2D_DESC irradianceDesc;
+	static_cast<ID3D11Texture2D*>(irradianceResource)->GetDesc(&irradianceDesc);
+	SAFE_RELEASE(irradianceResource);
+
+	if ((NULL == currentRT) || (currentRT->getWidth() != static_cast<int>(irradianceDesc.Width)) || (currentRT->getHeight() != static_cast<int>(irradianceDesc.Height)))
+	{
+		SAFE_DELETE(historyGuideRT[1]);
+		SAFE_DELETE(historyGuideRT[0]);
+		SAFE_DELETE(historyRT[1]);
+		SAFE_DELETE(historyRT[0]);
+		SAFE_DELETE(currentRT);
+
+		ID3D11Device* device = NULL;
+		context->GetDevice(&device);
+		currentRT = new RenderTarget(device, static_cast<int>(irradianceDesc.Width), static_cast<int>(irradianceDesc.Height), DXGI_FORMAT_R16G16B16A16_FLOAT);
+		for (int historyIndex = 0; historyIndex < 2; ++historyIndex)
+		{
+			historyRT[historyIndex] = new RenderTarget(device, static_cast<int>(irradianceDesc.Width), static_cast<int>(irradianceDesc.Height), DXGI_FORMAT_R16G16B16A16_FLOAT);
+			// NOTE: the view space position z is compared with the relative threshold, which is NOT precise enough in the half float
+			historyGuideRT[historyIndex] = new RenderTarget(device, static_cast<int>(irradianceDesc.Width), static_cast<int>(irradianceDesc.Height), DXGI_FORMAT_R32G32_FLOAT);
+		}
+		SAFE_RELEASE(device);
+
+		m_historyValid = false;
+	}
+
+	FLOAT ClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	context->ClearRenderTargetView(*currentRT, ClearColor);
+}
+
+DirectX::XMFLOAT4X4 SSSTemporalResolve::getReprojection(const DirectX::XMFLOAT4X4& currViewProj) const
+{
+	DirectX::XMFLOAT4X4 reprojection;
+	DirectX::XMStoreFloat4x4(&reprojection, DirectX::XMMatrixMultiply(DirectX::XMMatrixInverse(NULL, DirectX::XMLoadFloat4x4(&currViewProj)), DirectX::XMLoadFloat4x4(m_historyValid ? &m_prevViewProj : &currViewProj)));
+	return reprojection;
+}
+
+void SSSTemporalResolve::resolve(ID3D11DeviceContext* context,
+	Quad* quad,
+	ID3D11RenderTargetView* mainRTV,
+	ID3D11DepthStencilView* depthDSV,
+	ID3D11ShaderResourceView* velocitySRV,
+	const DirectX::XMFLOAT4X4& currViewProj)
+{
+	// NOTE: the pixels which are NOT written (stencil == 0) are rejected by the next frame (the view space position z is zero)
+	const int prevHistoryIndex = m_historyIndex;
+	const int nextHistoryIndex = 1 - m_historyIndex;
+
+	FLOAT ClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	if (!m_historyValid)
+	{
+		context->ClearRenderTargetView(*historyRT[prevHistoryIndex], ClearColor);
+		context->ClearRenderTargetView(*historyGuideRT[prevHistoryIndex], ClearColor);
+	}
+	context->ClearRenderTargetView(*historyRT[nextHistoryIndex], ClearColor);
+	context->ClearRenderTargetView(*historyGuideRT[nextHistoryIndex], ClearColor);
+
+	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	ID3D11RenderTargetView* pRenderTargetViews[3] = { NULL, NULL, NULL };
+
+	ID3D11ShaderResourceView* temporalSRVs[4] = { *currentRT, *historyRT[prevHistoryIndex], *historyGuideRT[prevHistoryIndex], velocitySRV };
+	context->PSSetShaderResources(TEX_TEMPORAL_CURRENT, 4U, temporalSRVs);
+	ID3D11RenderTargetView* temporalRTVs[3] = { mainRTV, *historyRT[nextHistoryIndex], *historyGuideRT[nextHistoryIndex] };
+	context->PSSetShader(SSS_Blur_Temporal_PS, NULL, 0);
+	context->OMSetBlendState(TemporalBlending, BlendFactor, 0xFFFFFFFF);
+	context->OMSetRenderTargets(3, temporalRTVs, depthDSV);
+	quad->draw(context);
+	context->OMSetRenderTargets(3, pRenderTargetViews, NULL);
+
+	m_historyIndex = nextHistoryIndex;
+	m_historyValid = true;
+	m_prevViewProj = currViewProj;
+	++m_frameIndex;
+}
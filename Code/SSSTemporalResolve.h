@@ -0,0 +1,108 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _SSSTemporalResolve_H_
+#define _SSSTemporalResolve_H_ 1
+
+#include <sdkddkver.h>
+#define NOMINMAX 1
+#define WIN32_LEAN_AND_MEAN 1
+#include <DXUT.h>
+#include <DirectXMath.h>
+#include "RenderTarget.h"
+#include "CPU/subsurface_scattering_temporal.h"
+
+// The sample pattern is rotated per frame, and the blurred radiance is accumulated into the history, which is reprojected by the motion vectors and rejected by the depth and the subsurface mask (see "subsurface_scattering_temporal.hlsli")
+class SSSTemporalResolve
+{
+public:
+	SSSTemporalResolve(ID3D11Device* device);
+	~SSSTemporalResolve();
+
+	// NOTE: the history is discarded when the temporal accumulation is disabled
+	void setEnabled(bool enabled)
+	{
+		this->m_enabled = enabled;
+	}
+
+	bool isEnabled() const
+	{
+		return this->m_enabled;
+	}
+
+	// The minimum weight of the current frame (exponential moving average), namely, about "1 / blend" frames are accumulated
+	void setBlend(float blend)
+	{
+		this->m_blend = std::min(std::max(blend, 1.0f / SSS_TEMPORAL_MAX_HISTORY_LENGTH), 1.0f);
+	}
+
+	float getBlend() const
+	{
+		return this->m_blend;
+	}
+
+	// The render targets are created by the first enabled "prepare", with the size of the irradiance
+	// The "currentRT" is cleared, since the pixels which are NOT written (stencil == 0) are NOT read by the resolve (stencil test)
+	void prepare(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV);
+
+	// NOTE: the sample pattern is NOT rotated (and the radii are NOT offset) without the temporal accumulation
+	float2 getSampleRotation() const
+	{
+		return subsurface_scattering_sample_rotation(this->m_enabled ? this->m_frameIndex : 0U);
+	}
+
+	float getSampleRadiusOffset() const
+	{
+		return subsurface_scattering_sample_radius_offset(subsurface_scattering_sample_radius_offset_index(this->m_enabled ? this->m_frameIndex : 0U));
+	}
+
+	// current NDC -> previous clip space
+	// NOTE: the history is rejected anyway if it is NOT valid
+	DirectX::XMFLOAT4X4 getReprojection(const DirectX::XMFLOAT4X4& currViewProj) const;
+
+	// The blurred radiance of the current frame, which is written instead of the main render target
+	ID3D11RenderTargetView* getCurrentRTV() const
+	{
+		return static_cast<ID3D11RenderTargetView*>(*this->currentRT);
+	}
+
+	// Resolve: currentRT + history[prev] -> mainRTV (the "temporalBlending") + history[next]
+	void resolve(ID3D11DeviceContext* context,
+		Quad* quad,
+		ID3D11RenderTargetView* mainRTV,
+		ID3D11DepthStencilView* depthDSV,
+		ID3D11ShaderResourceView* velocitySRV,
+		const DirectX::XMFLOAT4X4& currViewProj);
+
+private:
+	bool m_enabled;
+	float m_blend;
+	uint32_t m_frameIndex;
+	bool m_historyValid;
+	int m_historyIndex;
+	DirectX::XMFLOAT4X4 m_prevViewProj;
+
+	ID3D11PixelShader* SSS_Blur_Temporal_PS;
+	ID3D11BlendState* TemporalBlending;
+	// The blurred radiance of the current frame, and the ping-pong history: (radiance.rgb, history_length) and (view_space_position_z, subsurface_mask)
+	RenderTarget* currentRT;
+	RenderTarget* historyRT[2];
+	RenderTarget* historyGuideRT[2];
+};
+
+#endif
@@ -0,0 +1,133 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include "SSSTileClassifier.h"
+
+#include "../../dxbc/SSS_Blur_TileState_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_TileClassify_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_TileInterior_VS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_TileEdge_VS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_Interior_PS_bytecode.inl"
+
+#define TEX_IRRADIANCE 1
+#define TEX_TILE_STATE 18
+#define TEX_TILE_CLASS 19
+
+SSSTileClassifier::SSSTileClassifier(ID3D11Device* device) : m_enabled(true),
+	tileStateRT(NULL),
+	tileClassRT(NULL)
+{
+	HRESULT hr;
+
+	V(device->CreatePixelShader(SSS_Blur_TileState_PS_bytecode, sizeof(SSS_Blur_TileState_PS_bytecode), NULL, &SSS_Blur_TileState_PS));
+	V(device->CreatePixelShader(SSS_Blur_TileClassify_PS_bytecode, sizeof(SSS_Blur_TileClassify_PS_bytecode), NULL, &SSS_Blur_TileClassify_PS));
+	V(device->CreateVertexShader(SSS_Blur_TileInterior_VS_bytecode, sizeof(SSS_Blur_TileInterior_VS_bytecode), NULL, &SSS_Blur_TileInterior_VS));
+	V(device->CreateVertexShader(SSS_Blur_TileEdge_VS_bytecode, sizeof(SSS_Blur_TileEdge_VS_bytecode), NULL, &SSS_Blur_TileEdge_VS));
+	V(device->CreatePixelShader(SSS_Blur_Interior_PS_bytecode, sizeof(SSS_Blur_Interior_PS_bytecode), NULL, &SSS_Blur_Interior_PS));
+}
+
+SSSTileClassifier::~SSSTileClassifier()
+{
+	SAFE_DELETE(tileClassRT);
+	SAFE_DELETE(tileStateRT);
+	SAFE_RELEASE(SSS_Blur_Interior_PS);
+	SAFE_RELEASE(SSS_Blur_TileEdge_VS);
+	SAFE_RELEASE(SSS_Blur_TileInterior_VS);
+	SAFE_RELEASE(SSS_Blur_TileClassify_PS);
+	SAFE_RELEASE(SSS_Blur_TileState_PS);
+}
+
+void SSSTileClassifier::createRTs(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV)
+{
+	ID3D11Resource* irradianceResource = NULL;
+	irradianceSRV->GetResource(&irradianceResource);
+	D3D11_TEXTURE2D_DESC irradianceDesc;
+	static_cast<ID3D11Texture2D*>(irradianceResource)->GetDesc(&irradianceDesc);
+	SAFE_RELEASE(irradianceResource);
+
+	const int width = subsurface_scattering_tile_count(static_cast<int>(irradianceDesc.Width));
+	const int height = subsurface_scattering_tile_count(static_cast<int>(irradianceDesc.Height));
+	if ((NULL != tileClassRT) && (tileClassRT->getWidth() == width) && (tileClassRT->getHeight() == height))
+	{
+		return;
+	}
+
+	SAFE_DELETE(tileClassRT);
+	SAFE_DELETE(tileStateRT);
+
+	ID3D11Device* device = NULL;
+	context->GetDevice(&device);
+	tileStateRT = new RenderTarget(device, width, height, DXGI_FORMAT_R16_UINT);
+	tileClassRT = new RenderTarget(device, width, height, DXGI_FORMAT_R8G8B8A8_UINT);
+	SAFE_RELEASE(device);
+}
+
+void SSSTileClassifier::go(ID3D11DeviceContext* context,
+	Quad* quad,
+	ID3D11RenderTargetView* blurRTV,
+	ID3D11ShaderResourceView* blurIrradianceSRV,
+	ID3D11DepthStencilView* blurDSV,
+	ID3D11BlendState* blurBlending,
+	ID3D11PixelShader* edgePS)
+{
+	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	ID3D11RenderTargetView* pRenderTargetViews[1] = { NULL };
+
+	// The viewport of the blur is restored by the tile draws
+	UINT BlurNumViewports = 1U;
+	D3D11_VIEWPORT BlurViewport;
+	context->RSGetViewports(&BlurNumViewports, &BlurViewport);
+
+	// State: albedo + stencil -> tileStateRT (no stencil buffer and no blending)
+	tileStateRT->setViewport(context);
+	context->PSSetShader(SSS_Blur_TileState_PS, NULL, 0);
+	context->OMSetBlendState(NULL, BlendFactor, 0xFFFFFFFF);
+	context->OMSetRenderTargets(1, *tileStateRT, NULL);
+	quad->draw(context);
+	context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+
+	// Classify: tileStateRT -> tileClassRT (no stencil buffer and no blending)
+	ID3D11ShaderResourceView* tileStateSRV = *tileStateRT;
+	context->PSSetShaderResources(TEX_TILE_STATE, 1U, &tileStateSRV);
+	context->PSSetShader(SSS_Blur_TileClassify_PS, NULL, 0);
+	context->OMSetRenderTargets(1, *tileClassRT, NULL);
+	quad->draw(context);
+	context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+
+	// Interior and edge: one instance per tile, of which the quad is culled by the vertex shader if the class does NOT match, s.t. the empty tiles are NOT rasterized at all
+	// NOTE: the tile class is read by the vertex shader, and the vertices are generated from the SV_VERTEXID without the vertex buffer
+	const UINT tileCount = static_cast<UINT>(tileClassRT->getWidth() * tileClassRT->getHeight());
+	ID3D11ShaderResourceView* tileClassSRV = *tileClassRT;
+	context->RSSetViewports(BlurNumViewports, &BlurViewport);
+	context->VSSetShaderResources(TEX_IRRADIANCE, 1U, &blurIrradianceSRV);
+	context->VSSetShaderResources(TEX_TILE_CLASS, 1U, &tileClassSRV);
+	context->IASetInputLayout(NULL);
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	context->OMSetBlendState(blurBlending, BlendFactor, 0xFFFFFFFF);
+	context->OMSetRenderTargets(1, &blurRTV, blurDSV);
+
+	context->VSSetShader(SSS_Blur_TileInterior_VS, NULL, 0);
+	context->PSSetShader(SSS_Blur_Interior_PS, NULL, 0);
+	context->DrawInstanced(4U, tileCount, 0U, 0U);
+
+	context->VSSetShader(SSS_Blur_TileEdge_VS, NULL, 0);
+	context->PSSetShader(edgePS, NULL, 0);
+	context->DrawInstanced(4U, tileCount, 0U, 0U);
+
+	context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+}
@@ -0,0 +1,73 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _SSSTileClassifier_H_
+#define _SSSTileClassifier_H_ 1
+
+#include <sdkddkver.h>
+#define NOMINMAX 1
+#define WIN32_LEAN_AND_MEAN 1
+#include <DXUT.h>
+#include "RenderTarget.h"
+#include "CPU/subsurface_scattering_tile_classification.h"
+
+// The tiles (SSS_TILE_SIZE x SSS_TILE_SIZE) are classified by the subsurface mask and the stencil, s.t. the empty tiles are skipped and the interior tiles are drawn with the cheaper variant (see "subsurface_scattering_tile_classification.hlsli")
+class SSSTileClassifier
+{
+public:
+	SSSTileClassifier(ID3D11Device* device);
+	~SSSTileClassifier();
+
+	void setEnabled(bool enabled)
+	{
+		this->m_enabled = enabled;
+	}
+
+	bool isEnabled() const
+	{
+		return this->m_enabled;
+	}
+
+	// The render targets are created by the first "go", with the size of the blur / SSS_TILE_SIZE
+	void createRTs(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV);
+
+	// Classify the tiles of the inputs bound by the caller, and draw the interior tiles with the "SSS_Blur_Interior_PS" and the edge tiles with the "edgePS" into the "blurRTV" (the "blurBlending")
+	// NOTE: the vertex shader, the input layout and the primitive topology of the caller are NOT restored, and the viewport of the caller is restored
+	void go(ID3D11DeviceContext* context,
+		Quad* quad,
+		ID3D11RenderTargetView* blurRTV,
+		ID3D11ShaderResourceView* blurIrradianceSRV,
+		ID3D11DepthStencilView* blurDSV,
+		ID3D11BlendState* blurBlending,
+		ID3D11PixelShader* edgePS);
+
+private:
+	bool m_enabled;
+
+	ID3D11PixelShader* SSS_Blur_TileState_PS;
+	ID3D11PixelShader* SSS_Blur_TileClassify_PS;
+	ID3D11VertexShader* SSS_Blur_TileInterior_VS;
+	ID3D11VertexShader* SSS_Blur_TileEdge_VS;
+	ID3D11PixelShader* SSS_Blur_Interior_PS;
+	// SSS_TILE_STATE_UNIFORM + profile_index
+	RenderTarget* tileStateRT;
+	// (class, profile_index, margin, 0)
+	RenderTarget* tileClassRT;
+};
+
+#endif
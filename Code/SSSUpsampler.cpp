@@ -0,0 +1,137 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include "SSSUpsampler.h"
+
+#include "../../dxbc/SSS_Blur_Downsample_PS_bytecode.inl"
+#include "../../dxbc/SSS_Blur_Upsample_PS_bytecode.inl"
+
+#define TEX_ALBEDO 0
+#define TEX_IRRADIANCE 1
+#define TEX_DEPTH 2
+#define TEX_STENCIL 5
+#define TEX_LOW_RESOLUTION_BLURRED 8
+
+SSSUpsampler::SSSUpsampler(ID3D11Device* device) : m_resolutionFactor(SSS_RESOLUTION_FACTOR_FULL),
+	lowIrradianceRT(NULL),
+	lowAlbedoRT(NULL),
+	lowDepthRT(NULL),
+	lowStencilRT(NULL),
+	lowBlurredRT(NULL)
+{
+	HRESULT hr;
+
+	V(device->CreatePixelShader(SSS_Blur_Downsample_PS_bytecode, sizeof(SSS_Blur_Downsample_PS_bytecode), NULL, &SSS_Blur_Downsample_PS));
+	V(device->CreatePixelShader(SSS_Blur_Upsample_PS_bytecode, sizeof(SSS_Blur_Upsample_PS_bytecode), NULL, &SSS_Blur_Upsample_PS));
+}
+
+SSSUpsampler::~SSSUpsampler()
+{
+	SAFE_DELETE(lowBlurredRT);
+	SAFE_DELETE(lowStencilRT);
+	SAFE_DELETE(lowDepthRT);
+	SAFE_DELETE(lowAlbedoRT);
+	SAFE_DELETE(lowIrradianceRT);
+	SAFE_RELEASE(SSS_Blur_Upsample_PS);
+	SAFE_RELEASE(SSS_Blur_Downsample_PS);
+}
+
+void SSSUpsampler::createRTs(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV)
+{
+	ID3D11Resource* irradianceResource = NULL;
+	irradianceSRV->GetResource(&irradianceResource);
+	D3D11_TEXTURE2D_DESC irradianceDesc;
+	static_cast<ID3D11Texture2D*>(irradianceResource)->GetDesc(&irradianceDesc);
+	SAFE_RELEASE(irradianceResource);
+
+	const int width = subsurface_scattering_low_resolution_size(static_cast<int>(irradianceDesc.Width), m_resolutionFactor);
+	const int height = subsurface_scattering_low_resolution_size(static_cast<int>(irradianceDesc.Height), m_resolutionFactor);
+	if ((NULL != lowBlurredRT) && (lowBlurredRT->getWidth() == width) && (lowBlurredRT->getHeight() == height))
+	{
+		return;
+	}
+
+	SAFE_DELETE(lowBlurredRT);
+	SAFE_DELETE(lowStencilRT);
+	SAFE_DELETE(lowDepthRT);
+	SAFE_DELETE(lowAlbedoRT);
+	SAFE_DELETE(lowIrradianceRT);
+
+	ID3D11Device* device = NULL;
+	context->GetDevice(&device);
+	lowIrradianceRT = new RenderTarget(device, width, height, DXGI_FORMAT_R16G16B16A16_FLOAT);
+	lowAlbedoRT = new RenderTarget(device, width, height, DXGI_FORMAT_R8G8B8A8_UNORM);
+	lowDepthRT = new RenderTarget(device, width, height, DXGI_FORMAT_R32_FLOAT);
+	lowStencilRT = new RenderTarget(device, width, height, DXGI_FORMAT_R8G8_UINT);
+	lowBlurredRT = new RenderTarget(device, width, height, DXGI_FORMAT_R16G16B16A16_FLOAT);
+	SAFE_RELEASE(device);
+}
+
+void SSSUpsampler::downsample(ID3D11DeviceContext* context, Quad* quad)
+{
+	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	ID3D11RenderTargetView* pRenderTargetViews[4] = { NULL, NULL, NULL, NULL };
+
+	// NOTE: the texels of which the stencil is zero are written as well, s.t. the render targets do NOT need to be cleared
+	ID3D11RenderTargetView* lowRTVs[4] = { *lowIrradianceRT, *lowAlbedoRT, *lowDepthRT, *lowStencilRT };
+	lowBlurredRT->setViewport(context);
+	context->PSSetShader(SSS_Blur_Downsample_PS, NULL, 0);
+	context->OMSetBlendState(NULL, BlendFactor, 0xFFFFFFFF);
+	context->OMSetRenderTargets(4, lowRTVs, NULL);
+	quad->draw(context);
+	context->OMSetRenderTargets(4, pRenderTargetViews, NULL);
+
+	// The pixels which are NOT written (stencil == 0) are rejected by the upsample
+	FLOAT ClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	context->ClearRenderTargetView(*lowBlurredRT, ClearColor);
+
+	ID3D11ShaderResourceView* lowIrradianceSRV = *lowIrradianceRT;
+	ID3D11ShaderResourceView* lowAlbedoSRV = *lowAlbedoRT;
+	ID3D11ShaderResourceView* lowDepthSRV = *lowDepthRT;
+	ID3D11ShaderResourceView* lowStencilSRV = *lowStencilRT;
+	context->PSSetShaderResources(TEX_IRRADIANCE, 1U, &lowIrradianceSRV);
+	context->PSSetShaderResources(TEX_ALBEDO, 1U, &lowAlbedoSRV);
+	context->PSSetShaderResources(TEX_DEPTH, 1U, &lowDepthSRV);
+	context->PSSetShaderResources(TEX_STENCIL, 1U, &lowStencilSRV);
+}
+
+void SSSUpsampler::upsample(ID3D11DeviceContext* context,
+	Quad* quad,
+	ID3D11RenderTargetView* outputRTV,
+	ID3D11ShaderResourceView* irradianceSRV,
+	ID3D11ShaderResourceView* depthSRV,
+	ID3D11DepthStencilView* depthDSV,
+	ID3D11ShaderResourceView* stencilSRV,
+	ID3D11ShaderResourceView* albedoSRV,
+	ID3D11BlendState* addBlending)
+{
+	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	ID3D11RenderTargetView* pRenderTargetViews[4] = { NULL, NULL, NULL, NULL };
+
+	ID3D11ShaderResourceView* lowSRVs[4] = { *lowBlurredRT, *lowAlbedoRT, *lowDepthRT, *lowStencilRT };
+	context->PSSetShaderResources(TEX_IRRADIANCE, 1U, &irradianceSRV);
+	context->PSSetShaderResources(TEX_ALBEDO, 1U, &albedoSRV);
+	context->PSSetShaderResources(TEX_DEPTH, 1U, &depthSRV);
+	context->PSSetShaderResources(TEX_STENCIL, 1U, &stencilSRV);
+	context->PSSetShaderResources(TEX_LOW_RESOLUTION_BLURRED, 4U, lowSRVs);
+	context->PSSetShader(SSS_Blur_Upsample_PS, NULL, 0);
+	context->OMSetBlendState(addBlending, BlendFactor, 0xFFFFFFFF);
+	context->OMSetRenderTargets(1, &outputRTV, depthDSV);
+	quad->draw(context);
+	context->OMSetRenderTargets(1, pRenderTargetViews, NULL);
+}
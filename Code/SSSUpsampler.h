@@ -0,0 +1,95 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#ifndef _SSSUpsampler_H_
+#define _SSSUpsampler_H_ 1
+
+#include <sdkddkver.h>
+#define NOMINMAX 1
+#define WIN32_LEAN_AND_MEAN 1
+#include <DXUT.h>
+#include "RenderTarget.h"
+#include "CPU/subsurface_scattering_low_resolution.h"
+
+// The irradiance, the depth, the subsurface mask and the stencil are downsampled (depth-aware), blurred at the low resolution and upsampled by the joint bilateral filter guided by the full resolution depth and subsurface mask (see "subsurface_scattering_low_resolution.hlsli")
+class SSSUpsampler
+{
+public:
+	SSSUpsampler(ID3D11Device* device);
+	~SSSUpsampler();
+
+	// SSS_RESOLUTION_FACTOR_FULL / SSS_RESOLUTION_FACTOR_HALF / SSS_RESOLUTION_FACTOR_QUARTER
+	void setResolutionFactor(int resolutionFactor)
+	{
+		this->m_resolutionFactor = (resolutionFactor >= SSS_RESOLUTION_FACTOR_QUARTER) ? SSS_RESOLUTION_FACTOR_QUARTER : ((resolutionFactor >= SSS_RESOLUTION_FACTOR_HALF) ? SSS_RESOLUTION_FACTOR_HALF : SSS_RESOLUTION_FACTOR_FULL);
+	}
+
+	int getResolutionFactor() const
+	{
+		return this->m_resolutionFactor;
+	}
+
+	bool isEnabled() const
+	{
+		return (SSS_RESOLUTION_FACTOR_FULL != this->m_resolutionFactor);
+	}
+
+	// The render targets are created by the first "go", with the size of the irradiance / the "resolutionFactor"
+	void createRTs(ID3D11DeviceContext* context, ID3D11ShaderResourceView* irradianceSRV);
+
+	// Downsample: the full resolution inputs bound by the caller -> the low resolution render targets (no stencil buffer and no blending)
+	// The low resolution render targets are bound instead of the full resolution inputs, and the viewport of the low resolution is set
+	void downsample(ID3D11DeviceContext* context, Quad* quad);
+
+	// Upsample: the "lowBlurredRT" -> the "outputRTV" (additive blending)
+	// The full resolution inputs are bound again, and the viewport of the caller is NOT changed
+	void upsample(ID3D11DeviceContext* context,
+		Quad* quad,
+		ID3D11RenderTargetView* outputRTV,
+		ID3D11ShaderResourceView* irradianceSRV,
+		ID3D11ShaderResourceView* depthSRV,
+		ID3D11DepthStencilView* depthDSV,
+		ID3D11ShaderResourceView* stencilSRV,
+		ID3D11ShaderResourceView* albedoSRV,
+		ID3D11BlendState* addBlending);
+
+	ID3D11ShaderResourceView* getIrradianceSRV() const
+	{
+		return static_cast<ID3D11ShaderResourceView*>(*this->lowIrradianceRT);
+	}
+
+	ID3D11RenderTargetView* getBlurredRTV() const
+	{
+		return static_cast<ID3D11RenderTargetView*>(*this->lowBlurredRT);
+	}
+
+private:
+	int m_resolutionFactor;
+
+	ID3D11PixelShader* SSS_Blur_Downsample_PS;
+	ID3D11PixelShader* SSS_Blur_Upsample_PS;
+	RenderTarget* lowIrradianceRT;
+	RenderTarget* lowAlbedoRT;
+	// The NDC depth of the representative texel
+	RenderTarget* lowDepthRT;
+	// The G channel is the stencil (the same as the X24_TYPELESS_G8_UINT)
+	RenderTarget* lowStencilRT;
+	RenderTarget* lowBlurredRT;
+};
+
+#endif
@@ -1,5 +1,10 @@
 #include "Main.h"
 #include "../Demo.h"
+#include "../CPU/SSSTransmittanceLUT.h"
+#include "../CPU/SSSPreintegratedLUT.h"
+#include "../CPU/SSSCurvatureMap.h"
+#include "../CPU/SSSTextureSpace.h"
+#include "../SSSBlur.h"
 #include <vector>
 #include <fstream>
 #include <sstream>
@@ -8,6 +13,8 @@
 
 #include "../../dxbc/Main_RenderVS_bytecode.inl"
 #include "../../dxbc/Main_RenderPS_bytecode.inl"
+#include "../../dxbc/Main_TextureSpaceVS_bytecode.inl"
+#include "../../dxbc/Main_TextureSpacePS_bytecode.inl"
 
 static ID3D11Buffer* CbufUpdatedPerFrame = NULL;
 static ID3D11Buffer* CbufUpdatedPerObject = NULL;
@@ -25,6 +32,40 @@ static ID3D11SamplerState* ShadowSampler = NULL;
 static ID3D11ShaderResourceView* specularAOSRV = NULL;
 static ID3D11ShaderResourceView* irradianceSRV = NULL;
 
+// One row per profile (see "SSSTransmittanceLUT")
+static ID3D11Texture2D* TransmittanceLUT = NULL;
+static ID3D11ShaderResourceView* TransmittanceLUTSRV = NULL;
+static SSSTransmittanceLUT mainEffect_TransmittanceLUT;
+
+// One slice per profile (see "SSSPreintegratedLUT")
+static ID3D11Texture2D* PreintegratedLUT = NULL;
+static ID3D11ShaderResourceView* PreintegratedLUTSRV = NULL;
+static SSSPreintegratedLUT mainEffect_PreintegratedLUT;
+
+// Baked from the head once per device (see "SSSCurvatureMap")
+static ID3D11Texture2D* CurvatureMap = NULL;
+static ID3D11ShaderResourceView* CurvatureMapSRV = NULL;
+
+// The bounds of the head are computed from the same vertices as the curvature map
+static SSSLodSelector mainEffect_LodSelector;
+static SSSLodBounds mainEffect_HeadBounds;
+static bool mainEffect_LodEnabled = false;
+
+// One slice of the atlas per slot of the cache (see "SSSTextureSpaceCache"), and the position and the stretch are baked from the head once per device (see "SSSTextureSpaceGeometry")
+static SSSTextureSpaceCache mainEffect_TextureSpaceCache(SSS_TEXTURE_SPACE_DEFAULT_SIZE, SSS_TEXTURE_SPACE_DEFAULT_MEMORY_BUDGET, N_HEADS);
+static bool mainEffect_TextureSpaceEnabled = false;
+static ID3D11Texture2D* TextureSpaceAtlas = NULL;
+static ID3D11ShaderResourceView* TextureSpaceAtlasSRV = NULL;
+static std::vector<ID3D11RenderTargetView*> TextureSpaceAtlasRTVs;
+static RenderTarget* TextureSpaceIrradiance = NULL;
+static ID3D11Texture2D* TextureSpacePosition = NULL;
+static ID3D11ShaderResourceView* TextureSpacePositionSRV = NULL;
+static ID3D11Texture2D* TextureSpaceStretch = NULL;
+static ID3D11ShaderResourceView* TextureSpaceStretchSRV = NULL;
+static ID3D11VertexShader* TextureSpaceVS = NULL;
+static ID3D11PixelShader* TextureSpacePS = NULL;
+static ID3D11RasterizerState* DisableCulling = NULL;
+
 #define CB_UPDATEDPERFRAME 0
 #define CB_UPDATEDPEROBJECT 1
 
@@ -34,6 +75,11 @@ static ID3D11ShaderResourceView* irradianceSRV = NULL;
 #define TEX_SPECULARAO 3
 #define TEX_IRRADIANCE 5
 #define TEX_SHADOW_MAPS 6
+#define TEX_TRANSMITTANCE_LUT 11
+#define TEX_LINEAR_SHADOW_MAPS 12
+#define TEX_PREINTEGRATED_LUT 17
+#define TEX_CURVATURE_MAP 18
+#define TEX_TEXTURE_SPACE_ATLAS 19
 
 #define SAMP_POINT 0
 #define SAMP_LINEAR 1
@@ -63,6 +109,7 @@ static struct UpdatedPerFrame mainEffect_UpdatedPerFrame;
 struct UpdatedPerObject
 {
 	__declspec(align(16)) DirectX::XMFLOAT4X4 currWorldViewProj;
+	__declspec(align(16)) DirectX::XMFLOAT4X4 prevWorldViewProj;
 	__declspec(align(16)) DirectX::XMFLOAT4X4 world;
 	__declspec(align(16)) DirectX::XMFLOAT4X4 worldInverseTranspose;
 	__declspec(align(16)) DirectX::XMFLOAT3 scatteringDistance;
@@ -79,10 +126,23 @@ struct UpdatedPerObject
 	float worldScale;
 	float postscatterEnabled;
 	float ambient;
+	float transmittanceLUTEnabled;
+	float transmittanceLUTMaxThickness;
+	int profileIndex;
+	int irradianceEncoding;
+	int depthEncoding;
+	int shadowDepthMode;
+	float preintegratedEnabled;
+	float textureSpaceEnabled;
+	int textureSpaceSlice;
 };
 
 static struct UpdatedPerObject mainEffect_UpdatedPerObject;
 
+// The view-projection matrix of the previous "mainPass" (for the motion vectors)
+static DirectX::XMFLOAT4X4 mainEffect_PrevViewProj;
+static bool mainEffect_PrevViewProjValid = false;
+
 void initMainEffect(ID3D11Device* device, ID3D11ShaderResourceView* l_specularAOSRV, ID3D11ShaderResourceView* l_irradianceSRV)
 {
 	HRESULT hr;
@@ -160,8 +220,16 @@ void initMainEffect(ID3D11Device* device, ID3D11ShaderResourceView* l_specularAO
 	EnableMultisamplingDesc.MultisampleEnable = TRUE;
 	V(device->CreateRasterizerState(&EnableMultisamplingDesc, &EnableMultisampling));
 
+	// The winding of the triangles in the texture space is arbitrary
+	D3D11_RASTERIZER_DESC DisableCullingDesc = EnableMultisamplingDesc;
+	DisableCullingDesc.CullMode = D3D11_CULL_NONE;
+	DisableCullingDesc.MultisampleEnable = FALSE;
+	V(device->CreateRasterizerState(&DisableCullingDesc, &DisableCulling));
+
 	V(device->CreateVertexShader(Main_RenderVS_bytecode, sizeof(Main_RenderVS_bytecode), NULL, &RenderVS));
 	V(device->CreatePixelShader(Main_RenderPS_bytecode, sizeof(Main_RenderPS_bytecode), NULL, &RenderPS));
+	V(device->CreateVertexShader(Main_TextureSpaceVS_bytecode, sizeof(Main_TextureSpaceVS_bytecode), NULL, &TextureSpaceVS));
+	V(device->CreatePixelShader(Main_TextureSpacePS_bytecode, sizeof(Main_TextureSpacePS_bytecode), NULL, &TextureSpacePS));
 
 	D3D11_SAMPLER_DESC PointSamplerDesc;
 	PointSamplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
@@ -236,6 +304,141 @@ void initMainEffect(ID3D11Device* device, ID3D11ShaderResourceView* l_specularAO
 	specularAOSRV = l_specularAOSRV;
 	irradianceSRV = l_irradianceSRV;
 
+	D3D11_TEXTURE2D_DESC TransmittanceLUTDesc;
+	TransmittanceLUTDesc.Width = mainEffect_TransmittanceLUT.getSize();
+	TransmittanceLUTDesc.Height = SSS_PROFILE_MAX_COUNT;
+	TransmittanceLUTDesc.MipLevels = 1;
+	TransmittanceLUTDesc.ArraySize = 1;
+	TransmittanceLUTDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	TransmittanceLUTDesc.SampleDesc.Count = 1;
+	TransmittanceLUTDesc.SampleDesc.Quality = 0;
+	TransmittanceLUTDesc.Usage = D3D11_USAGE_DEFAULT;
+	TransmittanceLUTDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	TransmittanceLUTDesc.CPUAccessFlags = 0;
+	TransmittanceLUTDesc.MiscFlags = 0;
+	V(device->CreateTexture2D(&TransmittanceLUTDesc, NULL, &TransmittanceLUT));
+	V(device->CreateShaderResourceView(TransmittanceLUT, NULL, &TransmittanceLUTSRV));
+
+	// Force the upload by the first "mainPass"
+	mainEffect_TransmittanceLUT.setMaxThickness(mainEffect_TransmittanceLUT.getMaxThickness());
+
+	D3D11_TEXTURE2D_DESC PreintegratedLUTDesc;
+	PreintegratedLUTDesc.Width = mainEffect_PreintegratedLUT.getSize();
+	PreintegratedLUTDesc.Height = mainEffect_PreintegratedLUT.getSize();
+	PreintegratedLUTDesc.MipLevels = 1;
+	PreintegratedLUTDesc.ArraySize = SSS_PROFILE_MAX_COUNT;
+	PreintegratedLUTDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	PreintegratedLUTDesc.SampleDesc.Count = 1;
+	PreintegratedLUTDesc.SampleDesc.Quality = 0;
+	PreintegratedLUTDesc.Usage = D3D11_USAGE_DEFAULT;
+	PreintegratedLUTDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	PreintegratedLUTDesc.CPUAccessFlags = 0;
+	PreintegratedLUTDesc.MiscFlags = 0;
+	V(device->CreateTexture2D(&PreintegratedLUTDesc, NULL, &PreintegratedLUT));
+	V(device->CreateShaderResourceView(PreintegratedLUT, NULL, &PreintegratedLUTSRV));
+
+	// Force the upload by the first "mainPass"
+	mainEffect_PreintegratedLUT = SSSPreintegratedLUT();
+
+	// The layout of the vertices is the "layout" below: POSITION (0), NORMAL (12) and TEXCOORD (24)
+	std::vector<SSSCurvatureMesh> curvatureMeshes;
+	for (UINT meshIndex = 0U; meshIndex < mesh.GetNumMeshes(); ++meshIndex)
+	{
+		SSSCurvatureMesh curvatureMesh;
+		curvatureMesh.vertices = mesh.GetRawVerticesAt(mesh.GetMesh(meshIndex)->VertexBuffers[0]);
+		curvatureMesh.vertexCount = static_cast<int>(mesh.GetNumVertices(meshIndex, 0U));
+		curvatureMesh.vertexStride = static_cast<int>(mesh.GetVertexStride(meshIndex, 0U));
+		curvatureMesh.positionOffset = 0;
+		curvatureMesh.normalOffset = 12;
+		curvatureMesh.texcoordOffset = 24;
+		curvatureMesh.indices = mesh.GetRawIndicesAt(mesh.GetMesh(meshIndex)->IndexBuffer);
+		curvatureMesh.indexCount = static_cast<int>(mesh.GetNumIndices(meshIndex));
+		curvatureMesh.indices32 = (IT_32BIT == mesh.GetIndexType(meshIndex));
+		curvatureMeshes.push_back(curvatureMesh);
+	}
+
+	SSSCurvatureMap curvatureMap;
+	curvatureMap.bake(curvatureMeshes.data(), static_cast<int>(curvatureMeshes.size()));
+
+	mainEffect_HeadBounds = subsurface_scattering_lod_bounds(curvatureMeshes.data(), static_cast<int>(curvatureMeshes.size()));
+	mainEffect_LodSelector.reset();
+
+	D3D11_TEXTURE2D_DESC CurvatureMapDesc;
+	CurvatureMapDesc.Width = curvatureMap.getSize();
+	CurvatureMapDesc.Height = curvatureMap.getSize();
+	CurvatureMapDesc.MipLevels = 1;
+	CurvatureMapDesc.ArraySize = 1;
+	CurvatureMapDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	CurvatureMapDesc.SampleDesc.Count = 1;
+	CurvatureMapDesc.SampleDesc.Quality = 0;
+	CurvatureMapDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	CurvatureMapDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	CurvatureMapDesc.CPUAccessFlags = 0;
+	CurvatureMapDesc.MiscFlags = 0;
+	D3D11_SUBRESOURCE_DATA CurvatureMapData = { curvatureMap.getData(), static_cast<UINT>(sizeof(float) * curvatureMap.getSize()), 0U };
+	V(device->CreateTexture2D(&CurvatureMapDesc, &CurvatureMapData, &CurvatureMap));
+	V(device->CreateShaderResourceView(CurvatureMap, NULL, &CurvatureMapSRV));
+
+	SSSTextureSpaceGeometry textureSpaceGeometry(mainEffect_TextureSpaceCache.getSize());
+	textureSpaceGeometry.rasterize(curvatureMeshes.data(), static_cast<int>(curvatureMeshes.size()));
+
+	D3D11_TEXTURE2D_DESC TextureSpacePositionDesc;
+	TextureSpacePositionDesc.Width = textureSpaceGeometry.getSize();
+	TextureSpacePositionDesc.Height = textureSpaceGeometry.getSize();
+	TextureSpacePositionDesc.MipLevels = 1;
+	TextureSpacePositionDesc.ArraySize = 1;
+	TextureSpacePositionDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	TextureSpacePositionDesc.SampleDesc.Count = 1;
+	TextureSpacePositionDesc.SampleDesc.Quality = 0;
+	TextureSpacePositionDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	TextureSpacePositionDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	TextureSpacePositionDesc.CPUAccessFlags = 0;
+	TextureSpacePositionDesc.MiscFlags = 0;
+	D3D11_SUBRESOURCE_DATA TextureSpacePositionData = { textureSpaceGeometry.getPositions(), static_cast<UINT>(sizeof(float4) * textureSpaceGeometry.getSize()), 0U };
+	V(device->CreateTexture2D(&TextureSpacePositionDesc, &TextureSpacePositionData, &TextureSpacePosition));
+	V(device->CreateShaderResourceView(TextureSpacePosition, NULL, &TextureSpacePositionSRV));
+
+	D3D11_TEXTURE2D_DESC TextureSpaceStretchDesc = TextureSpacePositionDesc;
+	TextureSpaceStretchDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
+	D3D11_SUBRESOURCE_DATA TextureSpaceStretchData = { textureSpaceGeometry.getStretch(), static_cast<UINT>(sizeof(float2) * textureSpaceGeometry.getSize()), 0U };
+	V(device->CreateTexture2D(&TextureSpaceStretchDesc, &TextureSpaceStretchData, &TextureSpaceStretch));
+	V(device->CreateShaderResourceView(TextureSpaceStretch, NULL, &TextureSpaceStretchSRV));
+
+	// SSS_TEXTURE_SPACE_BYTES_PER_TEXEL of the cache
+	TextureSpaceIrradiance = new RenderTarget(device, mainEffect_TextureSpaceCache.getSize(), mainEffect_TextureSpaceCache.getSize(), DXGI_FORMAT_R16G16B16A16_FLOAT);
+
+	// The atlas is recreated, s.t. the slots are relit and diffused by the next "mainPass"
+	mainEffect_TextureSpaceCache.clear();
+	if (mainEffect_TextureSpaceCache.getSlotCount() > 0)
+	{
+		D3D11_TEXTURE2D_DESC TextureSpaceAtlasDesc;
+		TextureSpaceAtlasDesc.Width = mainEffect_TextureSpaceCache.getSize();
+		TextureSpaceAtlasDesc.Height = mainEffect_TextureSpaceCache.getSize();
+		TextureSpaceAtlasDesc.MipLevels = 1;
+		TextureSpaceAtlasDesc.ArraySize = mainEffect_TextureSpaceCache.getSlotCount();
+		TextureSpaceAtlasDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+		TextureSpaceAtlasDesc.SampleDesc.Count = 1;
+		TextureSpaceAtlasDesc.SampleDesc.Quality = 0;
+		TextureSpaceAtlasDesc.Usage = D3D11_USAGE_DEFAULT;
+		TextureSpaceAtlasDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+		TextureSpaceAtlasDesc.CPUAccessFlags = 0;
+		TextureSpaceAtlasDesc.MiscFlags = 0;
+		V(device->CreateTexture2D(&TextureSpaceAtlasDesc, NULL, &TextureSpaceAtlas));
+		V(device->CreateShaderResourceView(TextureSpaceAtlas, NULL, &TextureSpaceAtlasSRV));
+
+		TextureSpaceAtlasRTVs.assign(mainEffect_TextureSpaceCache.getSlotCount(), NULL);
+		for (int slot = 0; slot < mainEffect_TextureSpaceCache.getSlotCount(); ++slot)
+		{
+			D3D11_RENDER_TARGET_VIEW_DESC TextureSpaceAtlasRTVDesc;
+			TextureSpaceAtlasRTVDesc.Format = TextureSpaceAtlasDesc.Format;
+			TextureSpaceAtlasRTVDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+			TextureSpaceAtlasRTVDesc.Texture2DArray.MipSlice = 0;
+			TextureSpaceAtlasRTVDesc.Texture2DArray.FirstArraySlice = slot;
+			TextureSpaceAtlasRTVDesc.Texture2DArray.ArraySize = 1;
+			V(device->CreateRenderTargetView(TextureSpaceAtlas, &TextureSpaceAtlasRTVDesc, &TextureSpaceAtlasRTVs[slot]));
+		}
+	}
+
 	const D3D11_INPUT_ELEMENT_DESC layout[] = {
 		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
 		{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
@@ -248,13 +451,34 @@ void initMainEffect(ID3D11Device* device, ID3D11ShaderResourceView* l_specularAO
 
 void releaseMainEffect()
 {
+	for (ID3D11RenderTargetView*& TextureSpaceAtlasRTV : TextureSpaceAtlasRTVs)
+	{
+		SAFE_RELEASE(TextureSpaceAtlasRTV);
+	}
+	TextureSpaceAtlasRTVs.clear();
+	SAFE_RELEASE(TextureSpaceAtlasSRV);
+	SAFE_RELEASE(TextureSpaceAtlas);
+	SAFE_DELETE(TextureSpaceIrradiance);
+	SAFE_RELEASE(TextureSpaceStretchSRV);
+	SAFE_RELEASE(TextureSpaceStretch);
+	SAFE_RELEASE(TextureSpacePositionSRV);
+	SAFE_RELEASE(TextureSpacePosition);
+	SAFE_RELEASE(CurvatureMapSRV);
+	SAFE_RELEASE(CurvatureMap);
+	SAFE_RELEASE(PreintegratedLUTSRV);
+	SAFE_RELEASE(PreintegratedLUT);
+	SAFE_RELEASE(TransmittanceLUTSRV);
+	SAFE_RELEASE(TransmittanceLUT);
 	SAFE_RELEASE(vertexLayout);
 	SAFE_RELEASE(ShadowSampler);
 	SAFE_RELEASE(AnisotropicSampler);
 	SAFE_RELEASE(LinearSampler);
 	SAFE_RELEASE(PointSampler);
+	SAFE_RELEASE(TextureSpacePS);
+	SAFE_RELEASE(TextureSpaceVS);
 	SAFE_RELEASE(RenderPS);
 	SAFE_RELEASE(RenderVS);
+	SAFE_RELEASE(DisableCulling);
 	SAFE_RELEASE(EnableMultisampling);
 	SAFE_RELEASE(NoBlending);
 	SAFE_RELEASE(EnableDepthDisableStencil);
@@ -287,39 +511,66 @@ void mainEffect_setSSSEnabled(bool sssEnabled)
 	mainEffect_UpdatedPerObject.sssEnabled = sssEnabled ? 1.0f : -1.0f;
 }
 
-void mainEffect_setWorldScale(float worldScale)
+void mainEffect_setSpecularIntensity(float specularIntensity)
+{
+	mainEffect_UpdatedPerObject.specularIntensity = specularIntensity;
+}
+
+void mainEffect_setSpecularRoughness(float specularRoughness)
 {
-	mainEffect_UpdatedPerObject.worldScale = std::max(0.001f, worldScale);
+	mainEffect_UpdatedPerObject.specularRoughness = specularRoughness;
 }
 
-void mainEffect_setScatteringDistance(DirectX::XMFLOAT3 scatteringDistance)
+void mainEffect_setSpecularFresnel(float specularFresnel)
 {
-	mainEffect_UpdatedPerObject.scatteringDistance = scatteringDistance;
+	mainEffect_UpdatedPerObject.specularFresnel = specularFresnel;
 }
 
-void mainEffect_setTransmittanceTint(DirectX::XMFLOAT3 transmittanceTint)
+void mainEffect_setBumpiness(float bumpiness)
 {
-	mainEffect_UpdatedPerObject.transmittanceTint = transmittanceTint;
+	mainEffect_UpdatedPerObject.bumpiness = bumpiness;
 }
 
-void mainEffect_setSpecularIntensity(float specularIntensity)
+void mainEffect_setTransmittanceLUTEnabled(bool transmittanceLUTEnabled)
 {
-	mainEffect_UpdatedPerObject.specularIntensity = specularIntensity;
+	mainEffect_UpdatedPerObject.transmittanceLUTEnabled = transmittanceLUTEnabled ? 1.0f : -1.0f;
 }
 
-void mainEffect_setSpecularRoughness(float specularRoughness)
+void mainEffect_setTransmittanceLUTExtended(bool transmittanceLUTExtended)
 {
-	mainEffect_UpdatedPerObject.specularRoughness = specularRoughness;
+	float maxThickness = transmittanceLUTExtended ? SSS_TRANSMITTANCE_LUT_EXTENDED_MAX_THICKNESS : SSS_TRANSMITTANCE_LUT_MAX_THICKNESS;
+	if (mainEffect_TransmittanceLUT.getMaxThickness() != maxThickness)
+	{
+		mainEffect_TransmittanceLUT.setMaxThickness(maxThickness);
+	}
 }
 
-void mainEffect_setSpecularFresnel(float specularFresnel)
+void mainEffect_setPreintegratedEnabled(bool preintegratedEnabled)
 {
-	mainEffect_UpdatedPerObject.specularFresnel = specularFresnel;
+	mainEffect_UpdatedPerObject.preintegratedEnabled = preintegratedEnabled ? 1.0f : -1.0f;
 }
 
-void mainEffect_setBumpiness(float bumpiness)
+void mainEffect_setLodEnabled(bool lodEnabled)
 {
-	mainEffect_UpdatedPerObject.bumpiness = bumpiness;
+	mainEffect_LodEnabled = lodEnabled;
+	mainEffect_LodSelector.reset();
+}
+
+void mainEffect_setTextureSpaceEnabled(bool textureSpaceEnabled)
+{
+	mainEffect_TextureSpaceEnabled = textureSpaceEnabled;
+	mainEffect_TextureSpaceCache.clear();
+}
+
+void mainEffect_setGBufferEncoding(int irradianceEncoding, int depthEncoding)
+{
+	mainEffect_UpdatedPerObject.irradianceEncoding = irradianceEncoding;
+	mainEffect_UpdatedPerObject.depthEncoding = depthEncoding;
+}
+
+void mainEffect_setShadowDepthMode(int shadowDepthMode)
+{
+	mainEffect_UpdatedPerObject.shadowDepthMode = shadowDepthMode;
 }
 
 float mainEffect_getAmbient()
@@ -327,12 +578,87 @@ float mainEffect_getAmbient()
 	return mainEffect_UpdatedPerObject.ambient;
 }
 
-void mainPass(ID3D11DeviceContext* context, ID3D11RenderTargetView* mainRT, ID3D11RenderTargetView* depthRT, ID3D11RenderTargetView* albedoRT, ID3D11RenderTargetView* irradianceRT, ID3D11DepthStencilView* depthStencil)
+const SSSLodSelector& mainEffect_getLodSelector()
+{
+	return mainEffect_LodSelector;
+}
+
+const SSSTextureSpaceCache& mainEffect_getTextureSpaceCache()
+{
+	return mainEffect_TextureSpaceCache;
+}
+
+// The state shared by the heads and by the relighting of the texture space diffusion (which is overridden by the "SSSBlur::goTextureSpace")
+static void mainEffect_bindHeadState(ID3D11DeviceContext* context)
+{
+	context->IASetInputLayout(vertexLayout);
+
+	for (int i = 0; i < N_LIGHTS; i++)
+	{
+		ID3D11ShaderResourceView* shadowMapSRV = *lights[i].shadowMap;
+		context->PSSetShaderResources(TEX_SHADOW_MAPS + i, 1, &shadowMapSRV);
+		ID3D11ShaderResourceView* linearShadowMapSRV = lights[i].shadowMap->getLinearDepthSRV();
+		context->PSSetShaderResources(TEX_LINEAR_SHADOW_MAPS + i, 1, &linearShadowMapSRV);
+	}
+	context->PSSetShaderResources(TEX_SPECULARAO, 1, &specularAOSRV);
+	context->PSSetShaderResources(TEX_IRRADIANCE, 1, &irradianceSRV);
+	context->PSSetShaderResources(TEX_TRANSMITTANCE_LUT, 1, &TransmittanceLUTSRV);
+	context->PSSetShaderResources(TEX_PREINTEGRATED_LUT, 1, &PreintegratedLUTSRV);
+	context->PSSetShaderResources(TEX_CURVATURE_MAP, 1, &CurvatureMapSRV);
+
+	context->VSSetConstantBuffers(CB_UPDATEDPERFRAME, 1U, &CbufUpdatedPerFrame);
+	context->VSSetConstantBuffers(CB_UPDATEDPEROBJECT, 1U, &CbufUpdatedPerObject);
+	context->PSSetConstantBuffers(CB_UPDATEDPERFRAME, 1U, &CbufUpdatedPerFrame);
+	context->PSSetConstantBuffers(CB_UPDATEDPEROBJECT, 1U, &CbufUpdatedPerObject);
+	context->PSSetSamplers(SAMP_POINT, 1, &PointSampler);
+	context->PSSetSamplers(SAMP_LINEAR, 1, &LinearSampler);
+	context->PSSetSamplers(SAMP_ANISOTROPIS, 1, &AnisotropicSampler);
+	context->PSSetSamplers(SAMP_SHADOW, 1, &ShadowSampler);
+	context->GSSetShader(NULL, NULL, 0);
+	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	context->OMSetBlendState(NoBlending, BlendFactor, 0xFFFFFFFF);
+}
+
+// The transform and the profile of the head (the LOD and the texture space diffusion are set by the caller)
+static int mainEffect_setHead(int i, const DirectX::XMFLOAT4X4& currViewProj, const SSSProfileTable& profiles)
+{
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixTranslation(i - (N_HEADS - 1) / 2.0f, 0.0f, 0.0f));
+
+	DirectX::XMFLOAT4X4 currWorldViewProj;
+	DirectX::XMStoreFloat4x4(&currWorldViewProj, DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&world), DirectX::XMLoadFloat4x4(&currViewProj)));
+
+	// NOTE: the heads are static, s.t. the previous world matrix is the same
+	DirectX::XMFLOAT4X4 prevWorldViewProj;
+	DirectX::XMStoreFloat4x4(&prevWorldViewProj, DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&world), DirectX::XMLoadFloat4x4(&mainEffect_PrevViewProj)));
+
+	mainEffect_UpdatedPerObject.currWorldViewProj = currWorldViewProj;
+	mainEffect_UpdatedPerObject.prevWorldViewProj = prevWorldViewProj;
+	mainEffect_UpdatedPerObject.world = world;
+	DirectX::XMStoreFloat4x4(&mainEffect_UpdatedPerObject.worldInverseTranspose, DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&world)));
+
+	const int profileIndex = i % profiles.getCount();
+	const SSSProfile& profile = profiles.getProfile(profileIndex);
+	mainEffect_UpdatedPerObject.scatteringDistance = DirectX::XMFLOAT3(profile.scatteringDistance.x, profile.scatteringDistance.y, profile.scatteringDistance.z);
+	mainEffect_UpdatedPerObject.transmittanceTint = DirectX::XMFLOAT3(profile.transmittanceTint.x, profile.transmittanceTint.y, profile.transmittanceTint.z);
+	mainEffect_UpdatedPerObject.worldScale = profile.worldScale;
+	mainEffect_UpdatedPerObject.profileIndex = profileIndex;
+	return profileIndex;
+}
+
+void mainPass(ID3D11DeviceContext* context, ID3D11RenderTargetView* mainRT, ID3D11RenderTargetView* depthRT, ID3D11RenderTargetView* albedoRT, ID3D11RenderTargetView* irradianceRT, ID3D11RenderTargetView* velocityRT, ID3D11DepthStencilView* depthStencil, const SSSProfileTable& profiles, SSSBlur* textureSpaceBlur)
 {
 	// Calculate current view-projection matrix:
 	DirectX::XMFLOAT4X4 currViewProj;
 	DirectX::XMStoreFloat4x4(&currViewProj, DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&camera.getViewMatrix()), DirectX::XMLoadFloat4x4(&camera.getProjectionMatrix())));
 
+	// The motion vectors of the first frame are zero:
+	if (!mainEffect_PrevViewProjValid)
+	{
+		mainEffect_PrevViewProj = currViewProj;
+		mainEffect_PrevViewProjValid = true;
+	}
+
 	// Variables setup:
 	mainEffect_UpdatedPerFrame.cameraPosition = camera.getEyePosition();
 	mainEffect_UpdatedPerFrame.currProj = camera.getProjectionMatrix();
@@ -353,8 +679,6 @@ void mainPass(ID3D11DeviceContext* context, ID3D11RenderTargetView* mainRT, ID3D
 		mainEffect_UpdatedPerFrame.lights[i].falloffWidth = lights[i].falloffWidth;
 		mainEffect_UpdatedPerFrame.lights[i].farPlane = lights[i].farPlane;
 		mainEffect_UpdatedPerFrame.lights[i].bias = lights[i].bias;
-		ID3D11ShaderResourceView* shadowMapSRV = *lights[i].shadowMap;
-		context->PSSetShaderResources(TEX_SHADOW_MAPS + i, 1, &shadowMapSRV);
 	}
 
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
@@ -362,51 +686,144 @@ void mainPass(ID3D11DeviceContext* context, ID3D11RenderTargetView* mainRT, ID3D
 	memcpy(mappedResource.pData, &mainEffect_UpdatedPerFrame, sizeof(struct UpdatedPerFrame));
 	context->Unmap(CbufUpdatedPerFrame, 0);
 
-	// Render target setup:
+	// Only rebuilt when the profiles (or the thickness range) change
+	if (mainEffect_TransmittanceLUT.update(profiles))
+	{
+		D3D11_BOX box = { 0U, 0U, 0U, static_cast<UINT>(mainEffect_TransmittanceLUT.getSize()), static_cast<UINT>(mainEffect_TransmittanceLUT.getProfileCount()), 1U };
+		context->UpdateSubresource(TransmittanceLUT, 0U, &box, mainEffect_TransmittanceLUT.getData(), sizeof(float4) * mainEffect_TransmittanceLUT.getSize(), 0U);
+	}
+	mainEffect_UpdatedPerObject.transmittanceLUTMaxThickness = mainEffect_TransmittanceLUT.getMaxThickness();
+
+	// Only rebuilt when the profiles change
+	if (mainEffect_PreintegratedLUT.update(profiles))
+	{
+		const size_t sliceSize = static_cast<size_t>(mainEffect_PreintegratedLUT.getSize()) * static_cast<size_t>(mainEffect_PreintegratedLUT.getSize());
+		for (int profileIndex = 0; profileIndex < mainEffect_PreintegratedLUT.getProfileCount(); ++profileIndex)
+		{
+			context->UpdateSubresource(PreintegratedLUT, D3D11CalcSubresource(0U, static_cast<UINT>(profileIndex), 1U), NULL, mainEffect_PreintegratedLUT.getData() + static_cast<size_t>(profileIndex) * sliceSize, sizeof(float4) * mainEffect_PreintegratedLUT.getSize(), 0U);
+		}
+	}
+
+	mainEffect_bindHeadState(context);
+
+	// The LOD overrides the settings of the HUD per head, s.t. they are restored after the heads
+	const float sssEnabled = mainEffect_UpdatedPerObject.sssEnabled;
+	const float preintegratedEnabled = mainEffect_UpdatedPerObject.preintegratedEnabled;
+	UINT viewportCount = 1U;
+	D3D11_VIEWPORT viewport;
+	context->RSGetViewports(&viewportCount, &viewport);
+	if (mainEffect_LodEnabled)
+	{
+		static_assert(sizeof(float4x4) == sizeof(DirectX::XMFLOAT4X4), "The layout of the float4x4 should match the XMFLOAT4X4");
+		float4x4 view;
+		float4x4 proj;
+		memcpy(&view, &camera.getViewMatrix(), sizeof(float4x4));
+		memcpy(&proj, &camera.getProjectionMatrix(), sizeof(float4x4));
+
+		mainEffect_LodSelector.beginFrame(view, proj, static_cast<int>(viewport.Width), static_cast<int>(viewport.Height));
+	}
+
+	// The tiers of the LOD and the slots of the texture space diffusion are selected before the render targets of the heads are bound, since the dirty slots are relit and diffused into the atlas
+	const bool textureSpaceEnabled = mainEffect_TextureSpaceEnabled && (NULL != textureSpaceBlur) && (NULL != TextureSpaceAtlas);
+	if (textureSpaceEnabled)
+	{
+		mainEffect_TextureSpaceCache.beginFrame();
+	}
+
 	float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	int lodTiers[N_HEADS];
+	int textureSpaceSlots[N_HEADS];
+	for (int i = 0; i < N_HEADS; i++)
+	{
+		const int profileIndex = mainEffect_setHead(i, currViewProj, profiles);
+
+		int lodTier = SSS_LOD_TIER_FULL;
+		if (mainEffect_LodEnabled)
+		{
+			SSSLodBounds bounds = mainEffect_HeadBounds;
+			bounds.center.x += mainEffect_UpdatedPerObject.world._41;
+			bounds.center.y += mainEffect_UpdatedPerObject.world._42;
+			bounds.center.z += mainEffect_UpdatedPerObject.world._43;
+			lodTier = mainEffect_LodSelector.select(i, bounds, profiles.getProfile(profileIndex)).tier;
+		}
+		lodTiers[i] = lodTier;
+		textureSpaceSlots[i] = -1;
+
+		mainEffect_UpdatedPerObject.sssEnabled = (SSS_LOD_TIER_NONE == lodTier) ? -1.0f : sssEnabled;
+		mainEffect_UpdatedPerObject.preintegratedEnabled = (SSS_LOD_TIER_PREINTEGRATED == lodTier) ? 1.0f : preintegratedEnabled;
+		mainEffect_UpdatedPerObject.textureSpaceEnabled = -1.0f;
+		mainEffect_UpdatedPerObject.textureSpaceSlice = 0;
+
+		// The pre-integrated LUT (or the NONE tier) has the priority over the texture space diffusion
+		if ((!textureSpaceEnabled) || (mainEffect_UpdatedPerObject.sssEnabled <= 0.0f) || (mainEffect_UpdatedPerObject.preintegratedEnabled > 0.0f))
+		{
+			continue;
+		}
+
+		// The key covers the lights, the transform and the parameters of the head, but NOT the matrices of the camera (the first two matrices of the "UpdatedPerObject")
+		static_assert(offsetof(struct UpdatedPerObject, world) == 2U * sizeof(DirectX::XMFLOAT4X4), "The matrices of the camera should precede the world matrix");
+		uint64_t key = subsurface_scattering_texture_space_hash(mainEffect_UpdatedPerFrame.lights, sizeof(mainEffect_UpdatedPerFrame.lights));
+		key = subsurface_scattering_texture_space_hash(&mainEffect_UpdatedPerObject.world, sizeof(struct UpdatedPerObject) - offsetof(struct UpdatedPerObject, world), key);
+		const uint64_t profilesVersion = profiles.getVersion();
+		key = subsurface_scattering_texture_space_hash(&profilesVersion, sizeof(profilesVersion), key);
+
+		bool dirty = false;
+		textureSpaceSlots[i] = mainEffect_TextureSpaceCache.acquire(i, key, dirty);
+		if (!dirty)
+		{
+			continue;
+		}
+
+		// Relight: mesh -> texture space irradiance (the empty texels stay zero)
+		context->Map(CbufUpdatedPerObject, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+		memcpy(mappedResource.pData, &mainEffect_UpdatedPerObject, sizeof(struct UpdatedPerObject));
+		context->Unmap(CbufUpdatedPerObject, 0);
+
+		context->ClearRenderTargetView(*TextureSpaceIrradiance, clearColor);
+		context->OMSetRenderTargets(1, *TextureSpaceIrradiance, NULL);
+		context->OMSetDepthStencilState(NULL, 0);
+		TextureSpaceIrradiance->setViewport(context);
+		context->VSSetShader(TextureSpaceVS, NULL, 0);
+		context->PSSetShader(TextureSpacePS, NULL, 0);
+		context->RSSetState(DisableCulling);
+		mesh.Render(context, TEX_DIFFUSE, TEX_NORMAL, TEX_SPECULAR);
+
+		// Diffuse: texture space irradiance -> slice of the atlas (the irradiance is unbound as the render target first)
+		ID3D11RenderTargetView* pRenderTargetView = NULL;
+		context->OMSetRenderTargets(1, &pRenderTargetView, NULL);
+		textureSpaceBlur->goTextureSpace(context, TextureSpaceAtlasRTVs[textureSpaceSlots[i]], *TextureSpaceIrradiance, TextureSpacePositionSRV, TextureSpaceStretchSRV, mainEffect_TextureSpaceCache.getSize(), profileIndex, SSS_TEXTURE_SPACE_DEFAULT_SAMPLE_COUNT, profiles);
+		mainEffect_bindHeadState(context);
+	}
+	context->RSSetViewports(viewportCount, &viewport);
+
+	// Render target setup:
 	context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0, 0);
 	context->ClearRenderTargetView(mainRT, clearColor);
 	context->ClearRenderTargetView(depthRT, clearColor);
 	context->ClearRenderTargetView(irradianceRT, clearColor);
+	context->ClearRenderTargetView(velocityRT, clearColor);
 
-	ID3D11RenderTargetView* rt[] = { mainRT, depthRT, albedoRT, irradianceRT };
-	context->OMSetRenderTargets(4, rt, depthStencil);
+	ID3D11RenderTargetView* rt[] = { mainRT, depthRT, albedoRT, irradianceRT, velocityRT };
+	context->OMSetRenderTargets(5, rt, depthStencil);
 
 	// Heads rendering:
-	context->IASetInputLayout(vertexLayout);
-
-	context->PSSetShaderResources(TEX_SPECULARAO, 1, &specularAOSRV);
-	context->PSSetShaderResources(TEX_IRRADIANCE, 1, &irradianceSRV);
-
-	UINT StencilRef = 1;
-
-	context->VSSetConstantBuffers(CB_UPDATEDPERFRAME, 1U, &CbufUpdatedPerFrame);
-	context->VSSetConstantBuffers(CB_UPDATEDPEROBJECT, 1U, &CbufUpdatedPerObject);
-	context->PSSetConstantBuffers(CB_UPDATEDPERFRAME, 1U, &CbufUpdatedPerFrame);
-	context->PSSetConstantBuffers(CB_UPDATEDPEROBJECT, 1U, &CbufUpdatedPerObject);
-	context->PSSetSamplers(SAMP_POINT, 1, &PointSampler);
-	context->PSSetSamplers(SAMP_LINEAR, 1, &LinearSampler);
-	context->PSSetSamplers(SAMP_ANISOTROPIS, 1, &AnisotropicSampler);
-	context->PSSetSamplers(SAMP_SHADOW, 1, &ShadowSampler);
+	context->PSSetShaderResources(TEX_TEXTURE_SPACE_ATLAS, 1, &TextureSpaceAtlasSRV);
 	context->VSSetShader(RenderVS, NULL, 0);
-	context->GSSetShader(NULL, NULL, 0);
 	context->PSSetShader(RenderPS, NULL, 0);
 	context->RSSetState(EnableMultisampling);
-	context->OMSetDepthStencilState(EnableDepthDisableStencil, StencilRef);
-	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-	context->OMSetBlendState(NoBlending, BlendFactor, 0xFFFFFFFF);
 
 	for (int i = 0; i < N_HEADS; i++)
 	{
-		DirectX::XMFLOAT4X4 world;
-		DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixTranslation(i - (N_HEADS - 1) / 2.0f, 0.0f, 0.0f));
+		const int profileIndex = mainEffect_setHead(i, currViewProj, profiles);
+		const int lodTier = lodTiers[i];
+		mainEffect_UpdatedPerObject.sssEnabled = (SSS_LOD_TIER_NONE == lodTier) ? -1.0f : sssEnabled;
+		mainEffect_UpdatedPerObject.preintegratedEnabled = (SSS_LOD_TIER_PREINTEGRATED == lodTier) ? 1.0f : preintegratedEnabled;
+		mainEffect_UpdatedPerObject.textureSpaceEnabled = (textureSpaceSlots[i] >= 0) ? 1.0f : -1.0f;
+		mainEffect_UpdatedPerObject.textureSpaceSlice = std::max(textureSpaceSlots[i], 0);
 
-		DirectX::XMFLOAT4X4 currWorldViewProj;
-		DirectX::XMStoreFloat4x4(&currWorldViewProj, DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&world), DirectX::XMLoadFloat4x4(&currViewProj)));
-
-		mainEffect_UpdatedPerObject.currWorldViewProj = currWorldViewProj;
-		mainEffect_UpdatedPerObject.world = world;
-		DirectX::XMStoreFloat4x4(&mainEffect_UpdatedPerObject.worldInverseTranspose, DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&world)));
+		// The pixels of the pre-integrated LUT, of the texture space diffusion (or of the NONE tier) are NOT blurred, and the heads beyond the budget of the atlas fall back to the blur
+		UINT StencilRef = ((SSS_LOD_TIER_NONE == lodTier) || (mainEffect_UpdatedPerObject.preintegratedEnabled > 0.0f) || (textureSpaceSlots[i] >= 0)) ? 0U : subsurface_scattering_profile_stencil_ref(profileIndex, SSS_LOD_TIER_REDUCED == lodTier);
+		context->OMSetDepthStencilState(EnableDepthDisableStencil, StencilRef);
 
 		context->Map(CbufUpdatedPerObject, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 		memcpy(mappedResource.pData, &mainEffect_UpdatedPerObject, sizeof(struct UpdatedPerObject));
@@ -415,9 +832,14 @@ void mainPass(ID3D11DeviceContext* context, ID3D11RenderTargetView* mainRT, ID3D
 		mesh.Render(context, TEX_DIFFUSE, TEX_NORMAL, TEX_SPECULAR);
 	}
 
-	ID3D11RenderTargetView* pRenderTargetViews[4] = { NULL, NULL, NULL, NULL };
-	context->OMSetRenderTargets(4, pRenderTargetViews, NULL);
+	mainEffect_UpdatedPerObject.sssEnabled = sssEnabled;
+	mainEffect_UpdatedPerObject.preintegratedEnabled = preintegratedEnabled;
+
+	ID3D11RenderTargetView* pRenderTargetViews[5] = { NULL, NULL, NULL, NULL, NULL };
+	context->OMSetRenderTargets(5, pRenderTargetViews, NULL);
+
+	mainEffect_PrevViewProj = currViewProj;
 
-	ID3D11ShaderResourceView* pShaderResourceViews[16] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
-	context->PSSetShaderResources(0, 16, pShaderResourceViews);
+	ID3D11ShaderResourceView* pShaderResourceViews[TEX_TEXTURE_SPACE_ATLAS + 1] = {};
+	context->PSSetShaderResources(0, TEX_TEXTURE_SPACE_ATLAS + 1, pShaderResourceViews);
 }
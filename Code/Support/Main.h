@@ -6,8 +6,13 @@
 #define WIN32_LEAN_AND_MEAN 1
 #include <DXUT.h>
 #include "RenderTarget.h"
+#include "../CPU/SSSProfileTable.h"
+#include "../CPU/SSSLodSelector.h"
+#include "../CPU/SSSTextureSpaceCache.h"
 #include <DirectXMath.h>
 
+class SSSBlur;
+
 void initMainEffect(ID3D11Device* device, ID3D11ShaderResourceView* specularAOSRV, ID3D11ShaderResourceView* irradianceSRV);
 void releaseMainEffect();
 
@@ -16,16 +21,34 @@ void mainEffect_setSpecularLightEnabled(bool specularlightEnabled);
 void mainEffect_setSkyLightEnabled(bool skylightEnabled);
 void mainEffect_setSSSEnabled(bool sssEnabled);
 void mainEffect_setPostScatterEnabled(bool postscatterEnabled);
-void mainEffect_setWorldScale(float worldScale);
-void mainEffect_setScatteringDistance(DirectX::XMFLOAT3 scatteringDistance);
-void mainEffect_setTransmittanceTint(DirectX::XMFLOAT3 transmittanceTint);
 void mainEffect_setSpecularIntensity(float specularIntensity);
 void mainEffect_setSpecularRoughness(float specularRoughness);
 void mainEffect_setSpecularFresnel(float specularFresnel);
 void mainEffect_setBumpiness(float bumpiness);
+// The transmittance is sampled from the table baked per profile instead of the analytic version
+void mainEffect_setTransmittanceLUTEnabled(bool transmittanceLUTEnabled);
+// The table covers the thickness up to 128 mm instead of 32 mm (at the cost of the resolution)
+void mainEffect_setTransmittanceLUTExtended(bool transmittanceLUTExtended);
+// The diffuse is shaded by the pre-integrated LUT (the cheap LOD of the subsurface scattering) and the heads are NOT blurred
+void mainEffect_setPreintegratedEnabled(bool preintegratedEnabled);
+// The tier of the subsurface scattering of each head is selected by its coverage of the screen (see "SSSLodSelector")
+void mainEffect_setLodEnabled(bool lodEnabled);
+// The diffuse of each head is sampled from its slice of the texture space atlas, which is only relit and diffused when the lights, the parameters or the transform of the head change (see "SSSTextureSpaceCache")
+void mainEffect_setTextureSpaceEnabled(bool textureSpaceEnabled);
+// SSS_IRRADIANCE_ENCODING_* / SSS_DEPTH_ENCODING_*, which should match the formats of the "irradianceRT" and the "depthRT" (see "subsurface_scattering_gbuffer_encoding.h")
+void mainEffect_setGBufferEncoding(int irradianceEncoding, int depthEncoding);
+// SSS_SHADOW_DEPTH_MODE_*, which should match the "linearDepthFormat" of the shadow maps (see "subsurface_scattering_shadow_thickness.h")
+void mainEffect_setShadowDepthMode(int shadowDepthMode);
 
 float mainEffect_getAmbient();
 
-void mainPass(ID3D11DeviceContext* context, ID3D11RenderTargetView* mainRT, ID3D11RenderTargetView* depthRT, ID3D11RenderTargetView* albedoRT, ID3D11RenderTargetView* irradianceRT, ID3D11DepthStencilView* depthStencil);
+// The counters of the last "mainPass" (only updated if the LOD is enabled)
+const SSSLodSelector& mainEffect_getLodSelector();
+// The counters of the atlas (only updated if the texture space diffusion is enabled)
+const SSSTextureSpaceCache& mainEffect_getTextureSpaceCache();
+
+// The heads cycle through the profiles and the stencil of each head is "profile index + 1" (with the "reduced budget" bit of the LOD, or zero if the head is NOT blurred)
+// textureSpaceBlur: diffuses the dirty slots of the texture space atlas (NULL disables the texture space diffusion)
+void mainPass(ID3D11DeviceContext* context, ID3D11RenderTargetView* mainRT, ID3D11RenderTargetView* depthRT, ID3D11RenderTargetView* albedoRT, ID3D11RenderTargetView* irradianceRT, ID3D11RenderTargetView* velocityRT, ID3D11DepthStencilView* depthStencil, const SSSProfileTable& profiles, SSSBlur* textureSpaceBlur);
 
 #endif
@@ -33,7 +33,7 @@
 #include <DirectXMath.h>
 using namespace std;
 
-RenderTarget::RenderTarget(ID3D11Device* device, int width, int height, DXGI_FORMAT format, const DXGI_SAMPLE_DESC& sampleDesc, bool typeless)
+RenderTarget::RenderTarget(ID3D11Device* device, int width, int height, DXGI_FORMAT format, const DXGI_SAMPLE_DESC& sampleDesc, bool typeless, bool mipmapped)
 	: width(width), height(height)
 {
 	HRESULT hr;
@@ -42,13 +42,16 @@ RenderTarget::RenderTarget(ID3D11Device* device, int width, int height, DXGI_FOR
 	ZeroMemory(&desc, sizeof(desc));
 	desc.Width = width;
 	desc.Height = height;
-	desc.MipLevels = 1;
+	// The full mip chain (filled by the "GenerateMips")
+	desc.MipLevels = mipmapped ? 0 : 1;
 	desc.ArraySize = 1;
 	desc.Format = typeless ? makeTypeless(format) : format;
 	desc.SampleDesc = sampleDesc;
 	desc.Usage = D3D11_USAGE_DEFAULT;
 	desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	desc.MiscFlags = mipmapped ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0;
 	V(device->CreateTexture2D(&desc, NULL, &texture2D));
+	texture2D->GetDesc(&desc);
 
 	createViews(device, desc, format);
 }
@@ -117,7 +120,7 @@ void RenderTarget::createViews(ID3D11Device* device, D3D11_TEXTURE2D_DESC desc,
 		srdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DMS;
 	}
 	srdesc.Texture2D.MostDetailedMip = 0;
-	srdesc.Texture2D.MipLevels = 1;
+	srdesc.Texture2D.MipLevels = (0 != (desc.MiscFlags & D3D11_RESOURCE_MISC_GENERATE_MIPS)) ? desc.MipLevels : 1;
 	V(device->CreateShaderResourceView(texture2D, &srdesc, &shaderResourceView));
 }
 
@@ -167,8 +170,8 @@ DXGI_FORMAT RenderTarget::makeTypeless(DXGI_FORMAT format)
 
 DepthStencil::DepthStencil(ID3D11Device* device, int width, int height, DXGI_FORMAT texture2DFormat,
 	const DXGI_FORMAT depthStencilViewFormat, DXGI_FORMAT shaderResourceViewFormat,
-	const DXGI_SAMPLE_DESC& sampleDesc)
-	: device(device), width(width), height(height)
+	const DXGI_SAMPLE_DESC& sampleDesc, DXGI_FORMAT stencilShaderResourceViewFormat)
+	: device(device), width(width), height(height), readOnlyDepthStencilView(NULL), stencilShaderResourceView(NULL)
 {
 	HRESULT hr;
 
@@ -213,6 +216,15 @@ DepthStencil::DepthStencil(ID3D11Device* device, int width, int height, DXGI_FOR
 		srdesc.Texture2D.MostDetailedMip = 0;
 		srdesc.Texture2D.MipLevels = 1;
 		V(device->CreateShaderResourceView(texture2D, &srdesc, &shaderResourceView));
+
+		if (stencilShaderResourceViewFormat != DXGI_FORMAT_UNKNOWN)
+		{
+			srdesc.Format = stencilShaderResourceViewFormat;
+			V(device->CreateShaderResourceView(texture2D, &srdesc, &stencilShaderResourceView));
+
+			dsdesc.Flags = D3D11_DSV_READ_ONLY_DEPTH | D3D11_DSV_READ_ONLY_STENCIL;
+			V(device->CreateDepthStencilView(texture2D, &dsdesc, &readOnlyDepthStencilView));
+		}
 	}
 	else
 	{
@@ -225,6 +237,8 @@ DepthStencil::~DepthStencil()
 	SAFE_RELEASE(texture2D);
 	SAFE_RELEASE(depthStencilView);
 	SAFE_RELEASE(shaderResourceView);
+	SAFE_RELEASE(readOnlyDepthStencilView);
+	SAFE_RELEASE(stencilShaderResourceView);
 }
 
 void DepthStencil::setViewport(ID3D11DeviceContext* context, float minDepth, float maxDepth) const
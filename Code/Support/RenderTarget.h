@@ -53,7 +53,8 @@ public:
 	RenderTarget(ID3D11Device* device, int width, int height,
 		DXGI_FORMAT format,
 		const DXGI_SAMPLE_DESC& sampleDesc = NoMSAA(),
-		bool typeless = true);
+		bool typeless = true,
+		bool mipmapped = false);
 
 	/**
 		 * These two are just convenience constructors to build from existing
@@ -94,13 +95,22 @@ public:
 		DXGI_FORMAT texture2DFormat = DXGI_FORMAT_R32_TYPELESS,
 		DXGI_FORMAT depthStencilViewFormat = DXGI_FORMAT_D32_FLOAT,
 		DXGI_FORMAT shaderResourceViewFormat = DXGI_FORMAT_R32_FLOAT,
-		const DXGI_SAMPLE_DESC& sampleDesc = NoMSAA());
+		const DXGI_SAMPLE_DESC& sampleDesc = NoMSAA(),
+		DXGI_FORMAT stencilShaderResourceViewFormat = DXGI_FORMAT_UNKNOWN);
 	~DepthStencil();
 
 	operator ID3D11Texture2D* const() { return texture2D; }
 	operator ID3D11DepthStencilView* const() { return depthStencilView; }
 	operator ID3D11ShaderResourceView* const() { return shaderResourceView; }
 
+	/**
+	 * Only available if the "stencilShaderResourceViewFormat" is NOT
+	 * DXGI_FORMAT_UNKNOWN. The read-only view allows the stencil test while
+	 * the stencil is bound as the shader resource.
+	 */
+	ID3D11ShaderResourceView* getStencilShaderResourceView() const { return stencilShaderResourceView; }
+	ID3D11DepthStencilView* getReadOnlyDepthStencilView() const { return readOnlyDepthStencilView; }
+
 	int getWidth() const { return width; }
 	int getHeight() const { return height; }
 
@@ -112,6 +122,8 @@ private:
 	ID3D11Texture2D* texture2D;
 	ID3D11DepthStencilView* depthStencilView;
 	ID3D11ShaderResourceView* shaderResourceView;
+	ID3D11DepthStencilView* readOnlyDepthStencilView;
+	ID3D11ShaderResourceView* stencilShaderResourceView;
 };
 
 class BackbufferRenderTarget
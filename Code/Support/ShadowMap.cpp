@@ -33,8 +33,10 @@
 #include "../Demo.h"
 
 #include "../../dxbc/ShadowMap_ShadowMapVS_bytecode.inl"
+#include "../../dxbc/ShadowMap_ShadowMapPS_bytecode.inl"
 
 ID3D11VertexShader* ShadowMap::ShadowMapVS = NULL;
+ID3D11PixelShader* ShadowMap::ShadowMapPS = NULL;
 ID3D11Buffer* ShadowMap::CbufUpdatedPerFrame = NULL;
 ID3D11Buffer* ShadowMap::CbufUpdatedPerObject = NULL;
 ID3D11DepthStencilState* ShadowMap::EnableDepthDisableStencil = NULL;
@@ -78,6 +80,7 @@ void ShadowMap::init(ID3D11Device* device) {
 	V(device->CreateBuffer(&UpdatedPerObjectDesc, NULL, &CbufUpdatedPerObject));
 
 	V(device->CreateVertexShader(ShadowMap_ShadowMapVS_bytecode, sizeof(ShadowMap_ShadowMapVS_bytecode), NULL, &ShadowMapVS));
+	V(device->CreatePixelShader(ShadowMap_ShadowMapPS_bytecode, sizeof(ShadowMap_ShadowMapPS_bytecode), NULL, &ShadowMapPS));
 
 	D3D11_DEPTH_STENCIL_DESC EnableDepthDisableStencilDesc = { };
 	EnableDepthDisableStencilDesc.DepthEnable = TRUE;
@@ -130,17 +133,20 @@ void ShadowMap::release() {
 	SAFE_RELEASE(EnableDepthDisableStencil);
 	SAFE_RELEASE(CbufUpdatedPerObject);
 	SAFE_RELEASE(CbufUpdatedPerFrame);
+	SAFE_RELEASE(ShadowMapPS);
 	SAFE_RELEASE(ShadowMapVS);
 }
 
 
-ShadowMap::ShadowMap(ID3D11Device* device, int width, int height)
+ShadowMap::ShadowMap(ID3D11Device* device, int width, int height, DXGI_FORMAT linearDepthFormat)
 {
 	depthStencil = new DepthStencil(device, width, height);
+	linearDepthRT = (DXGI_FORMAT_UNKNOWN != linearDepthFormat) ? new RenderTarget(device, width, height, linearDepthFormat) : NULL;
 }
 
 
 ShadowMap::~ShadowMap() {
+	SAFE_DELETE(linearDepthRT);
 	SAFE_DELETE(depthStencil);
 }
 
@@ -150,6 +156,13 @@ void ShadowMap::begin(ID3D11DeviceContext* context, const DirectX::XMFLOAT4X4& v
 	context->IASetInputLayout(vertexLayout);
 
 	context->ClearDepthStencilView(*depthStencil, D3D11_CLEAR_DEPTH, 1.0, 0);
+	if (NULL != linearDepthRT)
+	{
+		// The far plane, the same as the NDC depth 1.0
+		const float farPlane = projection.m[3][2] / (1.0f - projection.m[2][2]);
+		const float clearColor[4] = { farPlane, farPlane, farPlane, farPlane };
+		context->ClearRenderTargetView(*linearDepthRT, clearColor);
+	}
 
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 	context->Map(CbufUpdatedPerFrame, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
@@ -157,7 +170,7 @@ void ShadowMap::begin(ID3D11DeviceContext* context, const DirectX::XMFLOAT4X4& v
 	((struct UpdatedPerFrame*)mappedResource.pData)->projection = projection;
 	context->Unmap(CbufUpdatedPerFrame, 0);
 
-	ID3D11RenderTargetView* pRenderTargetViews[1] = { NULL };
+	ID3D11RenderTargetView* pRenderTargetViews[1] = { (NULL != linearDepthRT) ? static_cast<ID3D11RenderTargetView*>(*linearDepthRT) : NULL };
 	context->OMSetRenderTargets(1, pRenderTargetViews, *depthStencil);
 
 	UINT numViewports = 1;
@@ -168,7 +181,7 @@ void ShadowMap::begin(ID3D11DeviceContext* context, const DirectX::XMFLOAT4X4& v
 	context->VSSetConstantBuffers(CB_UPDATEDPEROBJECT, 1U, &CbufUpdatedPerObject);
 	context->VSSetShader(ShadowMapVS, NULL, 0);
 	context->GSSetShader(NULL, NULL, 0);
-	context->PSSetShader(NULL, NULL, 0);
+	context->PSSetShader((NULL != linearDepthRT) ? ShadowMapPS : NULL, NULL, 0);
 	context->OMSetDepthStencilState(EnableDepthDisableStencil, 0);
 	FLOAT BlendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 	context->OMSetBlendState(NoBlending, BlendFactor, 0xFFFFFFFF);
@@ -44,7 +44,8 @@ public:
 	static void init(ID3D11Device* device);
 	static void release();
 
-	ShadowMap(ID3D11Device* device, int width, int height);
+	// linearDepthFormat: DXGI_FORMAT_R16_FLOAT / DXGI_FORMAT_R32_FLOAT of the linear shadow map, or DXGI_FORMAT_UNKNOWN if only the hardware depth is rendered
+	ShadowMap(ID3D11Device* device, int width, int height, DXGI_FORMAT linearDepthFormat = DXGI_FORMAT_UNKNOWN);
 	~ShadowMap();
 
 	void begin(ID3D11DeviceContext* context, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
@@ -53,13 +54,18 @@ public:
 
 	operator ID3D11ShaderResourceView* const () { return *depthStencil; }
 
+	// The view space position z of the light (NULL if the "linearDepthFormat" is DXGI_FORMAT_UNKNOWN)
+	ID3D11ShaderResourceView* getLinearDepthSRV() const { return (NULL != linearDepthRT) ? static_cast<ID3D11ShaderResourceView*>(*linearDepthRT) : NULL; }
+
 	static DirectX::XMFLOAT4X4 getViewProjectionTextureMatrix(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
 
 private:
 	DepthStencil* depthStencil;
+	RenderTarget* linearDepthRT;
 	D3D11_VIEWPORT viewport;
 
 	static ID3D11VertexShader* ShadowMapVS;
+	static ID3D11PixelShader* ShadowMapPS;
 	static ID3D11Buffer* CbufUpdatedPerFrame;
 	static ID3D11Buffer* CbufUpdatedPerObject;
 	static ID3D11DepthStencilState* EnableDepthDisableStencil;
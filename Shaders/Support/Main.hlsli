@@ -40,6 +40,10 @@ SamplerComparisonState ShadowSampler : register(s3);
 #include "../brdf.hlsli"
 #include "../subsurface_scattering_texturing_mode.hlsli"
 #include "../subsurface_scattering_disney_transmittance.hlsli"
+#include "../subsurface_scattering_transmittance_lut.hlsli"
+#include "../subsurface_scattering_preintegrated_lut.hlsli"
+#include "../subsurface_scattering_gbuffer_encoding.hlsli"
+#include "../subsurface_scattering_shadow_thickness.hlsli"
 
 #define N_LIGHTS 5
 
@@ -68,6 +72,7 @@ cbuffer UpdatedPerFrame : register(b0)
 cbuffer UpdatedPerObject : register(b1)
 {
     row_major float4x4 currWorldViewProj;
+    row_major float4x4 prevWorldViewProj;
     row_major float4x4 world;
     row_major float4x4 worldInverseTranspose;
     float3 scatteringDistance;
@@ -84,6 +89,19 @@ cbuffer UpdatedPerObject : register(b1)
     float worldScale;
     float postscatterEnabled;
     float ambient;
+    float transmittanceLUTEnabled;
+    float transmittanceLUTMaxThickness;
+    int profileIndex;
+    // SSS_IRRADIANCE_ENCODING_* and SSS_DEPTH_ENCODING_* of the render targets (the same as the "SSSBlur")
+    int irradianceEncoding;
+    int depthEncoding;
+    // SSS_SHADOW_DEPTH_MODE_*: the thickness of the transmittance is read from the "linearShadowMaps" unless the NDC_R32F
+    int shadowDepthMode;
+    // The diffuse is shaded by the "preintegratedLUT" instead of writing the irradiance for the blur (the stencil of the object is 0)
+    float preintegratedEnabled;
+    // The diffuse is sampled from the slice "textureSpaceSlice" of the "textureSpaceAtlas" instead of writing the irradiance for the blur (the stencil of the object is 0)
+    float textureSpaceEnabled;
+    int textureSpaceSlice;
 }
 
 Texture2D diffuseTex : register(t0);
@@ -92,6 +110,11 @@ Texture2D specularAOTex : register(t3);
 Texture2D beckmannTex : register(t4);
 TextureCube irradianceTex : register(t5);
 Texture2D shadowMaps[N_LIGHTS] : register(t6);
+Texture2D<float4> transmittanceLUT : register(t11);
+Texture2D linearShadowMaps[N_LIGHTS] : register(t12);
+Texture2DArray<float4> preintegratedLUT : register(t17);
+Texture2D<float> curvatureMap : register(t18);
+Texture2DArray<float4> textureSpaceAtlas : register(t19);
 
 void ShadowMapArray_GetDimensions(float LightIndex, out float Width, out float Height)
 {
@@ -188,12 +211,125 @@ float ShadowMapArray_SampleLevel(float LightIndex, float2 Location)
     return tmp;
 }
 
+float LinearShadowMapArray_SampleLevel(float LightIndex, float2 Location)
+{
+    float tmp;
+    [branch]
+    if (0 == LightIndex)
+    {
+        tmp = linearShadowMaps[0].SampleLevel(LinearSampler, Location, 0.0).r;
+    }
+    else if (1 == LightIndex)
+    {
+        tmp = linearShadowMaps[1].SampleLevel(LinearSampler, Location, 0.0).r;
+    }
+    else if (2 == LightIndex)
+    {
+        tmp = linearShadowMaps[2].SampleLevel(LinearSampler, Location, 0.0).r;
+    }
+    else if (3 == LightIndex)
+    {
+        tmp = linearShadowMaps[3].SampleLevel(LinearSampler, Location, 0.0).r;
+    }
+    else if (4 == LightIndex)
+    {
+        tmp = linearShadowMaps[4].SampleLevel(LinearSampler, Location, 0.0).r;
+    }
+    else
+    {
+        // 5 == N_LIGHTS
+        tmp = 0.0;
+    }
+    return tmp;
+}
+
+// The attenuation of the distance and the falloff of the spot light
+float LightAttenuation(int i, float3 worldPosition, float3 light)
+{
+    float spot = dot(lights[i].direction, -light);
+    if (spot > lights[i].falloffStart)
+    {
+        float dist = length(lights[i].position - worldPosition);
+        float curve = min(pow(dist / lights[i].farPlane, 6.0), 1.0);
+        float attenuation = lerp(1.0 / (1.0 + lights[i].color_attenuation.w * dist * dist), 0.0, curve);
+
+        // And the spot light falloff:
+        spot = saturate((spot - lights[i].falloffStart) / lights[i].falloffWidth);
+
+        return attenuation * spot;
+    }
+    else
+    {
+        return 0.0f;
+    }
+}
+
+// The transmittance of the light (through the thickness read from the shadow map) multiplied by its attenuation around the geometric normal
+float3 LightTransmittance(int i, float3 worldPosition, float3 geometricNormal, float3 light)
+{
+    float transmittanceLightAttenuation = EvaluateTransmittanceLightAttenuation(geometricNormal, light);
+    if (transmittanceLightAttenuation > 0.0)
+    {
+        /**
+         * First we shrink the position inwards the surface to avoid artifacts:
+         * (Note that this can be done once for all the lights)
+         */
+        float metersPerUnit = worldScale;
+        float4 shrinkedPos = float4(worldPosition - 0.000625 / metersPerUnit * geometricNormal, 1.0);
+
+        // Faceworks
+        // g_deepScatterNormalOffset = -0.0007f
+
+        /**
+         * Now we calculate the thickness from the light point of view:
+         */
+        float4 shadowPosition = mul(shrinkedPos, lights[i].viewProjection);
+        // The w (before the perspective division) is the view space position z of the light
+        float shadowPositionW = shadowPosition.w;
+        shadowPosition /= shadowPosition.w;
+        float thicknessInUnits;
+        [branch]
+        if (SSS_SHADOW_DEPTH_MODE_NDC_R32F != shadowDepthMode)
+        {
+            thicknessInUnits = subsurface_scattering_shadow_thickness_from_linear(LinearShadowMapArray_SampleLevel(i, shadowPosition.xy), shadowPositionW);
+        }
+        else
+        {
+            thicknessInUnits = subsurface_scattering_shadow_thickness_from_ndc(ShadowMapArray_SampleLevel(i, shadowPosition.xy), shadowPosition.z, lights[i].projection);
+        }
+
+        // The shader code is merely to transform the thickness from world units to mm.
+        float thicknessInMillimeters = 1000.0 * metersPerUnit * thicknessInUnits;
+
+        float3 transmittance;
+        [branch]
+        if (transmittanceLUTEnabled > 0.0f)
+        {
+            transmittance = subsurface_scattering_transmittance_lut(transmittanceLUT, profileIndex, transmittanceLUTMaxThickness, scatteringDistance, transmittanceTint, thicknessInMillimeters);
+        }
+        else
+        {
+            transmittance = transmittanceTint * EvaluateTransmittance(scatteringDistance, thicknessInMillimeters);
+        }
+
+        return transmittance * transmittanceLightAttenuation;
+    }
+    else
+    {
+        return float3(0.0, 0.0, 0.0);
+    }
+}
+
 struct RenderV2P
 {
     // Position and texcoord:
     float4 svPosition : SV_POSITION;
     float2 texcoord : TEXCOORD0;
 
+    // For the motion vector:
+    float4 currPosition : TEXCOORD1;
+    float4 prevPosition : TEXCOORD2;
+
     // For shading:
     centroid float3 worldPosition : TEXCOORD3;
     centroid float3 view : TEXCOORD4;
@@ -214,6 +350,8 @@ RenderV2P RenderVS(float4 position
 
     // Transform to homogeneous projection space:
     output.svPosition = mul(position, currWorldViewProj);
+    output.currPosition = output.svPosition;
+    output.prevPosition = mul(position, prevWorldViewProj);
 
     // Output texture coordinates:
     output.texcoord = texcoord;
@@ -235,7 +373,8 @@ float4 RenderPS(
     RenderV2P input, 
     out float depth : SV_TARGET1, 
     out float4 albedoOut : SV_TARGET2, 
-    out float4 sssTotalDiffuseReflectancePreScatterMultiplyFormFactorOut : SV_TARGET3
+    out float4 sssTotalDiffuseReflectancePreScatterMultiplyFormFactorOut : SV_TARGET3, 
+    out float2 velocity : SV_TARGET4
 ) : SV_TARGET0
 {
     // We build the TBN frame here in order to be able to use the bump map for IBL:
@@ -252,9 +391,22 @@ float4 RenderPS(
     // Fetch albedo, specular parameters and static ambient occlusion:
     float4 albedoAndStrength = diffuseTex.Sample(AnisotropicSampler, input.texcoord);
     float3 specularAO = specularAOTex.Sample(LinearSampler, input.texcoord).rgb;
+
+    // The pre-integrated LUT replaces the blur, s.t. the whole albedo is applied here (NOT split into the pre-scatter and the post-scatter)
+    bool preintegrated = (sssEnabled > 0.0f) && (preintegratedEnabled > 0.0f);
+    float curvatureInMillimeters = 0.0;
+    [branch]
+    if (preintegrated)
+    {
+        curvatureInMillimeters = subsurface_scattering_curvature_in_mm(curvatureMap.Sample(LinearSampler, input.texcoord), worldScale);
+    }
+
+    // The atlas replaces the diffuse, the transmittance and the ambient (relit and diffused in the texture space), s.t. only the specular is shaded here
+    bool textureSpace = (sssEnabled > 0.0f) && (!preintegrated) && (textureSpaceEnabled > 0.0f);
+
     float3 total_diffuse_reflectance_pre_scatter;
     [branch]
-    if (sssEnabled > 0.0f)
+    if ((sssEnabled > 0.0f) && (!preintegrated))
     {
         total_diffuse_reflectance_pre_scatter = subsurface_scattering_total_diffuse_reflectance_pre_scatter_from_albedo((postscatterEnabled > 0.0), albedoAndStrength.rgb);
     }
@@ -276,31 +428,22 @@ float4 RenderPS(
         float3 light = normalize(lights[i].position - input.worldPosition);
 
         // Calculate attenuation:
-        float light_attenuation;
-        {
-            float spot = dot(lights[i].direction, -light);
-            if (spot > lights[i].falloffStart)
-            {
-                float dist = length(lights[i].position - input.worldPosition);
-                float curve = min(pow(dist / lights[i].farPlane, 6.0), 1.0);
-                float attenuation = lerp(1.0 / (1.0 + lights[i].color_attenuation.w * dist * dist), 0.0, curve);
-
-                // And the spot light falloff:
-                spot = saturate((spot - lights[i].falloffStart) / lights[i].falloffWidth);
-
-                light_attenuation = attenuation * spot;
-            }
-            else
-            {
-                light_attenuation = 0.0f;
-            }
-        }
+        float light_attenuation = LightAttenuation(i, input.worldPosition, light);
 
         if (light_attenuation > 0.0f)
         {
             // Add the diffuse and specular components:
             float ndotl = saturate(dot(light, normal));
-            if (ndotl > 0.0f)
+
+            // The "saturate(N.L)" of the diffuse, which is wrapped around the terminator by the pre-integrated LUT
+            float3 diffuseNdotL = float3(ndotl, ndotl, ndotl);
+            [branch]
+            if (preintegrated)
+            {
+                diffuseNdotL = subsurface_scattering_preintegrated_lut(preintegratedLUT, profileIndex, scatteringDistance, dot(light, normal), curvatureInMillimeters);
+            }
+
+            if (max(max(diffuseNdotL.r, diffuseNdotL.g), diffuseNdotL.b) > 0.0f)
             {
                 float3 halfn = normalize(input.view + light);
                 float ndotv = saturate(dot(normal, input.view));
@@ -311,9 +454,12 @@ float4 RenderPS(
                 float shadow = ShadowPCF(input.worldPosition, i, 3, 1.0);
                 if (shadow > 0.0f)
                 {
-                    diffuseAccumulation += Diffuse_Disney(total_diffuse_reflectance_pre_scatter, roughness, ndotv, ndotl, vdoth) * ndotl * shadow * light_attenuation * lights[i].color_attenuation.xyz;
+                    if (!textureSpace)
+                    {
+                        diffuseAccumulation += Diffuse_Disney(total_diffuse_reflectance_pre_scatter, roughness, ndotv, ndotl, vdoth) * diffuseNdotL * shadow * light_attenuation * lights[i].color_attenuation.xyz;
+                    }
 
-                    if (specularlightEnabled > 0.0f)
+                    if ((specularlightEnabled > 0.0f) && (ndotl > 0.0f))
                     {
                         specularAccumulation += specularTint * Dual_Specular_TR(0.75, 1.30, 0.85, specularFresnel * float3(1.0, 1.0, 1.0), roughness, strength, ndotv, ndotl, ndoth, vdoth) * ndotl * shadow * light_attenuation * lights[i].color_attenuation.xyz;
                     }
@@ -321,56 +467,59 @@ float4 RenderPS(
             }
 
             // Add the transmittance component:
-            if (sssEnabled > 0.0f)
+            if ((sssEnabled > 0.0f) && (!textureSpace))
             {
-                float transmittanceLightAttenuation = EvaluateTransmittanceLightAttenuation(input.normal, light);
-                if (transmittanceLightAttenuation > 0.0)
-                {
-                    /**
-                     * First we shrink the position inwards the surface to avoid artifacts:
-                     * (Note that this can be done once for all the lights)
-                     */
-                    float metersPerUnit = worldScale;
-                    float4 shrinkedPos = float4(input.worldPosition - 0.000625 / metersPerUnit * input.normal, 1.0);
-
-                    // Faceworks
-                    // g_deepScatterNormalOffset = -0.0007f
-
-                    /**
-                     * Now we calculate the thickness from the light point of view:
-                     */
-                    float4 shadowPosition = mul(shrinkedPos, lights[i].viewProjection);
-                    shadowPosition /= shadowPosition.w;
-                    float d1 = lights[i].projection[3][2] / (ShadowMapArray_SampleLevel(i, shadowPosition.xy) - lights[i].projection[2][2]);
-                    float d2 = lights[i].projection[3][2] / (shadowPosition.z - lights[i].projection[2][2]);
-                    float worldDistance = abs(d2 - d1);
-
-                    // The shader code is merely to transform the thickness from world units to mm.
-                    float thicknessInUnits = abs(d2 - d1);
-                    float thicknessInMillimeters = 1000.0 * metersPerUnit * thicknessInUnits;
-
-                    diffuseAccumulation += transmittanceTint * EvaluateTransmittance(scatteringDistance, thicknessInMillimeters) * transmittanceLightAttenuation * light_attenuation * lights[i].color_attenuation.xyz;
-                }
+                diffuseAccumulation += LightTransmittance(i, input.worldPosition, input.normal, light) * light_attenuation * lights[i].color_attenuation.xyz;
             }
         }
     }
 
     // Add the ambient component:
-    if (skylightEnabled > 0.0f)
+    if ((skylightEnabled > 0.0f) && (!textureSpace))
     {
         diffuseAccumulation += total_diffuse_reflectance_pre_scatter * occlusion * ambient * irradianceTex.Sample(LinearSampler, normal).rgb;
     }
 
-    // Store the ViewPositionZ value:
+    // Store the ViewPositionZ value (SV_POSITION.w is the view space position z):
     depth = input.svPosition.z;
+    [branch]
+    if (SSS_DEPTH_ENCODING_LINEAR_R16 == depthEncoding)
+    {
+        depth = subsurface_scattering_linear_depth_encode(input.svPosition.w, currProj);
+    }
+    else if ((SSS_DEPTH_ENCODING_VIEW_Z_R16F == depthEncoding) || (SSS_DEPTH_ENCODING_VIEW_Z_R32F == depthEncoding))
+    {
+        depth = input.svPosition.w;
+    }
 
     // Store the Albedo and the SSS strength:
     albedoOut = albedoAndStrength;
 
-    if (sssEnabled > 0.0f)
+    // Store the motion vector 'uv_curr - uv_prev' (the same as the 'subsurface_scattering_motion_vector' of the 'Code/CPU/subsurface_scattering_temporal.h'):
+    velocity = (input.currPosition.xy / input.currPosition.w - input.prevPosition.xy / input.prevPosition.w) * float2(0.5, -0.5);
+
+    [branch]
+    if (textureSpace)
     {
-        // Store the SSS 'total_diffuse_reflectance_pre_scatter * form_factor'
+        // The head is NOT blurred again (the stencil of the object is 0)
+        sssTotalDiffuseReflectancePreScatterMultiplyFormFactorOut = float4(0.0, 0.0, 0.0, 1.0);
+
+        float3 diffused = textureSpaceAtlas.Sample(LinearSampler, float3(input.texcoord, float(textureSpaceSlice))).rgb;
+        return float4(diffused * subsurface_scattering_total_diffuse_reflectance_post_scatter_from_albedo((postscatterEnabled > 0.0), albedoAndStrength.rgb) + specularAccumulation, 1.0);
+    }
+    else if ((sssEnabled > 0.0f) && (!preintegrated))
+    {
+        // Store the SSS 'total_diffuse_reflectance_pre_scatter * form_factor' (the R11G11B10F and the RGBA16F are encoded by the hardware)
         sssTotalDiffuseReflectancePreScatterMultiplyFormFactorOut = float4(diffuseAccumulation, 1.0);
+        [branch]
+        if (SSS_IRRADIANCE_ENCODING_RGB9E5 == irradianceEncoding)
+        {
+            sssTotalDiffuseReflectancePreScatterMultiplyFormFactorOut = float4(subsurface_scattering_rgb9e5_to_unorm16x2(subsurface_scattering_rgb9e5_encode(diffuseAccumulation)), 0.0, 0.0);
+        }
+        else if (SSS_IRRADIANCE_ENCODING_YCOCG == irradianceEncoding)
+        {
+            sssTotalDiffuseReflectancePreScatterMultiplyFormFactorOut = float4(subsurface_scattering_ycocg_encode(diffuseAccumulation, int2(input.svPosition.xy)), 0.0, 0.0);
+        }
 
         return float4(specularAccumulation, 1.0);
     }
@@ -382,6 +531,86 @@ float4 RenderPS(
     }
 }
 
+struct TextureSpaceV2P
+{
+    // The texel of the atlas:
+    float4 svPosition : SV_POSITION;
+    float2 texcoord : TEXCOORD0;
+
+    // For shading:
+    float3 worldPosition : TEXCOORD1;
+    float3 normal : TEXCOORD2;
+    float3 tangent : TEXCOORD3;
+};
+
+// The mesh is rasterized into the texture space of the head (the same vertex layout as the "RenderVS")
+TextureSpaceV2P TextureSpaceVS(float4 position
+                               : POSITION0,
+                                 float3 normal
+                               : NORMAL,
+                                 float3 tangent
+                               : TANGENT,
+                                 float2 texcoord
+                               : TEXCOORD0)
+{
+    TextureSpaceV2P output;
+
+    output.svPosition = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+    output.texcoord = texcoord;
+
+    output.worldPosition = mul(position, world).xyz;
+    output.normal = mul(normal, (float3x3)worldInverseTranspose);
+    output.tangent = mul(tangent, (float3x3)worldInverseTranspose);
+
+    return output;
+}
+
+// The relighting of the texture space diffusion: (total_diffuse_reflectance_pre_scatter_multiply_form_factor, coverage) of each texel, which is diffused into the atlas by the "SSSBlur::goTextureSpace"
+// NOTE: the view is along the normal, s.t. the irradiance does NOT depend on the camera (the retro-reflection of the "Diffuse_Disney" is evaluated at "N.V = 1"), and the specular is still shaded by the "RenderPS"
+float4 TextureSpacePS(TextureSpaceV2P input) : SV_TARGET0
+{
+    input.normal = normalize(input.normal);
+    input.tangent = normalize(input.tangent);
+    float3 bitangent = cross(input.normal, input.tangent);
+    float3x3 tbn = transpose(float3x3(input.tangent, bitangent, input.normal));
+
+    float3 tangentNormal = lerp(float3(0.0, 0.0, 1.0), UnpackNormalMap(normalTex.Sample(AnisotropicSampler, input.texcoord).gr), bumpiness);
+    float3 normal = mul(tbn, tangentNormal);
+
+    float3 albedo = diffuseTex.Sample(AnisotropicSampler, input.texcoord).rgb;
+    float3 specularAO = specularAOTex.Sample(LinearSampler, input.texcoord).rgb;
+    float3 total_diffuse_reflectance_pre_scatter = subsurface_scattering_total_diffuse_reflectance_pre_scatter_from_albedo((postscatterEnabled > 0.0), albedo);
+    float occlusion = specularAO.b;
+    float roughness = (specularAO.g / 0.3) * specularRoughness;
+
+    float3 diffuseAccumulation = float3(0.0, 0.0, 0.0);
+    for (int i = 0; i < N_LIGHTS; i++)
+    {
+        float3 light = normalize(lights[i].position - input.worldPosition);
+        float light_attenuation = LightAttenuation(i, input.worldPosition, light);
+
+        if (light_attenuation > 0.0f)
+        {
+            float ndotl = saturate(dot(light, normal));
+            if (ndotl > 0.0f)
+            {
+                float vdoth = saturate(dot(normal, normalize(normal + light)));
+                float shadow = ShadowPCF(input.worldPosition, i, 3, 1.0);
+                diffuseAccumulation += Diffuse_Disney(total_diffuse_reflectance_pre_scatter, roughness, 1.0, ndotl, vdoth) * ndotl * shadow * light_attenuation * lights[i].color_attenuation.xyz;
+            }
+
+            diffuseAccumulation += LightTransmittance(i, input.worldPosition, input.normal, light) * light_attenuation * lights[i].color_attenuation.xyz;
+        }
+    }
+
+    if (skylightEnabled > 0.0f)
+    {
+        diffuseAccumulation += total_diffuse_reflectance_pre_scatter * occlusion * ambient * irradianceTex.Sample(LinearSampler, normal).rgb;
+    }
+
+    return float4(diffuseAccumulation, 1.0);
+}
+
 float3 UnpackNormalMap(float2 TextureSample)
 {
     float2 NormalXY = TextureSample * float2(2.0f, 2.0f) + float2(-1.0f, -1.0f);
@@ -0,0 +1 @@
+#include "Main.hlsli"
\ No newline at end of file
@@ -1,12 +1,40 @@
 cbuffer UpdatedPerFrame : register(b0)
 {
 	row_major float4x4 currProj;
-	float3 scatteringDistance;
-	float padding_scatteringDistance;
-	float worldScale;
 	float postscatterEnabled;
 	int sampleBudget;
 	int pixelsPerSample;
+	int inverseCdfMode;
+	int kernelCacheEnabled;
+	int sequence;
+	int misMode;
+	int resolutionFactor;
+	float2 sampleRotation;
+	float temporalBlend;
+	// The Cranley-Patterson offset of the radius of the frame (see "subsurface_scattering_sample_radius_offset" of the "Code/CPU/subsurface_scattering_temporal.h")
+	// NOTE: the kernel cache is baked without the offset
+	float sampleRadiusOffset;
+	// current NDC -> previous clip space
+	row_major float4x4 reprojection;
+	// The adaptive sampling (the "SSS_Blur_Pilot_PS" and the "SSS_Blur_Refinement_PS")
+	float samplesPerFrame;
+	int pilotSampleCount;
+	int2 padding_pilotSampleCount;
+	// 0 disables the mask pyramid
+	int maskPyramidLevelCount;
+	int3 padding_maskPyramidLevelCount;
+	// 0 disables the irradiance pyramid
+	int irradiancePyramidLevelCount;
+	int3 padding_irradiancePyramidLevelCount;
+	// SSS_IRRADIANCE_ENCODING_* and SSS_DEPTH_ENCODING_* of the full resolution (read by the "SSS_FULL_RESOLUTION_*" and the temporal resolve) and of the resolution of the blur (the low resolution render targets are NOT encoded)
+	int irradianceEncoding;
+	int depthEncoding;
+	int blurIrradianceEncoding;
+	int blurDepthEncoding;
+	// The texture space diffusion (the "SSS_Blur_TextureSpace_PS"): the profile of the head and the samples per texel
+	int textureSpaceProfileIndex;
+	int textureSpaceSampleCount;
+	int2 padding_textureSpaceSampleCount;
 }
 
 Texture2D g_albedo_texture : register(t0);
@@ -16,15 +44,139 @@ Texture2D g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture :
 
 Texture2D depthTex : register(t2);
 
+Texture1D<float2> g_diffusion_profile_inverse_cdf_lut : register(t3);
+
+Buffer<float4> g_kernel_cache : register(t4);
+
+// X24_TYPELESS_G8_UINT: stencil = profile_index + 1
+Texture2D<uint2> g_stencil_texture : register(t5);
+
+Buffer<float4> g_profiles : register(t6);
+
+// [profile index][sample index] = (weight.rgb, offset_in_mm)
+Buffer<float4> g_separable_kernel : register(t7);
+
+// The low resolution render targets (written by the "SSS_Blur_Downsample_PS" and read by the "SSS_Blur_Upsample_PS")
+// NOTE: the low resolution blur binds them as the t0 (albedo), t1 (irradiance), t2 (depth) and t5 (stencil) instead
+Texture2D g_low_resolution_blurred_texture : register(t8);
+
+Texture2D g_low_resolution_albedo_texture : register(t9);
+
+Texture2D g_low_resolution_depth_texture : register(t10);
+
+Texture2D<uint2> g_low_resolution_stencil_texture : register(t11);
+
+// The temporal accumulation (read by the "SSS_Blur_Temporal_PS")
+// The blurred radiance of the current frame
+Texture2D g_temporal_current_texture : register(t12);
+
+// (radiance.rgb, history_length) of the previous frame
+Texture2D g_temporal_history_texture : register(t13);
+
+// (view_space_position_z, subsurface_mask) of the previous frame
+Texture2D<float2> g_temporal_history_guide_texture : register(t14);
+
+// uv_curr - uv_prev
+Texture2D<float2> g_motion_vector_texture : register(t15);
+
+// The adaptive sampling (read by the "SSS_Blur_Refinement_PS")
+// (radiance.rgb, pilot_sample_count) of the pilot pass
+Texture2D g_adaptive_pilot_texture : register(t16);
+
+// (deviation, pilot_sample_count, covered, 0) of the pilot pass, of which the last mip (by the "GenerateMips") is the mean over all pixels
+// NOTE: the mean is approximate if the size is NOT the power of two, since the "GenerateMips" drops the odd texels
+Texture2D g_adaptive_pilot_error_texture : register(t17);
+
+// The tile classification (at the resolution of the tiles)
+// SSS_TILE_STATE_* (written by the "SSS_Blur_TileState_PS" and read by the "SSS_Blur_TileClassify_PS")
+Texture2D<uint> g_tile_state_texture : register(t18);
+
+// (class, profile_index, margin, 0) (written by the "SSS_Blur_TileClassify_PS" and read by the "SSS_Blur_TileInterior_VS" and the "SSS_Blur_TileEdge_VS")
+Texture2D<uint4> g_tile_class_texture : register(t19);
+
+// The mask pyramid (at the padded resolution of the blur)
+// (min_mask, max_mask, coverage, profile) with the mips (written by the "SSS_Blur_MaskPyramidBase_PS" and the "SSS_Blur_MaskPyramidReduce_PS", and read by the blur)
+Texture2D g_mask_pyramid_texture : register(t20);
+
+// The previous level of the mask pyramid (only read by the "SSS_Blur_MaskPyramidReduce_PS")
+Texture2D g_mask_pyramid_previous_level_texture : register(t21);
+
+// The irradiance pyramid (at the padded resolution of the blur)
+// (total_diffuse_reflectance_pre_scatter_multiply_form_factor, profile) and the view depth with the mips (written by the "SSS_Blur_IrradiancePyramidBase_PS" and the "SSS_Blur_IrradiancePyramidReduce_PS", and read by the blur)
+Texture2D g_irradiance_pyramid_texture : register(t22);
+Texture2D<float> g_irradiance_pyramid_view_space_position_z_texture : register(t23);
+
+// The previous level of the irradiance pyramid (only read by the "SSS_Blur_IrradiancePyramidReduce_PS")
+Texture2D g_irradiance_pyramid_previous_level_texture : register(t24);
+Texture2D<float> g_irradiance_pyramid_previous_level_view_space_position_z_texture : register(t25);
+
+// The texture space diffusion: the relit irradiance (with the coverage in the alpha), the object space positions and the stretch of the head (see "Code/CPU/SSSTextureSpace.h")
+Texture2D g_texture_space_irradiance_texture : register(t26);
+Texture2D g_texture_space_position_texture : register(t27);
+Texture2D<float2> g_texture_space_stretch_texture : register(t28);
+
 SamplerState PointSampler : register(s1);
 
 #include "../subsurface_scattering_texturing_mode.hlsli"
 
+#include "../subsurface_scattering_gbuffer_encoding.hlsli"
+
+// NOTE: the intermediate render target of the separable mode is NOT encoded
+inline int SSS_BLUR_IRRADIANCE_ENCODING()
+{
+#if defined(SSS_BLUR_SEPARABLE_VERTICAL) && SSS_BLUR_SEPARABLE_VERTICAL
+	return SSS_IRRADIANCE_ENCODING_RGBA16F;
+#else
+	return blurIrradianceEncoding;
+#endif
+}
+
+// The RGBA16F and the R11G11B10F are decoded by the hardware
+inline float3 SSS_BLUR_IRRADIANCE_LOAD(int irradiance_encoding, int2 texel)
+{
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	[branch]
+	if (SSS_IRRADIANCE_ENCODING_RGB9E5 == irradiance_encoding)
+	{
+		total_diffuse_reflectance_pre_scatter_multiply_form_factor = subsurface_scattering_rgb9e5_decode(subsurface_scattering_rgb9e5_from_unorm16x2(g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture.Load(int3(texel, 0)).rg));
+	}
+	else if (SSS_IRRADIANCE_ENCODING_YCOCG == irradiance_encoding)
+	{
+		uint outWidth;
+		uint outHeight;
+		g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture.GetDimensions(outWidth, outHeight);
+		int2 partner_texel = int2(subsurface_scattering_ycocg_partner_x(texel.x, int(outWidth)), texel.y);
+		float2 center = g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture.Load(int3(texel, 0)).rg;
+		float2 partner = g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture.Load(int3(partner_texel, 0)).rg;
+		total_diffuse_reflectance_pre_scatter_multiply_form_factor = subsurface_scattering_ycocg_decode(center, partner, texel);
+	}
+	else
+	{
+		total_diffuse_reflectance_pre_scatter_multiply_form_factor = g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture.Load(int3(texel, 0)).rgb;
+	}
+	return total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+}
+
 inline float3 SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE(float2 pixelCoord)
 {
-	// NOTE: use SampleLevel rather than Sample
-	// warning X3595: gradient instruction used in a loop with varying iteration; partial derivatives may have undefined value
-	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor = g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture.SampleLevel(PointSampler, pixelCoord, 0).rgb;
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	int irradiance_encoding = SSS_BLUR_IRRADIANCE_ENCODING();
+	[branch]
+	if ((SSS_IRRADIANCE_ENCODING_RGB9E5 == irradiance_encoding) || (SSS_IRRADIANCE_ENCODING_YCOCG == irradiance_encoding))
+	{
+		// NOTE: "Load" does NOT clamp the address, s.t. the address is clamped the same as the "PointSampler"
+		uint outWidth;
+		uint outHeight;
+		g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture.GetDimensions(outWidth, outHeight);
+		int2 texelCoord = clamp(int2(floor(pixelCoord * float2(outWidth, outHeight))), int2(0, 0), int2(outWidth, outHeight) - int2(1, 1));
+		total_diffuse_reflectance_pre_scatter_multiply_form_factor = SSS_BLUR_IRRADIANCE_LOAD(irradiance_encoding, texelCoord);
+	}
+	else
+	{
+		// NOTE: use SampleLevel rather than Sample
+		// warning X3595: gradient instruction used in a loop with varying iteration; partial derivatives may have undefined value
+		total_diffuse_reflectance_pre_scatter_multiply_form_factor = g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture.SampleLevel(PointSampler, pixelCoord, 0).rgb;
+	}
 	return total_diffuse_reflectance_pre_scatter_multiply_form_factor;
 }
 
@@ -40,6 +192,30 @@ inline float SSS_SUBSURFACE_MASK_SOURCE(float2 pixelCoord)
 	return g_albedo_texture.SampleLevel(PointSampler, pixelCoord, 0).a;
 }
 
+#include "../subsurface_scattering_profile.hlsli"
+
+inline uint SSS_BLUR_STENCIL(float2 pixelCoord)
+{
+	// NOTE: "Load" does NOT clamp the address, s.t. the address is clamped the same as the "PointSampler"
+	uint outWidth;
+	uint outHeight;
+	g_stencil_texture.GetDimensions(outWidth, outHeight);
+	int2 texelCoord = clamp(int2(floor(pixelCoord * float2(outWidth, outHeight))), int2(0, 0), int2(outWidth, outHeight) - int2(1, 1));
+	return g_stencil_texture.Load(int3(texelCoord, 0)).g;
+}
+
+inline int SSS_SUBSURFACE_PROFILE_INDEX_SOURCE(float2 pixelCoord)
+{
+	return subsurface_scattering_profile_index_from_stencil(SSS_BLUR_STENCIL(pixelCoord));
+}
+
+// The budget of the LOD of the head (see "Code/CPU/SSSLodSelector.h")
+// NOTE: the low resolution stencil (written by the "SSS_Blur_Downsample_PS") has no "reduced budget" bit, s.t. the low resolution blur always uses the full budget
+inline int SSS_BLUR_SAMPLE_BUDGET(float2 texcoord)
+{
+	return subsurface_scattering_sample_budget_from_stencil(SSS_BLUR_STENCIL(texcoord), sampleBudget);
+}
+
 inline float SSS_PROJECTION_X_SOURCE()
 {
 	return currProj[0][0];
@@ -60,10 +236,25 @@ inline float ndcz_to_viewpositionz(float ndcz, float4x4 proj)
 	return proj[3][2] / (ndcz - proj[2][2]);
 }
 
-inline float3 ndc_to_view(float3 ndc, float4x4 proj)
+// NOTE: the "SSS_DEPTH_ENCODING_VIEW_Z_*" is already the view space position z
+inline float depth_to_viewpositionz(int depth_encoding, float depth, float4x4 proj)
+{
+	float view_position_z = depth;
+	[branch]
+	if (SSS_DEPTH_ENCODING_NDC_R32F == depth_encoding)
+	{
+		view_position_z = ndcz_to_viewpositionz(depth, proj);
+	}
+	else if (SSS_DEPTH_ENCODING_LINEAR_R16 == depth_encoding)
+	{
+		view_position_z = subsurface_scattering_linear_depth_decode(depth, proj);
+	}
+	return view_position_z;
+}
+
+inline float3 ndcxy_to_view(float2 ndcxy, float view_position_z, float4x4 proj)
 {
-	float view_position_z = ndcz_to_viewpositionz(ndc.z, proj);
-	float2 view_position_xy = ndc.xy * view_position_z / float2(proj[0][0], proj[1][1]);
+	float2 view_position_xy = ndcxy * view_position_z / float2(proj[0][0], proj[1][1]);
 	return float3(view_position_xy, view_position_z);
 }
 
@@ -72,14 +263,14 @@ inline float SSS_VIEW_SPACE_POSITION_Z_SOURCE(float2 pixelCoord)
 	// NOTE: use SampleLevel rather than Sample
 	// warning X3595: gradient instruction used in a loop with varying iteration; partial derivatives may have undefined value
 	float depth = depthTex.SampleLevel(PointSampler, pixelCoord, 0).r;
-	float view_position_z = ndcz_to_viewpositionz(depth, currProj);
+	float view_position_z = depth_to_viewpositionz(blurDepthEncoding, depth, currProj);
 	return view_position_z;
 }
 
 inline float3 SSS_VIEW_SPACE_POSITION_SOURCE(float2 pixelCoord)
 {
 	float depth = depthTex.SampleLevel(PointSampler, pixelCoord, 0).r;
-	float3 view_position = ndc_to_view(float3(uv_to_ndcxy(pixelCoord), depth), currProj);
+	float3 view_position = ndcxy_to_view(uv_to_ndcxy(pixelCoord), depth_to_viewpositionz(blurDepthEncoding, depth, currProj), currProj);
 	return view_position;
 }
 
@@ -92,8 +283,225 @@ inline float2 SSS_PIXELS_PER_UV()
 	return float2(outWidth, outHeight);
 }
 
+#include "../diffusion_profile_inverse_cdf_lut.hlsli"
+
+inline float SSS_DIFFUSION_PROFILE_SAMPLE_R_SOURCE(float d, float cdf)
+{
+	return diffusion_profile_sample_r_lut(g_diffusion_profile_inverse_cdf_lut, inverseCdfMode, d, cdf);
+}
+
+#include "../subsurface_scattering_kernel_cache.hlsli"
+
+inline float SSS_CENTER_SAMPLE_CDF_SOURCE(float center_sample_cdf)
+{
+	return (kernelCacheEnabled != 0) ? subsurface_scattering_kernel_cache_center_sample_cdf(center_sample_cdf) : center_sample_cdf;
+}
+
+#include "../low_discrepancy_sequence.hlsli"
+
+inline float2 SSS_SAMPLE_SEQUENCE_SOURCE(int sample_count, int sample_index)
+{
+	// The offset is scaled by "1 / sample_count" (the stratum of the Hammersley)
+	float2 xi = low_discrepancy_sequence_2d(sequence, sample_index, sample_count);
+	return float2(frac(xi.x + sampleRadiusOffset / float(sample_count)), xi.y);
+}
+
+inline float2 SSS_SAMPLE_ROTATION_SOURCE()
+{
+	return sampleRotation;
+}
+
+inline int SSS_MASK_PYRAMID_LEVEL_COUNT()
+{
+	return maskPyramidLevelCount;
+}
+
+inline float4 SSS_MASK_PYRAMID_SOURCE(int level, int2 texel)
+{
+	return g_mask_pyramid_texture.Load(int3(texel, level));
+}
+
+inline int SSS_IRRADIANCE_PYRAMID_LEVEL_COUNT()
+{
+	return irradiancePyramidLevelCount;
+}
+
+inline float4 SSS_IRRADIANCE_PYRAMID_SOURCE(int level, int2 texel)
+{
+	return g_irradiance_pyramid_texture.Load(int3(texel, level));
+}
+
+inline float SSS_IRRADIANCE_PYRAMID_VIEW_SPACE_POSITION_Z_SOURCE(int level, int2 texel)
+{
+	return g_irradiance_pyramid_view_space_position_z_texture.Load(int3(texel, level));
+}
+
+float4 subsurface_scattering_disney_kernel_sample(float d, float center_sample_cdf, int sample_count, int sample_index);
+
+inline float4 SSS_KERNEL_SAMPLE_SOURCE(float d, float center_sample_cdf, int sample_count, int sample_index)
+{
+	float4 kernel_sample;
+	[branch]
+	if (kernelCacheEnabled != 0)
+	{
+		kernel_sample = subsurface_scattering_kernel_cache_sample(g_kernel_cache, d, center_sample_cdf, sample_count, sample_index);
+	}
+	else
+	{
+		kernel_sample = subsurface_scattering_disney_kernel_sample(d, center_sample_cdf, sample_count, sample_index);
+	}
+	return kernel_sample;
+}
+
 #include "../subsurface_scattering_disney_blur.hlsli"
 
+#include "../subsurface_scattering_adaptive.hlsli"
+
+inline float4 SSS_SEPARABLE_KERNEL_SAMPLE_SOURCE(int profile_index, int sample_index)
+{
+	return g_separable_kernel[SSS_SEPARABLE_KERNEL_SAMPLE_COUNT * profile_index + sample_index];
+}
+
+#include "../subsurface_scattering_separable_blur.hlsli"
+
+inline float3 SSS_FULL_RESOLUTION_IRRADIANCE_SOURCE(int2 texel)
+{
+	return SSS_BLUR_IRRADIANCE_LOAD(irradianceEncoding, texel);
+}
+
+inline float SSS_FULL_RESOLUTION_SUBSURFACE_MASK_SOURCE(int2 texel)
+{
+	return g_albedo_texture.Load(int3(texel, 0)).a;
+}
+
+inline int SSS_FULL_RESOLUTION_PROFILE_INDEX_SOURCE(int2 texel)
+{
+	return subsurface_scattering_profile_index_from_stencil(g_stencil_texture.Load(int3(texel, 0)).g);
+}
+
+inline float SSS_FULL_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE(int2 texel)
+{
+	return depth_to_viewpositionz(depthEncoding, depthTex.Load(int3(texel, 0)).r, currProj);
+}
+
+inline int2 SSS_FULL_RESOLUTION_SIZE()
+{
+	uint outWidth;
+	uint outHeight;
+	g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture.GetDimensions(outWidth, outHeight);
+	return int2(outWidth, outHeight);
+}
+
+inline float3 SSS_LOW_RESOLUTION_BLURRED_SOURCE(int2 texel)
+{
+	return g_low_resolution_blurred_texture.Load(int3(texel, 0)).rgb;
+}
+
+inline float SSS_LOW_RESOLUTION_SUBSURFACE_MASK_SOURCE(int2 texel)
+{
+	return g_low_resolution_albedo_texture.Load(int3(texel, 0)).a;
+}
+
+inline int SSS_LOW_RESOLUTION_PROFILE_INDEX_SOURCE(int2 texel)
+{
+	return subsurface_scattering_profile_index_from_stencil(g_low_resolution_stencil_texture.Load(int3(texel, 0)).g);
+}
+
+inline float SSS_LOW_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE(int2 texel)
+{
+	return ndcz_to_viewpositionz(g_low_resolution_depth_texture.Load(int3(texel, 0)).r, currProj);
+}
+
+inline int2 SSS_LOW_RESOLUTION_SIZE()
+{
+	uint outWidth;
+	uint outHeight;
+	g_low_resolution_blurred_texture.GetDimensions(outWidth, outHeight);
+	return int2(outWidth, outHeight);
+}
+
+#include "../subsurface_scattering_low_resolution.hlsli"
+
+inline float4 SSS_TEMPORAL_HISTORY_SOURCE(int2 texel)
+{
+	return g_temporal_history_texture.Load(int3(texel, 0));
+}
+
+inline float2 SSS_TEMPORAL_HISTORY_GUIDE_SOURCE(int2 texel)
+{
+	return g_temporal_history_guide_texture.Load(int3(texel, 0));
+}
+
+inline int2 SSS_TEMPORAL_HISTORY_SIZE()
+{
+	uint outWidth;
+	uint outHeight;
+	g_temporal_history_texture.GetDimensions(outWidth, outHeight);
+	return int2(outWidth, outHeight);
+}
+
+#include "../subsurface_scattering_temporal.hlsli"
+
+// NOTE: the tile classification runs at the resolution of the blur (the low resolution render targets are bound as the t0 and the t5 if the resolution is NOT full)
+inline float SSS_TILE_SUBSURFACE_MASK_SOURCE(int2 texel)
+{
+	return g_albedo_texture.Load(int3(texel, 0)).a;
+}
+
+inline int SSS_TILE_PROFILE_INDEX_SOURCE(int2 texel)
+{
+	return subsurface_scattering_profile_index_from_stencil(g_stencil_texture.Load(int3(texel, 0)).g);
+}
+
+inline int2 SSS_TILE_SCREEN_SIZE()
+{
+	return int2(SSS_PIXELS_PER_UV());
+}
+
+inline uint SSS_TILE_STATE_SOURCE(int2 tile)
+{
+	return g_tile_state_texture.Load(int3(tile, 0));
+}
+
+#include "../subsurface_scattering_tile_classification.hlsli"
+
+inline float4 SSS_TEXTURE_SPACE_IRRADIANCE_SOURCE(int2 texel)
+{
+	return g_texture_space_irradiance_texture.Load(int3(texel, 0));
+}
+
+inline float4 SSS_TEXTURE_SPACE_POSITION_SOURCE(int2 texel)
+{
+	return g_texture_space_position_texture.Load(int3(texel, 0));
+}
+
+inline float2 SSS_TEXTURE_SPACE_STRETCH_SOURCE(int2 texel)
+{
+	return g_texture_space_stretch_texture.Load(int3(texel, 0));
+}
+
+inline int SSS_TEXTURE_SPACE_SIZE()
+{
+	uint outWidth;
+	uint outHeight;
+	g_texture_space_position_texture.GetDimensions(outWidth, outHeight);
+	return int(outWidth);
+}
+
+#include "../subsurface_scattering_texture_space.hlsli"
+
+// NOTE: the stencil test guarantees that the profile index is valid at the full resolution, but the low resolution blur has no stencil buffer
+inline int SSS_BLUR_PROFILE_INDEX(float2 texcoord)
+{
+	int profile_index = SSS_SUBSURFACE_PROFILE_INDEX_SOURCE(texcoord);
+	[branch]
+	if (profile_index < 0)
+	{
+		discard;
+	}
+	return profile_index;
+}
+
 void SSS_Blur_VS(float4 position : POSITION, out float4 svposition : SV_POSITION, inout float2 texcoord : TEXCOORD0)
 {
 	svposition = position;
@@ -101,6 +509,273 @@ void SSS_Blur_VS(float4 position : POSITION, out float4 svposition : SV_POSITION
 
 float4 SSS_Blur_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
 {
-	float3 color = subsurface_scattering_disney_blur(scatteringDistance, worldScale, pixelsPerSample, sampleBudget, texcoord);
+	subsurface_scattering_profile profile = subsurface_scattering_profile_load(g_profiles, SSS_BLUR_PROFILE_INDEX(texcoord));
+	float3 color = subsurface_scattering_disney_blur(profile.scattering_distance, profile.filter_radius, profile.world_scale, pixelsPerSample, SSS_BLUR_SAMPLE_BUDGET(texcoord), misMode, texcoord);
+	return float4(color, 1.0);
+}
+
+struct SSS_Blur_Pilot_Output
+{
+	float4 pilot : SV_TARGET0;
+	float4 pilot_error : SV_TARGET1;
+};
+
+// Into the pilot render targets (no blending)
+SSS_Blur_Pilot_Output SSS_Blur_Pilot_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0)
+{
+	subsurface_scattering_profile profile = subsurface_scattering_profile_load(g_profiles, SSS_BLUR_PROFILE_INDEX(texcoord));
+	subsurface_scattering_disney_blur_result pilot = subsurface_scattering_disney_blur_estimate(profile.scattering_distance, profile.filter_radius, profile.world_scale, pixelsPerSample, pilotSampleCount, misMode, texcoord);
+
+	SSS_Blur_Pilot_Output output;
+	output.pilot = float4(pilot.radiance, float(pilot.sample_count));
+	output.pilot_error = float4(subsurface_scattering_adaptive_deviation(pilot.standard_error, pilot.sample_count), float(pilot.sample_count), (pilot.sample_count > 0) ? 1.0 : 0.0, 0.0);
+	return output;
+}
+
+// The refinement replaces the pilot (see "subsurface_scattering_adaptive.hlsli")
+float4 SSS_Blur_Refinement_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
+{
+	subsurface_scattering_profile profile = subsurface_scattering_profile_load(g_profiles, SSS_BLUR_PROFILE_INDEX(texcoord));
+
+	int2 texel = int2(position.xy);
+	float4 pilot = g_adaptive_pilot_texture.Load(int3(texel, 0));
+	// The mean deviation of the block of the pixel
+	float deviation = g_adaptive_pilot_error_texture.Load(int3(texel >> SSS_ADAPTIVE_DEVIATION_MIP_LEVEL, SSS_ADAPTIVE_DEVIATION_MIP_LEVEL)).r;
+
+	uint outWidth;
+	uint outHeight;
+	uint outNumberOfLevels;
+	g_adaptive_pilot_error_texture.GetDimensions(0, outWidth, outHeight, outNumberOfLevels);
+	float pixel_count = float(outWidth) * float(outHeight);
+	float3 mean_pilot_error = g_adaptive_pilot_error_texture.Load(int3(0, 0, outNumberOfLevels - 1)).rgb;
+
+	// (mean_deviation, mean_pilot_sample_count, coverage) over all pixels
+	float refinement_samples_per_pixel = subsurface_scattering_adaptive_refinement_samples_per_pixel(samplesPerFrame, mean_pilot_error.z * pixel_count, mean_pilot_error.y * pixel_count);
+	float uniform_sample_count = (mean_pilot_error.x > 0.0) ? (SSS_ADAPTIVE_UNIFORM_FRACTION * refinement_samples_per_pixel) : refinement_samples_per_pixel;
+	float deviation_scale = (mean_pilot_error.x > 0.0) ? ((1.0 - SSS_ADAPTIVE_UNIFORM_FRACTION) * refinement_samples_per_pixel * mean_pilot_error.z / mean_pilot_error.x) : 0.0;
+
+	int pilot_sample_count = int(pilot.a);
+	int refinement_sample_count = (pilot_sample_count > 0) ? subsurface_scattering_adaptive_refinement_sample_count(deviation, deviation_scale, uniform_sample_count, pilot_sample_count, SSS_BLUR_SAMPLE_BUDGET(texcoord)) : 0;
+
+	float3 color = pilot.rgb;
+	[branch]
+	if (refinement_sample_count > 0)
+	{
+		subsurface_scattering_disney_blur_result refinement = subsurface_scattering_disney_blur_estimate(profile.scattering_distance, profile.filter_radius, profile.world_scale, pixelsPerSample, refinement_sample_count, misMode, texcoord);
+		color = refinement.radiance;
+	}
+	return float4(color, 1.0);
+}
+
+// Into the intermediate render target (no blending)
+float4 SSS_Blur_SeparableHorizontal_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
+{
+	subsurface_scattering_profile profile = subsurface_scattering_profile_load(g_profiles, SSS_BLUR_PROFILE_INDEX(texcoord));
+	float3 color = subsurface_scattering_separable_blur(profile.filter_radius, profile.world_scale, float2(1.0, 0.0), texcoord);
+	return float4(color, 1.0);
+}
+
+// NOTE: the intermediate render target is bound as the "g_total_diffuse_reflectance_pre_scatter_multiply_form_factor_texture"
+float4 SSS_Blur_SeparableVertical_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
+{
+	subsurface_scattering_profile profile = subsurface_scattering_profile_load(g_profiles, SSS_BLUR_PROFILE_INDEX(texcoord));
+	float3 color = subsurface_scattering_separable_blur(profile.filter_radius, profile.world_scale, float2(0.0, 1.0), texcoord);
+	return float4(SSS_TOTAL_DIFFUSE_REFLECTANCE_POST_SCATTER_SOURCE(texcoord) * color, 1.0);
+}
+
+struct SSS_Blur_Downsample_Output
+{
+	float4 total_diffuse_reflectance_pre_scatter_multiply_form_factor : SV_TARGET0;
+	// The albedo is white, s.t. the low resolution blur outputs the blurred irradiance
+	float4 albedo : SV_TARGET1;
+	float depth : SV_TARGET2;
+	// The same layout as the X24_TYPELESS_G8_UINT
+	uint2 stencil : SV_TARGET3;
+};
+
+// At the low resolution (no blending)
+SSS_Blur_Downsample_Output SSS_Blur_Downsample_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0)
+{
+	subsurface_scattering_downsample_result result = subsurface_scattering_downsample(resolutionFactor, int2(position.xy));
+
+	SSS_Blur_Downsample_Output output;
+	output.total_diffuse_reflectance_pre_scatter_multiply_form_factor = float4(result.total_diffuse_reflectance_pre_scatter_multiply_form_factor, 1.0);
+	output.albedo = float4(1.0, 1.0, 1.0, result.subsurface_mask);
+	// NOTE: the low resolution depth is NOT encoded
+	float depth = depthTex.Load(int3(result.representative_texel, 0)).r;
+	output.depth = (SSS_DEPTH_ENCODING_NDC_R32F == depthEncoding) ? depth : subsurface_scattering_ndcz_from_view_space_position_z(depth_to_viewpositionz(depthEncoding, depth, currProj), currProj);
+	output.stencil = uint2(0, uint(result.profile_index + 1));
+	return output;
+}
+
+// At the full resolution (additive blending)
+float4 SSS_Blur_Upsample_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
+{
+	float3 color = subsurface_scattering_upsample(resolutionFactor, int2(position.xy));
+	return float4(SSS_TOTAL_DIFFUSE_REFLECTANCE_POST_SCATTER_SOURCE(texcoord) * color, 1.0);
+}
+
+
+struct SSS_Blur_Temporal_Output
+{
+	float4 radiance : SV_TARGET0;
+	float4 history : SV_TARGET1;
+	float2 history_guide : SV_TARGET2;
+};
+
+// At the full resolution (additive blending into the "radiance" and no blending into the "history" and the "history_guide")
+SSS_Blur_Temporal_Output SSS_Blur_Temporal_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0)
+{
+	int2 texel = int2(position.xy);
+	float3 current = g_temporal_current_texture.Load(int3(texel, 0)).rgb;
+	float subsurface_mask = g_albedo_texture.Load(int3(texel, 0)).a;
+	float view_space_position_z = depth_to_viewpositionz(depthEncoding, depthTex.Load(int3(texel, 0)).r, currProj);
+	float depth = subsurface_scattering_ndcz_from_view_space_position_z(view_space_position_z, currProj);
+
+	// NOTE: the previous uv is from the motion vector, while the view depth of the previous frame is predicted by the camera matrices
+	float2 prev_uv = texcoord - g_motion_vector_texture.Load(int3(texel, 0));
+	float predicted_prev_view_space_position_z = subsurface_scattering_temporal_reproject(texcoord, depth, view_space_position_z, reprojection).z;
+
+	float4 history = subsurface_scattering_temporal_history(prev_uv, predicted_prev_view_space_position_z, subsurface_mask);
+	float4 accumulated = subsurface_scattering_temporal_accumulate(current, history, temporalBlend);
+
+	SSS_Blur_Temporal_Output output;
+	output.radiance = float4(accumulated.rgb, 1.0);
+	output.history = accumulated;
+	output.history_guide = float2(view_space_position_z, subsurface_mask);
+	return output;
+}
+
+// At the resolution of the tiles (no stencil buffer and no blending)
+uint SSS_Blur_TileState_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
+{
+	return subsurface_scattering_tile_state(int2(position.xy));
+}
+
+// At the resolution of the tiles (no stencil buffer and no blending)
+uint4 SSS_Blur_TileClassify_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
+{
+	return uint4(subsurface_scattering_tile_classify(int2(position.xy)), 0);
+}
+
+// At the padded resolution of the level 0 of the mask pyramid (no stencil buffer and no blending)
+// NOTE: the mask pyramid runs at the resolution of the blur (the low resolution render targets are bound as the t0 and the t5 if the resolution is NOT full), and the padding replicates the border
+float4 SSS_Blur_MaskPyramidBase_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
+{
+	int2 texel = min(int2(position.xy), int2(SSS_PIXELS_PER_UV()) - int2(1, 1));
+	float subsurface_mask = g_albedo_texture.Load(int3(texel, 0)).a;
+	int profile_index = subsurface_scattering_profile_index_from_stencil(g_stencil_texture.Load(int3(texel, 0)).g);
+	return subsurface_scattering_mask_pyramid_base(subsurface_mask, profile_index);
+}
+
+// At the resolution of the level of the mask pyramid (no stencil buffer and no blending)
+float4 SSS_Blur_MaskPyramidReduce_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
+{
+	int2 texel = int2(position.xy) * 2;
+	float4 texel_00 = g_mask_pyramid_previous_level_texture.Load(int3(texel, 0));
+	float4 texel_10 = g_mask_pyramid_previous_level_texture.Load(int3(texel + int2(1, 0), 0));
+	float4 texel_01 = g_mask_pyramid_previous_level_texture.Load(int3(texel + int2(0, 1), 0));
+	float4 texel_11 = g_mask_pyramid_previous_level_texture.Load(int3(texel + int2(1, 1), 0));
+	return subsurface_scattering_mask_pyramid_reduce(texel_00, texel_10, texel_01, texel_11);
+}
+
+struct SSS_Blur_IrradiancePyramid_Output
+{
+	float4 irradiance : SV_TARGET0;
+	float view_space_position_z : SV_TARGET1;
+};
+
+// At the padded resolution of the level 0 of the irradiance pyramid (no stencil buffer and no blending)
+// NOTE: the irradiance pyramid runs at the resolution of the blur (the low resolution render targets are bound as the t0, the t1, the t2 and the t5 if the resolution is NOT full), and the padding replicates the border
+SSS_Blur_IrradiancePyramid_Output SSS_Blur_IrradiancePyramidBase_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0)
+{
+	int2 texel = min(int2(position.xy), int2(SSS_PIXELS_PER_UV()) - int2(1, 1));
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor = SSS_BLUR_IRRADIANCE_LOAD(blurIrradianceEncoding, texel);
+	float subsurface_mask = g_albedo_texture.Load(int3(texel, 0)).a;
+	int profile_index = subsurface_scattering_profile_index_from_stencil(g_stencil_texture.Load(int3(texel, 0)).g);
+	float view_space_position_z = depth_to_viewpositionz(blurDepthEncoding, depthTex.Load(int3(texel, 0)).r, currProj);
+
+	subsurface_scattering_irradiance_pyramid_texel pyramid_texel = subsurface_scattering_irradiance_pyramid_base(total_diffuse_reflectance_pre_scatter_multiply_form_factor, subsurface_mask, profile_index, view_space_position_z);
+
+	SSS_Blur_IrradiancePyramid_Output output;
+	output.irradiance = pyramid_texel.irradiance;
+	output.view_space_position_z = pyramid_texel.view_space_position_z;
+	return output;
+}
+
+// At the resolution of the level of the irradiance pyramid (no stencil buffer and no blending)
+SSS_Blur_IrradiancePyramid_Output SSS_Blur_IrradiancePyramidReduce_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0)
+{
+	// The level is NOT in the constant buffer: each texel of the level "level - 1" covers exactly 2^(level - 1) pixels of the padded level 0
+	int level_count = irradiancePyramidLevelCount;
+	int max_texel_size = 1 << (level_count - 1);
+	int padded_width = ((int(SSS_PIXELS_PER_UV().x) + max_texel_size - 1) / max_texel_size) * max_texel_size;
+	uint previous_width;
+	uint previous_height;
+	g_irradiance_pyramid_previous_level_texture.GetDimensions(previous_width, previous_height);
+	int level = firstbithigh(uint(padded_width) / previous_width) + 1;
+
+	int2 texel = int2(position.xy) * 2;
+	subsurface_scattering_irradiance_pyramid_texel children[4];
+	[unroll]
+	for (int child_index = 0; child_index < 4; ++child_index)
+	{
+		int2 child_texel = texel + int2(child_index & 1, child_index >> 1);
+		children[child_index].irradiance = g_irradiance_pyramid_previous_level_texture.Load(int3(child_texel, 0));
+		children[child_index].view_space_position_z = g_irradiance_pyramid_previous_level_view_space_position_z_texture.Load(int3(child_texel, 0));
+	}
+
+	subsurface_scattering_irradiance_pyramid_texel pyramid_texel = subsurface_scattering_irradiance_pyramid_reduce(children, level);
+
+	SSS_Blur_IrradiancePyramid_Output output;
+	output.irradiance = pyramid_texel.irradiance;
+	output.view_space_position_z = pyramid_texel.view_space_position_z;
+	return output;
+}
+
+// One instance (triangle strip of 4 vertices without the vertex buffer) per tile, of which the quad is degenerate (and culled) if the class of the tile does NOT match
+inline void SSS_BLUR_TILE_VERTEX(uint tile_class, uint vertex_id, uint instance_id, out float4 svposition, out float2 texcoord, out uint2 profile_index_margin)
+{
+	uint tile_count_x;
+	uint tile_count_y;
+	g_tile_class_texture.GetDimensions(tile_count_x, tile_count_y);
+	int2 tile = int2(instance_id % tile_count_x, instance_id / tile_count_x);
+	uint4 classification = g_tile_class_texture.Load(int3(tile, 0));
+
+	// The same winding as the "Quad": (0, 1), (0, 0), (1, 1), (1, 0)
+	int2 screen_size = SSS_TILE_SCREEN_SIZE();
+	int2 corner = int2(vertex_id >> 1, 1 - (vertex_id & 1));
+	texcoord = float2(min((tile + corner) * int(SSS_TILE_SIZE), screen_size)) / float2(screen_size);
+	svposition = (tile_class == classification.x) ? float4(uv_to_ndcxy(texcoord), 1.0, 1.0) : float4(0.0, 0.0, 0.0, 1.0);
+	profile_index_margin = classification.yz;
+}
+
+void SSS_Blur_TileInterior_VS(uint vertex_id : SV_VERTEXID, uint instance_id : SV_INSTANCEID, out float4 svposition : SV_POSITION, out float2 texcoord : TEXCOORD0, out nointerpolation uint2 profile_index_margin : TEXCOORD1)
+{
+	SSS_BLUR_TILE_VERTEX(SSS_TILE_CLASS_INTERIOR, vertex_id, instance_id, svposition, texcoord, profile_index_margin);
+}
+
+// NOTE: drawn with the "SSS_Blur_PS" which ignores the "profile_index_margin"
+void SSS_Blur_TileEdge_VS(uint vertex_id : SV_VERTEXID, uint instance_id : SV_INSTANCEID, out float4 svposition : SV_POSITION, out float2 texcoord : TEXCOORD0, out nointerpolation uint2 profile_index_margin : TEXCOORD1)
+{
+	SSS_BLUR_TILE_VERTEX(SSS_TILE_CLASS_EDGE, vertex_id, instance_id, svposition, texcoord, profile_index_margin);
+}
+
+// The INTERIOR tiles: the profile index is from the tile (instead of the stencil), and the samples within the edge free radius skip the subsurface mask and the profile index
+float4 SSS_Blur_Interior_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0, nointerpolation uint2 profile_index_margin : TEXCOORD1) : SV_TARGET
+{
+	subsurface_scattering_profile profile = subsurface_scattering_profile_load(g_profiles, int(profile_index_margin.x));
+	float edge_free_radius_in_pixels = subsurface_scattering_tile_edge_free_radius(int2(position.xy), profile_index_margin.y);
+	float3 color = subsurface_scattering_disney_blur_interior(profile.scattering_distance, profile.filter_radius, profile.world_scale, pixelsPerSample, SSS_BLUR_SAMPLE_BUDGET(texcoord), misMode, edge_free_radius_in_pixels, texcoord);
 	return float4(color, 1.0);
 }
+
+// Into the slice of the atlas of the head (no blending, the viewport of the atlas): (the diffused irradiance, coverage), s.t. the "RenderPS" samples the atlas instead of the lighting
+float4 SSS_Blur_TextureSpace_PS(float4 position: SV_POSITION, float2 texcoord : TEXCOORD0) : SV_TARGET
+{
+	subsurface_scattering_profile profile = subsurface_scattering_profile_load(g_profiles, textureSpaceProfileIndex);
+	int2 texel = int2(position.xy);
+	float3 color = subsurface_scattering_texture_space_diffuse(profile.scattering_distance, profile.world_scale, textureSpaceSampleCount, texel);
+	float coverage = (SSS_TEXTURE_SPACE_POSITION_SOURCE(texel).w > 0.0) ? 1.0 : 0.0;
+	return float4(color, coverage);
+}
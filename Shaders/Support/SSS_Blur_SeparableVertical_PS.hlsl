@@ -0,0 +1,2 @@
+#define SSS_BLUR_SEPARABLE_VERTICAL 1
+#include "SSS_Blur.hlsli"
\ No newline at end of file
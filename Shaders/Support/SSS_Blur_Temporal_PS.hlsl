@@ -0,0 +1 @@
+#include "SSS_Blur.hlsli"
\ No newline at end of file
@@ -45,3 +45,9 @@ float4 ShadowMapVS(float4 position : POSITION0) : SV_POSITION
     float4 pos = mul(position, worldViewProjection);
     return pos;
 }
+
+// The view space position z of the light (SV_POSITION.w) of the linear shadow map
+float ShadowMapPS(float4 position : SV_POSITION) : SV_TARGET
+{
+    return position.w;
+}
@@ -0,0 +1 @@
+#include "ShadowMap.hlsli"
\ No newline at end of file
@@ -0,0 +1,77 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The normalized inverse CDF "x = diffusion_profile_sample_r(1, cdf)" tabulated uniformly in [0, SSS_INVERSE_CDF_LUT_MAX_CDF] and "r = x * d".
+// Each texel stores (x, h * dx/dcdf) where h is the spacing of the table. The table is built on the CPU (see "Code/CPU/diffusion_profile_inverse_cdf_lut.h").
+// The analytic version is used beyond the "SSS_INVERSE_CDF_LUT_MAX_CDF" where "dx/dcdf" diverges.
+//
+// NOTE: "Load" rather than "SampleLevel" since the hardware bilinear filter only has 8 bits of fraction.
+//
+
+#ifndef _DIFFUSION_PROFILE_INVERSE_CDF_LUT_HLSLI_
+#define _DIFFUSION_PROFILE_INVERSE_CDF_LUT_HLSLI_ 1
+
+#define SSS_INVERSE_CDF_MODE_ANALYTIC 0
+#define SSS_INVERSE_CDF_MODE_LUT_LINEAR 1
+#define SSS_INVERSE_CDF_MODE_LUT_HERMITE 2
+
+#define SSS_INVERSE_CDF_LUT_MAX_CDF 0.99
+
+float diffusion_profile_sample_r(float d, float cdf);
+
+float diffusion_profile_sample_r_lut(Texture1D<float2> lut, int mode, float d, float cdf)
+{
+	[branch]
+	if ((SSS_INVERSE_CDF_MODE_ANALYTIC == mode) || !(cdf < SSS_INVERSE_CDF_LUT_MAX_CDF))
+	{
+		return diffusion_profile_sample_r(d, cdf);
+	}
+
+	uint lut_size;
+	lut.GetDimensions(lut_size);
+
+	float t = max(cdf, 0.0) * (float(lut_size - 1) / SSS_INVERSE_CDF_LUT_MAX_CDF);
+	int index = min(int(t), int(lut_size) - 2);
+	float f = t - float(index);
+
+	float2 p0 = lut.Load(int2(index, 0));
+	float2 p1 = lut.Load(int2(index + 1, 0));
+
+	float x;
+	[branch]
+	if (SSS_INVERSE_CDF_MODE_LUT_HERMITE == mode)
+	{
+		// Cubic Hermite spline
+		float f2 = f * f;
+		float f3 = f2 * f;
+		float h00 = 2.0 * f3 - 3.0 * f2 + 1.0;
+		float h10 = f3 - 2.0 * f2 + f;
+		float h01 = 3.0 * f2 - 2.0 * f3;
+		float h11 = f3 - f2;
+		x = h00 * p0.x + h10 * p0.y + h01 * p1.x + h11 * p1.y;
+	}
+	else
+	{
+		x = lerp(p0.x, p1.x, f);
+	}
+
+	// r = x * rcpS = x * d
+	float r = x * d;
+	return r;
+}
+
+#endif
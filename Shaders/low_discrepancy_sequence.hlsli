@@ -18,6 +18,16 @@
 #ifndef _LOW_DISCREPANCY_HLSLI_
 #define _LOW_DISCREPANCY_HLSLI_ 1
 
+// The sequence ID of the "low_discrepancy_sequence_2d"
+#define LOW_DISCREPANCY_SEQUENCE_HAMMERSLEY 0
+#define LOW_DISCREPANCY_SEQUENCE_FIBONACCI 1
+#define LOW_DISCREPANCY_SEQUENCE_R2 2
+#define LOW_DISCREPANCY_SEQUENCE_SOBOL_OWEN 3
+#define LOW_DISCREPANCY_SEQUENCE_BLUE_NOISE 4
+#define LOW_DISCREPANCY_SEQUENCE_COUNT 5
+
+#define LOW_DISCREPANCY_BLUE_NOISE_POINT_COUNT 80
+
 float2 hammersley_2d(uint sample_index, uint sample_count)
 {
     // "7.4.1 Hammersley and Halton Sequences" of PBR Book
@@ -33,8 +43,125 @@ float2 hammersley_2d(uint sample_index, uint sample_count)
 float2 fibonacci_2d(uint sample_index, uint sample_count)
 {
     // https://en.wikipedia.org/wiki/Golden_ratio#Relationship_to_Fibonacci_sequence
-    // TODO
-    return float2(0.7, 0.7);
+    // U3D: [Fibonacci2d](https://github.com/Unity-Technologies/Graphics/blob/v10.8.0/com.unity.render-pipelines.core/ShaderLibrary/Sampling/Fibonacci.hlsl#L16)
+    // NOTE: the fraction is evaluated in 32-bit fixed point, s.t. the precision does NOT decrease with the index (and only 24 bits are kept, s.t. the value is NOT rounded up to 1.0)
+    // 2654435769 = round(2^32 / golden_ratio)
+
+    float xi_1 = (float(sample_index) + 0.5) / float(sample_count);
+    float xi_2 = float((sample_index * 2654435769u) >> 8u) * (1.0 / 16777216.0);
+
+    return float2(xi_1, xi_2);
+}
+
+float2 r2_2d(uint sample_index)
+{
+    // [Martin Roberts. "The Unreasonable Effectiveness of Quasirandom Sequences." 2018.](http://extremelearning.com.au/unreasonable-effectiveness-of-quasirandom-sequences/)
+    // The Kronecker sequence of the plastic number: frac(0.5 + n * (1 / g, 1 / g^2)) where g^3 = g + 1
+    // NOTE: the fraction is evaluated in 32-bit fixed point, s.t. the precision does NOT decrease with the index (and only 24 bits are kept, s.t. the value is NOT rounded up to 1.0)
+    // 3242174889 = round(2^32 / g), 2447445414 = round(2^32 / g^2)
+
+    float xi_1 = float((2147483648u + sample_index * 3242174889u) >> 8u) * (1.0 / 16777216.0);
+    float xi_2 = float((2147483648u + sample_index * 2447445414u) >> 8u) * (1.0 / 16777216.0);
+
+    return float2(xi_1, xi_2);
+}
+
+uint laine_karras_permutation(uint value, uint seed)
+{
+    value += seed;
+    value ^= value * 0x6c50b47cu;
+    value ^= value * 0xb82f1e52u;
+    value ^= value * 0xc7afe638u;
+    value ^= value * 0x8d22f6e6u;
+    return value;
+}
+
+uint nested_uniform_scramble(uint value, uint seed)
+{
+    value = reversebits(value);
+    value = laine_karras_permutation(value, seed);
+    value = reversebits(value);
+    return value;
+}
+
+float2 sobol_owen_2d(uint sample_index)
+{
+    // [Brent Burley. "Practical Hash-based Owen Scrambling." JCGT 2020.](https://jcgt.org/published/0009/04/01/)
+    // The first dimension of the Sobol sequence is the van der Corput sequence, and the second dimension is generated by the direction numbers "v ^= v >> 1".
+    // NOTE: the seeds are constant, s.t. all pixels share the same kernel (as the other sequences)
+
+    uint sobol_1 = reversebits(sample_index);
+
+    uint sobol_2 = 0u;
+    uint v = (1u << 31u);
+    for (uint index = sample_index; 0u != index; index >>= 1u)
+    {
+        sobol_2 ^= (0u != (index & 1u)) ? v : 0u;
+        v ^= (v >> 1u);
+    }
+
+    float xi_1 = float(nested_uniform_scramble(sobol_1, 0x8a3c1f5du) >> 8u) * (1.0 / 16777216.0);
+    float xi_2 = float(nested_uniform_scramble(sobol_2, 0x2d7b94e1u) >> 8u) * (1.0 / 16777216.0);
+
+    return float2(xi_1, xi_2);
+}
+
+// Progressive: each prefix of the point set is well distributed, s.t. the same table is used by all sample counts.
+// Generated by the best-candidate algorithm ([Don P. Mitchell. "Spectrally Optimal Sampling for Distribution Ray Tracing." SIGGRAPH 1991.](https://doi.org/10.1145/127719.122736)) with the toroidal distance and "64 * n" candidates for the n-th point.
+static const float2 blue_noise_points[LOW_DISCREPANCY_BLUE_NOISE_POINT_COUNT] = {
+    float2(0.316593528, 0.875706971), float2(0.817218959, 0.3137182), float2(0.822947919, 0.802365541), float2(0.342273951, 0.371989548),
+    float2(0.595685005, 0.0506322384), float2(0.0961852074, 0.603780866), float2(0.0498498678, 0.0750439167), float2(0.539352596, 0.646940053),
+    float2(0.306465864, 0.126363099), float2(0.0918661356, 0.361384511), float2(0.787325621, 0.556313872), float2(0.567756593, 0.283088028),
+    float2(0.0734766126, 0.840498626), float2(0.826614439, 0.0160238147), float2(0.302418232, 0.670116961), float2(0.56125021, 0.847314358),
+    float2(0.504846096, 0.464828014), float2(0.946943641, 0.470285773), float2(0.929069698, 0.659519851), float2(0.721409976, 0.164765298),
+    float2(0.2259022, 0.495536029), float2(0.976373792, 0.232816517), float2(0.431023896, 0.00321787596), float2(0.161880732, 0.204300046),
+    float2(0.668345273, 0.418143094), float2(0.170081794, 0.974454939), float2(0.676164865, 0.723665655), float2(0.699617267, 0.921276629),
+    float2(0.452175558, 0.173803926), float2(0.425682068, 0.754073501), float2(0.952157795, 0.935139775), float2(0.391880631, 0.552791238),
+    float2(0.202516675, 0.775443137), float2(0.653716624, 0.580811262), float2(0.86144489, 0.146281838), float2(0.21612525, 0.32406944),
+    float2(0.95033437, 0.805364907), float2(0.803607702, 0.677660525), float2(0.328872442, 0.248517156), float2(0.690906644, 0.285241425),
+    float2(0.788718045, 0.432384729), float2(0.463349283, 0.347987056), float2(0.0398060679, 0.714587033), float2(0.304088831, 0.99651438),
+    float2(0.973040164, 0.352427304), float2(0.0656459928, 0.483788192), float2(0.592908323, 0.170165956), float2(0.189796329, 0.092457056),
+    float2(0.442565024, 0.884504497), float2(0.937532961, 0.0674037933), float2(0.715333343, 0.04488796), float2(0.532927692, 0.956406713),
+    float2(0.059963882, 0.947440028), float2(0.194077671, 0.667699814), float2(0.852311492, 0.906021833), float2(0.996446311, 0.572817981),
+    float2(0.528380096, 0.748998344), float2(0.204159319, 0.877558947), float2(0.432951629, 0.644975245), float2(0.719850063, 0.814739585),
+    float2(0.0748169422, 0.260206878), float2(0.50215596, 0.0859385729), float2(0.330029368, 0.47127378), float2(0.895237029, 0.560952902),
+    float2(0.308143675, 0.776929915), float2(0.600159883, 0.498013318), float2(0.87864399, 0.393426776), float2(0.57007134, 0.385055184),
+    float2(0.492569208, 0.559461057), float2(0.881554961, 0.240994632), float2(0.285381794, 0.572780252), float2(0.0696194172, 0.164699078),
+    float2(0.160309374, 0.425316989), float2(0.418369949, 0.427490175), float2(0.255158424, 0.407330394), float2(0.39786762, 0.0928955674),
+    float2(0.708789766, 0.504694998), float2(0.420944929, 0.258045912), float2(0.88877058, 0.739498973), float2(0.721273899, 0.640360713)
+};
+
+float2 blue_noise_2d(uint sample_index)
+{
+    // NOTE: the indices beyond the table fall back to the R2 sequence
+    return (sample_index < LOW_DISCREPANCY_BLUE_NOISE_POINT_COUNT) ? blue_noise_points[sample_index] : r2_2d(sample_index);
+}
+
+float2 low_discrepancy_sequence_2d(int sequence, uint sample_index, uint sample_count)
+{
+    float2 xi;
+    [branch]
+    if (LOW_DISCREPANCY_SEQUENCE_FIBONACCI == sequence)
+    {
+        xi = fibonacci_2d(sample_index, sample_count);
+    }
+    else if (LOW_DISCREPANCY_SEQUENCE_R2 == sequence)
+    {
+        xi = r2_2d(sample_index);
+    }
+    else if (LOW_DISCREPANCY_SEQUENCE_SOBOL_OWEN == sequence)
+    {
+        xi = sobol_owen_2d(sample_index);
+    }
+    else if (LOW_DISCREPANCY_SEQUENCE_BLUE_NOISE == sequence)
+    {
+        xi = blue_noise_2d(sample_index);
+    }
+    else
+    {
+        xi = hammersley_2d(sample_index, sample_count);
+    }
+    return xi;
 }
 
 #endif
\ No newline at end of file
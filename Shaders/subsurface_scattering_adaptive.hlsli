@@ -0,0 +1,62 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The variance-driven adaptive sampling of the blur under a global budget of the samples of the frame.
+//
+// 1. The pilot pass blurs every pixel with at most SSS_ADAPTIVE_PILOT_SAMPLE_COUNT samples, and estimates the "standard_error" (see "subsurface_scattering_disney_blur_estimate").
+// 2. The rest of the "samples_per_frame" (after the samples of the pilot pass) is spread across the pixels in proportion to the estimated error of each pixel, namely, the "deviation" (the standard deviation of one sample).
+// 3. The refinement pass blurs the pixel again with the allocated samples, which replace the pilot estimate.
+//
+// The flat and evenly lit pixels have almost zero error, s.t. the budget is spent on the shadow edges and the silhouettes.
+// However, the few pilot samples may miss the edge in the tail of the kernel, which is found by the neighbors, s.t. the mean deviation of the block of 2^SSS_ADAPTIVE_DEVIATION_MIP_LEVEL pixels (the mip of the "GenerateMips") is used rather than the deviation of each pixel.
+// And the pixels which are allocated more than the "sample_budget" waste the budget, s.t. SSS_ADAPTIVE_UNIFORM_FRACTION of the rest is spread evenly.
+//
+// NOTE: the pilot set and the refinement set (of another sample count) are NOT stratified with each other, and combining the two estimates by the sample counts was worse than the uniform sampling of the same budget.
+// The "sample_budget" (namely, "setNSamples") is still the maximum sample count of one pixel, and the projected area of the kernel still limits the sample count.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_ADAPTIVE_HLSLI_
+#define _SUBSURFACE_SCATTERING_ADAPTIVE_HLSLI_ 1
+
+#include "math_consts.hlsli"
+
+#define SSS_ADAPTIVE_PILOT_SAMPLE_COUNT 8
+#define SSS_ADAPTIVE_UNIFORM_FRACTION 0.25
+#define SSS_ADAPTIVE_DEVIATION_MIP_LEVEL 4
+
+// The standard deviation of one sample, of which the sum over the pixels is the denominator of the allocation
+float subsurface_scattering_adaptive_deviation(float standard_error, int sample_count)
+{
+	return standard_error * sqrt(float(sample_count));
+}
+
+// The "covered_pixel_count" is the number of the pixels of which the "pilot_sample_count" is NOT zero, and the sums are over all pixels of the pilot pass
+float subsurface_scattering_adaptive_refinement_samples_per_pixel(float samples_per_frame, float covered_pixel_count, float sum_pilot_sample_count)
+{
+	return max(samples_per_frame - sum_pilot_sample_count, 0.0) / max(covered_pixel_count, 1.0);
+}
+
+// The "uniform_sample_count" (SSS_ADAPTIVE_UNIFORM_FRACTION of the "refinement_samples_per_pixel") is allocated to every covered pixel, and the rest is in proportion to the "deviation" by the "deviation_scale"
+// The "deviation_scale" is "(1 - SSS_ADAPTIVE_UNIFORM_FRACTION) * refinement_samples_per_pixel / mean_deviation" (over the covered pixels), s.t. the budget is exact unless the pixels reach the "sample_budget"
+// The pixel is NOT refined (0 is returned and the pilot is kept) unless the refinement takes more samples than the "pilot_sample_count"
+int subsurface_scattering_adaptive_refinement_sample_count(float deviation, float deviation_scale, float uniform_sample_count, int pilot_sample_count, int sample_budget)
+{
+	int sample_count = int(clamp(uniform_sample_count + deviation_scale * deviation + 0.5, 0.0, float(max(sample_budget, 0))));
+	return (sample_count > pilot_sample_count) ? sample_count : 0;
+}
+
+#endif
@@ -31,10 +31,23 @@
 
 #include "math_consts.hlsli"
 #include "low_discrepancy_sequence.hlsli"
+#include "subsurface_scattering_mask_pyramid.hlsli"
+#include "subsurface_scattering_irradiance_pyramid.hlsli"
 
 #define SSS_MIN_PIXELS_PER_SAMPLE 4
 #define SSS_MAX_SAMPLE_BUDGET 80
 
+// SSS_SAMPLE_ROTATION_SOURCE() returns (cos(theta), sin(theta)), by which the whole sample pattern is rotated, s.t. the temporal accumulation (see "subsurface_scattering_temporal.hlsli") converges to more samples than the budget of one frame
+
+// SSS_MIS_MODE_NONE: all samples are drawn from the profile of the widest channel
+// SSS_MIS_MODE_BALANCE / SSS_MIS_MODE_POWER: the budget is split across the profiles of the three channels (in proportion to the area of the filter of each channel), and the samples are combined by the balance / power (beta = 2) heuristic
+#define SSS_MIS_MODE_NONE 0
+#define SSS_MIS_MODE_BALANCE 1
+#define SSS_MIS_MODE_POWER 2
+
+// The pixels which take fewer samples fall back to SSS_MIS_MODE_NONE, since the budget split across the three strategies leaves too few samples to each of them to be stratified (the MIS is noisier than the widest channel below 32 samples, see "benchmarkMisVariance")
+#define SSS_MIS_MIN_SAMPLE_COUNT 32
+
 // https://zero-radiance.github.io/post/sampling-diffusion/
 // S = ShapeParam = 1 / ScatteringDistance = 1 / d
 // d = ScatteringDistance = 1 / ShapeParam = 1 / S
@@ -46,8 +59,46 @@ float diffusion_profile_evaluate_cdf(float d, float r);
 float diffusion_profile_evaluate_rcp_pdf(float d, float r);
 float3 diffusion_profile_evaluate_pdf(float3 S, float r);
 
-float3 subsurface_scattering_disney_blur(const float3 scattering_distance, const float world_scale, const int pixels_per_sample, const int sample_budget, const float2 center_uv)
+// (offset_in_mm.x, offset_in_mm.y, r, rcp_pdf)
+// The "SSS_KERNEL_SAMPLE_SOURCE" may either call this function or fetch the same value from the kernel cache (see "subsurface_scattering_kernel_cache.hlsli").
+// The "SSS_SAMPLE_SEQUENCE_SOURCE" returns the point of the "low_discrepancy_sequence_2d" (see "low_discrepancy_sequence.hlsli"), of which x is mapped to the radius and y to the angle.
+float4 subsurface_scattering_disney_kernel_sample(float d, float center_sample_cdf, int sample_count, int sample_index)
 {
+	// NOTE: Hammersley by default, or the other sequence selected by the user
+	float2 xi = SSS_SAMPLE_SEQUENCE_SOURCE(sample_count, sample_index);
+
+	// Center Sample Reweighting
+	xi.x = lerp(center_sample_cdf, 1.0, xi.x);
+
+	// Sampling Diffusion Profile
+	// NOTE: the analytic version or the inverse CDF LUT (see "diffusion_profile_inverse_cdf_lut.hlsli")
+	float r = SSS_DIFFUSION_PROFILE_SAMPLE_R_SOURCE(d, xi.x);
+	float theta = 2.0 * float(PI) * xi.y;
+
+	float rcp_pdf = diffusion_profile_evaluate_rcp_pdf(d, r);
+
+	return float4(float2(cos(theta), sin(theta)) * r, r, rcp_pdf);
+}
+
+struct subsurface_scattering_disney_blur_result
+{
+	float3 radiance;
+	// The standard error of the luminance of the "radiance", estimated from the samples themselves.
+	// The blur is the ratio estimator N / D (the "sum_numerator" and the "sum_denominator"), of which the variance is approximated by the delta method: Var[N / D] = (n / (n - 1)) * Sum{(N_i - (N / D) * D_i)^2} / D^2.
+	// NOTE: the samples are NOT independent (low discrepancy sequence, MIS), s.t. this is only a relative measure of the noise of the pixel (see "subsurface_scattering_adaptive.hlsli").
+	float standard_error;
+	int sample_count;
+	// The samples rejected by the subsurface mask or the profile index, and those of them which were rejected only after the fetch of the full resolution (namely, NOT decided by the mask pyramid)
+	int rejected_sample_count;
+	int wasted_sample_count;
+};
+
+// The "edge_free_radius_in_pixels" is the radius (around the center) within which all pixels are known to belong to the profile of the center (see "subsurface_scattering_tile_classification.hlsli"), s.t. the samples within it skip the subsurface mask and the profile index.
+// NOTE: the result is exactly the same as the "subsurface_scattering_disney_blur_estimate", of which the "edge_free_radius_in_pixels" is zero.
+subsurface_scattering_disney_blur_result subsurface_scattering_disney_blur_estimate_interior(const float3 scattering_distance, const float filter_radius, const float world_scale, const int pixels_per_sample, const int sample_budget, const int mis_mode, const float edge_free_radius_in_pixels, const float2 center_uv)
+{
+	subsurface_scattering_disney_blur_result result;
+
 	const float dist_scale = SSS_SUBSURFACE_MASK_SOURCE(center_uv);
 	// Early Out
 	[branch]
@@ -57,8 +108,12 @@ float3 subsurface_scattering_disney_blur(const float3 scattering_distance, const
 
 		float3 total_diffuse_reflectance_post_scatter = SSS_TOTAL_DIFFUSE_REFLECTANCE_POST_SCATTER_SOURCE(center_uv);
 		
-		float3 radiance = total_diffuse_reflectance_post_scatter * total_diffuse_reflectance_pre_scatter_multiply_form_factor;
-		return radiance;
+		result.radiance = total_diffuse_reflectance_post_scatter * total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+		result.standard_error = 0.0;
+		result.sample_count = 0;
+		result.rejected_sample_count = 0;
+		result.wasted_sample_count = 0;
+		return result;
 	}
 
 	// In UE4, the "dist_scale" is applied to the "scattering_distance" rather than the "uv_per_mm".  
@@ -102,47 +157,136 @@ float3 subsurface_scattering_disney_blur(const float3 scattering_distance, const
 	// With the center sample is scaled the weight T and the rest of the samples are weighted
 	// by (1-T). There shouldn't be any bias, except for small errors due to precision.
 	const float center_sample_radius_in_mm = 0.5 * (1.0 / pixels_per_mm.x + 1.0 / pixels_per_mm.y);
-	const float center_sample_cdf = diffusion_profile_evaluate_cdf(d, center_sample_radius_in_mm);
+	//
+	// NOTE: the kernel cache quantizes the "center_sample_cdf"
+	const float center_sample_cdf = SSS_CENTER_SAMPLE_CDF_SOURCE(diffusion_profile_evaluate_cdf(d, center_sample_radius_in_mm));
 
-	float3 sum_numerator = float3(0.0, 0.0, 0.0);
-	float3 sum_denominator = float3(0.0, 0.0, 0.0);
+	const int profile_index = SSS_SUBSURFACE_PROFILE_INDEX_SOURCE(center_uv);
+
+	// The mask pyramid may prove that the whole filter belongs to the profile of the center (see "subsurface_scattering_mask_pyramid.hlsli")
+	const float sample_edge_free_radius_in_pixels = max(edge_free_radius_in_pixels, subsurface_scattering_mask_pyramid_edge_free_radius(center_uv, profile_index, filter_radius * max(pixels_per_mm.x, pixels_per_mm.y)));
 
 	// Filter radius is, strictly speaking, infinite.
 	// The magnitude of the function decays exponentially, but it is never truly zero.
 	// To estimate the radius, we can use adapt the "three-sigma rule" by defining
 	// the radius of the kernel by the value of the CDF which corresponds to 99.7%
 	// of the energy of the filter.
-	const float filter_radius = diffusion_profile_sample_r(d, 0.997);
-	float sample_count = int(float(PI) * (filter_radius * pixels_per_mm.x) * (filter_radius * pixels_per_mm.y) * (1.0 / float(max(pixels_per_sample, int(SSS_MIN_PIXELS_PER_SAMPLE)))));
-	sample_count = min(sample_count, min(sample_budget, int(SSS_MAX_SAMPLE_BUDGET)));
+	// NOTE: the "filter_radius" (of the widest channel) is precomputed per profile (see "subsurface_scattering_profile.hlsli"), and the radius of each channel is proportional to the scattering distance
+	const float rcp_pixels_per_sample = 1.0 / float(max(pixels_per_sample, int(SSS_MIN_PIXELS_PER_SAMPLE)));
+	const int max_sample_count = min(sample_budget, int(SSS_MAX_SAMPLE_BUDGET));
+
+	// Multiple Importance Sampling
+	// The samples [0, N0) are drawn from the profile of which the scattering distance is "strategy_d[0]", the samples [N0, N0 + N1) from "strategy_d[1]" and the rest from "strategy_d[2]".
+	// Without MIS, all samples are drawn from the widest channel.
+	float3 strategy_d;
+	float3 strategy_center_sample_cdf;
+	int3 strategy_sample_count;
+	float sample_count_unclamped = float(PI) * (filter_radius * pixels_per_mm.x) * (filter_radius * pixels_per_mm.y) * rcp_pixels_per_sample;
+	const int strategy_mis_mode = (min(int(sample_count_unclamped), max_sample_count) >= SSS_MIS_MIN_SAMPLE_COUNT) ? mis_mode : SSS_MIS_MODE_NONE;
+	[branch]
+	if (SSS_MIS_MODE_NONE == strategy_mis_mode)
+	{
+		strategy_d = float3(d, d, d);
+		strategy_center_sample_cdf = float3(center_sample_cdf, center_sample_cdf, center_sample_cdf);
+		strategy_sample_count = int3(min(int(sample_count_unclamped), max_sample_count), 0, 0);
+	}
+	else
+	{
+		strategy_d = scattering_distance;
+		strategy_center_sample_cdf = float3(
+			SSS_CENTER_SAMPLE_CDF_SOURCE(diffusion_profile_evaluate_cdf(strategy_d.x, center_sample_radius_in_mm)),
+			SSS_CENTER_SAMPLE_CDF_SOURCE(diffusion_profile_evaluate_cdf(strategy_d.y, center_sample_radius_in_mm)),
+			SSS_CENTER_SAMPLE_CDF_SOURCE(diffusion_profile_evaluate_cdf(strategy_d.z, center_sample_radius_in_mm)));
+
+		float3 channel_filter_radius = filter_radius * (strategy_d / d);
+		float3 strategy_sample_count_unclamped = float(PI) * (channel_filter_radius * pixels_per_mm.x) * (channel_filter_radius * pixels_per_mm.y) * rcp_pixels_per_sample;
+
+		// The budget is split in proportion to the area of the filter of each channel
+		float budget_scale = min(1.0, float(max_sample_count) / max(strategy_sample_count_unclamped.x + strategy_sample_count_unclamped.y + strategy_sample_count_unclamped.z, FLT_MIN));
+		strategy_sample_count = min(int3(strategy_sample_count_unclamped * budget_scale), int3(max_sample_count, max_sample_count, max_sample_count));
+	}
+
+	int sample_count = strategy_sample_count.x + strategy_sample_count.y + strategy_sample_count.z;
+
+	// The density of each strategy is truncated by the center sample (the samples are only drawn beyond the center sample radius): N_k * pdf_k(r) / (1 - center_sample_cdf_k)
+	float3 strategy_pdf_scale = float3(strategy_sample_count) / max(float3(1.0, 1.0, 1.0) - strategy_center_sample_cdf, float3(FLT_MIN, FLT_MIN, FLT_MIN));
+
+	float3 sum_numerator = float3(0.0, 0.0, 0.0);
+	float3 sum_denominator = float3(0.0, 0.0, 0.0);
+
+	// The second moments of the ratio estimator (only used by the "standard_error", s.t. they are eliminated by the compiler otherwise)
+	float3 sum_numerator_squared = float3(0.0, 0.0, 0.0);
+	float3 sum_numerator_denominator = float3(0.0, 0.0, 0.0);
+	float3 sum_denominator_squared = float3(0.0, 0.0, 0.0);
+
+	const float2 sample_rotation = SSS_SAMPLE_ROTATION_SOURCE();
+
+	int rejected_sample_count = 0;
+	int wasted_sample_count = 0;
 
 	[loop]
 	for (int sample_index = 0; sample_index < int(SSS_MAX_SAMPLE_BUDGET) && sample_index < sample_count; ++sample_index)
 	{
-		float2 xi = hammersley_2d(sample_index, sample_count);
+		int strategy = (sample_index < strategy_sample_count.x) ? 0 : ((sample_index < (strategy_sample_count.x + strategy_sample_count.y)) ? 1 : 2);
+		int strategy_sample_offset = (0 == strategy) ? 0 : ((1 == strategy) ? strategy_sample_count.x : (strategy_sample_count.x + strategy_sample_count.y));
 
-		// Center Sample Reweighting
-		xi.x = lerp(center_sample_cdf, 1.0, xi.x);
-
-		// Sampling Diffusion Profile
-		float r = diffusion_profile_sample_r(d, xi.x);
-		float theta = 2.0 * float(PI) * xi.y;
+		// (offset_in_mm.x, offset_in_mm.y, r, rcp_pdf)
+		float4 kernel_sample = SSS_KERNEL_SAMPLE_SOURCE(strategy_d[strategy], strategy_center_sample_cdf[strategy], strategy_sample_count[strategy], sample_index - strategy_sample_offset);
+		float r = kernel_sample.z;
+		float rcp_pdf = kernel_sample.w;
 
 		// Bilateral Filter
-		float2 sample_uv = center_uv + uv_per_mm * float2(cos(theta), sin(theta)) * r;
-
-		// The "sample_form_factor" may be zero even if the "sample_dist_scale" is NOT zero
-		float sample_dist_scale = SSS_SUBSURFACE_MASK_SOURCE(sample_uv);
+		float2 sample_offset_in_mm = float2(kernel_sample.x * sample_rotation.x - kernel_sample.y * sample_rotation.y, kernel_sample.x * sample_rotation.y + kernel_sample.y * sample_rotation.x);
+		float2 sample_uv = center_uv + uv_per_mm * sample_offset_in_mm;
 
+		// The samples which belong to another profile are rejected
+		// NOTE: the samples within the "sample_edge_free_radius_in_pixels" are known to belong to the profile of the center
+		bool sample_accepted = true;
 		[branch]
-		if (sample_dist_scale >= (1.0 / 255.0))
+		if (length(sample_offset_in_mm * pixels_per_mm) >= sample_edge_free_radius_in_pixels)
 		{
-			float3 sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor = SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE(sample_uv);
+			// Only the samples which are NOT decided by the mask pyramid fetch the full resolution
+			int mask_pyramid_sample_test = subsurface_scattering_mask_pyramid_sample_test(sample_uv, profile_index);
+			[branch]
+			if (SSS_MASK_PYRAMID_SAMPLE_UNKNOWN == mask_pyramid_sample_test)
+			{
+				// The "sample_form_factor" may be zero even if the "sample_dist_scale" is NOT zero
+				float sample_dist_scale = SSS_SUBSURFACE_MASK_SOURCE(sample_uv);
+				sample_accepted = (sample_dist_scale >= (1.0 / 255.0)) && (SSS_SUBSURFACE_PROFILE_INDEX_SOURCE(sample_uv) == profile_index);
+				wasted_sample_count += sample_accepted ? 0 : 1;
+			}
+			else
+			{
+				sample_accepted = (SSS_MASK_PYRAMID_SAMPLE_ACCEPTED == mask_pyramid_sample_test);
+			}
+			rejected_sample_count += sample_accepted ? 0 : 1;
+		}
 
-			float rcp_pdf = diffusion_profile_evaluate_rcp_pdf(d, r);
+		[branch]
+		if (sample_accepted)
+		{
+			// Without MIS, the weight is the "rcp_pdf". Otherwise, the weight is the MIS weight divided by the density of the strategy:
+			// balance: 1 / Sum{N_k * pdf_k}
+			// power: (N_j * pdf_j) / Sum{(N_k * pdf_k)^2}
+			// The footprint (in mm^2) is the share of the disk covered by the sample, namely, the reciprocal of the density of all samples (per mm^2): r / Sum{N_k * pdf_k}
+			float sample_weight = rcp_pdf;
+			float sample_footprint_in_mm2 = r * rcp_pdf / max(strategy_pdf_scale.x, FLT_MIN);
+			[branch]
+			if (SSS_MIS_MODE_NONE != strategy_mis_mode)
+			{
+				// NOTE: the densities of the three strategies are evaluated at once, since the scattering distance of each strategy is the scattering distance of the channel
+				float3 strategy_pdf = diffusion_profile_evaluate_pdf(S, r) * strategy_pdf_scale;
+				sample_weight = (SSS_MIS_MODE_BALANCE == strategy_mis_mode) ? (1.0 / max(strategy_pdf.x + strategy_pdf.y + strategy_pdf.z, FLT_MIN)) : (strategy_pdf[strategy] / max(dot(strategy_pdf, strategy_pdf), FLT_MIN));
+				sample_footprint_in_mm2 = r / max(strategy_pdf.x + strategy_pdf.y + strategy_pdf.z, FLT_MIN);
+			}
+
+			// Mipmapped Irradiance
+			// The level of the irradiance pyramid matches the footprint of the sample (the full resolution if the pyramid is disabled)
+			subsurface_scattering_irradiance_pyramid_sample_result sample_irradiance = subsurface_scattering_irradiance_pyramid_sample(sample_uv, profile_index, sample_footprint_in_mm2 * pixels_per_mm.x * pixels_per_mm.y);
+			float3 sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor = sample_irradiance.total_diffuse_reflectance_pre_scatter_multiply_form_factor;
 
 			// Bilateral Filter
-			float sample_view_space_position_z = SSS_VIEW_SPACE_POSITION_Z_SOURCE(sample_uv);
+			float sample_view_space_position_z = sample_irradiance.view_space_position_z;
 			float relative_position_z_mm = mms_per_unit * (sample_view_space_position_z - center_view_space_position_z);
 			float r_bilateral_weight = sqrt(r * r + relative_position_z_mm * relative_position_z_mm);
 
@@ -153,27 +297,66 @@ float3 subsurface_scattering_disney_blur(const float3 scattering_distance, const
 			// = (1.0 / float(N)) * total_diffuse_reflectance * pdf * form_factor * rcp_pdf
 			// = (1.0 / float(N)) * total_diffuse_reflectance_post_scatter * pdf * (total_diffuse_reflectance_pre_scatter * form_factor) * rcp_pdf
 			// the 'total_diffuse_reflectance_post_scatter' will be calculated later while the 'total_diffuse_reflectance_pre_scatter * form_factor' is calculated here 
-			float3 sample_numerator = pdf * sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor * rcp_pdf;
+			float3 sample_numerator = pdf * sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor * sample_weight;
 
 			// (1.0 / float(N)) * pdf * rcp_pdf
-			float3 sample_denominator = pdf * rcp_pdf;
+			float3 sample_denominator = pdf * sample_weight;
 
 			sum_numerator += sample_numerator;
 
 			// assumed to be N since the pdf is normalized and the common divisor '1.0 / float(N)' is reduced
 			sum_denominator += sample_denominator;
+
+			sum_numerator_squared += sample_numerator * sample_numerator;
+			sum_numerator_denominator += sample_numerator * sample_denominator;
+			sum_denominator_squared += sample_denominator * sample_denominator;
 		}
 	}
 
 	// Center Sample Reweighting
+	// NOTE: with MIS, the center sample weight of each channel is the CDF of the profile of the channel
 	float3 sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor = sum_numerator / max(sum_denominator, float3(FLT_MIN, FLT_MIN, FLT_MIN));
 	float3 center_total_diffuse_reflectance_pre_scatter_multiply_form_factor = SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE(center_uv);
-	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor = lerp(sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor, center_total_diffuse_reflectance_pre_scatter_multiply_form_factor, center_sample_cdf);
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor = lerp(sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor, center_total_diffuse_reflectance_pre_scatter_multiply_form_factor, strategy_center_sample_cdf);
 
 	float3 total_diffuse_reflectance_post_scatter = SSS_TOTAL_DIFFUSE_REFLECTANCE_POST_SCATTER_SOURCE(center_uv);
 	
-	float3 radiance = total_diffuse_reflectance_post_scatter * total_diffuse_reflectance_pre_scatter_multiply_form_factor;
-	return radiance;
+	result.radiance = total_diffuse_reflectance_post_scatter * total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+
+	// Var[N / D] = (n / (n - 1)) * Sum{(N_i - (N / D) * D_i)^2} / D^2
+	// The "radiance" is the "total_diffuse_reflectance_post_scatter * lerp(N / D, center, center_sample_cdf)"
+	[branch]
+	if (sample_count > 1)
+	{
+		float3 ratio = sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+		float3 sum_squared_residual = max(sum_numerator_squared - 2.0 * ratio * sum_numerator_denominator + ratio * ratio * sum_denominator_squared, float3(0.0, 0.0, 0.0));
+		float3 ratio_variance = (float(sample_count) / float(sample_count - 1)) * sum_squared_residual / max(sum_denominator * sum_denominator, float3(FLT_MIN, FLT_MIN, FLT_MIN));
+		float3 radiance_standard_error = total_diffuse_reflectance_post_scatter * (float3(1.0, 1.0, 1.0) - strategy_center_sample_cdf) * sqrt(ratio_variance);
+		result.standard_error = dot(radiance_standard_error, float3(0.2126, 0.7152, 0.0722));
+	}
+	else
+	{
+		result.standard_error = 0.0;
+	}
+	result.sample_count = sample_count;
+	result.rejected_sample_count = rejected_sample_count;
+	result.wasted_sample_count = wasted_sample_count;
+	return result;
+}
+
+subsurface_scattering_disney_blur_result subsurface_scattering_disney_blur_estimate(const float3 scattering_distance, const float filter_radius, const float world_scale, const int pixels_per_sample, const int sample_budget, const int mis_mode, const float2 center_uv)
+{
+	return subsurface_scattering_disney_blur_estimate_interior(scattering_distance, filter_radius, world_scale, pixels_per_sample, sample_budget, mis_mode, 0.0, center_uv);
+}
+
+float3 subsurface_scattering_disney_blur(const float3 scattering_distance, const float filter_radius, const float world_scale, const int pixels_per_sample, const int sample_budget, const int mis_mode, const float2 center_uv)
+{
+	return subsurface_scattering_disney_blur_estimate(scattering_distance, filter_radius, world_scale, pixels_per_sample, sample_budget, mis_mode, center_uv).radiance;
+}
+
+float3 subsurface_scattering_disney_blur_interior(const float3 scattering_distance, const float filter_radius, const float world_scale, const int pixels_per_sample, const int sample_budget, const int mis_mode, const float edge_free_radius_in_pixels, const float2 center_uv)
+{
+	return subsurface_scattering_disney_blur_estimate_interior(scattering_distance, filter_radius, world_scale, pixels_per_sample, sample_budget, mis_mode, edge_free_radius_in_pixels, center_uv).radiance;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,130 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The compact encodings of the inputs of the blur written by the main pass (see the "SSS_IRRADIANCE_ENCODING_*" and the "SSS_DEPTH_ENCODING_*").
+//
+// The conversions of the render target formats (the R16G16B16A16_FLOAT, the R11G11B10_FLOAT, the R16G16_FLOAT, the R16_UNORM and the R16_FLOAT) are done by the hardware, s.t. only the RGB9E5, the YCoCg and the linear depth are encoded by the shaders.
+// The view space position z (SV_POSITION.w) of the "SSS_DEPTH_ENCODING_VIEW_Z_*" is NOT encoded at all, s.t. the blur consumes the depth without the reconstruction from the NDC depth.
+// The RGB9E5 is packed into the R16G16_UNORM since the R9G9B9E5_SHAREDEXP can NOT be rendered, and the YCoCg stores the Co and the Cg in the checkerboard, s.t. the chroma is at the half horizontal resolution.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_GBUFFER_ENCODING_HLSLI_
+#define _SUBSURFACE_SCATTERING_GBUFFER_ENCODING_HLSLI_ 1
+
+#define SSS_IRRADIANCE_ENCODING_RGBA16F 0
+#define SSS_IRRADIANCE_ENCODING_R11G11B10F 1
+#define SSS_IRRADIANCE_ENCODING_RGB9E5 2
+#define SSS_IRRADIANCE_ENCODING_YCOCG 3
+
+#define SSS_DEPTH_ENCODING_NDC_R32F 0
+#define SSS_DEPTH_ENCODING_LINEAR_R16 1
+#define SSS_DEPTH_ENCODING_VIEW_Z_R16F 2
+#define SSS_DEPTH_ENCODING_VIEW_Z_R32F 3
+
+// The shared exponent (the same as the DXGI_FORMAT_R9G9B9E5_SHAREDEXP): 9 bits of each channel and 5 bits of the exponent (bias 15)
+uint subsurface_scattering_rgb9e5_encode(float3 rgb)
+{
+	// (2^9 - 1) / 2^9 * 2^(31 - 15)
+	float3 clamped_rgb = clamp(rgb, float3(0.0, 0.0, 0.0), float3(65408.0, 65408.0, 65408.0));
+	float max_channel = max(max(clamped_rgb.r, clamped_rgb.g), clamped_rgb.b);
+
+	// NOTE: the exponent of the float is exact while the "log2" may NOT be
+	int max_channel_exponent = max(int((asuint(max_channel) >> 23) & 0xFF) - 127, -16);
+	int shared_exponent = max_channel_exponent + 16;
+	[flatten]
+	if (floor(max_channel * exp2(float(24 - shared_exponent)) + 0.5) >= 512.0)
+	{
+		++shared_exponent;
+	}
+
+	uint3 encoded = uint3(floor(clamped_rgb * exp2(float(24 - shared_exponent)) + 0.5));
+	return encoded.r | (encoded.g << 9) | (encoded.b << 18) | (uint(shared_exponent) << 27);
+}
+
+float3 subsurface_scattering_rgb9e5_decode(uint encoded)
+{
+	int shared_exponent = int(encoded >> 27);
+	return float3(encoded & 0x1FF, (encoded >> 9) & 0x1FF, (encoded >> 18) & 0x1FF) * exp2(float(shared_exponent - 24));
+}
+
+// The 32 bits are split into the two channels of the R16G16_UNORM, which are exact since "k / 65535" is rounded back to "k" by the conversion of the UNORM
+float2 subsurface_scattering_rgb9e5_to_unorm16x2(uint encoded)
+{
+	return float2(encoded & 0xFFFF, encoded >> 16) * (1.0 / 65535.0);
+}
+
+uint subsurface_scattering_rgb9e5_from_unorm16x2(float2 unorm16x2)
+{
+	uint2 encoded = uint2(floor(unorm16x2 * 65535.0 + 0.5));
+	return encoded.x | (encoded.y << 16);
+}
+
+// YCoCg (NOT the YCoCg-R), of which the Co and the Cg are signed
+float3 subsurface_scattering_rgb_to_ycocg(float3 rgb)
+{
+	return float3(0.25 * rgb.r + 0.5 * rgb.g + 0.25 * rgb.b, 0.5 * rgb.r - 0.5 * rgb.b, -0.25 * rgb.r + 0.5 * rgb.g - 0.25 * rgb.b);
+}
+
+float3 subsurface_scattering_ycocg_to_rgb(float3 ycocg)
+{
+	float t = ycocg.x - ycocg.z;
+	return float3(t + ycocg.y, ycocg.x + ycocg.z, t - ycocg.y);
+}
+
+// The Co is stored at the texels of which the "x + y" is even, and the Cg is stored at the others, s.t. the horizontal partner (x ^ 1) always stores the other one
+float2 subsurface_scattering_ycocg_encode(float3 rgb, int2 texel)
+{
+	float3 ycocg = subsurface_scattering_rgb_to_ycocg(rgb);
+	return float2(ycocg.x, (0 == ((texel.x + texel.y) & 1)) ? ycocg.y : ycocg.z);
+}
+
+// NOTE: the last column of the odd width is paired with the previous column, which still stores the other chroma
+int subsurface_scattering_ycocg_partner_x(int x, int width)
+{
+	return ((x ^ 1) < width) ? (x ^ 1) : max(x - 1, 0);
+}
+
+// The chroma of the partner is scaled by the ratio of the luma, s.t. the hue of the partner is kept while the partner of which the irradiance is different (e.g. across the shadow edge) does NOT bleed
+float3 subsurface_scattering_ycocg_decode(float2 center, float2 partner, int2 texel)
+{
+	float partner_chroma = (partner.x > 0.0) ? (partner.y * (center.x / partner.x)) : 0.0;
+	bool co_at_center = (0 == ((texel.x + texel.y) & 1));
+	float3 rgb = subsurface_scattering_ycocg_to_rgb(float3(center.x, co_at_center ? center.y : partner_chroma, co_at_center ? partner_chroma : center.y));
+	return max(rgb, float3(0.0, 0.0, 0.0));
+}
+
+// The near plane and the far plane of the projection (row major, SV_POSITION.z = (proj[2][2] * z + proj[3][2]) / z)
+float subsurface_scattering_linear_depth_encode(float view_space_position_z, float4x4 proj)
+{
+	float near_plane = -proj[3][2] / proj[2][2];
+	float far_plane = proj[3][2] / (1.0 - proj[2][2]);
+	return saturate((view_space_position_z - near_plane) / (far_plane - near_plane));
+}
+
+float subsurface_scattering_linear_depth_decode(float linear_depth, float4x4 proj)
+{
+	float near_plane = -proj[3][2] / proj[2][2];
+	float far_plane = proj[3][2] / (1.0 - proj[2][2]);
+	return near_plane + linear_depth * (far_plane - near_plane);
+}
+
+float subsurface_scattering_ndcz_from_view_space_position_z(float view_space_position_z, float4x4 proj)
+{
+	return proj[2][2] + proj[3][2] / view_space_position_z;
+}
+
+#endif
@@ -0,0 +1,152 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The depth-aware mip chain of the irradiance and the view depth, s.t. each sample of the blur fetches the level which matches its share of the disk (the mipmapped screen-space subsurface scattering).
+//
+// Note: Provided by the User!
+//
+// int SSS_IRRADIANCE_PYRAMID_LEVEL_COUNT(): 0 disables the pyramid
+// float4 SSS_IRRADIANCE_PYRAMID_SOURCE(int level, int2 texel): (total_diffuse_reflectance_pre_scatter_multiply_form_factor, profile) of the level
+// float SSS_IRRADIANCE_PYRAMID_VIEW_SPACE_POSITION_Z_SOURCE(int level, int2 texel): the view depth of the level
+//
+// The layout is the same as the mask pyramid (see "subsurface_scattering_mask_pyramid.hlsli"): the level 0 is padded by clamping the address, and each texel of each level covers exactly 2^level x 2^level pixels.
+// The level 0 is written by the "subsurface_scattering_irradiance_pyramid_base" and each following level by the "subsurface_scattering_irradiance_pyramid_reduce" of the 2x2 texels of the previous level:
+//    profile: the profile index of the representative (the nearest child of the subsurface scattering), or -1 if none of the children is covered
+//    irradiance / view depth: the average of the children which are on the same surface as the representative (the same profile and NOT beyond the depth threshold)
+//
+// The sample of which the density is "p" (per mm^2) covers "1 / p" of the disk, and the "subsurface_scattering_irradiance_pyramid_sample" fetches the level of which the texel is NOT larger than the footprint.
+// The finer level is used if the representative of the texel belongs to another profile, and the level 0 is the full resolution (namely, the "SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE" and the "SSS_VIEW_SPACE_POSITION_Z_SOURCE").
+//
+
+#ifndef _SUBSURFACE_SCATTERING_IRRADIANCE_PYRAMID_HLSLI_
+#define _SUBSURFACE_SCATTERING_IRRADIANCE_PYRAMID_HLSLI_ 1
+
+#include "subsurface_scattering_mask_pyramid.hlsli"
+
+#define SSS_IRRADIANCE_PYRAMID_MAX_LEVEL_COUNT 8
+
+// The relative depth gradient per pixel beyond which the children are NOT on the same surface
+#define SSS_IRRADIANCE_PYRAMID_RELATIVE_DEPTH_THRESHOLD 0.01
+
+struct subsurface_scattering_irradiance_pyramid_texel
+{
+	// (total_diffuse_reflectance_pre_scatter_multiply_form_factor, profile_index)
+	float4 irradiance;
+	float view_space_position_z;
+};
+
+subsurface_scattering_irradiance_pyramid_texel subsurface_scattering_irradiance_pyramid_base(float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor, float subsurface_mask, int profile_index, float view_space_position_z)
+{
+	bool covered = (subsurface_mask >= (1.0 / 255.0)) && (profile_index >= 0);
+
+	subsurface_scattering_irradiance_pyramid_texel texel;
+	texel.irradiance = float4(total_diffuse_reflectance_pre_scatter_multiply_form_factor, covered ? float(profile_index) : -1.0);
+	texel.view_space_position_z = view_space_position_z;
+	return texel;
+}
+
+subsurface_scattering_irradiance_pyramid_texel subsurface_scattering_irradiance_pyramid_reduce(subsurface_scattering_irradiance_pyramid_texel children[4], int level)
+{
+	// The nearest child of the subsurface scattering is the representative (the same as the "subsurface_scattering_downsample")
+	int representative_profile_index = -1;
+	float representative_view_space_position_z = 0.0;
+	[unroll]
+	for (int child_index = 0; child_index < 4; ++child_index)
+	{
+		int profile_index = int(children[child_index].irradiance.w);
+		if ((profile_index >= 0) && ((representative_profile_index < 0) || (children[child_index].view_space_position_z < representative_view_space_position_z)))
+		{
+			representative_profile_index = profile_index;
+			representative_view_space_position_z = children[child_index].view_space_position_z;
+		}
+	}
+
+	// Only the children which are on the same surface as the representative are averaged (all of them if none is covered)
+	// NOTE: the threshold is the relative depth gradient per pixel, s.t. the sloped surface is NOT split at the coarse levels
+	float depth_threshold = SSS_IRRADIANCE_PYRAMID_RELATIVE_DEPTH_THRESHOLD * float(1 << (level - 1)) * representative_view_space_position_z;
+	float3 sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor = float3(0.0, 0.0, 0.0);
+	float sum_view_space_position_z = 0.0;
+	float count = 0.0;
+	[unroll]
+	for (int child_index = 0; child_index < 4; ++child_index)
+	{
+		if ((representative_profile_index < 0) || ((int(children[child_index].irradiance.w) == representative_profile_index) && (abs(children[child_index].view_space_position_z - representative_view_space_position_z) <= depth_threshold)))
+		{
+			sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor += children[child_index].irradiance.rgb;
+			sum_view_space_position_z += children[child_index].view_space_position_z;
+			count += 1.0;
+		}
+	}
+
+	// NOTE: the representative itself is always counted
+	subsurface_scattering_irradiance_pyramid_texel texel;
+	texel.irradiance = float4(sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor * (1.0 / count), float(representative_profile_index));
+	texel.view_space_position_z = sum_view_space_position_z * (1.0 / count);
+	return texel;
+}
+
+// The level of which the texel (2^level x 2^level pixels) is NOT larger than the footprint
+int subsurface_scattering_irradiance_pyramid_level(float footprint_in_pixels, int level_count)
+{
+	int level = 0;
+	[branch]
+	if ((level_count > 1) && (footprint_in_pixels >= 4.0))
+	{
+		level = min(int(0.5 * log2(footprint_in_pixels)), level_count - 1);
+	}
+	return level;
+}
+
+struct subsurface_scattering_irradiance_pyramid_sample_result
+{
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	float view_space_position_z;
+};
+
+subsurface_scattering_irradiance_pyramid_sample_result subsurface_scattering_irradiance_pyramid_sample(float2 sample_uv, int profile_index, float footprint_in_pixels)
+{
+	subsurface_scattering_irradiance_pyramid_sample_result result;
+	result.total_diffuse_reflectance_pre_scatter_multiply_form_factor = float3(0.0, 0.0, 0.0);
+	result.view_space_position_z = 0.0;
+
+	int2 sample_texel = subsurface_scattering_mask_pyramid_texel(sample_uv, int2(SSS_PIXELS_PER_UV()));
+
+	// The finer level is used if the representative of the texel belongs to another profile
+	bool found = false;
+	for (int level = subsurface_scattering_irradiance_pyramid_level(footprint_in_pixels, SSS_IRRADIANCE_PYRAMID_LEVEL_COUNT()); (level > 0) && (!found); --level)
+	{
+		float4 irradiance = SSS_IRRADIANCE_PYRAMID_SOURCE(level, sample_texel >> level);
+		[branch]
+		if (int(irradiance.w) == profile_index)
+		{
+			result.total_diffuse_reflectance_pre_scatter_multiply_form_factor = irradiance.rgb;
+			result.view_space_position_z = SSS_IRRADIANCE_PYRAMID_VIEW_SPACE_POSITION_Z_SOURCE(level, sample_texel >> level);
+			found = true;
+		}
+	}
+
+	// The level 0 is the full resolution
+	[branch]
+	if (!found)
+	{
+		result.total_diffuse_reflectance_pre_scatter_multiply_form_factor = SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE(sample_uv);
+		result.view_space_position_z = SSS_VIEW_SPACE_POSITION_Z_SOURCE(sample_uv);
+	}
+	return result;
+}
+
+#endif
@@ -0,0 +1,45 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The kernels of the blur baked on the CPU (see "Code/CPU/SSSKernelCache.h").
+//
+// The "center_sample_cdf" is quantized (rounded down) into buckets.
+// Each sample is (offset_in_mm.x, offset_in_mm.y, r, rcp_pdf) where offset_in_mm = (cos(theta), sin(theta)) * r.
+// The kernels are baked for "d = 1" and shared by all profiles, since the (offset_in_mm, r, rcp_pdf) are proportional to "d".
+// The kernels of all sample counts [1, SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT] are packed without gaps: offset = bucket * (MAX * (MAX + 1) / 2) + sample_count * (sample_count - 1) / 2
+//
+
+#ifndef _SUBSURFACE_SCATTERING_KERNEL_CACHE_HLSLI_
+#define _SUBSURFACE_SCATTERING_KERNEL_CACHE_HLSLI_ 1
+
+#define SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT 64
+#define SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT 80
+
+float subsurface_scattering_kernel_cache_center_sample_cdf(float center_sample_cdf)
+{
+	return floor(saturate(center_sample_cdf) * float(SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT - 1)) * (1.0 / float(SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT - 1));
+}
+
+float4 subsurface_scattering_kernel_cache_sample(Buffer<float4> kernel_cache, float d, float quantized_center_sample_cdf, int sample_count, int sample_index)
+{
+	// NOTE: "+ 0.5" to be robust to the rounding of the quantized value
+	int center_cdf_bucket = int(quantized_center_sample_cdf * float(SSS_KERNEL_CACHE_CENTER_CDF_BUCKET_COUNT - 1) + 0.5);
+	int offset = center_cdf_bucket * ((SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT * (SSS_KERNEL_CACHE_MAX_SAMPLE_COUNT + 1)) / 2) + (sample_count * (sample_count - 1)) / 2;
+	return d * kernel_cache.Load(offset + sample_index);
+}
+
+#endif
@@ -0,0 +1,181 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+// The depth-aware downsampling and the joint bilateral upsampling of the low resolution blur.
+//
+// Note: Provided by the User!
+//
+// The full resolution (the "downsample" reads the whole block and the "upsample" reads the center):
+// float3 SSS_FULL_RESOLUTION_IRRADIANCE_SOURCE(int2 texel)
+// float SSS_FULL_RESOLUTION_SUBSURFACE_MASK_SOURCE(int2 texel)
+// int SSS_FULL_RESOLUTION_PROFILE_INDEX_SOURCE(int2 texel)
+// float SSS_FULL_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE(int2 texel)
+// int2 SSS_FULL_RESOLUTION_SIZE()
+//
+// The low resolution (the "upsample" reads the four texels around the center):
+// float3 SSS_LOW_RESOLUTION_BLURRED_SOURCE(int2 texel)
+// float SSS_LOW_RESOLUTION_SUBSURFACE_MASK_SOURCE(int2 texel)
+// int SSS_LOW_RESOLUTION_PROFILE_INDEX_SOURCE(int2 texel)
+// float SSS_LOW_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE(int2 texel)
+// int2 SSS_LOW_RESOLUTION_SIZE()
+//
+// The low resolution texel (x, y) covers the block [factor * x, factor * x + factor) * [factor * y, factor * y + factor) of the full resolution, and the size of the low resolution is ceil(full / factor).
+// The "SSS_LOW_RESOLUTION_BLURRED_SOURCE" is the blurred "total_diffuse_reflectance_pre_scatter_multiply_form_factor", namely, the low resolution blur is performed with the white albedo and the "total_diffuse_reflectance_post_scatter" is multiplied at the full resolution, s.t. the details of the albedo are NOT lost.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_LOW_RESOLUTION_HLSLI_
+#define _SUBSURFACE_SCATTERING_LOW_RESOLUTION_HLSLI_ 1
+
+// The texels are on the same surface if the difference of the view depth is less than this ratio of the view depth
+#define SSS_LOW_RESOLUTION_RELATIVE_DEPTH_THRESHOLD 0.01
+
+// Less than this, the upsample falls back to the nearest (in depth) low resolution texel
+#define SSS_LOW_RESOLUTION_MIN_UPSAMPLE_WEIGHT 1e-4
+
+struct subsurface_scattering_downsample_result
+{
+	float3 total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	float subsurface_mask;
+	// -1 if none of the block is subsurface scattering
+	int profile_index;
+	// The full resolution texel of which the depth is used by the low resolution
+	int2 representative_texel;
+};
+
+subsurface_scattering_downsample_result subsurface_scattering_downsample(int resolution_factor, int2 low_resolution_texel)
+{
+	int2 full_resolution_size = SSS_FULL_RESOLUTION_SIZE();
+	int2 block_begin = min(low_resolution_texel * resolution_factor, full_resolution_size - int2(1, 1));
+	int2 block_end = min(block_begin + int2(resolution_factor, resolution_factor), full_resolution_size);
+
+	// The nearest texel of the subsurface scattering is the representative, s.t. the silhouette is NOT pushed into the background
+	subsurface_scattering_downsample_result result;
+	result.total_diffuse_reflectance_pre_scatter_multiply_form_factor = float3(0.0, 0.0, 0.0);
+	result.subsurface_mask = 0.0;
+	result.profile_index = -1;
+	result.representative_texel = block_begin;
+	float representative_view_space_position_z = 0.0;
+	for (int block_y = block_begin.y; block_y < block_end.y; ++block_y)
+	{
+		for (int block_x = block_begin.x; block_x < block_end.x; ++block_x)
+		{
+			int profile_index = SSS_FULL_RESOLUTION_PROFILE_INDEX_SOURCE(int2(block_x, block_y));
+			float view_space_position_z = SSS_FULL_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE(int2(block_x, block_y));
+			if ((profile_index >= 0) && ((result.profile_index < 0) || (view_space_position_z < representative_view_space_position_z)))
+			{
+				result.profile_index = profile_index;
+				result.representative_texel = int2(block_x, block_y);
+				representative_view_space_position_z = view_space_position_z;
+			}
+		}
+	}
+
+	[branch]
+	if (result.profile_index < 0)
+	{
+		return result;
+	}
+
+	// Only the texels which are on the same surface as the representative are averaged, s.t. the irradiance is NOT leaked across the depth discontinuity or the profile boundary
+	float3 sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor = float3(0.0, 0.0, 0.0);
+	float sum_subsurface_mask = 0.0;
+	float count = 0.0;
+	for (int y = block_begin.y; y < block_end.y; ++y)
+	{
+		for (int x = block_begin.x; x < block_end.x; ++x)
+		{
+			int profile_index = SSS_FULL_RESOLUTION_PROFILE_INDEX_SOURCE(int2(x, y));
+			float view_space_position_z = SSS_FULL_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE(int2(x, y));
+			if ((profile_index == result.profile_index) && (abs(view_space_position_z - representative_view_space_position_z) <= (SSS_LOW_RESOLUTION_RELATIVE_DEPTH_THRESHOLD * representative_view_space_position_z)))
+			{
+				sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor += SSS_FULL_RESOLUTION_IRRADIANCE_SOURCE(int2(x, y));
+				sum_subsurface_mask += SSS_FULL_RESOLUTION_SUBSURFACE_MASK_SOURCE(int2(x, y));
+				count += 1.0;
+			}
+		}
+	}
+
+	// NOTE: the representative itself is always counted
+	result.total_diffuse_reflectance_pre_scatter_multiply_form_factor = sum_total_diffuse_reflectance_pre_scatter_multiply_form_factor * (1.0 / count);
+	result.subsurface_mask = sum_subsurface_mask * (1.0 / count);
+	return result;
+}
+
+// Joint Bilateral Upsampling
+// The bilinear weights of the four low resolution texels around the center are multiplied by the similarity of the depth and the subsurface mask (guided by the full resolution), and the texels of another profile are rejected.
+// NOTE: the center should be subsurface scattering (the stencil test guarantees that the profile index is valid)
+float3 subsurface_scattering_upsample(int resolution_factor, int2 full_resolution_texel)
+{
+	float center_subsurface_mask = SSS_FULL_RESOLUTION_SUBSURFACE_MASK_SOURCE(full_resolution_texel);
+	// Early Out (the same as the full resolution blur)
+	[branch]
+	if (center_subsurface_mask < (1.0 / 255.0))
+	{
+		return SSS_FULL_RESOLUTION_IRRADIANCE_SOURCE(full_resolution_texel);
+	}
+
+	int center_profile_index = SSS_FULL_RESOLUTION_PROFILE_INDEX_SOURCE(full_resolution_texel);
+	float center_view_space_position_z = SSS_FULL_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE(full_resolution_texel);
+	float rcp_depth_sigma = 1.0 / (SSS_LOW_RESOLUTION_RELATIVE_DEPTH_THRESHOLD * center_view_space_position_z);
+
+	// The center of the full resolution texel in the texel space of the low resolution
+	float2 low_resolution_position = (float2(full_resolution_texel) + float2(0.5, 0.5)) * (1.0 / float(resolution_factor)) - float2(0.5, 0.5);
+	int2 low_resolution_base = int2(floor(low_resolution_position));
+	float2 bilinear = low_resolution_position - float2(low_resolution_base);
+	int2 low_resolution_size = SSS_LOW_RESOLUTION_SIZE();
+
+	float3 sum_blurred = float3(0.0, 0.0, 0.0);
+	float sum_weight = 0.0;
+
+	// The fallback is the unblurred center if none of the four texels is on the same profile
+	float3 nearest_blurred = SSS_FULL_RESOLUTION_IRRADIANCE_SOURCE(full_resolution_texel);
+	float nearest_relative_position_z = -1.0;
+
+	[unroll]
+	for (int tap_index = 0; tap_index < 4; ++tap_index)
+	{
+		int2 tap_offset = int2(tap_index & 1, tap_index >> 1);
+		int2 low_resolution_texel = clamp(low_resolution_base + tap_offset, int2(0, 0), low_resolution_size - int2(1, 1));
+
+		float tap_subsurface_mask = SSS_LOW_RESOLUTION_SUBSURFACE_MASK_SOURCE(low_resolution_texel);
+		[branch]
+		if ((SSS_LOW_RESOLUTION_PROFILE_INDEX_SOURCE(low_resolution_texel) == center_profile_index) && (tap_subsurface_mask >= (1.0 / 255.0)))
+		{
+			float3 tap_blurred = SSS_LOW_RESOLUTION_BLURRED_SOURCE(low_resolution_texel);
+			float relative_position_z = abs(SSS_LOW_RESOLUTION_VIEW_SPACE_POSITION_Z_SOURCE(low_resolution_texel) - center_view_space_position_z) * rcp_depth_sigma;
+
+			float bilinear_weight = ((0 != tap_offset.x) ? bilinear.x : (1.0 - bilinear.x)) * ((0 != tap_offset.y) ? bilinear.y : (1.0 - bilinear.y));
+			float depth_weight = exp(-0.5 * relative_position_z * relative_position_z);
+			float subsurface_mask_weight = saturate(1.0 - abs(tap_subsurface_mask - center_subsurface_mask));
+			float weight = bilinear_weight * depth_weight * subsurface_mask_weight;
+
+			sum_blurred += tap_blurred * weight;
+			sum_weight += weight;
+
+			if ((nearest_relative_position_z < 0.0) || (relative_position_z < nearest_relative_position_z))
+			{
+				nearest_blurred = tap_blurred;
+				nearest_relative_position_z = relative_position_z;
+			}
+		}
+	}
+
+	return (sum_weight >= SSS_LOW_RESOLUTION_MIN_UPSAMPLE_WEIGHT) ? (sum_blurred * (1.0 / sum_weight)) : nearest_blurred;
+}
+
+#endif
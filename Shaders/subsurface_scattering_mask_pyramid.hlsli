@@ -0,0 +1,149 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The hierarchical subsurface mask of the blur, s.t. the samples of which the footprint is known to be empty skip the full resolution fetch.
+//
+// Note: Provided by the User!
+//
+// int SSS_MASK_PYRAMID_LEVEL_COUNT(): 0 disables the pyramid
+// float4 SSS_MASK_PYRAMID_SOURCE(int level, int2 texel): the texel of the level
+//
+// Each texel of the pyramid is (min_mask, max_mask, coverage, profile) over the footprint (2^level x 2^level pixels of the blur):
+//    min_mask / max_mask: the minimum / maximum subsurface mask
+//    coverage: the fraction of the pixels which are NOT rejected by the subsurface mask (namely, "dist_scale >= 1 / 255") and of which the stencil is NOT zero
+//    profile: the profile index if all pixels belong to the same profile (-1 if the stencil is zero), and SSS_MASK_PYRAMID_PROFILE_MIXED otherwise
+// The level 0 is written by the "subsurface_scattering_mask_pyramid_base" and each following level by the "subsurface_scattering_mask_pyramid_reduce" of the 2x2 texels of the previous level.
+// NOTE: the size of the level 0 is padded to the multiple of 2^(level_count - 1) by clamping the address to the screen (the same as the sample), s.t. each texel of each level covers exactly 2^level x 2^level pixels.
+//
+// 1. The "subsurface_scattering_mask_pyramid_sample_test" decides each sample by the texel of the SSS_MASK_PYRAMID_SAMPLE_LEVEL:
+//    REJECTED: the footprint is empty (max_mask < 1 / 255 or coverage is zero) or belongs to another profile
+//    ACCEPTED: the footprint is covered (min_mask >= 1 / 255) and belongs to the profile of the center
+//    UNKNOWN: the subsurface mask and the profile index of the sample are fetched at the full resolution
+// 2. The "subsurface_scattering_mask_pyramid_edge_free_radius" decides the whole pixel: if the (at most) 2x2 texels of the level which cover the filter are all ACCEPTED, none of the samples within the returned radius needs to be tested at all (see "subsurface_scattering_disney_blur_estimate_interior").
+//
+
+#ifndef _SUBSURFACE_SCATTERING_MASK_PYRAMID_HLSLI_
+#define _SUBSURFACE_SCATTERING_MASK_PYRAMID_HLSLI_ 1
+
+#define SSS_MASK_PYRAMID_MAX_LEVEL_COUNT 8
+
+// The footprint of the texel of the sample test is 4x4 pixels
+#define SSS_MASK_PYRAMID_SAMPLE_LEVEL 2
+
+#define SSS_MASK_PYRAMID_PROFILE_MIXED -2
+
+#define SSS_MASK_PYRAMID_SAMPLE_REJECTED 0
+#define SSS_MASK_PYRAMID_SAMPLE_ACCEPTED 1
+#define SSS_MASK_PYRAMID_SAMPLE_UNKNOWN 2
+
+// The edges of the footprint on the border of the screen are infinitely far, since the address of the sample is clamped
+#define SSS_MASK_PYRAMID_UNBOUNDED_RADIUS 3.402823466e+38
+
+// The floating point error of the address of the sample (in pixels)
+#define SSS_MASK_PYRAMID_EDGE_FREE_RADIUS_EPSILON (1.0 / 16.0)
+
+float4 subsurface_scattering_mask_pyramid_base(float subsurface_mask, int profile_index)
+{
+	bool covered = (subsurface_mask >= (1.0 / 255.0)) && (profile_index >= 0);
+	return float4(subsurface_mask, subsurface_mask, covered ? 1.0 : 0.0, float(profile_index));
+}
+
+float4 subsurface_scattering_mask_pyramid_reduce(float4 texel_00, float4 texel_10, float4 texel_01, float4 texel_11)
+{
+	float min_mask = min(min(texel_00.x, texel_10.x), min(texel_01.x, texel_11.x));
+	float max_mask = max(max(texel_00.y, texel_10.y), max(texel_01.y, texel_11.y));
+	float coverage = 0.25 * (texel_00.z + texel_10.z + texel_01.z + texel_11.z);
+	bool uniform = (texel_00.w == texel_10.w) && (texel_00.w == texel_01.w) && (texel_00.w == texel_11.w);
+	return float4(min_mask, max_mask, coverage, uniform ? texel_00.w : float(SSS_MASK_PYRAMID_PROFILE_MIXED));
+}
+
+// NOTE: the address is clamped the same as the "SSS_SUBSURFACE_PROFILE_INDEX_SOURCE"
+int2 subsurface_scattering_mask_pyramid_texel(float2 uv, int2 screen_size)
+{
+	return clamp(int2(floor(uv * float2(screen_size))), int2(0, 0), screen_size - int2(1, 1));
+}
+
+int subsurface_scattering_mask_pyramid_sample_test(float2 sample_uv, int profile_index)
+{
+	[branch]
+	if (SSS_MASK_PYRAMID_LEVEL_COUNT() <= SSS_MASK_PYRAMID_SAMPLE_LEVEL)
+	{
+		return SSS_MASK_PYRAMID_SAMPLE_UNKNOWN;
+	}
+
+	int2 sample_texel = subsurface_scattering_mask_pyramid_texel(sample_uv, int2(SSS_PIXELS_PER_UV()));
+	float4 footprint = SSS_MASK_PYRAMID_SOURCE(SSS_MASK_PYRAMID_SAMPLE_LEVEL, sample_texel >> SSS_MASK_PYRAMID_SAMPLE_LEVEL);
+	int footprint_profile_index = int(footprint.w);
+
+	int sample_test;
+	if ((footprint.y < (1.0 / 255.0)) || (footprint.z <= 0.0) || ((SSS_MASK_PYRAMID_PROFILE_MIXED != footprint_profile_index) && (footprint_profile_index != profile_index)))
+	{
+		sample_test = SSS_MASK_PYRAMID_SAMPLE_REJECTED;
+	}
+	else if ((footprint.x >= (1.0 / 255.0)) && (footprint_profile_index == profile_index))
+	{
+		sample_test = SSS_MASK_PYRAMID_SAMPLE_ACCEPTED;
+	}
+	else
+	{
+		sample_test = SSS_MASK_PYRAMID_SAMPLE_UNKNOWN;
+	}
+	return sample_test;
+}
+
+// The radius (in pixels) around the center within which all pixels are known to belong to the profile of the center, or zero if unknown
+// NOTE: the level is the smallest one of which the texel is NOT less than the diameter of the filter, s.t. the filter is covered by at most 2x2 texels
+float subsurface_scattering_mask_pyramid_edge_free_radius(float2 center_uv, int profile_index, float radius_in_pixels)
+{
+	const int level_count = SSS_MASK_PYRAMID_LEVEL_COUNT();
+	[branch]
+	if ((level_count <= 0) || !((2.0 * radius_in_pixels) <= float(1 << (level_count - 1))))
+	{
+		return 0.0;
+	}
+
+	const int level = int(ceil(log2(max(2.0 * radius_in_pixels, 1.0))));
+	const float texel_size = float(1 << level);
+
+	const int2 screen_size = int2(SSS_PIXELS_PER_UV());
+	const int2 last_texel = (screen_size - int2(1, 1)) >> level;
+	const float2 center = float2(subsurface_scattering_mask_pyramid_texel(center_uv, screen_size)) + float2(0.5, 0.5);
+	const int2 texel_begin = clamp(int2(floor((center - radius_in_pixels) / texel_size)), int2(0, 0), last_texel);
+	const int2 texel_end = clamp(int2(floor((center + radius_in_pixels) / texel_size)), int2(0, 0), last_texel);
+
+	bool covered = true;
+	for (int texel_y = texel_begin.y; texel_y <= texel_end.y; ++texel_y)
+	{
+		for (int texel_x = texel_begin.x; texel_x <= texel_end.x; ++texel_x)
+		{
+			float4 footprint = SSS_MASK_PYRAMID_SOURCE(level, int2(texel_x, texel_y));
+			covered = covered && (footprint.x >= (1.0 / 255.0)) && (int(footprint.w) == profile_index);
+		}
+	}
+
+	[branch]
+	if (!covered)
+	{
+		return 0.0;
+	}
+
+	const float2 distance_begin = float2((0 == texel_begin.x) ? SSS_MASK_PYRAMID_UNBOUNDED_RADIUS : (center.x - float(texel_begin.x) * texel_size), (0 == texel_begin.y) ? SSS_MASK_PYRAMID_UNBOUNDED_RADIUS : (center.y - float(texel_begin.y) * texel_size));
+	const float2 distance_end = float2((last_texel.x == texel_end.x) ? SSS_MASK_PYRAMID_UNBOUNDED_RADIUS : (float(texel_end.x + 1) * texel_size - center.x), (last_texel.y == texel_end.y) ? SSS_MASK_PYRAMID_UNBOUNDED_RADIUS : (float(texel_end.y + 1) * texel_size - center.y));
+	return min(min(distance_begin.x, distance_begin.y), min(distance_end.x, distance_end.y)) - SSS_MASK_PYRAMID_EDGE_FREE_RADIUS_EPSILON;
+}
+
+#endif
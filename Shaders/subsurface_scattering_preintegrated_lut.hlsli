@@ -0,0 +1,60 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The pre-integrated skin shading baked on the CPU (see "Code/CPU/SSSPreintegratedLUT.h"), which is the cheap LOD of the blur.
+//
+// One slice per profile, and each slice is [curvature][N.L]: the irradiance of the sphere of the radius "1 / curvature" blurred by the Burley profile, which replaces the "saturate(N.L)" of the light loop.
+// The "N.L" is uniform in [-1, 1] and the curvature is uniform in "sqrt(curvature * max(scattering_distance) / SSS_PREINTEGRATED_LUT_MAX_CURVATURE)".
+// The curvature is baked into the texture space of the mesh (see "Code/CPU/SSSCurvatureMap.h") in 1 / (the units of the mesh).
+// NOTE: the four texels are loaded and interpolated manually, the same as the "subsurface_scattering_transmittance_lut".
+//
+
+#ifndef _SUBSURFACE_SCATTERING_PREINTEGRATED_LUT_HLSLI_
+#define _SUBSURFACE_SCATTERING_PREINTEGRATED_LUT_HLSLI_ 1
+
+#define SSS_PREINTEGRATED_LUT_MAX_CURVATURE 1.0
+
+float subsurface_scattering_curvature_in_mm(float curvature_in_units, float world_scale)
+{
+    float meters_per_unit = world_scale;
+    return curvature_in_units * (1.0 / (1000.0 * meters_per_unit));
+}
+
+float3 subsurface_scattering_preintegrated_lut(Texture2DArray<float4> preintegrated_lut, int profile_index, float3 scattering_distance, float ndotl, float curvature_in_mm)
+{
+    uint lut_width;
+    uint lut_height;
+    uint lut_elements;
+    preintegrated_lut.GetDimensions(lut_width, lut_height, lut_elements);
+
+    float d = max(max(scattering_distance.x, scattering_distance.y), scattering_distance.z);
+
+    float s = saturate(ndotl * 0.5 + 0.5) * float(int(lut_width) - 1);
+    float t = sqrt(saturate(max(curvature_in_mm, 0.0) * d * (1.0 / SSS_PREINTEGRATED_LUT_MAX_CURVATURE))) * float(int(lut_height) - 1);
+    int s_index = min(int(s), int(lut_width) - 2);
+    int t_index = min(int(t), int(lut_height) - 2);
+    float s_fraction = s - float(s_index);
+    float t_fraction = t - float(t_index);
+
+    float3 p00 = preintegrated_lut.Load(int4(s_index, t_index, profile_index, 0)).xyz;
+    float3 p01 = preintegrated_lut.Load(int4(s_index + 1, t_index, profile_index, 0)).xyz;
+    float3 p10 = preintegrated_lut.Load(int4(s_index, t_index + 1, profile_index, 0)).xyz;
+    float3 p11 = preintegrated_lut.Load(int4(s_index + 1, t_index + 1, profile_index, 0)).xyz;
+    return lerp(lerp(p00, p01, s_fraction), lerp(p10, p11, s_fraction), t_fraction);
+}
+
+#endif
@@ -0,0 +1,64 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The profiles of the subsurface scattering uploaded by the CPU (see "Code/CPU/SSSProfileTable.h").
+//
+// The profile index of each pixel is stored in the stencil buffer: stencil = profile_index + 1, and zero means no subsurface scattering.
+// The highest bit of the stencil is the "reduced budget" tier of the LOD (see "Code/CPU/SSSLodSelector.h"), s.t. the profile index only takes the lower 7 bits.
+// Each profile is two "float4" of the "Buffer<float4>": (scattering_distance, world_scale) and (transmittance_tint, filter_radius).
+//
+
+#ifndef _SUBSURFACE_SCATTERING_PROFILE_HLSLI_
+#define _SUBSURFACE_SCATTERING_PROFILE_HLSLI_ 1
+
+#define SSS_PROFILE_MAX_COUNT 127
+#define SSS_STENCIL_PROFILE_MASK 0x7F
+#define SSS_STENCIL_REDUCED_BUDGET_BIT 0x80
+#define SSS_REDUCED_SAMPLE_BUDGET_DIVISOR 4
+
+struct subsurface_scattering_profile
+{
+	float3 scattering_distance;
+	float world_scale;
+	float3 transmittance_tint;
+	float filter_radius;
+};
+
+int subsurface_scattering_profile_index_from_stencil(uint stencil)
+{
+	return int(stencil & SSS_STENCIL_PROFILE_MASK) - 1;
+}
+
+int subsurface_scattering_sample_budget_from_stencil(uint stencil, int sample_budget)
+{
+	return (0 != (stencil & SSS_STENCIL_REDUCED_BUDGET_BIT)) ? max(1, sample_budget / SSS_REDUCED_SAMPLE_BUDGET_DIVISOR) : sample_budget;
+}
+
+subsurface_scattering_profile subsurface_scattering_profile_load(Buffer<float4> profiles, int profile_index)
+{
+	float4 scattering_distance_world_scale = profiles.Load(2 * profile_index);
+	float4 transmittance_tint_filter_radius = profiles.Load(2 * profile_index + 1);
+
+	subsurface_scattering_profile profile;
+	profile.scattering_distance = scattering_distance_world_scale.xyz;
+	profile.world_scale = scattering_distance_world_scale.w;
+	profile.transmittance_tint = transmittance_tint_filter_radius.xyz;
+	profile.filter_radius = transmittance_tint_filter_radius.w;
+	return profile;
+}
+
+#endif
@@ -0,0 +1,93 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// Note: Provided by the User!
+//
+// SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE
+// SSS_SUBSURFACE_MASK_SOURCE
+// SSS_SUBSURFACE_PROFILE_INDEX_SOURCE
+// SSS_VIEW_SPACE_POSITION_Z_SOURCE
+// SSS_PROJECTION_X_SOURCE
+// SSS_PROJECTION_Y_SOURCE
+// SSS_SEPARABLE_KERNEL_SAMPLE_SOURCE: (weight.rgb, offset_in_mm) of the row of the profile (see "Code/CPU/SSSSeparableKernel.h")
+//
+// The separable approximation of [Jorge Jimenez, Karoly Zsolnai, Adrian Jarabo, Christian Freude, Thomas Auzinger, Xian-Chun Wu, Javier von der Pahlen, Michael Wimmer, Diego Gutierrez. "Separable Subsurface Scattering." CGF 2015.](http://www.iryoku.com/separable-sss/)
+// The Burley profile is fitted by a sum of Gaussians on the CPU, and each Gaussian is separable, s.t. the 2D blur is approximated by the horizontal pass and the vertical pass of the 1D kernel (the cross terms of the sum of Gaussians are the error of the approximation).
+// The horizontal pass reads the irradiance and the vertical pass reads the output of the horizontal pass (the intermediate render target), namely, the "SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE" of the vertical pass is the intermediate render target.
+// The "total_diffuse_reflectance_post_scatter" is multiplied by the caller of the vertical pass.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_SEPARABLE_BLUR_HLSLI_
+#define _SUBSURFACE_SCATTERING_SEPARABLE_BLUR_HLSLI_ 1
+
+#define SSS_SEPARABLE_KERNEL_SAMPLE_COUNT 25
+
+// SSS_BLUR_MODE_BURLEY: the "subsurface_scattering_disney_blur" (one pass)
+// SSS_BLUR_MODE_SEPARABLE: the "subsurface_scattering_separable_blur" (the horizontal pass into the intermediate render target and then the vertical pass)
+#define SSS_BLUR_MODE_BURLEY 0
+#define SSS_BLUR_MODE_SEPARABLE 1
+
+// direction: (1, 0) for the horizontal pass and (0, 1) for the vertical pass
+float3 subsurface_scattering_separable_blur(const float filter_radius, const float world_scale, const float2 direction, const float2 center_uv)
+{
+	const float3 center_total_diffuse_reflectance_pre_scatter_multiply_form_factor = SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE(center_uv);
+
+	const float dist_scale = SSS_SUBSURFACE_MASK_SOURCE(center_uv);
+	// Early Out
+	[branch]
+	if (dist_scale < (1.0 / 255.0))
+	{
+		return center_total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	}
+
+	// UE4
+	// See "subsurface_scattering_disney_blur" for details.
+	const float meters_per_unit = world_scale;
+	const float center_view_space_position_z = SSS_VIEW_SPACE_POSITION_Z_SOURCE(center_uv);
+	const float mms_per_unit = 1000.0 * meters_per_unit * (1.0 / dist_scale);
+	const float2 uv_per_mm = 0.5 * float2(SSS_PROJECTION_X_SOURCE(), SSS_PROJECTION_Y_SOURCE()) * (1.0 / center_view_space_position_z) * (1.0 / mms_per_unit);
+
+	const int profile_index = SSS_SUBSURFACE_PROFILE_INDEX_SOURCE(center_uv);
+
+	float3 sum = float3(0.0, 0.0, 0.0);
+	[unroll]
+	for (int sample_index = 0; sample_index < SSS_SEPARABLE_KERNEL_SAMPLE_COUNT; ++sample_index)
+	{
+		// (weight.rgb, offset_in_mm)
+		float4 kernel_sample = SSS_SEPARABLE_KERNEL_SAMPLE_SOURCE(profile_index, sample_index);
+		float2 sample_uv = center_uv + uv_per_mm * direction * kernel_sample.w;
+
+		// The samples which belong to another profile (or which are NOT skin) are replaced by the center, s.t. the energy is NOT leaked across the boundary
+		float3 sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor = center_total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+		[branch]
+		if ((SSS_SUBSURFACE_MASK_SOURCE(sample_uv) >= (1.0 / 255.0)) && (SSS_SUBSURFACE_PROFILE_INDEX_SOURCE(sample_uv) == profile_index))
+		{
+			// Follow Surface
+			// The 1D kernel can NOT be evaluated at the 3D distance (since the cross terms of the sum of Gaussians are dropped), and thus the sample is faded to the center by the depth difference relative to the filter radius.
+			float sample_view_space_position_z = SSS_VIEW_SPACE_POSITION_Z_SOURCE(sample_uv);
+			float relative_position_z_mm = mms_per_unit * (sample_view_space_position_z - center_view_space_position_z);
+			float follow_surface = saturate(abs(relative_position_z_mm) * (1.0 / filter_radius));
+			sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor = lerp(SSS_TOTAL_DIFFUSE_REFLECTANCE_PRE_SCATTER_MULTIPLY_FORM_FACTOR_SOURCE(sample_uv), center_total_diffuse_reflectance_pre_scatter_multiply_form_factor, follow_surface);
+		}
+
+		sum += kernel_sample.rgb * sample_total_diffuse_reflectance_pre_scatter_multiply_form_factor;
+	}
+
+	return sum;
+}
+
+#endif
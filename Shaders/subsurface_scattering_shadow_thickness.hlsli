@@ -0,0 +1,45 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The thickness of the transmittance between the shaded point and the first surface seen by the light (namely, the texel of the shadow map).
+//
+// The shadow map pass additionally writes SV_POSITION.w (the view space position z of the light) into the linear shadow map (the R16_FLOAT or the R32_FLOAT), while the hardware depth is still used by the PCF.
+// The w of the shadow position (before the perspective division) is the view space position z of the shaded point, s.t. the thickness is the difference of the two without the reconstruction from the NDC depth of both ends.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_SHADOW_THICKNESS_HLSLI_
+#define _SUBSURFACE_SCATTERING_SHADOW_THICKNESS_HLSLI_ 1
+
+#define SSS_SHADOW_DEPTH_MODE_NDC_R32F 0
+#define SSS_SHADOW_DEPTH_MODE_LINEAR_R16F 1
+#define SSS_SHADOW_DEPTH_MODE_LINEAR_R32F 2
+
+// The NDC depth of both ends (SV_POSITION.z = (proj[2][2] * z + proj[3][2]) / z)
+float subsurface_scattering_shadow_thickness_from_ndc(float shadow_map_depth, float shadow_position_z, float4x4 light_projection)
+{
+	float d1 = light_projection[3][2] / (shadow_map_depth - light_projection[2][2]);
+	float d2 = light_projection[3][2] / (shadow_position_z - light_projection[2][2]);
+	return abs(d2 - d1);
+}
+
+// The view space position z of both ends
+float subsurface_scattering_shadow_thickness_from_linear(float shadow_map_view_space_position_z, float shadow_position_w)
+{
+	return abs(shadow_position_w - shadow_map_view_space_position_z);
+}
+
+#endif
@@ -0,0 +1,104 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+// The temporal accumulation of the blur: the history is reprojected to the current frame, the history samples which are NOT on the same surface are rejected, and the current frame is blended exponentially.
+//
+// Note: Provided by the User!
+//
+// float4 SSS_TEMPORAL_HISTORY_SOURCE(int2 texel): (radiance.rgb, history_length) of the previous frame
+// float2 SSS_TEMPORAL_HISTORY_GUIDE_SOURCE(int2 texel): (view_space_position_z, subsurface_mask) of the previous frame, of which the zero view_space_position_z means invalid (NOT written or cleared)
+// int2 SSS_TEMPORAL_HISTORY_SIZE()
+//
+// The sample pattern of the blur is rotated and the radii are offset per frame (see "SSS_SAMPLE_ROTATION_SOURCE" and "SSS_SAMPLE_SEQUENCE_SOURCE" of the "subsurface_scattering_disney_blur.hlsli"), s.t. the accumulated history converges to more samples than the budget of one frame.
+// The motion vector is "uv_curr - uv_prev" (see "RenderPS" of the "Shaders/Support/Main.hlsli").
+// The reprojection matrix transforms the current NDC to the previous clip space: inverse(curr_view_projection) * prev_view_projection (row vector).
+//
+
+#ifndef _SUBSURFACE_SCATTERING_TEMPORAL_HLSLI_
+#define _SUBSURFACE_SCATTERING_TEMPORAL_HLSLI_ 1
+
+// The history sample is on the same surface if the difference of the view depth is less than this ratio of the (predicted) view depth
+#define SSS_TEMPORAL_RELATIVE_DEPTH_THRESHOLD 0.01
+
+// The history sample is rejected if the subsurface mask differs by more than this threshold
+#define SSS_TEMPORAL_SUBSURFACE_MASK_THRESHOLD 0.1
+
+// Until the history length reaches "1 / min_blend", the history is the average of all frames
+#define SSS_TEMPORAL_MAX_HISTORY_LENGTH 64.0
+
+// (uv_prev, view_space_position_z_prev)
+// NOTE: the NDC is the clip space divided by the w (the view space position z), s.t. the w of the previous clip space is multiplied back
+float3 subsurface_scattering_temporal_reproject(float2 uv, float ndc_depth, float view_space_position_z, float4x4 reprojection)
+{
+	float4 prev_clip = mul(float4(uv * float2(2.0, -2.0) + float2(-1.0, 1.0), ndc_depth, 1.0), reprojection);
+	float2 prev_uv = (prev_clip.xy / prev_clip.w) * float2(0.5, -0.5) + float2(0.5, 0.5);
+	return float3(prev_uv, prev_clip.w * view_space_position_z);
+}
+
+// (radiance.rgb, history_length), of which the zero history_length means rejected
+// The bilinear weights of the four history texels around the "prev_uv" are renormalized over the texels which are on the same surface.
+float4 subsurface_scattering_temporal_history(float2 prev_uv, float predicted_prev_view_space_position_z, float subsurface_mask)
+{
+	// Off Screen
+	[branch]
+	if (any(prev_uv < float2(0.0, 0.0)) || any(prev_uv > float2(1.0, 1.0)) || (predicted_prev_view_space_position_z <= 0.0))
+	{
+		return float4(0.0, 0.0, 0.0, 0.0);
+	}
+
+	int2 history_size = SSS_TEMPORAL_HISTORY_SIZE();
+	float2 history_position = prev_uv * float2(history_size) - float2(0.5, 0.5);
+	int2 history_base = int2(floor(history_position));
+	float2 bilinear = history_position - float2(history_base);
+
+	float4 sum_history = float4(0.0, 0.0, 0.0, 0.0);
+	float sum_weight = 0.0;
+
+	[unroll]
+	for (int tap_index = 0; tap_index < 4; ++tap_index)
+	{
+		int2 tap_offset = int2(tap_index & 1, tap_index >> 1);
+		int2 history_texel = clamp(history_base + tap_offset, int2(0, 0), history_size - int2(1, 1));
+
+		float2 history_guide = SSS_TEMPORAL_HISTORY_GUIDE_SOURCE(history_texel);
+		bool same_surface = (history_guide.x > 0.0) && (history_guide.y >= (1.0 / 255.0)) && (abs(history_guide.x - predicted_prev_view_space_position_z) <= (SSS_TEMPORAL_RELATIVE_DEPTH_THRESHOLD * predicted_prev_view_space_position_z)) && (abs(history_guide.y - subsurface_mask) <= SSS_TEMPORAL_SUBSURFACE_MASK_THRESHOLD);
+
+		[branch]
+		if (same_surface)
+		{
+			float weight = ((0 != tap_offset.x) ? bilinear.x : (1.0 - bilinear.x)) * ((0 != tap_offset.y) ? bilinear.y : (1.0 - bilinear.y));
+			sum_history += SSS_TEMPORAL_HISTORY_SOURCE(history_texel) * weight;
+			sum_weight += weight;
+		}
+	}
+
+	// NOTE: the history length is also interpolated, s.t. the partially rejected history is trusted less
+	return (sum_weight > 0.0) ? float4(sum_history.rgb * (1.0 / sum_weight), sum_history.a) : float4(0.0, 0.0, 0.0, 0.0);
+}
+
+// Exponential Moving Average
+// (radiance.rgb, history_length)
+// NOTE: the history length is clamped to "1 / min_blend", s.t. the weight of the current frame is always "1 / history_length"
+float4 subsurface_scattering_temporal_accumulate(float3 current, float4 history, float min_blend)
+{
+	float history_length = min(history.a + 1.0, min(SSS_TEMPORAL_MAX_HISTORY_LENGTH, 1.0 / min_blend));
+	float blend = 1.0 / history_length;
+	return float4(lerp(history.rgb, current, blend), history_length);
+}
+
+#endif
@@ -0,0 +1,114 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The texture space diffusion: the irradiance is rendered into the texture space of the head (the "relighting") and blurred by the Burley profile there, s.t. the result does NOT depend on the camera and is reused until the lights, the parameters or the transform change (see "Code/CPU/SSSTextureSpaceCache.h").
+// Each texel takes the samples of the profile of the widest channel (the same estimator as the "subsurface_scattering_disney_blur"), of which the offset in mm is converted to the texels by the stretch of the center (the units of the mesh per texel along u and v, see "Code/CPU/SSSTextureSpace.h").
+// The radius passed to the profile is the distance between the object space positions of the center and the sample if it is longer than the sampled radius, s.t. the samples of the neighboring charts (adjacent in the texture space but NOT on the surface) are attenuated by their real distance,
+// while the shorter distances (the stretch changes within the filter, e.g. towards the poles of the charts) do NOT amplify the weights.
+// The texels outside the charts (the coverage of the irradiance is zero) and outside the texture are rejected, the same as the subsurface mask of the blur.
+// NOTE: the samples across the seams (adjacent on the surface but NOT in the texture space) are missed, and the ratio estimator renormalizes the rest of the samples.
+//
+// Note: Provided by the User!
+//
+// float4 SSS_TEXTURE_SPACE_IRRADIANCE_SOURCE(int2 texel): (total_diffuse_reflectance_pre_scatter_multiply_form_factor, coverage)
+// float4 SSS_TEXTURE_SPACE_POSITION_SOURCE(int2 texel): (object space position, 1), or zero if the texel is empty
+// float2 SSS_TEXTURE_SPACE_STRETCH_SOURCE(int2 texel): the units of the mesh per texel along u and v
+// int SSS_TEXTURE_SPACE_SIZE(): the size (in texels) of the atlas
+//
+
+#ifndef _SUBSURFACE_SCATTERING_TEXTURE_SPACE_HLSLI_
+#define _SUBSURFACE_SCATTERING_TEXTURE_SPACE_HLSLI_ 1
+
+#include "math_consts.hlsli"
+#include "low_discrepancy_sequence.hlsli"
+#include "subsurface_scattering_disney_blur.hlsli"
+
+#define SSS_TEXTURE_SPACE_DEFAULT_SAMPLE_COUNT 64
+#define SSS_TEXTURE_SPACE_MAX_SAMPLE_COUNT 256
+
+// The rotation of the samples of each texel (the interleaved gradient noise without the frame), s.t. the neighboring texels take the different samples and the pattern of the Fibonacci spiral is NOT baked into the atlas
+float subsurface_scattering_texture_space_rotation(int2 texel)
+{
+	// http://www.iryoku.com/next-generation-post-processing-in-call-of-duty-advanced-warfare
+	return frac(52.9829189 * frac(0.06711056 * float(texel.x) + 0.00583715 * float(texel.y)));
+}
+
+float3 subsurface_scattering_texture_space_diffuse(const float3 scattering_distance, const float world_scale, const int sample_count, const int2 texel)
+{
+	float4 center_position = SSS_TEXTURE_SPACE_POSITION_SOURCE(texel);
+	[branch]
+	if (!(center_position.w > 0.0))
+	{
+		return float3(0.0, 0.0, 0.0);
+	}
+
+	float2 center_stretch = SSS_TEXTURE_SPACE_STRETCH_SOURCE(texel);
+	int size = SSS_TEXTURE_SPACE_SIZE();
+
+	float meters_per_unit = world_scale;
+	float mms_per_unit = 1000.0 * meters_per_unit;
+	float2 texels_per_mm = float2(1.0, 1.0) / max(center_stretch * mms_per_unit, float2(1e-7, 1e-7));
+
+	float d = max(max(scattering_distance.x, scattering_distance.y), scattering_distance.z);
+	float3 S = float3(1.0, 1.0, 1.0) / scattering_distance;
+	float rotation = subsurface_scattering_texture_space_rotation(texel);
+
+	float3 sum_numerator = float3(0.0, 0.0, 0.0);
+	float3 sum_denominator = float3(0.0, 0.0, 0.0);
+	for (int sample_index = 0; sample_index < sample_count; ++sample_index)
+	{
+		float2 xi = fibonacci_2d(uint(sample_index), uint(sample_count));
+
+		float r = diffusion_profile_sample_r(d, xi.x);
+		float theta = 2.0 * PI * (xi.y + rotation);
+		float rcp_pdf = diffusion_profile_evaluate_rcp_pdf(d, r);
+
+		// NOTE: the nearest texel, s.t. the position and the irradiance of the sample are those of the same texel
+		int2 sample_texel = int2(floor(float2(texel) + float2(0.5, 0.5) + float2(cos(theta), sin(theta)) * r * texels_per_mm));
+		[branch]
+		if (any(sample_texel < int2(0, 0)) || any(sample_texel >= int2(size, size)))
+		{
+			continue;
+		}
+
+		float4 sample_irradiance = SSS_TEXTURE_SPACE_IRRADIANCE_SOURCE(sample_texel);
+		[branch]
+		if (!(sample_irradiance.w > 0.0))
+		{
+			continue;
+		}
+
+		// The samples within the center texel keep the sampled radius (the distance between the positions is zero)
+		float r_weight = r;
+		[branch]
+		if (any(sample_texel != texel))
+		{
+			float4 sample_position = SSS_TEXTURE_SPACE_POSITION_SOURCE(sample_texel);
+			r_weight = max(length(sample_position.xyz - center_position.xyz) * mms_per_unit, r);
+		}
+
+		float3 weight = diffusion_profile_evaluate_pdf(S, r_weight) * rcp_pdf;
+		sum_numerator += weight * sample_irradiance.rgb;
+		sum_denominator += weight;
+	}
+
+	// NOTE: the dilated texels (NOT lit) of which all samples are rejected are zero
+	float3 center_irradiance = SSS_TEXTURE_SPACE_IRRADIANCE_SOURCE(texel).rgb;
+	return float3((sum_denominator.x > 0.0) ? (sum_numerator.x / sum_denominator.x) : center_irradiance.x, (sum_denominator.y > 0.0) ? (sum_numerator.y / sum_denominator.y) : center_irradiance.y, (sum_denominator.z > 0.0) ? (sum_numerator.z / sum_denominator.z) : center_irradiance.z);
+}
+
+#endif
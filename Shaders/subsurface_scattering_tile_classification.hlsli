@@ -0,0 +1,132 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The tile classification of the blur, s.t. the blur only touches the tiles of the subsurface scattering.
+//
+// Note: Provided by the User!
+//
+// float SSS_TILE_SUBSURFACE_MASK_SOURCE(int2 texel)
+// int SSS_TILE_PROFILE_INDEX_SOURCE(int2 texel): -1 if the stencil is zero
+// int2 SSS_TILE_SCREEN_SIZE(): the size (in pixels) of the blur
+// uint SSS_TILE_STATE_SOURCE(int2 tile): the "subsurface_scattering_tile_state" of the tile (only read by the "subsurface_scattering_tile_classify")
+//
+// 1. The "subsurface_scattering_tile_state" reduces the SSS_TILE_SIZE x SSS_TILE_SIZE pixels of each tile into the state:
+//    EMPTY: none of the pixels passes the stencil test
+//    UNIFORM: all pixels belong to the same profile and NONE of them is rejected by the subsurface mask (namely, "dist_scale >= 1 / 255")
+//    MIXED: otherwise
+// 2. The "subsurface_scattering_tile_classify" classifies each tile by the states of the tile and its 8 neighbours:
+//    EMPTY: the blur is NOT drawn
+//    INTERIOR: the tile is UNIFORM, and the blur is the cheaper variant (see "subsurface_scattering_disney_blur_estimate_interior") of which the samples within the "edge_free_radius" skip the subsurface mask and the profile index
+//    EDGE: the tile is MIXED, and the blur is the original one
+// The "margin" of the INTERIOR tile is one tile if the 8 neighbours are UNIFORM with the same profile, and zero otherwise.
+// NOTE: the neighbours beyond the screen are NOT required, since the address of the sample is clamped into the tiles of the screen.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_TILE_CLASSIFICATION_HLSLI_
+#define _SUBSURFACE_SCATTERING_TILE_CLASSIFICATION_HLSLI_ 1
+
+#define SSS_TILE_SIZE 16
+
+#define SSS_TILE_STATE_EMPTY 0
+#define SSS_TILE_STATE_MIXED 1
+// SSS_TILE_STATE_UNIFORM + profile_index
+#define SSS_TILE_STATE_UNIFORM 2
+
+#define SSS_TILE_CLASS_EMPTY 0
+#define SSS_TILE_CLASS_INTERIOR 1
+#define SSS_TILE_CLASS_EDGE 2
+
+// The floating point error of the address of the sample (in pixels)
+#define SSS_TILE_EDGE_FREE_RADIUS_EPSILON (1.0 / 16.0)
+
+int2 subsurface_scattering_tile_count(int2 screen_size)
+{
+	return (screen_size + int2(SSS_TILE_SIZE - 1, SSS_TILE_SIZE - 1)) / int2(SSS_TILE_SIZE, SSS_TILE_SIZE);
+}
+
+uint subsurface_scattering_tile_state(int2 tile)
+{
+	int2 texel_begin = tile * int(SSS_TILE_SIZE);
+	int2 texel_end = min(texel_begin + int2(SSS_TILE_SIZE, SSS_TILE_SIZE), SSS_TILE_SCREEN_SIZE());
+
+	int uniform_profile_index = SSS_TILE_PROFILE_INDEX_SOURCE(texel_begin);
+	bool any_profile = false;
+	bool all_uniform = true;
+
+	[loop]
+	for (int y = texel_begin.y; y < texel_end.y; ++y)
+	{
+		[loop]
+		for (int x = texel_begin.x; x < texel_end.x; ++x)
+		{
+			int profile_index = SSS_TILE_PROFILE_INDEX_SOURCE(int2(x, y));
+			float subsurface_mask = SSS_TILE_SUBSURFACE_MASK_SOURCE(int2(x, y));
+			any_profile = any_profile || (profile_index >= 0);
+			all_uniform = all_uniform && (profile_index == uniform_profile_index) && (subsurface_mask >= (1.0 / 255.0));
+		}
+	}
+
+	return (all_uniform && (uniform_profile_index >= 0)) ? (uint(SSS_TILE_STATE_UNIFORM) + uint(uniform_profile_index)) : (any_profile ? uint(SSS_TILE_STATE_MIXED) : uint(SSS_TILE_STATE_EMPTY));
+}
+
+// (class, profile_index, margin): the "profile_index" and the "margin" (in tiles) are only valid for the INTERIOR tile
+uint3 subsurface_scattering_tile_classify(int2 tile)
+{
+	uint state = SSS_TILE_STATE_SOURCE(tile);
+
+	[branch]
+	if (uint(SSS_TILE_STATE_EMPTY) == state)
+	{
+		return uint3(SSS_TILE_CLASS_EMPTY, 0, 0);
+	}
+	else if (uint(SSS_TILE_STATE_MIXED) == state)
+	{
+		return uint3(SSS_TILE_CLASS_EDGE, 0, 0);
+	}
+
+	int2 tile_count = subsurface_scattering_tile_count(SSS_TILE_SCREEN_SIZE());
+	uint margin = 1;
+	[unroll]
+	for (int neighbour_y = -1; neighbour_y <= 1; ++neighbour_y)
+	{
+		[unroll]
+		for (int neighbour_x = -1; neighbour_x <= 1; ++neighbour_x)
+		{
+			int2 neighbour = tile + int2(neighbour_x, neighbour_y);
+			[branch]
+			if (all(neighbour >= int2(0, 0)) && all(neighbour < tile_count) && (SSS_TILE_STATE_SOURCE(neighbour) != state))
+			{
+				margin = 0;
+			}
+		}
+	}
+
+	return uint3(SSS_TILE_CLASS_INTERIOR, state - uint(SSS_TILE_STATE_UNIFORM), margin);
+}
+
+// The distance (in pixels) from the center of the texel (of the INTERIOR tile) to the boundary of the tile expanded by the "margin", within which all pixels belong to the profile of the tile
+float subsurface_scattering_tile_edge_free_radius(int2 texel, uint margin)
+{
+	int2 tile = texel / int(SSS_TILE_SIZE);
+	float2 edge_free_begin = float2((tile - int(margin)) * int(SSS_TILE_SIZE));
+	float2 edge_free_end = float2((tile + int(1 + margin)) * int(SSS_TILE_SIZE));
+	float2 center = float2(texel) + float2(0.5, 0.5);
+	float2 distance = min(center - edge_free_begin, edge_free_end - center);
+	return min(distance.x, distance.y) - SSS_TILE_EDGE_FREE_RADIUS_EPSILON;
+}
+
+#endif
@@ -0,0 +1,58 @@
+//
+// Copyright (C) YuqiaoZhang(HanetakaChou)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+// The transmittance baked on the CPU (see "Code/CPU/SSSTransmittanceLUT.h").
+//
+// One row per profile: "transmittance_tint * EvaluateTransmittance(scattering_distance, thickness)" tabulated in [0, max_thickness] (in mm).
+// The entries are uniform in "sqrt(thickness / max_thickness)", s.t. the steep part near zero thickness gets more entries.
+// The analytic version is used beyond the "max_thickness".
+// NOTE: the two texels are loaded and interpolated manually, since the precision of the fraction of the bilinear filter is only 8 bits.
+//
+
+#ifndef _SUBSURFACE_SCATTERING_TRANSMITTANCE_LUT_HLSLI_
+#define _SUBSURFACE_SCATTERING_TRANSMITTANCE_LUT_HLSLI_ 1
+
+#include "subsurface_scattering_disney_transmittance.hlsli"
+
+float3 subsurface_scattering_transmittance_lut(Texture2D<float4> transmittance_lut, int profile_index, float max_thickness, float3 scattering_distance, float3 transmittance_tint, float thickness)
+{
+    float3 transmittance;
+
+    [branch]
+    if (!(thickness < max_thickness))
+    {
+        transmittance = transmittance_tint * EvaluateTransmittance(scattering_distance, thickness);
+    }
+    else
+    {
+        uint lut_width;
+        uint lut_height;
+        transmittance_lut.GetDimensions(lut_width, lut_height);
+
+        float t = sqrt(max(thickness, 0.0) * (1.0 / max_thickness)) * float(int(lut_width) - 1);
+        int index = min(int(t), int(lut_width) - 2);
+        float f = t - float(index);
+
+        float3 p0 = transmittance_lut.Load(int3(index, profile_index, 0)).xyz;
+        float3 p1 = transmittance_lut.Load(int3(index + 1, profile_index, 0)).xyz;
+        transmittance = lerp(p0, p1, f);
+    }
+
+    return transmittance;
+}
+
+#endif